@@ -0,0 +1,136 @@
+// File "Arena.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <cstdlib>
+#include <stdexcept>
+#include "Arena.h"
+
+using namespace std;
+
+namespace blahtex
+{
+
+// Every allocation is rounded up to a multiple of this, which is enough
+// alignment for anything the trees contain.
+union ArenaAlignment
+{
+    long double mLongDouble;
+    long long mLongLong;
+    void* mPointer;
+};
+
+const size_t cArenaAlignment = sizeof(ArenaAlignment);
+
+// Size of the first chunk. This is enough for all but fairly large
+// formulas, so usually an arena only ever has one chunk.
+const size_t cFirstChunkSize = 16384;
+
+// The arena for the current thread (see ArenaScope). This uses the GCC
+// "__thread" extension, since each thread (e.g. in batch mode) has its
+// own Interface, and hence its own arena.
+static __thread Arena* gCurrentArena = NULL;
+
+Arena::Arena() :
+    mChunk(NULL),
+    mNext(NULL),
+    mEnd(NULL)
+{ }
+
+Arena::~Arena()
+{
+    while (mChunk)
+    {
+        Chunk* previous = mChunk->mPrevious;
+        free(mChunk);
+        mChunk = previous;
+    }
+}
+
+void Arena::Grow(size_t size)
+{
+    size_t chunkSize = mChunk ? 2 * mChunk->mSize : cFirstChunkSize;
+    while (chunkSize < size)
+        chunkSize *= 2;
+
+    // The header is padded out so that the first allocation is aligned.
+    size_t headerSize = (sizeof(Chunk) + cArenaAlignment - 1)
+        & ~(cArenaAlignment - 1);
+
+    Chunk* chunk = static_cast<Chunk*>(malloc(headerSize + chunkSize));
+    if (!chunk)
+        throw bad_alloc();
+    chunk->mPrevious = mChunk;
+    chunk->mSize = chunkSize;
+
+    mChunk = chunk;
+    mNext = reinterpret_cast<char*>(chunk) + headerSize;
+    mEnd = mNext + chunkSize;
+}
+
+void* Arena::Allocate(size_t size)
+{
+    size = (size + cArenaAlignment - 1) & ~(cArenaAlignment - 1);
+    if (static_cast<size_t>(mEnd - mNext) < size)
+        Grow(size);
+
+    void* output = mNext;
+    mNext += size;
+    return output;
+}
+
+void Arena::Reset()
+{
+    if (!mChunk)
+        return;
+
+    // Free everything except the newest (and largest) chunk.
+    Chunk* previous = mChunk->mPrevious;
+    while (previous)
+    {
+        Chunk* next = previous->mPrevious;
+        free(previous);
+        previous = next;
+    }
+    mChunk->mPrevious = NULL;
+
+    mNext = mEnd - mChunk->mSize;
+}
+
+ArenaScope::ArenaScope(Arena& arena) :
+    mPrevious(gCurrentArena)
+{
+    gCurrentArena = &arena;
+}
+
+ArenaScope::~ArenaScope()
+{
+    gCurrentArena = mPrevious;
+}
+
+void* AllocateFromCurrentArena(size_t size)
+{
+    if (!gCurrentArena)
+        throw logic_error("No current arena in AllocateFromCurrentArena");
+    return gCurrentArena->Allocate(size);
+}
+
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
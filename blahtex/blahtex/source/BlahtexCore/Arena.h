@@ -0,0 +1,197 @@
+// File "Arena.h"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef BLAHTEX_ARENA_H
+#define BLAHTEX_ARENA_H
+
+#include <cstddef>
+#include <new>
+
+namespace blahtex
+{
+
+// An Arena hands out memory for the parse tree, layout tree and MathML
+// tree built during a single conversion. Allocation just bumps a pointer
+// through a large chunk, and freeing is a no-op; the memory only comes
+// back all at once, when Reset() is called.
+//
+// Each Manager owns an Arena, and resets it at the start of every
+// ProcessInput, so a Manager that is reused for many inputs (as the
+// Interface in batch and server mode does) keeps recycling the same chunk
+// rather than going back to the heap for every node.
+class Arena
+{
+public:
+    Arena();
+    ~Arena();
+
+    // Returns "size" bytes, aligned suitably for any of the tree nodes.
+    void* Allocate(size_t size);
+
+    // Makes all the memory handed out so far available again. Anything
+    // allocated from the arena must already have been destroyed.
+    //
+    // The largest chunk is kept for next time; any others (there are only
+    // a few, since each chunk is twice the size of the last) are freed.
+    void Reset();
+
+private:
+    struct Chunk
+    {
+        Chunk* mPrevious;
+        size_t mSize;
+    };
+
+    // The chunk currently being allocated from; it is the newest and
+    // largest, and links back to the earlier ones.
+    Chunk* mChunk;
+
+    // The unused part of mChunk.
+    char* mNext;
+    char* mEnd;
+
+    // Starts a new chunk big enough for at least "size" bytes.
+    void Grow(size_t size);
+
+    // Not copyable.
+    Arena(const Arena&);
+    Arena& operator=(const Arena&);
+};
+
+
+// While an ArenaScope exists, tree nodes and their containers created on
+// the same thread are allocated from the given arena. Scopes may be
+// nested; the previous arena is restored on destruction.
+class ArenaScope
+{
+public:
+    explicit ArenaScope(Arena& arena);
+    ~ArenaScope();
+
+private:
+    Arena* mPrevious;
+
+    ArenaScope(const ArenaScope&);
+    ArenaScope& operator=(const ArenaScope&);
+};
+
+
+// Returns memory from the current arena. Throws std::logic_error if there
+// isn't one, since the caller would have no way to free it.
+void* AllocateFromCurrentArena(size_t size);
+
+
+// Base class for the tree node types (ParseTree::Node, LayoutTree::Node,
+// MathmlNode). It makes "new" allocate from the current arena, and
+// "delete" only run the destructor; the memory is reclaimed by
+// Arena::Reset.
+struct ArenaAllocated
+{
+    static void* operator new(size_t size)
+    {
+        return AllocateFromCurrentArena(size);
+    }
+
+    static void operator delete(void*)
+    { }
+};
+
+
+// ArenaAllocator lets the standard containers inside the tree nodes (child
+// lists, attribute maps) allocate from the current arena too. It has no
+// state of its own, so any two ArenaAllocators compare equal.
+template <class T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <class U>
+    struct rebind
+    {
+        typedef ArenaAllocator<U> other;
+    };
+
+    ArenaAllocator()
+    { }
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>&)
+    { }
+
+    pointer address(reference x) const
+    {
+        return &x;
+    }
+
+    const_pointer address(const_reference x) const
+    {
+        return &x;
+    }
+
+    pointer allocate(size_type count, const void* = 0)
+    {
+        return static_cast<pointer>(
+            AllocateFromCurrentArena(count * sizeof(T))
+        );
+    }
+
+    void deallocate(pointer, size_type)
+    { }
+
+    size_type max_size() const
+    {
+        return static_cast<size_type>(-1) / sizeof(T);
+    }
+
+    void construct(pointer p, const T& value)
+    {
+        new (static_cast<void*>(p)) T(value);
+    }
+
+    void destroy(pointer p)
+    {
+        p->~T();
+    }
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&)
+{
+    return true;
+}
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&)
+{
+    return false;
+}
+
+}
+
+#endif
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -19,8 +19,10 @@
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
 #include <sstream>
+#include <stdexcept>
 #include "Interface.h"
-#include "MathmlNode.h"
+#include "MathmlWriter.h"
+#include "Utf8.h"
 
 using namespace std;
 
@@ -29,16 +31,44 @@ namespace blahtex
 
 void Interface::ProcessInput(const wstring& input)
 {
-    mManager.reset(new Manager);
-    mManager->ProcessInput(input, mTexvcCompatibility);
+    Exception error;
+    if (!TryProcessInput(input, error))
+        throw error;
+}
+
+bool Interface::TryProcessInput(const wstring& input, Exception& error)
+{
+    // The Manager is kept from one input to the next, so that the memory
+    // for its trees gets reused.
+    if (!mManager.get())
+        mManager.reset(new Manager);
+    return mManager->TryProcessInput(input, mTexvcCompatibility, error);
+}
+
+void Interface::Validate(const wstring& input, bool checkLayout)
+{
+    Exception error;
+    if (!TryValidate(input, checkLayout, error))
+        throw error;
+}
+
+bool Interface::TryValidate(
+    const wstring& input,
+    bool checkLayout,
+    Exception& error
+)
+{
+    return
+        TryProcessInput(input, error) &&
+        (!checkLayout || mManager->TryCheckLayoutTree(error));
 }
 
 wstring Interface::GetMathml()
 {
-    wostringstream output;
-    auto_ptr<MathmlNode> root = mManager->GenerateMathml(mMathmlOptions);
-    root->Print(output, mEncodingOptions, mIndented);
-    return output.str();
+    wstring output;
+    MathmlPrinter<wstring> printer(output, mEncodingOptions, mIndented);
+    mManager->WriteMathml(printer, mMathmlOptions);
+    return output;
 }
 
 wstring Interface::GetPurifiedTex()
@@ -46,6 +76,204 @@ wstring Interface::GetPurifiedTex()
     return mManager->GeneratePurifiedTex(mPurifiedTexOptions);
 }
 
+void Interface::ProcessInputUtf8(const string& input)
+{
+    Exception error;
+    if (!TryProcessInputUtf8(input, error))
+        throw error;
+}
+
+bool Interface::TryProcessInputUtf8(const string& input, Exception& error)
+{
+    wstring wideInput;
+    if (!DecodeUtf8(input, wideInput))
+    {
+        error = Exception(L"InvalidUtf8Input");
+        return false;
+    }
+    return TryProcessInput(wideInput, error);
+}
+
+void Interface::ValidateUtf8(const string& input, bool checkLayout)
+{
+    Exception error;
+    if (!TryValidateUtf8(input, checkLayout, error))
+        throw error;
+}
+
+bool Interface::TryValidateUtf8(
+    const string& input,
+    bool checkLayout,
+    Exception& error
+)
+{
+    return
+        TryProcessInputUtf8(input, error) &&
+        (!checkLayout || mManager->TryCheckLayoutTree(error));
+}
+
+string Interface::GetMathmlUtf8()
+{
+    string output;
+    AppendMathmlUtf8(output);
+    return output;
+}
+
+void Interface::AppendMathmlUtf8(string& output)
+{
+    string::size_type originalSize = output.size();
+    try
+    {
+        MathmlPrinter<string> printer(output, mEncodingOptions, mIndented);
+        mManager->WriteMathml(printer, mMathmlOptions);
+    }
+    catch (...)
+    {
+        // Remove any partial output.
+        output.resize(originalSize);
+        throw;
+    }
+}
+
+bool IsSameMathmlOptions(const MathmlOptions& x, const MathmlOptions& y)
+{
+    return
+        x.mSpacingControl            == y.mSpacingControl &&
+        x.mUseVersion1FontAttributes == y.mUseVersion1FontAttributes &&
+        x.mAllowPlane1               == y.mAllowPlane1;
+}
+
+void Interface::GetMathmlVariantsUtf8(
+    const vector<MathmlProfile>& profiles,
+    vector<MathmlVariant>& variants
+)
+{
+    variants.resize(profiles.size());
+    vector<bool> isDone(profiles.size(), false);
+
+    for (vector<MathmlProfile>::size_type
+        first = 0; first < profiles.size(); first++
+    )
+    {
+        if (isDone[first])
+            continue;
+
+        // Each profile with the same MathmlOptions as this one gets its
+        // own printer, and they all get fed from one WriteMathml().
+        const MathmlOptions& options = profiles[first].mMathmlOptions;
+        vector<vector<MathmlProfile>::size_type> group;
+        MathmlBroadcaster broadcaster;
+
+        for (vector<MathmlProfile>::size_type
+            index = first; index < profiles.size(); index++
+        )
+        {
+            const MathmlProfile& profile = profiles[index];
+            if (isDone[index] ||
+                !IsSameMathmlOptions(profile.mMathmlOptions, options)
+            )
+                continue;
+
+            isDone[index] = true;
+            group.push_back(index);
+            variants[index].mMathml.clear();
+            variants[index].mHasError = false;
+            broadcaster.Add(auto_ptr<MathmlWriter>(
+                new MathmlPrinter<string>(
+                    variants[index].mMathml,
+                    profile.mEncodingOptions,
+                    profile.mIndented
+                )
+            ));
+        }
+
+        try
+        {
+            mManager->WriteMathml(broadcaster, options);
+        }
+        catch (Exception& e)
+        {
+            for (vector<vector<MathmlProfile>::size_type>::iterator
+                index = group.begin(); index != group.end(); index++
+            )
+            {
+                variants[*index].mMathml.clear();
+                variants[*index].mHasError = true;
+                variants[*index].mError = e;
+            }
+        }
+    }
+}
+
+void Interface::ConvertUtf8(
+    const string& input,
+    bool doMathml,
+    bool doPurifiedTex,
+    ConversionResult& result
+)
+{
+    result.mMathml.clear();
+    result.mPurifiedTex.clear();
+    result.mHasMathmlError = false;
+    result.mHasPurifiedTexError = false;
+    result.mInputError = result.mMathmlError = result.mPurifiedTexError =
+        Exception();
+
+    result.mHasInputError = !TryProcessInputUtf8(input, result.mInputError);
+    if (result.mHasInputError)
+        return;
+
+    // Errors from here on are rare, and come from deep inside the trees,
+    // so they are still thrown internally.
+    if (doMathml)
+    {
+        try
+        {
+            AppendMathmlUtf8(result.mMathml);
+        }
+        catch (Exception& e)
+        {
+            result.mHasMathmlError = true;
+            result.mMathmlError = e;
+        }
+    }
+
+    if (doPurifiedTex)
+    {
+        try
+        {
+            result.mPurifiedTex = GetPurifiedTexUtf8();
+        }
+        catch (Exception& e)
+        {
+            result.mHasPurifiedTexError = true;
+            result.mPurifiedTexError = e;
+        }
+    }
+}
+
+string Interface::GetCanonicalFormUtf8()
+{
+    string output;
+    if (!AppendUtf8(output, mManager->GetCanonicalForm()))
+        throw logic_error(
+            "Invalid character in Interface::GetCanonicalFormUtf8"
+        );
+    return output;
+}
+
+string Interface::GetPurifiedTexUtf8()
+{
+    string output;
+    if (!AppendUtf8(
+        output, mManager->GeneratePurifiedTex(mPurifiedTexOptions)
+    ))
+        throw logic_error(
+            "Invalid character in Interface::GetPurifiedTexUtf8"
+        );
+    return output;
+}
+
 }
 
 // end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -22,6 +22,7 @@
 #define BLAHTEX_INTERFACE_H
 
 #include <string>
+#include <vector>
 #include <memory>
 #include "Misc.h"
 #include "Manager.h"
@@ -30,6 +31,62 @@
 namespace blahtex
 {
 
+// MathmlProfile collects the options that only affect the MathML output,
+// i.e. the ones that may differ between several MathML variants of the
+// same input (see Interface::GetMathmlVariantsUtf8).
+struct MathmlProfile
+{
+    MathmlOptions mMathmlOptions;
+    EncodingOptions mEncodingOptions;
+    bool mIndented;
+
+    MathmlProfile() :
+        mIndented(false)
+    { }
+};
+
+// MathmlVariant holds the MathML generated for one MathmlProfile, in
+// UTF-8, or the error that prevented it from being generated.
+struct MathmlVariant
+{
+    std::string mMathml;
+    bool mHasError;
+    Exception mError;
+
+    MathmlVariant() :
+        mHasError(false)
+    { }
+};
+
+// ConversionResult holds everything Interface::ConvertUtf8() produces for
+// one input. Each error is stored next to the output it prevented, rather
+// than thrown.
+struct ConversionResult
+{
+    // Set if the input itself was rejected (e.g. a syntax error); then
+    // neither output gets generated.
+    bool mHasInputError;
+    Exception mInputError;
+
+    // The requested outputs, in UTF-8. Each may fail on its own (e.g.
+    // "UnavailableSymbolFontCombination" only affects the MathML), in
+    // which case its string is empty and its error is set.
+    std::string mMathml;
+    bool mHasMathmlError;
+    Exception mMathmlError;
+
+    std::string mPurifiedTex;
+    bool mHasPurifiedTexError;
+    Exception mPurifiedTexError;
+
+    ConversionResult() :
+        mHasInputError(false),
+        mHasMathmlError(false),
+        mHasPurifiedTexError(false)
+    { }
+};
+
+
 // If you want to use blahtex in your own code, using an Interface object
 // is probably the easiest way to do it. It's essentially a wrapper for
 // the Manager class, putting all the options and methods in one convenient
@@ -43,6 +100,15 @@ namespace blahtex
 // (4) Call GetMathml() to get the MathML output
 // (5) Call GetPurifiedTex() to get a complete TeX file that could be sent
 //     to latex to generate graphical output
+// (Steps 3-5 can also be done in UTF-8; see ProcessInputUtf8() etc.)
+//
+// Thread safety: all the lookup tables used by the core are built during
+// static initialisation (i.e. before main() starts) and are never modified
+// afterwards. Everything that changes during a conversion is owned by the
+// Interface (and its Manager). Therefore different threads may run
+// conversions at the same time, as long as each thread uses its own
+// Interface object. A single Interface must not be used by more than one
+// thread at once. Conversions must not be started before main() begins.
 
 class Interface
 {
@@ -70,6 +136,88 @@ public:
     void ProcessInput(const std::wstring& input);
     std::wstring GetMathml();
     std::wstring GetPurifiedTex();
+
+    // Validate() just checks whether "input" would convert, without
+    // generating anything: it tokenises and parses the input, and throws
+    // the same blahtex::Exception as ProcessInput() would if it's not
+    // valid. If checkLayout is set, it also builds the layout tree, and
+    // throws the errors found there that would otherwise be reported by
+    // GetMathml() (i.e. "UnavailableSymbolFontCombination").
+    //
+    // A successful Validate() leaves things as after ProcessInput(), so
+    // the output may still be generated afterwards.
+    void Validate(const std::wstring& input, bool checkLayout = false);
+
+    // TryProcessInput() and TryValidate() are the same as the functions
+    // above, except that an invalid input makes them return false and
+    // store the error in "error", instead of throwing it. The error is
+    // never thrown at all on the way (see Parser::DoParse), which makes
+    // these a lot faster on invalid input; use them when most inputs are
+    // expected to be invalid, e.g. when converting a formula on every
+    // keystroke as it gets typed.
+    bool TryProcessInput(const std::wstring& input, Exception& error);
+    bool TryValidate(
+        const std::wstring& input,
+        bool checkLayout,
+        Exception& error
+    );
+
+    // UTF-8 versions of the above. The input is decoded straight into the
+    // core, and the MathML is written straight out as UTF-8, so callers
+    // working in UTF-8 never need to handle a wstring (or use
+    // UnicodeConverter). ProcessInputUtf8() and ValidateUtf8() throw
+    // Exception(L"InvalidUtf8Input") if the input isn't valid UTF-8.
+    void ProcessInputUtf8(const std::string& input);
+    void ValidateUtf8(const std::string& input, bool checkLayout = false);
+    bool TryProcessInputUtf8(const std::string& input, Exception& error);
+    bool TryValidateUtf8(
+        const std::string& input,
+        bool checkLayout,
+        Exception& error
+    );
+    std::string GetMathmlUtf8();
+    std::string GetPurifiedTexUtf8();
+
+    // GetCanonicalFormUtf8() returns Manager::GetCanonicalForm() for the
+    // input most recently processed, in UTF-8. A caller caching the output
+    // can key on this (plus the options, and
+    // Manager::cCanonicalFormVersion) instead of on the input, so that
+    // differently spelt inputs with the same meaning share an entry.
+    std::string GetCanonicalFormUtf8();
+
+    // Same as GetMathmlUtf8(), but appends the MathML to "output", so that
+    // it can go straight into a larger output buffer. If an exception is
+    // thrown, "output" is left as it was.
+    void AppendMathmlUtf8(std::string& output);
+
+    // GetMathmlVariantsUtf8() generates the MathML for each of "profiles"
+    // from the input most recently processed, and stores it in the
+    // corresponding element of "variants" (which is resized to match; its
+    // strings are reused). The mMathmlOptions, mEncodingOptions and
+    // mIndented members above are not used.
+    //
+    // The input is only parsed once however many profiles there are, and
+    // profiles with the same MathmlOptions also share a single pass over
+    // the layout tree. A blahtex::Exception while generating the MathML
+    // is stored in the variants concerned, rather than thrown, so that
+    // the other variants still get generated.
+    void GetMathmlVariantsUtf8(
+        const std::vector<MathmlProfile>& profiles,
+        std::vector<MathmlVariant>& variants
+    );
+
+    // ConvertUtf8() does a complete conversion: it processes "input",
+    // and then generates the MathML and/or the purified TeX, as requested,
+    // storing everything in "result" (whose strings are reused). It never
+    // throws a blahtex::Exception; the only exceptions that can escape
+    // are the ones that indicate a bug (std::logic_error) or a problem
+    // with the installation.
+    void ConvertUtf8(
+        const std::string& input,
+        bool doMathml,
+        bool doPurifiedTex,
+        ConversionResult& result
+    );
 };
 
 }
@@ -22,9 +22,10 @@
 #include <sstream>
 #include <stdexcept>
 #include <list>
-#include <set>
 #include <map>
+#include <algorithm>
 #include "MathmlNode.h"
+#include "MathmlWriter.h"
 #include "LayoutTree.h"
 
 using namespace std;
@@ -78,7 +79,7 @@ namespace LayoutTree
 
 Row::~Row()
 {
-    for (list<Node*>::iterator
+    for (NodeList::iterator
         p = mChildren.begin();
         p != mChildren.end();
         p++
@@ -88,12 +89,12 @@ Row::~Row()
 
 Table::~Table()
 {
-    for (vector<vector<Node*> >::iterator
+    for (NodeRows::iterator
         p = mRows.begin();
         p != mRows.end();
         p++
     )
-        for (vector<Node*>::iterator q = p->begin(); q != p->end(); q++)
+        for (NodeVector::iterator q = p->begin(); q != p->end(); q++)
             delete *q;
 }
 
@@ -105,21 +106,140 @@ void IncrementNodeCount(unsigned& nodeCount)
 }
 
 
-// This function obtains the core of a MathML expression. (See
-// "embellished operators" in the MathML spec.) This is used to find any
-// <mo> node which should have its "lspace" and/or "rspace" attributes set.
-MathmlNode* GetCore(MathmlNode* node)
+// Converts an RGBColour to "#rrggbb" format.
+wstring FormatColour(RGBColour colour)
 {
-    // FIX: this code is not quite right. It doesn't handle situations where
-    // <mrow> or <mstyle> or something similar contain a single node which
-    // is an embellished operator. I don't think this really matters
-    // because I don't think these situations can actually arise, but
-    // maybe should be fixed just in case.
+    wostringstream os;
+    os << L"#" << hex << setfill(L'0') << setw(6) << colour;
+    return os.str();
+}
 
-    if (!node)
-        return NULL;
-    
-    switch (node->mType)
+
+// A RowEntry is one item in the MathML for a Row: either the frame of one
+// of its children, or an <mspace> inserted between them. It records the
+// environment that the item should be rendered in.
+struct RowEntry
+{
+    MathmlFrame* mFrame;
+    MathmlEnvironment mEnvironment;
+
+    RowEntry(
+        MathmlFrame* frame,
+        const MathmlEnvironment& environment
+    ) :
+        mFrame(frame),
+        mEnvironment(environment)
+    { }
+};
+
+typedef vector<RowEntry, ArenaAllocator<RowEntry> > RowEntryVector;
+
+
+// A MathmlFrame is a chain of elements, each the only child of the next,
+// that encloses the MathML for a node. For example, a coloured fraction
+// gets the frame <mstyle mathcolor="..."><mfrac>, and then
+// Fraction::WriteMathmlContent() writes the numerator and denominator
+// inside the <mfrac>.
+//
+// Frames are allocated from the current arena, and never destroyed.
+struct MathmlFrame : ArenaAllocated
+{
+    struct Element
+    {
+        MathmlNode::Type mType;
+        MathmlNode::AttributeSet mAttributes;
+
+        explicit Element(MathmlNode::Type type) :
+            mType(type)
+        { }
+    };
+
+    // The innermost element comes first, so the outermost one is
+    // mElements.back(). There is always at least one.
+    vector<Element, ArenaAllocator<Element> > mElements;
+
+    // The node whose WriteMathmlContent() fills in the innermost element,
+    // or NULL if that element is empty (e.g. an <mspace> inserted by Row).
+    const Node* mContent;
+
+    // The frame of a child that had to be prepared early. For Scripts
+    // this is the base, since its core might need extra attributes.
+    MathmlFrame* mChild;
+
+    // The items inside a Row's <mrow>, if they have been worked out yet.
+    RowEntryVector mRowEntries;
+
+    MathmlFrame(
+        MathmlNode::Type type,
+        const Node* content
+    ) :
+        mContent(content),
+        mChild(NULL)
+    {
+        mElements.push_back(Element(type));
+    }
+
+    MathmlNode::Type GetOuterType() const
+    {
+        return mElements.back().mType;
+    }
+
+    MathmlNode::AttributeSet& GetOuterAttributes()
+    {
+        return mElements.back().mAttributes;
+    }
+
+    // Adds a new outermost element.
+    void Wrap(MathmlNode::Type type)
+    {
+        mElements.push_back(Element(type));
+    }
+};
+
+
+// Writes the elements of "frame", and whatever goes inside them.
+void WriteMathmlFrame(
+    MathmlWriter& writer,
+    const MathmlOptions& options,
+    MathmlFrame& frame,
+    unsigned& nodeCount
+)
+{
+    for (size_t i = frame.mElements.size(); i > 0; i--)
+        writer.StartElement(
+            frame.mElements[i - 1].mType,
+            frame.mElements[i - 1].mAttributes
+        );
+
+    if (frame.mContent)
+        frame.mContent->WriteMathmlContent(
+            writer, options, frame, nodeCount
+        );
+
+    for (size_t i = 0; i < frame.mElements.size(); i++)
+        writer.EndElement(frame.mElements[i].mType);
+}
+
+
+void Node::WriteMathml(
+    MathmlWriter& writer,
+    const MathmlOptions& options,
+    const MathmlEnvironment& inheritedEnvironment,
+    unsigned& nodeCount
+) const
+{
+    WriteMathmlFrame(
+        writer,
+        options,
+        *PrepareMathml(options, inheritedEnvironment, nodeCount),
+        nodeCount
+    );
+}
+
+
+bool IsScriptsType(MathmlNode::Type type)
+{
+    switch (type)
     {
         case MathmlNode::cTypeMsub:
         case MathmlNode::cTypeMsup:
@@ -127,157 +247,181 @@ MathmlNode* GetCore(MathmlNode* node)
         case MathmlNode::cTypeMunder:
         case MathmlNode::cTypeMover:
         case MathmlNode::cTypeMunderover:
-            return GetCore(node->mChildren.front());
-        
+            return true;
+
         default:
-            return node;
+            return false;
     }
 }
 
 
-// Converts an RGBColour to "#rrggbb" format.
-wstring FormatColour(RGBColour colour)
+// This function obtains the type of the core of a MathML expression. (See
+// "embellished operators" in the MathML spec.) This is used to find any
+// <mo> node which should have its "lspace" and/or "rspace" attributes set.
+//
+// Only Scripts makes frames whose outer element is <msub> etc, and it
+// keeps the base's frame in mChild.
+MathmlNode::Type GetCoreType(const MathmlFrame& frame)
 {
-    wostringstream os;
-    os << L"#" << hex << setfill(L'0') << setw(6) << colour;
-    return os.str();
+    // FIX: this code is not quite right. It doesn't handle situations where
+    // <mrow> or <mstyle> or something similar contain a single node which
+    // is an embellished operator. I don't think this really matters
+    // because I don't think these situations can actually arise, but
+    // maybe should be fixed just in case.
+
+    if (IsScriptsType(frame.GetOuterType()))
+        return GetCoreType(*frame.mChild);
+    else
+        return frame.GetOuterType();
+}
+
+// Sets an attribute on the core of a MathML expression (see GetCoreType).
+template <class Value>
+void SetCoreAttribute(
+    MathmlFrame& frame,
+    MathmlNode::Attribute attribute,
+    const Value& value
+)
+{
+    if (IsScriptsType(frame.GetOuterType()))
+        SetCoreAttribute(*frame.mChild, attribute, value);
+    else
+        frame.GetOuterAttributes().Set(attribute, value);
 }
 
 
 // This function compares sourceEnvironment to targetEnvironment. It then
-// modifies "node" by inserting appropriate attributes or possibly an
-// <mstyle> node, so that the node receives the desired "target
-// environment", assuming that it inherited the indicated "source
-// environment".
+// modifies "frame" by inserting appropriate attributes or possibly an
+// <mstyle> element, so that the frame's contents receive the desired
+// "target environment", assuming that they inherited the indicated
+// "source environment".
 
 // FIX: sometimes firefox doesn't get the scriptlevel correct for
 // tables. (see mozilla bug 328141). So for the moment, we force an
 // extra <mstyle> node around every table to handle the scriptlevel.
 #define MOZILLA_BUG_328141_WORKAROUND 1
 
-auto_ptr<MathmlNode> AdjustMathmlEnvironment(
-    auto_ptr<MathmlNode> node,
-    MathmlEnvironment sourceEnvironment,
-    MathmlEnvironment targetEnvironment
+void AdjustMathmlEnvironment(
+    MathmlFrame& frame,
+    const MathmlEnvironment& sourceEnvironment,
+    const MathmlEnvironment& targetEnvironment
 )
 {
+    MathmlNode::Type type = frame.GetOuterType();
+
     if (
         sourceEnvironment.mDisplayStyle == targetEnvironment.mDisplayStyle
         && sourceEnvironment.mScriptLevel == targetEnvironment.mScriptLevel
         && sourceEnvironment.mColour == targetEnvironment.mColour
 #if MOZILLA_BUG_328141_WORKAROUND
-        && node->mType != MathmlNode::cTypeMtable
+        && type != MathmlNode::cTypeMtable
 #endif
     )
-        return node;
+        return;
 
-    auto_ptr<MathmlNode> newNode(new MathmlNode(MathmlNode::cTypeMstyle));
+    // The attributes for the <mstyle> element, if we end up needing one.
+    MathmlNode::AttributeSet styleAttributes;
 
     if (sourceEnvironment.mDisplayStyle != targetEnvironment.mDisplayStyle)
     {
-        if (node->mType == MathmlNode::cTypeMtable)
+        if (type == MathmlNode::cTypeMtable)
         {
             // Special case if the node in question is <mtable>, because
             // the MathML spec says that the displaystyle attribute needs
             // to be set on the <mtable> element itself, since the default
             // "false" overrides any enclosing <mstyle>.
-            node->mAttributes[MathmlNode::cAttributeDisplaystyle] =
-                (targetEnvironment.mDisplayStyle) ? L"true" : L"false";
+            frame.GetOuterAttributes().Set(
+                MathmlNode::cAttributeDisplaystyle,
+                (targetEnvironment.mDisplayStyle) ? L"true" : L"false"
+            );
         }
         else
         {
-            newNode->mAttributes[MathmlNode::cAttributeDisplaystyle] =
-                (targetEnvironment.mDisplayStyle) ? L"true" : L"false";
+            styleAttributes.Set(
+                MathmlNode::cAttributeDisplaystyle,
+                (targetEnvironment.mDisplayStyle) ? L"true" : L"false"
+            );
         }
     }
 
     if (
         sourceEnvironment.mScriptLevel != targetEnvironment.mScriptLevel
 #if MOZILLA_BUG_328141_WORKAROUND
-        || node->mType == MathmlNode::cTypeMtable
+        || type == MathmlNode::cTypeMtable
 #endif
     )
     {
         wostringstream os;
         os << targetEnvironment.mScriptLevel;
-        newNode->mAttributes
-            [MathmlNode::cAttributeScriptlevel] = os.str();
+        styleAttributes.Set(MathmlNode::cAttributeScriptlevel, os.str());
     }
 
     if (sourceEnvironment.mColour != targetEnvironment.mColour)
     {
         // If the child is a token element, we can just add mathcolor
         // directly
-        switch (node->mType)
+        switch (type)
         {
             case MathmlNode::cTypeMi:
             case MathmlNode::cTypeMo:
             case MathmlNode::cTypeMn:
             case MathmlNode::cTypeMtext:
-                node->mAttributes[MathmlNode::cAttributeMathcolor] =
-                    FormatColour(targetEnvironment.mColour);
+                frame.GetOuterAttributes().Set(
+                    MathmlNode::cAttributeMathcolor,
+                    FormatColour(targetEnvironment.mColour)
+                );
                 break;
-                
+
             default:
-                newNode->mAttributes[MathmlNode::cAttributeMathcolor] =
-                    FormatColour(targetEnvironment.mColour);
+                styleAttributes.Set(
+                    MathmlNode::cAttributeMathcolor,
+                    FormatColour(targetEnvironment.mColour)
+                );
                 break;
         }
     }
 
-    if (newNode->mAttributes.empty())
-        // In some cases we don't actually need an <mstyle> node, and just
-        // return the original node. (This can happen if either (1) the
-        // child is an <mtable> where only the displaystyle got modified,
-        // or (2) it was a token element and only the colour got modified.)
-        return node;
+    if (styleAttributes.IsEmpty())
+        // In some cases we don't actually need an <mstyle> element.
+        // (This can happen if either (1) the frame is an <mtable> where
+        // only the displaystyle got modified, or (2) it was a token
+        // element and only the colour got modified.)
+        return;
 
-    if (node->mType == MathmlNode::cTypeMrow)
-        // If the child is an mrow, we can splice it out
-        newNode->mChildren.swap(node->mChildren);
+    if (type != MathmlNode::cTypeMrow)
+        frame.Wrap(MathmlNode::cTypeMstyle);
     else
-        newNode->mChildren.push_back(node.release());
-    
-    return newNode;
+        // If the outer element is an mrow, we can turn it into the
+        // <mstyle> instead
+        frame.mElements.back().mType = MathmlNode::cTypeMstyle;
+
+    frame.GetOuterAttributes() = styleAttributes;
 }
 
 
-auto_ptr<MathmlNode> Row::BuildMathmlTree(
+// This function works out the MathML items for the children of "row",
+// and the spacing between them, and stores them in "entries".
+void PlanRowEntries(
+    const Row& row,
     const MathmlOptions& options,
-    const MathmlEnvironment& inheritedEnvironment,
+    RowEntryVector& entries,
     unsigned& nodeCount
-) const
+)
 {
-    // The strategy is:
-    // First write each output node to "outputNode", but simultaneously
-    // keep a list of MathmlEnvironments corresponding to the desired
-    // environment for each node. Then, do a second pass inserting <mstyle>
-    // nodes to implement those desired environments.
-    
-    auto_ptr<MathmlNode> outputNode(new MathmlNode(MathmlNode::cTypeMrow));
-    list<MathmlNode*>& outputList = outputNode->mChildren;
-        
-    IncrementNodeCount(nodeCount);
-    
-    if (mChildren.empty())
-        return outputNode;
-
-    vector<MathmlEnvironment> environments;
-
-    for (list<Node*>::const_iterator
-        source = mChildren.begin();
+    for (NodeList::const_iterator
+        source = row.mChildren.begin();
         true;
         ++source
     )
     {
-        MathmlNode* previousTarget =
-            outputList.empty() ? NULL : outputList.back();
-    
+        MathmlFrame* previousFrame =
+            entries.empty() ? NULL : entries.back().mFrame;
+
         int spaceWidth = 0;
         bool isUserRequested = false;
 
         Space* sourceAsSpace =
-            (source == mChildren.end())
+            (source == row.mChildren.end())
                 ? NULL : dynamic_cast<Space*>(*source);
         if (sourceAsSpace)
         {
@@ -285,38 +429,28 @@ auto_ptr<MathmlNode> Row::BuildMathmlTree(
             isUserRequested = sourceAsSpace->mIsUserRequested;
             source++;
         }
-        
-        MathmlNode* currentTarget = NULL;
-        if (source != mChildren.end())
-        {
-            environments.push_back(
-                MathmlEnvironment((*source)->mStyle, (*source)->mColour)
-            );
 
-            outputList.push_back(
-                (*source)->BuildMathmlTree(
-                    options,
-                    environments.back(),
-                    nodeCount
-                ).release()
+        MathmlFrame* currentFrame = NULL;
+        if (source != row.mChildren.end())
+        {
+            MathmlEnvironment environment(
+                (*source)->mStyle, (*source)->mColour
             );
-            
-            currentTarget = outputList.back();
+            currentFrame =
+                (*source)->PrepareMathml(options, environment, nodeCount);
+            entries.push_back(RowEntry(currentFrame, environment));
         }
-        
-        // Now decide about whether to insert markup for the
-        // space between currentNode and previousNode.
 
-        MathmlNode*  currentNucleus = GetCore(currentTarget);
-        MathmlNode* previousNucleus = GetCore(previousTarget);
+        // Now decide about whether to insert markup for the
+        // space between currentFrame and previousFrame.
 
         bool isPreviousMo =
-            previousNucleus &&
-            (previousNucleus->mType == MathmlNode::cTypeMo);
+            previousFrame &&
+            (GetCoreType(*previousFrame) == MathmlNode::cTypeMo);
 
         bool isCurrentMo =
-            currentNucleus &&
-            (currentNucleus->mType == MathmlNode::cTypeMo);
+            currentFrame &&
+            (GetCoreType(*currentFrame) == MathmlNode::cTypeMo);
 
         bool doSpace = false;
 
@@ -336,7 +470,7 @@ auto_ptr<MathmlNode> Row::BuildMathmlTree(
             // spacing decisions, without being *too* pushy.
 
             // This section of code is likely to change a LOT.
-            
+
             // Note: I scratched most of this as of blahtex 0.4.4....
             // it was getting really ugly and I need to think of another
             // way to do it
@@ -367,15 +501,22 @@ auto_ptr<MathmlNode> Row::BuildMathmlTree(
 
             if (isPreviousMo)
             {
-                previousNucleus->mAttributes
-                    [MathmlNode::cAttributeRspace] = widthAsString;
+                SetCoreAttribute(
+                    *previousFrame,
+                    MathmlNode::cAttributeRspace,
+                    widthAsString
+                );
                 if (isCurrentMo)
-                    currentNucleus->mAttributes
-                        [MathmlNode::cAttributeLspace] = L"0";
+                    SetCoreAttribute(
+                        *currentFrame, MathmlNode::cAttributeLspace, L"0"
+                    );
             }
             else if (isCurrentMo)
-                currentNucleus->mAttributes
-                    [MathmlNode::cAttributeLspace] = widthAsString;
+                SetCoreAttribute(
+                    *currentFrame,
+                    MathmlNode::cAttributeLspace,
+                    widthAsString
+                );
             else
             {
                 // FIX: this <mi>-specific stuff is a nasty hack because
@@ -384,111 +525,188 @@ auto_ptr<MathmlNode> Row::BuildMathmlTree(
                 // See https://bugzilla.mozilla.org/show_bug.cgi?id=320294
 
                 bool isPreviousMi =
-                    previousNucleus &&
-                    (previousNucleus->mType == MathmlNode::cTypeMi);
+                    previousFrame &&
+                    (GetCoreType(*previousFrame) == MathmlNode::cTypeMi);
 
                 bool isCurrentMi =
-                    currentNucleus &&
-                    (currentNucleus->mType == MathmlNode::cTypeMi);
+                    currentFrame &&
+                    (GetCoreType(*currentFrame) == MathmlNode::cTypeMi);
 
                 if (spaceWidth != 0 || (isPreviousMi && isCurrentMi))
                 {
-                    auto_ptr<MathmlNode> spaceNode(
-                        new MathmlNode(MathmlNode::cTypeMspace)
-                    );
+                    MathmlFrame* spaceFrame =
+                        new MathmlFrame(MathmlNode::cTypeMspace, NULL);
                     IncrementNodeCount(nodeCount);
-                    spaceNode->mAttributes
-                        [MathmlNode::cAttributeWidth] = widthAsString;
+                    spaceFrame->GetOuterAttributes().Set(
+                        MathmlNode::cAttributeWidth, widthAsString
+                    );
 
-                    if (currentTarget)
+                    if (currentFrame)
                     {
-                        outputList.insert(
-                            --outputList.end(),
-                            spaceNode.release()
+                        RowEntry entry(
+                            spaceFrame, entries.back().mEnvironment
                         );
-                        environments.push_back(environments.back());
+                        entries.insert(entries.end() - 1, entry);
                     }
                     else
-                    {
-                        outputList.push_back(spaceNode.release());
-                        environments.push_back(
-                            MathmlEnvironment(mStyle, mColour)
+                        entries.push_back(
+                            RowEntry(
+                                spaceFrame,
+                                MathmlEnvironment(row.mStyle, row.mColour)
+                            )
                         );
-                    }
                 }
             }
         }
 
-        if (source == mChildren.end())
+        if (source == row.mChildren.end())
             break;
     }
+}
 
-    // Now do second pass where styles get adjusted
-    list<MathmlNode*>::iterator outputPtr = outputList.end();
-    for (vector<MathmlEnvironment>::reverse_iterator
-        environment = environments.rbegin();
-        environment != environments.rend();
-        environment++
-    )
+
+// Writes the items of a row. Whenever the environment changes from one
+// item to the next, the rest of the row goes inside an <mstyle> (or, for
+// the last item, the item itself gets adjusted).
+void WriteRowEntries(
+    MathmlWriter& writer,
+    const MathmlOptions& options,
+    RowEntryVector& entries,
+    unsigned& nodeCount
+)
+{
+    // The elements that have been started on behalf of the whole row, in
+    // the order they were started.
+    vector<MathmlNode::Type, ArenaAllocator<MathmlNode::Type> > openTypes;
+
+    for (size_t index = 0; index < entries.size(); index++)
     {
-        if (outputPtr != outputList.begin())
-            outputPtr--;
-        
-        if (environment == environments.rbegin())
-            continue;
-        
-        if (!(environment[-1] == environment[0]))
+        RowEntry& entry = entries[index];
+
+        if (index > 0 &&
+            !(entries[index - 1].mEnvironment == entry.mEnvironment)
+        )
         {
-            list<MathmlNode*>::iterator previousOutputPtr = outputPtr;
-            previousOutputPtr++;
-            
-            auto_ptr<MathmlNode> enclosedNode;
-            
-            if (--outputList.end() == previousOutputPtr)
-            {
-                // If outputPtr is already the last node, we don't need
-                // to create a new <mrow>
-                enclosedNode.reset(*previousOutputPtr);
-                outputList.pop_back();
-            }
+            if (index + 1 == entries.size())
+                // If this is already the last item, we don't need to
+                // create a new <mrow>
+                AdjustMathmlEnvironment(
+                    *entry.mFrame,
+                    entries[index - 1].mEnvironment,
+                    entry.mEnvironment
+                );
             else
             {
-                enclosedNode.reset(new MathmlNode(MathmlNode::cTypeMrow));
-                enclosedNode->mChildren.splice(
-                    enclosedNode->mChildren.begin(),
-                    outputList,
-                    previousOutputPtr,
-                    outputList.end()
+                MathmlFrame enclosing(MathmlNode::cTypeMrow, NULL);
+                AdjustMathmlEnvironment(
+                    enclosing,
+                    entries[index - 1].mEnvironment,
+                    entry.mEnvironment
                 );
+
+                for (size_t i = enclosing.mElements.size(); i > 0; i--)
+                {
+                    writer.StartElement(
+                        enclosing.mElements[i - 1].mType,
+                        enclosing.mElements[i - 1].mAttributes
+                    );
+                    openTypes.push_back(enclosing.mElements[i - 1].mType);
+                }
             }
-            
-            outputList.push_back(
-                AdjustMathmlEnvironment(
-                    enclosedNode,
-                    environment[0],
-                    environment[-1]
-                ).release()
-            );
         }
+
+        WriteMathmlFrame(writer, options, *entry.mFrame, nodeCount);
     }
-    
+
+    while (!openTypes.empty())
+    {
+        writer.EndElement(openTypes.back());
+        openTypes.pop_back();
+    }
+}
+
+
+MathmlFrame* Row::PrepareMathml(
+    const MathmlOptions& options,
+    const MathmlEnvironment& inheritedEnvironment,
+    unsigned& nodeCount
+) const
+{
+    IncrementNodeCount(nodeCount);
+
+    if (mChildren.empty())
+        return new MathmlFrame(MathmlNode::cTypeMrow, NULL);
+
+    // Find the first child that isn't just a space before the next one
+    // (see PlanRowEntries), and check whether there are any more.
+    const Node* firstChild = NULL;
+    bool hasSeveralChildren = false;
+    for (NodeList::const_iterator
+        source = mChildren.begin();
+        source != mChildren.end();
+        ++source
+    )
+    {
+        if (dynamic_cast<Space*>(*source) && ++source == mChildren.end())
+            break;
+
+        if (firstChild)
+        {
+            hasSeveralChildren = true;
+            break;
+        }
+        firstChild = *source;
+    }
+
+    if (hasSeveralChildren)
+    {
+        // The result will be an <mrow> with at least two children
+        // whatever happens, so the children can wait until
+        // WriteMathmlContent().
+        MathmlFrame* frame = new MathmlFrame(MathmlNode::cTypeMrow, this);
+        AdjustMathmlEnvironment(
+            *frame,
+            inheritedEnvironment,
+            MathmlEnvironment(firstChild->mStyle, firstChild->mColour)
+        );
+        return frame;
+    }
+
+    RowEntryVector entries;
+    PlanRowEntries(*this, options, entries, nodeCount);
+
+    if (entries.empty())
+        return new MathmlFrame(MathmlNode::cTypeMrow, NULL);
+
+    MathmlEnvironment firstEnvironment = entries[0].mEnvironment;
+    MathmlFrame* frame;
+
     // If the result is an <mrow> with a single child, just return the
     // child by itself.
-    // (We don't use list::size() here because that's O(n) :-))
-    if (!outputNode->mChildren.empty() &&
-        outputNode->mChildren.front() == outputNode->mChildren.back()
-    )
+    if (entries.size() == 1)
+        frame = entries[0].mFrame;
+    else
     {
-        MathmlNode* child = outputNode->mChildren.back();
-        outputNode->mChildren.pop_back();       // relinquish ownership
-        outputNode.reset(child);
+        frame = new MathmlFrame(MathmlNode::cTypeMrow, this);
+        frame->mRowEntries.swap(entries);
     }
 
-    return AdjustMathmlEnvironment(
-        outputNode,
-        inheritedEnvironment,
-        environments[0]
-    );
+    AdjustMathmlEnvironment(*frame, inheritedEnvironment, firstEnvironment);
+    return frame;
+}
+
+
+void Row::WriteMathmlContent(
+    MathmlWriter& writer,
+    const MathmlOptions& options,
+    MathmlFrame& frame,
+    unsigned& nodeCount
+) const
+{
+    if (frame.mRowEntries.empty())
+        PlanRowEntries(*this, options, frame.mRowEntries, nodeCount);
+
+    WriteRowEntries(writer, options, frame.mRowEntries, nodeCount);
 }
 
 
@@ -527,228 +745,317 @@ wchar_t FixOutOfSequenceMathmlCharacter(wchar_t c)
 }
 
 
-auto_ptr<MathmlNode> SymbolIdentifier::BuildMathmlTree(
-    const MathmlOptions& options,
-    const MathmlEnvironment& inheritedEnvironment,
-    unsigned& nodeCount
-) const
+// Returns true if the identifier is in one of the "fancy" fonts (fraktur,
+// script, bold-fraktur, bold-script, double-struck) and MathML version 1.x
+// fonts are requested, since then we need to explicitly substitute MathML
+// entities.
+bool IsVersion1FancyFont(
+    MathmlFont font,
+    const MathmlOptions& options
+)
 {
-    auto_ptr<MathmlNode> node(new MathmlNode(MathmlNode::cTypeMi, mText));
-    IncrementNodeCount(nodeCount);
-
-    // Here we have a special case to deal with the "fancy" fonts
-    // (fraktur, script, bold-fraktur, bold-script, double-struck)
-    // when MathML version 1.x fonts are requested, since then we need
-    // to explicitly substitute MathML entities.
-    if (
+    return
         options.mUseVersion1FontAttributes &&
         (
-            mFont == cMathmlFontFraktur ||
-            mFont == cMathmlFontBoldFraktur ||
-            mFont == cMathmlFontDoubleStruck ||
-            mFont == cMathmlFontScript ||
-            mFont == cMathmlFontBoldScript
-        )
-    )
-    {
-        if (mText.size() != 1)
-            throw logic_error(
-                "Unexpected string length in "
-                "SymbolIdentifier::BuildMathmlTree()"
-            );
-        
-        wchar_t replacement = 0;
+            font == cMathmlFontFraktur ||
+            font == cMathmlFontBoldFraktur ||
+            font == cMathmlFontDoubleStruck ||
+            font == cMathmlFontScript ||
+            font == cMathmlFontBoldScript
+        );
+}
+
+// Returns the explicit character to use for an identifier in a fancy font
+// (see IsVersion1FancyFont). Sets isBold if the <mi> also needs
+// fontweight="bold".
+wchar_t GetVersion1FancyCharacter(
+    const SymbolIdentifier& symbol,
+    const MathmlOptions& options,
+    bool& isBold
+)
+{
+    const wstring& text = symbol.mText;
+    if (text.size() != 1)
+        throw logic_error(
+            "Unexpected string length in GetVersion1FancyCharacter()"
+        );
 
-        // These hold the explicit characters for "A" and "a" in the
-        // desired font (or zero if unavailable)
-        wchar_t baseUppercase = 0, baseLowercase = 0;
+    wchar_t replacement = 0;
+    isBold = false;
 
-        switch (mFont)
-        {
-            case cMathmlFontBoldScript:
-                if (options.mAllowPlane1)
-                {
-                    baseUppercase = L'\U0001D4D0';
-                    break;
-                }
-                else
-                {
-                    // If we don't have plane 1 characters available, then
-                    // we'll just have to do e.g.
-                    // <mi fontweight="bold">&Acal;</mi>
-                    // since there aren't specific MathML names for bold
-                    // script capitals.
-                    node->mAttributes
-                        [MathmlNode::cAttributeFontweight] = L"bold";
-                    baseUppercase = L'\U0001D49C';
-                    break;
-                }
+    // These hold the explicit characters for "A" and "a" in the
+    // desired font (or zero if unavailable)
+    wchar_t baseUppercase = 0, baseLowercase = 0;
 
-            case cMathmlFontScript:
+    switch (symbol.mFont)
+    {
+        case cMathmlFontBoldScript:
+            if (options.mAllowPlane1)
+            {
+                baseUppercase = L'\U0001D4D0';
+                break;
+            }
+            else
+            {
+                // If we don't have plane 1 characters available, then
+                // we'll just have to do e.g.
+                // <mi fontweight="bold">&Acal;</mi>
+                // since there aren't specific MathML names for bold
+                // script capitals.
+                isBold = true;
                 baseUppercase = L'\U0001D49C';
                 break;
+            }
 
-            case cMathmlFontBoldFraktur:
-                if (options.mAllowPlane1)
-                {
-                    baseUppercase = L'\U0001D56C';
-                    baseLowercase = L'\U0001D586';
-                    break;
-                }
-                else
-                {
-                    // See comments above under cMathmlFontBoldScript
-                    node->mAttributes
-                        [MathmlNode::cAttributeFontweight] = L"bold";
-                    baseUppercase = L'\U0001D504';
-                    baseLowercase = L'\U0001D51E';
-                    break;
-                }
+        case cMathmlFontScript:
+            baseUppercase = L'\U0001D49C';
+            break;
 
-            case cMathmlFontFraktur:
+        case cMathmlFontBoldFraktur:
+            if (options.mAllowPlane1)
+            {
+                baseUppercase = L'\U0001D56C';
+                baseLowercase = L'\U0001D586';
+                break;
+            }
+            else
+            {
+                // See comments above under cMathmlFontBoldScript
+                isBold = true;
                 baseUppercase = L'\U0001D504';
                 baseLowercase = L'\U0001D51E';
                 break;
+            }
 
-            case cMathmlFontDoubleStruck:
-                baseUppercase = L'\U0001D538';
-                break;
-        }
-
-        if (baseUppercase && mText[0] >= 'A' && mText[0] <= 'Z')
-            replacement = baseUppercase + (mText[0] - 'A');
-        if (baseLowercase && mText[0] >= 'a' && mText[0] <= 'z')
-            replacement = baseLowercase + (mText[0] - 'a');
+        case cMathmlFontFraktur:
+            baseUppercase = L'\U0001D504';
+            baseLowercase = L'\U0001D51E';
+            break;
 
-        if (!replacement)
-            throw logic_error(
-                "Unexpected character/font combination in "
-                "SymbolIdentifier::BuildMathmlTree()"
-            );
+        case cMathmlFontDoubleStruck:
+            baseUppercase = L'\U0001D538';
+            break;
+    }
 
-        node->mText =
-            wstring(1, FixOutOfSequenceMathmlCharacter(replacement));
+    if (baseUppercase && text[0] >= 'A' && text[0] <= 'Z')
+        replacement = baseUppercase + (text[0] - 'A');
+    if (baseLowercase && text[0] >= 'a' && text[0] <= 'z')
+        replacement = baseLowercase + (text[0] - 'a');
 
-        return AdjustMathmlEnvironment(
-            node,
-            inheritedEnvironment,
-            MathmlEnvironment(mStyle, mColour)
+    if (!replacement)
+        throw logic_error(
+            "Unexpected character/font combination in "
+            "GetVersion1FancyCharacter()"
         );
-    }
 
-    node->AddFontAttributes(mFont, options);
-    return AdjustMathmlEnvironment(
-        node, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
-    );
+    return FixOutOfSequenceMathmlCharacter(replacement);
 }
 
 
-auto_ptr<MathmlNode> SymbolOperator::BuildMathmlTree(
+MathmlFrame* SymbolIdentifier::PrepareMathml(
     const MathmlOptions& options,
     const MathmlEnvironment& inheritedEnvironment,
     unsigned& nodeCount
 ) const
 {
-    // These are all the operators that stretch by default in the normative
-    // operator dictionary. If we *don't* want them to stretch, we need
-    // to explicitly say so.
-    static wchar_t stretchyByDefaultArray[] =
+    MathmlFrame* frame = new MathmlFrame(MathmlNode::cTypeMi, this);
+    IncrementNodeCount(nodeCount);
+
+    if (IsVersion1FancyFont(mFont, options))
     {
-        L'(',
-        L')',
-        L'[',
-        L']',
-        L'{',
-        L'}',
-        L'|',
-        L'/',
-        L'\U000002DC',      // DiacriticalTilde
-        L'\U000002C7',      // Hacek
-        L'\U000002D8',      // Breve
-        L'\U00002216',      // Backslash
-        L'\U00002329',      // LeftAngleBracket
-        L'\U0000232A',      // RightAngleBracket
-        L'\U00002308',      // LeftCeiling
-        L'\U00002309',      // RightCeiling
-        L'\U0000230A',      // LeftFloor
-        L'\U0000230B',      // RightFloor
-        L'\U00002211',      // Sum
-        L'\U0000220F',      // Product
-        L'\U0000222B',      // Integral
-        L'\U0000222C',      // Int
-        L'\U0000222D',      // iiint
-        L'\U00002A0C',      // iiiint
-        L'\U0000222E',      // ContourIntegral
-        L'\U000022C2',      // Intersection
-        L'\U00002A00',      // bigodot
-        L'\U00002A02',      // bigotimes
-        L'\U00002210',      // Coproduct
-        L'\U00002A06',      // bigsqcup
-        L'\U00002A01',      // bigoplus
-        L'\U000022C1',      // Vee
-        L'\U00002A04',      // biguplus
-        L'\U000022C0'       // Wedge
-    };
-    static wishful_hash_set<wchar_t> stretchyByDefaultTable(
-        stretchyByDefaultArray,
-        END_ARRAY(stretchyByDefaultArray)
+        // The text gets replaced in WriteMathmlContent.
+        bool isBold;
+        GetVersion1FancyCharacter(*this, options, isBold);
+        if (isBold)
+            frame->GetOuterAttributes().Set(
+                MathmlNode::cAttributeFontweight, L"bold"
+            );
+    }
+    else
+        AddFontAttributes(
+            frame->GetOuterAttributes(),
+            MathmlNode::cTypeMi,
+            mText,
+            mFont,
+            options
+        );
+
+    AdjustMathmlEnvironment(
+        *frame, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
     );
+    return frame;
+}
 
-    // Special case for "\not":
-    if (mText == L"NOT")
+
+void SymbolIdentifier::WriteMathmlContent(
+    MathmlWriter& writer,
+    const MathmlOptions& options,
+    MathmlFrame& frame,
+    unsigned& nodeCount
+) const
+{
+    if (IsVersion1FancyFont(mFont, options))
     {
-        auto_ptr<MathmlNode> node(new MathmlNode(MathmlNode::cTypeMpadded));
-        auto_ptr<MathmlNode> space(new MathmlNode(MathmlNode::cTypeMspace));
-        space->mAttributes[MathmlNode::cAttributeWidth] = L"0.1em";
-        node->mChildren.push_back(space.release());
-        node->mChildren.push_back(
-            new MathmlNode(MathmlNode::cTypeMo, L"/")
+        bool isBold;
+        writer.Text(
+            wstring(1, GetVersion1FancyCharacter(*this, options, isBold))
         );
-        node->mAttributes[MathmlNode::cAttributeWidth] = L"0";
-        return node;
     }
+    else
+        Symbol::WriteMathmlContent(writer, options, frame, nodeCount);
+}
 
-    // And these are the characters that are accents by default;
-    // again we may need to modify this explicitly.
-    static wchar_t accentByDefaultArray[] =
+
+void Symbol::WriteMathmlContent(
+    MathmlWriter& writer,
+    const MathmlOptions& options,
+    MathmlFrame& frame,
+    unsigned& nodeCount
+) const
+{
+    if (mEncodedText)
+        writer.PreEncodedText(mText, *mEncodedText);
+    else
+        writer.Text(mText);
+}
+
+
+// These are all the operators that stretch by default in the normative
+// operator dictionary. If we *don't* want them to stretch, we need
+// to explicitly say so. (Sorted, for binary_search.)
+static const wchar_t gStretchyByDefaultArray[] =
+{
+    L'(',
+    L')',
+    L'/',
+    L'[',
+    L']',
+    L'{',
+    L'|',
+    L'}',
+    L'\U000002C7',      // Hacek
+    L'\U000002D8',      // Breve
+    L'\U000002DC',      // DiacriticalTilde
+    L'\U0000220F',      // Product
+    L'\U00002210',      // Coproduct
+    L'\U00002211',      // Sum
+    L'\U00002216',      // Backslash
+    L'\U0000222B',      // Integral
+    L'\U0000222C',      // Int
+    L'\U0000222D',      // iiint
+    L'\U0000222E',      // ContourIntegral
+    L'\U000022C0',      // Wedge
+    L'\U000022C1',      // Vee
+    L'\U000022C2',      // Intersection
+    L'\U00002308',      // LeftCeiling
+    L'\U00002309',      // RightCeiling
+    L'\U0000230A',      // LeftFloor
+    L'\U0000230B',      // RightFloor
+    L'\U00002329',      // LeftAngleBracket
+    L'\U0000232A',      // RightAngleBracket
+    L'\U00002A00',      // bigodot
+    L'\U00002A01',      // bigoplus
+    L'\U00002A02',      // bigotimes
+    L'\U00002A04',      // biguplus
+    L'\U00002A06',      // bigsqcup
+    L'\U00002A0C'       // iiiint
+};
+
+
+// And these are the characters that are accents by default;
+// again we may need to modify this explicitly. (Also sorted.)
+static const wchar_t gAccentByDefaultArray[] =
+{
+    L'\U0000FE37',
+    L'\U0000FE38'
+};
+
+
+MathmlFrame* SymbolOperator::PrepareMathml(
+    const MathmlOptions& options,
+    const MathmlEnvironment& inheritedEnvironment,
+    unsigned& nodeCount
+) const
+{
+    // Special case for "\not" (see WriteMathmlContent):
+    if (mText == L"NOT")
     {
-        L'\U0000FE37',
-        L'\U0000FE38'
-    };
-    static wishful_hash_set<wchar_t> accentByDefaultTable(
-        accentByDefaultArray,
-        END_ARRAY(accentByDefaultArray)
-    );
+        MathmlFrame* frame =
+            new MathmlFrame(MathmlNode::cTypeMpadded, this);
+        frame->GetOuterAttributes().Set(MathmlNode::cAttributeWidth, L"0");
+        return frame;
+    }
 
-    auto_ptr<MathmlNode> node(new MathmlNode(MathmlNode::cTypeMo, mText));
+    MathmlFrame* frame = new MathmlFrame(MathmlNode::cTypeMo, this);
+    MathmlNode::AttributeSet& attributes = frame->GetOuterAttributes();
 
     if (mIsStretchy)
     {
-        node->mAttributes[MathmlNode::cAttributeStretchy] = L"true";
+        attributes.Set(MathmlNode::cAttributeStretchy, L"true");
         if (!mSize.empty())
-            node->mAttributes[MathmlNode::cAttributeMinsize] =
-            node->mAttributes[MathmlNode::cAttributeMaxsize] = mSize;
+        {
+            attributes.Set(MathmlNode::cAttributeMinsize, mSize);
+            attributes.Set(MathmlNode::cAttributeMaxsize, mSize);
+        }
     }
-    else if (mText.size() == 1 && stretchyByDefaultTable.count(mText[0]))
-        node->mAttributes[MathmlNode::cAttributeStretchy] = L"false";
+    else if (mText.size() == 1 &&
+        binary_search(
+            gStretchyByDefaultArray,
+            END_ARRAY(gStretchyByDefaultArray),
+            mText[0]
+        )
+    )
+        attributes.Set(MathmlNode::cAttributeStretchy, L"false");
 
     if (mIsAccent)
     {
-        node->mAttributes[MathmlNode::cAttributeAccent] = L"true";
-        return node;
+        attributes.Set(MathmlNode::cAttributeAccent, L"true");
+        return frame;
     }
-    else if (mText.size() == 1 && accentByDefaultTable.count(mText[0]))
-        node->mAttributes[MathmlNode::cAttributeAccent] = L"false";
+    else if (mText.size() == 1 &&
+        binary_search(
+            gAccentByDefaultArray,
+            END_ARRAY(gAccentByDefaultArray),
+            mText[0]
+        )
+    )
+        attributes.Set(MathmlNode::cAttributeAccent, L"false");
 
-    node->AddFontAttributes(mFont, options);
+    AddFontAttributes(attributes, MathmlNode::cTypeMo, mText, mFont, options);
 
-    return AdjustMathmlEnvironment(
-        node, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
+    AdjustMathmlEnvironment(
+        *frame, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
     );
+    return frame;
 }
 
 
-auto_ptr<MathmlNode> SymbolNumber::BuildMathmlTree(
+void SymbolOperator::WriteMathmlContent(
+    MathmlWriter& writer,
+    const MathmlOptions& options,
+    MathmlFrame& frame,
+    unsigned& nodeCount
+) const
+{
+    if (mText == L"NOT")
+    {
+        MathmlNode::AttributeSet spaceAttributes;
+        spaceAttributes.Set(MathmlNode::cAttributeWidth, L"0.1em");
+        writer.StartElement(MathmlNode::cTypeMspace, spaceAttributes);
+        writer.EndElement(MathmlNode::cTypeMspace);
+
+        writer.StartElement(
+            MathmlNode::cTypeMo, MathmlNode::AttributeSet()
+        );
+        writer.Text(L"/");
+        writer.EndElement(MathmlNode::cTypeMo);
+    }
+    else
+        Symbol::WriteMathmlContent(writer, options, frame, nodeCount);
+}
+
+
+MathmlFrame* SymbolNumber::PrepareMathml(
     const MathmlOptions& options,
     const MathmlEnvironment& inheritedEnvironment,
     unsigned& nodeCount
@@ -757,33 +1064,39 @@ auto_ptr<MathmlNode> SymbolNumber::BuildMathmlTree(
     // FIX: what about merging commas, decimal points into <mn> nodes?
     // Might need to special-case it.
 
-    auto_ptr<MathmlNode> node(new MathmlNode(MathmlNode::cTypeMn, mText));
+    MathmlFrame* frame = new MathmlFrame(MathmlNode::cTypeMn, this);
     IncrementNodeCount(nodeCount);
-    node->AddFontAttributes(mFont, options);
-    return AdjustMathmlEnvironment(
-        node, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
+    AddFontAttributes(
+        frame->GetOuterAttributes(), MathmlNode::cTypeMn, mText, mFont,
+        options
     );
+    AdjustMathmlEnvironment(
+        *frame, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
+    );
+    return frame;
 }
 
 
-auto_ptr<MathmlNode> SymbolText::BuildMathmlTree(
+MathmlFrame* SymbolText::PrepareMathml(
     const MathmlOptions& options,
     const MathmlEnvironment& inheritedEnvironment,
     unsigned& nodeCount
 ) const
 {
-    auto_ptr<MathmlNode> node(
-        new MathmlNode(MathmlNode::cTypeMtext, mText)
-    );
+    MathmlFrame* frame = new MathmlFrame(MathmlNode::cTypeMtext, this);
     IncrementNodeCount(nodeCount);
-    node->AddFontAttributes(mFont, options);
-    return AdjustMathmlEnvironment(
-        node, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
+    AddFontAttributes(
+        frame->GetOuterAttributes(), MathmlNode::cTypeMtext, mText, mFont,
+        options
     );
+    AdjustMathmlEnvironment(
+        *frame, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
+    );
+    return frame;
 }
 
 
-auto_ptr<MathmlNode> Sqrt::BuildMathmlTree(
+MathmlFrame* Sqrt::PrepareMathml(
     const MathmlOptions& options,
     const MathmlEnvironment& inheritedEnvironment,
     unsigned& nodeCount
@@ -791,86 +1104,87 @@ auto_ptr<MathmlNode> Sqrt::BuildMathmlTree(
 {
     MathmlEnvironment desiredEnvironment(mStyle, mColour);
 
-    auto_ptr<MathmlNode> child =
-        mChild->BuildMathmlTree(
-            options, desiredEnvironment, nodeCount
-        );
-    
-    auto_ptr<MathmlNode> node;
-    
-    if (child->mType == MathmlNode::cTypeMrow)
+    MathmlFrame* child =
+        mChild->PrepareMathml(options, desiredEnvironment, nodeCount);
+
+    MathmlFrame* frame;
+
+    if (child->GetOuterType() == MathmlNode::cTypeMrow)
     {
         // This removes redundant <mrow>s, i.e. things like
         // <msqrt><mrow>...</mrow></msqrt>
-        node = child;
-        node->mType = MathmlNode::cTypeMsqrt;
+        frame = child;
+        frame->mElements.back().mType = MathmlNode::cTypeMsqrt;
     }
     else
     {
-        node.reset(new MathmlNode(MathmlNode::cTypeMsqrt));
+        frame = new MathmlFrame(MathmlNode::cTypeMsqrt, this);
         IncrementNodeCount(nodeCount);
-        node->mChildren.push_back(child.release());
+        frame->mChild = child;
     }
 
-    return AdjustMathmlEnvironment(
-        node, inheritedEnvironment, desiredEnvironment
-    );
+    AdjustMathmlEnvironment(*frame, inheritedEnvironment, desiredEnvironment);
+    return frame;
 }
 
 
-auto_ptr<MathmlNode> Root::BuildMathmlTree(
+void Sqrt::WriteMathmlContent(
+    MathmlWriter& writer,
     const MathmlOptions& options,
-    const MathmlEnvironment& inheritedEnvironment,
+    MathmlFrame& frame,
     unsigned& nodeCount
 ) const
 {
-    auto_ptr<MathmlNode> node(new MathmlNode(MathmlNode::cTypeMroot));
-    IncrementNodeCount(nodeCount);
+    WriteMathmlFrame(writer, options, *frame.mChild, nodeCount);
+}
 
-    MathmlEnvironment desiredEnvironment(mStyle, mColour);
 
-    node->mChildren.push_back(
-        mInside->BuildMathmlTree(
-            options,
-            desiredEnvironment,
-            nodeCount
-        ).release()
+MathmlFrame* Root::PrepareMathml(
+    const MathmlOptions& options,
+    const MathmlEnvironment& inheritedEnvironment,
+    unsigned& nodeCount
+) const
+{
+    MathmlFrame* frame = new MathmlFrame(MathmlNode::cTypeMroot, this);
+    IncrementNodeCount(nodeCount);
+    AdjustMathmlEnvironment(
+        *frame, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
     );
+    return frame;
+}
 
-    node->mChildren.push_back(
-        mOutside->BuildMathmlTree(
-            options,
-            MathmlEnvironment(false, 2, mColour),
-            nodeCount
-        ).release()
+
+void Root::WriteMathmlContent(
+    MathmlWriter& writer,
+    const MathmlOptions& options,
+    MathmlFrame& frame,
+    unsigned& nodeCount
+) const
+{
+    mInside->WriteMathml(
+        writer, options, MathmlEnvironment(mStyle, mColour), nodeCount
     );
-    
-    return AdjustMathmlEnvironment(
-        node, inheritedEnvironment, desiredEnvironment
+    mOutside->WriteMathml(
+        writer, options, MathmlEnvironment(false, 2, mColour), nodeCount
     );
 }
 
 
-auto_ptr<MathmlNode> Scripts::BuildMathmlTree(
+MathmlFrame* Scripts::PrepareMathml(
     const MathmlOptions& options,
     const MathmlEnvironment& inheritedEnvironment,
     unsigned& nodeCount
 ) const
 {
-    // Simulate the change in rendering environment for the super/
-    // sub/over/underscripts.
     MathmlEnvironment baseEnvironment(mStyle, mColour);
-    MathmlEnvironment scriptEnvironment = baseEnvironment;
-    scriptEnvironment.mDisplayStyle = false;
-    scriptEnvironment.mScriptLevel++;
 
-    auto_ptr<MathmlNode> base;
+    MathmlFrame* base;
     if (mBase.get())
-        base = mBase->BuildMathmlTree(options, baseEnvironment, nodeCount);
+        base = mBase->PrepareMathml(options, baseEnvironment, nodeCount);
     else
     {
         // An empty base gets represented by "<mrow/>"
-        base.reset(new MathmlNode(MathmlNode::cTypeMrow));
+        base = new MathmlFrame(MathmlNode::cTypeMrow, NULL);
         IncrementNodeCount(nodeCount);
     }
 
@@ -892,42 +1206,9 @@ auto_ptr<MathmlNode> Scripts::BuildMathmlTree(
             ? MathmlNode::cTypeMsub
             : MathmlNode::cTypeMunder;
 
-    auto_ptr<MathmlNode> scriptsNode(new MathmlNode(type));
+    MathmlFrame* frame = new MathmlFrame(type, this);
     IncrementNodeCount(nodeCount);
-    scriptsNode->mChildren.push_back(base.release());
-
-    if (mUpper.get())
-    {
-        if (mLower.get())
-        {
-            scriptsNode->mChildren.push_back(
-                mLower->BuildMathmlTree(
-                    options, scriptEnvironment, nodeCount
-                ).release()
-            );
-            scriptsNode->mChildren.push_back(
-                mUpper->BuildMathmlTree(
-                    options, scriptEnvironment, nodeCount
-                ).release()
-            );
-        }
-        else
-        {
-            scriptsNode->mChildren.push_back(
-                mUpper->BuildMathmlTree(
-                    options, scriptEnvironment, nodeCount
-                ).release()
-            );
-        }
-    }
-    else
-    {
-        scriptsNode->mChildren.push_back(
-            mLower->BuildMathmlTree(
-                options, scriptEnvironment, nodeCount
-            ).release()
-        );
-    }
+    frame->mChild = base;
 
     if (!mIsSideset && mStyle != cStyleDisplay)
     {
@@ -944,57 +1225,82 @@ auto_ptr<MathmlNode> Scripts::BuildMathmlTree(
         // is likely to need movablelimits adjusted because of the
         // operator dictionary.
 
-        MathmlNode* core = GetCore(scriptsNode->mChildren.front());
-        if (core->mType == MathmlNode::cTypeMo)
-            core->mAttributes
-                [MathmlNode::cAttributeMovablelimits] = L"false";
+        if (GetCoreType(*base) == MathmlNode::cTypeMo)
+            SetCoreAttribute(
+                *base, MathmlNode::cAttributeMovablelimits, L"false"
+            );
     }
 
-    return AdjustMathmlEnvironment(
-        scriptsNode, inheritedEnvironment, baseEnvironment
-    );
+    AdjustMathmlEnvironment(*frame, inheritedEnvironment, baseEnvironment);
+    return frame;
+}
+
+
+void Scripts::WriteMathmlContent(
+    MathmlWriter& writer,
+    const MathmlOptions& options,
+    MathmlFrame& frame,
+    unsigned& nodeCount
+) const
+{
+    // Simulate the change in rendering environment for the super/
+    // sub/over/underscripts.
+    MathmlEnvironment scriptEnvironment(mStyle, mColour);
+    scriptEnvironment.mDisplayStyle = false;
+    scriptEnvironment.mScriptLevel++;
+
+    WriteMathmlFrame(writer, options, *frame.mChild, nodeCount);
+
+    if (mLower.get())
+        mLower->WriteMathml(writer, options, scriptEnvironment, nodeCount);
+    if (mUpper.get())
+        mUpper->WriteMathml(writer, options, scriptEnvironment, nodeCount);
 }
 
 
-auto_ptr<MathmlNode> Fraction::BuildMathmlTree(
+MathmlFrame* Fraction::PrepareMathml(
     const MathmlOptions& options,
     const MathmlEnvironment& inheritedEnvironment,
     unsigned& nodeCount
 ) const
+{
+    MathmlFrame* frame = new MathmlFrame(MathmlNode::cTypeMfrac, this);
+    IncrementNodeCount(nodeCount);
+
+    if (!mIsLineVisible)
+        frame->GetOuterAttributes().Set(
+            MathmlNode::cAttributeLinethickness, L"0"
+        );
+
+    AdjustMathmlEnvironment(
+        *frame, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
+    );
+    return frame;
+}
+
+
+void Fraction::WriteMathmlContent(
+    MathmlWriter& writer,
+    const MathmlOptions& options,
+    MathmlFrame& frame,
+    unsigned& nodeCount
+) const
 {
     // Determine the rendering style for the numerator and denominator.
-    MathmlEnvironment baseEnvironment(mStyle, mColour);
-    MathmlEnvironment smallerEnvironment = baseEnvironment;
+    MathmlEnvironment smallerEnvironment(mStyle, mColour);
     if (smallerEnvironment.mDisplayStyle)
         smallerEnvironment.mDisplayStyle = false;
     else
         smallerEnvironment.mScriptLevel++;
 
-    auto_ptr<MathmlNode> node(new MathmlNode(MathmlNode::cTypeMfrac));
-    IncrementNodeCount(nodeCount);
-
-    node->mChildren.push_back(
-        mNumerator->BuildMathmlTree(
-            options, smallerEnvironment, nodeCount
-        ).release()
-    );
-    node->mChildren.push_back(
-        mDenominator->BuildMathmlTree(
-            options, smallerEnvironment, nodeCount
-        ).release()
-    );
-
-    if (!mIsLineVisible)
-        node->mAttributes
-            [MathmlNode::cAttributeLinethickness] = L"0";
-
-    return AdjustMathmlEnvironment(
-        node, inheritedEnvironment, baseEnvironment
+    mNumerator->WriteMathml(writer, options, smallerEnvironment, nodeCount);
+    mDenominator->WriteMathml(
+        writer, options, smallerEnvironment, nodeCount
     );
 }
 
 
-auto_ptr<MathmlNode> Space::BuildMathmlTree(
+MathmlFrame* Space::PrepareMathml(
     const MathmlOptions& options,
     const MathmlEnvironment& inheritedEnvironment,
     unsigned& nodeCount
@@ -1002,148 +1308,182 @@ auto_ptr<MathmlNode> Space::BuildMathmlTree(
 {
     if (!mIsUserRequested)
         throw logic_error(
-            "Unexpected lonely automatic space in Space::BuildMathmlTree"
+            "Unexpected lonely automatic space in Space::PrepareMathml"
         );
 
     // FIX: what happens with negative space?
 
-    auto_ptr<MathmlNode> node(new MathmlNode(MathmlNode::cTypeMspace));
+    MathmlFrame* frame = new MathmlFrame(MathmlNode::cTypeMspace, NULL);
     IncrementNodeCount(nodeCount);
 
     wostringstream wos;
     wos << fixed << setprecision(3) << (mWidth / 18.0) << L"em";
-    node->mAttributes[MathmlNode::cAttributeWidth] = wos.str();
+    frame->GetOuterAttributes().Set(MathmlNode::cAttributeWidth, wos.str());
 
-    return node;
+    return frame;
 }
 
 
-auto_ptr<MathmlNode> Fenced::BuildMathmlTree(
+MathmlFrame* Fenced::PrepareMathml(
     const MathmlOptions& options,
     const MathmlEnvironment& inheritedEnvironment,
     unsigned& nodeCount
 ) const
 {
-    auto_ptr<MathmlNode> inside = mChild->BuildMathmlTree(
+    MathmlFrame* inside = mChild->PrepareMathml(
         options, MathmlEnvironment(mStyle, mColour), nodeCount
     );
 
     if (mLeftDelimiter.empty() && mRightDelimiter.empty())
         return inside;
 
-    if (inside->mType != MathmlNode::cTypeMrow)
+    if (inside->GetOuterType() != MathmlNode::cTypeMrow)
     {
         // Ensure that the stuff between the fences is surrounded by
         // an <mrow>. (I don't really understand why this is necessary,
         // but the MathML spec suggests it, and Firefox seems a bit fussy,
         // so let's just do it.)
-        auto_ptr<MathmlNode> temp(new MathmlNode(MathmlNode::cTypeMrow));
+        inside->Wrap(MathmlNode::cTypeMrow);
         IncrementNodeCount(nodeCount);
-        temp->mChildren.push_back(inside.release());
-        inside = temp;
     }
 
     // And surround the whole thing by an <mrow> as well.
     // (This one makes more sense... we want the delimiters to stretch
     // around the correct stuff.)
-    auto_ptr<MathmlNode> output(new MathmlNode(MathmlNode::cTypeMrow));
+    MathmlFrame* frame = new MathmlFrame(MathmlNode::cTypeMrow, this);
     IncrementNodeCount(nodeCount);
+    frame->mChild = inside;
 
+    // The delimiters themselves are written by WriteMathmlContent.
     if (!mLeftDelimiter.empty())
-    {
-        auto_ptr<MathmlNode> node(
-            new MathmlNode(MathmlNode::cTypeMo, mLeftDelimiter)
-        );
         IncrementNodeCount(nodeCount);
-        node->mAttributes[MathmlNode::cAttributeStretchy] = L"true";
-        output->mChildren.push_back(node.release());
-    }
-
-    output->mChildren.push_back(inside.release());
-
     if (!mRightDelimiter.empty())
-    {
-        auto_ptr<MathmlNode> node(
-            new MathmlNode(MathmlNode::cTypeMo, mRightDelimiter)
-        );
         IncrementNodeCount(nodeCount);
-        node->mAttributes[MathmlNode::cAttributeStretchy] = L"true";
-        output->mChildren.push_back(node.release());
-    }
 
-    return AdjustMathmlEnvironment(
-        output, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
+    AdjustMathmlEnvironment(
+        *frame, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
     );
+    return frame;
 }
 
 
-auto_ptr<MathmlNode> Table::BuildMathmlTree(
+void Fenced::WriteMathmlContent(
+    MathmlWriter& writer,
     const MathmlOptions& options,
-    const MathmlEnvironment& inheritedEnvironment,
+    MathmlFrame& frame,
     unsigned& nodeCount
 ) const
 {
-    auto_ptr<MathmlNode> node(new MathmlNode(MathmlNode::cTypeMtable));
-    IncrementNodeCount(nodeCount);
+    MathmlNode::AttributeSet delimiterAttributes;
+    delimiterAttributes.Set(MathmlNode::cAttributeStretchy, L"true");
+
+    if (!mLeftDelimiter.empty())
+    {
+        writer.StartElement(MathmlNode::cTypeMo, delimiterAttributes);
+        writer.Text(mLeftDelimiter);
+        writer.EndElement(MathmlNode::cTypeMo);
+    }
+
+    WriteMathmlFrame(writer, options, *frame.mChild, nodeCount);
 
-    // Compute the table width. We do this so we can "fill out" each
-    // row with the correct number of entries. Although the MathML spec
-    // doesn't require this, it seems that Firefox doesn't always align
-    // the entries properly unless we fill in the missing entries.
+    if (!mRightDelimiter.empty())
+    {
+        writer.StartElement(MathmlNode::cTypeMo, delimiterAttributes);
+        writer.Text(mRightDelimiter);
+        writer.EndElement(MathmlNode::cTypeMo);
+    }
+}
+
+
+// Computes the table width. We do this so we can "fill out" each
+// row with the correct number of entries. Although the MathML spec
+// doesn't require this, it seems that Firefox doesn't always align
+// the entries properly unless we fill in the missing entries.
+int GetTableWidth(const NodeRows& rows)
+{
     int tableWidth = 0;
-    for (vector<vector<Node*> >::const_iterator
-        row = mRows.begin();
-        row != mRows.end();
+    for (NodeRows::const_iterator
+        row = rows.begin();
+        row != rows.end();
         row++
     )
     {
         if (tableWidth < row->size())
             tableWidth = row->size();
     }
+    return tableWidth;
+}
+
+
+MathmlFrame* Table::PrepareMathml(
+    const MathmlOptions& options,
+    const MathmlEnvironment& inheritedEnvironment,
+    unsigned& nodeCount
+) const
+{
+    MathmlFrame* frame = new MathmlFrame(MathmlNode::cTypeMtable, this);
+    IncrementNodeCount(nodeCount);
+    MathmlNode::AttributeSet& attributes = frame->GetOuterAttributes();
+
+    int tableWidth = GetTableWidth(mRows);
 
     if (mAlign == cAlignLeft)
-        node->mAttributes[MathmlNode::cAttributeColumnalign] = L"left";
+        attributes.Set(MathmlNode::cAttributeColumnalign, L"left");
     else if (mAlign == cAlignRightLeft)
     {
         wstring alignString = L"right";
         for (int i = 1; i < tableWidth; i++)
             alignString += (i % 2) ? L" left" : L" right";
-        node->mAttributes[MathmlNode::cAttributeColumnalign] = alignString;
-        
+        attributes.Set(MathmlNode::cAttributeColumnalign, alignString);
+
         wstring spacingString = L"0.2em";
         for (int i = 2; i < tableWidth; i++)
             spacingString += (i % 2) ? L" 0.2em" : L" 1em";
-        node->mAttributes[MathmlNode::cAttributeColumnspacing] =
-            spacingString;
+        attributes.Set(MathmlNode::cAttributeColumnspacing, spacingString);
     }
-    
+
     // FIX: need to test this for Firefox whenever they get that bug fixed
     // (mozilla bug 330964)
     if (mRowSpacing == cRowSpacingTight)
-        node->mAttributes[MathmlNode::cAttributeRowspacing] = L"0.3ex";
+        attributes.Set(MathmlNode::cAttributeRowspacing, L"0.3ex");
+
+    AdjustMathmlEnvironment(
+        *frame, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
+    );
+    return frame;
+}
+
+
+void Table::WriteMathmlContent(
+    MathmlWriter& writer,
+    const MathmlOptions& options,
+    MathmlFrame& frame,
+    unsigned& nodeCount
+) const
+{
+    int tableWidth = GetTableWidth(mRows);
+    MathmlNode::AttributeSet noAttributes;
 
-    for (vector<vector<Node*> >::const_iterator
+    for (NodeRows::const_iterator
         inRow = mRows.begin();
         inRow != mRows.end();
         inRow++
     )
     {
-        auto_ptr<MathmlNode> outRow(new MathmlNode(MathmlNode::cTypeMtr));
+        writer.StartElement(MathmlNode::cTypeMtr, noAttributes);
         IncrementNodeCount(nodeCount);
         int count = 0;
-        for (vector<Node*>::const_iterator
+        for (NodeVector::const_iterator
             inEntry = inRow->begin();
             inEntry != inRow->end();
             inEntry++, count++
         )
         {
-            auto_ptr<MathmlNode> outEntry(
-                new MathmlNode(MathmlNode::cTypeMtd)
-            );
+            // This counts the <mtd>.
             IncrementNodeCount(nodeCount);
-        
-            auto_ptr<MathmlNode> child =
-                (*inEntry)->BuildMathmlTree(
+
+            MathmlFrame* child =
+                (*inEntry)->PrepareMathml(
                     options, MathmlEnvironment(mStyle, mColour), nodeCount
                 );
 
@@ -1153,133 +1493,122 @@ auto_ptr<MathmlNode> Table::BuildMathmlTree(
 #define MOZILLA_BUG_236963_WORKAROUND 1
 
 #if MOZILLA_BUG_236963_WORKAROUND
-            if (child->mType == MathmlNode::cTypeMrow)
-            {
-                child->mType = MathmlNode::cTypeMtd;
-                outEntry = child;
-            }
+            if (child->GetOuterType() == MathmlNode::cTypeMrow)
+                child->mElements.back().mType = MathmlNode::cTypeMtd;
             else
-                outEntry->mChildren.push_back(child.release());
+                child->Wrap(MathmlNode::cTypeMtd);
 #else
-            if (child->mType != MathmlNode::cTypeMrow)
+            if (child->GetOuterType() != MathmlNode::cTypeMrow)
             {
-                auto_ptr<MathmlNode> temp(
-                    new MathmlNode(MathmlNode::cTypeMrow)
-                );
+                child->Wrap(MathmlNode::cTypeMrow);
                 IncrementNodeCount(nodeCount);
-                temp->mChildren.push_back(child.release());
-                child = temp;
             }
-            outEntry->mChildren.push_back(child.release());
+            child->Wrap(MathmlNode::cTypeMtd);
 #endif
 
-            outRow->mChildren.push_back(outEntry.release());
+            WriteMathmlFrame(writer, options, *child, nodeCount);
         }
 
         // fill out the extra table entries:
         for (; count < tableWidth; count++)
         {
-            outRow->mChildren.push_back(
-                new MathmlNode(MathmlNode::cTypeMtd)
-            );
+            writer.StartElement(MathmlNode::cTypeMtd, noAttributes);
+            writer.EndElement(MathmlNode::cTypeMtd);
             IncrementNodeCount(nodeCount);
         }
 
-        node->mChildren.push_back(outRow.release());
+        writer.EndElement(MathmlNode::cTypeMtr);
     }
-
-    return AdjustMathmlEnvironment(
-        node, inheritedEnvironment, MathmlEnvironment(mStyle, mColour)
-    );
 }
 
 
 // This is a list of all operators that we know how to negate.
-pair<wstring, wstring> gNegationArray[] =
+static const TableEntry<const wchar_t*> gNegationArray[] =
 {
-    // Element => NotElement
-    make_pair(L"\U00002208", L"\U00002209"),
-    // Congruent => NotCongruent
-    make_pair(L"\U00002261", L"\U00002262"),
-    // Exists => NotExists
-    make_pair(L"\U00002203", L"\U00002204"),
+    // > => NotLess
+    {L"<",          L"\U0000226E"},
     // = => NotEqual
-    make_pair(L"=",          L"\U00002260"),
-    // SubsetEqual => NotSubsetEqual
-    make_pair(L"\U00002286", L"\U00002288"),
-    // Tilde => NotTilde
-    make_pair(L"\U0000223C", L"\U00002241"),
+    {L"=",          L"\U00002260"},
+    // < => NotGreater
+    {L">",          L"\U0000226F"},
     // LeftArrow => nleftarrow
-    make_pair(L"\U00002190", L"\U0000219A"),
+    {L"\U00002190", L"\U0000219A"},
     // RightArrow => nrightarrow
-    make_pair(L"\U00002192", L"\U0000219B"),
+    {L"\U00002192", L"\U0000219B"},
     // LeftRightArrow => nleftrightarrow
-    make_pair(L"\U00002194", L"\U000021AE"),
+    {L"\U00002194", L"\U000021AE"},
     // DoubleLeftArrow => nLeftArrow
-    make_pair(L"\U000021D0", L"\U000021CD"),
+    {L"\U000021D0", L"\U000021CD"},
     // DoubleRightArrow => nRightArrow
-    make_pair(L"\U000021D2", L"\U000021CF"),
+    {L"\U000021D2", L"\U000021CF"},
     // DoubleLeftRightArrow => nLeftrightArrow
-    make_pair(L"\U000021D4", L"\U000021CE"),
+    {L"\U000021D4", L"\U000021CE"},
+    // Exists => NotExists
+    {L"\U00002203", L"\U00002204"},
+    // Element => NotElement
+    {L"\U00002208", L"\U00002209"},
     // ReverseElement => NotReverseElement
-    make_pair(L"\U0000220B", L"\U0000220C"),
+    {L"\U0000220B", L"\U0000220C"},
     // FIX: what happens to the pipe character?
     // VerticalBar => NotVerticalBar
-    make_pair(L"\U00002223", L"\U00002224"),
+    {L"\U00002223", L"\U00002224"},
     // DoubleVerticalBar => NotDoubleVerticalBar
-    make_pair(L"\U00002225", L"\U00002226"),
+    {L"\U00002225", L"\U00002226"},
+    // Tilde => NotTilde
+    {L"\U0000223C", L"\U00002241"},
     // TildeEqual => NotTildeEqual
-    make_pair(L"\U00002243", L"\U00002244"),
+    {L"\U00002243", L"\U00002244"},
     // TildeFullEqual => NotTildeFullEqual
-    make_pair(L"\U00002245", L"\U00002247"),
+    {L"\U00002245", L"\U00002247"},
     // TildeTilde => NotTildeTilde
-    make_pair(L"\U00002248", L"\U00002249"),
-    // > => NotLess
-    make_pair(L"<", L"\U0000226E"),
-    // < => NotGreater
-    make_pair(L">", L"\U0000226F"),
+    {L"\U00002248", L"\U00002249"},
+    // Congruent => NotCongruent
+    {L"\U00002261", L"\U00002262"},
     // leq => NotLessEqual
-    make_pair(L"\U00002264", L"\U00002270"),
+    {L"\U00002264", L"\U00002270"},
     // GreaterEqual => NotGreaterEqual
-    make_pair(L"\U00002265", L"\U00002271"),
+    {L"\U00002265", L"\U00002271"},
     // FIX: what about "Precedes", "Succeeds"?
     // subset => nsub
-    make_pair(L"\U00002282", L"\U00002284"),
+    {L"\U00002282", L"\U00002284"},
     // Superset => nsup
-    make_pair(L"\U00002283", L"\U00002285"),
+    {L"\U00002283", L"\U00002285"},
     // SubsetEqual => NotSubsetEqual
-    make_pair(L"\U00002286", L"\U00002288"),
+    {L"\U00002286", L"\U00002288"},
     // SupersetEqual => NotSupersetEqual
-    make_pair(L"\U00002287", L"\U00002289"),
+    {L"\U00002287", L"\U00002289"},
+    // SquareSubsetEqual => NotSquareSubsetEqual
+    {L"\U00002291", L"\U000022E2"},
+    // SquareSupersetEqual => NotSquareSupersetEqual
+    {L"\U00002292", L"\U000022E3"},
     // RightTee => nvdash
-    make_pair(L"\U000022A2", L"\U000022AC"),
+    {L"\U000022A2", L"\U000022AC"},
     // DoubleRightTee => nvDash
-    make_pair(L"\U000022A8", L"\U000022AD"),
+    {L"\U000022A8", L"\U000022AD"},
     // Vdash => nVdash
-    make_pair(L"\U000022A9", L"\U000022AE"),
-    // SquareSubsetEqual => NotSquareSubsetEqual
-    make_pair(L"\U00002291", L"\U000022E2"),
-    // SquareSupersetEqual => NotSquareSupersetEqual
-    make_pair(L"\U00002292", L"\U000022E3"),
+    {L"\U000022A9", L"\U000022AE"},
     // LeftTriangle => NotLeftTriangle
-    make_pair(L"\U000022B2", L"\U000022EA"),
+    {L"\U000022B2", L"\U000022EA"},
     // RightTriangle => NotRightTriangle
-    make_pair(L"\U000022B3", L"\U000022EB"),
+    {L"\U000022B3", L"\U000022EB"},
     // LeftTriangleEqual => NotLeftTriangleEqual
-    make_pair(L"\U000022B4", L"\U000022EC"),
+    {L"\U000022B4", L"\U000022EC"},
     // RightTriangleEqual => NotRightTriangleEqual
-    make_pair(L"\U000022B5", L"\U000022ED")
+    {L"\U000022B5", L"\U000022ED"}
 };
-wishful_hash_map<wstring, wstring> gNegationTable(
-    gNegationArray,
-    END_ARRAY(gNegationArray)
-);
+
+// Stops blahtex at startup if any of the tables in this file has been
+// edited out of order.
+const bool gTablesChecked =
+    CheckTableOrder(gStretchyByDefaultArray, "gStretchyByDefaultArray") &&
+    CheckTableOrder(gAccentByDefaultArray, "gAccentByDefaultArray") &&
+    CheckTableOrder(gNegationArray, "gNegationArray");
 
 
 void Row::Optimise()
 {
-    list<Node*>::iterator lastSpace = mChildren.end();
-    list<Node*>::iterator lastNonSpace = mChildren.end();
+    NodeList::iterator lastSpace = mChildren.end();
+    NodeList::iterator lastNonSpace = mChildren.end();
     
     // Throughout this loop, we ensure that:
     // * lastNonSpace points to the most recently seen non-Space node,
@@ -1288,7 +1617,7 @@ void Row::Optimise()
     //   lastNonSpace, or just the most recently seen Space node if
     //   lastNonSpace == mChildren.end().
     
-    for (list<Node*>::iterator
+    for (NodeList::iterator
         current = mChildren.begin(); current != mChildren.end(); ++current
     )
     {
@@ -1332,16 +1661,14 @@ void Row::Optimise()
                     dynamic_cast<SymbolOperator*>(*lastNonSpace);
                 SymbolOperator* currentAsOperator =
                     dynamic_cast<SymbolOperator*>(*current);
-                wishful_hash_map<wstring, wstring>::const_iterator
-                    negationLookup;
+                const TableEntry<const wchar_t*>* negationLookup;
 
                 if (
                     lastNonSpaceAsOperator &&
                     lastNonSpaceAsOperator->mText == L"NOT" &&
                     currentAsOperator &&
                     (negationLookup =
-                        gNegationTable.find(currentAsOperator->mText))
-                    != gNegationTable.end()
+                        FindEntry(gNegationArray, currentAsOperator->mText))
                 )
                 {
                     // Replace with appropriate negated character.
@@ -1349,7 +1676,8 @@ void Row::Optimise()
                     if (lastSpace != mChildren.end())
                         mChildren.erase(lastSpace);
                     
-                    currentAsOperator->mText = negationLookup->second;
+                    currentAsOperator->mText = negationLookup->mValue;
+                    currentAsOperator->mEncodedText = NULL;
                     mChildren.erase(lastNonSpace);
                 }
                 else
@@ -1426,6 +1754,7 @@ void Row::Optimise()
                         lastNonSpaceAsSymbol->mText.swap(
                             currentCoreAsSymbol->mText
                         );
+                        currentCoreAsSymbol->mEncodedText = NULL;
                         
                         mChildren.erase(lastNonSpace);
                     }
@@ -1479,12 +1808,12 @@ void Root::Optimise()
 void Table::Optimise()
 {
     for (
-        vector<vector<Node*> >::iterator row = mRows.begin();
+        NodeRows::iterator row = mRows.begin();
         row != mRows.end();
         ++row
     )
         for (
-            vector<Node*>::iterator entry = row->begin();
+            NodeVector::iterator entry = row->begin();
             entry != row->end();
             ++entry
         )
@@ -1501,39 +1830,39 @@ wstring indent(int depth)
     return wstring(2 * depth, L' ');
 }
 
-wstring Node::PrintFields() const
+static const wchar_t* const gFlavourStrings[] =
 {
-    static wstring gFlavourStrings[] =
-    {
-        L"ord",
-        L"op",
-        L"bin",
-        L"rel",
-        L"open",
-        L"close",
-        L"punct",
-        L"inner"
-    };
+    L"ord",
+    L"op",
+    L"bin",
+    L"rel",
+    L"open",
+    L"close",
+    L"punct",
+    L"inner"
+};
 
-    static wstring gLimitsStrings[] =
-    {
-        L"displaylimits",
-        L"limits",
-        L"nolimits"
-    };
+static const wchar_t* const gLimitsStrings[] =
+{
+    L"displaylimits",
+    L"limits",
+    L"nolimits"
+};
 
-    static wstring gStyleStrings[] =
-    {
-        L"displaystyle",
-        L"textstyle",
-        L"scriptstyle",
-        L"scriptscriptstyle"
-    };
+static const wchar_t* const gStyleStrings[] =
+{
+    L"displaystyle",
+    L"textstyle",
+    L"scriptstyle",
+    L"scriptscriptstyle"
+};
 
+wstring Node::PrintFields() const
+{
     wstring output = gFlavourStrings[mFlavour];
     if (mFlavour == cFlavourOp)
-        output += L" " + gLimitsStrings[mLimits];
-    output += L" " + gStyleStrings[mStyle];
+        output += wstring(L" ") + gLimitsStrings[mLimits];
+    output += wstring(L" ") + gStyleStrings[mStyle];
     wostringstream colourHex;
     colourHex << hex << setw(6) << setfill(L'0') << mColour;
     output += L" 0x" + colourHex.str();
@@ -1543,7 +1872,7 @@ wstring Node::PrintFields() const
 void Row::Print(wostream& os, int depth) const
 {
     os << indent(depth) << L"Row " << PrintFields() << endl;
-    for (list<Node*>::const_iterator
+    for (NodeList::const_iterator
         ptr = mChildren.begin();
         ptr != mChildren.end();
         ptr++
@@ -1643,25 +1972,25 @@ void Root::Print(wostream& os, int depth) const
     mOutside->Print(os, depth+1);
 }
 
-void Table::Print(wostream& os, int depth) const
+static const wchar_t* const gAlignStrings[] =
 {
-    static wstring gAlignStrings[] =
-    {
-        L"left",
-        L"centre",
-        L"rightleft"
-    };
+    L"left",
+    L"centre",
+    L"rightleft"
+};
 
+void Table::Print(wostream& os, int depth) const
+{
     os << indent(depth) << L"Table " << PrintFields() << L" "
         << gAlignStrings[mAlign] << endl;
-    for (vector<vector<Node*> >::const_iterator
+    for (NodeRows::const_iterator
         row = mRows.begin();
         row != mRows.end();
         row++
     )
     {
         os << indent(depth+1) << L"Table row" << endl;
-        for (vector<Node*>::const_iterator
+        for (NodeVector::const_iterator
             entry = row->begin();
             entry != row->end();
             entry++
@@ -21,7 +21,10 @@
 #ifndef BLAHTEX_LAYOUTTREE_H
 #define BLAHTEX_LAYOUTTREE_H
 
+#include <list>
+#include <vector>
 #include "MathmlNode.h"
+#include "Arena.h"
 
 namespace blahtex
 {
@@ -33,14 +36,19 @@ const unsigned cMaxMathmlNodeCount = 2500;
 
 
 struct MathmlEnvironment;
+class EncodedText;
 
 // The LayoutTree namespace contains all classes that represents nodes in
 // the layout tree. The layout tree is an intermediate stage between the
 // parse tree and the final output XML tree.
 namespace LayoutTree
 {
-    // Base class for layout tree nodes.
-    struct Node
+    // The outer elements of a node's MathML; see Node::PrepareMathml().
+    struct MathmlFrame;
+
+    // Base class for layout tree nodes. Nodes are allocated from the
+    // current arena (see Arena.h).
+    struct Node : ArenaAllocated
     {
         virtual ~Node()
         { }
@@ -125,8 +133,8 @@ namespace LayoutTree
         { }
         
 
-        // This function converts the layout tree rooted at this node into
-        // a MathML tree.
+        // This function writes the MathML for the layout tree rooted at
+        // this node to "writer".
         //
         // The inheritedEnvironment parameter tells it what assumptions to
         // make about its rendering environment. It uses these to decide
@@ -135,12 +143,35 @@ namespace LayoutTree
         // The nodeCount parameter is used to keep track of the total number
         // of nodes in the MathML tree. For security reasons we put a hard
         // limit on this. (See cMaxMathmlNodeCount.)
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        void WriteMathml(
+            MathmlWriter& writer,
+            const MathmlOptions& options,
+            const MathmlEnvironment& inheritedEnvironment,
+            unsigned& nodeCount
+        ) const;
+
+        // WriteMathml() works in two steps. PrepareMathml() decides on the
+        // elements that will enclose this node's markup (e.g. an <mi> and
+        // its attributes, or an <mstyle> around an <mfrac>), and returns
+        // them as a MathmlFrame. Later, once the parent has had a chance to
+        // adjust those elements (e.g. to put "lspace" on an <mo>),
+        // WriteMathmlContent() writes whatever goes inside the innermost
+        // one. Only the frames of a node's immediate children are ever
+        // needed at once, so no complete tree gets built.
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
         ) const = 0;
 
+        virtual void WriteMathmlContent(
+            MathmlWriter& writer,
+            const MathmlOptions& options,
+            MathmlFrame& frame,
+            unsigned& nodeCount
+        ) const
+        { }
+
 
         // This function recursively prints the layout tree under this node.
         // Debugging use only.
@@ -153,13 +184,20 @@ namespace LayoutTree
     };
 
 
+    // The child containers of Row and Table. Like the nodes themselves,
+    // they are allocated from the current arena.
+    typedef std::list<Node*, ArenaAllocator<Node*> > NodeList;
+    typedef std::vector<Node*, ArenaAllocator<Node*> > NodeVector;
+    typedef std::vector<NodeVector, ArenaAllocator<NodeVector> > NodeRows;
+
+
     // A Row stores a list of children nodes. It gets translated into an
     // <mrow> node in the MathML tree.
     //
     // No Row ever has another Row node as its child.
     struct Row : Node
     {
-        std::list<Node*> mChildren;
+        NodeList mChildren;
 
         Row(Style style, RGBColour colour) :
             Node(style, cFlavourOrd, cLimitsDisplayLimits, colour)
@@ -169,12 +207,19 @@ namespace LayoutTree
 
         virtual void Optimise();
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
         ) const;
 
+        virtual void WriteMathmlContent(
+            MathmlWriter& writer,
+            const MathmlOptions& options,
+            MathmlFrame& frame,
+            unsigned& nodeCount
+        ) const;
+
         virtual void Print(
             std::wostream& os,
             int depth = 0
@@ -192,6 +237,12 @@ namespace LayoutTree
         std::wstring mText;
         MathmlFont mFont;
 
+        // For symbols that come straight from one of the built-in tables,
+        // mEncodedText holds mText already XML-encoded, so that it can be
+        // written out without going through XmlEncode() again. Otherwise
+        // (and after anything changes mText) it is NULL.
+        const EncodedText* mEncodedText;
+
         Symbol(
             const std::wstring& text,
             MathmlFont font,
@@ -202,14 +253,17 @@ namespace LayoutTree
         ) :
             Node(style, flavour, limits, colour),
             mText(text),
-            mFont(font)
+            mFont(font),
+            mEncodedText(NULL)
         { }
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        // Writes mText (using mEncodedText if possible).
+        virtual void WriteMathmlContent(
+            MathmlWriter& writer,
             const MathmlOptions& options,
-            const MathmlEnvironment& inheritedEnvironment,
+            MathmlFrame& frame,
             unsigned& nodeCount
-        ) const = 0;
+        ) const;
 
         virtual void Print(
             std::wostream& os,
@@ -232,12 +286,19 @@ namespace LayoutTree
             Symbol(text, font, style, flavour, limits, colour)
         { }
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
         ) const;
 
+        virtual void WriteMathmlContent(
+            MathmlWriter& writer,
+            const MathmlOptions& options,
+            MathmlFrame& frame,
+            unsigned& nodeCount
+        ) const;
+
         virtual void Print(
             std::wostream& os,
             int depth = 0
@@ -259,7 +320,7 @@ namespace LayoutTree
             Symbol(text, font, style, flavour, limits, colour)
         { }
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
@@ -275,7 +336,7 @@ namespace LayoutTree
     // SymbolText represents things translated as <mtext>.
     //
     // Actually, each SymbolText represents just a single character;
-    // they get merged by their parent's Row::BuildMathmlTree() function.
+    // they get merged by their parent's Row::Optimise() function.
     struct SymbolText : Symbol
     {
         SymbolText(
@@ -289,7 +350,7 @@ namespace LayoutTree
             )
         { }
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
@@ -308,7 +369,7 @@ namespace LayoutTree
         // Whether or not this operator is stretchy.
         //
         // Note: because of the existence of the MathML operator dictionary,
-        // BuildMathmlTree() needs to do a bit of work to decide whether
+        // PrepareMathml() needs to do a bit of work to decide whether
         // to actually use a "stretchy" attribute to implement this flag.
         bool mIsStretchy;
 
@@ -318,7 +379,7 @@ namespace LayoutTree
 
         // Whether to use the accent="true" attribute.
         //
-        // Again, BuildMathmlTree needs to do some work to decide if the
+        // Again, PrepareMathml needs to do some work to decide if the
         // "accent" attribute is actually needed.
         bool mIsAccent;
 
@@ -339,12 +400,19 @@ namespace LayoutTree
             mIsAccent(isAccent)
         { }
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
         ) const;
 
+        virtual void WriteMathmlContent(
+            MathmlWriter& writer,
+            const MathmlOptions& options,
+            MathmlFrame& frame,
+            unsigned& nodeCount
+        ) const;
+
         virtual void Print(
             std::wostream& os,
             int depth = 0
@@ -375,7 +443,7 @@ namespace LayoutTree
             mIsUserRequested(isUserRequested)
         { }
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
@@ -420,12 +488,19 @@ namespace LayoutTree
 
         virtual void Optimise();
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
         ) const;
 
+        virtual void WriteMathmlContent(
+            MathmlWriter& writer,
+            const MathmlOptions& options,
+            MathmlFrame& frame,
+            unsigned& nodeCount
+        ) const;
+
         virtual void Print(
             std::wostream& os,
             int depth = 0
@@ -458,12 +533,19 @@ namespace LayoutTree
 
         virtual void Optimise();
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
         ) const;
 
+        virtual void WriteMathmlContent(
+            MathmlWriter& writer,
+            const MathmlOptions& options,
+            MathmlFrame& frame,
+            unsigned& nodeCount
+        ) const;
+
         virtual void Print(
             std::wostream& os,
             int depth = 0
@@ -500,12 +582,19 @@ namespace LayoutTree
 
         virtual void Optimise();
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
         ) const;
 
+        virtual void WriteMathmlContent(
+            MathmlWriter& writer,
+            const MathmlOptions& options,
+            MathmlFrame& frame,
+            unsigned& nodeCount
+        ) const;
+
         virtual void Print(
             std::wostream& os,
             int depth = 0
@@ -530,12 +619,19 @@ namespace LayoutTree
 
         virtual void Optimise();
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
         ) const;
 
+        virtual void WriteMathmlContent(
+            MathmlWriter& writer,
+            const MathmlOptions& options,
+            MathmlFrame& frame,
+            unsigned& nodeCount
+        ) const;
+
         virtual void Print(
             std::wostream& os,
             int depth = 0
@@ -562,12 +658,19 @@ namespace LayoutTree
 
         virtual void Optimise();
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
         ) const;
 
+        virtual void WriteMathmlContent(
+            MathmlWriter& writer,
+            const MathmlOptions& options,
+            MathmlFrame& frame,
+            unsigned& nodeCount
+        ) const;
+
         virtual void Print(
             std::wostream& os,
             int depth = 0
@@ -579,7 +682,7 @@ namespace LayoutTree
     struct Table : Node
     {
         // Array of rows of table entries.
-        std::vector<std::vector<Node*> > mRows;
+        NodeRows mRows;
 
         // These values describe the possible alignment values for the
         // table. Most environments (e.g. "matrix", "pmatrix") use
@@ -618,12 +721,19 @@ namespace LayoutTree
 
         virtual void Optimise();
 
-        virtual std::auto_ptr<MathmlNode> BuildMathmlTree(
+        virtual MathmlFrame* PrepareMathml(
             const MathmlOptions& options,
             const MathmlEnvironment& inheritedEnvironment,
             unsigned& nodeCount
         ) const;
 
+        virtual void WriteMathmlContent(
+            MathmlWriter& writer,
+            const MathmlOptions& options,
+            MathmlFrame& frame,
+            unsigned& nodeCount
+        ) const;
+
         virtual void Print(
             std::wostream& os,
             int depth = 0
@@ -634,7 +744,7 @@ namespace LayoutTree
 
 
 // This struct records some information about the rendering environment for
-// a portion of the MathML tree. It is used when building the MathML tree
+// a portion of the MathML tree. It is used when generating the MathML
 // to decide when it is necessary to insert additional <mstyle> tags.
 struct MathmlEnvironment
 {
@@ -18,6 +18,7 @@
 // along with this program; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
+#include <stdexcept>
 #include "MacroProcessor.h"
 
 using namespace std;
@@ -26,7 +27,7 @@ namespace blahtex
 {
 
 // Implemented in Parser.cpp:
-extern bool IsInTokenTables(const wstring& token);
+extern bool IsInTokenTables(Token token);
 
 // If the input string ends with "Reserved", this function strips it off.
 // All other input is returned unharmed.
@@ -43,11 +44,71 @@ wstring StripReservedSuffix(const wstring& input)
         return input;
 }
 
-MacroProcessor::MacroProcessor(const vector<wstring>& input)
+MacroProcessor::MacroProcessor(
+    const vector<Token>& input,
+    const TokenTable& tokenTable,
+    const MacroTable& predefinedMacros
+) :
+    mPredefinedMacros(predefinedMacros),
+    mTokenTable(tokenTable),
+    mTokens(input.rbegin(), input.rend())
 {
-    copy(input.rbegin(), input.rend(), inserter(mTokens, mTokens.begin()));
     mCostIncurred = input.size();
     mIsTokenReady = false;
+    mHasError = false;
+}
+
+MacroProcessor::MacroTable MacroProcessor::CompileMacros(
+    const vector<Token>& definitions,
+    const TokenTable& tokenTable
+)
+{
+    MacroTable noMacros;
+    MacroProcessor processor(definitions, tokenTable, noMacros);
+
+    while (!processor.mTokens.empty())
+    {
+        Token token = processor.mTokens.back();
+        if (token == cTokenWhitespace)
+            processor.Advance();
+        else if (token == cTokenNewcommand)
+            processor.DefineMacro(true);
+        else
+            throw logic_error(
+                "Unexpected token in MacroProcessor::CompileMacros"
+            );
+    }
+
+    if (processor.mHasError)
+        throw logic_error(
+            "Invalid macro definition in MacroProcessor::CompileMacros"
+        );
+
+    return processor.mMacros;
+}
+
+const MacroProcessor::Macro* MacroProcessor::FindMacro(Token command) const
+{
+    MacroTable::const_iterator macro = mMacros.find(command);
+    if (macro != mMacros.end())
+        return &macro->second;
+
+    macro = mPredefinedMacros.find(command);
+    if (macro != mPredefinedMacros.end())
+        return &macro->second;
+
+    return NULL;
+}
+
+void MacroProcessor::Abort(const Exception& error)
+{
+    if (!mHasError)
+    {
+        mHasError = true;
+        mError = error;
+    }
+    mTokens.clear();
+    mIsTokenReady = false;
 }
 
 void MacroProcessor::Advance()
@@ -62,31 +123,31 @@ void MacroProcessor::Advance()
 
 void MacroProcessor::SkipWhitespace()
 {
-    while (Peek() == L" ")
+    while (Peek() == cTokenWhitespace)
         Advance();
 }
 
 void MacroProcessor::SkipWhitespaceRaw()
 {
-    while (!mTokens.empty() && mTokens.back() == L" ")
+    while (!mTokens.empty() && mTokens.back() == cTokenWhitespace)
         Advance();
 }
 
-bool MacroProcessor::ReadArgument(vector<wstring>& output)
+bool MacroProcessor::ReadArgument(vector<Token>& output)
 {
     SkipWhitespaceRaw();
     if (mTokens.empty())
         // Missing argument
         return false;
 
-    wstring token = mTokens.back();
+    Token token = mTokens.back();
     mTokens.pop_back();
     mCostIncurred++;
-    if (token == L"}")
+    if (token == cTokenEndGroup)
         // Argument can't start with "}"
         return false;
 
-    if (token == L"{")
+    if (token == cTokenBeginGroup)
     {
         // Keep track of brace nesting depth so we know which is the
         // matching closing brace
@@ -94,16 +155,19 @@ bool MacroProcessor::ReadArgument(vector<wstring>& output)
         while (!mTokens.empty())
         {
             mCostIncurred++;
-            wstring token = mTokens.back();
+            Token token = mTokens.back();
             mTokens.pop_back();
-            if (token == L"{")
+            if (token == cTokenBeginGroup)
                 braceDepth++;
-            else if (token == L"}" && --braceDepth == 0)
+            else if (token == cTokenEndGroup && --braceDepth == 0)
                 break;
             output.push_back(token);
         }
         if (braceDepth > 0)
-            throw Exception(L"UnmatchedOpenBrace");
+        {
+            Abort(Exception(L"UnmatchedOpenBrace"));
+            return false;
+        }
     }
     else
         output.push_back(token);
@@ -112,14 +176,19 @@ bool MacroProcessor::ReadArgument(vector<wstring>& output)
     return true;
 }
 
-wstring MacroProcessor::Get()
+Token MacroProcessor::Get()
 {
-    wstring token = Peek();
+    Token token = Peek();
     Advance();
     return token;
 }
 
 void MacroProcessor::HandleNewcommand()
+{
+    DefineMacro(false);
+}
+
+void MacroProcessor::DefineMacro(bool isPredefined)
 {
     // pop the "\newcommand" command:
     mTokens.pop_back();
@@ -127,68 +196,106 @@ void MacroProcessor::HandleNewcommand()
 
     // gobble opening brace
     SkipWhitespaceRaw();
-    if (mTokens.empty() || mTokens.back() != L"{")
-        throw Exception(L"MissingOpenBraceAfter", L"\\newcommand");
+    if (mTokens.empty() || mTokens.back() != cTokenBeginGroup)
+    {
+        Abort(Exception(L"MissingOpenBraceAfter", L"\\newcommand"));
+        return;
+    }
     mTokens.pop_back();
 
     // grab new command being defined
     SkipWhitespaceRaw();
     if (mTokens.empty() ||
-        mTokens.back().empty() ||
-        mTokens.back()[0] != L'\\'
+        mTokenTable.GetName(mTokens.back()).empty() ||
+        mTokenTable.GetName(mTokens.back())[0] != L'\\'
     )
-        throw Exception(L"MissingCommandAfterNewcommand");
-    wstring newCommand = mTokens.back();
-    if (mMacros.count(newCommand) || IsInTokenTables(newCommand))
-        throw Exception(
+    {
+        Abort(Exception(L"MissingCommandAfterNewcommand"));
+        return;
+    }
+    Token newCommand = mTokens.back();
+    if (FindMacro(newCommand) ||
+        (!isPredefined && IsInTokenTables(newCommand))
+    )
+    {
+        Abort(Exception(
             L"IllegalRedefinition",
-            StripReservedSuffix(newCommand)
-        );
+            StripReservedSuffix(mTokenTable.GetName(newCommand))
+        ));
+        return;
+    }
     mTokens.pop_back();
 
     // gobble close brace
     SkipWhitespaceRaw();
     if (mTokens.empty())
-        throw Exception(L"UnmatchedOpenBrace");
-    if (mTokens.back() != L"}")
-        throw Exception(L"MissingCommandAfterNewcommand");
+    {
+        Abort(Exception(L"UnmatchedOpenBrace"));
+        return;
+    }
+    if (mTokens.back() != cTokenEndGroup)
+    {
+        Abort(Exception(L"MissingCommandAfterNewcommand"));
+        return;
+    }
     mTokens.pop_back();
 
     Macro& macro = mMacros[newCommand];
 
     SkipWhitespaceRaw();
     // Determine the number of arguments, if specified.
-    if (!mTokens.empty() && mTokens.back() == L"[")
+    if (!mTokens.empty() && mTokens.back() == cTokenOpenBracket)
     {
         mTokens.pop_back();
 
+        const wstring& newCommandName = mTokenTable.GetName(newCommand);
         SkipWhitespaceRaw();
-        if (mTokens.empty() || mTokens.back().size() != 1)
-            throw Exception(L"MissingOrIllegalParameterCount", newCommand);
-        macro.mParameterCount = static_cast<int>(mTokens.back()[0] - L'0');
+        if (mTokens.empty() ||
+            mTokenTable.GetName(mTokens.back()).size() != 1
+        )
+        {
+            Abort(Exception(
+                L"MissingOrIllegalParameterCount", newCommandName
+            ));
+            return;
+        }
+        macro.mParameterCount = static_cast<int>(
+            mTokenTable.GetName(mTokens.back())[0] - L'0'
+        );
         if (macro.mParameterCount <= 0 || macro.mParameterCount > 9)
-            throw Exception(L"MissingOrIllegalParameterCount", newCommand);
+        {
+            Abort(Exception(
+                L"MissingOrIllegalParameterCount", newCommandName
+            ));
+            return;
+        }
         mTokens.pop_back();
 
         SkipWhitespaceRaw();
-        if (mTokens.empty() || mTokens.back() != L"]")
-            throw Exception(L"UnmatchedOpenBracket");
+        if (mTokens.empty() || mTokens.back() != cTokenCloseBracket)
+        {
+            Abort(Exception(L"UnmatchedOpenBracket"));
+            return;
+        }
         mTokens.pop_back();
     }
 
     // Read and store the tokens which make up the macro replacement.
     if (!ReadArgument(macro.mReplacement))
-        throw Exception(L"NotEnoughArguments", L"\\newcommand");
+        Abort(Exception(L"NotEnoughArguments", L"\\newcommand"));
 }
 
-wstring MacroProcessor::Peek()
+Token MacroProcessor::Peek()
 {
     while (!mTokens.empty())
     {
         // This is the only place that we check that the user hasn't
         // exceeded the token limit.
         if (mTokens.size() + (++mCostIncurred) >= cMaxParseCost)
-            throw Exception(L"TooManyTokens");
+        {
+            Abort(Exception(L"TooManyTokens"));
+            return cTokenEndOfInput;
+        }
 
         if (mIsTokenReady)
             return mTokens.back();
@@ -204,55 +311,63 @@ wstring MacroProcessor::Peek()
         //
         // We need to take into account grouping braces,
         // e.g. "\sqrt[{]}]{2}" should be valid.
-        if (mTokens.back() == L"\\sqrtReserved")
+        if (mTokens.back() == cTokenSqrtReserved)
         {
             mTokens.pop_back();
 
             SkipWhitespaceRaw();
-            if (!mTokens.empty() && mTokens.back() == L"[")
+            if (!mTokens.empty() && mTokens.back() == cTokenOpenBracket)
             {
-                mTokens.back() = L"{";
+                mTokens.back() = cTokenBeginGroup;
 
-                vector<wstring>::reverse_iterator ptr = mTokens.rbegin();
+                vector<Token>::reverse_iterator ptr = mTokens.rbegin();
                 ptr++;
 
                 int braceDepth = 0;
                 while (ptr != mTokens.rend() &&
-                    (braceDepth > 0 || *ptr != L"]")
+                    (braceDepth > 0 || *ptr != cTokenCloseBracket)
                 )
                 {
                     mCostIncurred++;
-                    if (*ptr == L"{")
+                    if (*ptr == cTokenBeginGroup)
                         braceDepth++;
-                    else if (*ptr == L"}")
+                    else if (*ptr == cTokenEndGroup)
                     {
                         if (--braceDepth < 0)
-                            throw Exception(L"UnmatchedCloseBrace");
+                        {
+                            Abort(Exception(L"UnmatchedCloseBrace"));
+                            return cTokenEndOfInput;
+                        }
                     }
                     ptr++;
                 }
                 if (ptr == mTokens.rend())
-                    throw Exception(L"UnmatchedOpenBracket");
-                if (*ptr != L"]")
-                    throw Exception(L"NotEnoughArguments", L"\\sqrt");
-                *ptr = L"}";
-                mTokens.push_back(L"\\rootReserved");
+                {
+                    Abort(Exception(L"UnmatchedOpenBracket"));
+                    return cTokenEndOfInput;
+                }
+                if (*ptr != cTokenCloseBracket)
+                {
+                    Abort(Exception(L"NotEnoughArguments", L"\\sqrt"));
+                    return cTokenEndOfInput;
+                }
+                *ptr = cTokenEndGroup;
+                mTokens.push_back(cTokenRootReserved);
                 mIsTokenReady = true;
-                return L"\\rootReserved";
+                return cTokenRootReserved;
             }
             else
             {
-                mTokens.push_back(L"\\sqrt");
+                mTokens.push_back(cTokenSqrt);
                 mIsTokenReady = true;
-                return L"\\sqrt";
+                return cTokenSqrt;
             }
         }
         else
         {
-            wstring token = mTokens.back();
-            wishful_hash_map<wstring, Macro>::const_iterator
-                macroPtr = mMacros.find(token);
-            if (macroPtr == mMacros.end())
+            Token token = mTokens.back();
+            const Macro* macroPtr = FindMacro(token);
+            if (!macroPtr)
             {
                 // In this case it's not "\sqrt" and not a macro, so
                 // we're finished here.
@@ -260,44 +375,51 @@ wstring MacroProcessor::Peek()
                 return token;
             }
 
-            const Macro& macro = macroPtr->second;
+            const Macro& macro = *macroPtr;
             mTokens.pop_back();
 
             // It's a macro. Determines the arguments to substitute in....
-            vector<vector<wstring> > arguments(macro.mParameterCount);
+            vector<vector<Token> > arguments(macro.mParameterCount);
             for (int argumentIndex = 0;
                 argumentIndex < macro.mParameterCount;
                 argumentIndex++
             )
                 if (!ReadArgument(arguments[argumentIndex]))
-                    throw Exception(
+                {
+                    Abort(Exception(
                         L"NotEnoughArguments",
-                        StripReservedSuffix(token)
-                    );
+                        StripReservedSuffix(mTokenTable.GetName(token))
+                    ));
+                    return cTokenEndOfInput;
+                }
 
             // ... and now write the replacement, substituting
             // arguments as we go.
-            const vector<wstring>& replacement = macro.mReplacement;
-            vector<wstring> output;
-            for (vector<wstring>::const_iterator
+            const vector<Token>& replacement = macro.mReplacement;
+            vector<Token> output;
+            for (vector<Token>::const_iterator
                 source = replacement.begin();
                 source != replacement.end();
                 source++
             )
             {
                 mCostIncurred++;
-                if (*source == L"#")
+                if (*source == cTokenHash)
                 {
                     if (++source == replacement.end() ||
-                        source->size() != 1
+                        mTokenTable.GetName(*source).size() != 1
                     )
-                        throw Exception(
+                    {
+                        Abort(Exception(
                             L"MissingOrIllegalParameterIndex",
-                            token
-                        );
+                            mTokenTable.GetName(token)
+                        ));
+                        return cTokenEndOfInput;
+                    }
 
-                    int parameterIndex
-                        = static_cast<int>((*source)[0] - '1');
+                    int parameterIndex = static_cast<int>(
+                        mTokenTable.GetName(*source)[0] - '1'
+                    );
 
                     // FIX: perhaps this next error should be flagged when
                     // reading the definition of the macro rather than
@@ -305,10 +427,13 @@ wstring MacroProcessor::Peek()
                     if (parameterIndex < 0 ||
                         parameterIndex >= macro.mParameterCount
                     )
-                        throw Exception(
+                    {
+                        Abort(Exception(
                             L"MissingOrIllegalParameterIndex",
-                            token
-                        );
+                            mTokenTable.GetName(token)
+                        ));
+                        return cTokenEndOfInput;
+                    }
                     copy(
                         arguments[parameterIndex].begin(),
                         arguments[parameterIndex].end(),
@@ -324,7 +449,7 @@ wstring MacroProcessor::Peek()
         }
     }
 
-    return L"";
+    return cTokenEndOfInput;
 }
 
 }
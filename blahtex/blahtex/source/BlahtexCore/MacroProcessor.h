@@ -25,6 +25,7 @@
 #include <vector>
 #include <map>
 #include "Misc.h"
+#include "TokenTable.h"
 
 namespace blahtex
 {
@@ -49,17 +50,57 @@ const unsigned cMaxParseCost = 20000;
 class MacroProcessor
 {
 public:
-    // Input is a vector of strings, one for each input token.
-    MacroProcessor(const std::vector<std::wstring>& input);
+    // Records information about a single macro.
+    struct Macro
+    {
+        // The number of parameters the macro accepts. (Blahtex doesn't
+        // handle optional arguments.)
+        int mParameterCount;
+
+        // The sequence of tokens that get substituted when this macro is
+        // expanded. Arguments are indicated as follows: first the token
+        // "#", and then the token "n", where n is a number between 1 and
+        // 9, indicating which argument to substitute.
+        std::vector<Token> mReplacement;
+
+        Macro() :
+            mParameterCount(0)
+        { }
+    };
+
+    typedef wishful_hash_map<Token, Macro> MacroTable;
+
+    // Input is a vector of tokens, all of which must be in "tokenTable".
+    // The MacroProcessor keeps a reference to the table (for looking up
+    // token names) but never adds anything to it.
+    //
+    // "predefinedMacros" are the macros in force before the input starts
+    // (see CompileMacros). They are shared, not copied; macros defined by
+    // the input are kept separately, so it is never modified. It must
+    // outlive the MacroProcessor.
+    MacroProcessor(
+        const std::vector<Token>& input,
+        const TokenTable& tokenTable,
+        const MacroTable& predefinedMacros
+    );
+
+    // Runs a sequence of "\newcommand" definitions (with nothing else
+    // between them except whitespace), and returns the resulting macros.
+    // This is used to build the standard macro tables once, during static
+    // initialisation, instead of once per input.
+    static MacroTable CompileMacros(
+        const std::vector<Token>& definitions,
+        const TokenTable& tokenTable
+    );
 
     // Returns the next token on the stack (without removing it), after
     // expanding macros.
-    // Returns empty string if there are no tokens left.
-    std::wstring Peek();
+    // Returns cTokenEndOfInput if there are no tokens left.
+    Token Peek();
 
     // Same as Peek(), but also removes the token.
-    // Returns empty string if there are no tokens left.
-    std::wstring Get();
+    // Returns cTokenEndOfInput if there are no tokens left.
+    Token Get();
 
     // Pops the current token.
     void Advance();
@@ -71,31 +112,52 @@ public:
     // stack, this function processes a subsequent macro definition.
     void HandleNewcommand();
 
-private:
+    // Errors in the input are not thrown. Instead, Abort() records the
+    // error and throws away all the remaining tokens, so that from then
+    // on Peek() and Get() just return cTokenEndOfInput, and the parser
+    // winds down as if the input had ended there. Only the first error is
+    // kept; later ones are usually just side effects of it.
+    //
+    // (Malformed input is very common, e.g. in live previews where every
+    // keystroke gets converted, and C++ exceptions are slow to unwind
+    // through the recursive descent parser.)
+    void Abort(const Exception& error);
 
-    // Records information about a single macro.
-    struct Macro
+    // True if Abort() has been called; GetError() then returns the error.
+    bool HasError() const
     {
-        // The number of parameters the macro accepts. (Blahtex doesn't
-        // handle optional arguments.)
-        int mParameterCount;
+        return mHasError;
+    }
 
-        // The sequence of tokens that get substituted when this macro is
-        // expanded. Arguments are indicated as follows: first the string
-        // "#", and then the string "n", where n is a number between 1 and
-        // 9, indicating which argument to substitute.
-        std::vector<std::wstring> mReplacement;
+    const Exception& GetError() const
+    {
+        return mError;
+    }
 
-        Macro() :
-            mParameterCount(0)
-        { }
-    };
+private:
 
-    // List of all currently recognised macros.
-    wishful_hash_map<std::wstring, Macro> mMacros;
+    // The macros defined before the input started, and those defined by
+    // the input itself. A macro can't be redefined, so no command is in
+    // both.
+    const MacroTable& mPredefinedMacros;
+    MacroTable mMacros;
+
+    // Returns the definition of the given command, or NULL if it isn't a
+    // macro.
+    const Macro* FindMacro(Token command) const;
+
+    // Does the work for HandleNewcommand. CompileMacros uses this with
+    // "isPredefined" set, which skips checking the new command against the
+    // parser's token tables: they may not have been built yet during
+    // static initialisation, and the standard macros are known not to
+    // clash with them anyway.
+    void DefineMacro(bool isPredefined);
+
+    // The table that all the tokens come from.
+    const TokenTable& mTokenTable;
 
     // The token stack; the top of the stack is mTokens.back().
-    std::vector<std::wstring> mTokens;
+    std::vector<Token> mTokens;
 
     // This flag is set if we have already ascertained that the current
     // token doesn't need to undergo macro expansion.
@@ -108,7 +170,7 @@ private:
     // argument (not including delimiting braces) is appended to "output".
     //
     // Returns true on success, or false if the argument is missing.
-    bool ReadArgument(std::vector<std::wstring>& output);
+    bool ReadArgument(std::vector<Token>& output);
 
     // Skips whitespace without expanding macros.
     void SkipWhitespaceRaw();
@@ -116,6 +178,10 @@ private:
     // Total approximate cost of parsing activity so far.
     // (See cMaxParseCost.)
     unsigned mCostIncurred;
+
+    // See Abort().
+    bool mHasError;
+    Exception mError;
 };
 
 }
@@ -21,6 +21,7 @@
 #include <sstream>
 #include <stdexcept>
 #include "Manager.h"
+#include "MathmlWriter.h"
 #include "Parser.h"
 
 using namespace std;
@@ -37,8 +38,9 @@ bool IsAlphabetic(wchar_t c)
 }
 
 
-// Tokenise() splits the given input into tokens, each represented by a
-// string. The output is APPENDED to "output".
+// Tokenise() splits the given input into tokens, interning each one in
+// "table". The output is APPENDED to "output". Returns false (storing the
+// reason in "error") if the input can't be tokenised.
 //
 // There are several types of tokens:
 // * single characters like "a", or "{", or single non-ASCII unicode
@@ -53,78 +55,101 @@ bool IsAlphabetic(wchar_t c)
 // * the sequence "\begin   {  stuff  }" gets stored as the single token
 //   "\begin{  stuff  }". Note that whitespace is preserved between the
 //   braces but not between "\begin" and "{". Similarly for "\end".
-void Tokenise(const wstring& input, vector<wstring>& output)
+bool Tokenise(
+    const wstring& input,
+    TokenTable& table,
+    vector<Token>& output,
+    Exception& error
+)
 {
-    wstring::const_iterator ptr = input.begin();
+    const wchar_t* ptr = input.data();
+    const wchar_t* end = ptr + input.size();
 
-    while (ptr != input.end())
+    while (ptr != end)
     {
         // merge adjacent whitespace
         if (iswspace(*ptr))
         {
-            output.push_back(L" ");
+            output.push_back(cTokenWhitespace);
             do
                 ptr++;
-            while (ptr != input.end() && iswspace(*ptr));
+            while (ptr != end && iswspace(*ptr));
         }
         // boring single character tokens
         else if (*ptr != L'\\')
         {
             // Disallow non-printable, non-whitespace ASCII
             if (*ptr < L' ' || *ptr == 0x7F)
-                throw Exception(L"IllegalCharacter");
-            output.push_back(wstring(1, *ptr++));
+            {
+                error = Exception(L"IllegalCharacter");
+                return false;
+            }
+            output.push_back(table.Intern(ptr++, 1));
         }
         else
         {
             // tokens starting with backslash
-            wstring token = L"\\";
+            const wchar_t* start = ptr;
 
-            if (++ptr == input.end())
-                throw Exception(L"IllegalFinalBackslash");
+            if (++ptr == end)
+            {
+                error = Exception(L"IllegalFinalBackslash");
+                return false;
+            }
             if (IsAlphabetic(*ptr))
             {
                 // plain alphabetic commands
                 do
-                    token += *ptr++;
-                while (ptr != input.end() && IsAlphabetic(*ptr));
+                    ptr++;
+                while (ptr != end && IsAlphabetic(*ptr));
+                Token token = table.Intern(start, ptr - start);
 
                 // Special treatment for "\begin" and "\end"; need to
                 // collapse "\begin  {xyz}" to "\begin{xyz}", and store it
                 // as a single token.
-                if (token == L"\\begin" || token == L"\\end")
+                if (token == cTokenBegin || token == cTokenEnd)
                 {
-                    while (ptr != input.end() && iswspace(*ptr))
+                    wstring name(start, ptr);
+                    while (ptr != end && iswspace(*ptr))
+                        ptr++;
+                    if (ptr == end || *ptr != L'{')
+                    {
+                        error = Exception(L"MissingOpenBraceAfter", name);
+                        return false;
+                    }
+                    start = ptr;
+                    while (ptr != end && *ptr != L'}')
                         ptr++;
-                    if (ptr == input.end() || *ptr != L'{')
-                        throw Exception(L"MissingOpenBraceAfter", token);
-                    token += *ptr++;
-                    while (ptr != input.end() && *ptr != L'}')
-                        token += *ptr++;
-                    if (ptr == input.end())
-                        throw Exception(L"UnmatchedOpenBrace");
-                    token += *ptr++;
+                    if (ptr == end)
+                    {
+                        error = Exception(L"UnmatchedOpenBrace");
+                        return false;
+                    }
+                    name.append(start, ++ptr);
+                    token = table.Intern(name);
                 }
+
+                output.push_back(token);
             }
             else if (iswspace(*ptr))
             {
                 // commands like "\    "
-                token += L" ";
                 do
                     ptr++;
-                while (ptr != input.end() && iswspace(*ptr));
+                while (ptr != end && iswspace(*ptr));
+                output.push_back(table.Intern(L"\\ ", 2));
             }
             // commands like "\," and "\;"
             else
-                token += *ptr++;
-
-            output.push_back(token);
+                output.push_back(table.Intern(start, (++ptr) - start));
         }
     }
+
+    return true;
 }
 
 
-wstring Manager::gTexvcCompatibilityMacros =
+const wchar_t Manager::gTexvcCompatibilityMacros[] =
 
     // First we have some macros which are not part of tex/latex/amslatex
     // but which texvc recognises, so for backward compatibility we define
@@ -212,7 +237,7 @@ wstring Manager::gTexvcCompatibilityMacros =
     L"\\newcommand{\\part}{\\partial}"
 ;
 
-wstring Manager::gStandardMacros =
+const wchar_t Manager::gStandardMacros[] =
 
     // The next group are standard TeX/LaTeX/AMS-LaTeX synonyms.
     L"\\newcommand{\\|}{\\Vert}"
@@ -290,70 +315,148 @@ wstring Manager::gStandardMacros =
     L"\\newcommand{\\cyrReserved}     [1]{{\\cyr{#1}}}"
 ;
 
-vector<wstring> Manager::gStandardMacrosTokenised;
-vector<wstring> Manager::gTexvcCompatibilityMacrosTokenised;
+// Tokenises a block of macro definitions (the tokens go straight into the
+// global token table) and returns the macros it defines.
+MacroProcessor::MacroTable CompileMacros(const wstring& macros)
+{
+    vector<Token> tokens;
+    Exception error;
+    if (!Tokenise(macros, GetGlobalTokenTable(), tokens, error))
+        throw logic_error("Invalid macro definitions in CompileMacros");
+    return MacroProcessor::CompileMacros(tokens, GetGlobalTokenTable());
+}
+
+// Since a macro can't be redefined, compiling the texvc macros on their
+// own and adding the standard ones gives the same table as compiling
+// gTexvcCompatibilityMacros followed by gStandardMacros, without
+// tokenising and parsing the standard macros a second time.
+MacroProcessor::MacroTable CompileTexvcCompatibilityMacros(
+    const wstring& texvcMacros,
+    const MacroProcessor::MacroTable& standardMacros
+)
+{
+    MacroProcessor::MacroTable output = CompileMacros(texvcMacros);
+    size_t texvcCount = output.size();
+    output.insert(standardMacros.begin(), standardMacros.end());
+    if (output.size() != texvcCount + standardMacros.size())
+        throw logic_error(
+            "Texvc macro redefines a standard macro in "
+            "CompileTexvcCompatibilityMacros"
+        );
+    return output;
+}
+
+// These are computed during static initialisation (gStandardMacroTable is
+// defined first, so it is ready when the texvc table needs it), and never
+// modified afterwards. This means that any number of Managers can share
+// them on different threads.
+const MacroProcessor::MacroTable Manager::gStandardMacroTable =
+    CompileMacros(gStandardMacros);
+const MacroProcessor::MacroTable Manager::gTexvcCompatibilityMacroTable =
+    CompileTexvcCompatibilityMacros(
+        gTexvcCompatibilityMacros,
+        gStandardMacroTable
+    );
 
 Manager::Manager()
 {
     if (sizeof(RGBColour) != 4)
         throw runtime_error("The \"unsigned\" type is not 4 bytes wide!");
 
-    // Tokenise the standard macros if it hasn't been done already.
-
-    if (gTexvcCompatibilityMacrosTokenised.empty())
-        Tokenise(
-            gTexvcCompatibilityMacros,
-            gTexvcCompatibilityMacrosTokenised
-        );
+    mStrictSpacingRequested = false;
+    mIsLayoutTreeBuilt = false;
+}
 
-    if (gStandardMacrosTokenised.empty())
-        Tokenise(gStandardMacros, gStandardMacrosTokenised);
+// Here are all the commands which get "Reserved" tacked on the end
+// before the MacroProcessor sees them:
+static const wchar_t* const gReservedCommandArray[] =
+{
+    L"\\sqrt",
+    L"\\mbox",
+    L"\\text",
+    L"\\textit",
+    L"\\textrm",
+    L"\\textbf",
+    L"\\textsf",
+    L"\\texttt",
+    L"\\jap",
+    L"\\cyr",
+    L"\\emph",
+    L"\\frac",
+    L"\\mathrm",
+    L"\\mathbf",
+    L"\\mathbb",
+    L"\\mathit",
+    L"\\mathcal",
+    L"\\mathfrak",
+    L"\\mathtt",
+    L"\\mathsf",
+    L"\\big",
+    L"\\bigg",
+    L"\\Big",
+    L"\\Bigg",
+    L"\\overset",
+    L"\\underset",
+    L"\\substack"
+};
+
+// Returns a vector indexed by token (in the global token table) giving the
+// token for "\xyzReserved" for each command "\xyz" in
+// gReservedCommandArray, or cTokenEndOfInput for any other token.
+static vector<Token> BuildReservedTokens()
+{
+    TokenTable& tokenTable = GetGlobalTokenTable();
+    vector<pair<Token, Token> > pairs;
+    for (const wchar_t* const* ptr = gReservedCommandArray;
+        ptr != END_ARRAY(gReservedCommandArray);
+        ptr++
+    )
+    {
+        wstring command = *ptr;
+        pairs.push_back(make_pair(
+            tokenTable.Intern(command),
+            tokenTable.Intern(command + L"Reserved")
+        ));
+    }
 
-    mStrictSpacingRequested = false;
+    vector<Token> output(tokenTable.Size(), cTokenEndOfInput);
+    for (size_t index = 0; index < pairs.size(); index++)
+        output[pairs[index].first] = pairs[index].second;
+    return output;
 }
 
+static const vector<Token> gReservedTokens = BuildReservedTokens();
+
 void Manager::ProcessInput(const wstring& input, bool texvcCompatibility)
 {
-    // Here are all the commands which get "Reserved" tacked on the end
-    // before the MacroProcessor sees them:
+    Exception error;
+    if (!TryProcessInput(input, texvcCompatibility, error))
+        throw error;
+}
 
-    static wstring reservedCommandArray[] =
-    {
-        L"\\sqrt",
-        L"\\mbox",
-        L"\\text",
-        L"\\textit",
-        L"\\textrm",
-        L"\\textbf",
-        L"\\textsf",
-        L"\\texttt",
-        L"\\jap",
-        L"\\cyr",
-        L"\\emph",
-        L"\\frac",
-        L"\\mathrm",
-        L"\\mathbf",
-        L"\\mathbb",
-        L"\\mathit",
-        L"\\mathcal",
-        L"\\mathfrak",
-        L"\\mathtt",
-        L"\\mathsf",
-        L"\\big",
-        L"\\bigg",
-        L"\\Big",
-        L"\\Bigg",
-        L"\\overset",
-        L"\\underset",
-        L"\\substack"
-    };
-    static wishful_hash_set<wstring> reservedCommandTable(
-        reservedCommandArray,
-        END_ARRAY(reservedCommandArray)
-    );
+bool Manager::TryProcessInput(
+    const wstring& input,
+    bool texvcCompatibility,
+    Exception& error
+)
+{
+    // Throw away the trees from any previous input, and recycle the memory
+    // they used for the new ones.
+    mParseTree.reset(NULL);
+    mLayoutTree.reset(NULL);
+    mIsLayoutTreeBuilt = false;
+    mHasDelayedMathmlError = false;
+    mArena.Reset();
+    ArenaScope arenaScope(mArena);
+
+    // Any tokens in the input that aren't in the global table (e.g.
+    // unknown commands or non-ASCII characters) are kept in this table,
+    // which only lives as long as this call.
+    TokenTable tokenTable(&GetGlobalTokenTable());
 
-    vector<wstring> inputTokens;
-    Tokenise(input, inputTokens);
+    vector<Token> tokens;
+    if (!Tokenise(input, tokenTable, tokens, error))
+        return false;
 
     mStrictSpacingRequested = false;
 
@@ -362,47 +465,78 @@ void Manager::ProcessInput(const wstring& input, bool texvcCompatibility)
     //
     // Also search for magic commands (currently the only magic command is
     // "\strictspacing")
-    for (vector<wstring>::iterator
-        ptr = inputTokens.begin();
-        ptr != inputTokens.end();
+    for (vector<Token>::iterator
+        ptr = tokens.begin();
+        ptr != tokens.end();
         ptr++
     )
     {
-        if (reservedCommandTable.count(*ptr))
-            *ptr += L"Reserved";
-
-        else if (
-            ptr->size() >= 8 &&
-            ptr->substr(ptr->size() - 8, 8) == L"Reserved"
+        if (*ptr < gReservedTokens.size() &&
+            gReservedTokens[*ptr] != cTokenEndOfInput
         )
-            throw Exception(L"ReservedCommand", *ptr);
+            *ptr = gReservedTokens[*ptr];
+
+        else if (tokenTable.HasReservedSuffix(*ptr))
+        {
+            error = Exception(L"ReservedCommand", tokenTable.GetName(*ptr));
+            return false;
+        }
 
-        else if (*ptr == L"\\strictspacing")
+        else if (*ptr == cTokenStrictspacing)
         {
             mStrictSpacingRequested = true;
-            *ptr = L" ";
+            *ptr = cTokenWhitespace;
         }
     }
 
-    vector<wstring> tokens;
+    // Generate the parse tree, starting off with the standard (and
+    // texvc-compatibility, where appropriate) macros.
+    Parser P;
+    mParseTree = P.DoParse(
+        tokens,
+        tokenTable,
+        texvcCompatibility
+            ? gTexvcCompatibilityMacroTable : gStandardMacroTable,
+        error
+    );
+    if (!mParseTree.get())
+        return false;
+
+    // The layout tree normally waits until someone asks for MathML. But a
+    // misplaced "\limits" is an input syntax error that only shows up
+    // while building the layout tree, so if there are any of those
+    // commands we build it straight away, to report it from here. (This
+    // one is still thrown from deep inside the tree; it's rare enough not
+    // to matter.)
+    if (P.HasLimitsCommands())
+    {
+        try
+        {
+            BuildLayoutTree();
+        }
+        catch (Exception& e)
+        {
+            mParseTree.reset(NULL);
+            error = e;
+            return false;
+        }
+    }
 
-    // Append the texvc-compatibility and standard macros where appropriate.
+    return true;
+}
 
-    if (texvcCompatibility)
-        tokens = gTexvcCompatibilityMacrosTokenised;
 
-    copy(
-        gStandardMacrosTokenised.begin(),
-        gStandardMacrosTokenised.end(),
-        back_inserter(tokens)
-    );
-    copy(inputTokens.begin(), inputTokens.end(), back_inserter(tokens));
+void Manager::BuildLayoutTree() const
+{
+    if (mIsLayoutTreeBuilt)
+        return;
 
-    // Generate the parse tree and the layout tree.
-    Parser P;
-    mParseTree = P.DoParse(tokens);
-    mHasDelayedMathmlError = false;
-    
+    if (!mParseTree.get())
+        throw logic_error(
+            "Parse tree not yet built in Manager::BuildLayoutTree"
+        );
+
+    ArenaScope arenaScope(mArena);
     try
     {
         TexProcessingState topState;
@@ -424,19 +558,40 @@ void Manager::ProcessInput(const wstring& input, bool texvcCompatibility)
         else
             throw e;
     }
+    mIsLayoutTreeBuilt = true;
 }
 
 
-auto_ptr<MathmlNode> Manager::GenerateMathml(
-    const MathmlOptions& options
-) const
+void Manager::CheckLayoutTree() const
 {
+    BuildLayoutTree();
     if (mHasDelayedMathmlError)
         throw mDelayedMathmlError;
+}
+
+
+bool Manager::TryCheckLayoutTree(Exception& error) const
+{
+    BuildLayoutTree();
+    if (mHasDelayedMathmlError)
+    {
+        error = mDelayedMathmlError;
+        return false;
+    }
+    return true;
+}
+
+
+void Manager::WriteMathml(
+    MathmlWriter& writer,
+    const MathmlOptions& options
+) const
+{
+    CheckLayoutTree();
     
     if (!mLayoutTree.get())
         throw logic_error(
-            "Layout tree not yet built in Manager::GenerateMathml"
+            "Layout tree not yet built in Manager::WriteMathml"
         );
 
     MathmlOptions optionsCopy = options;
@@ -445,16 +600,40 @@ auto_ptr<MathmlNode> Manager::GenerateMathml(
         // command appeared somewhere in the input.
         optionsCopy.mSpacingControl = MathmlOptions::cSpacingControlStrict;
 
-    // Build the MathML tree. The nodeCount variables counts the number
+    // Generate the MathML. The nodeCount variables counts the number
     // of nodes being generated; if too many appear, an exception is thrown.
+    ArenaScope arenaScope(mArena);
     unsigned nodeCount = 0;
-    auto_ptr<MathmlNode> root = mLayoutTree->BuildMathmlTree(
+    mLayoutTree->WriteMathml(
+        writer,
         optionsCopy,
         MathmlEnvironment(LayoutTree::Node::cStyleText, RGBColour(0)),
         nodeCount
     );
+}
+
+
+auto_ptr<MathmlNode> Manager::GenerateMathml(
+    const MathmlOptions& options
+) const
+{
+    MathmlTreeBuilder builder;
+    WriteMathml(builder, options);
+    return builder.GetRoot();
+}
+
+
+wstring Manager::GetCanonicalForm() const
+{
+    if (!mParseTree.get())
+        throw logic_error(
+            "Parse tree not yet built in Manager::GetCanonicalForm"
+        );
 
-    return root;
+    wstring output;
+    output += mStrictSpacingRequested ? L'!' : L'.';
+    mParseTree->AppendCanonical(output);
+    return output;
 }
 
 
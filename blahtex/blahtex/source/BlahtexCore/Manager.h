@@ -29,6 +29,9 @@
 #include "MathmlNode.h"
 #include "LayoutTree.h"
 #include "ParseTree.h"
+#include "MacroProcessor.h"
+#include "TokenTable.h"
+#include "Arena.h"
 
 namespace blahtex
 {
@@ -48,11 +51,14 @@ class Manager
 public:
     Manager();
 
-    // ProcessInput generates a parse tree and a layout tree from the
-    // supplied input.
+    // ProcessInput generates a parse tree from the supplied input. The
+    // layout tree is only built once something needs it (WriteMathml,
+    // GenerateMathml or GetLayoutTree), so that a caller who only wants
+    // purified TeX never pays for it; this doesn't change which errors
+    // get reported where.
     //
-    // If texvcCompatibility is set, then ProcessInput will append a series
-    // of macros to emulate various non-standard commands that texvc
+    // If texvcCompatibility is set, then ProcessInput will also define a
+    // series of macros to emulate various non-standard commands that texvc
     // recognises (see gTexvcCompatibilityMacros). This corresponds to the
     // command line option "--texvc-compatible-commands".
     void ProcessInput(
@@ -60,8 +66,38 @@ public:
         bool texvcCompatibility = false
     );
 
+    // TryProcessInput is the same as ProcessInput, except that if the
+    // input is invalid, it returns false and stores the error in "error",
+    // instead of throwing it. Since syntax errors are reported from deep
+    // inside the parser's recursion, this is much faster for invalid input
+    // than catching the exception from ProcessInput (which is just a
+    // wrapper around this).
+    bool TryProcessInput(
+        const std::wstring& input,
+        bool texvcCompatibility,
+        Exception& error
+    );
+
+    // CheckLayoutTree builds the layout tree (if that hasn't happened
+    // yet), and throws any error that turned up while doing so, i.e. an
+    // error that would otherwise only be reported by WriteMathml.
+    void CheckLayoutTree() const;
+
+    // Same as CheckLayoutTree, but returns false and stores the error in
+    // "error" instead of throwing it.
+    bool TryCheckLayoutTree(Exception& error) const;
+
+    // WriteMathml sends the MathML markup to "writer" (see
+    // MathmlWriter.h), without building a tree.
+    void WriteMathml(
+        MathmlWriter& writer,
+        const MathmlOptions& options
+    ) const;
+
     // GenerateMathml generates a XML tree containing MathML markup.
-    // Returns the root node.
+    // Returns the root node. The tree lives in this Manager's arena, so it
+    // must be destroyed before the next call to ProcessInput (or before
+    // the Manager itself is destroyed).
     std::auto_ptr<MathmlNode> GenerateMathml(
         const MathmlOptions& options
     ) const;
@@ -73,6 +109,22 @@ public:
         const PurifiedTexOptions& options
     ) const;
 
+    // GetCanonicalForm returns a serialisation of everything about the
+    // current input that the output depends on: the parse tree (after
+    // macro expansion, and without whitespace, comments or the braces
+    // around single token arguments), and whether "\strictspacing" was
+    // used. Two inputs with the same canonical form give the same MathML,
+    // purified TeX and errors for the same options. For example "x+y",
+    // "x + y" and "\newcommand{\a}{x}\a+y" share one, but "{x}+y" has its
+    // own, since a group can change the spacing (as in "a{+}b").
+    //
+    // The canonical form of a given input only changes between releases
+    // if cCanonicalFormVersion does; so does the output generated for a
+    // given canonical form. Either kind of change must bump it.
+    std::wstring GetCanonicalForm() const;
+
+    static const int cCanonicalFormVersion = 1;
+
     // A few accessor functions.
     const ParseTree::MathNode* GetParseTree() const
     {
@@ -81,13 +133,30 @@ public:
 
     const LayoutTree::Node* GetLayoutTree() const
     {
+        BuildLayoutTree();
         return mLayoutTree.get();
     }
 
 private:
-    // These store the parse tree and layout tree generated by ProcessInput.
+    // All three trees are allocated from mArena, which ProcessInput resets
+    // for each new input. (It's declared before the trees so that it's
+    // destroyed after them.)
+    mutable Arena mArena;
+
+    // These store the parse tree generated by ProcessInput, and the
+    // layout tree generated from it by BuildLayoutTree. They are mutable
+    // (as is everything else BuildLayoutTree sets) since the layout tree
+    // is built on demand, from inside const member functions.
     std::auto_ptr<ParseTree::MathNode> mParseTree;
-    std::auto_ptr<LayoutTree::Node> mLayoutTree;
+    mutable std::auto_ptr<LayoutTree::Node> mLayoutTree;
+
+    // True once BuildLayoutTree has run for the current input (even if
+    // it only produced mDelayedMathmlError).
+    mutable bool mIsLayoutTreeBuilt;
+
+    // Builds and optimises mLayoutTree from mParseTree, unless that has
+    // already been done for the current input.
+    void BuildLayoutTree() const;
 
     // This flag is set if the user has requested "strict spacing" rules
     // (see SpacingControl) via the magic "\strictspacing" command.
@@ -100,24 +169,27 @@ private:
     // someone tries to GenerateMathml().
     // FIX: this is a bit hacky and badly designed.
     // Come back and fix it up one day.
-    bool mHasDelayedMathmlError;
-    Exception mDelayedMathmlError;
+    mutable bool mHasDelayedMathmlError;
+    mutable Exception mDelayedMathmlError;
 
     // gStandardMacros is a string which, in effect, gets inserted at the
     // beginning of any input string handled by ProcessInput. It contains
     // a sequence of macro definitions ("\newcommand"s) which set up some
     // standard TeX synonyms.
-    static std::wstring gStandardMacros;
+    static const wchar_t gStandardMacros[];
 
     // gTexvcCompatibilityMacros is similar; it contains definitions for
     // commands recognised by texvc but that are not standard TeX/LaTeX/
     // AMS-LaTeX. (See also the texvcCompatibility flag.)
-    static std::wstring gTexvcCompatibilityMacros;
-
-    // Tokenised version of gStandardMacros and gTexvcCompatibilityMacros
-    // (computed only once, when first used):
-    static std::vector<std::wstring> gStandardMacrosTokenised;
-    static std::vector<std::wstring> gTexvcCompatibilityMacrosTokenised;
+    static const wchar_t gTexvcCompatibilityMacros[];
+
+    // The macros defined by gStandardMacros, and by
+    // gTexvcCompatibilityMacros followed by gStandardMacros. They are
+    // compiled once, during static initialisation, and every input starts
+    // off with one of them already in force; see
+    // MacroProcessor::CompileMacros.
+    static const MacroProcessor::MacroTable gStandardMacroTable;
+    static const MacroProcessor::MacroTable gTexvcCompatibilityMacroTable;
 };
 
 }
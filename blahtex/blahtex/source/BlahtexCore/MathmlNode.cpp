@@ -18,11 +18,11 @@
 // along with this program; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <cwchar>
 #include <stdexcept>
 #include "MathmlNode.h"
-#include "XmlEncode.h"
+#include "MathmlWriter.h"
 
 using namespace std;
 
@@ -30,7 +30,7 @@ namespace blahtex
 {
 
 // Strings for each MathML "mathvariant" value.
-wstring gMathmlFontStrings[] =
+const wchar_t* const gMathmlFontStrings[] =
 {
     L"normal",
     L"bold",
@@ -49,16 +49,174 @@ wstring gMathmlFontStrings[] =
 };
 
 
+// Attribute values that turn up often enough to be worth sharing, sorted
+// by wcscmp. This includes the common TeX spaces in ems (see
+// Space::PrepareMathml), which are otherwise computed afresh each time,
+// and the \big etc delimiter sizes.
+static const wchar_t* const gCommonAttributeValues[] =
+{
+    L"-0.167em",
+    L"0",
+    L"0.1em",
+    L"0.167em",
+    L"0.222em",
+    L"0.278em",
+    L"0.2em",
+    L"0.3ex",
+    L"1",
+    L"1.000em",
+    L"1.2em",
+    L"1.8em",
+    L"2",
+    L"2.000em",
+    L"2.4em",
+    L"3em",
+    L"bold",
+    L"false",
+    L"italic",
+    L"left",
+    L"monospace",
+    L"normal",
+    L"sans-serif",
+    L"true"
+};
+
+// Returns a pointer to a copy of "value" which lasts as long as the node
+// being built: either the shared copy from gCommonAttributeValues, or a
+// fresh copy in the current arena.
+static const wchar_t* InternAttributeValue(const wstring& value)
+{
+    const wchar_t* const* begin = gCommonAttributeValues;
+    const wchar_t* const* end = END_ARRAY(gCommonAttributeValues);
+    while (begin < end)
+    {
+        const wchar_t* const* middle = begin + (end - begin) / 2;
+        int comparison = CompareTableName(*middle, value);
+        if (comparison == 0)
+            return *middle;
+        if (comparison < 0)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+
+    wchar_t* copy = static_cast<wchar_t*>(
+        AllocateFromCurrentArena((value.size() + 1) * sizeof(wchar_t))
+    );
+    wmemcpy(copy, value.c_str(), value.size() + 1);
+    return copy;
+}
+
+// Returns the number of bits set in "mask".
+inline int CountBits(unsigned mask)
+{
+    int count = 0;
+    for (; mask; mask &= mask - 1)
+        count++;
+    return count;
+}
+
+
+MathmlNode::AttributeSet::AttributeSet(const AttributeSet& other) :
+    mOverflowValues(NULL)
+{
+    *this = other;
+}
+
+MathmlNode::AttributeSet& MathmlNode::AttributeSet::operator=(
+    const AttributeSet& other
+)
+{
+    if (this == &other)
+        return *this;
+
+    // Each set needs its own overflow block, since Set() modifies it in
+    // place.
+    int count = CountBits(other.mMask);
+    if (count > cInlineCount)
+    {
+        if (!mOverflowValues)
+            mOverflowValues = static_cast<const wchar_t**>(
+                AllocateFromCurrentArena(cAttributeCount * sizeof(wchar_t*))
+            );
+        copy(
+            other.mOverflowValues,
+            other.mOverflowValues + count,
+            mOverflowValues
+        );
+    }
+    else
+    {
+        mOverflowValues = NULL;
+        const wchar_t* const* values = other.GetValues();
+        copy(values, values + count, mInlineValues);
+    }
+    mMask = other.mMask;
+    return *this;
+}
+
+void MathmlNode::AttributeSet::Set(Attribute attribute, const wchar_t* value)
+{
+    if (attribute < 0 || attribute >= cAttributeCount)
+        throw logic_error(
+            "Illegal attribute in MathmlNode::AttributeSet::Set"
+        );
+
+    unsigned bit = 1u << attribute;
+    int index = CountBits(mMask & (bit - 1));
+
+    if (mMask & bit)
+    {
+        (mOverflowValues ? mOverflowValues : mInlineValues)[index] = value;
+        return;
+    }
+
+    int count = CountBits(mMask);
+    if (!mOverflowValues && count == cInlineCount)
+    {
+        mOverflowValues = static_cast<const wchar_t**>(
+            AllocateFromCurrentArena(cAttributeCount * sizeof(wchar_t*))
+        );
+        copy(mInlineValues, mInlineValues + count, mOverflowValues);
+    }
+
+    const wchar_t** values =
+        mOverflowValues ? mOverflowValues : mInlineValues;
+    copy_backward(values + index, values + count, values + count + 1);
+    values[index] = value;
+    mMask |= bit;
+}
+
+void MathmlNode::AttributeSet::Set(
+    Attribute attribute,
+    const wstring& value
+)
+{
+    Set(attribute, InternAttributeValue(value));
+}
+
+const wchar_t* MathmlNode::AttributeSet::Get(Attribute attribute) const
+{
+    unsigned bit = 1u << attribute;
+    if (!(mMask & bit))
+        return NULL;
+    return GetValues()[CountBits(mMask & (bit - 1))];
+}
+
+
 MathmlNode::~MathmlNode()
 {
-    for (list<MathmlNode*>::iterator
+    for (MathmlNode::ChildList::iterator
         p = mChildren.begin(); p != mChildren.end(); p++
     )
         delete *p;
 }
 
 
-void MathmlNode::AddFontAttributes(
+void AddFontAttributes(
+    MathmlNode::AttributeSet& attributes,
+    MathmlNode::Type type,
+    const wstring& text,
     MathmlFont desiredFont,
     const MathmlOptions& options
 )
@@ -82,23 +240,24 @@ void MathmlNode::AddFontAttributes(
             // mention something.) Therefore we can't access them with
             // version 1 font attributes, so let's just map it to bold
             // instead.
-            if (mType == cTypeMn &&
+            if (type == MathmlNode::cTypeMn &&
                 (
                     desiredFont == cMathmlFontFraktur ||
                     desiredFont == cMathmlFontBoldFraktur
                 )
             )
-                mAttributes[cAttributeFontweight] = L"bold";
+                attributes.Set(MathmlNode::cAttributeFontweight, L"bold");
             else
                 throw logic_error(
                     "Unexpected font/symbol combination "
-                    "in MathmlNode::AddFontAttributes"
+                    "in AddFontAttributes"
                 );
         }
         else
         {
             
-            bool defaultItalic = (mType == cTypeMi && mText.size() == 1);
+            bool defaultItalic =
+                (type == MathmlNode::cTypeMi && text.size() == 1);
 
             bool desiredItalic = (
                 desiredFont == cMathmlFontItalic ||
@@ -108,8 +267,10 @@ void MathmlNode::AddFontAttributes(
             );
             
             if (defaultItalic != desiredItalic)
-                mAttributes[cAttributeFontstyle] =
-                    desiredItalic ? L"italic" : L"normal";
+                attributes.Set(
+                    MathmlNode::cAttributeFontstyle,
+                    desiredItalic ? L"italic" : L"normal"
+                );
             
             if (
                 desiredFont == cMathmlFontBold ||
@@ -117,7 +278,7 @@ void MathmlNode::AddFontAttributes(
                 desiredFont == cMathmlFontBoldSansSerif ||
                 desiredFont == cMathmlFontSansSerifBoldItalic
             )
-                mAttributes[cAttributeFontweight] = L"bold";
+                attributes.Set(MathmlNode::cAttributeFontweight, L"bold");
 
             if (
                 desiredFont == cMathmlFontSansSerif ||
@@ -125,10 +286,14 @@ void MathmlNode::AddFontAttributes(
                 desiredFont == cMathmlFontSansSerifItalic ||
                 desiredFont == cMathmlFontSansSerifBoldItalic
             )
-                mAttributes[cAttributeFontfamily] = L"sans-serif";
+                attributes.Set(
+                    MathmlNode::cAttributeFontfamily, L"sans-serif"
+                );
 
             else if (desiredFont == cMathmlFontMonospace)
-                mAttributes[cAttributeFontfamily] = L"monospace";
+                attributes.Set(
+                    MathmlNode::cAttributeFontfamily, L"monospace"
+                );
         }
     }
     else
@@ -136,99 +301,29 @@ void MathmlNode::AddFontAttributes(
         // MathML version 2.0 fonts requested.
         
         MathmlFont defaultFont =
-            (mType == cTypeMi && mText.size() == 1)
+            (type == MathmlNode::cTypeMi && text.size() == 1)
             ? cMathmlFontItalic : cMathmlFontNormal;
         
         if (desiredFont != defaultFont)
-            mAttributes[cAttributeMathvariant] =
-                gMathmlFontStrings[desiredFont];
+            attributes.Set(
+                MathmlNode::cAttributeMathvariant,
+                gMathmlFontStrings[desiredFont]
+            );
     }
 }
 
 
-void WriteIndent(
-    wostream& os,
-    int depth
-)
-{
-    for (int i = 0; i < depth; i++)
-        os << L"  ";
-}
-
-void MathmlNode::PrintType(wostream& os) const
+void MathmlNode::Write(MathmlWriter& writer) const
 {
-    static wstring gTypeArray[] =
-    {
-        L"mi",
-        L"mo",
-        L"mn",
-        L"mspace",
-        L"mtext",
-        L"mrow",
-        L"mstyle",
-        L"msub",
-        L"msup",
-        L"msubsup",
-        L"munder",
-        L"mover",
-        L"munderover",
-        L"mfrac",
-        L"msqrt",
-        L"mroot",
-        L"mtable",
-        L"mtr",
-        L"mtd",
-        L"mpadded"
-    };
-    
-    if (mType < 0 || mType >= sizeof(gTypeArray))
-        throw logic_error("Illegal node type in MathmlNode::PrintType");
-    
-    os << gTypeArray[mType];
-}
-
-void MathmlNode::PrintAttributes(wostream& os) const
-{
-    static wstring gAttributeArray[] =
-    {
-        L"displaystyle",
-        L"scriptlevel",
-        L"mathvariant",
-        L"mathcolor",
-        L"lspace",
-        L"rspace",
-        L"width",
-        L"stretchy",
-        L"minsize",
-        L"maxsize",
-        L"accent",
-        L"movablelimits",
-        L"linethickness",
-        L"columnalign",
-        L"columnspacing",
-        L"rowspacing",
-        L"fontfamily",
-        L"fontstyle",
-        L"fontweight"
-    };
-    
-    for (map<Attribute, wstring>::const_iterator
-        attribute = mAttributes.begin();
-        attribute != mAttributes.end();
-        attribute++
+    writer.StartElement(mType, mAttributes);
+    writer.Text(mText);
+    for (ChildList::const_iterator
+        child = mChildren.begin();
+        child != mChildren.end();
+        child++
     )
-    {
-        if (
-            attribute->first < 0 ||
-            attribute->first >= sizeof(gAttributeArray)
-        )
-            throw logic_error(
-                "Illegal attribute in MathmlNode::PrintAttributes"
-            );
-
-        os << L" " << gAttributeArray[attribute->first] << L"=\""
-            << attribute->second << L"\"";
-    }
+        (*child)->Write(writer);
+    writer.EndElement(mType);
 }
 
 void MathmlNode::Print(
@@ -238,44 +333,21 @@ void MathmlNode::Print(
     int depth
 ) const
 {
-    if (indent)
-        WriteIndent(os, depth);
-    
-    os << L"<";
-    PrintType(os);
-    PrintAttributes(os);
-    if (mText.empty() && mChildren.empty())
-        os << L"/>";
-    else
-    {
-        if (!mText.empty())
-        {
-            // is a leaf node with text
-            os << L">" << XmlEncode(mText, options);
-        }
-        else
-        {
-            // is a internal node with at least one child
-            os << L">";
-            if (indent)
-                os << endl;
-            
-            for (list<MathmlNode*>::const_iterator
-                child = mChildren.begin(); child != mChildren.end(); child++
-            )
-                (*child)->Print(os, options, indent, depth + 1);
-
-            if (indent)
-                WriteIndent(os, depth);
-        }
+    wstring output;
+    MathmlPrinter<wstring> printer(output, options, indent, depth);
+    Write(printer);
+    os << output;
+}
 
-        os << L"</";
-        PrintType(os);
-        os << L">";
-    }
-    
-    if (indent)
-        os << endl;
+void MathmlNode::Print(
+    string& output,
+    const EncodingOptions& options,
+    bool indent,
+    int depth
+) const
+{
+    MathmlPrinter<string> printer(output, options, indent, depth);
+    Write(printer);
 }
 
 }
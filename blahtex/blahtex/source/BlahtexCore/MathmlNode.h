@@ -23,9 +23,9 @@
 
 #include <string>
 #include <iostream>
-#include <map>
-#include <list>
+#include <vector>
 #include "Misc.h"
+#include "Arena.h"
 
 namespace blahtex
 {
@@ -53,11 +53,18 @@ enum MathmlFont
 
 // String versions of the MathML mathvariant fonts.
 // (See enum MathmlFont in LayoutTree.h.)
-extern std::wstring gMathmlFontStrings[];
+extern const wchar_t* const gMathmlFontStrings[];
 
+class MathmlWriter;
 
-// Represents a node in an MathML tree.
-struct MathmlNode
+
+// Represents a node in an MathML tree. Nodes, and their child lists, are
+// allocated from the current arena (see Arena.h).
+//
+// The layout tree normally writes its MathML straight to a MathmlWriter
+// (see MathmlWriter.h) without building any MathmlNodes; a tree is only
+// built for callers that ask for one (see Manager::GenerateMathml).
+struct MathmlNode : ArenaAllocated
 {
     enum Type
     {
@@ -107,17 +114,88 @@ struct MathmlNode
         cAttributeRowspacing,
         cAttributeFontfamily,
         cAttributeFontstyle,
-        cAttributeFontweight
+        cAttributeFontweight,
+
+        cAttributeCount
+    };
+
+    // A set of attributes and their values.
+    //
+    // Bit n of the mask is set if attribute n is present. The values of
+    // the present attributes are stored in increasing order of Attribute,
+    // so the value of attribute n is at the position given by the number
+    // of bits below bit n.
+    //
+    // Nearly every element has at most cInlineCount attributes, and those
+    // live inside the AttributeSet itself; a set with more moves them all
+    // to mOverflowValues, a block in the current arena with room for every
+    // attribute.
+    //
+    // Attribute values are always generated by blahtex (never copied from
+    // the input), and are plain ASCII.
+    class AttributeSet
+    {
+    public:
+        AttributeSet() :
+            mMask(0),
+            mOverflowValues(NULL)
+        { }
+
+        AttributeSet(const AttributeSet& other);
+        AttributeSet& operator=(const AttributeSet& other);
+
+        // Sets an attribute, replacing any previous value. This version is
+        // for string literals (and other strings that live forever, such
+        // as gMathmlFontStrings); only the pointer is stored.
+        void Set(Attribute attribute, const wchar_t* value);
+
+        // Same as above, for computed values. If the value is one of the
+        // common ones (see InternAttributeValue) the shared copy is used,
+        // otherwise it is copied into the current arena.
+        void Set(Attribute attribute, const std::wstring& value);
+
+        // Returns the value of an attribute, or NULL if it isn't set.
+        const wchar_t* Get(Attribute attribute) const;
+
+        bool IsEmpty() const
+        {
+            return mMask == 0;
+        }
+
+        unsigned GetMask() const
+        {
+            return mMask;
+        }
+
+        // The values of the attributes in GetMask(), in increasing order
+        // of Attribute.
+        const wchar_t* const* GetValues() const
+        {
+            return mOverflowValues ? mOverflowValues : mInlineValues;
+        }
+
+    private:
+        enum
+        {
+            cInlineCount = 4
+        };
+
+        unsigned mMask;
+        const wchar_t* mInlineValues[cInlineCount];
+        const wchar_t** mOverflowValues;
     };
 
-    std::map<Attribute, std::wstring> mAttributes;
+    AttributeSet mAttributes;
 
     // mText is only used for leaf nodes: it holds the text that is
     // displayed between the opening and closing tags
     std::wstring mText;
     
     // mChildren is only used for internal nodes
-    std::list<MathmlNode*> mChildren;
+    typedef std::vector<MathmlNode*, ArenaAllocator<MathmlNode*> >
+        ChildList;
+
+    ChildList mChildren;
     
     MathmlNode(Type type, const std::wstring& text = L"") :
         mType(type),
@@ -125,17 +203,10 @@ struct MathmlNode
     { }
     
     ~MathmlNode();
-    
-    // This function adds mathvariant (for MathML 2.0) or fontstyle/
-    // fontweight/fontfamily (for MathML 1.x) as appropriate to this node
-    // to obtain the desired font. It knows about MathML defaults (like the
-    // annoying automatic italic for single character <mi> nodes).
-    void AddFontAttributes(
-        MathmlFont desiredFont,
-        const MathmlOptions& options
-    );
-    
-    
+
+    // Write() recursively sends the tree rooted at this node to "writer".
+    void Write(MathmlWriter& writer) const;
+
     // Print() recursively prints the tree rooted at this node to the
     // given output stream.
     //
@@ -150,11 +221,34 @@ struct MathmlNode
         int depth = 0
     ) const;
 
-    // Used internally by Print:
-    void PrintType(std::wostream& os) const;
-    void PrintAttributes(std::wostream& os) const;
+    // Same as above, but appends the output to "output" in UTF-8.
+    void Print(
+        std::string& output,
+        const EncodingOptions& options,
+        bool indent,
+        int depth = 0
+    ) const;
+
+private:
+    // Not copyable; the children would be deleted twice.
+    MathmlNode(const MathmlNode&);
+    MathmlNode& operator=(const MathmlNode&);
 };
 
+
+// This function adds mathvariant (for MathML 2.0) or fontstyle/
+// fontweight/fontfamily (for MathML 1.x) as appropriate to the attributes
+// of an element of the given type and text, to obtain the desired font. It
+// knows about MathML defaults (like the annoying automatic italic for
+// single character <mi> nodes).
+void AddFontAttributes(
+    MathmlNode::AttributeSet& attributes,
+    MathmlNode::Type type,
+    const std::wstring& text,
+    MathmlFont desiredFont,
+    const MathmlOptions& options
+);
+
 }
 
 #endif
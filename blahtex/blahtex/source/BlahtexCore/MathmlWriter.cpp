@@ -0,0 +1,377 @@
+// File "MathmlWriter.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <stdexcept>
+#include "MathmlWriter.h"
+#include "XmlEncode.h"
+
+using namespace std;
+
+namespace blahtex
+{
+
+static const wchar_t* const gTypeArray[] =
+{
+    L"mi",
+    L"mo",
+    L"mn",
+    L"mspace",
+    L"mtext",
+    L"mrow",
+    L"mstyle",
+    L"msub",
+    L"msup",
+    L"msubsup",
+    L"munder",
+    L"mover",
+    L"munderover",
+    L"mfrac",
+    L"msqrt",
+    L"mroot",
+    L"mtable",
+    L"mtr",
+    L"mtd",
+    L"mpadded"
+};
+
+static const wchar_t* const gAttributeArray[] =
+{
+    L"displaystyle",
+    L"scriptlevel",
+    L"mathvariant",
+    L"mathcolor",
+    L"lspace",
+    L"rspace",
+    L"width",
+    L"stretchy",
+    L"minsize",
+    L"maxsize",
+    L"accent",
+    L"movablelimits",
+    L"linethickness",
+    L"columnalign",
+    L"columnspacing",
+    L"rowspacing",
+    L"fontfamily",
+    L"fontstyle",
+    L"fontweight"
+};
+
+// Element and attribute names, and attribute values, are plain ASCII.
+inline void AppendName(wstring& output, const wchar_t* name)
+{
+    output += name;
+}
+
+inline void AppendName(string& output, const wchar_t* name)
+{
+    for (; *name; name++)
+        output += static_cast<char>(*name);
+}
+
+// Pre-encoded text is only available in UTF-8.
+inline void AppendPreEncoded(
+    wstring& output,
+    const wstring& text,
+    const EncodedText& encoded,
+    const EncodingOptions& options,
+    int combination
+)
+{
+    XmlEncode(output, text, options);
+}
+
+inline void AppendPreEncoded(
+    string& output,
+    const wstring& text,
+    const EncodedText& encoded,
+    const EncodingOptions& options,
+    int combination
+)
+{
+    encoded.AppendTo(output, combination);
+}
+
+template<class Output>
+void WriteIndent(
+    Output& output,
+    int depth
+)
+{
+    output.append(2 * depth, ' ');
+}
+
+template<class Output>
+void PrintType(
+    Output& output,
+    MathmlNode::Type type
+)
+{
+    if (type < 0 || type >= END_ARRAY(gTypeArray) - gTypeArray)
+        throw logic_error("Illegal node type in MathmlPrinter");
+
+    AppendName(output, gTypeArray[type]);
+}
+
+template<class Output>
+void PrintAttributes(
+    Output& output,
+    const MathmlNode::AttributeSet& attributes
+)
+{
+    unsigned mask = attributes.GetMask();
+    const wchar_t* const* value = attributes.GetValues();
+    for (int attribute = 0; (mask >> attribute) != 0; attribute++)
+    {
+        if (!(mask >> attribute & 1))
+            continue;
+
+        output += ' ';
+        AppendName(output, gAttributeArray[attribute]);
+        output += '=';
+        output += '"';
+        AppendName(output, *value++);
+        output += '"';
+    }
+}
+
+
+template <class Output>
+MathmlPrinter<Output>::MathmlPrinter(
+    Output& output,
+    const EncodingOptions& options,
+    bool indent,
+    int depth
+) :
+    mOutput(output),
+    mOptions(options),
+    mIndent(indent),
+    mDepth(depth),
+    mEncodingCombination(EncodedText::GetCombination(options)),
+    mIsStartTagOpen(false),
+    mHasText(false)
+{ }
+
+template <class Output>
+void MathmlPrinter<Output>::StartElement(
+    MathmlNode::Type type,
+    const MathmlNode::AttributeSet& attributes
+)
+{
+    if (mIsStartTagOpen)
+    {
+        // The parent turns out to have children.
+        mOutput += '>';
+        if (mIndent)
+            mOutput += '\n';
+    }
+
+    if (mIndent)
+        WriteIndent(mOutput, mDepth);
+
+    mOutput += '<';
+    PrintType(mOutput, type);
+    PrintAttributes(mOutput, attributes);
+    mIsStartTagOpen = true;
+    mDepth++;
+}
+
+template <class Output>
+void MathmlPrinter<Output>::Text(const wstring& text)
+{
+    if (text.empty())
+        return;
+
+    if (!mIsStartTagOpen)
+        throw logic_error("Unexpected text in MathmlPrinter::Text");
+
+    mOutput += '>';
+    XmlEncode(mOutput, text, mOptions);
+    mIsStartTagOpen = false;
+    mHasText = true;
+}
+
+template <class Output>
+void MathmlPrinter<Output>::PreEncodedText(
+    const wstring& text,
+    const EncodedText& encoded
+)
+{
+    if (text.empty())
+        return;
+
+    if (!mIsStartTagOpen)
+        throw logic_error(
+            "Unexpected text in MathmlPrinter::PreEncodedText"
+        );
+
+    mOutput += '>';
+    AppendPreEncoded(mOutput, text, encoded, mOptions, mEncodingCombination);
+    mIsStartTagOpen = false;
+    mHasText = true;
+}
+
+template <class Output>
+void MathmlPrinter<Output>::EndElement(MathmlNode::Type type)
+{
+    mDepth--;
+
+    if (mIsStartTagOpen)
+    {
+        mOutput += '/';
+        mOutput += '>';
+        mIsStartTagOpen = false;
+    }
+    else
+    {
+        if (mIndent && !mHasText)
+            WriteIndent(mOutput, mDepth);
+
+        mOutput += '<';
+        mOutput += '/';
+        PrintType(mOutput, type);
+        mOutput += '>';
+    }
+
+    mHasText = false;
+    if (mIndent)
+        mOutput += '\n';
+}
+
+void MathmlWriter::PreEncodedText(
+    const wstring& text,
+    const EncodedText& encoded
+)
+{
+    Text(text);
+}
+
+
+template class MathmlPrinter<wstring>;
+template class MathmlPrinter<string>;
+
+
+MathmlBroadcaster::MathmlBroadcaster()
+{ }
+
+MathmlBroadcaster::~MathmlBroadcaster()
+{
+    for (vector<MathmlWriter*>::iterator
+        writer = mWriters.begin(); writer != mWriters.end(); writer++
+    )
+        delete *writer;
+}
+
+void MathmlBroadcaster::Add(auto_ptr<MathmlWriter> writer)
+{
+    mWriters.push_back(writer.get());
+    writer.release();
+}
+
+void MathmlBroadcaster::StartElement(
+    MathmlNode::Type type,
+    const MathmlNode::AttributeSet& attributes
+)
+{
+    for (vector<MathmlWriter*>::iterator
+        writer = mWriters.begin(); writer != mWriters.end(); writer++
+    )
+        (*writer)->StartElement(type, attributes);
+}
+
+void MathmlBroadcaster::Text(const wstring& text)
+{
+    for (vector<MathmlWriter*>::iterator
+        writer = mWriters.begin(); writer != mWriters.end(); writer++
+    )
+        (*writer)->Text(text);
+}
+
+void MathmlBroadcaster::PreEncodedText(
+    const wstring& text,
+    const EncodedText& encoded
+)
+{
+    for (vector<MathmlWriter*>::iterator
+        writer = mWriters.begin(); writer != mWriters.end(); writer++
+    )
+        (*writer)->PreEncodedText(text, encoded);
+}
+
+void MathmlBroadcaster::EndElement(MathmlNode::Type type)
+{
+    for (vector<MathmlWriter*>::iterator
+        writer = mWriters.begin(); writer != mWriters.end(); writer++
+    )
+        (*writer)->EndElement(type);
+}
+
+
+MathmlTreeBuilder::MathmlTreeBuilder()
+{ }
+
+void MathmlTreeBuilder::StartElement(
+    MathmlNode::Type type,
+    const MathmlNode::AttributeSet& attributes
+)
+{
+    auto_ptr<MathmlNode> node(new MathmlNode(type));
+    node->mAttributes = attributes;
+    MathmlNode* nodePointer = node.get();
+
+    if (!mOpenNodes.empty())
+        mOpenNodes.back()->mChildren.push_back(node.release());
+    else if (!mRoot.get())
+        mRoot = node;
+    else
+        throw logic_error(
+            "Second root element in MathmlTreeBuilder::StartElement"
+        );
+
+    mOpenNodes.push_back(nodePointer);
+}
+
+void MathmlTreeBuilder::Text(const wstring& text)
+{
+    if (mOpenNodes.empty())
+        throw logic_error("Unexpected text in MathmlTreeBuilder::Text");
+
+    mOpenNodes.back()->mText = text;
+}
+
+void MathmlTreeBuilder::EndElement(MathmlNode::Type type)
+{
+    if (mOpenNodes.empty() || mOpenNodes.back()->mType != type)
+        throw logic_error(
+            "Mismatched end tag in MathmlTreeBuilder::EndElement"
+        );
+
+    mOpenNodes.pop_back();
+}
+
+auto_ptr<MathmlNode> MathmlTreeBuilder::GetRoot()
+{
+    mOpenNodes.clear();
+    return mRoot;
+}
+
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -0,0 +1,166 @@
+// File "MathmlWriter.h"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef BLAHTEX_MATHMLWRITER_H
+#define BLAHTEX_MATHMLWRITER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include "Misc.h"
+#include "MathmlNode.h"
+#include "XmlEncode.h"
+
+namespace blahtex
+{
+
+// A MathmlWriter receives MathML as a sequence of events (start tag, text,
+// end tag) in document order. The layout tree generates its MathML this
+// way (see LayoutTree::Node::WriteMathml), so that it can go straight to a
+// MathmlPrinter without a MathmlNode tree being built in between.
+class MathmlWriter
+{
+public:
+    virtual ~MathmlWriter()
+    { }
+
+    virtual void StartElement(
+        MathmlNode::Type type,
+        const MathmlNode::AttributeSet& attributes
+    ) = 0;
+
+    // Text inside the current element, which must be a token element.
+    // Empty text is ignored.
+    virtual void Text(const std::wstring& text) = 0;
+
+    // Same as Text(), where "encoded" holds "text" already XML-encoded
+    // (see XmlEncode.h). The default just calls Text(text).
+    virtual void PreEncodedText(
+        const std::wstring& text,
+        const EncodedText& encoded
+    );
+
+    virtual void EndElement(MathmlNode::Type type) = 0;
+};
+
+
+// MathmlPrinter appends the markup to "output", which is either a wstring
+// or a string (in which case the markup is in UTF-8). The format is
+// described under MathmlNode::Print.
+template <class Output>
+class MathmlPrinter : public MathmlWriter
+{
+public:
+    MathmlPrinter(
+        Output& output,
+        const EncodingOptions& options,
+        bool indent,
+        int depth = 0
+    );
+
+    virtual void StartElement(
+        MathmlNode::Type type,
+        const MathmlNode::AttributeSet& attributes
+    );
+    virtual void Text(const std::wstring& text);
+    virtual void PreEncodedText(
+        const std::wstring& text,
+        const EncodedText& encoded
+    );
+    virtual void EndElement(MathmlNode::Type type);
+
+private:
+    Output& mOutput;
+    const EncodingOptions& mOptions;
+    bool mIndent;
+    int mDepth;
+
+    // EncodedText::GetCombination(mOptions)
+    int mEncodingCombination;
+
+    // True if the most recent start tag is still missing its ">", so that
+    // it can become "<x/>" if the element turns out to be empty.
+    bool mIsStartTagOpen;
+
+    // True if the current element contains text.
+    bool mHasText;
+};
+
+
+// MathmlBroadcaster passes every event on to each writer in a list, so
+// that several printers can share a single pass over the layout tree. It
+// owns the writers.
+class MathmlBroadcaster : public MathmlWriter
+{
+public:
+    MathmlBroadcaster();
+    virtual ~MathmlBroadcaster();
+
+    void Add(std::auto_ptr<MathmlWriter> writer);
+
+    virtual void StartElement(
+        MathmlNode::Type type,
+        const MathmlNode::AttributeSet& attributes
+    );
+    virtual void Text(const std::wstring& text);
+    virtual void PreEncodedText(
+        const std::wstring& text,
+        const EncodedText& encoded
+    );
+    virtual void EndElement(MathmlNode::Type type);
+
+private:
+    std::vector<MathmlWriter*> mWriters;
+
+    // Not copyable, since it owns the writers.
+    MathmlBroadcaster(const MathmlBroadcaster&);
+    MathmlBroadcaster& operator=(const MathmlBroadcaster&);
+};
+
+
+// MathmlTreeBuilder builds a MathmlNode tree from the events. The nodes
+// are allocated from the current arena.
+class MathmlTreeBuilder : public MathmlWriter
+{
+public:
+    MathmlTreeBuilder();
+
+    virtual void StartElement(
+        MathmlNode::Type type,
+        const MathmlNode::AttributeSet& attributes
+    );
+    virtual void Text(const std::wstring& text);
+    virtual void EndElement(MathmlNode::Type type);
+
+    // Returns the tree built so far, and gives up ownership of it.
+    std::auto_ptr<MathmlNode> GetRoot();
+
+private:
+    std::auto_ptr<MathmlNode> mRoot;
+
+    // The elements that have been started but not yet ended.
+    std::vector<MathmlNode*> mOpenNodes;
+};
+
+}
+
+#endif
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -22,7 +22,9 @@
 #define BLAHTEX_MISC_H
 
 
+#include <cwchar>
 #include <set>
+#include <stdexcept>
 #include <vector>
 #include <string>
 
@@ -44,6 +46,96 @@
 namespace blahtex
 {
 
+// The lookup tables keyed by command name (operators, delimiters, error
+// messages, etc) are arrays of TableEntry, sorted by mName. Since they
+// are plain aggregates of pointers and constants, the compiler lays them
+// out in read-only data, so unlike a std::map they cost nothing at
+// startup and never touch the heap.
+//
+// Anyone adding an entry must keep the array sorted (in order of
+// character codes, so for example "\\Gamma" comes before "\\alpha"),
+// otherwise FindEntry will quietly miss things. Each file that defines
+// such tables passes them to CheckTableOrder during static
+// initialisation, so an entry out of place stops blahtex at startup.
+template <class Value>
+struct TableEntry
+{
+    const wchar_t* mName;
+    Value mValue;
+};
+
+// Compares a table name with a key, in the same order as wcscmp.
+inline int CompareTableName(const wchar_t* name, const std::wstring& key)
+{
+    for (size_t index = 0; index < key.size(); index++)
+    {
+        if (name[index] == 0)
+            return -1;
+        if (name[index] != key[index])
+            return (name[index] < key[index]) ? -1 : 1;
+    }
+    return (name[key.size()] == 0) ? 0 : 1;
+}
+
+// Binary search for "key" in the sorted range [begin, end) of TableEntry.
+// Returns NULL if it isn't there.
+template <class Value>
+const TableEntry<Value>* FindEntry(
+    const TableEntry<Value>* begin,
+    const TableEntry<Value>* end,
+    const std::wstring& key
+)
+{
+    while (begin < end)
+    {
+        const TableEntry<Value>* middle = begin + (end - begin) / 2;
+        int comparison = CompareTableName(middle->mName, key);
+        if (comparison == 0)
+            return middle;
+        if (comparison < 0)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    return NULL;
+}
+
+template <class Value, size_t size>
+const TableEntry<Value>* FindEntry(
+    const TableEntry<Value> (&table)[size],
+    const std::wstring& key
+)
+{
+    return FindEntry(table, table + size, key);
+}
+
+// Throws std::logic_error unless "table" is strictly increasing by mName.
+// Returns true, so that it can initialise a global.
+template <class Value, size_t size>
+bool CheckTableOrder(
+    const TableEntry<Value> (&table)[size],
+    const char* tableName
+)
+{
+    for (size_t index = 1; index < size; index++)
+        if (std::wcscmp(table[index - 1].mName, table[index].mName) >= 0)
+            throw std::logic_error(
+                std::string(tableName) + " is not sorted"
+            );
+    return true;
+}
+
+// The same for plain arrays that are searched with std::binary_search.
+template <class Value, size_t size>
+bool CheckTableOrder(const Value (&table)[size], const char* tableName)
+{
+    for (size_t index = 1; index < size; index++)
+        if (!(table[index - 1] < table[index]))
+            throw std::logic_error(
+                std::string(tableName) + " is not sorted"
+            );
+    return true;
+}
 
 // Stores colours in 0x00rrggbb format.
 // Better be 32 bits wide!
@@ -25,7 +25,10 @@
 // ParseTree2.cpp and ParseTree3.cpp.
 
 #include <memory>
+#include <vector>
 #include "LayoutTree.h"
+#include "Arena.h"
+#include "TokenTable.h"
 
 // The ParseTree namespace contains all classes representing nodes in the
 // parse tree. This is essentially a tree representation of the input
@@ -101,6 +104,20 @@ struct TexTextFont
     MathmlFont GetMathmlApproximation() const;
 };
 
+// The same information as TexTextFont, but without a constructor, so that
+// it can be used in the constant tables of text mode commands.
+struct TexTextFontEntry
+{
+    TexTextFont::Family mFamily;
+    bool mIsBold;
+    bool mIsItalic;
+
+    TexTextFont GetFont() const
+    {
+        return TexTextFont(mFamily, mIsBold, mIsItalic);
+    }
+};
+
 
 // This struct represents some state information during the parse tree =>
 // layout tree building phase (i.e. while within BuildLayoutTree).
@@ -149,8 +166,9 @@ struct LatexFeatures
     { }
 
     // Given the LaTeX command "command", checks to see if any of the above
-    // flags need to be switched on for that command to work.
-    void Update(const std::wstring& command);
+    // flags need to be switched on for that command to work (using the
+    // feature bits in its CommandInfo).
+    void Update(Token command);
 };
 
 
@@ -167,8 +185,9 @@ enum FontEncoding
 
 namespace ParseTree
 {
-    // Base class for nodes in the parse tree.
-    struct Node
+    // Base class for nodes in the parse tree. Nodes are allocated from the
+    // current arena (see Arena.h).
+    struct Node : ArenaAllocated
     {
         virtual ~Node()
         { };
@@ -200,6 +219,13 @@ namespace ParseTree
             std::wostream& os,
             int depth = 0
         ) const = 0;
+
+        // AppendCanonical() appends a compact serialisation of the parse
+        // tree under this node to "output" (see
+        // Manager::GetCanonicalForm). Unlike Print(), it records every
+        // member that can affect the output, and its format only changes
+        // together with Manager::cCanonicalFormVersion.
+        virtual void AppendCanonical(std::wstring& output) const = 0;
     };
 
 
@@ -213,16 +239,29 @@ namespace ParseTree
     {
     };
 
+    struct MathTableRow;
+
+    // The child vectors of MathList, MathTableRow, MathTable and TextList.
+    // Like the nodes themselves, they are allocated from the current arena.
+    typedef std::vector<MathNode*, ArenaAllocator<MathNode*> >
+        MathNodeVector;
+    typedef std::vector<TextNode*, ArenaAllocator<TextNode*> >
+        TextNodeVector;
+    typedef std::vector<MathTableRow*, ArenaAllocator<MathTableRow*> >
+        MathTableRowVector;
+
 
     // Represents any command like "a", "1", "\alpha", "\int" which blahtex
     // treats as a single symbol. Also includes spacing commands like "\,".
     struct MathSymbol : MathNode
     {
-        // The command, e.g. "a", "\alpha".
+        // The command, e.g. "a", "\alpha", and its Token.
         std::wstring mCommand;
+        Token mToken;
 
-        MathSymbol(const std::wstring& command) :
-            mCommand(command)
+        MathSymbol(Token token, const std::wstring& command) :
+            mCommand(command),
+            mToken(token)
         { }
 
         virtual std::auto_ptr<LayoutTree::Node> BuildLayoutTree(
@@ -239,22 +278,27 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
     // Represents a command taking a single argument.
     struct MathCommand1Arg : MathNode
     {
-        // The command, e.g. "\hat", "\mathop".
+        // The command, e.g. "\hat", "\mathop", and its Token.
         std::wstring mCommand;
+        Token mToken;
 
         // Node corresponding to the argument of the command.
         std::auto_ptr<MathNode> mChild;
 
         MathCommand1Arg(
+            Token token,
             const std::wstring& command,
             std::auto_ptr<MathNode> child
         ) :
             mCommand(command),
+            mToken(token),
             mChild(child)
         { }
 
@@ -272,6 +316,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -279,13 +325,16 @@ namespace ParseTree
     // "\color".
     struct MathStateChange : MathNode
     {
-        // The style change command, e.g. "\scriptstyle".
+        // The style change command, e.g. "\scriptstyle", and its Token.
         std::wstring mCommand;
+        Token mToken;
 
         MathStateChange(
+            Token token,
             const std::wstring& command
         ) :
-            mCommand(command)
+            mCommand(command),
+            mToken(token)
         { }
         
         // Modifies "state" according to the state change command.
@@ -307,6 +356,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -319,7 +370,7 @@ namespace ParseTree
         MathColour(
             const std::wstring& colourName
         ) :
-            MathStateChange(L"\\color"),
+            MathStateChange(cTokenColor, L"\\color"),
             mColourName(colourName)
         { }
 
@@ -341,14 +392,17 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
     // Represents a command taking two arguments, including infix commands.
     struct MathCommand2Args : MathNode
     {
-        // The command, e.g. "\frac", "\choose".
+        // The command, e.g. "\frac", "\choose", and its Token.
         std::wstring mCommand;
+        Token mToken;
 
         // The two arguments.
         std::auto_ptr<MathNode> mChild1, mChild2;
@@ -357,12 +411,14 @@ namespace ParseTree
         bool mIsInfix;
 
         MathCommand2Args(
+            Token token,
             const std::wstring& command,
             std::auto_ptr<MathNode> child1,
             std::auto_ptr<MathNode> child2,
             bool isInfix
         ) :
             mCommand(command),
+            mToken(token),
             mChild1(child1),
             mChild2(child2),
             mIsInfix(isInfix)
@@ -382,6 +438,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -394,12 +452,19 @@ namespace ParseTree
         // The delimiter that the big command is applied to, e.g. "\langle".
         std::wstring mDelimiter;
 
+        // Tokens for mCommand and mDelimiter.
+        Token mCommandToken, mDelimiterToken;
+
         MathBig(
+            Token commandToken,
             const std::wstring& command,
+            Token delimiterToken,
             const std::wstring& delimiter
         ) :
             mCommand(command),
-            mDelimiter(delimiter)
+            mDelimiter(delimiter),
+            mCommandToken(commandToken),
+            mDelimiterToken(delimiterToken)
         { }
 
         virtual std::auto_ptr<LayoutTree::Node> BuildLayoutTree(
@@ -416,6 +481,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -444,6 +511,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -452,7 +521,7 @@ namespace ParseTree
     // nodes.
     struct MathList : MathNode
     {
-        std::vector<MathNode*> mChildren;
+        MathNodeVector mChildren;
 
         ~MathList();
 
@@ -470,6 +539,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -494,6 +565,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -532,26 +605,33 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
     // Represents an expression surrounded by "\left( ... \right)".
     struct MathDelimited : MathNode
     {
-        // The delimiters, e.g. "\langle", "(".
+        // The delimiters, e.g. "\langle", "(", and their Tokens.
         std::wstring mLeftDelimiter, mRightDelimiter;
+        Token mLeftToken, mRightToken;
 
         // The stuff enclosed by the delimiters:
         std::auto_ptr<MathNode> mChild;
 
         MathDelimited(
             std::auto_ptr<MathNode> child,
+            Token leftToken,
             const std::wstring& leftDelimiter,
+            Token rightToken,
             const std::wstring& rightDelimiter
         ) :
             mChild(child),
             mLeftDelimiter(leftDelimiter),
-            mRightDelimiter(rightDelimiter)
+            mRightDelimiter(rightDelimiter),
+            mLeftToken(leftToken),
+            mRightToken(rightToken)
         { }
 
         virtual std::auto_ptr<LayoutTree::Node> BuildLayoutTree(
@@ -568,6 +648,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -576,7 +658,7 @@ namespace ParseTree
     struct MathTableRow : MathNode
     {
         // The entries in the row.
-        std::vector<MathNode*> mEntries;
+        MathNodeVector mEntries;
 
         ~MathTableRow();
 
@@ -594,6 +676,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -602,7 +686,7 @@ namespace ParseTree
     struct MathTable : MathNode
     {
         // The rows of the table.
-        std::vector<MathTableRow*> mRows;
+        MathTableRowVector mRows;
 
         ~MathTable();
 
@@ -620,6 +704,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -665,6 +751,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -674,17 +762,20 @@ namespace ParseTree
     // mode, but into a EnterTextMode if encountered during math mode.
     struct EnterTextMode : MathNode
     {
-        // The command, e.g. "\text".
+        // The command, e.g. "\text", and its Token.
         std::wstring mCommand;
+        Token mToken;
 
         // The enclosed *text-mode* node.
         std::auto_ptr<TextNode> mChild;
 
         EnterTextMode(
+            Token token,
             const std::wstring& command,
             std::auto_ptr<TextNode> child
         ) :
             mCommand(command),
+            mToken(token),
             mChild(child)
         { }
 
@@ -702,6 +793,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -709,7 +802,7 @@ namespace ParseTree
     // e.g. "abc" is stored as a TextList containing three TextSymbol nodes.
     struct TextList : TextNode
     {
-        std::vector<TextNode*> mChildren;
+        TextNodeVector mChildren;
 
         ~TextList();
 
@@ -727,6 +820,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -754,6 +849,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -762,11 +859,13 @@ namespace ParseTree
     // like "\,").
     struct TextSymbol : TextNode
     {
-        // The command, e.g. "a" or "\textbackslash"
+        // The command, e.g. "a" or "\textbackslash", and its Token.
         std::wstring mCommand;
+        Token mToken;
 
-        TextSymbol(const std::wstring& command) :
-            mCommand(command)
+        TextSymbol(Token token, const std::wstring& command) :
+            mCommand(command),
+            mToken(token)
         { }
 
         virtual std::auto_ptr<LayoutTree::Node> BuildLayoutTree(
@@ -783,19 +882,24 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
     // Represents a state change command like "\rm" occurring in text mode.
     struct TextStateChange : TextNode
     {
-        // The command, e.g. "\rm".
+        // The command, e.g. "\rm", and its Token.
         std::wstring mCommand;
+        Token mToken;
 
         TextStateChange(
+            Token token,
             const std::wstring& command
         ) :
-            mCommand(command)
+            mCommand(command),
+            mToken(token)
         { }
 
         // Modifies "state" according to the state change command.
@@ -817,6 +921,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
@@ -829,7 +935,7 @@ namespace ParseTree
         TextColour(
             const std::wstring& colourName
         ) :
-            TextStateChange(L"\\color"),
+            TextStateChange(cTokenColor, L"\\color"),
             mColourName(colourName)
         { }
 
@@ -851,23 +957,28 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 
     // Represents a command in text mode taking a single argument.
     struct TextCommand1Arg : TextNode
     {
-        // The command, e.g. "\textrm".
+        // The command, e.g. "\textrm", and its Token.
         std::wstring mCommand;
+        Token mToken;
 
         // Node corresponding to the argument of the command.
         std::auto_ptr<TextNode> mChild;
 
         TextCommand1Arg(
+            Token token,
             const std::wstring& command,
             std::auto_ptr<TextNode> child
         ) :
             mCommand(command),
+            mToken(token),
             mChild(child)
         { }
 
@@ -885,6 +996,8 @@ namespace ParseTree
             std::wostream& os,
             int depth
         ) const;
+
+        virtual void AppendCanonical(std::wstring& output) const;
     };
 
 } // end ParseTree namespace
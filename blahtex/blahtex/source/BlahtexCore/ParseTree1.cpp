@@ -29,54 +29,94 @@ namespace blahtex
 // This is a list of delimiters which may appear after "\left", "\right"
 // and "\big", and of which MathML characters they get mapped to.
 
-static pair<wstring, wstring> gDelimiterArray[] =
+static const TableEntry<const wchar_t*> gDelimiterArray[] =
 {
-    make_pair(L".",             L""),
-    make_pair(L"[",             L"["),
-    make_pair(L"]",             L"]"),
-    make_pair(L"\\lbrack",      L"["),
-    make_pair(L"\\rbrack",      L"]"),
-    make_pair(L"(",             L"("),
-    make_pair(L")",             L")"),
-    make_pair(L"<",             L"\U00002329"),
-    make_pair(L">",             L"\U0000232A"),
-    make_pair(L"\\langle",      L"\U00002329"),
-    make_pair(L"\\rangle",      L"\U0000232A"),
-    make_pair(L"/",             L"/"),
-    make_pair(L"\\backslash",   L"\U00002216"),
-    make_pair(L"\\{",           L"{"),
-    make_pair(L"\\}",           L"}"),
-    make_pair(L"\\lbrace",      L"{"),
-    make_pair(L"\\rbrace",      L"}"),
-    make_pair(L"|",             L"|"),
-    make_pair(L"\\vert",        L"|"),
-    make_pair(L"\\lvert",       L"|"),
-    make_pair(L"\\rvert",       L"|"),
-    make_pair(L"\\Vert",        L"\U00002225"),
-    make_pair(L"\\lVert",       L"\U00002225"),
-    make_pair(L"\\rVert",       L"\U00002225"),
-    make_pair(L"\\uparrow",     L"\U00002191"),
-    make_pair(L"\\downarrow",   L"\U00002193"),
-    make_pair(L"\\updownarrow", L"\U00002195"),
-    make_pair(L"\\Uparrow",     L"\U000021D1"),
-    make_pair(L"\\Downarrow",   L"\U000021D3"),
-    make_pair(L"\\Updownarrow", L"\U000021D5"),
-    make_pair(L"\\lfloor",      L"\U0000230A"),
-    make_pair(L"\\rfloor",      L"\U0000230B"),
-    make_pair(L"\\lceil",       L"\U00002308"),
-    make_pair(L"\\rceil",       L"\U00002309")
+    {L"(",             L"("},
+    {L")",             L")"},
+    {L".",             L""},
+    {L"/",             L"/"},
+    {L"<",             L"\U00002329"},
+    {L">",             L"\U0000232A"},
+    {L"[",             L"["},
+    {L"\\Downarrow",   L"\U000021D3"},
+    {L"\\Uparrow",     L"\U000021D1"},
+    {L"\\Updownarrow", L"\U000021D5"},
+    {L"\\Vert",        L"\U00002225"},
+    {L"\\backslash",   L"\U00002216"},
+    {L"\\downarrow",   L"\U00002193"},
+    {L"\\lVert",       L"\U00002225"},
+    {L"\\langle",      L"\U00002329"},
+    {L"\\lbrace",      L"{"},
+    {L"\\lbrack",      L"["},
+    {L"\\lceil",       L"\U00002308"},
+    {L"\\lfloor",      L"\U0000230A"},
+    {L"\\lvert",       L"|"},
+    {L"\\rVert",       L"\U00002225"},
+    {L"\\rangle",      L"\U0000232A"},
+    {L"\\rbrace",      L"}"},
+    {L"\\rbrack",      L"]"},
+    {L"\\rceil",       L"\U00002309"},
+    {L"\\rfloor",      L"\U0000230B"},
+    {L"\\rvert",       L"|"},
+    {L"\\uparrow",     L"\U00002191"},
+    {L"\\updownarrow", L"\U00002195"},
+    {L"\\vert",        L"|"},
+    {L"\\{",           L"{"},
+    {L"\\}",           L"}"},
+    {L"]",             L"]"},
+    {L"|",             L"|"}
 };
 
-wishful_hash_map<wstring, wstring> gDelimiterTable(
-    gDelimiterArray,
-    END_ARRAY(gDelimiterArray)
-);
+// Used by the parser to check delimiters.
+bool IsDelimiter(const wstring& delimiter)
+{
+    return FindEntry(gDelimiterArray, delimiter) != NULL;
+}
+
+// LookupDelimiter() returns the MathML character for a delimiter which the
+// parser has already checked with IsDelimiter().
+const wchar_t* LookupDelimiter(const wstring& delimiter)
+{
+    const TableEntry<const wchar_t*>* lookup =
+        FindEntry(gDelimiterArray, delimiter);
+    if (!lookup)
+        throw logic_error("Unexpected delimiter in LookupDelimiter");
+    return lookup->mValue;
+}
 
 
 namespace ParseTree
 {
 
 
+static int gSpaceTable[8][8] =
+{
+//                     RIGHT
+// ord   op    bin   rel   open  close punct inner
+   {0,    3,    4,    5,    0,    0,    0,    3},    // ord
+   {3,    3,    0,    5,    0,    0,    0,    3},    // op
+   {4,    4,    0,    0,    4,    0,    0,    4},    // bin
+   {5,    5,    0,    0,    5,    0,    0,    5},    // rel
+   {0,    0,    0,    0,    0,    0,    0,    0},    // open     // LEFT
+   {0,    3,    4,    5,    0,    0,    0,    3},    // close
+   {3,    3,    0,    3,    3,    3,    3,    3},    // punct
+   {3,    3,    4,    5,    3,    0,    3,    3}     // inner
+};
+
+static int gIgnoreSpaceTable[8][8] =
+{
+//                     RIGHT
+// ord   op    bin   rel   open  close punct inner
+   {0,    0,    1,    1,    0,    0,    0,    1},    // ord
+   {0,    0,    0,    1,    0,    0,    0,    1},    // op
+   {1,    1,    0,    0,    1,    0,    0,    1},    // bin
+   {1,    1,    0,    0,    1,    0,    0,    1},    // rel
+   {0,    0,    0,    0,    0,    0,    0,    0},    // open     // LEFT
+   {0,    0,    1,    1,    0,    0,    0,    1},    // close
+   {1,    1,    0,    1,    1,    1,    1,    1},    // punct
+   {1,    0,    1,    1,    1,    0,    1,    1}     // inner
+};
+
 auto_ptr<LayoutTree::Node> MathList::BuildLayoutTree(
     const TexProcessingState& state
 ) const
@@ -84,13 +124,13 @@ auto_ptr<LayoutTree::Node> MathList::BuildLayoutTree(
     auto_ptr<LayoutTree::Row> output(
         new LayoutTree::Row(state.mStyle, state.mColour)
     );
-    list<LayoutTree::Node*>& targetList = output->mChildren;
+    LayoutTree::NodeList& targetList = output->mChildren;
 
 
     // 1st pass: recursively build layout trees for all children in
     // this row, and process state changes
     TexProcessingState currentState = state;
-    for (vector<MathNode*>::const_iterator
+    for (MathNodeVector::const_iterator
         node = mChildren.begin(); node != mChildren.end(); node++
     )
     {
@@ -107,7 +147,7 @@ auto_ptr<LayoutTree::Node> MathList::BuildLayoutTree(
 
 
     // 2nd pass: modify atom flavours according to TeX's rules.
-    for (list<LayoutTree::Node*>::iterator
+    for (LayoutTree::NodeList::iterator
         node = targetList.begin(); node != targetList.end(); node++
     )
     {
@@ -119,7 +159,7 @@ auto_ptr<LayoutTree::Node> MathList::BuildLayoutTree(
                     (*node)->mFlavour = LayoutTree::Node::cFlavourOrd;
                 else
                 {
-                    list<LayoutTree::Node*>::iterator previous = node;
+                    LayoutTree::NodeList::iterator previous = node;
                     previous--;
                     switch ((*previous)->mFlavour)
                     {
@@ -142,7 +182,7 @@ auto_ptr<LayoutTree::Node> MathList::BuildLayoutTree(
             {
                 if (node != targetList.begin())
                 {
-                    list<LayoutTree::Node*>::iterator previous = node;
+                    LayoutTree::NodeList::iterator previous = node;
                     previous--;
                     if ((*previous)->mFlavour ==
                             LayoutTree::Node::cFlavourBin
@@ -163,42 +203,14 @@ auto_ptr<LayoutTree::Node> MathList::BuildLayoutTree(
 
     // 3rd pass: insert inter-atomic spacing according to TeX's rules.
 
-    // spaceTable[i][j] gives the amount of space that should be inserted
+    // gSpaceTable[i][j] gives the amount of space that should be inserted
     // between nodes of flavour i and flavour j.
 
-    // ignoreSpaceTable[i][j] is nonzero whenever the space between i and j
+    // gIgnoreSpaceTable[i][j] is nonzero whenever the space between i and j
     // should be ignored while in script or scriptscript style.
 
-    static int spaceTable[8][8] =
-    {
-    //                     RIGHT
-    // ord   op    bin   rel   open  close punct inner
-       {0,    3,    4,    5,    0,    0,    0,    3},    // ord
-       {3,    3,    0,    5,    0,    0,    0,    3},    // op
-       {4,    4,    0,    0,    4,    0,    0,    4},    // bin
-       {5,    5,    0,    0,    5,    0,    0,    5},    // rel
-       {0,    0,    0,    0,    0,    0,    0,    0},    // open     // LEFT
-       {0,    3,    4,    5,    0,    0,    0,    3},    // close
-       {3,    3,    0,    3,    3,    3,    3,    3},    // punct
-       {3,    3,    4,    5,    3,    0,    3,    3}     // inner
-    };
-
-    static int ignoreSpaceTable[8][8] =
-    {
-    //                     RIGHT
-    // ord   op    bin   rel   open  close punct inner
-       {0,    0,    1,    1,    0,    0,    0,    1},    // ord
-       {0,    0,    0,    1,    0,    0,    0,    1},    // op
-       {1,    1,    0,    0,    1,    0,    0,    1},    // bin
-       {1,    1,    0,    0,    1,    0,    0,    1},    // rel
-       {0,    0,    0,    0,    0,    0,    0,    0},    // open     // LEFT
-       {0,    0,    1,    1,    0,    0,    0,    1},    // close
-       {1,    1,    0,    1,    1,    1,    1,    1},    // punct
-       {1,    0,    1,    1,    1,    0,    1,    1}     // inner
-    };
-
-    list<LayoutTree::Node*>::iterator currentAtom = targetList.begin();
-    list<LayoutTree::Node*>::iterator previousAtom;
+    LayoutTree::NodeList::iterator currentAtom = targetList.begin();
+    LayoutTree::NodeList::iterator previousAtom;
     bool foundFirst = false;
     while (true)
     {
@@ -222,7 +234,7 @@ auto_ptr<LayoutTree::Node> MathList::BuildLayoutTree(
 
             int width =
             (
-                ignoreSpaceTable[leftFlavour][rightFlavour] &&
+                gIgnoreSpaceTable[leftFlavour][rightFlavour] &&
                     (
                         state.mStyle ==
                             LayoutTree::Node::cStyleScript
@@ -231,7 +243,7 @@ auto_ptr<LayoutTree::Node> MathList::BuildLayoutTree(
                             LayoutTree::Node::cStyleScriptScript
                     )
             )
-                ? 0 : spaceTable[leftFlavour][rightFlavour];
+                ? 0 : gSpaceTable[leftFlavour][rightFlavour];
 
             targetList.insert(
                 currentAtom,
@@ -249,7 +261,7 @@ auto_ptr<LayoutTree::Node> MathList::BuildLayoutTree(
 
     // 4th pass: splice any children Rows into this Row.
     // The idea is that no Row node should have any Rows as children.
-    for (list<LayoutTree::Node*>::iterator
+    for (LayoutTree::NodeList::iterator
         child = targetList.begin(); child != targetList.end(); child++
     )
     {
@@ -270,16 +282,60 @@ auto_ptr<LayoutTree::Node> MathList::BuildLayoutTree(
 
 // Stores info about accent commands (like "\hat", "\overrightarrow", etc)
 struct AccentInfo {
-    wstring mText;
+    const wchar_t* mText;
     bool mIsStretchy;
+};
 
-    AccentInfo(
-        const wstring& text,
-        bool isStretchy
-    ) :
-        mText(text),
-        mIsStretchy(isStretchy)
-    { }
+
+static const TableEntry<LayoutTree::Node::Flavour> gFlavourCommandArray[] =
+{
+    {L"\\mathbin",       LayoutTree::Node::cFlavourBin},
+    {L"\\mathclose",     LayoutTree::Node::cFlavourClose},
+    {L"\\mathinner",     LayoutTree::Node::cFlavourInner},
+    {L"\\mathop",        LayoutTree::Node::cFlavourOp},
+    {L"\\mathopen",      LayoutTree::Node::cFlavourOpen},
+    {L"\\mathord",       LayoutTree::Node::cFlavourOrd},
+    {L"\\mathpunct",     LayoutTree::Node::cFlavourPunct},
+    {L"\\mathrel",       LayoutTree::Node::cFlavourRel}
+};
+
+
+static const TableEntry<TexMathFont::Family> gFontCommandArray[] =
+{
+    {L"\\mathbb",         TexMathFont::cFamilyBb},
+    {L"\\mathbf",         TexMathFont::cFamilyBf},
+    {L"\\mathcal",        TexMathFont::cFamilyCal},
+    {L"\\mathfrak",       TexMathFont::cFamilyFrak},
+    {L"\\mathit",         TexMathFont::cFamilyIt},
+    {L"\\mathrm",         TexMathFont::cFamilyRm},
+    {L"\\mathsf",         TexMathFont::cFamilySf},
+    {L"\\mathtt",         TexMathFont::cFamilyTt}
+};
+
+
+// Here is a list of all the accent commands we know about.
+static const TableEntry<AccentInfo> gAccentCommandArray[] =
+{
+    {L"\\acute",                {L"\U000000B4", false}},
+    {L"\\bar",                  {L"\U000000AF", false}},
+    {L"\\breve",                {L"\U000002D8", false}},
+    {L"\\check",                {L"\U000002C7", false}},
+    {L"\\ddot",                 {L"\U000000B7\U000000B7", false}},
+    {L"\\dot",                  {L"\U000000B7", false}},
+    {L"\\grave",                {L"\U00000060", false}},
+    // FIX: there's some funny inconsistency between the definition of
+    // &Hat; among MathML versions. I was originally using plain "^" for
+    // \hat and \widehat, but Roger recommended using 0x302 instead.
+    {L"\\hat",                  {L"\U00000302", false}},
+    {L"\\overleftarrow",        {L"\U00002190", true}},
+    {L"\\overleftrightarrow",   {L"\U00002194", true}},
+    {L"\\overline",             {L"\U000000AF", true}},
+    {L"\\overrightarrow",       {L"\U00002192", true}},
+    {L"\\tilde",                {L"\U000002DC", false}},
+    {L"\\underline",            {L"\U000000AF", true}},
+    {L"\\vec",                  {L"\U000020D7", true}},
+    {L"\\widehat",              {L"\U00000302", true}},
+    {L"\\widetilde",            {L"\U000002DC", true}}
 };
 
 
@@ -416,57 +472,24 @@ auto_ptr<LayoutTree::Node> MathCommand1Arg::BuildLayoutTree(
     }
 
 
-    static pair<wstring, LayoutTree::Node::Flavour> flavourCommandArray[] =
-    {
-        make_pair(L"\\mathop",        LayoutTree::Node::cFlavourOp),
-        make_pair(L"\\mathrel",       LayoutTree::Node::cFlavourRel),
-        make_pair(L"\\mathbin",       LayoutTree::Node::cFlavourBin),
-        make_pair(L"\\mathord",       LayoutTree::Node::cFlavourOrd),
-        make_pair(L"\\mathopen",      LayoutTree::Node::cFlavourOpen),
-        make_pair(L"\\mathclose",     LayoutTree::Node::cFlavourClose),
-        make_pair(L"\\mathpunct",     LayoutTree::Node::cFlavourPunct),
-        make_pair(L"\\mathinner",     LayoutTree::Node::cFlavourInner)
-    };
-    static wishful_hash_map<wstring, LayoutTree::Node::Flavour>
-        flavourCommandTable(
-            flavourCommandArray,
-            END_ARRAY(flavourCommandArray)
-        );
-
-    wishful_hash_map<wstring, LayoutTree::Node::Flavour>::const_iterator
-        flavourCommand = flavourCommandTable.find(mCommand);
-    if (flavourCommand != flavourCommandTable.end())
+    const TableEntry<LayoutTree::Node::Flavour>* flavourCommand =
+        FindEntry(gFlavourCommandArray, mCommand);
+    if (flavourCommand)
     {
         auto_ptr<LayoutTree::Node> node
             = mChild->BuildLayoutTree(state);
-        node->mFlavour = flavourCommand->second;
+        node->mFlavour = flavourCommand->mValue;
         if (node->mFlavour == LayoutTree::Node::cFlavourOp)
             node->mLimits = LayoutTree::Node::cLimitsDisplayLimits;
         return node;
     }
 
-    static pair<wstring, TexMathFont::Family> fontCommandArray[] =
-    {
-        make_pair(L"\\mathbf",         TexMathFont::cFamilyBf),
-        make_pair(L"\\mathbb",         TexMathFont::cFamilyBb),
-        make_pair(L"\\mathit",         TexMathFont::cFamilyIt),
-        make_pair(L"\\mathrm",         TexMathFont::cFamilyRm),
-        make_pair(L"\\mathsf",         TexMathFont::cFamilySf),
-        make_pair(L"\\mathtt",         TexMathFont::cFamilyTt),
-        make_pair(L"\\mathcal",        TexMathFont::cFamilyCal),
-        make_pair(L"\\mathfrak",       TexMathFont::cFamilyFrak)
-    };
-    static wishful_hash_map<wstring, TexMathFont::Family> fontCommandTable(
-        fontCommandArray,
-        END_ARRAY(fontCommandArray)
-    );
-
-    wishful_hash_map<wstring, TexMathFont::Family>::const_iterator
-        fontCommand = fontCommandTable.find(mCommand);
-    if (fontCommand != fontCommandTable.end())
+    const TableEntry<TexMathFont::Family>* fontCommand =
+        FindEntry(gFontCommandArray, mCommand);
+    if (fontCommand)
     {
         TexProcessingState newState = state;
-        newState.mMathFont.mFamily = fontCommand->second;
+        newState.mMathFont.mFamily = fontCommand->mValue;
         return mChild->BuildLayoutTree(newState);
     }
 
@@ -478,39 +501,9 @@ auto_ptr<LayoutTree::Node> MathCommand1Arg::BuildLayoutTree(
         return mChild->BuildLayoutTree(newState);
     }
 
-    // Here is a list of all the accent commands we know about.
-    static pair<wstring, AccentInfo> accentCommandArray[] =
-    {
-        // FIX: there's some funny inconsistency between the definition of
-        // &Hat; among MathML versions. I was originally using plain "^" for
-        // these accents, but Roger recommended using 0x302 instead.
-        make_pair(L"\\hat",                  AccentInfo(L"\U00000302", false)),
-        make_pair(L"\\widehat",              AccentInfo(L"\U00000302", true)),
-        make_pair(L"\\bar",                  AccentInfo(L"\U000000AF", false)),
-        make_pair(L"\\overline",             AccentInfo(L"\U000000AF", true)),
-        make_pair(L"\\underline",            AccentInfo(L"\U000000AF", true)),
-        make_pair(L"\\tilde",                AccentInfo(L"\U000002DC", false)),
-        make_pair(L"\\widetilde",            AccentInfo(L"\U000002DC", true)),
-        make_pair(L"\\overleftarrow",        AccentInfo(L"\U00002190", true)),
-        make_pair(L"\\vec",                  AccentInfo(L"\U000020D7", true)),
-        make_pair(L"\\overrightarrow",       AccentInfo(L"\U00002192", true)),
-        make_pair(L"\\overleftrightarrow",   AccentInfo(L"\U00002194", true)),
-        make_pair(L"\\dot",                  AccentInfo(L"\U000000B7", false)),
-        make_pair(L"\\ddot",                 AccentInfo(L"\U000000B7\U000000B7", false)),
-        make_pair(L"\\check",                AccentInfo(L"\U000002C7", false)),
-        make_pair(L"\\acute",                AccentInfo(L"\U000000B4", false)),
-        make_pair(L"\\grave",                AccentInfo(L"\U00000060", false)),
-        make_pair(L"\\breve",                AccentInfo(L"\U000002D8", false)
-        )
-    };
-    static wishful_hash_map<wstring, AccentInfo> accentCommandTable(
-        accentCommandArray,
-        END_ARRAY(accentCommandArray)
-    );
-
-    wishful_hash_map<wstring, AccentInfo>::const_iterator
-        accentCommand = accentCommandTable.find(mCommand);
-    if (accentCommand != accentCommandTable.end())
+    const TableEntry<AccentInfo>* accentCommand =
+        FindEntry(gAccentCommandArray, mCommand);
+    if (accentCommand)
     {
         auto_ptr<LayoutTree::Node> base
             = mChild->BuildLayoutTree(state);
@@ -518,10 +511,10 @@ auto_ptr<LayoutTree::Node> MathCommand1Arg::BuildLayoutTree(
 
         auto_ptr<LayoutTree::Node> accent(
             new LayoutTree::SymbolOperator(
-                accentCommand->second.mIsStretchy,
+                accentCommand->mValue.mIsStretchy,
                 L"",
                 true,       // is an accent
-                accentCommand->second.mText,
+                accentCommand->mValue.mText,
                 state.mMathFont.mIsBoldsymbol
                     ? cMathmlFontBold : cMathmlFontNormal,
                 // We don't need to decrement the style here, because
@@ -726,10 +719,14 @@ auto_ptr<LayoutTree::Node> MathCommand2Args::BuildLayoutTree(
         auto_ptr<LayoutTree::Node> base =
             mChild2->BuildLayoutTree(state);
 
+        // Read the flavour before "base" is handed over below; the order
+        // in which the arguments get evaluated is unspecified.
+        LayoutTree::Node::Flavour flavour = base->mFlavour;
+
         return auto_ptr<LayoutTree::Node>(
             new LayoutTree::Scripts(
                 state.mStyle,
-                base->mFlavour,
+                flavour,
                 LayoutTree::Node::cLimitsNoLimits,
                 state.mColour,
                 false,      // false = NOT sideset
@@ -857,8 +854,8 @@ auto_ptr<LayoutTree::Node> MathDelimited::BuildLayoutTree(
         new LayoutTree::Fenced(
             state.mStyle,
             state.mColour,
-            gDelimiterTable[mLeftDelimiter],
-            gDelimiterTable[mRightDelimiter],
+            LookupDelimiter(mLeftDelimiter),
+            LookupDelimiter(mRightDelimiter),
             mChild->BuildLayoutTree(state)
         )
     );
@@ -869,15 +866,26 @@ auto_ptr<LayoutTree::Node> MathDelimited::BuildLayoutTree(
 struct BigInfo
 {
     LayoutTree::Node::Flavour mFlavour;
-    wstring mSize;
-
-    BigInfo(
-        LayoutTree::Node::Flavour flavour,
-        const wstring& size
-    ) :
-        mFlavour(flavour),
-        mSize(size)
-    { }
+    const wchar_t* mSize;
+};
+
+
+// Here's a list of all the "\big..." commands, how big the delimiter
+// should become, and what flavour it should be, for each one.
+static const TableEntry<BigInfo> gBigCommandArray[] =
+{
+    {L"\\Big",   {LayoutTree::Node::cFlavourOrd,   L"1.8em"}},
+    {L"\\Bigg",  {LayoutTree::Node::cFlavourOrd,   L"3em"}},
+    {L"\\Biggl", {LayoutTree::Node::cFlavourOpen,  L"3em"}},
+    {L"\\Biggr", {LayoutTree::Node::cFlavourClose, L"3em"}},
+    {L"\\Bigl",  {LayoutTree::Node::cFlavourOpen,  L"1.8em"}},
+    {L"\\Bigr",  {LayoutTree::Node::cFlavourClose, L"1.8em"}},
+    {L"\\big",   {LayoutTree::Node::cFlavourOrd,   L"1.2em"}},
+    {L"\\bigg",  {LayoutTree::Node::cFlavourOrd,   L"2.4em"}},
+    {L"\\biggl", {LayoutTree::Node::cFlavourOpen,  L"2.4em"}},
+    {L"\\biggr", {LayoutTree::Node::cFlavourClose, L"2.4em"}},
+    {L"\\bigl",  {LayoutTree::Node::cFlavourOpen,  L"1.2em"}},
+    {L"\\bigr",  {LayoutTree::Node::cFlavourClose, L"1.2em"}}
 };
 
 
@@ -885,35 +893,10 @@ auto_ptr<LayoutTree::Node> MathBig::BuildLayoutTree(
     const TexProcessingState& state
 ) const
 {
-    // Here's a list of all the "\big..." commands, how big the delimiter
-    // should become, and what flavour it should be, for each one.
-    static pair<wstring, BigInfo> bigCommandArray[] =
-    {
-        make_pair(L"\\big",   BigInfo(LayoutTree::Node::cFlavourOrd,   L"1.2em")),
-        make_pair(L"\\bigl",  BigInfo(LayoutTree::Node::cFlavourOpen,  L"1.2em")),
-        make_pair(L"\\bigr",  BigInfo(LayoutTree::Node::cFlavourClose, L"1.2em")),
-
-        make_pair(L"\\Big",   BigInfo(LayoutTree::Node::cFlavourOrd,   L"1.8em")),
-        make_pair(L"\\Bigl",  BigInfo(LayoutTree::Node::cFlavourOpen,  L"1.8em")),
-        make_pair(L"\\Bigr",  BigInfo(LayoutTree::Node::cFlavourClose, L"1.8em")),
-
-        make_pair(L"\\bigg",  BigInfo(LayoutTree::Node::cFlavourOrd,   L"2.4em")),
-        make_pair(L"\\biggl", BigInfo(LayoutTree::Node::cFlavourOpen,  L"2.4em")),
-        make_pair(L"\\biggr", BigInfo(LayoutTree::Node::cFlavourClose, L"2.4em")),
-
-        make_pair(L"\\Bigg",  BigInfo(LayoutTree::Node::cFlavourOrd,   L"3em")),
-        make_pair(L"\\Biggl", BigInfo(LayoutTree::Node::cFlavourOpen,  L"3em")),
-        make_pair(L"\\Biggr", BigInfo(LayoutTree::Node::cFlavourClose, L"3em"))
-    };
-    static wishful_hash_map<wstring, BigInfo> bigCommandTable(
-        bigCommandArray,
-        END_ARRAY(bigCommandArray)
-    );
+    const TableEntry<BigInfo>* bigCommand =
+        FindEntry(gBigCommandArray, mCommand);
 
-    wishful_hash_map<wstring, BigInfo>::const_iterator
-        bigCommand = bigCommandTable.find(mCommand);
-
-    if (bigCommand != bigCommandTable.end())
+    if (bigCommand)
     {
         LayoutTree::Node::Style newStyle = state.mStyle;
         if (state.mStyle != LayoutTree::Node::cStyleDisplay &&
@@ -925,12 +908,12 @@ auto_ptr<LayoutTree::Node> MathBig::BuildLayoutTree(
         return auto_ptr<LayoutTree::Node>(
             new LayoutTree::SymbolOperator(
                 true,       // indicates stretchy="true"
-                bigCommand->second.mSize,
+                bigCommand->mValue.mSize,
                 false,      // not an accent
-                gDelimiterTable[mDelimiter],
+                LookupDelimiter(mDelimiter),
                 cMathmlFontNormal,
                 newStyle,
-                bigCommand->second.mFlavour,
+                bigCommand->mValue.mFlavour,
                 LayoutTree::Node::cLimitsDisplayLimits,
                 state.mColour
             )
@@ -963,15 +946,15 @@ auto_ptr<LayoutTree::Node> MathTable::BuildLayoutTree(
     table->mRows.reserve(mRows.size());
 
     // Walk the table, building the layout tree as we go.
-    for (vector<MathTableRow*>::const_iterator
+    for (MathTableRowVector::const_iterator
         inRow = mRows.begin();
         inRow != mRows.end();
         inRow++
     )
     {
-        table->mRows.push_back(vector<LayoutTree::Node*>());
-        vector<LayoutTree::Node*>& outRow = table->mRows.back();
-        for (vector<MathNode*>::const_iterator
+        table->mRows.push_back(LayoutTree::NodeVector());
+        LayoutTree::NodeVector& outRow = table->mRows.back();
+        for (MathNodeVector::const_iterator
             entry = (*inRow)->mEntries.begin();
             entry != (*inRow)->mEntries.end();
             entry++
@@ -989,15 +972,28 @@ auto_ptr<LayoutTree::Node> MathTable::BuildLayoutTree(
 // Stores information about an environment.
 struct EnvironmentInfo
 {
-    wstring mLeftDelimiter, mRightDelimiter;
-
-    EnvironmentInfo(
-        const wstring& leftDelimiter,
-        const wstring& rightDelimiter
-    ) :
-        mLeftDelimiter(leftDelimiter),
-        mRightDelimiter(rightDelimiter)
-    { }
+    const wchar_t* mLeftDelimiter;
+    const wchar_t* mRightDelimiter;
+};
+
+
+// A list of all environments, and which delimiters appear on each
+// side of the corresponding table.
+// FIX: this is kind of stupid... almost every environment ends up
+// with its own special-case code!
+static const TableEntry<EnvironmentInfo> gEnvironmentArray[] =
+{
+    {L"Bmatrix",      {L"{",      L"}"}},
+    // DoubleVerticalBar:
+    {L"Vmatrix",      {L"\U00002225", L"\U00002225"}},
+    {L"aligned",      {L"",       L""}},
+    {L"bmatrix",      {L"[",      L"]"}},
+    {L"cases",        {L"{",      L""}},
+    {L"matrix",       {L"",       L""}},
+    {L"pmatrix",      {L"(",      L")"}},
+    {L"smallmatrix",  {L"",       L""}},
+    {L"substack",     {L"",       L""}},
+    {L"vmatrix",      {L"|",      L"|"}}
 };
 
 
@@ -1005,33 +1001,10 @@ auto_ptr<LayoutTree::Node> MathEnvironment::BuildLayoutTree(
     const TexProcessingState& state
 ) const
 {
-    // A list of all environments, and which delimiters appear on each
-    // side of the corresponding table.
-    // FIX: this is kind of stupid... almost every environment ends up
-    // with its own special-case code!
-    static pair<wstring, EnvironmentInfo> environmentArray[] =
-    {
-        make_pair(L"matrix",       EnvironmentInfo(L"",       L"")),
-        make_pair(L"pmatrix",      EnvironmentInfo(L"(",      L")")),
-        make_pair(L"bmatrix",      EnvironmentInfo(L"[",      L"]")),
-        make_pair(L"Bmatrix",      EnvironmentInfo(L"{",      L"}")),
-        make_pair(L"vmatrix",      EnvironmentInfo(L"|",      L"|")),
-        // DoubleVerticalBar:
-        make_pair(L"Vmatrix",      EnvironmentInfo(L"\U00002225", L"\U00002225")),
-        make_pair(L"cases",        EnvironmentInfo(L"{",      L"")),
-        make_pair(L"aligned",      EnvironmentInfo(L"",       L"")),
-        make_pair(L"smallmatrix",  EnvironmentInfo(L"",       L"")),
-        make_pair(L"substack",     EnvironmentInfo(L"",       L""))
-    };
-    static wishful_hash_map<wstring, EnvironmentInfo> environmentTable(
-        environmentArray,
-        END_ARRAY(environmentArray)
-    );
-
-    wishful_hash_map<wstring, EnvironmentInfo>::const_iterator
-        environmentLookup = environmentTable.find(mName);
+    const TableEntry<EnvironmentInfo>* environmentLookup =
+        FindEntry(gEnvironmentArray, mName);
 
-    if (environmentLookup == environmentTable.end())
+    if (!environmentLookup)
         throw logic_error(
             "Unexpected environment name in "
             "MathEnvironment::BuildLayoutTree"
@@ -1073,8 +1046,8 @@ auto_ptr<LayoutTree::Node> MathEnvironment::BuildLayoutTree(
     else if (mName == L"cases")
         tablePtr->mAlign = LayoutTree::Table::cAlignLeft;
 
-    if (environmentLookup->second.mLeftDelimiter.empty() &&
-        environmentLookup->second.mRightDelimiter.empty()
+    if (environmentLookup->mValue.mLeftDelimiter[0] == L'\0' &&
+        environmentLookup->mValue.mRightDelimiter[0] == L'\0'
     )
         return table;
 
@@ -1082,49 +1055,46 @@ auto_ptr<LayoutTree::Node> MathEnvironment::BuildLayoutTree(
         new LayoutTree::Fenced(
             fencedStyle,
             state.mColour,
-            environmentLookup->second.mLeftDelimiter,
-            environmentLookup->second.mRightDelimiter,
+            environmentLookup->mValue.mLeftDelimiter,
+            environmentLookup->mValue.mRightDelimiter,
             table
         )
     );
 }
 
 
+// List of all commands that launch into text mode, and some information
+// about which font they select.
+static const TableEntry<TexTextFontEntry> gTextCommandArray[] =
+{                                             // flags are:     bold?  italic?
+    {L"\\cyr",     {TexTextFont::cFamilyRm, false, false}},
+    {L"\\emph",    {TexTextFont::cFamilyRm, false, true}},
+    {L"\\hbox",    {TexTextFont::cFamilyRm, false, false}},
+    {L"\\jap",     {TexTextFont::cFamilyRm, false, false}},
+    {L"\\mbox",    {TexTextFont::cFamilyRm, false, false}},
+    {L"\\text",    {TexTextFont::cFamilyRm, false, false}},
+    {L"\\textbf",  {TexTextFont::cFamilyRm, true,  false}},
+    {L"\\textit",  {TexTextFont::cFamilyRm, false, true}},
+    {L"\\textrm",  {TexTextFont::cFamilyRm, false, false}},
+    {L"\\textsf",  {TexTextFont::cFamilySf, false, false}},
+    {L"\\texttt",  {TexTextFont::cFamilyTt, false, false}}
+};
+
+
 auto_ptr<LayoutTree::Node> EnterTextMode::BuildLayoutTree(
     const TexProcessingState& state
 ) const
 {
-    // List of all commands that launch into text mode, and some information
-    // about which font they select.
-    static pair<wstring, TexTextFont> textCommandArray[] =
-    {                                             // flags are:     bold?  italic?
-        make_pair(L"\\mbox",    TexTextFont(TexTextFont::cFamilyRm, false, false)),
-        make_pair(L"\\hbox",    TexTextFont(TexTextFont::cFamilyRm, false, false)),
-        make_pair(L"\\text",    TexTextFont(TexTextFont::cFamilyRm, false, false)),
-        make_pair(L"\\textrm",  TexTextFont(TexTextFont::cFamilyRm, false, false)),
-        make_pair(L"\\textbf",  TexTextFont(TexTextFont::cFamilyRm, true,  false)),
-        make_pair(L"\\emph",    TexTextFont(TexTextFont::cFamilyRm, false, true)),
-        make_pair(L"\\textit",  TexTextFont(TexTextFont::cFamilyRm, false, true)),
-        make_pair(L"\\textsf",  TexTextFont(TexTextFont::cFamilySf, false, false)),
-        make_pair(L"\\texttt",  TexTextFont(TexTextFont::cFamilyTt, false, false)),
-        make_pair(L"\\cyr",     TexTextFont(TexTextFont::cFamilyRm, false, false)),
-        make_pair(L"\\jap",     TexTextFont(TexTextFont::cFamilyRm, false, false))
-    };
-    static wishful_hash_map<wstring, TexTextFont> textCommandTable(
-        textCommandArray,
-        END_ARRAY(textCommandArray)
-    );
+    const TableEntry<TexTextFontEntry>* textCommand =
+        FindEntry(gTextCommandArray, mCommand);
 
-    wishful_hash_map<wstring, TexTextFont>::iterator
-        textCommand = textCommandTable.find(mCommand);
-
-    if (textCommand == textCommandTable.end())
+    if (!textCommand)
         throw logic_error(
             "Unexpected command in EnterTextMode::BuildLayoutTree"
         );
 
     TexProcessingState newState = state;
-    newState.mTextFont = textCommand->second;
+    newState.mTextFont = textCommand->mValue.GetFont();
     
     if (mCommand == L"\\hbox" || mCommand == L"\\mbox")
         newState.mStyle = LayoutTree::Node::cStyleText;
@@ -1144,7 +1114,7 @@ auto_ptr<LayoutTree::Node> TextList::BuildLayoutTree(
     // Recursively build layout trees for children, and merge Rows to obtain
     // a single Row, and apply state changes as appropriate.
     TexProcessingState currentState = state;
-    for (vector<TextNode*>::const_iterator
+    for (TextNodeVector::const_iterator
         child = mChildren.begin();
         child != mChildren.end();
         child++
@@ -1177,53 +1147,61 @@ auto_ptr<LayoutTree::Node> TextList::BuildLayoutTree(
 }
 
 
+static const TableEntry<const wchar_t*> gTextSymbolArray[] =
+{
+    {L" ",                  L"\U000000A0"},     // NonBreakingSpace
+    // FIX: why did I put in these next two lines again?
+    // FIX: The character "<" and ">" actually do funny things in TeX...
+    {L"<",                  L"<"},
+    {L">",                  L">"},
+    {L"\\ ",                L"\U000000A0"},
+    {L"\\!",                L""},
+    {L"\\#",                L"#"},
+    {L"\\$",                L"$"},
+    {L"\\%",                L"%"},
+    {L"\\&",                L"&"},
+    {L"\\,",                L"\U000000A0"},
+    {L"\\;",                L"\U000000A0"},
+    {L"\\O",                L"\U000000D8"},
+    {L"\\S",                L"\U000000A7"},
+    {L"\\_",                L"_"},
+    {L"\\qquad",            L"\U000000A0\U000000A0\U000000A0\U000000A0"},
+    {L"\\quad",             L"\U000000A0\U000000A0"},
+    // FIX: for some reason in Firefox the caret is much lower
+    // than it should be
+    {L"\\textasciicircum",  L"^"},
+    {L"\\textasciitilde",   L"~"},
+    {L"\\textbackslash",    L"\\"},
+    {L"\\textvisiblespace", L"\U000023B5"},
+    {L"\\{",                L"{"},
+    {L"\\}",                L"}"},
+    {L"~",                  L"\U000000A0"}
+};
+
+// Stops blahtex at startup if any of the tables in this file has been
+// edited out of order (see TableEntry in Misc.h).
+const bool gTablesChecked =
+    CheckTableOrder(gDelimiterArray, "gDelimiterArray") &&
+    CheckTableOrder(gFlavourCommandArray, "gFlavourCommandArray") &&
+    CheckTableOrder(gFontCommandArray, "gFontCommandArray") &&
+    CheckTableOrder(gAccentCommandArray, "gAccentCommandArray") &&
+    CheckTableOrder(gBigCommandArray, "gBigCommandArray") &&
+    CheckTableOrder(gEnvironmentArray, "gEnvironmentArray") &&
+    CheckTableOrder(gTextCommandArray, "gTextCommandArray") &&
+    CheckTableOrder(gTextSymbolArray, "gTextSymbolArray");
+
+
 auto_ptr<LayoutTree::Node> TextSymbol::BuildLayoutTree(
     const TexProcessingState& state
 ) const
 {
-    static pair<wstring, wstring> textCommandArray[] =
-    {
-        make_pair(L"\\!",      L""),
-        make_pair(L" ",        L"\U000000A0"),     // NonBreakingSpace
-        make_pair(L"~",        L"\U000000A0"),
-        make_pair(L"\\,",      L"\U000000A0"),
-        make_pair(L"\\ ",      L"\U000000A0"),
-        make_pair(L"\\;",      L"\U000000A0"),
-        make_pair(L"\\quad",   L"\U000000A0\U000000A0"),
-        make_pair(L"\\qquad",  L"\U000000A0\U000000A0\U000000A0\U000000A0"),
-
-        make_pair(L"\\&",                 L"&"),
-        // FIX: why did I put in these next two lines again?
-        // FIX: The character "<" and ">" actually do funny things in TeX...
-        make_pair(L"<",                   L"<"),
-        make_pair(L">",                   L">"),
-        make_pair(L"\\_",                 L"_"),
-        make_pair(L"\\$",                 L"$"),
-        make_pair(L"\\#",                 L"#"),
-        make_pair(L"\\%",                 L"%"),
-        make_pair(L"\\{",                 L"{"),
-        make_pair(L"\\}",                 L"}"),
-        make_pair(L"\\textbackslash",     L"\\"),
-        // FIX: for some reason in Firefox the caret is much lower
-        // than it should be
-        make_pair(L"\\textasciicircum",   L"^"),
-        make_pair(L"\\textasciitilde",    L"~"),
-        make_pair(L"\\textvisiblespace",  L"\U000023B5"),
-        make_pair(L"\\O",                 L"\U000000D8"),
-        make_pair(L"\\S",                 L"\U000000A7")
-    };
-    static wishful_hash_map<wstring, wstring> textCommandTable(
-        textCommandArray,
-        END_ARRAY(textCommandArray)
-    );
-
-    wishful_hash_map<wstring, wstring>::iterator
-        textCommand = textCommandTable.find(mCommand);
+    const TableEntry<const wchar_t*>* textCommand =
+        FindEntry(gTextSymbolArray, mCommand);
 
-    if (textCommand != textCommandTable.end())
+    if (textCommand)
         return auto_ptr<LayoutTree::Node>(
             new LayoutTree::SymbolText(
-                textCommand->second,
+                textCommand->mValue,
                 state.mTextFont.GetMathmlApproximation(),
                 state.mStyle,
                 state.mColour
@@ -18,633 +18,694 @@
 // along with this program; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
+#include <cwchar>
 #include <stdexcept>
 #include "ParseTree.h"
+#include "XmlEncode.h"
 
 using namespace std;
 
 namespace blahtex
 {
 
-pair<wstring, wchar_t> lowercaseGreekArray[] =
+const TableEntry<wchar_t> lowercaseGreekArray[] =
 {
-    make_pair(L"\\alpha",      L'\U000003B1'),
-    make_pair(L"\\beta",       L'\U000003B2'),
-    make_pair(L"\\gamma",      L'\U000003B3'),
-    make_pair(L"\\delta",      L'\U000003B4'),
-    make_pair(L"\\epsilon",    L'\U000003F5'),  // straightepsilon
-    make_pair(L"\\varepsilon", L'\U000003B5'),  // varepsilon
-    make_pair(L"\\zeta",       L'\U000003B6'),
-    make_pair(L"\\eta",        L'\U000003B7'),
-    make_pair(L"\\theta",      L'\U000003B8'),
-    make_pair(L"\\vartheta",   L'\U000003D1'),
-    make_pair(L"\\iota",       L'\U000003B9'),
-    make_pair(L"\\kappa",      L'\U000003BA'),
-    make_pair(L"\\varkappa",   L'\U000003F0'),
-    make_pair(L"\\lambda",     L'\U000003BB'),
-    make_pair(L"\\mu",         L'\U000003BC'),
-    make_pair(L"\\nu",         L'\U000003BD'),
-    make_pair(L"\\pi",         L'\U000003C0'),
-    make_pair(L"\\varpi",      L'\U000003D6'),
-    make_pair(L"\\rho",        L'\U000003C1'),
-    make_pair(L"\\varrho",     L'\U000003F1'),
-    make_pair(L"\\sigma",      L'\U000003C3'),
-    make_pair(L"\\varsigma",   L'\U000003C2'),
-    make_pair(L"\\tau",        L'\U000003C4'),
-    make_pair(L"\\upsilon",    L'\U000003C5'),
-    make_pair(L"\\phi",        L'\U000003D5'),  // straightphi
-    make_pair(L"\\varphi",     L'\U000003C6'),
-    make_pair(L"\\chi",        L'\U000003C7'),
-    make_pair(L"\\psi",        L'\U000003C8'),
-    make_pair(L"\\omega",      L'\U000003C9'),
-    make_pair(L"\\xi",         L'\U000003BE'),
-    make_pair(L"\\digamma",    L'\U000003DD')
+    {L"\\alpha",      L'\U000003B1'},
+    {L"\\beta",       L'\U000003B2'},
+    {L"\\chi",        L'\U000003C7'},
+    {L"\\delta",      L'\U000003B4'},
+    {L"\\digamma",    L'\U000003DD'},
+    {L"\\epsilon",    L'\U000003F5'},  // straightepsilon
+    {L"\\eta",        L'\U000003B7'},
+    {L"\\gamma",      L'\U000003B3'},
+    {L"\\iota",       L'\U000003B9'},
+    {L"\\kappa",      L'\U000003BA'},
+    {L"\\lambda",     L'\U000003BB'},
+    {L"\\mu",         L'\U000003BC'},
+    {L"\\nu",         L'\U000003BD'},
+    {L"\\omega",      L'\U000003C9'},
+    {L"\\phi",        L'\U000003D5'},  // straightphi
+    {L"\\pi",         L'\U000003C0'},
+    {L"\\psi",        L'\U000003C8'},
+    {L"\\rho",        L'\U000003C1'},
+    {L"\\sigma",      L'\U000003C3'},
+    {L"\\tau",        L'\U000003C4'},
+    {L"\\theta",      L'\U000003B8'},
+    {L"\\upsilon",    L'\U000003C5'},
+    {L"\\varepsilon", L'\U000003B5'},  // varepsilon
+    {L"\\varkappa",   L'\U000003F0'},
+    {L"\\varphi",     L'\U000003C6'},
+    {L"\\varpi",      L'\U000003D6'},
+    {L"\\varrho",     L'\U000003F1'},
+    {L"\\varsigma",   L'\U000003C2'},
+    {L"\\vartheta",   L'\U000003D1'},
+    {L"\\xi",         L'\U000003BE'},
+    {L"\\zeta",       L'\U000003B6'}
 };
-wishful_hash_map<wstring, wchar_t> lowercaseGreekTable(
-    lowercaseGreekArray,
-    END_ARRAY(lowercaseGreekArray)
-);
 
 
-pair<wstring, wchar_t> uppercaseGreekArray[] =
+const TableEntry<wchar_t> uppercaseGreekArray[] =
 {
-    make_pair(L"\\Gamma",     L'\U00000393'),
-    make_pair(L"\\Delta",     L'\U00000394'),
-    make_pair(L"\\Theta",     L'\U00000398'),
-    make_pair(L"\\Lambda",    L'\U0000039B'),
-    make_pair(L"\\Pi",        L'\U000003A0'),
-    make_pair(L"\\Sigma",     L'\U000003A3'),
-    make_pair(L"\\Upsilon",   L'\U000003A5'),
-    make_pair(L"\\Phi",       L'\U000003A6'),
-    make_pair(L"\\Psi",       L'\U000003A8'),
-    make_pair(L"\\Omega",     L'\U000003A9'),
-    make_pair(L"\\Xi",        L'\U0000039E')
+    {L"\\Delta",     L'\U00000394'},
+    {L"\\Gamma",     L'\U00000393'},
+    {L"\\Lambda",    L'\U0000039B'},
+    {L"\\Omega",     L'\U000003A9'},
+    {L"\\Phi",       L'\U000003A6'},
+    {L"\\Pi",        L'\U000003A0'},
+    {L"\\Psi",       L'\U000003A8'},
+    {L"\\Sigma",     L'\U000003A3'},
+    {L"\\Theta",     L'\U00000398'},
+    {L"\\Upsilon",   L'\U000003A5'},
+    {L"\\Xi",        L'\U0000039E'}
 };
-wishful_hash_map<wstring, wchar_t> uppercaseGreekTable(
-    uppercaseGreekArray,
-    END_ARRAY(uppercaseGreekArray)
-);
 
 
-pair<wstring, int> spaceArray[] =
+const TableEntry<int> spaceArray[] =
 {
-    make_pair(L"\\!",       -3),
-    make_pair(L"\\,",       3),
-    make_pair(L"\\>",       4),
-    make_pair(L"\\;",       5),
-    make_pair(L"\\quad",    18),
-    make_pair(L"\\qquad",   36),
-    // These last two aren't quite right, but hopefully they're close
+    {L"\\ ",       6},      // not quite right; see "~" below
+    {L"\\!",       -3},
+    {L"\\,",       3},
+    {L"\\;",       5},
+    {L"\\>",       4},
+    {L"\\qquad",   36},
+    {L"\\quad",    18},
+    // This and "\ " aren't quite right, but hopefully they're close
     // enough. TeX's rules are too complicated for me to care :-)
-    make_pair(L"~",         6),
-    make_pair(L"\\ ",       6)
+    {L"~",         6}
 };
-wishful_hash_map<wstring, int> spaceTable(
-    spaceArray,
-    END_ARRAY(spaceArray)
-);
 
 
 struct OperatorInfo
 {
-    wstring mText;
+    const wchar_t* mText;
     LayoutTree::Node::Flavour mFlavour;
-    LayoutTree::Node::Limits mLimits;
 
-    OperatorInfo(
-        const wstring& text,
-        LayoutTree::Node::Flavour flavour,
-        LayoutTree::Node::Limits limits =
-            LayoutTree::Node::cLimitsDisplayLimits
-    ) :
-        mText(text),
-        mFlavour(flavour),
-        mLimits(limits)
-    { }
+    // Entries which leave this out get cLimitsDisplayLimits (zero).
+    LayoutTree::Node::Limits mLimits;
 };
 
 // Here is a list of all commands that get translated as operators,
 // together with their MathML translation and flavour.
-pair<wstring, OperatorInfo> operatorArray[] =
+//
+// FIX: the correct MathML characters for the long arrows are
+//     \longleftarrow         0x27F5
+//     \longrightarrow        0x27F6
+//     \Longleftarrow         0x27F8
+//     \Longrightarrow        0x27F9
+//     \longmapsto            0x27FC
+//     \longleftrightarrow    0x27F7
+//     \Longleftrightarrow    0x27FA
+// They seem to be missing in the fonts currently shipped with Firefox, so
+// we just map them to their short counterparts for the moment. (Perhaps
+// it's possible to do this with the "stretchy" attribute instead?)
+//
+// FIX: the fonts shipped with Firefox 1.5 don't know about 0x2a2f
+// (&Cross;). So I'm mapping \times to 0xd7 (&times;) for now.
+const TableEntry<OperatorInfo> operatorArray[] =
 {
-    make_pair(L"(",                      OperatorInfo(L"(", LayoutTree::Node::cFlavourOpen)),
-    make_pair(L")",                      OperatorInfo(L")", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"[",                      OperatorInfo(L"[", LayoutTree::Node::cFlavourOpen)),
-    make_pair(L"]",                      OperatorInfo(L"]", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"<",                      OperatorInfo(L"<", LayoutTree::Node::cFlavourRel)),
-    make_pair(L">",                      OperatorInfo(L">", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"+",                      OperatorInfo(L"+", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"-",                      OperatorInfo(L"-", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"=",                      OperatorInfo(L"=", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"|",                      OperatorInfo(L"|", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L";",                      OperatorInfo(L";", LayoutTree::Node::cFlavourPunct)),
-    make_pair(L":",                      OperatorInfo(L":", LayoutTree::Node::cFlavourRel)),
-    make_pair(L",",                      OperatorInfo(L",", LayoutTree::Node::cFlavourPunct)),
-    make_pair(L".",                      OperatorInfo(L".", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"/",                      OperatorInfo(L"/", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"?",                      OperatorInfo(L"?", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"!",                      OperatorInfo(L"!", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"@",                      OperatorInfo(L"@", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"*",                      OperatorInfo(L"*", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\_",                    OperatorInfo(L"_", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\&",                    OperatorInfo(L"&", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\$",                    OperatorInfo(L"$", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\#",                    OperatorInfo(L"#", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\%",                    OperatorInfo(L"%", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\{",                    OperatorInfo(L"{", LayoutTree::Node::cFlavourOpen)),
-    make_pair(L"\\}",                    OperatorInfo(L"}", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"\\ast",                  OperatorInfo(L"*", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\lbrace",               OperatorInfo(L"{", LayoutTree::Node::cFlavourOpen)),
-    make_pair(L"\\rbrace",               OperatorInfo(L"}", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"\\vert",                 OperatorInfo(L"|", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\lvert",                OperatorInfo(L"|", LayoutTree::Node::cFlavourOpen)),
-    make_pair(L"\\rvert",                OperatorInfo(L"|", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"\\lbrack",               OperatorInfo(L"[", LayoutTree::Node::cFlavourOpen)),
-    make_pair(L"\\rbrack",               OperatorInfo(L"]", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"\\Vert",                 OperatorInfo(L"\U00002225", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\lVert",                OperatorInfo(L"\U00002225", LayoutTree::Node::cFlavourOpen)),
-    make_pair(L"\\rVert",                OperatorInfo(L"\U00002225", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"\\lfloor",               OperatorInfo(L"\U0000230A", LayoutTree::Node::cFlavourOpen)),
-    make_pair(L"\\rfloor",               OperatorInfo(L"\U0000230B", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"\\lceil",                OperatorInfo(L"\U00002308", LayoutTree::Node::cFlavourOpen)),
-    make_pair(L"\\rceil",                OperatorInfo(L"\U00002309", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"\\langle",               OperatorInfo(L"\U00002329", LayoutTree::Node::cFlavourOpen)),
-    make_pair(L"\\rangle",               OperatorInfo(L"\U0000232A", LayoutTree::Node::cFlavourClose)),
-    make_pair(L"\\forall",               OperatorInfo(L"\U00002200", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\exists",               OperatorInfo(L"\U00002203", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\leftarrow",            OperatorInfo(L"\U00002190", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\rightarrow",           OperatorInfo(L"\U00002192", LayoutTree::Node::cFlavourRel)),
-
-    // FIX: The first version below has the correct MathML characters.
-    // They seem to be missing in the fonts currently shipped with
-    // Firefox, so we just map them to their short counterparts (second
-    // version) for the moment.
-    // FIX: perhaps it's possible to do this with the "stretchy" attribute
-    // instead?
-#if 0
-    make_pair(L"\\longleftarrow",        OperatorInfo(L"\U000027F5", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\longrightarrow",       OperatorInfo(L"\U000027F6", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Longleftarrow",        OperatorInfo(L"\U000027F8", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Longrightarrow",       OperatorInfo(L"\U000027F9", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\longmapsto",           OperatorInfo(L"\U000027FC", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\longleftrightarrow",   OperatorInfo(L"\U000027F7", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Longleftrightarrow",   OperatorInfo(L"\U000027FA", LayoutTree::Node::cFlavourRel)),
-#else
-    make_pair(L"\\longleftarrow",        OperatorInfo(L"\U00002190", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\longrightarrow",       OperatorInfo(L"\U00002192", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Longleftarrow",        OperatorInfo(L"\U000021D0", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Longrightarrow",       OperatorInfo(L"\U000021D2", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\longmapsto",           OperatorInfo(L"\U000021A6", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\longleftrightarrow",   OperatorInfo(L"\U00002194", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Longleftrightarrow",   OperatorInfo(L"\U000021D4", LayoutTree::Node::cFlavourRel)),
-#endif
-
-    make_pair(L"\\Leftarrow",            OperatorInfo(L"\U000021D0", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Rightarrow",           OperatorInfo(L"\U000021D2", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\mapsto",               OperatorInfo(L"\U000021A6", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\leftrightarrow",       OperatorInfo(L"\U00002194", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Leftrightarrow",       OperatorInfo(L"\U000021D4", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\uparrow",              OperatorInfo(L"\U00002191", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Uparrow",              OperatorInfo(L"\U000021D1", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\downarrow",            OperatorInfo(L"\U00002193", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Downarrow",            OperatorInfo(L"\U000021D3", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\updownarrow",          OperatorInfo(L"\U00002195", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Updownarrow",          OperatorInfo(L"\U000021D5", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\searrow",              OperatorInfo(L"\U00002198", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nearrow",              OperatorInfo(L"\U00002197", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\swarrow",              OperatorInfo(L"\U00002199", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nwarrow",              OperatorInfo(L"\U00002196", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\hookrightarrow",       OperatorInfo(L"\U000021AA", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\hookleftarrow",        OperatorInfo(L"\U000021A9", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\upharpoonright",       OperatorInfo(L"\U000021BE", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\upharpoonleft",        OperatorInfo(L"\U000021BF", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\downharpoonright",     OperatorInfo(L"\U000021C2", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\downharpoonleft",      OperatorInfo(L"\U000021C3", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\rightharpoonup",       OperatorInfo(L"\U000021C0", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\rightharpoondown",     OperatorInfo(L"\U000021C1", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\leftharpoonup",        OperatorInfo(L"\U000021BC", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\leftharpoondown",      OperatorInfo(L"\U000021BD", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nleftarrow",           OperatorInfo(L"\U0000219A", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nrightarrow",          OperatorInfo(L"\U0000219B", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\supset",               OperatorInfo(L"\U00002283", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\subset",               OperatorInfo(L"\U00002282", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\supseteq",             OperatorInfo(L"\U00002287", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\subseteq",             OperatorInfo(L"\U00002286", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\sqsupset",             OperatorInfo(L"\U00002290", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\sqsubset",             OperatorInfo(L"\U0000228F", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\sqsupseteq",           OperatorInfo(L"\U00002292", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\sqsubseteq",           OperatorInfo(L"\U00002291", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\supsetneq",            OperatorInfo(L"\U0000228B", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\subsetneq",            OperatorInfo(L"\U0000228A", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\in",                   OperatorInfo(L"\U00002208", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ni",                   OperatorInfo(L"\U0000220B", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\notin",                OperatorInfo(L"\U00002209", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\mid",                  OperatorInfo(L"|",          LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\sim",                  OperatorInfo(L"\U0000223C", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\simeq",                OperatorInfo(L"\U00002243", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\approx",               OperatorInfo(L"\U00002248", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\propto",               OperatorInfo(L"\U0000221D", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\equiv",                OperatorInfo(L"\U00002261", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\cong",                 OperatorInfo(L"\U00002245", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\neq",                  OperatorInfo(L"\U00002260", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ll",                   OperatorInfo(L"\U0000226A", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\gg",                   OperatorInfo(L"\U0000226B", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\geq",                  OperatorInfo(L"\U00002265", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\leq",                  OperatorInfo(L"\U00002264", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\triangleleft",         OperatorInfo(L"\U000025C3", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\triangleright",        OperatorInfo(L"\U000025B9", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\models",               OperatorInfo(L"\U000022A7", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\vdash",                OperatorInfo(L"\U000022A2", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Vdash",                OperatorInfo(L"\U000022A9", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\vDash",                OperatorInfo(L"\U000022A8", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\lesssim",              OperatorInfo(L"\U00002272", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nless",                OperatorInfo(L"\U0000226E", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ngeq",                 OperatorInfo(L"\U00002271", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nleq",                 OperatorInfo(L"\U00002270", LayoutTree::Node::cFlavourRel)),
-
-    // FIX: the fonts shipped with Firefox 1.5 don't know about
-    // 0x2a2f (&Cross;). So I'm mapping it to 0xd7 (&times;) for now.
-#if 0
-    make_pair(L"\\times",                OperatorInfo(L"\U00002A2F", LayoutTree::Node::cFlavourBin)),
-#else
-    make_pair(L"\\times",                OperatorInfo(L"\U000000D7", LayoutTree::Node::cFlavourBin)),
-#endif
-
-    make_pair(L"\\div",                  OperatorInfo(L"\U000000F7", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\wedge",                OperatorInfo(L"\U00002227", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\vee",                  OperatorInfo(L"\U00002228", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\oplus",                OperatorInfo(L"\U00002295", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\otimes",               OperatorInfo(L"\U00002297", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\cap",                  OperatorInfo(L"\U00002229", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\cup",                  OperatorInfo(L"\U0000222A", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\sqcap",                OperatorInfo(L"\U00002293", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\sqcup",                OperatorInfo(L"\U00002294", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\smile",                OperatorInfo(L"\U00002323", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\frown",                OperatorInfo(L"\U00002322", LayoutTree::Node::cFlavourRel)),
-    // FIX: how to make these smiles/frowns smaller?
-    make_pair(L"\\smallsmile",           OperatorInfo(L"\U00002323", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\smallfrown",           OperatorInfo(L"\U00002322", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\setminus",             OperatorInfo(L"\U00002216", LayoutTree::Node::cFlavourBin)),
-    // FIX: how to make smallsetminus smaller?
-    make_pair(L"\\smallsetminus",        OperatorInfo(L"\U00002216", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\star",                 OperatorInfo(L"\U000022C6", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\triangle",             OperatorInfo(L"\U000025B3", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\wr",                   OperatorInfo(L"\U00002240", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\circ",                 OperatorInfo(L"\U00002218", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\lnot",                 OperatorInfo(L"\U000000AC", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\nabla",                OperatorInfo(L"\U00002207", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\prime",                OperatorInfo(L"\U00002032", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\backslash",            OperatorInfo(L"\U00002216", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\pm",                   OperatorInfo(L"\U000000B1", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\mp",                   OperatorInfo(L"\U00002213", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\angle",                OperatorInfo(L"\U00002220", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\nmid",                 OperatorInfo(L"\U00002224", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\square",               OperatorInfo(L"\U000025A1", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\Box",                  OperatorInfo(L"\U000025A1", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\checkmark",            OperatorInfo(L"\U00002713", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\complement",           OperatorInfo(L"\U00002201", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\flat",                 OperatorInfo(L"\U0000266D", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\sharp",                OperatorInfo(L"\U0000266F", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\natural",              OperatorInfo(L"\U0000266E", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\bullet",               OperatorInfo(L"\U00002022", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\dagger",               OperatorInfo(L"\U00002020", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\ddagger",              OperatorInfo(L"\U00002021", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\clubsuit",             OperatorInfo(L"\U00002663", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\spadesuit",            OperatorInfo(L"\U00002660", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\heartsuit",            OperatorInfo(L"\U00002665", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\diamondsuit",          OperatorInfo(L"\U00002666", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\top",                  OperatorInfo(L"\U000022A4", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\bot",                  OperatorInfo(L"\U000022A5", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\perp",                 OperatorInfo(L"\U000022A5", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\cdot",                 OperatorInfo(L"\U000022C5", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\vdots",                OperatorInfo(L"\U000022EE", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\ddots",                OperatorInfo(L"\U000022F1", LayoutTree::Node::cFlavourInner)),
-    make_pair(L"\\cdots",                OperatorInfo(L"\U000022EF", LayoutTree::Node::cFlavourInner)),
-    make_pair(L"\\ldots",                OperatorInfo(L"\U00002026", LayoutTree::Node::cFlavourInner)),
-    // FIX: these next two aren't right. The amsmath package does tricky
-    // things so that the dots change their vertical position depending
-    // on the surrounding operators. We chicken out and just map them
-    // to the same as \cdots and \ldots respectively.
-    make_pair(L"\\dotsb",                OperatorInfo(L"\U000022EF", LayoutTree::Node::cFlavourInner)),
-    make_pair(L"\\dots",                 OperatorInfo(L"\U00002026", LayoutTree::Node::cFlavourInner)),
-    make_pair(L"\\sum",                  OperatorInfo(L"\U00002211", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\prod",                 OperatorInfo(L"\U0000220F", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\int",                  OperatorInfo(L"\U0000222B", LayoutTree::Node::cFlavourOp, LayoutTree::Node::cLimitsNoLimits)),
-    make_pair(L"\\iint",                 OperatorInfo(L"\U0000222C", LayoutTree::Node::cFlavourOp, LayoutTree::Node::cLimitsNoLimits)),
-    make_pair(L"\\iiint",                OperatorInfo(L"\U0000222D", LayoutTree::Node::cFlavourOp, LayoutTree::Node::cLimitsNoLimits)),
-    make_pair(L"\\iiiint",               OperatorInfo(L"\U00002A0C", LayoutTree::Node::cFlavourOp, LayoutTree::Node::cLimitsNoLimits)),
-    make_pair(L"\\oint",                 OperatorInfo(L"\U0000222E", LayoutTree::Node::cFlavourOp, LayoutTree::Node::cLimitsNoLimits)),
-    make_pair(L"\\bigcap",               OperatorInfo(L"\U000022C2", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\bigodot",              OperatorInfo(L"\U00002A00", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\bigcup",               OperatorInfo(L"\U000022C3", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\bigotimes",            OperatorInfo(L"\U00002A02", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\coprod",               OperatorInfo(L"\U00002210", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\bigsqcup",             OperatorInfo(L"\U00002A06", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\bigoplus",             OperatorInfo(L"\U00002A01", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\bigvee",               OperatorInfo(L"\U000022C1", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\biguplus",             OperatorInfo(L"\U00002A04", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\bigwedge",             OperatorInfo(L"\U000022C0", LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\ulcorner",             OperatorInfo(L"\U0000231C", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\urcorner",             OperatorInfo(L"\U0000231D", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\llcorner",             OperatorInfo(L"\U0000231E", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\lrcorner",             OperatorInfo(L"\U0000231F", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\dashrightarrow",       OperatorInfo(L"\U0000290F", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\dashleftarrow",        OperatorInfo(L"\U0000290E", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\backprime",            OperatorInfo(L"\U00002035", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\vartriangle",          OperatorInfo(L"\U000025B5", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\blacktriangle",        OperatorInfo(L"\U000025B4", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\triangledown",         OperatorInfo(L"\U000025BF", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\blacktriangledown",    OperatorInfo(L"\U000025BE", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\blacksquare",          OperatorInfo(L"\U000025FC", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\lozenge",              OperatorInfo(L"\U000025CA", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\blacklozenge",         OperatorInfo(L"\U000029EB", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\bigstar",              OperatorInfo(L"\U00002605", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\sphericalangle",       OperatorInfo(L"\U00002222", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\measuredangle",        OperatorInfo(L"\U00002221", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\dotplus",              OperatorInfo(L"\U00002214", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\ltimes",               OperatorInfo(L"\U000022C9", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\rtimes",               OperatorInfo(L"\U000022CA", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\Cap",                  OperatorInfo(L"\U000022D2", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\leftthreetimes",       OperatorInfo(L"\U000022CB", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\rightthreetimes",      OperatorInfo(L"\U000022CC", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\Cup",                  OperatorInfo(L"\U000022D3", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\barwedge",             OperatorInfo(L"\U00002305", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\curlywedge",           OperatorInfo(L"\U000022CF", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\veebar",               OperatorInfo(L"\U000022BB", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\curlyvee",             OperatorInfo(L"\U000022CE", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\doublebarwedge",       OperatorInfo(L"\U00002306", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\boxminus",             OperatorInfo(L"\U0000229F", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\circleddash",          OperatorInfo(L"\U0000229D", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\boxtimes",             OperatorInfo(L"\U000022A0", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\circledast",           OperatorInfo(L"\U0000229B", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\boxdot",               OperatorInfo(L"\U000022A1", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\circledcirc",          OperatorInfo(L"\U0000229A", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\boxplus",              OperatorInfo(L"\U0000229E", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\centerdot",            OperatorInfo(L"\U000022C5", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\divideontimes",        OperatorInfo(L"\U000022C7", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\intercal",             OperatorInfo(L"\U000022BA", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\leqq",                 OperatorInfo(L"\U00002266", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\geqq",                 OperatorInfo(L"\U00002267", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\leqslant",             OperatorInfo(L"\U00002A7D", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\geqslant",             OperatorInfo(L"\U00002A7E", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\eqslantless",          OperatorInfo(L"\U00002A95", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\eqslantgtr",           OperatorInfo(L"\U00002A96", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\gtrsim",               OperatorInfo(L"\U00002273", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\lessapprox",           OperatorInfo(L"\U00002A85", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\gtrapprox",            OperatorInfo(L"\U00002A86", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\approxeq",             OperatorInfo(L"\U0000224A", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\eqsim",                OperatorInfo(L"\U00002242", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\lessdot",              OperatorInfo(L"\U000022D6", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\gtrdot",               OperatorInfo(L"\U000022D7", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\lll",                  OperatorInfo(L"\U000022D8", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ggg",                  OperatorInfo(L"\U000022D9", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\lessgtr",              OperatorInfo(L"\U00002276", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\gtrless",              OperatorInfo(L"\U00002277", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\lesseqgtr",            OperatorInfo(L"\U000022DA", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\gtreqless",            OperatorInfo(L"\U000022DB", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\lesseqqgtr",           OperatorInfo(L"\U00002A8B", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\gtreqqless",           OperatorInfo(L"\U00002A8C", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\doteqdot",             OperatorInfo(L"\U00002251", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\eqcirc",               OperatorInfo(L"\U00002256", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\risingdotseq",         OperatorInfo(L"\U00002253", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\circeq",               OperatorInfo(L"\U00002257", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\fallingdotseq",        OperatorInfo(L"\U00002252", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\triangleq",            OperatorInfo(L"\U0000225C", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\backsim",              OperatorInfo(L"\U0000223D", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\thicksim",             OperatorInfo(L"\U0000223C", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\backsimeq",            OperatorInfo(L"\U000022CD", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\thickapprox",          OperatorInfo(L"\U00002248", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\subseteqq",            OperatorInfo(L"\U00002AC5", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\supseteqq",            OperatorInfo(L"\U00002AC6", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Subset",               OperatorInfo(L"\U000022D0", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Supset",               OperatorInfo(L"\U000022D1", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\preccurlyeq",          OperatorInfo(L"\U0000227C", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\succcurlyeq",          OperatorInfo(L"\U0000227D", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\curlyeqprec",          OperatorInfo(L"\U000022DE", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\curlyeqsucc",          OperatorInfo(L"\U000022DF", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\precsim",              OperatorInfo(L"\U0000227E", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\succsim",              OperatorInfo(L"\U0000227F", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\precapprox",           OperatorInfo(L"\U00002AB7", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\succapprox",           OperatorInfo(L"\U00002AB8", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Vvdash",               OperatorInfo(L"\U000022AA", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\shortmid",             OperatorInfo(L"\U00002223", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\shortparallel",        OperatorInfo(L"\U00002225", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\bumpeq",               OperatorInfo(L"\U0000224F", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\between",              OperatorInfo(L"\U0000226C", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Bumpeq",               OperatorInfo(L"\U0000224E", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\varpropto",            OperatorInfo(L"\U0000221D", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\backepsilon",          OperatorInfo(L"\U000003F6", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\blacktriangleleft",    OperatorInfo(L"\U000025C0", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\blacktriangleright",   OperatorInfo(L"\U000025B6", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\therefore",            OperatorInfo(L"\U00002234", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\because",              OperatorInfo(L"\U00002235", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ngtr",                 OperatorInfo(L"\U0000226F", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nleqslant",            OperatorInfo(L"\U00002A7D\U00000338", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ngeqslant",            OperatorInfo(L"\U00002A7E\U00000338", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nleqq",                OperatorInfo(L"\U00002266\U00000338", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ngeqq",                OperatorInfo(L"\U00002267\U00000338", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\lneqq",                OperatorInfo(L"\U00002268", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\gneqq",                OperatorInfo(L"\U00002269", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\lvertneqq",            OperatorInfo(L"\U00002268\U0000FE00", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\gvertneqq",            OperatorInfo(L"\U00002269\U0000FE00", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\lnsim",                OperatorInfo(L"\U000022E6", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\gnsim",                OperatorInfo(L"\U000022E7", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\lnapprox",             OperatorInfo(L"\U00002A89", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\gnapprox",             OperatorInfo(L"\U00002A8A", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nprec",                OperatorInfo(L"\U00002280", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nsucc",                OperatorInfo(L"\U00002281", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\npreceq",              OperatorInfo(L"\U00002AAF\U00000338", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nsucceq",              OperatorInfo(L"\U00002AB0\U00000338", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\precneqq",             OperatorInfo(L"\U00002AB5", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\succneqq",             OperatorInfo(L"\U00002AB6", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\precnsim",             OperatorInfo(L"\U000022E8", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\succnsim",             OperatorInfo(L"\U000022E9", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\precnapprox",          OperatorInfo(L"\U00002AB9", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\succnapprox",          OperatorInfo(L"\U00002ABA", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nsim",                 OperatorInfo(L"\U00002241", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ncong",                OperatorInfo(L"\U00002247", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nshortmid",            OperatorInfo(L"\U00002224", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nshortparallel",       OperatorInfo(L"\U00002226", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nmid",                 OperatorInfo(L"\U00002224", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nparallel",            OperatorInfo(L"\U00002226", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nvdash",               OperatorInfo(L"\U000022AC", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nvDash",               OperatorInfo(L"\U000022AD", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nVdash",               OperatorInfo(L"\U000022AE", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nVDash",               OperatorInfo(L"\U000022AF", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ntriangleleft",        OperatorInfo(L"\U000022EA", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ntriangleright",       OperatorInfo(L"\U000022EB", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ntrianglelefteq",      OperatorInfo(L"\U000022EC", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\ntrianglerighteq",     OperatorInfo(L"\U000022ED", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nsubseteq",            OperatorInfo(L"\U00002288", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nsupseteq",            OperatorInfo(L"\U00002289", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nsubseteqq",           OperatorInfo(L"\U00002AC5\U00000338", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nsupseteqq",           OperatorInfo(L"\U00002AC6\U00000338", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\subsetneq",            OperatorInfo(L"\U0000228A", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\supsetneq",            OperatorInfo(L"\U0000228B", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\varsubsetneq",         OperatorInfo(L"\U0000228A\U0000FE00", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\varsupsetneq",         OperatorInfo(L"\U0000228B\U0000FE00", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\subsetneqq",           OperatorInfo(L"\U00002ACB", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\supsetneqq",           OperatorInfo(L"\U00002ACC", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\varsubsetneqq",        OperatorInfo(L"\U00002ACB\U0000FE00", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\varsupsetneqq",        OperatorInfo(L"\U00002ACC\U0000FE00", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\leftleftarrows",       OperatorInfo(L"\U000021C7", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\rightrightarrows",     OperatorInfo(L"\U000021C9", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\leftrightarrows",      OperatorInfo(L"\U000021C6", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\rightleftarrows",      OperatorInfo(L"\U000021C4", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Lleftarrow",           OperatorInfo(L"\U000021DA", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Rrightarrow",          OperatorInfo(L"\U000021DB", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\twoheadleftarrow",     OperatorInfo(L"\U0000219E", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\twoheadrightarrow",    OperatorInfo(L"\U000021A0", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\leftarrowtail",        OperatorInfo(L"\U000021A2", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\rightarrowtail",       OperatorInfo(L"\U000021A3", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\looparrowleft",        OperatorInfo(L"\U000021AB", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\looparrowright",       OperatorInfo(L"\U000021AC", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\leftrightharpoons",    OperatorInfo(L"\U000021CB", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\rightleftharpoons",    OperatorInfo(L"\U000021CC", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\curvearrowleft",       OperatorInfo(L"\U000021B6", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\curvearrowright",      OperatorInfo(L"\U000021B7", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\circlearrowleft",      OperatorInfo(L"\U000021BA", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\circlearrowright",     OperatorInfo(L"\U000021BB", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Lsh",                  OperatorInfo(L"\U000021B0", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\Rsh",                  OperatorInfo(L"\U000021B1", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\upuparrows",           OperatorInfo(L"\U000021C8", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\downdownarrows",       OperatorInfo(L"\U000021CA", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\multimap",             OperatorInfo(L"\U000022B8", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\rightsquigarrow",      OperatorInfo(L"\U0000219D", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\leftrightsquigarrow",  OperatorInfo(L"\U000021AD", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nLeftarrow",           OperatorInfo(L"\U000021CD", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nRightarrow",          OperatorInfo(L"\U000021CF", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nleftrightarrow",      OperatorInfo(L"\U000021AE", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nLeftrightarrow",      OperatorInfo(L"\U000021CE", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\pitchfork",            OperatorInfo(L"\U000022D4", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\nexists",              OperatorInfo(L"\U00002204", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\lhd",                  OperatorInfo(L"\U000022B2", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\rhd",                  OperatorInfo(L"\U000022B3", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\unlhd",                OperatorInfo(L"\U000022B4", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\unrhd",                OperatorInfo(L"\U000022B5", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\leadsto",              OperatorInfo(L"\U000021DD", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\uplus",                OperatorInfo(L"\U0000228E", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\diamond",              OperatorInfo(L"\U000022C4", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\bigtriangleup",        OperatorInfo(L"\U000025B3", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\bigtriangledown",      OperatorInfo(L"\U000025BD", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\ominus",               OperatorInfo(L"\U00002296", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\oslash",               OperatorInfo(L"\U00002298", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\odot",                 OperatorInfo(L"\U00002299", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\bigcirc",              OperatorInfo(L"\U000025EF", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\amalg",                OperatorInfo(L"\U00002A3F", LayoutTree::Node::cFlavourBin)),
-    make_pair(L"\\prec",                 OperatorInfo(L"\U0000227A", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\succ",                 OperatorInfo(L"\U0000227B", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\preceq",               OperatorInfo(L"\U00002AAF", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\succeq",               OperatorInfo(L"\U00002AB0", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\dashv",                OperatorInfo(L"\U000022A3", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\asymp",                OperatorInfo(L"\U00002248", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\doteq",                OperatorInfo(L"\U00002250", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\parallel",             OperatorInfo(L"\U00002225", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\bowtie",               OperatorInfo(L"\U000022C8", LayoutTree::Node::cFlavourRel)),
-    make_pair(L"\\surd",                 OperatorInfo(L"\U0000221A", LayoutTree::Node::cFlavourOrd)),
-
-    make_pair(L"\\lim",                  OperatorInfo(L"lim",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\sup",                  OperatorInfo(L"sup",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\inf",                  OperatorInfo(L"inf",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\min",                  OperatorInfo(L"min",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\max",                  OperatorInfo(L"max",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\gcd",                  OperatorInfo(L"gcd",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\det",                  OperatorInfo(L"det",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\Pr",                   OperatorInfo(L"Pr",         LayoutTree::Node::cFlavourOp)),
-    // FIX: the space between the words in these operators is maybe a tiny bit too big.
-    make_pair(L"\\limsup",               OperatorInfo(L"lim sup",    LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\liminf",               OperatorInfo(L"lim inf",    LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\injlim",               OperatorInfo(L"inj lim",    LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\projlim",              OperatorInfo(L"proj lim",   LayoutTree::Node::cFlavourOp)),
-    
+    {L"!",                      {L"!", LayoutTree::Node::cFlavourClose}},
+    {L"(",                      {L"(", LayoutTree::Node::cFlavourOpen}},
+    {L")",                      {L")", LayoutTree::Node::cFlavourClose}},
+    {L"*",                      {L"*", LayoutTree::Node::cFlavourBin}},
+    {L"+",                      {L"+", LayoutTree::Node::cFlavourBin}},
+    {L",",                      {L",", LayoutTree::Node::cFlavourPunct}},
+    {L"-",                      {L"-", LayoutTree::Node::cFlavourBin}},
+    {L".",                      {L".", LayoutTree::Node::cFlavourOrd}},
+    {L"/",                      {L"/", LayoutTree::Node::cFlavourOrd}},
+    {L":",                      {L":", LayoutTree::Node::cFlavourRel}},
+    {L";",                      {L";", LayoutTree::Node::cFlavourPunct}},
+    {L"<",                      {L"<", LayoutTree::Node::cFlavourRel}},
+    {L"=",                      {L"=", LayoutTree::Node::cFlavourRel}},
+    {L">",                      {L">", LayoutTree::Node::cFlavourRel}},
+    {L"?",                      {L"?", LayoutTree::Node::cFlavourClose}},
+    {L"@",                      {L"@", LayoutTree::Node::cFlavourOrd}},
+    {L"[",                      {L"[", LayoutTree::Node::cFlavourOpen}},
+    {L"\\#",                    {L"#", LayoutTree::Node::cFlavourOrd}},
+    {L"\\$",                    {L"$", LayoutTree::Node::cFlavourOrd}},
+    {L"\\%",                    {L"%", LayoutTree::Node::cFlavourOrd}},
+    {L"\\&",                    {L"&", LayoutTree::Node::cFlavourOrd}},
+    {L"\\Box",                  {L"\U000025A1", LayoutTree::Node::cFlavourOrd}},
+    {L"\\Bumpeq",               {L"\U0000224E", LayoutTree::Node::cFlavourRel}},
+    {L"\\Cap",                  {L"\U000022D2", LayoutTree::Node::cFlavourBin}},
+    {L"\\Cup",                  {L"\U000022D3", LayoutTree::Node::cFlavourBin}},
+    {L"\\Downarrow",            {L"\U000021D3", LayoutTree::Node::cFlavourRel}},
+    {L"\\Leftarrow",            {L"\U000021D0", LayoutTree::Node::cFlavourRel}},
+    {L"\\Leftrightarrow",       {L"\U000021D4", LayoutTree::Node::cFlavourRel}},
+    {L"\\Lleftarrow",           {L"\U000021DA", LayoutTree::Node::cFlavourRel}},
+    {L"\\Longleftarrow",        {L"\U000021D0", LayoutTree::Node::cFlavourRel}},
+    {L"\\Longleftrightarrow",   {L"\U000021D4", LayoutTree::Node::cFlavourRel}},
+    {L"\\Longrightarrow",       {L"\U000021D2", LayoutTree::Node::cFlavourRel}},
+    {L"\\Lsh",                  {L"\U000021B0", LayoutTree::Node::cFlavourRel}},
+    {L"\\Pr",                   {L"Pr",         LayoutTree::Node::cFlavourOp}},
+    {L"\\Rightarrow",           {L"\U000021D2", LayoutTree::Node::cFlavourRel}},
+    {L"\\Rrightarrow",          {L"\U000021DB", LayoutTree::Node::cFlavourRel}},
+    {L"\\Rsh",                  {L"\U000021B1", LayoutTree::Node::cFlavourRel}},
+    {L"\\Subset",               {L"\U000022D0", LayoutTree::Node::cFlavourRel}},
+    {L"\\Supset",               {L"\U000022D1", LayoutTree::Node::cFlavourRel}},
+    {L"\\Uparrow",              {L"\U000021D1", LayoutTree::Node::cFlavourRel}},
+    {L"\\Updownarrow",          {L"\U000021D5", LayoutTree::Node::cFlavourRel}},
+    {L"\\Vdash",                {L"\U000022A9", LayoutTree::Node::cFlavourRel}},
+    {L"\\Vert",                 {L"\U00002225", LayoutTree::Node::cFlavourOrd}},
+    {L"\\Vvdash",               {L"\U000022AA", LayoutTree::Node::cFlavourRel}},
+    {L"\\_",                    {L"_", LayoutTree::Node::cFlavourOrd}},
+    {L"\\amalg",                {L"\U00002A3F", LayoutTree::Node::cFlavourBin}},
+    {L"\\angle",                {L"\U00002220", LayoutTree::Node::cFlavourOrd}},
+    {L"\\approx",               {L"\U00002248", LayoutTree::Node::cFlavourRel}},
+    {L"\\approxeq",             {L"\U0000224A", LayoutTree::Node::cFlavourRel}},
+    {L"\\ast",                  {L"*", LayoutTree::Node::cFlavourBin}},
+    {L"\\asymp",                {L"\U00002248", LayoutTree::Node::cFlavourRel}},
+    {L"\\backepsilon",          {L"\U000003F6", LayoutTree::Node::cFlavourRel}},
+    {L"\\backprime",            {L"\U00002035", LayoutTree::Node::cFlavourOrd}},
+    {L"\\backsim",              {L"\U0000223D", LayoutTree::Node::cFlavourRel}},
+    {L"\\backsimeq",            {L"\U000022CD", LayoutTree::Node::cFlavourRel}},
+    {L"\\backslash",            {L"\U00002216", LayoutTree::Node::cFlavourOrd}},
+    {L"\\barwedge",             {L"\U00002305", LayoutTree::Node::cFlavourBin}},
+    {L"\\because",              {L"\U00002235", LayoutTree::Node::cFlavourRel}},
+    {L"\\between",              {L"\U0000226C", LayoutTree::Node::cFlavourRel}},
+    {L"\\bigcap",               {L"\U000022C2", LayoutTree::Node::cFlavourOp}},
+    {L"\\bigcirc",              {L"\U000025EF", LayoutTree::Node::cFlavourBin}},
+    {L"\\bigcup",               {L"\U000022C3", LayoutTree::Node::cFlavourOp}},
+    {L"\\bigodot",              {L"\U00002A00", LayoutTree::Node::cFlavourOp}},
+    {L"\\bigoplus",             {L"\U00002A01", LayoutTree::Node::cFlavourOp}},
+    {L"\\bigotimes",            {L"\U00002A02", LayoutTree::Node::cFlavourOp}},
+    {L"\\bigsqcup",             {L"\U00002A06", LayoutTree::Node::cFlavourOp}},
+    {L"\\bigstar",              {L"\U00002605", LayoutTree::Node::cFlavourOrd}},
+    {L"\\bigtriangledown",      {L"\U000025BD", LayoutTree::Node::cFlavourBin}},
+    {L"\\bigtriangleup",        {L"\U000025B3", LayoutTree::Node::cFlavourBin}},
+    {L"\\biguplus",             {L"\U00002A04", LayoutTree::Node::cFlavourOp}},
+    {L"\\bigvee",               {L"\U000022C1", LayoutTree::Node::cFlavourOp}},
+    {L"\\bigwedge",             {L"\U000022C0", LayoutTree::Node::cFlavourOp}},
+    {L"\\blacklozenge",         {L"\U000029EB", LayoutTree::Node::cFlavourOrd}},
+    {L"\\blacksquare",          {L"\U000025FC", LayoutTree::Node::cFlavourOrd}},
+    {L"\\blacktriangle",        {L"\U000025B4", LayoutTree::Node::cFlavourOrd}},
+    {L"\\blacktriangledown",    {L"\U000025BE", LayoutTree::Node::cFlavourOrd}},
+    {L"\\blacktriangleleft",    {L"\U000025C0", LayoutTree::Node::cFlavourRel}},
+    {L"\\blacktriangleright",   {L"\U000025B6", LayoutTree::Node::cFlavourRel}},
+    {L"\\bot",                  {L"\U000022A5", LayoutTree::Node::cFlavourOrd}},
+    {L"\\bowtie",               {L"\U000022C8", LayoutTree::Node::cFlavourRel}},
+    {L"\\boxdot",               {L"\U000022A1", LayoutTree::Node::cFlavourBin}},
+    {L"\\boxminus",             {L"\U0000229F", LayoutTree::Node::cFlavourBin}},
+    {L"\\boxplus",              {L"\U0000229E", LayoutTree::Node::cFlavourBin}},
+    {L"\\boxtimes",             {L"\U000022A0", LayoutTree::Node::cFlavourBin}},
+    {L"\\bullet",               {L"\U00002022", LayoutTree::Node::cFlavourBin}},
+    {L"\\bumpeq",               {L"\U0000224F", LayoutTree::Node::cFlavourRel}},
+    {L"\\cap",                  {L"\U00002229", LayoutTree::Node::cFlavourBin}},
+    {L"\\cdot",                 {L"\U000022C5", LayoutTree::Node::cFlavourBin}},
+    {L"\\cdots",                {L"\U000022EF", LayoutTree::Node::cFlavourInner}},
+    {L"\\centerdot",            {L"\U000022C5", LayoutTree::Node::cFlavourBin}},
+    {L"\\checkmark",            {L"\U00002713", LayoutTree::Node::cFlavourOrd}},
+    {L"\\circ",                 {L"\U00002218", LayoutTree::Node::cFlavourBin}},
+    {L"\\circeq",               {L"\U00002257", LayoutTree::Node::cFlavourRel}},
+    {L"\\circlearrowleft",      {L"\U000021BA", LayoutTree::Node::cFlavourRel}},
+    {L"\\circlearrowright",     {L"\U000021BB", LayoutTree::Node::cFlavourRel}},
+    {L"\\circledast",           {L"\U0000229B", LayoutTree::Node::cFlavourBin}},
+    {L"\\circledcirc",          {L"\U0000229A", LayoutTree::Node::cFlavourBin}},
+    {L"\\circleddash",          {L"\U0000229D", LayoutTree::Node::cFlavourBin}},
+    {L"\\clubsuit",             {L"\U00002663", LayoutTree::Node::cFlavourOrd}},
+    {L"\\complement",           {L"\U00002201", LayoutTree::Node::cFlavourOrd}},
+    {L"\\cong",                 {L"\U00002245", LayoutTree::Node::cFlavourRel}},
+    {L"\\coprod",               {L"\U00002210", LayoutTree::Node::cFlavourOp}},
+    {L"\\cup",                  {L"\U0000222A", LayoutTree::Node::cFlavourBin}},
+    {L"\\curlyeqprec",          {L"\U000022DE", LayoutTree::Node::cFlavourRel}},
+    {L"\\curlyeqsucc",          {L"\U000022DF", LayoutTree::Node::cFlavourRel}},
+    {L"\\curlyvee",             {L"\U000022CE", LayoutTree::Node::cFlavourBin}},
+    {L"\\curlywedge",           {L"\U000022CF", LayoutTree::Node::cFlavourBin}},
+    {L"\\curvearrowleft",       {L"\U000021B6", LayoutTree::Node::cFlavourRel}},
+    {L"\\curvearrowright",      {L"\U000021B7", LayoutTree::Node::cFlavourRel}},
+    {L"\\dagger",               {L"\U00002020", LayoutTree::Node::cFlavourBin}},
+    {L"\\dashleftarrow",        {L"\U0000290E", LayoutTree::Node::cFlavourRel}},
+    {L"\\dashrightarrow",       {L"\U0000290F", LayoutTree::Node::cFlavourRel}},
+    {L"\\dashv",                {L"\U000022A3", LayoutTree::Node::cFlavourRel}},
+    {L"\\ddagger",              {L"\U00002021", LayoutTree::Node::cFlavourBin}},
+    {L"\\ddots",                {L"\U000022F1", LayoutTree::Node::cFlavourInner}},
+    {L"\\det",                  {L"det",        LayoutTree::Node::cFlavourOp}},
+    {L"\\diamond",              {L"\U000022C4", LayoutTree::Node::cFlavourBin}},
+    {L"\\diamondsuit",          {L"\U00002666", LayoutTree::Node::cFlavourOrd}},
+    {L"\\div",                  {L"\U000000F7", LayoutTree::Node::cFlavourBin}},
+    {L"\\divideontimes",        {L"\U000022C7", LayoutTree::Node::cFlavourBin}},
+    {L"\\doteq",                {L"\U00002250", LayoutTree::Node::cFlavourRel}},
+    {L"\\doteqdot",             {L"\U00002251", LayoutTree::Node::cFlavourRel}},
+    {L"\\dotplus",              {L"\U00002214", LayoutTree::Node::cFlavourOrd}},
+    // FIX: \dots and \dotsb aren't right. The amsmath package does
+    // tricky things so that the dots change their vertical position
+    // depending on the surrounding operators. We chicken out and just map
+    // them to the same as \ldots and \cdots respectively.
+    {L"\\dots",                 {L"\U00002026", LayoutTree::Node::cFlavourInner}},
+    {L"\\dotsb",                {L"\U000022EF", LayoutTree::Node::cFlavourInner}},
+    {L"\\doublebarwedge",       {L"\U00002306", LayoutTree::Node::cFlavourBin}},
+    {L"\\downarrow",            {L"\U00002193", LayoutTree::Node::cFlavourRel}},
+    {L"\\downdownarrows",       {L"\U000021CA", LayoutTree::Node::cFlavourRel}},
+    {L"\\downharpoonleft",      {L"\U000021C3", LayoutTree::Node::cFlavourRel}},
+    {L"\\downharpoonright",     {L"\U000021C2", LayoutTree::Node::cFlavourRel}},
+    {L"\\eqcirc",               {L"\U00002256", LayoutTree::Node::cFlavourRel}},
+    {L"\\eqsim",                {L"\U00002242", LayoutTree::Node::cFlavourRel}},
+    {L"\\eqslantgtr",           {L"\U00002A96", LayoutTree::Node::cFlavourRel}},
+    {L"\\eqslantless",          {L"\U00002A95", LayoutTree::Node::cFlavourRel}},
+    {L"\\equiv",                {L"\U00002261", LayoutTree::Node::cFlavourRel}},
+    {L"\\exists",               {L"\U00002203", LayoutTree::Node::cFlavourOrd}},
+    {L"\\fallingdotseq",        {L"\U00002252", LayoutTree::Node::cFlavourRel}},
+    {L"\\flat",                 {L"\U0000266D", LayoutTree::Node::cFlavourOrd}},
+    {L"\\forall",               {L"\U00002200", LayoutTree::Node::cFlavourOrd}},
+    {L"\\frown",                {L"\U00002322", LayoutTree::Node::cFlavourRel}},
+    {L"\\gcd",                  {L"gcd",        LayoutTree::Node::cFlavourOp}},
+    {L"\\geq",                  {L"\U00002265", LayoutTree::Node::cFlavourRel}},
+    {L"\\geqq",                 {L"\U00002267", LayoutTree::Node::cFlavourRel}},
+    {L"\\geqslant",             {L"\U00002A7E", LayoutTree::Node::cFlavourRel}},
+    {L"\\gg",                   {L"\U0000226B", LayoutTree::Node::cFlavourRel}},
+    {L"\\ggg",                  {L"\U000022D9", LayoutTree::Node::cFlavourRel}},
+    {L"\\gnapprox",             {L"\U00002A8A", LayoutTree::Node::cFlavourRel}},
+    {L"\\gneqq",                {L"\U00002269", LayoutTree::Node::cFlavourRel}},
+    {L"\\gnsim",                {L"\U000022E7", LayoutTree::Node::cFlavourRel}},
+    {L"\\gtrapprox",            {L"\U00002A86", LayoutTree::Node::cFlavourRel}},
+    {L"\\gtrdot",               {L"\U000022D7", LayoutTree::Node::cFlavourBin}},
+    {L"\\gtreqless",            {L"\U000022DB", LayoutTree::Node::cFlavourRel}},
+    {L"\\gtreqqless",           {L"\U00002A8C", LayoutTree::Node::cFlavourRel}},
+    {L"\\gtrless",              {L"\U00002277", LayoutTree::Node::cFlavourRel}},
+    {L"\\gtrsim",               {L"\U00002273", LayoutTree::Node::cFlavourRel}},
+    {L"\\gvertneqq",            {L"\U00002269\U0000FE00", LayoutTree::Node::cFlavourRel}},
+    {L"\\heartsuit",            {L"\U00002665", LayoutTree::Node::cFlavourOrd}},
+    {L"\\hookleftarrow",        {L"\U000021A9", LayoutTree::Node::cFlavourRel}},
+    {L"\\hookrightarrow",       {L"\U000021AA", LayoutTree::Node::cFlavourRel}},
+    {L"\\iiiint",               {L"\U00002A0C", LayoutTree::Node::cFlavourOp, LayoutTree::Node::cLimitsNoLimits}},
+    {L"\\iiint",                {L"\U0000222D", LayoutTree::Node::cFlavourOp, LayoutTree::Node::cLimitsNoLimits}},
+    {L"\\iint",                 {L"\U0000222C", LayoutTree::Node::cFlavourOp, LayoutTree::Node::cLimitsNoLimits}},
+    {L"\\in",                   {L"\U00002208", LayoutTree::Node::cFlavourRel}},
+    {L"\\inf",                  {L"inf",        LayoutTree::Node::cFlavourOp}},
+    {L"\\injlim",               {L"inj lim",    LayoutTree::Node::cFlavourOp}},
+    {L"\\int",                  {L"\U0000222B", LayoutTree::Node::cFlavourOp, LayoutTree::Node::cLimitsNoLimits}},
+    {L"\\intercal",             {L"\U000022BA", LayoutTree::Node::cFlavourBin}},
+    {L"\\lVert",                {L"\U00002225", LayoutTree::Node::cFlavourOpen}},
+    {L"\\langle",               {L"\U00002329", LayoutTree::Node::cFlavourOpen}},
+    {L"\\lbrace",               {L"{", LayoutTree::Node::cFlavourOpen}},
+    {L"\\lbrack",               {L"[", LayoutTree::Node::cFlavourOpen}},
+    {L"\\lceil",                {L"\U00002308", LayoutTree::Node::cFlavourOpen}},
+    {L"\\ldots",                {L"\U00002026", LayoutTree::Node::cFlavourInner}},
+    {L"\\leadsto",              {L"\U000021DD", LayoutTree::Node::cFlavourRel}},
+    {L"\\leftarrow",            {L"\U00002190", LayoutTree::Node::cFlavourRel}},
+    {L"\\leftarrowtail",        {L"\U000021A2", LayoutTree::Node::cFlavourRel}},
+    {L"\\leftharpoondown",      {L"\U000021BD", LayoutTree::Node::cFlavourRel}},
+    {L"\\leftharpoonup",        {L"\U000021BC", LayoutTree::Node::cFlavourRel}},
+    {L"\\leftleftarrows",       {L"\U000021C7", LayoutTree::Node::cFlavourRel}},
+    {L"\\leftrightarrow",       {L"\U00002194", LayoutTree::Node::cFlavourRel}},
+    {L"\\leftrightarrows",      {L"\U000021C6", LayoutTree::Node::cFlavourRel}},
+    {L"\\leftrightharpoons",    {L"\U000021CB", LayoutTree::Node::cFlavourRel}},
+    {L"\\leftrightsquigarrow",  {L"\U000021AD", LayoutTree::Node::cFlavourRel}},
+    {L"\\leftthreetimes",       {L"\U000022CB", LayoutTree::Node::cFlavourBin}},
+    {L"\\leq",                  {L"\U00002264", LayoutTree::Node::cFlavourRel}},
+    {L"\\leqq",                 {L"\U00002266", LayoutTree::Node::cFlavourRel}},
+    {L"\\leqslant",             {L"\U00002A7D", LayoutTree::Node::cFlavourRel}},
+    {L"\\lessapprox",           {L"\U00002A85", LayoutTree::Node::cFlavourRel}},
+    {L"\\lessdot",              {L"\U000022D6", LayoutTree::Node::cFlavourBin}},
+    {L"\\lesseqgtr",            {L"\U000022DA", LayoutTree::Node::cFlavourRel}},
+    {L"\\lesseqqgtr",           {L"\U00002A8B", LayoutTree::Node::cFlavourRel}},
+    {L"\\lessgtr",              {L"\U00002276", LayoutTree::Node::cFlavourRel}},
+    {L"\\lesssim",              {L"\U00002272", LayoutTree::Node::cFlavourRel}},
+    {L"\\lfloor",               {L"\U0000230A", LayoutTree::Node::cFlavourOpen}},
+    {L"\\lhd",                  {L"\U000022B2", LayoutTree::Node::cFlavourBin}},
+    {L"\\lim",                  {L"lim",        LayoutTree::Node::cFlavourOp}},
+    {L"\\liminf",               {L"lim inf",    LayoutTree::Node::cFlavourOp}},
+    // FIX: the space between the words in \limsup, \liminf, \injlim and
+    // \projlim is maybe a tiny bit too big.
+    {L"\\limsup",               {L"lim sup",    LayoutTree::Node::cFlavourOp}},
+    {L"\\ll",                   {L"\U0000226A", LayoutTree::Node::cFlavourRel}},
+    {L"\\llcorner",             {L"\U0000231E", LayoutTree::Node::cFlavourOrd}},
+    {L"\\lll",                  {L"\U000022D8", LayoutTree::Node::cFlavourRel}},
+    {L"\\lnapprox",             {L"\U00002A89", LayoutTree::Node::cFlavourRel}},
+    {L"\\lneqq",                {L"\U00002268", LayoutTree::Node::cFlavourRel}},
+    {L"\\lnot",                 {L"\U000000AC", LayoutTree::Node::cFlavourOrd}},
+    {L"\\lnsim",                {L"\U000022E6", LayoutTree::Node::cFlavourRel}},
+    {L"\\longleftarrow",        {L"\U00002190", LayoutTree::Node::cFlavourRel}},
+    {L"\\longleftrightarrow",   {L"\U00002194", LayoutTree::Node::cFlavourRel}},
+    {L"\\longmapsto",           {L"\U000021A6", LayoutTree::Node::cFlavourRel}},
+    {L"\\longrightarrow",       {L"\U00002192", LayoutTree::Node::cFlavourRel}},
+    {L"\\looparrowleft",        {L"\U000021AB", LayoutTree::Node::cFlavourRel}},
+    {L"\\looparrowright",       {L"\U000021AC", LayoutTree::Node::cFlavourRel}},
+    {L"\\lozenge",              {L"\U000025CA", LayoutTree::Node::cFlavourOrd}},
+    {L"\\lrcorner",             {L"\U0000231F", LayoutTree::Node::cFlavourOrd}},
+    {L"\\ltimes",               {L"\U000022C9", LayoutTree::Node::cFlavourBin}},
+    {L"\\lvert",                {L"|", LayoutTree::Node::cFlavourOpen}},
+    {L"\\lvertneqq",            {L"\U00002268\U0000FE00", LayoutTree::Node::cFlavourRel}},
+    {L"\\mapsto",               {L"\U000021A6", LayoutTree::Node::cFlavourRel}},
+    {L"\\max",                  {L"max",        LayoutTree::Node::cFlavourOp}},
+    {L"\\measuredangle",        {L"\U00002221", LayoutTree::Node::cFlavourOrd}},
+    {L"\\mid",                  {L"|",          LayoutTree::Node::cFlavourRel}},
+    {L"\\min",                  {L"min",        LayoutTree::Node::cFlavourOp}},
+    {L"\\models",               {L"\U000022A7", LayoutTree::Node::cFlavourRel}},
+    {L"\\mp",                   {L"\U00002213", LayoutTree::Node::cFlavourBin}},
+    {L"\\multimap",             {L"\U000022B8", LayoutTree::Node::cFlavourRel}},
+    {L"\\nLeftarrow",           {L"\U000021CD", LayoutTree::Node::cFlavourRel}},
+    {L"\\nLeftrightarrow",      {L"\U000021CE", LayoutTree::Node::cFlavourRel}},
+    {L"\\nRightarrow",          {L"\U000021CF", LayoutTree::Node::cFlavourRel}},
+    {L"\\nVDash",               {L"\U000022AF", LayoutTree::Node::cFlavourRel}},
+    {L"\\nVdash",               {L"\U000022AE", LayoutTree::Node::cFlavourRel}},
+    {L"\\nabla",                {L"\U00002207", LayoutTree::Node::cFlavourOrd}},
+    {L"\\natural",              {L"\U0000266E", LayoutTree::Node::cFlavourOrd}},
+    {L"\\ncong",                {L"\U00002247", LayoutTree::Node::cFlavourRel}},
+    {L"\\nearrow",              {L"\U00002197", LayoutTree::Node::cFlavourRel}},
+    {L"\\neq",                  {L"\U00002260", LayoutTree::Node::cFlavourRel}},
+    {L"\\nexists",              {L"\U00002204", LayoutTree::Node::cFlavourOrd}},
+    {L"\\ngeq",                 {L"\U00002271", LayoutTree::Node::cFlavourRel}},
+    {L"\\ngeqq",                {L"\U00002267\U00000338", LayoutTree::Node::cFlavourRel}},
+    {L"\\ngeqslant",            {L"\U00002A7E\U00000338", LayoutTree::Node::cFlavourRel}},
+    {L"\\ngtr",                 {L"\U0000226F", LayoutTree::Node::cFlavourRel}},
+    {L"\\ni",                   {L"\U0000220B", LayoutTree::Node::cFlavourRel}},
+    {L"\\nleftarrow",           {L"\U0000219A", LayoutTree::Node::cFlavourRel}},
+    {L"\\nleftrightarrow",      {L"\U000021AE", LayoutTree::Node::cFlavourRel}},
+    {L"\\nleq",                 {L"\U00002270", LayoutTree::Node::cFlavourRel}},
+    {L"\\nleqq",                {L"\U00002266\U00000338", LayoutTree::Node::cFlavourRel}},
+    {L"\\nleqslant",            {L"\U00002A7D\U00000338", LayoutTree::Node::cFlavourRel}},
+    {L"\\nless",                {L"\U0000226E", LayoutTree::Node::cFlavourRel}},
+    {L"\\nmid",                 {L"\U00002224", LayoutTree::Node::cFlavourRel}},
     // The translation of \not is special: we record it as a SymbolOperator
     // in the layout tree, but it gets special handling later.
-    make_pair(L"\\not",                  OperatorInfo(L"NOT", LayoutTree::Node::cFlavourRel))
+    {L"\\not",                  {L"NOT", LayoutTree::Node::cFlavourRel}},
+    {L"\\notin",                {L"\U00002209", LayoutTree::Node::cFlavourRel}},
+    {L"\\nparallel",            {L"\U00002226", LayoutTree::Node::cFlavourRel}},
+    {L"\\nprec",                {L"\U00002280", LayoutTree::Node::cFlavourRel}},
+    {L"\\npreceq",              {L"\U00002AAF\U00000338", LayoutTree::Node::cFlavourRel}},
+    {L"\\nrightarrow",          {L"\U0000219B", LayoutTree::Node::cFlavourRel}},
+    {L"\\nshortmid",            {L"\U00002224", LayoutTree::Node::cFlavourRel}},
+    {L"\\nshortparallel",       {L"\U00002226", LayoutTree::Node::cFlavourRel}},
+    {L"\\nsim",                 {L"\U00002241", LayoutTree::Node::cFlavourRel}},
+    {L"\\nsubseteq",            {L"\U00002288", LayoutTree::Node::cFlavourRel}},
+    {L"\\nsubseteqq",           {L"\U00002AC5\U00000338", LayoutTree::Node::cFlavourRel}},
+    {L"\\nsucc",                {L"\U00002281", LayoutTree::Node::cFlavourRel}},
+    {L"\\nsucceq",              {L"\U00002AB0\U00000338", LayoutTree::Node::cFlavourRel}},
+    {L"\\nsupseteq",            {L"\U00002289", LayoutTree::Node::cFlavourRel}},
+    {L"\\nsupseteqq",           {L"\U00002AC6\U00000338", LayoutTree::Node::cFlavourRel}},
+    {L"\\ntriangleleft",        {L"\U000022EA", LayoutTree::Node::cFlavourRel}},
+    {L"\\ntrianglelefteq",      {L"\U000022EC", LayoutTree::Node::cFlavourRel}},
+    {L"\\ntriangleright",       {L"\U000022EB", LayoutTree::Node::cFlavourRel}},
+    {L"\\ntrianglerighteq",     {L"\U000022ED", LayoutTree::Node::cFlavourRel}},
+    {L"\\nvDash",               {L"\U000022AD", LayoutTree::Node::cFlavourRel}},
+    {L"\\nvdash",               {L"\U000022AC", LayoutTree::Node::cFlavourRel}},
+    {L"\\nwarrow",              {L"\U00002196", LayoutTree::Node::cFlavourRel}},
+    {L"\\odot",                 {L"\U00002299", LayoutTree::Node::cFlavourBin}},
+    {L"\\oint",                 {L"\U0000222E", LayoutTree::Node::cFlavourOp, LayoutTree::Node::cLimitsNoLimits}},
+    {L"\\ominus",               {L"\U00002296", LayoutTree::Node::cFlavourBin}},
+    {L"\\oplus",                {L"\U00002295", LayoutTree::Node::cFlavourBin}},
+    {L"\\oslash",               {L"\U00002298", LayoutTree::Node::cFlavourBin}},
+    {L"\\otimes",               {L"\U00002297", LayoutTree::Node::cFlavourBin}},
+    {L"\\parallel",             {L"\U00002225", LayoutTree::Node::cFlavourRel}},
+    {L"\\perp",                 {L"\U000022A5", LayoutTree::Node::cFlavourRel}},
+    {L"\\pitchfork",            {L"\U000022D4", LayoutTree::Node::cFlavourRel}},
+    {L"\\pm",                   {L"\U000000B1", LayoutTree::Node::cFlavourBin}},
+    {L"\\prec",                 {L"\U0000227A", LayoutTree::Node::cFlavourRel}},
+    {L"\\precapprox",           {L"\U00002AB7", LayoutTree::Node::cFlavourRel}},
+    {L"\\preccurlyeq",          {L"\U0000227C", LayoutTree::Node::cFlavourRel}},
+    {L"\\preceq",               {L"\U00002AAF", LayoutTree::Node::cFlavourRel}},
+    {L"\\precnapprox",          {L"\U00002AB9", LayoutTree::Node::cFlavourRel}},
+    {L"\\precneqq",             {L"\U00002AB5", LayoutTree::Node::cFlavourRel}},
+    {L"\\precnsim",             {L"\U000022E8", LayoutTree::Node::cFlavourRel}},
+    {L"\\precsim",              {L"\U0000227E", LayoutTree::Node::cFlavourRel}},
+    {L"\\prime",                {L"\U00002032", LayoutTree::Node::cFlavourOrd}},
+    {L"\\prod",                 {L"\U0000220F", LayoutTree::Node::cFlavourOp}},
+    {L"\\projlim",              {L"proj lim",   LayoutTree::Node::cFlavourOp}},
+    {L"\\propto",               {L"\U0000221D", LayoutTree::Node::cFlavourRel}},
+    {L"\\rVert",                {L"\U00002225", LayoutTree::Node::cFlavourClose}},
+    {L"\\rangle",               {L"\U0000232A", LayoutTree::Node::cFlavourClose}},
+    {L"\\rbrace",               {L"}", LayoutTree::Node::cFlavourClose}},
+    {L"\\rbrack",               {L"]", LayoutTree::Node::cFlavourClose}},
+    {L"\\rceil",                {L"\U00002309", LayoutTree::Node::cFlavourClose}},
+    {L"\\rfloor",               {L"\U0000230B", LayoutTree::Node::cFlavourClose}},
+    {L"\\rhd",                  {L"\U000022B3", LayoutTree::Node::cFlavourBin}},
+    {L"\\rightarrow",           {L"\U00002192", LayoutTree::Node::cFlavourRel}},
+    {L"\\rightarrowtail",       {L"\U000021A3", LayoutTree::Node::cFlavourRel}},
+    {L"\\rightharpoondown",     {L"\U000021C1", LayoutTree::Node::cFlavourRel}},
+    {L"\\rightharpoonup",       {L"\U000021C0", LayoutTree::Node::cFlavourRel}},
+    {L"\\rightleftarrows",      {L"\U000021C4", LayoutTree::Node::cFlavourRel}},
+    {L"\\rightleftharpoons",    {L"\U000021CC", LayoutTree::Node::cFlavourRel}},
+    {L"\\rightrightarrows",     {L"\U000021C9", LayoutTree::Node::cFlavourRel}},
+    {L"\\rightsquigarrow",      {L"\U0000219D", LayoutTree::Node::cFlavourRel}},
+    {L"\\rightthreetimes",      {L"\U000022CC", LayoutTree::Node::cFlavourBin}},
+    {L"\\risingdotseq",         {L"\U00002253", LayoutTree::Node::cFlavourRel}},
+    {L"\\rtimes",               {L"\U000022CA", LayoutTree::Node::cFlavourBin}},
+    {L"\\rvert",                {L"|", LayoutTree::Node::cFlavourClose}},
+    {L"\\searrow",              {L"\U00002198", LayoutTree::Node::cFlavourRel}},
+    {L"\\setminus",             {L"\U00002216", LayoutTree::Node::cFlavourBin}},
+    {L"\\sharp",                {L"\U0000266F", LayoutTree::Node::cFlavourOrd}},
+    {L"\\shortmid",             {L"\U00002223", LayoutTree::Node::cFlavourRel}},
+    {L"\\shortparallel",        {L"\U00002225", LayoutTree::Node::cFlavourRel}},
+    {L"\\sim",                  {L"\U0000223C", LayoutTree::Node::cFlavourRel}},
+    {L"\\simeq",                {L"\U00002243", LayoutTree::Node::cFlavourRel}},
+    {L"\\smallfrown",           {L"\U00002322", LayoutTree::Node::cFlavourRel}},
+    // FIX: how to make smallsetminus smaller?
+    {L"\\smallsetminus",        {L"\U00002216", LayoutTree::Node::cFlavourBin}},
+    // FIX: how to make \smallsmile and \smallfrown smaller?
+    {L"\\smallsmile",           {L"\U00002323", LayoutTree::Node::cFlavourRel}},
+    {L"\\smile",                {L"\U00002323", LayoutTree::Node::cFlavourRel}},
+    {L"\\spadesuit",            {L"\U00002660", LayoutTree::Node::cFlavourOrd}},
+    {L"\\sphericalangle",       {L"\U00002222", LayoutTree::Node::cFlavourOrd}},
+    {L"\\sqcap",                {L"\U00002293", LayoutTree::Node::cFlavourBin}},
+    {L"\\sqcup",                {L"\U00002294", LayoutTree::Node::cFlavourBin}},
+    {L"\\sqsubset",             {L"\U0000228F", LayoutTree::Node::cFlavourRel}},
+    {L"\\sqsubseteq",           {L"\U00002291", LayoutTree::Node::cFlavourRel}},
+    {L"\\sqsupset",             {L"\U00002290", LayoutTree::Node::cFlavourRel}},
+    {L"\\sqsupseteq",           {L"\U00002292", LayoutTree::Node::cFlavourRel}},
+    {L"\\square",               {L"\U000025A1", LayoutTree::Node::cFlavourOrd}},
+    {L"\\star",                 {L"\U000022C6", LayoutTree::Node::cFlavourBin}},
+    {L"\\subset",               {L"\U00002282", LayoutTree::Node::cFlavourRel}},
+    {L"\\subseteq",             {L"\U00002286", LayoutTree::Node::cFlavourRel}},
+    {L"\\subseteqq",            {L"\U00002AC5", LayoutTree::Node::cFlavourRel}},
+    {L"\\subsetneq",            {L"\U0000228A", LayoutTree::Node::cFlavourRel}},
+    {L"\\subsetneqq",           {L"\U00002ACB", LayoutTree::Node::cFlavourRel}},
+    {L"\\succ",                 {L"\U0000227B", LayoutTree::Node::cFlavourRel}},
+    {L"\\succapprox",           {L"\U00002AB8", LayoutTree::Node::cFlavourRel}},
+    {L"\\succcurlyeq",          {L"\U0000227D", LayoutTree::Node::cFlavourRel}},
+    {L"\\succeq",               {L"\U00002AB0", LayoutTree::Node::cFlavourRel}},
+    {L"\\succnapprox",          {L"\U00002ABA", LayoutTree::Node::cFlavourRel}},
+    {L"\\succneqq",             {L"\U00002AB6", LayoutTree::Node::cFlavourRel}},
+    {L"\\succnsim",             {L"\U000022E9", LayoutTree::Node::cFlavourRel}},
+    {L"\\succsim",              {L"\U0000227F", LayoutTree::Node::cFlavourRel}},
+    {L"\\sum",                  {L"\U00002211", LayoutTree::Node::cFlavourOp}},
+    {L"\\sup",                  {L"sup",        LayoutTree::Node::cFlavourOp}},
+    {L"\\supset",               {L"\U00002283", LayoutTree::Node::cFlavourRel}},
+    {L"\\supseteq",             {L"\U00002287", LayoutTree::Node::cFlavourRel}},
+    {L"\\supseteqq",            {L"\U00002AC6", LayoutTree::Node::cFlavourRel}},
+    {L"\\supsetneq",            {L"\U0000228B", LayoutTree::Node::cFlavourRel}},
+    {L"\\supsetneqq",           {L"\U00002ACC", LayoutTree::Node::cFlavourRel}},
+    {L"\\surd",                 {L"\U0000221A", LayoutTree::Node::cFlavourOrd}},
+    {L"\\swarrow",              {L"\U00002199", LayoutTree::Node::cFlavourRel}},
+    {L"\\therefore",            {L"\U00002234", LayoutTree::Node::cFlavourRel}},
+    {L"\\thickapprox",          {L"\U00002248", LayoutTree::Node::cFlavourRel}},
+    {L"\\thicksim",             {L"\U0000223C", LayoutTree::Node::cFlavourRel}},
+    {L"\\times",                {L"\U000000D7", LayoutTree::Node::cFlavourBin}},
+    {L"\\top",                  {L"\U000022A4", LayoutTree::Node::cFlavourOrd}},
+    {L"\\triangle",             {L"\U000025B3", LayoutTree::Node::cFlavourOrd}},
+    {L"\\triangledown",         {L"\U000025BF", LayoutTree::Node::cFlavourOrd}},
+    {L"\\triangleleft",         {L"\U000025C3", LayoutTree::Node::cFlavourBin}},
+    {L"\\triangleq",            {L"\U0000225C", LayoutTree::Node::cFlavourRel}},
+    {L"\\triangleright",        {L"\U000025B9", LayoutTree::Node::cFlavourBin}},
+    {L"\\twoheadleftarrow",     {L"\U0000219E", LayoutTree::Node::cFlavourRel}},
+    {L"\\twoheadrightarrow",    {L"\U000021A0", LayoutTree::Node::cFlavourRel}},
+    {L"\\ulcorner",             {L"\U0000231C", LayoutTree::Node::cFlavourOrd}},
+    {L"\\unlhd",                {L"\U000022B4", LayoutTree::Node::cFlavourBin}},
+    {L"\\unrhd",                {L"\U000022B5", LayoutTree::Node::cFlavourBin}},
+    {L"\\uparrow",              {L"\U00002191", LayoutTree::Node::cFlavourRel}},
+    {L"\\updownarrow",          {L"\U00002195", LayoutTree::Node::cFlavourRel}},
+    {L"\\upharpoonleft",        {L"\U000021BF", LayoutTree::Node::cFlavourRel}},
+    {L"\\upharpoonright",       {L"\U000021BE", LayoutTree::Node::cFlavourRel}},
+    {L"\\uplus",                {L"\U0000228E", LayoutTree::Node::cFlavourBin}},
+    {L"\\upuparrows",           {L"\U000021C8", LayoutTree::Node::cFlavourRel}},
+    {L"\\urcorner",             {L"\U0000231D", LayoutTree::Node::cFlavourOrd}},
+    {L"\\vDash",                {L"\U000022A8", LayoutTree::Node::cFlavourRel}},
+    {L"\\varpropto",            {L"\U0000221D", LayoutTree::Node::cFlavourRel}},
+    {L"\\varsubsetneq",         {L"\U0000228A\U0000FE00", LayoutTree::Node::cFlavourRel}},
+    {L"\\varsubsetneqq",        {L"\U00002ACB\U0000FE00", LayoutTree::Node::cFlavourRel}},
+    {L"\\varsupsetneq",         {L"\U0000228B\U0000FE00", LayoutTree::Node::cFlavourRel}},
+    {L"\\varsupsetneqq",        {L"\U00002ACC\U0000FE00", LayoutTree::Node::cFlavourRel}},
+    {L"\\vartriangle",          {L"\U000025B5", LayoutTree::Node::cFlavourRel}},
+    {L"\\vdash",                {L"\U000022A2", LayoutTree::Node::cFlavourRel}},
+    {L"\\vdots",                {L"\U000022EE", LayoutTree::Node::cFlavourOrd}},
+    {L"\\vee",                  {L"\U00002228", LayoutTree::Node::cFlavourBin}},
+    {L"\\veebar",               {L"\U000022BB", LayoutTree::Node::cFlavourBin}},
+    {L"\\vert",                 {L"|", LayoutTree::Node::cFlavourOrd}},
+    {L"\\wedge",                {L"\U00002227", LayoutTree::Node::cFlavourBin}},
+    {L"\\wr",                   {L"\U00002240", LayoutTree::Node::cFlavourBin}},
+    {L"\\{",                    {L"{", LayoutTree::Node::cFlavourOpen}},
+    {L"\\}",                    {L"}", LayoutTree::Node::cFlavourClose}},
+    {L"]",                      {L"]", LayoutTree::Node::cFlavourClose}},
+    {L"|",                      {L"|", LayoutTree::Node::cFlavourOrd}}
 };
-wishful_hash_map<wstring, OperatorInfo> operatorTable(
-    operatorArray,
-    END_ARRAY(operatorArray)
-);
 
 
 struct IdentifierInfo
 {
     bool mIsItalicDefault;
-    wstring mText;
+    const wchar_t* mText;
     LayoutTree::Node::Flavour mFlavour;
-
-    IdentifierInfo(
-        bool isItalicDefault,
-        const wstring& text,
-        LayoutTree::Node::Flavour flavour
-    ) :
-        mIsItalicDefault(isItalicDefault),
-        mText(text),
-        mFlavour(flavour)
-    { }
 };
 
 // A list of all commands that get translated as identifiers,
 // their MathML translations, flavour, and whether they should be
 // rendered in italic font.
-pair<wstring, IdentifierInfo> identifierArray[] =
+const TableEntry<IdentifierInfo> identifierArray[] =
 {
-    make_pair(L"\\ker",         IdentifierInfo(false, L"ker",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\deg",         IdentifierInfo(false, L"deg",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\hom",         IdentifierInfo(false, L"hom",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\dim",         IdentifierInfo(false, L"dim",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\arg",         IdentifierInfo(false, L"arg",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\sin",         IdentifierInfo(false, L"sin",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\cos",         IdentifierInfo(false, L"cos",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\sec",         IdentifierInfo(false, L"sec",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\csc",         IdentifierInfo(false, L"csc",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\tan",         IdentifierInfo(false, L"tan",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\cot",         IdentifierInfo(false, L"cot",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\arcsin",      IdentifierInfo(false, L"arcsin",     LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\arccos",      IdentifierInfo(false, L"arccos",     LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\arctan",      IdentifierInfo(false, L"arctan",     LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\sinh",        IdentifierInfo(false, L"sinh",       LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\cosh",        IdentifierInfo(false, L"cosh",       LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\tanh",        IdentifierInfo(false, L"tanh",       LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\coth",        IdentifierInfo(false, L"coth",       LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\log",         IdentifierInfo(false, L"log",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\lg",          IdentifierInfo(false, L"lg",         LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\ln",          IdentifierInfo(false, L"ln",         LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\exp",         IdentifierInfo(false, L"exp",        LayoutTree::Node::cFlavourOp)),
-    make_pair(L"\\aleph",       IdentifierInfo(false, L"\U00002135", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\beth",        IdentifierInfo(false, L"\U00002136", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\gimel",       IdentifierInfo(false, L"\U00002137", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\daleth",      IdentifierInfo(false, L"\U00002138", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\wp",          IdentifierInfo(true,  L"\U00002118", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\ell",         IdentifierInfo(true,  L"\U00002113", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\P",           IdentifierInfo(true,  L"\U000000B6", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\imath",       IdentifierInfo(true,  L"\U00000131", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\Finv",        IdentifierInfo(false, L"\U00002132", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\Game",        IdentifierInfo(false, L"\U00002141", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\partial",     IdentifierInfo(false, L"\U00002202", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\Re",          IdentifierInfo(false, L"\U0000211C", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\Im",          IdentifierInfo(false, L"\U00002111", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\infty",       IdentifierInfo(false, L"\U0000221E", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\hbar",        IdentifierInfo(false, L"\U00000127", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\emptyset",    IdentifierInfo(false, L"\U00002205", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\varnothing",  IdentifierInfo(false, L"\U000000D8", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\S",           IdentifierInfo(false, L"\U000000A7", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\eth",         IdentifierInfo(false, L"\U000000F0", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\hslash",      IdentifierInfo(false, L"\U0000210F", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\mho",         IdentifierInfo(false, L"\U00002127", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\circledR",    IdentifierInfo(false, L"\U000000AE", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\yen",         IdentifierInfo(false, L"\U000000A5", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\maltese",     IdentifierInfo(false, L"\U00002720", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\circledS",    IdentifierInfo(false, L"\U000024C8", LayoutTree::Node::cFlavourOrd)),
-    // FIX: these two needs special testing since they're plane-1:
+    // FIX: this and \jmath need special testing since they're plane-1:
     // FIX: need to update mediawiki to recognise these entities
-    make_pair(L"\\Bbbk",        IdentifierInfo(false, L"\U0001D55C", LayoutTree::Node::cFlavourOrd)),
-    make_pair(L"\\jmath",       IdentifierInfo(true,  L"\U0001D6A5", LayoutTree::Node::cFlavourOrd))
+    {L"\\Bbbk",        {false, L"\U0001D55C", LayoutTree::Node::cFlavourOrd}},
+    {L"\\Finv",        {false, L"\U00002132", LayoutTree::Node::cFlavourOrd}},
+    {L"\\Game",        {false, L"\U00002141", LayoutTree::Node::cFlavourOrd}},
+    {L"\\Im",          {false, L"\U00002111", LayoutTree::Node::cFlavourOrd}},
+    {L"\\P",           {true,  L"\U000000B6", LayoutTree::Node::cFlavourOrd}},
+    {L"\\Re",          {false, L"\U0000211C", LayoutTree::Node::cFlavourOrd}},
+    {L"\\S",           {false, L"\U000000A7", LayoutTree::Node::cFlavourOrd}},
+    {L"\\aleph",       {false, L"\U00002135", LayoutTree::Node::cFlavourOrd}},
+    {L"\\arccos",      {false, L"arccos",     LayoutTree::Node::cFlavourOp}},
+    {L"\\arcsin",      {false, L"arcsin",     LayoutTree::Node::cFlavourOp}},
+    {L"\\arctan",      {false, L"arctan",     LayoutTree::Node::cFlavourOp}},
+    {L"\\arg",         {false, L"arg",        LayoutTree::Node::cFlavourOp}},
+    {L"\\beth",        {false, L"\U00002136", LayoutTree::Node::cFlavourOrd}},
+    {L"\\circledR",    {false, L"\U000000AE", LayoutTree::Node::cFlavourOrd}},
+    {L"\\circledS",    {false, L"\U000024C8", LayoutTree::Node::cFlavourOrd}},
+    {L"\\cos",         {false, L"cos",        LayoutTree::Node::cFlavourOp}},
+    {L"\\cosh",        {false, L"cosh",       LayoutTree::Node::cFlavourOp}},
+    {L"\\cot",         {false, L"cot",        LayoutTree::Node::cFlavourOp}},
+    {L"\\coth",        {false, L"coth",       LayoutTree::Node::cFlavourOp}},
+    {L"\\csc",         {false, L"csc",        LayoutTree::Node::cFlavourOp}},
+    {L"\\daleth",      {false, L"\U00002138", LayoutTree::Node::cFlavourOrd}},
+    {L"\\deg",         {false, L"deg",        LayoutTree::Node::cFlavourOp}},
+    {L"\\dim",         {false, L"dim",        LayoutTree::Node::cFlavourOp}},
+    {L"\\ell",         {true,  L"\U00002113", LayoutTree::Node::cFlavourOrd}},
+    {L"\\emptyset",    {false, L"\U00002205", LayoutTree::Node::cFlavourOrd}},
+    {L"\\eth",         {false, L"\U000000F0", LayoutTree::Node::cFlavourOrd}},
+    {L"\\exp",         {false, L"exp",        LayoutTree::Node::cFlavourOp}},
+    {L"\\gimel",       {false, L"\U00002137", LayoutTree::Node::cFlavourOrd}},
+    {L"\\hbar",        {false, L"\U00000127", LayoutTree::Node::cFlavourOrd}},
+    {L"\\hom",         {false, L"hom",        LayoutTree::Node::cFlavourOp}},
+    {L"\\hslash",      {false, L"\U0000210F", LayoutTree::Node::cFlavourOrd}},
+    {L"\\imath",       {true,  L"\U00000131", LayoutTree::Node::cFlavourOrd}},
+    {L"\\infty",       {false, L"\U0000221E", LayoutTree::Node::cFlavourOrd}},
+    {L"\\jmath",       {true,  L"\U0001D6A5", LayoutTree::Node::cFlavourOrd}},
+    {L"\\ker",         {false, L"ker",        LayoutTree::Node::cFlavourOp}},
+    {L"\\lg",          {false, L"lg",         LayoutTree::Node::cFlavourOp}},
+    {L"\\ln",          {false, L"ln",         LayoutTree::Node::cFlavourOp}},
+    {L"\\log",         {false, L"log",        LayoutTree::Node::cFlavourOp}},
+    {L"\\maltese",     {false, L"\U00002720", LayoutTree::Node::cFlavourOrd}},
+    {L"\\mho",         {false, L"\U00002127", LayoutTree::Node::cFlavourOrd}},
+    {L"\\partial",     {false, L"\U00002202", LayoutTree::Node::cFlavourOrd}},
+    {L"\\sec",         {false, L"sec",        LayoutTree::Node::cFlavourOp}},
+    {L"\\sin",         {false, L"sin",        LayoutTree::Node::cFlavourOp}},
+    {L"\\sinh",        {false, L"sinh",       LayoutTree::Node::cFlavourOp}},
+    {L"\\tan",         {false, L"tan",        LayoutTree::Node::cFlavourOp}},
+    {L"\\tanh",        {false, L"tanh",       LayoutTree::Node::cFlavourOp}},
+    {L"\\varnothing",  {false, L"\U000000D8", LayoutTree::Node::cFlavourOrd}},
+    {L"\\wp",          {true,  L"\U00002118", LayoutTree::Node::cFlavourOrd}},
+    {L"\\yen",         {false, L"\U000000A5", LayoutTree::Node::cFlavourOrd}}
+};
+
+// SymbolEncodings holds the MathML text of the symbols in the tables above
+// already XML-encoded (see EncodedText in XmlEncode.h), so that the most
+// common leaf nodes never go through XmlEncode() during a conversion.
+// Each vector runs parallel to its table, e.g. mOperators[i] is the text
+// of operatorArray[i]. mAscii is indexed by character code, and is used
+// for single letters and digits.
+struct SymbolEncodings
+{
+    vector<EncodedText> mAscii;
+    vector<EncodedText> mLowercaseGreek;
+    vector<EncodedText> mUppercaseGreek;
+    vector<EncodedText> mOperators;
+    vector<EncodedText> mIdentifiers;
+
+    SymbolEncodings();
 };
-wishful_hash_map<wstring, IdentifierInfo> identifierTable(
-    identifierArray,
-    END_ARRAY(identifierArray)
-);
+
+SymbolEncodings::SymbolEncodings()
+{
+    mAscii.reserve(0x80);
+    for (wchar_t c = 0; c < 0x80; c++)
+        mAscii.push_back(EncodedText(wstring(1, c)));
+
+    mLowercaseGreek.reserve(
+        END_ARRAY(lowercaseGreekArray) - lowercaseGreekArray
+    );
+    for (const TableEntry<wchar_t>*
+        entry = lowercaseGreekArray;
+        entry != END_ARRAY(lowercaseGreekArray);
+        entry++
+    )
+        mLowercaseGreek.push_back(EncodedText(wstring(1, entry->mValue)));
+
+    mUppercaseGreek.reserve(
+        END_ARRAY(uppercaseGreekArray) - uppercaseGreekArray
+    );
+    for (const TableEntry<wchar_t>*
+        entry = uppercaseGreekArray;
+        entry != END_ARRAY(uppercaseGreekArray);
+        entry++
+    )
+        mUppercaseGreek.push_back(EncodedText(wstring(1, entry->mValue)));
+
+    mOperators.reserve(END_ARRAY(operatorArray) - operatorArray);
+    for (const TableEntry<OperatorInfo>*
+        entry = operatorArray;
+        entry != END_ARRAY(operatorArray);
+        entry++
+    )
+        mOperators.push_back(EncodedText(entry->mValue.mText));
+
+    mIdentifiers.reserve(END_ARRAY(identifierArray) - identifierArray);
+    for (const TableEntry<IdentifierInfo>*
+        entry = identifierArray;
+        entry != END_ARRAY(identifierArray);
+        entry++
+    )
+        mIdentifiers.push_back(EncodedText(entry->mValue.mText));
+}
+
+const SymbolEncodings gSymbolEncodings;
+
+// Records in the global token table where each command in "table" is, so
+// that MathSymbol::BuildLayoutTree can find it from its Token alone. A
+// command listed in more than one table keeps the first one registered.
+template <class Value, size_t size>
+void RegisterSymbolTable(
+    const TableEntry<Value> (&table)[size],
+    unsigned char symbolTable
+)
+{
+    TokenTable& tokenTable = GetGlobalTokenTable();
+    for (size_t index = 0; index < size; index++)
+    {
+        const wchar_t* name = table[index].mName;
+        CommandInfo& info =
+            tokenTable.EditCommandInfo(tokenTable.Intern(name, wcslen(name)));
+
+        if (info.mSymbolTable == cSymbolTableNone)
+        {
+            info.mSymbolTable = symbolTable;
+            info.mSymbolIndex = static_cast<unsigned short>(index);
+        }
+    }
+}
+
+// These go in the same order that MathSymbol::BuildLayoutTree used to
+// search the tables by name.
+bool RegisterSymbolTables()
+{
+    RegisterSymbolTable(lowercaseGreekArray, cSymbolTableLowercaseGreek);
+    RegisterSymbolTable(uppercaseGreekArray, cSymbolTableUppercaseGreek);
+    RegisterSymbolTable(spaceArray, cSymbolTableSpace);
+    RegisterSymbolTable(operatorArray, cSymbolTableOperator);
+    RegisterSymbolTable(identifierArray, cSymbolTableIdentifier);
+    return true;
+}
+
+const bool gSymbolTablesRegistered = RegisterSymbolTables();
+
+// Returns the entry of "table" that "info" points at, or NULL if it
+// belongs to a different table (or none).
+template <class Value>
+const TableEntry<Value>* FindSymbol(
+    const TableEntry<Value>* table,
+    unsigned char symbolTable,
+    const CommandInfo& info
+)
+{
+    return info.mSymbolTable == symbolTable
+        ? table + info.mSymbolIndex : NULL;
+}
 
 
 namespace ParseTree
@@ -701,8 +762,9 @@ auto_ptr<LayoutTree::Node> MathSymbol::BuildLayoutTree(
                     L"UnavailableSymbolFontCombination", mCommand, L"bb"
                 );
 
+            auto_ptr<LayoutTree::Symbol> symbol;
             if (isNumber)
-                return auto_ptr<LayoutTree::Node>(
+                symbol.reset(
                     new LayoutTree::SymbolNumber(
                         mCommand,
                         font.GetMathmlApproximation(),
@@ -713,7 +775,7 @@ auto_ptr<LayoutTree::Node> MathSymbol::BuildLayoutTree(
                     )
                 );
             else
-                return auto_ptr<LayoutTree::Node>(
+                symbol.reset(
                     new LayoutTree::SymbolIdentifier(
                         mCommand,
                         font.GetMathmlApproximation(),
@@ -723,6 +785,8 @@ auto_ptr<LayoutTree::Node> MathSymbol::BuildLayoutTree(
                         state.mColour
                     )
                 );
+            symbol->mEncodedText = &gSymbolEncodings.mAscii[mCommand[0]];
+            return static_cast<auto_ptr<LayoutTree::Node> >(symbol);
         }
 
         // Non-ascii characters
@@ -733,14 +797,17 @@ auto_ptr<LayoutTree::Node> MathSymbol::BuildLayoutTree(
             );
     }
 
-    wishful_hash_map<wstring, wchar_t>::const_iterator
-        lowercaseGreekLookup = lowercaseGreekTable.find(mCommand);
+    const CommandInfo& info = GetGlobalTokenTable().GetCommandInfo(mToken);
+
+    const TableEntry<wchar_t>* lowercaseGreekLookup = FindSymbol(
+        lowercaseGreekArray, cSymbolTableLowercaseGreek, info
+    );
 
-    if (lowercaseGreekLookup != lowercaseGreekTable.end())
+    if (lowercaseGreekLookup)
     {
-        return auto_ptr<LayoutTree::Node>(
+        auto_ptr<LayoutTree::Symbol> symbol(
             new LayoutTree::SymbolIdentifier(
-                wstring(1, lowercaseGreekLookup->second),
+                wstring(1, lowercaseGreekLookup->mValue),
                 // lowercase greek is only affected by the boldsymbol
                 // status, not the family.
                 state.mMathFont.mIsBoldsymbol
@@ -751,12 +818,17 @@ auto_ptr<LayoutTree::Node> MathSymbol::BuildLayoutTree(
                 state.mColour
             )
         );
+        symbol->mEncodedText = &gSymbolEncodings.mLowercaseGreek[
+            lowercaseGreekLookup - lowercaseGreekArray
+        ];
+        return static_cast<auto_ptr<LayoutTree::Node> >(symbol);
     }
 
-    wishful_hash_map<wstring, wchar_t>::const_iterator
-        uppercaseGreekLookup = uppercaseGreekTable.find(mCommand);
+    const TableEntry<wchar_t>* uppercaseGreekLookup = FindSymbol(
+        uppercaseGreekArray, cSymbolTableUppercaseGreek, info
+    );
 
-    if (uppercaseGreekLookup != uppercaseGreekTable.end())
+    if (uppercaseGreekLookup)
     {
         TexMathFont font = state.mMathFont;
         if (font.mFamily == TexMathFont::cFamilyCal)
@@ -777,9 +849,9 @@ auto_ptr<LayoutTree::Node> MathSymbol::BuildLayoutTree(
         if (font.mFamily == TexMathFont::cFamilyDefault)
             font.mFamily = TexMathFont::cFamilyRm;
 
-        return auto_ptr<LayoutTree::Node>(
+        auto_ptr<LayoutTree::Symbol> symbol(
             new LayoutTree::SymbolIdentifier(
-                wstring(1, uppercaseGreekLookup->second),
+                wstring(1, uppercaseGreekLookup->mValue),
                 font.GetMathmlApproximation(),
                 state.mStyle,
                 LayoutTree::Node::cFlavourOrd,
@@ -787,62 +859,69 @@ auto_ptr<LayoutTree::Node> MathSymbol::BuildLayoutTree(
                 state.mColour
             )
         );
+        symbol->mEncodedText = &gSymbolEncodings.mUppercaseGreek[
+            uppercaseGreekLookup - uppercaseGreekArray
+        ];
+        return static_cast<auto_ptr<LayoutTree::Node> >(symbol);
     }
 
-    wishful_hash_map<wstring, int>::const_iterator
-        spaceLookup = spaceTable.find(mCommand);
+    const TableEntry<int>* spaceLookup =
+        FindSymbol(spaceArray, cSymbolTableSpace, info);
 
-    if (spaceLookup != spaceTable.end())
+    if (spaceLookup)
     {
         return auto_ptr<LayoutTree::Node>(
             new LayoutTree::Space(
-                spaceLookup->second,
+                spaceLookup->mValue,
                 true      // true = indicates a user-requested space
             )
         );
     }
 
-    wishful_hash_map<wstring, OperatorInfo>::const_iterator
-        operatorLookup = operatorTable.find(mCommand);
+    const TableEntry<OperatorInfo>* operatorLookup =
+        FindSymbol(operatorArray, cSymbolTableOperator, info);
 
-    if (operatorLookup != operatorTable.end())
+    if (operatorLookup)
     {
-        return auto_ptr<LayoutTree::Node>(
+        auto_ptr<LayoutTree::Symbol> symbol(
             new LayoutTree::SymbolOperator(
                 false, L"",     // not stretchy
                 false,          // not an accent
-                operatorLookup->second.mText,
+                operatorLookup->mValue.mText,
                 // operators are only affected by the boldsymbol status,
                 // not the family.
                 state.mMathFont.mIsBoldsymbol
                     ? cMathmlFontBold : cMathmlFontNormal,
                 state.mStyle,
-                operatorLookup->second.mFlavour,
-                operatorLookup->second.mLimits,
+                operatorLookup->mValue.mFlavour,
+                operatorLookup->mValue.mLimits,
                 state.mColour
             )
         );
+        symbol->mEncodedText =
+            &gSymbolEncodings.mOperators[operatorLookup - operatorArray];
+        return static_cast<auto_ptr<LayoutTree::Node> >(symbol);
     }
 
-    wishful_hash_map<wstring, IdentifierInfo>::const_iterator
-        identifierLookup = identifierTable.find(mCommand);
+    const TableEntry<IdentifierInfo>* identifierLookup =
+        FindSymbol(identifierArray, cSymbolTableIdentifier, info);
 
-    if (identifierLookup != identifierTable.end())
+    if (identifierLookup)
     {
         TexMathFont font = state.mMathFont;
         font.mFamily =
-            identifierLookup->second.mIsItalicDefault
+            identifierLookup->mValue.mIsItalicDefault
                 ? TexMathFont::cFamilyIt : TexMathFont::cFamilyRm;
 
-        return auto_ptr<LayoutTree::Node>(
+        auto_ptr<LayoutTree::Symbol> symbol(
             new LayoutTree::SymbolIdentifier(
-                identifierLookup->second.mText,
+                identifierLookup->mValue.mText,
                 font.GetMathmlApproximation(),
                 state.mStyle,
-                identifierLookup->second.mFlavour,
+                identifierLookup->mValue.mFlavour,
                 // For all the "\sin"-like functions:
                 (
-                    identifierLookup->second.mFlavour ==
+                    identifierLookup->mValue.mFlavour ==
                     LayoutTree::Node::cFlavourOp
                 )
                     ? LayoutTree::Node::cLimitsNoLimits
@@ -850,6 +929,9 @@ auto_ptr<LayoutTree::Node> MathSymbol::BuildLayoutTree(
                 state.mColour
             )
         );
+        symbol->mEncodedText =
+            &gSymbolEncodings.mIdentifiers[identifierLookup - identifierArray];
+        return static_cast<auto_ptr<LayoutTree::Node> >(symbol);
     }
 
     if (mCommand == L"\\And")
@@ -19,7 +19,8 @@
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
 #include <stdexcept>
-#include <set>
+#include <algorithm>
+#include <cwchar>
 #include <iomanip>
 #include <sstream>
 #include "ParseTree.h"
@@ -30,90 +31,91 @@ namespace blahtex
 {
 
 // List of colour names that we know about.
-pair<wstring, RGBColour> gColourArray[] =
-{
-    make_pair(L"GreenYellow",         0xd8ff4f),
-    make_pair(L"Yellow",              0xffff00),
-    make_pair(L"yellow",              0xffff00),
-    make_pair(L"Goldenrod",           0xffe528),
-    make_pair(L"Dandelion",           0xffb528),
-    make_pair(L"Apricot",             0xffad7a),
-    make_pair(L"Peach",               0xff7f4c),
-    make_pair(L"Melon",               0xff897f),
-    make_pair(L"YellowOrange",        0xff9300),
-    make_pair(L"Orange",              0xff6321),
-    make_pair(L"BurntOrange",         0xff7c00),
-    make_pair(L"Bittersweet",         0xc10200),
-    make_pair(L"RedOrange",           0xff3a21),
-    make_pair(L"Mahogany",            0xa50000),
-    make_pair(L"Maroon",              0xad0000),
-    make_pair(L"BrickRed",            0xb70000),
-    make_pair(L"Red",                 0xff0000),
-    make_pair(L"red",                 0xff0000),
-    make_pair(L"OrangeRed",           0xff007f),
-    make_pair(L"RubineRed",           0xff00dd),
-    make_pair(L"WildStrawberry",      0xff0a9b),
-    make_pair(L"Salmon",              0xff779e),
-    make_pair(L"CarnationPink",       0xff5eff),
-    make_pair(L"Magenta",             0xff00ff),
-    make_pair(L"magenta",             0xff00ff),
-    make_pair(L"VioletRed",           0xff30ff),
-    make_pair(L"Rhodamine",           0xff2dff),
-    make_pair(L"Mulberry",            0xa314f9),
-    make_pair(L"RedViolet",           0x9600a8),
-    make_pair(L"Fuchsia",             0x7202ea),
-    make_pair(L"Lavender",            0xff84ff),
-    make_pair(L"Thistle",             0xe068ff),
-    make_pair(L"Orchid",              0xad5bff),
-    make_pair(L"DarkOrchid",          0x9933cc),
-    make_pair(L"Purple",              0x8c23ff),
-    make_pair(L"Plum",                0x7f00ff),
-    make_pair(L"Violet",              0x351eff),
-    make_pair(L"RoyalPurple",         0x3f19ff),
-    make_pair(L"BlueViolet",          0x190cf4),
-    make_pair(L"Periwinkle",          0x6d72ff),
-    make_pair(L"CadetBlue",           0x606dc4),
-    make_pair(L"CornflowerBlue",      0x59ddff),
-    make_pair(L"MidnightBlue",        0x007091),
-    make_pair(L"NavyBlue",            0x0f75ff),
-    make_pair(L"RoyalBlue",           0x007fff),
-    make_pair(L"Blue",                0x0000ff),
-    make_pair(L"blue",                0x0000ff),
-    make_pair(L"Cerulean",            0x0fe2ff),
-    make_pair(L"Cyan",                0x00ffff),
-    make_pair(L"cyan",                0x00ffff),
-    make_pair(L"ProcessBlue",         0x0affff),
-    make_pair(L"SkyBlue",             0x60ffe0),
-    make_pair(L"Turquoise",           0x26ffcc),
-    make_pair(L"TealBlue",            0x1ef9a3),
-    make_pair(L"Aquamarine",          0x2dffb2),
-    make_pair(L"BlueGreen",           0x26ffaa),
-    make_pair(L"Emerald",             0x00ff7f),
-    make_pair(L"JungleGreen",         0x02ff7a),
-    make_pair(L"SeaGreen",            0x4fff7f),
-    make_pair(L"Green",               0x00ff00),
-    make_pair(L"green",               0x00ff00),
-    make_pair(L"ForestGreen",         0x00e000),
-    make_pair(L"PineGreen",           0x00bf28),
-    make_pair(L"LimeGreen",           0x7fff00),
-    make_pair(L"YellowGreen",         0x8eff42),
-    make_pair(L"SpringGreen",         0xbcff3d),
-    make_pair(L"OliveGreen",          0x009900),
-    make_pair(L"RawSienna",           0x8c0000),
-    make_pair(L"Sepia",               0x4c0000),
-    make_pair(L"Brown",               0x660000),
-    make_pair(L"Tan",                 0xdb9370),
-    make_pair(L"Gray",                0x7f7f7f),
-    make_pair(L"Black",               0x000000),
-    make_pair(L"black",               0x000000),
-    make_pair(L"White",               0xffffff),
-    make_pair(L"white",               0xffffff)
+static const TableEntry<RGBColour> gColourArray[] =
+{
+    {L"Apricot",             0xffad7a},
+    {L"Aquamarine",          0x2dffb2},
+    {L"Bittersweet",         0xc10200},
+    {L"Black",               0x000000},
+    {L"Blue",                0x0000ff},
+    {L"BlueGreen",           0x26ffaa},
+    {L"BlueViolet",          0x190cf4},
+    {L"BrickRed",            0xb70000},
+    {L"Brown",               0x660000},
+    {L"BurntOrange",         0xff7c00},
+    {L"CadetBlue",           0x606dc4},
+    {L"CarnationPink",       0xff5eff},
+    {L"Cerulean",            0x0fe2ff},
+    {L"CornflowerBlue",      0x59ddff},
+    {L"Cyan",                0x00ffff},
+    {L"Dandelion",           0xffb528},
+    {L"DarkOrchid",          0x9933cc},
+    {L"Emerald",             0x00ff7f},
+    {L"ForestGreen",         0x00e000},
+    {L"Fuchsia",             0x7202ea},
+    {L"Goldenrod",           0xffe528},
+    {L"Gray",                0x7f7f7f},
+    {L"Green",               0x00ff00},
+    {L"GreenYellow",         0xd8ff4f},
+    {L"JungleGreen",         0x02ff7a},
+    {L"Lavender",            0xff84ff},
+    {L"LimeGreen",           0x7fff00},
+    {L"Magenta",             0xff00ff},
+    {L"Mahogany",            0xa50000},
+    {L"Maroon",              0xad0000},
+    {L"Melon",               0xff897f},
+    {L"MidnightBlue",        0x007091},
+    {L"Mulberry",            0xa314f9},
+    {L"NavyBlue",            0x0f75ff},
+    {L"OliveGreen",          0x009900},
+    {L"Orange",              0xff6321},
+    {L"OrangeRed",           0xff007f},
+    {L"Orchid",              0xad5bff},
+    {L"Peach",               0xff7f4c},
+    {L"Periwinkle",          0x6d72ff},
+    {L"PineGreen",           0x00bf28},
+    {L"Plum",                0x7f00ff},
+    {L"ProcessBlue",         0x0affff},
+    {L"Purple",              0x8c23ff},
+    {L"RawSienna",           0x8c0000},
+    {L"Red",                 0xff0000},
+    {L"RedOrange",           0xff3a21},
+    {L"RedViolet",           0x9600a8},
+    {L"Rhodamine",           0xff2dff},
+    {L"RoyalBlue",           0x007fff},
+    {L"RoyalPurple",         0x3f19ff},
+    {L"RubineRed",           0xff00dd},
+    {L"Salmon",              0xff779e},
+    {L"SeaGreen",            0x4fff7f},
+    {L"Sepia",               0x4c0000},
+    {L"SkyBlue",             0x60ffe0},
+    {L"SpringGreen",         0xbcff3d},
+    {L"Tan",                 0xdb9370},
+    {L"TealBlue",            0x1ef9a3},
+    {L"Thistle",             0xe068ff},
+    {L"Turquoise",           0x26ffcc},
+    {L"Violet",              0x351eff},
+    {L"VioletRed",           0xff30ff},
+    {L"White",               0xffffff},
+    {L"WildStrawberry",      0xff0a9b},
+    {L"Yellow",              0xffff00},
+    {L"YellowGreen",         0x8eff42},
+    {L"YellowOrange",        0xff9300},
+    {L"black",               0x000000},
+    {L"blue",                0x0000ff},
+    {L"cyan",                0x00ffff},
+    {L"green",               0x00ff00},
+    {L"magenta",             0xff00ff},
+    {L"red",                 0xff0000},
+    {L"white",               0xffffff},
+    {L"yellow",              0xffff00}
 };
 
-wishful_hash_map<wstring, RGBColour> gColourTable(
-    gColourArray,
-    END_ARRAY(gColourArray)
-);
+// Used by the parser to check colour names.
+bool IsColourName(const wstring& name)
+{
+    return FindEntry(gColourArray, name) != NULL;
+}
 
 
 MathmlFont TexMathFont::GetMathmlApproximation() const
@@ -186,7 +188,7 @@ namespace ParseTree
 
 MathList::~MathList()
 {
-    for (vector<MathNode*>::iterator
+    for (MathNodeVector::iterator
         p = mChildren.begin(); p != mChildren.end(); p++
     )
         delete *p;
@@ -194,7 +196,7 @@ MathList::~MathList()
 
 MathTableRow::~MathTableRow()
 {
-    for (vector<MathNode*>::iterator
+    for (MathNodeVector::iterator
         p = mEntries.begin(); p != mEntries.end(); p++
     )
         delete *p;
@@ -202,7 +204,7 @@ MathTableRow::~MathTableRow()
 
 MathTable::~MathTable()
 {
-    for (vector<MathTableRow*>::iterator
+    for (MathTableRowVector::iterator
         p = mRows.begin(); p != mRows.end(); p++
     )
         delete *p;
@@ -210,7 +212,7 @@ MathTable::~MathTable()
 
 TextList::~TextList()
 {
-    for (vector<TextNode*>::iterator
+    for (TextNodeVector::iterator
         p = mChildren.begin(); p != mChildren.end(); p++
     )
         delete *p;
@@ -221,52 +223,45 @@ TextList::~TextList()
 // Implementations of ParseTree::MathStateChange/TextStateChange::Apply
 
 
+static const TableEntry<LayoutTree::Node::Style> gStyleCommandArray[] =
+{
+    {L"\\displaystyle",       LayoutTree::Node::cStyleDisplay},
+    {L"\\scriptscriptstyle",  LayoutTree::Node::cStyleScriptScript},
+    {L"\\scriptstyle",        LayoutTree::Node::cStyleScript},
+    {L"\\textstyle",          LayoutTree::Node::cStyleText}
+};
+
+
+static const TableEntry<TexMathFont::Family> gFontCommandArray[] =
+{
+    {L"\\bf",     TexMathFont::cFamilyBf},
+    {L"\\cal",    TexMathFont::cFamilyCal},
+    {L"\\it",     TexMathFont::cFamilyIt},
+    {L"\\rm",     TexMathFont::cFamilyRm},
+    {L"\\sf",     TexMathFont::cFamilySf},
+    {L"\\tt",     TexMathFont::cFamilyTt}
+};
+
+
 void MathStateChange::Apply(
     TexProcessingState& state
 ) const
 {
-    static pair<wstring, LayoutTree::Node::Style> styleCommandArray[] =
-    {
-        make_pair(L"\\displaystyle",       LayoutTree::Node::cStyleDisplay),
-        make_pair(L"\\textstyle",          LayoutTree::Node::cStyleText),
-        make_pair(L"\\scriptstyle",        LayoutTree::Node::cStyleScript),
-        make_pair(L"\\scriptscriptstyle",  LayoutTree::Node::cStyleScriptScript)
-    };
-    static wishful_hash_map<wstring, LayoutTree::Node::Style>
-        styleCommandTable(
-            styleCommandArray,
-            END_ARRAY(styleCommandArray)
-        );
+    const TableEntry<LayoutTree::Node::Style>* styleCommand =
+        FindEntry(gStyleCommandArray, mCommand);
 
-    wishful_hash_map<wstring, LayoutTree::Node::Style>::const_iterator
-        styleCommand = styleCommandTable.find(mCommand);
-
-    if (styleCommand != styleCommandTable.end())
+    if (styleCommand)
     {
-        state.mStyle = styleCommand->second;
+        state.mStyle = styleCommand->mValue;
         return;
     }
 
-    static pair<wstring, TexMathFont::Family> fontCommandArray[] =
-    {
-        make_pair(L"\\rm",     TexMathFont::cFamilyRm),
-        make_pair(L"\\bf",     TexMathFont::cFamilyBf),
-        make_pair(L"\\it",     TexMathFont::cFamilyIt),
-        make_pair(L"\\cal",    TexMathFont::cFamilyCal),
-        make_pair(L"\\tt",     TexMathFont::cFamilyTt),
-        make_pair(L"\\sf",     TexMathFont::cFamilySf)
-    };
-    static wishful_hash_map<wstring, TexMathFont::Family> fontCommandTable(
-        fontCommandArray,
-        END_ARRAY(fontCommandArray)
-    );
-
-    wishful_hash_map<wstring, TexMathFont::Family>::const_iterator
-        fontCommand = fontCommandTable.find(mCommand);
+    const TableEntry<TexMathFont::Family>* fontCommand =
+        FindEntry(gFontCommandArray, mCommand);
 
-    if (fontCommand != fontCommandTable.end())
+    if (fontCommand)
     {
-        state.mMathFont.mFamily = fontCommand->second;
+        state.mMathFont.mFamily = fontCommand->mValue;
         return;
     }
 
@@ -276,32 +271,29 @@ void MathStateChange::Apply(
 }
 
 
+static const TableEntry<TexTextFontEntry> gTextCommandArray[] =
+{                                                       //  bold?  italic?
+    {L"\\bf",  {TexTextFont::cFamilyRm, true,  false}},
+    {L"\\it",  {TexTextFont::cFamilyRm, false, true}},
+    {L"\\rm",  {TexTextFont::cFamilyRm, false, false}},
+    {L"\\sf",  {TexTextFont::cFamilySf, false, false}},
+    {L"\\tt",  {TexTextFont::cFamilyTt, false, false}}
+};
+
+
 void TextStateChange::Apply(
     TexProcessingState& state
 ) const
 {
-    static pair<wstring, TexTextFont> textCommandArray[] =
-    {                                                       //  bold?  italic?
-        make_pair(L"\\rm",  TexTextFont(TexTextFont::cFamilyRm, false, false)),
-        make_pair(L"\\it",  TexTextFont(TexTextFont::cFamilyRm, false, true)),
-        make_pair(L"\\bf",  TexTextFont(TexTextFont::cFamilyRm, true,  false)),
-        make_pair(L"\\sf",  TexTextFont(TexTextFont::cFamilySf, false, false)),
-        make_pair(L"\\tt",  TexTextFont(TexTextFont::cFamilyTt, false, false)),
-    };
-    static wishful_hash_map<wstring, TexTextFont> textCommandTable(
-        textCommandArray,
-        END_ARRAY(textCommandArray)
-    );
-
-    wishful_hash_map<wstring, TexTextFont>::iterator
-        textCommand = textCommandTable.find(mCommand);
+    const TableEntry<TexTextFontEntry>* textCommand =
+        FindEntry(gTextCommandArray, mCommand);
 
-    if (textCommand == textCommandTable.end())
+    if (!textCommand)
         throw logic_error(
             "Unexpected command in TextStateChange::Apply"
         );
 
-    state.mTextFont = textCommand->second;
+    state.mTextFont = textCommand->mValue.GetFont();
 }
 
 
@@ -309,17 +301,17 @@ void MathColour::Apply(
     TexProcessingState& state
 ) const
 {
-    wishful_hash_map<wstring, RGBColour>::const_iterator
-        colourLookup = gColourTable.find(mColourName);
+    const TableEntry<RGBColour>* colourLookup =
+        FindEntry(gColourArray, mColourName);
 
-    if (colourLookup == gColourTable.end())
+    if (!colourLookup)
         // This shouldn't happen because we checked the colour name during
         // parsing stage
         throw logic_error(
             "Cannot find colour name in MathColour::Apply"
         );
 
-    state.mColour = colourLookup->second;
+    state.mColour = colourLookup->mValue;
 }
 
 
@@ -327,17 +319,17 @@ void TextColour::Apply(
     TexProcessingState& state
 ) const
 {
-    wishful_hash_map<wstring, RGBColour>::const_iterator
-        colourLookup = gColourTable.find(mColourName);
+    const TableEntry<RGBColour>* colourLookup =
+        FindEntry(gColourArray, mColourName);
 
-    if (colourLookup == gColourTable.end())
+    if (!colourLookup)
         // This shouldn't happen because we checked the colour name during
         // parsing stage
         throw logic_error(
             "Cannot find colour name in TextColour::Apply"
         );
 
-    state.mColour = colourLookup->second;
+    state.mColour = colourLookup->mValue;
 }
 
 
@@ -345,334 +337,351 @@ void TextColour::Apply(
 // Implementations of ParseTree::Node::GetPurifiedTex()
 
 
-void LatexFeatures::Update(const wstring& command)
+static const wchar_t* const gNeedsAmsmathArray[] =
+{
+    L"\\And",
+    L"\\binom",
+    L"\\boldsymbol",
+    L"\\cfrac",
+    L"\\dotsb",
+    L"\\iiiint",
+    L"\\iiint",
+    L"\\iint",
+    L"\\injlim",
+    L"\\lVert",
+    L"\\lvert",
+    L"\\mod",
+    L"\\operatorname",
+    L"\\operatornamewithlimits",
+    L"\\overleftrightarrow",
+    L"\\overset",
+    L"\\projlim",
+    L"\\rVert",
+    L"\\rvert",
+    L"\\text",
+    L"\\underset",
+    L"\\varinjlim",
+    L"\\varliminf",
+    L"\\varlimsup",
+    L"\\varprojlim"
+};
+
+// The following commands are all defined in regular latex, but amsmath
+// redefines them to have slightly different properties:
+//
+//  * The text commands are modified so that the font size does not
+//    change if they are used inside a formula.
+//  * The "\dots" command adjusts the height of the dots depending
+//    on the surrounding symbols.
+//  * The "\colon" command gets some spacing adjustments.
+//
+// Therefore for consistency we include amsmath when these commands
+// appear.
+//
+// (FIX: there are probably others that need to be here that I
+// haven't put here yet.)
+static const wchar_t* const gRedefinedByAmsmathArray[] =
+{
+    L"\\colon",
+    L"\\dots",
+    L"\\emph",
+    L"\\textbf",
+    L"\\textit",
+    L"\\textrm",
+    L"\\textsf",
+    L"\\texttt"
+};
+
+static const wchar_t* const gNeedsAmssymbArray[] =
+{
+    L"\\Bbbk",
+    L"\\Box",
+    L"\\Bumpeq",
+    L"\\Cap",
+    L"\\Cup",
+    L"\\Finv",
+    L"\\Game",
+    L"\\Join",
+    L"\\Lleftarrow",
+    L"\\Lsh",
+    L"\\Rrightarrow",
+    L"\\Rsh",
+    L"\\Subset",
+    L"\\Supset",
+    L"\\Vdash",
+    L"\\Vvdash",
+    L"\\approxeq",
+    L"\\backepsilon",
+    L"\\backprime",
+    L"\\backsim",
+    L"\\backsimeq",
+    L"\\barwedge",
+    L"\\because",
+    L"\\beth",
+    L"\\between",
+    L"\\bigstar",
+    L"\\blacklozenge",
+    L"\\blacksquare",
+    L"\\blacktriangle",
+    L"\\blacktriangledown",
+    L"\\blacktriangleleft",
+    L"\\blacktriangleright",
+    L"\\boxdot",
+    L"\\boxminus",
+    L"\\boxplus",
+    L"\\boxtimes",
+    L"\\bumpeq",
+    L"\\centerdot",
+    L"\\checkmark",
+    L"\\circeq",
+    L"\\circlearrowleft",
+    L"\\circlearrowright",
+    L"\\circledR",
+    L"\\circledS",
+    L"\\circledast",
+    L"\\circledcirc",
+    L"\\circleddash",
+    L"\\complement",
+    L"\\curlyeqprec",
+    L"\\curlyeqsucc",
+    L"\\curlyvee",
+    L"\\curlywedge",
+    L"\\curvearrowleft",
+    L"\\curvearrowright",
+    L"\\daleth",
+    L"\\dasharrow",
+    L"\\dashleftarrow",
+    L"\\dashrightarrow",
+    L"\\diagdown",
+    L"\\diagup",
+    L"\\digamma",
+    L"\\divideontimes",
+    L"\\doteqdot",
+    L"\\dotplus",
+    L"\\doublebarwedge",
+    L"\\downdownarrows",
+    L"\\downharpoonleft",
+    L"\\downharpoonright",
+    L"\\eqcirc",
+    L"\\eqsim",
+    L"\\eqslantgtr",
+    L"\\eqslantless",
+    L"\\eth",
+    L"\\fallingdotseq",
+    L"\\geqq",
+    L"\\geqslant",
+    L"\\ggg",
+    L"\\gimel",
+    L"\\gnapprox",
+    L"\\gneqq",
+    L"\\gnsim",
+    L"\\gtrapprox",
+    L"\\gtrdot",
+    L"\\gtreqless",
+    L"\\gtreqqless",
+    L"\\gtrless",
+    L"\\gtrsim",
+    L"\\gvertneqq",
+    L"\\hslash",
+    L"\\intercal",
+    L"\\leadsto",
+    L"\\leftarrowtail",
+    L"\\leftleftarrows",
+    L"\\leftrightarrows",
+    L"\\leftrightharpoons",
+    L"\\leftrightsquigarrow",
+    L"\\leftthreetimes",
+    L"\\leqq",
+    L"\\leqslant",
+    L"\\lessapprox",
+    L"\\lessdot",
+    L"\\lesseqgtr",
+    L"\\lesseqqgtr",
+    L"\\lessgtr",
+    L"\\lesssim",
+    L"\\lhd",
+    L"\\llcorner",
+    L"\\lll",
+    L"\\lnapprox",
+    L"\\lneqq",
+    L"\\lnsim",
+    L"\\looparrowleft",
+    L"\\looparrowright",
+    L"\\lozenge",
+    L"\\lrcorner",
+    L"\\ltimes",
+    L"\\lvertneqq",
+    L"\\maltese",
+    L"\\measuredangle",
+    L"\\mho",
+    L"\\multimap",
+    L"\\nLeftarrow",
+    L"\\nLeftrightarrow",
+    L"\\nRightarrow",
+    L"\\nVDash",
+    L"\\nVdash",
+    L"\\ncong",
+    L"\\nexists",
+    L"\\ngeq",
+    L"\\ngeqq",
+    L"\\ngeqslant",
+    L"\\ngtr",
+    L"\\nleftarrow",
+    L"\\nleftrightarrow",
+    L"\\nleq",
+    L"\\nleqq",
+    L"\\nleqslant",
+    L"\\nless",
+    L"\\nmid",
+    L"\\nparallel",
+    L"\\nprec",
+    L"\\npreceq",
+    L"\\nrightarrow",
+    L"\\nshortmid",
+    L"\\nshortparallel",
+    L"\\nsim",
+    L"\\nsubseteq",
+    L"\\nsubseteqq",
+    L"\\nsucc",
+    L"\\nsucceq",
+    L"\\nsupseteq",
+    L"\\nsupseteqq",
+    L"\\ntriangleleft",
+    L"\\ntrianglelefteq",
+    L"\\ntriangleright",
+    L"\\ntrianglerighteq",
+    L"\\nvDash",
+    L"\\nvdash",
+    L"\\pitchfork",
+    L"\\precapprox",
+    L"\\preccurlyeq",
+    L"\\precnapprox",
+    L"\\precneqq",
+    L"\\precnsim",
+    L"\\precsim",
+    L"\\rhd",
+    L"\\rightarrowtail",
+    L"\\rightleftarrows",
+    L"\\rightleftharpoons",
+    L"\\rightrightarrows",
+    L"\\rightsquigarrow",
+    L"\\rightthreetimes",
+    L"\\risingdotseq",
+    L"\\rtimes",
+    L"\\shortmid",
+    L"\\shortparallel",
+    L"\\smallfrown",
+    L"\\smallsetminus",
+    L"\\smallsmile",
+    L"\\sphericalangle",
+    L"\\sqsubset",
+    L"\\sqsupset",
+    L"\\square",
+    L"\\subseteqq",
+    L"\\subsetneq",
+    L"\\subsetneqq",
+    L"\\succapprox",
+    L"\\succcurlyeq",
+    L"\\succnapprox",
+    L"\\succneqq",
+    L"\\succnsim",
+    L"\\succsim",
+    L"\\supseteqq",
+    L"\\supsetneq",
+    L"\\supsetneqq",
+    L"\\therefore",
+    L"\\thickapprox",
+    L"\\thicksim",
+    L"\\triangledown",
+    L"\\triangleq",
+    L"\\twoheadleftarrow",
+    L"\\twoheadrightarrow",
+    L"\\ulcorner",
+    L"\\unlhd",
+    L"\\unrhd",
+    L"\\upharpoonleft",
+    L"\\upharpoonright",
+    L"\\upuparrows",
+    L"\\urcorner",
+    L"\\vDash",
+    L"\\varkappa",
+    L"\\varnothing",
+    L"\\varpropto",
+    L"\\varsubsetneq",
+    L"\\varsubsetneqq",
+    L"\\varsupsetneq",
+    L"\\varsupsetneqq",
+    L"\\vartriangle",
+    L"\\vartriangleleft",
+    L"\\vartriangleright",
+    L"\\veebar",
+    L"\\yen"
+};
+
+static const wchar_t* const gNeedsAmsfontsArray[] =
+{
+    L"\\mathbb",
+    L"\\mathfrak"
+};
+
+// Sets "feature" in the CommandInfo of each command in the list.
+template <size_t size>
+void RegisterFeature(
+    const wchar_t* const (&list)[size],
+    unsigned char feature
+)
+{
+    TokenTable& tokenTable = GetGlobalTokenTable();
+    for (size_t index = 0; index < size; index++)
+        tokenTable.EditCommandInfo(
+            tokenTable.Intern(list[index], wcslen(list[index]))
+        ).mFeatures |= feature;
+}
+
+// Records in the global token table which LaTeX packages each command
+// needs, so that LatexFeatures::Update can work from the Token alone.
+bool RegisterFeatures()
+{
+    RegisterFeature(gNeedsAmsmathArray, cFeatureAmsmath);
+    RegisterFeature(gRedefinedByAmsmathArray, cFeatureAmsmath);
+    RegisterFeature(gNeedsAmssymbArray, cFeatureAmssymb);
+    RegisterFeature(gNeedsAmsfontsArray, cFeatureAmsfonts);
+
+    TokenTable& tokenTable = GetGlobalTokenTable();
+    tokenTable.EditCommandInfo(tokenTable.Intern(L"\\cyr")).mFeatures |=
+        cFeatureCyrillic;
+    tokenTable.EditCommandInfo(tokenTable.Intern(L"\\jap")).mFeatures |=
+        cFeatureJapanese;
+    return true;
+}
+
+const bool gFeaturesRegistered = RegisterFeatures();
+
+} // end ParseTree namespace
+
+void LatexFeatures::Update(Token command)
 {
-    static wstring gNeedsAmsmathArray[] =
-    {
-        L"\\text",
-        L"\\binom",
-        L"\\cfrac",
-        L"\\begin{matrix}",
-        L"\\begin{pmatrix}",
-        L"\\begin{bmatrix}",
-        L"\\begin{Bmatrix}",
-        L"\\begin{vmatrix}",
-        L"\\begin{Vmatrix}",
-        L"\\begin{cases}",
-        L"\\begin{aligned}",
-        L"\\begin{smallmatrix}",
-        L"\\overleftrightarrow",
-        L"\\boldsymbol",
-        L"\\And",
-        L"\\iint",
-        L"\\iiint",
-        L"\\iiiint",
-        L"\\varlimsup",
-        L"\\varliminf",
-        L"\\varinjlim",
-        L"\\varprojlim",
-        L"\\injlim",
-        L"\\projlim",
-        L"\\dotsb",
-        L"\\operatorname",
-        L"\\operatornamewithlimits",
-        L"\\lvert",
-        L"\\rvert",
-        L"\\lVert",
-        L"\\rVert",
-        L"\\substack",
-        L"\\overset",
-        L"\\underset",
-        L"\\mod",
-
-        // The following commands are all defined in regular latex, but
-        // amsmath redefines them to have slightly different properties:
-        //
-        //  * The text commands are modified so that the font size does not
-        //    change if they are used inside a formula.
-        //  * The "\dots" command adjusts the height of the dots depending
-        //    on the surrounding symbols.
-        //  * The "\colon" command gets some spacing adjustments.
-        //
-        // Therefore for consistency we include amsmath when these commands
-        // appear.
-        //
-        // (FIX: there are probably others that need to be here that I
-        // haven't put here yet.)
-        L"\\emph",
-        L"\\textit",
-        L"\\textbf",
-        L"\\textrm",
-        L"\\texttt",
-        L"\\textsf",
-        L"\\dots",
-        L"\\dotsb",
-        L"\\colon"
-    };
-
-    static wishful_hash_set<wstring> gNeedsAmsmathTable(
-        gNeedsAmsmathArray,
-        END_ARRAY(gNeedsAmsmathArray)
-    );
-        
 
-    static wstring gNeedsAmssymbArray[] =
-    {
-        L"\\varkappa",
-        L"\\digamma",
-        L"\\beth",
-        L"\\gimel",
-        L"\\daleth",
-        L"\\Finv",
-        L"\\Game",
-        L"\\upharpoonright",
-        L"\\upharpoonleft",
-        L"\\downharpoonright",
-        L"\\downharpoonleft",
-        L"\\nleftarrow",
-        L"\\nrightarrow",
-        L"\\sqsupset",
-        L"\\sqsubset",
-        L"\\supsetneq",
-        L"\\subsetneq",
-        L"\\Vdash",
-        L"\\vDash",
-        L"\\lesssim",
-        L"\\nless",
-        L"\\ngeq",
-        L"\\nleq",
-        L"\\smallsmile",
-        L"\\smallfrown",
-        L"\\smallsetminus",
-        L"\\varnothing",
-        L"\\nmid",
-        L"\\square",
-        L"\\Box",
-        L"\\checkmark",
-        L"\\complement",
-        L"\\eth",
-        L"\\hslash",
-        L"\\mho",
-        L"\\circledR",
-        L"\\yen",
-        L"\\maltese",
-        L"\\ulcorner",
-        L"\\urcorner",
-        L"\\llcorner",
-        L"\\lrcorner",
-        L"\\dashrightarrow",
-        L"\\dasharrow",
-        L"\\dashleftarrow",
-        L"\\backprime",
-        L"\\vartriangle",
-        L"\\blacktriangle",
-        L"\\triangledown",
-        L"\\blacktriangledown",
-        L"\\blacksquare",
-        L"\\lozenge",
-        L"\\blacklozenge",
-        L"\\circledS",
-        L"\\bigstar",
-        L"\\sphericalangle",
-        L"\\measuredangle",
-        L"\\diagup",
-        L"\\diagdown",
-        L"\\Bbbk",
-        L"\\dotplus",
-        L"\\ltimes",
-        L"\\rtimes",
-        L"\\Cap",
-        L"\\leftthreetimes",
-        L"\\rightthreetimes",
-        L"\\Cup",
-        L"\\barwedge",
-        L"\\curlywedge",
-        L"\\veebar",
-        L"\\curlyvee",
-        L"\\doublebarwedge",
-        L"\\boxminus",
-        L"\\circleddash",
-        L"\\boxtimes",
-        L"\\circledast",
-        L"\\boxdot",
-        L"\\circledcirc",
-        L"\\boxplus",
-        L"\\centerdot",
-        L"\\divideontimes",
-        L"\\intercal",
-        L"\\leqq",
-        L"\\geqq",
-        L"\\leqslant",
-        L"\\geqslant",
-        L"\\eqslantless",
-        L"\\eqslantgtr",
-        L"\\gtrsim",
-        L"\\lessapprox",
-        L"\\gtrapprox",
-        L"\\approxeq",
-        L"\\eqsim",
-        L"\\lessdot",
-        L"\\gtrdot",
-        L"\\lll",
-        L"\\ggg",
-        L"\\lessgtr",
-        L"\\gtrless",
-        L"\\lesseqgtr",
-        L"\\gtreqless",
-        L"\\lesseqqgtr",
-        L"\\gtreqqless",
-        L"\\doteqdot",
-        L"\\eqcirc",
-        L"\\risingdotseq",
-        L"\\circeq",
-        L"\\fallingdotseq",
-        L"\\triangleq",
-        L"\\backsim",
-        L"\\thicksim",
-        L"\\backsimeq",
-        L"\\thickapprox",
-        L"\\subseteqq",
-        L"\\supseteqq",
-        L"\\Subset",
-        L"\\Supset",
-        L"\\preccurlyeq",
-        L"\\succcurlyeq",
-        L"\\curlyeqprec",
-        L"\\curlyeqsucc",
-        L"\\precsim",
-        L"\\succsim",
-        L"\\precapprox",
-        L"\\succapprox",
-        L"\\vartriangleleft",
-        L"\\vartriangleright",
-        L"\\Vvdash",
-        L"\\shortmid",
-        L"\\shortparallel",
-        L"\\bumpeq",
-        L"\\between",
-        L"\\Bumpeq",
-        L"\\varpropto",
-        L"\\backepsilon",
-        L"\\blacktriangleleft",
-        L"\\blacktriangleright",
-        L"\\therefore",
-        L"\\because",
-        L"\\ngtr",
-        L"\\nleqslant",
-        L"\\ngeqslant",
-        L"\\nleqq",
-        L"\\ngeqq",
-        L"\\lneqq",
-        L"\\gneqq",
-        L"\\lvertneqq",
-        L"\\gvertneqq",
-        L"\\lnsim",
-        L"\\gnsim",
-        L"\\lnapprox",
-        L"\\gnapprox",
-        L"\\nprec",
-        L"\\nsucc",
-        L"\\npreceq",
-        L"\\nsucceq",
-        L"\\precneqq",
-        L"\\succneqq",
-        L"\\precnsim",
-        L"\\succnsim",
-        L"\\precnapprox",
-        L"\\succnapprox",
-        L"\\nsim",
-        L"\\ncong",
-        L"\\nshortmid",
-        L"\\nshortparallel",
-        L"\\nmid",
-        L"\\nparallel",
-        L"\\nvdash",
-        L"\\nvDash",
-        L"\\nVdash",
-        L"\\nVDash",
-        L"\\ntriangleleft",
-        L"\\ntriangleright",
-        L"\\ntrianglelefteq",
-        L"\\ntrianglerighteq",
-        L"\\nsubseteq",
-        L"\\nsupseteq",
-        L"\\nsubseteqq",
-        L"\\nsupseteqq",
-        L"\\subsetneq",
-        L"\\supsetneq",
-        L"\\varsubsetneq",
-        L"\\varsupsetneq",
-        L"\\subsetneqq",
-        L"\\supsetneqq",
-        L"\\varsubsetneqq",
-        L"\\varsupsetneqq",
-        L"\\leftleftarrows",
-        L"\\rightrightarrows",
-        L"\\leftrightarrows",
-        L"\\rightleftarrows",
-        L"\\Lleftarrow",
-        L"\\Rrightarrow",
-        L"\\twoheadleftarrow",
-        L"\\twoheadrightarrow",
-        L"\\leftarrowtail",
-        L"\\rightarrowtail",
-        L"\\looparrowleft",
-        L"\\looparrowright",
-        L"\\leftrightharpoons",
-        L"\\rightleftharpoons",
-        L"\\curvearrowleft",
-        L"\\curvearrowright",
-        L"\\circlearrowleft",
-        L"\\circlearrowright",
-        L"\\Lsh",
-        L"\\Rsh",
-        L"\\upuparrows",
-        L"\\downdownarrows",
-        L"\\multimap",
-        L"\\rightsquigarrow",
-        L"\\leftrightsquigarrow",
-        L"\\nLeftarrow",
-        L"\\nRightarrow",
-        L"\\nleftrightarrow",
-        L"\\nLeftrightarrow",
-        L"\\pitchfork",
-        L"\\nexists",
-        L"\\lhd",
-        L"\\rhd",
-        L"\\unlhd",
-        L"\\unrhd",
-        L"\\Join",
-        L"\\leadsto"
-    };
-
-    static wishful_hash_set<wstring> gNeedsAmssymbTable(
-        gNeedsAmssymbArray,
-        END_ARRAY(gNeedsAmssymbArray)
-    );
-        
     // Note: there might be other commands which imply loading packages
     // which are handled elsewhere (e.g. \color)
 
-    if (command[0] == L'\\')
-    {
-        if (command == L"\\cyr")
-            mNeedsX2 = mNeedsUcs = true;
-        if (command == L"\\jap")
-            mNeedsCJK = mNeedsJapaneseFont = true;
-        
-        if (!mNeedsAmsfonts &&
-            (command == L"\\mathbb" || command == L"\\mathfrak")
-        )
-            mNeedsAmsfonts = true;
-        
-        if (!mNeedsAmsmath && gNeedsAmsmathTable.count(command))
-            mNeedsAmsmath = true;
-
-        if (!mNeedsAmssymb && gNeedsAmssymbTable.count(command))
-            mNeedsAmssymb = true;
-    }
+    unsigned features =
+        GetGlobalTokenTable().GetCommandInfo(command).mFeatures;
+
+    if (features & cFeatureCyrillic)
+        mNeedsX2 = mNeedsUcs = true;
+    if (features & cFeatureJapanese)
+        mNeedsCJK = mNeedsJapaneseFont = true;
+    if (features & cFeatureAmsfonts)
+        mNeedsAmsfonts = true;
+    if (features & cFeatureAmsmath)
+        mNeedsAmsmath = true;
+    if (features & cFeatureAmssymb)
+        mNeedsAmssymb = true;
 }
 
+namespace ParseTree
+{
 
 void MathSymbol::GetPurifiedTex(
     wostream& os,
@@ -680,7 +689,7 @@ void MathSymbol::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    features.Update(mCommand);
+    features.Update(mToken);
     os << L" " << mCommand;
 }
 
@@ -691,7 +700,7 @@ void MathCommand1Arg::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    features.Update(mCommand);
+    features.Update(mToken);
     os << mCommand << L"{";
     mChild->GetPurifiedTex(os, features, fontEncoding);
     os << L"}";
@@ -704,7 +713,7 @@ void MathStateChange::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    features.Update(mCommand);
+    features.Update(mToken);
     os << mCommand << L" ";
 }
 
@@ -726,7 +735,7 @@ void MathCommand2Args::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    features.Update(mCommand);
+    features.Update(mToken);
     if (mIsInfix)
     {
         // e.g. "\over"
@@ -738,7 +747,7 @@ void MathCommand2Args::GetPurifiedTex(
     }
     else
     {
-        if (mCommand == L"\\rootReserved")
+        if (mToken == cTokenRootReserved)
         {
             os << L"\\sqrt[{";
             mChild1->GetPurifiedTex(os, features, fontEncoding);
@@ -776,7 +785,7 @@ void MathList::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    for (vector<MathNode*>::const_iterator
+    for (MathNodeVector::const_iterator
         ptr = mChildren.begin();
         ptr != mChildren.end();
         ptr++
@@ -825,8 +834,8 @@ void MathDelimited::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    features.Update(mLeftDelimiter);
-    features.Update(mRightDelimiter);
+    features.Update(mLeftToken);
+    features.Update(mRightToken);
     
     os << L"\\left" << mLeftDelimiter;
     mChild->GetPurifiedTex(os, features, fontEncoding);
@@ -840,8 +849,8 @@ void MathBig::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    features.Update(mCommand);
-    features.Update(mDelimiter);
+    features.Update(mCommandToken);
+    features.Update(mDelimiterToken);
     
     os << mCommand << mDelimiter;
 }
@@ -853,7 +862,7 @@ void MathTableRow::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    for (vector<MathNode*>::const_iterator
+    for (MathNodeVector::const_iterator
         ptr = mEntries.begin();
         ptr != mEntries.end();
         ptr++
@@ -872,7 +881,7 @@ void MathTable::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    for (vector<MathTableRow*>::const_iterator
+    for (MathTableRowVector::const_iterator
         ptr = mRows.begin();
         ptr != mRows.end();
         ptr++
@@ -891,18 +900,19 @@ void MathEnvironment::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
+    // Every environment we support (including "\substack") comes from
+    // amsmath.
+    features.mNeedsAmsmath = true;
+
     wstring beginCommand, endCommand;
     if (mIsShort)
     {
-        beginCommand = L"\\" + mName;
-        features.Update(beginCommand);
-        beginCommand += L"{";
+        beginCommand = L"\\" + mName + L"{";
         endCommand = L"}";
     }
     else
     {
         beginCommand = L"\\begin{" + mName + L"}";
-        features.Update(beginCommand);
         endCommand = L"\\end{" + mName + L"}";
     }
     
@@ -918,7 +928,7 @@ void TextList::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    for (vector<TextNode*>::const_iterator
+    for (TextNodeVector::const_iterator
         ptr = mChildren.begin();
         ptr != mChildren.end();
         ptr++
@@ -946,47 +956,52 @@ wstring FormatCodePoint(unsigned code)
     return s.str();
 }
 
-wstring FontEncodingName[] =
+const wchar_t* const FontEncodingName[] =
 {
     L"default",
     L"cyrillic",
     L"japanese"
 };
 
+// These are all the non-ASCII unicode characters that we will translate
+// directly to \unichar without additional font encoding commands.
+// (Sorted, for binary_search.)
+static const wchar_t gSimpleUnicodeArray[] =
+{
+    161, 163, 167, 169, 172, 174, 176, 181, 182, 191, 192, 193, 194,
+    195, 196, 197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207,
+    209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221,
+    223, 224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235,
+    236, 237, 238, 241, 242, 243, 244, 245, 246, 247, 248, 249, 250,
+    251, 252, 253, 255, 256, 257, 258, 259, 262, 263, 264, 265, 266,
+    267, 268, 269, 270, 271, 274, 275, 276, 277, 278, 279, 282, 283,
+    284, 285, 286, 287, 288, 289, 290, 292, 293, 296, 297, 298, 299,
+    300, 301, 304, 305, 308, 309, 310, 311, 313, 314, 315, 316, 317,
+    318, 321, 322, 323, 324, 325, 326, 327, 328, 332, 333, 334, 335,
+    336, 337, 338, 339, 340, 341, 342, 343, 344, 345, 346, 347, 348,
+    349, 350, 351, 352, 353, 354, 355, 356, 357, 360, 361, 362, 363,
+    364, 365, 366, 367, 368, 369, 372, 373, 374, 375, 376, 377, 378,
+    379, 380, 381, 382, 461, 462, 463, 464, 465, 466, 467, 468, 482,
+    483, 486, 487, 488, 489, 496, 500, 501, 504, 505, 508, 509, 510,
+    511, 536, 537, 538, 539, 542, 543, 550, 551, 552, 553, 558, 559,
+    562, 563
+};
+
+// Stops blahtex at startup if any of the tables in this file has been
+// edited out of order.
+const bool gTablesChecked =
+    CheckTableOrder(gColourArray, "gColourArray") &&
+    CheckTableOrder(gStyleCommandArray, "gStyleCommandArray") &&
+    CheckTableOrder(gFontCommandArray, "gFontCommandArray") &&
+    CheckTableOrder(gTextCommandArray, "gTextCommandArray") &&
+    CheckTableOrder(gSimpleUnicodeArray, "gSimpleUnicodeArray");
+
 void TextSymbol::GetPurifiedTex(
     wostream& os,
     LatexFeatures& features,
     FontEncoding fontEncoding
 ) const
 {
-    // These are all the non-ASCII unicode characters that we will translate
-    // directly to \unichar without additional font encoding commands.
-    static wchar_t gSimpleUnicodeArray[] =
-    {
-        161, 163, 167, 169, 172, 174, 176, 181, 182, 191, 192, 193, 194,
-        195, 196, 197, 198, 199, 200, 201, 202, 203, 204, 205, 206, 207,
-        209, 210, 211, 212, 213, 214, 215, 216, 217, 218, 219, 220, 221,
-        223, 224, 225, 226, 227, 228, 229, 230, 231, 232, 233, 234, 235,
-        236, 237, 238, 241, 242, 243, 244, 245, 246, 247, 248, 249, 250,
-        251, 252, 253, 255, 256, 257, 258, 259, 262, 263, 264, 265, 266,
-        267, 268, 269, 270, 271, 274, 275, 276, 277, 278, 279, 282, 283,
-        284, 285, 286, 287, 288, 289, 290, 292, 293, 296, 297, 298, 299,
-        300, 301, 304, 305, 308, 309, 310, 311, 313, 314, 315, 316, 317,
-        318, 321, 322, 323, 324, 325, 326, 327, 328, 332, 333, 334, 335,
-        336, 337, 338, 339, 340, 341, 342, 343, 344, 345, 346, 347, 348,
-        349, 350, 351, 352, 353, 354, 355, 356, 357, 360, 361, 362, 363,
-        364, 365, 366, 367, 368, 369, 372, 373, 374, 375, 376, 377, 378,
-        379, 380, 381, 382, 461, 462, 463, 464, 465, 466, 467, 468, 482,
-        483, 486, 487, 488, 489, 496, 500, 501, 504, 505, 508, 509, 510,
-        511, 536, 537, 538, 539, 542, 543, 550, 551, 552, 553, 558, 559,
-        562, 563
-    };
-
-    static set<wchar_t> gSimpleUnicodeTable(
-        gSimpleUnicodeArray,
-        END_ARRAY(gSimpleUnicodeArray)
-    );
-
     if (mCommand.size() > 1 || mCommand[0] <= 0x7F)
     {
         // Plain ASCII character, or something like \textbackslash or \{.
@@ -997,14 +1012,18 @@ void TextSymbol::GetPurifiedTex(
                 FontEncodingName[fontEncoding]
             );
 
-        features.Update(mCommand);
+        features.Update(mToken);
         os << mCommand;
     }
     else
     {
         unsigned code = static_cast<unsigned>(mCommand[0]);
 
-        if (gSimpleUnicodeTable.count(code))
+        if (binary_search(
+            gSimpleUnicodeArray,
+            END_ARRAY(gSimpleUnicodeArray),
+            static_cast<wchar_t>(code)
+        ))
         {
             if (fontEncoding != cFontEncodingDefault)
                 throw Exception(
@@ -1071,7 +1090,7 @@ void TextStateChange::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    features.Update(mCommand);
+    features.Update(mToken);
     os << mCommand << L"{}";
 }
 
@@ -1091,15 +1110,17 @@ void TextColour::GetPurifiedTex(
 // (like "\cyr" or "\jap"), modifies fontEncoding accordingly, and throws
 // an exception if nested encodings occur.
 void HandleFontEncodingCommand(
-    const wstring& command,
+    Token command,
     FontEncoding& fontEncoding
 )
 {
     FontEncoding newEncoding = cFontEncodingDefault;
-    
-    if (command == L"\\cyr")
+    unsigned features =
+        GetGlobalTokenTable().GetCommandInfo(command).mFeatures;
+
+    if (features & cFeatureCyrillic)
         newEncoding = cFontEncodingCyrillic;
-    else if (command == L"\\jap")
+    else if (features & cFeatureJapanese)
         newEncoding = cFontEncodingJapanese;
         
     if (newEncoding != cFontEncodingDefault)
@@ -1117,8 +1138,8 @@ void TextCommand1Arg::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    features.Update(mCommand);
-    HandleFontEncodingCommand(mCommand, fontEncoding);
+    features.Update(mToken);
+    HandleFontEncodingCommand(mToken, fontEncoding);
 
     os << mCommand << L"{";
     mChild->GetPurifiedTex(os, features, fontEncoding);
@@ -1132,8 +1153,8 @@ void EnterTextMode::GetPurifiedTex(
     FontEncoding fontEncoding
 ) const
 {
-    features.Update(mCommand);
-    HandleFontEncodingCommand(mCommand, fontEncoding);
+    features.Update(mToken);
+    HandleFontEncodingCommand(mToken, fontEncoding);
 
     os << mCommand << L"{";
     mChild->GetPurifiedTex(os, features, fontEncoding);
@@ -1179,7 +1200,7 @@ void MathGroup::Print(wostream& os, int depth) const
 void MathList::Print(wostream& os, int depth) const
 {
     os << indent(depth) << L"MathList" << endl;
-    for (vector<MathNode*>::const_iterator
+    for (MathNodeVector::const_iterator
         ptr = mChildren.begin(); ptr != mChildren.end(); ptr++
     )
         (*ptr)->Print(os, depth+1);
@@ -1239,7 +1260,7 @@ void MathBig::Print(wostream& os, int depth) const
 void MathTableRow::Print(wostream& os, int depth) const
 {
     os << indent(depth) << L"MathTableRow" << endl;
-    for (vector<MathNode*>::const_iterator
+    for (MathNodeVector::const_iterator
         ptr = mEntries.begin(); ptr != mEntries.end(); ptr++
     )
         (*ptr)->Print(os, depth+1);
@@ -1248,7 +1269,7 @@ void MathTableRow::Print(wostream& os, int depth) const
 void MathTable::Print(wostream& os, int depth) const
 {
     os << indent(depth) << L"MathTable" << endl;
-    for (vector<MathTableRow*>::const_iterator
+    for (MathTableRowVector::const_iterator
         ptr = mRows.begin(); ptr != mRows.end(); ptr++
     )
         (*ptr)->Print(os, depth+1);
@@ -1272,7 +1293,7 @@ void EnterTextMode::Print(wostream& os, int depth) const
 void TextList::Print(wostream& os, int depth) const
 {
     os << indent(depth) << L"TextList" << endl;
-    for (vector<TextNode*>::const_iterator
+    for (TextNodeVector::const_iterator
         ptr = mChildren.begin(); ptr != mChildren.end(); ptr++
     )
         (*ptr)->Print(os, depth+1);
@@ -1308,6 +1329,198 @@ void TextGroup::Print(wostream& os, int depth) const
     mChild->Print(os, depth+1);
 }
 
+// =========================================================================
+// Now the canonical form (see Manager::GetCanonicalForm).
+//
+// Each node is written as a single tag character, followed by its strings
+// and then its children. Strings are prefixed by their length (e.g.
+// "3:\pm"), and variable length child lists are enclosed in parentheses,
+// so that two different trees never give the same serialisation.
+
+void AppendCanonicalString(wstring& output, const wstring& text)
+{
+    wchar_t digits[16];
+    int count = 0;
+    wstring::size_type length = text.size();
+    do
+    {
+        digits[count++] = L'0' + length % 10;
+        length /= 10;
+    }
+    while (length);
+    while (count)
+        output += digits[--count];
+    output += L':';
+    output += text;
+}
+
+// Optional children are written as '-' if absent.
+void AppendCanonicalChild(wstring& output, const Node* child)
+{
+    if (child)
+        child->AppendCanonical(output);
+    else
+        output += L'-';
+}
+
+void MathSymbol::AppendCanonical(wstring& output) const
+{
+    output += L's';
+    AppendCanonicalString(output, mCommand);
+}
+
+void MathCommand1Arg::AppendCanonical(wstring& output) const
+{
+    output += L'c';
+    AppendCanonicalString(output, mCommand);
+    mChild->AppendCanonical(output);
+}
+
+void MathCommand2Args::AppendCanonical(wstring& output) const
+{
+    output += mIsInfix ? L'i' : L'C';
+    AppendCanonicalString(output, mCommand);
+    mChild1->AppendCanonical(output);
+    mChild2->AppendCanonical(output);
+}
+
+void MathGroup::AppendCanonical(wstring& output) const
+{
+    output += L'g';
+    mChild->AppendCanonical(output);
+}
+
+void MathList::AppendCanonical(wstring& output) const
+{
+    output += L'l';
+    output += L'(';
+    for (MathNodeVector::const_iterator
+        ptr = mChildren.begin(); ptr != mChildren.end(); ptr++
+    )
+        (*ptr)->AppendCanonical(output);
+    output += L')';
+}
+
+void MathScripts::AppendCanonical(wstring& output) const
+{
+    output += L'x';
+    AppendCanonicalChild(output, mBase.get());
+    AppendCanonicalChild(output, mUpper.get());
+    AppendCanonicalChild(output, mLower.get());
+}
+
+void MathLimits::AppendCanonical(wstring& output) const
+{
+    output += L'm';
+    AppendCanonicalString(output, mCommand);
+    mChild->AppendCanonical(output);
+}
+
+void MathStateChange::AppendCanonical(wstring& output) const
+{
+    output += L't';
+    AppendCanonicalString(output, mCommand);
+}
+
+void MathColour::AppendCanonical(wstring& output) const
+{
+    output += L'k';
+    AppendCanonicalString(output, mColourName);
+}
+
+void MathDelimited::AppendCanonical(wstring& output) const
+{
+    output += L'd';
+    AppendCanonicalString(output, mLeftDelimiter);
+    AppendCanonicalString(output, mRightDelimiter);
+    mChild->AppendCanonical(output);
+}
+
+void MathBig::AppendCanonical(wstring& output) const
+{
+    output += L'b';
+    AppendCanonicalString(output, mCommand);
+    AppendCanonicalString(output, mDelimiter);
+}
+
+void MathTableRow::AppendCanonical(wstring& output) const
+{
+    output += L'r';
+    output += L'(';
+    for (MathNodeVector::const_iterator
+        ptr = mEntries.begin(); ptr != mEntries.end(); ptr++
+    )
+        (*ptr)->AppendCanonical(output);
+    output += L')';
+}
+
+void MathTable::AppendCanonical(wstring& output) const
+{
+    output += L'a';
+    output += L'(';
+    for (MathTableRowVector::const_iterator
+        ptr = mRows.begin(); ptr != mRows.end(); ptr++
+    )
+        (*ptr)->AppendCanonical(output);
+    output += L')';
+}
+
+void MathEnvironment::AppendCanonical(wstring& output) const
+{
+    output += mIsShort ? L'E' : L'e';
+    AppendCanonicalString(output, mName);
+    mTable->AppendCanonical(output);
+}
+
+void EnterTextMode::AppendCanonical(wstring& output) const
+{
+    output += L'T';
+    AppendCanonicalString(output, mCommand);
+    mChild->AppendCanonical(output);
+}
+
+void TextList::AppendCanonical(wstring& output) const
+{
+    output += L'L';
+    output += L'(';
+    for (TextNodeVector::const_iterator
+        ptr = mChildren.begin(); ptr != mChildren.end(); ptr++
+    )
+        (*ptr)->AppendCanonical(output);
+    output += L')';
+}
+
+void TextSymbol::AppendCanonical(wstring& output) const
+{
+    output += L'S';
+    AppendCanonicalString(output, mCommand);
+}
+
+void TextCommand1Arg::AppendCanonical(wstring& output) const
+{
+    output += L'F';
+    AppendCanonicalString(output, mCommand);
+    mChild->AppendCanonical(output);
+}
+
+void TextStateChange::AppendCanonical(wstring& output) const
+{
+    output += L'Z';
+    AppendCanonicalString(output, mCommand);
+}
+
+void TextColour::AppendCanonical(wstring& output) const
+{
+    output += L'K';
+    AppendCanonicalString(output, mColourName);
+}
+
+void TextGroup::AppendCanonical(wstring& output) const
+{
+    output += L'G';
+    mChild->AppendCanonical(output);
+}
+
 }
 }
 
@@ -19,431 +19,433 @@
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
 #include <stdexcept>
+#include <cwchar>
 #include "Parser.h"
 
 using namespace std;
 
 namespace blahtex {
 
-// Imported from ParseTree1.cpp:
-extern wishful_hash_map<wstring, wstring> gDelimiterTable;
-extern wishful_hash_map<wstring, RGBColour> gColourTable;
+// Imported from ParseTree1.cpp and ParseTree3.cpp:
+extern bool IsDelimiter(const wstring& delimiter);
+extern bool IsColourName(const wstring& name);
 
-// These tables contain all the commands that blahtex recognises in math
+// These arrays contain all the commands that blahtex recognises in math
 // mode (respectively text mode). They provide the token codes for the
-// parser to do its job.
+// parser to do its job. (Unlike most TableEntry arrays they need not be
+// sorted, since they are only used to build the vectors below.)
 
-pair<wstring, Parser::TokenCode> gMathTokenArray[] =
+const TableEntry<Parser::TokenCode> gMathTokenArray[] =
 {
-    make_pair(L"",                         Parser::cEndOfInput),
-    make_pair(L" ",                        Parser::cWhitespace),
-    make_pair(L"\\newcommand",             Parser::cNewcommand),
-
-    make_pair(L"$",                        Parser::cIllegal),
-    make_pair(L"%",                        Parser::cIllegal),
-    make_pair(L"#",                        Parser::cIllegal),
-    make_pair(L"`",                        Parser::cIllegal),
-    make_pair(L"\"",                       Parser::cIllegal),
-
-    make_pair(L"{",                        Parser::cBeginGroup),
-    make_pair(L"}",                        Parser::cEndGroup),
-
-    make_pair(L"&",                        Parser::cNextCell),
-    make_pair(L"\\\\",                     Parser::cNextRow),
-
-    make_pair(L"^",                        Parser::cSuperscript),
-    make_pair(L"_",                        Parser::cSubscript),
-    make_pair(L"'",                        Parser::cPrime),
-
-    make_pair(L"\\hbox",                   Parser::cEnterTextMode),
-    make_pair(L"\\mbox",                   Parser::cEnterTextMode),
-    make_pair(L"\\emph",                   Parser::cEnterTextMode),
-    make_pair(L"\\text",                   Parser::cEnterTextMode),
-    make_pair(L"\\textit",                 Parser::cEnterTextMode),
-    make_pair(L"\\textbf",                 Parser::cEnterTextMode),
-    make_pair(L"\\textrm",                 Parser::cEnterTextMode),
-    make_pair(L"\\texttt",                 Parser::cEnterTextMode),
-    make_pair(L"\\textsf",                 Parser::cEnterTextMode),
+    {L"",                         Parser::cEndOfInput},
+    {L" ",                        Parser::cWhitespace},
+    {L"\\newcommand",             Parser::cNewcommand},
+
+    {L"$",                        Parser::cIllegal},
+    {L"%",                        Parser::cIllegal},
+    {L"#",                        Parser::cIllegal},
+    {L"`",                        Parser::cIllegal},
+    {L"\"",                       Parser::cIllegal},
+
+    {L"{",                        Parser::cBeginGroup},
+    {L"}",                        Parser::cEndGroup},
+
+    {L"&",                        Parser::cNextCell},
+    {L"\\\\",                     Parser::cNextRow},
+
+    {L"^",                        Parser::cSuperscript},
+    {L"_",                        Parser::cSubscript},
+    {L"'",                        Parser::cPrime},
+
+    {L"\\hbox",                   Parser::cEnterTextMode},
+    {L"\\mbox",                   Parser::cEnterTextMode},
+    {L"\\emph",                   Parser::cEnterTextMode},
+    {L"\\text",                   Parser::cEnterTextMode},
+    {L"\\textit",                 Parser::cEnterTextMode},
+    {L"\\textbf",                 Parser::cEnterTextMode},
+    {L"\\textrm",                 Parser::cEnterTextMode},
+    {L"\\texttt",                 Parser::cEnterTextMode},
+    {L"\\textsf",                 Parser::cEnterTextMode},
     
-    make_pair(L"\\cyr",                    Parser::cEnterTextMode),
-    make_pair(L"\\jap",                    Parser::cEnterTextMode),
+    {L"\\cyr",                    Parser::cEnterTextMode},
+    {L"\\jap",                    Parser::cEnterTextMode},
 
-    make_pair(L"\\sqrt",                   Parser::cCommand1Arg),
-    make_pair(L"\\pmod",                   Parser::cCommand1Arg),
-    make_pair(L"\\operatorname",           Parser::cCommand1Arg),
-    make_pair(L"\\operatornamewithlimits", Parser::cCommand1Arg),
+    {L"\\sqrt",                   Parser::cCommand1Arg},
+    {L"\\pmod",                   Parser::cCommand1Arg},
+    {L"\\operatorname",           Parser::cCommand1Arg},
+    {L"\\operatornamewithlimits", Parser::cCommand1Arg},
 
     // "\rootReserved" is the *only* "Reserved" command the parser
     // has to worry about.
-    make_pair(L"\\rootReserved",           Parser::cCommand2Args),
-
-    make_pair(L"\\binom",                  Parser::cCommand2Args),
-    make_pair(L"\\frac",                   Parser::cCommand2Args),
-    make_pair(L"\\cfrac",                  Parser::cCommand2Args),
-    make_pair(L"\\overset",                Parser::cCommand2Args),
-    make_pair(L"\\underset",               Parser::cCommand2Args),
-
-    make_pair(L"\\over",                   Parser::cCommandInfix),
-    make_pair(L"\\choose",                 Parser::cCommandInfix),
-    make_pair(L"\\atop",                   Parser::cCommandInfix),
-
-    make_pair(L"\\left",                   Parser::cLeft),
-    make_pair(L"\\right",                  Parser::cRight),
-
-    make_pair(L"\\big",                    Parser::cBig),
-    make_pair(L"\\bigl",                   Parser::cBig),
-    make_pair(L"\\bigr",                   Parser::cBig),
-    make_pair(L"\\Big",                    Parser::cBig),
-    make_pair(L"\\Bigl",                   Parser::cBig),
-    make_pair(L"\\Bigr",                   Parser::cBig),
-    make_pair(L"\\bigg",                   Parser::cBig),
-    make_pair(L"\\biggl",                  Parser::cBig),
-    make_pair(L"\\biggr",                  Parser::cBig),
-    make_pair(L"\\Bigg",                   Parser::cBig),
-    make_pair(L"\\Biggl",                  Parser::cBig),
-    make_pair(L"\\Biggr",                  Parser::cBig),
-
-    make_pair(L"\\mathop",                 Parser::cCommand1Arg),
-    make_pair(L"\\mathrel",                Parser::cCommand1Arg),
-    make_pair(L"\\mathord",                Parser::cCommand1Arg),
-    make_pair(L"\\mathbin",                Parser::cCommand1Arg),
-    make_pair(L"\\mathopen",               Parser::cCommand1Arg),
-    make_pair(L"\\mathclose",              Parser::cCommand1Arg),
-    make_pair(L"\\mathpunct",              Parser::cCommand1Arg),
-    make_pair(L"\\mathinner",              Parser::cCommand1Arg),
-
-    make_pair(L"\\limits",                 Parser::cLimits),
-    make_pair(L"\\nolimits",               Parser::cLimits),
-    make_pair(L"\\displaylimits",          Parser::cLimits),
-
-    make_pair(L"\\_",                      Parser::cSymbol),
-    make_pair(L"\\&",                      Parser::cSymbol),
-    make_pair(L"\\$",                      Parser::cSymbol),
-    make_pair(L"\\#",                      Parser::cSymbol),
-    make_pair(L"\\%",                      Parser::cSymbol),
-    make_pair(L"\\{",                      Parser::cSymbol),
-    make_pair(L"\\}",                      Parser::cSymbol),
-
-    make_pair(L"\\mod",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\bmod",                   Parser::cSymbolUnsafe),
-
-    make_pair(L"\\substack",               Parser::cShortEnvironment),
-
-    make_pair(L"\\begin{matrix}",          Parser::cBeginEnvironment),
-    make_pair(L"\\begin{pmatrix}",         Parser::cBeginEnvironment),
-    make_pair(L"\\begin{bmatrix}",         Parser::cBeginEnvironment),
-    make_pair(L"\\begin{Bmatrix}",         Parser::cBeginEnvironment),
-    make_pair(L"\\begin{vmatrix}",         Parser::cBeginEnvironment),
-    make_pair(L"\\begin{Vmatrix}",         Parser::cBeginEnvironment),
-    make_pair(L"\\begin{cases}",           Parser::cBeginEnvironment),
-    make_pair(L"\\begin{aligned}",         Parser::cBeginEnvironment),
-    make_pair(L"\\begin{smallmatrix}",     Parser::cBeginEnvironment),
-
-    make_pair(L"\\end{matrix}",            Parser::cEndEnvironment),
-    make_pair(L"\\end{pmatrix}",           Parser::cEndEnvironment),
-    make_pair(L"\\end{bmatrix}",           Parser::cEndEnvironment),
-    make_pair(L"\\end{Bmatrix}",           Parser::cEndEnvironment),
-    make_pair(L"\\end{vmatrix}",           Parser::cEndEnvironment),
-    make_pair(L"\\end{Vmatrix}",           Parser::cEndEnvironment),
-    make_pair(L"\\end{cases}",             Parser::cEndEnvironment),
-    make_pair(L"\\end{aligned}",           Parser::cEndEnvironment),
-    make_pair(L"\\end{smallmatrix}",       Parser::cEndEnvironment),
-
-    make_pair(L"~",                        Parser::cSymbolUnsafe),
-    make_pair(L"\\,",                      Parser::cSymbolUnsafe),
-    make_pair(L"\\!",                      Parser::cSymbolUnsafe),
-    make_pair(L"\\ ",                      Parser::cSymbolUnsafe),
-    make_pair(L"\\;",                      Parser::cSymbolUnsafe),
-    make_pair(L"\\>",                      Parser::cSymbolUnsafe),
-    make_pair(L"\\quad",                   Parser::cSymbolUnsafe),
-    make_pair(L"\\qquad",                  Parser::cSymbolUnsafe),
-
-    make_pair(L"\\not",                    Parser::cSymbol),
-
-    make_pair(L"(",                        Parser::cSymbol),
-    make_pair(L")",                        Parser::cSymbol),
-    make_pair(L"[",                        Parser::cSymbol),
-    make_pair(L"]",                        Parser::cSymbol),
-    make_pair(L"<",                        Parser::cSymbol),
-    make_pair(L">",                        Parser::cSymbol),
-    make_pair(L"+",                        Parser::cSymbol),
-    make_pair(L"-",                        Parser::cSymbol),
-    make_pair(L"=",                        Parser::cSymbol),
-    make_pair(L"|",                        Parser::cSymbol),
-    make_pair(L";",                        Parser::cSymbol),
-    make_pair(L":",                        Parser::cSymbol),
-    make_pair(L",",                        Parser::cSymbol),
-    make_pair(L".",                        Parser::cSymbol),
-    make_pair(L"/",                        Parser::cSymbol),
-    make_pair(L"?",                        Parser::cSymbol),
-    make_pair(L"!",                        Parser::cSymbol),
-    make_pair(L"@",                        Parser::cSymbol),
-    make_pair(L"*",                        Parser::cSymbol),
-
-    make_pair(L"\\vert",                   Parser::cSymbol),
-    make_pair(L"\\lvert",                  Parser::cSymbol),
-    make_pair(L"\\rvert",                  Parser::cSymbol),
-    make_pair(L"\\Vert",                   Parser::cSymbol),
-    make_pair(L"\\lVert",                  Parser::cSymbol),
-    make_pair(L"\\rVert",                  Parser::cSymbol),
-    make_pair(L"\\lfloor",                 Parser::cSymbol),
-    make_pair(L"\\rfloor",                 Parser::cSymbol),
-    make_pair(L"\\lceil",                  Parser::cSymbol),
-    make_pair(L"\\rceil",                  Parser::cSymbol),
-    make_pair(L"\\lbrace",                 Parser::cSymbol),
-    make_pair(L"\\rbrace",                 Parser::cSymbol),
-    make_pair(L"\\langle",                 Parser::cSymbol),
-    make_pair(L"\\rangle",                 Parser::cSymbol),
-    make_pair(L"\\lbrack",                 Parser::cSymbol),
-    make_pair(L"\\rbrack",                 Parser::cSymbol),
-
-    make_pair(L"\\hat",                    Parser::cCommand1Arg),
-    make_pair(L"\\widehat",                Parser::cCommand1Arg),
-    make_pair(L"\\dot",                    Parser::cCommand1Arg),
-    make_pair(L"\\ddot",                   Parser::cCommand1Arg),
-    make_pair(L"\\bar",                    Parser::cCommand1Arg),
-    make_pair(L"\\overline",               Parser::cCommand1Arg),
-    make_pair(L"\\underline",              Parser::cCommand1Arg),
-    make_pair(L"\\overbrace",              Parser::cCommand1Arg),
-    make_pair(L"\\underbrace",             Parser::cCommand1Arg),
-    make_pair(L"\\overleftarrow",          Parser::cCommand1Arg),
-    make_pair(L"\\overrightarrow",         Parser::cCommand1Arg),
-    make_pair(L"\\overleftrightarrow",     Parser::cCommand1Arg),
-    make_pair(L"\\check",                  Parser::cCommand1Arg),
-    make_pair(L"\\acute",                  Parser::cCommand1Arg),
-    make_pair(L"\\grave",                  Parser::cCommand1Arg),
-    make_pair(L"\\vec",                    Parser::cCommand1Arg),
-    make_pair(L"\\breve",                  Parser::cCommand1Arg),
-    make_pair(L"\\tilde",                  Parser::cCommand1Arg),
-    make_pair(L"\\widetilde",              Parser::cCommand1Arg),
-
-    make_pair(L"\\mathbf",                 Parser::cCommand1Arg),
-    make_pair(L"\\mathbb",                 Parser::cCommand1Arg),
-    make_pair(L"\\mathrm",                 Parser::cCommand1Arg),
-    make_pair(L"\\mathit",                 Parser::cCommand1Arg),
-    make_pair(L"\\mathcal",                Parser::cCommand1Arg),
-    make_pair(L"\\mathfrak",               Parser::cCommand1Arg),
-    make_pair(L"\\mathsf",                 Parser::cCommand1Arg),
-    make_pair(L"\\mathtt",                 Parser::cCommand1Arg),
-    make_pair(L"\\boldsymbol",             Parser::cCommand1Arg),
-
-    make_pair(L"\\rm",                     Parser::cStateChange),
-    make_pair(L"\\bf",                     Parser::cStateChange),
-    make_pair(L"\\it",                     Parser::cStateChange),
-    make_pair(L"\\cal",                    Parser::cStateChange),
-    make_pair(L"\\tt",                     Parser::cStateChange),
-    make_pair(L"\\sf",                     Parser::cStateChange),
-
-    make_pair(L"\\displaystyle",           Parser::cStateChange),
-    make_pair(L"\\textstyle",              Parser::cStateChange),
-    make_pair(L"\\scriptstyle",            Parser::cStateChange),
-    make_pair(L"\\scriptscriptstyle",      Parser::cStateChange),
-
-    make_pair(L"\\color",                  Parser::cStateChange),
-
-    make_pair(L"\\varlimsup",              Parser::cSymbolUnsafe),
-    make_pair(L"\\varliminf",              Parser::cSymbolUnsafe),
-    make_pair(L"\\lim",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\sup",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\inf",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\limsup",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\liminf",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\injlim",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\projlim",                Parser::cSymbolUnsafe),
-    make_pair(L"\\min",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\max",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\gcd",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\det",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\Pr",                     Parser::cSymbolUnsafe),
-
-    make_pair(L"\\ker",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\hom",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\dim",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\arg",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\sin",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\cos",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\sec",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\csc",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\tan",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\cot",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\arcsin",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\arccos",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\arctan",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\sinh",                   Parser::cSymbolUnsafe),
-    make_pair(L"\\cosh",                   Parser::cSymbolUnsafe),
-    make_pair(L"\\tanh",                   Parser::cSymbolUnsafe),
-    make_pair(L"\\coth",                   Parser::cSymbolUnsafe),
-    make_pair(L"\\log",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\lg",                     Parser::cSymbolUnsafe),
-    make_pair(L"\\ln",                     Parser::cSymbolUnsafe),
-    make_pair(L"\\exp",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\deg",                    Parser::cSymbolUnsafe),
-
-    make_pair(L"\\alpha",                  Parser::cSymbol),
-    make_pair(L"\\beta",                   Parser::cSymbol),
-    make_pair(L"\\gamma",                  Parser::cSymbol),
-    make_pair(L"\\delta",                  Parser::cSymbol),
-    make_pair(L"\\epsilon",                Parser::cSymbol),
-    make_pair(L"\\varepsilon",             Parser::cSymbol),
-    make_pair(L"\\zeta",                   Parser::cSymbol),
-    make_pair(L"\\eta",                    Parser::cSymbol),
-    make_pair(L"\\theta",                  Parser::cSymbol),
-    make_pair(L"\\vartheta",               Parser::cSymbol),
-    make_pair(L"\\iota",                   Parser::cSymbol),
-    make_pair(L"\\kappa",                  Parser::cSymbol),
-    make_pair(L"\\varkappa",               Parser::cSymbol),
-    make_pair(L"\\lambda",                 Parser::cSymbol),
-    make_pair(L"\\mu",                     Parser::cSymbol),
-    make_pair(L"\\nu",                     Parser::cSymbol),
-    make_pair(L"\\pi",                     Parser::cSymbol),
-    make_pair(L"\\varpi",                  Parser::cSymbol),
-    make_pair(L"\\rho",                    Parser::cSymbol),
-    make_pair(L"\\varrho",                 Parser::cSymbol),
-    make_pair(L"\\sigma",                  Parser::cSymbol),
-    make_pair(L"\\varsigma",               Parser::cSymbol),
-    make_pair(L"\\tau",                    Parser::cSymbol),
-    make_pair(L"\\upsilon",                Parser::cSymbol),
-    make_pair(L"\\phi",                    Parser::cSymbol),
-    make_pair(L"\\varphi",                 Parser::cSymbol),
-    make_pair(L"\\chi",                    Parser::cSymbol),
-    make_pair(L"\\psi",                    Parser::cSymbol),
-    make_pair(L"\\omega",                  Parser::cSymbol),
-    make_pair(L"\\xi",                     Parser::cSymbol),
-    make_pair(L"\\digamma",                Parser::cSymbol),
-
-    make_pair(L"\\Gamma",                  Parser::cSymbol),
-    make_pair(L"\\Delta",                  Parser::cSymbol),
-    make_pair(L"\\Theta",                  Parser::cSymbol),
-    make_pair(L"\\Lambda",                 Parser::cSymbol),
-    make_pair(L"\\Pi",                     Parser::cSymbol),
-    make_pair(L"\\Sigma",                  Parser::cSymbol),
-    make_pair(L"\\Upsilon",                Parser::cSymbol),
-    make_pair(L"\\Phi",                    Parser::cSymbol),
-    make_pair(L"\\Psi",                    Parser::cSymbol),
-    make_pair(L"\\Omega",                  Parser::cSymbol),
-    make_pair(L"\\Xi",                     Parser::cSymbol),
-
-    make_pair(L"\\aleph",                  Parser::cSymbol),
-    make_pair(L"\\beth",                   Parser::cSymbol),
-    make_pair(L"\\gimel",                  Parser::cSymbol),
-    make_pair(L"\\daleth",                 Parser::cSymbol),
-
-    make_pair(L"\\wp",                     Parser::cSymbol),
-    make_pair(L"\\ell",                    Parser::cSymbol),
-    make_pair(L"\\P",                      Parser::cSymbol),
-    make_pair(L"\\imath",                  Parser::cSymbol),
-    make_pair(L"\\forall",                 Parser::cSymbol),
-    make_pair(L"\\exists",                 Parser::cSymbol),
-    make_pair(L"\\Finv",                   Parser::cSymbol),
-    make_pair(L"\\Game",                   Parser::cSymbol),
-    make_pair(L"\\partial",                Parser::cSymbol),
-    make_pair(L"\\Re",                     Parser::cSymbol),
-    make_pair(L"\\Im",                     Parser::cSymbol),
-
-    make_pair(L"\\leftarrow",              Parser::cSymbol),
-    make_pair(L"\\rightarrow",             Parser::cSymbol),
-    make_pair(L"\\longleftarrow",          Parser::cSymbolUnsafe),
-    make_pair(L"\\longrightarrow",         Parser::cSymbolUnsafe),
-    make_pair(L"\\Leftarrow",              Parser::cSymbol),
-    make_pair(L"\\Rightarrow",             Parser::cSymbol),
-    make_pair(L"\\Longleftarrow",          Parser::cSymbolUnsafe),
-    make_pair(L"\\Longrightarrow",         Parser::cSymbolUnsafe),
-    make_pair(L"\\mapsto",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\longmapsto",             Parser::cSymbolUnsafe),
-    make_pair(L"\\leftrightarrow",         Parser::cSymbol),
-    make_pair(L"\\Leftrightarrow",         Parser::cSymbol),
-    make_pair(L"\\longleftrightarrow",     Parser::cSymbolUnsafe),
-    make_pair(L"\\Longleftrightarrow",     Parser::cSymbolUnsafe),
-
-    make_pair(L"\\uparrow",                Parser::cSymbol),
-    make_pair(L"\\Uparrow",                Parser::cSymbol),
-    make_pair(L"\\downarrow",              Parser::cSymbol),
-    make_pair(L"\\Downarrow",              Parser::cSymbol),
-    make_pair(L"\\updownarrow",            Parser::cSymbol),
-    make_pair(L"\\Updownarrow",            Parser::cSymbol),
-
-    make_pair(L"\\searrow",                Parser::cSymbol),
-    make_pair(L"\\nearrow",                Parser::cSymbol),
-    make_pair(L"\\swarrow",                Parser::cSymbol),
-    make_pair(L"\\nwarrow",                Parser::cSymbol),
-
-    make_pair(L"\\hookrightarrow",         Parser::cSymbolUnsafe),
-    make_pair(L"\\hookleftarrow",          Parser::cSymbolUnsafe),
-    make_pair(L"\\upharpoonright",         Parser::cSymbol),
-    make_pair(L"\\upharpoonleft",          Parser::cSymbol),
-    make_pair(L"\\downharpoonright",       Parser::cSymbol),
-    make_pair(L"\\downharpoonleft",        Parser::cSymbol),
-    make_pair(L"\\rightharpoonup",         Parser::cSymbol),
-    make_pair(L"\\rightharpoondown",       Parser::cSymbol),
-    make_pair(L"\\leftharpoonup",          Parser::cSymbol),
-    make_pair(L"\\leftharpoondown",        Parser::cSymbol),
-
-    make_pair(L"\\nleftarrow",             Parser::cSymbol),
-    make_pair(L"\\nrightarrow",            Parser::cSymbol),
-
-    make_pair(L"\\supset",                 Parser::cSymbol),
-    make_pair(L"\\subset",                 Parser::cSymbol),
-    make_pair(L"\\supseteq",               Parser::cSymbol),
-    make_pair(L"\\subseteq",               Parser::cSymbol),
-    make_pair(L"\\sqsupset",               Parser::cSymbol),
-    make_pair(L"\\sqsubset",               Parser::cSymbol),
-    make_pair(L"\\sqsupseteq",             Parser::cSymbol),
-    make_pair(L"\\sqsubseteq",             Parser::cSymbol),
-    make_pair(L"\\supsetneq",              Parser::cSymbol),
-    make_pair(L"\\subsetneq",              Parser::cSymbol),
-
-    make_pair(L"\\in",                     Parser::cSymbol),
-    make_pair(L"\\ni",                     Parser::cSymbol),
-    make_pair(L"\\notin",                  Parser::cSymbolUnsafe),
-
-    make_pair(L"\\iff",                    Parser::cSymbolUnsafe),
-
-    make_pair(L"\\mid",                    Parser::cSymbol),
-    make_pair(L"\\sim",                    Parser::cSymbol),
-    make_pair(L"\\simeq",                  Parser::cSymbol),
-    make_pair(L"\\approx",                 Parser::cSymbol),
-    make_pair(L"\\propto",                 Parser::cSymbol),
-    make_pair(L"\\equiv",                  Parser::cSymbol),
-    make_pair(L"\\cong",                   Parser::cSymbolUnsafe),
-    make_pair(L"\\neq",                    Parser::cSymbolUnsafe),
-
-    make_pair(L"\\ll",                     Parser::cSymbol),
-    make_pair(L"\\gg",                     Parser::cSymbol),
-    make_pair(L"\\geq",                    Parser::cSymbol),
-    make_pair(L"\\leq",                    Parser::cSymbol),
-    make_pair(L"\\triangleleft",           Parser::cSymbol),
-    make_pair(L"\\triangleright",          Parser::cSymbol),
-
-    make_pair(L"\\models",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\vdash",                  Parser::cSymbol),
-    make_pair(L"\\Vdash",                  Parser::cSymbol),
-    make_pair(L"\\vDash",                  Parser::cSymbol),
-
-    make_pair(L"\\lesssim",                Parser::cSymbol),
-    make_pair(L"\\nless",                  Parser::cSymbol),
-    make_pair(L"\\ngeq",                   Parser::cSymbol),
-    make_pair(L"\\nleq",                   Parser::cSymbol),
-
-    make_pair(L"\\ast",                    Parser::cSymbol),
-    make_pair(L"\\times",                  Parser::cSymbol),
-    make_pair(L"\\div",                    Parser::cSymbol),
-    make_pair(L"\\wedge",                  Parser::cSymbol),
-    make_pair(L"\\vee",                    Parser::cSymbol),
-    make_pair(L"\\oplus",                  Parser::cSymbol),
-    make_pair(L"\\otimes",                 Parser::cSymbol),
-    make_pair(L"\\cap",                    Parser::cSymbol),
-    make_pair(L"\\cup",                    Parser::cSymbol),
-    make_pair(L"\\sqcap",                  Parser::cSymbol),
-    make_pair(L"\\sqcup",                  Parser::cSymbol),
-    make_pair(L"\\smile",                  Parser::cSymbol),
-    make_pair(L"\\frown",                  Parser::cSymbol),
-    make_pair(L"\\smallsmile",             Parser::cSymbol),
-    make_pair(L"\\smallfrown",             Parser::cSymbol),
-
-    make_pair(L"\\setminus",               Parser::cSymbol),
-    make_pair(L"\\smallsetminus",          Parser::cSymbol),
-
-    make_pair(L"\\And",                    Parser::cSymbolUnsafe),
+    {L"\\rootReserved",           Parser::cCommand2Args},
+
+    {L"\\binom",                  Parser::cCommand2Args},
+    {L"\\frac",                   Parser::cCommand2Args},
+    {L"\\cfrac",                  Parser::cCommand2Args},
+    {L"\\overset",                Parser::cCommand2Args},
+    {L"\\underset",               Parser::cCommand2Args},
+
+    {L"\\over",                   Parser::cCommandInfix},
+    {L"\\choose",                 Parser::cCommandInfix},
+    {L"\\atop",                   Parser::cCommandInfix},
+
+    {L"\\left",                   Parser::cLeft},
+    {L"\\right",                  Parser::cRight},
+
+    {L"\\big",                    Parser::cBig},
+    {L"\\bigl",                   Parser::cBig},
+    {L"\\bigr",                   Parser::cBig},
+    {L"\\Big",                    Parser::cBig},
+    {L"\\Bigl",                   Parser::cBig},
+    {L"\\Bigr",                   Parser::cBig},
+    {L"\\bigg",                   Parser::cBig},
+    {L"\\biggl",                  Parser::cBig},
+    {L"\\biggr",                  Parser::cBig},
+    {L"\\Bigg",                   Parser::cBig},
+    {L"\\Biggl",                  Parser::cBig},
+    {L"\\Biggr",                  Parser::cBig},
+
+    {L"\\mathop",                 Parser::cCommand1Arg},
+    {L"\\mathrel",                Parser::cCommand1Arg},
+    {L"\\mathord",                Parser::cCommand1Arg},
+    {L"\\mathbin",                Parser::cCommand1Arg},
+    {L"\\mathopen",               Parser::cCommand1Arg},
+    {L"\\mathclose",              Parser::cCommand1Arg},
+    {L"\\mathpunct",              Parser::cCommand1Arg},
+    {L"\\mathinner",              Parser::cCommand1Arg},
+
+    {L"\\limits",                 Parser::cLimits},
+    {L"\\nolimits",               Parser::cLimits},
+    {L"\\displaylimits",          Parser::cLimits},
+
+    {L"\\_",                      Parser::cSymbol},
+    {L"\\&",                      Parser::cSymbol},
+    {L"\\$",                      Parser::cSymbol},
+    {L"\\#",                      Parser::cSymbol},
+    {L"\\%",                      Parser::cSymbol},
+    {L"\\{",                      Parser::cSymbol},
+    {L"\\}",                      Parser::cSymbol},
+
+    {L"\\mod",                    Parser::cSymbolUnsafe},
+    {L"\\bmod",                   Parser::cSymbolUnsafe},
+
+    {L"\\substack",               Parser::cShortEnvironment},
+
+    {L"\\begin{matrix}",          Parser::cBeginEnvironment},
+    {L"\\begin{pmatrix}",         Parser::cBeginEnvironment},
+    {L"\\begin{bmatrix}",         Parser::cBeginEnvironment},
+    {L"\\begin{Bmatrix}",         Parser::cBeginEnvironment},
+    {L"\\begin{vmatrix}",         Parser::cBeginEnvironment},
+    {L"\\begin{Vmatrix}",         Parser::cBeginEnvironment},
+    {L"\\begin{cases}",           Parser::cBeginEnvironment},
+    {L"\\begin{aligned}",         Parser::cBeginEnvironment},
+    {L"\\begin{smallmatrix}",     Parser::cBeginEnvironment},
+
+    {L"\\end{matrix}",            Parser::cEndEnvironment},
+    {L"\\end{pmatrix}",           Parser::cEndEnvironment},
+    {L"\\end{bmatrix}",           Parser::cEndEnvironment},
+    {L"\\end{Bmatrix}",           Parser::cEndEnvironment},
+    {L"\\end{vmatrix}",           Parser::cEndEnvironment},
+    {L"\\end{Vmatrix}",           Parser::cEndEnvironment},
+    {L"\\end{cases}",             Parser::cEndEnvironment},
+    {L"\\end{aligned}",           Parser::cEndEnvironment},
+    {L"\\end{smallmatrix}",       Parser::cEndEnvironment},
+
+    {L"~",                        Parser::cSymbolUnsafe},
+    {L"\\,",                      Parser::cSymbolUnsafe},
+    {L"\\!",                      Parser::cSymbolUnsafe},
+    {L"\\ ",                      Parser::cSymbolUnsafe},
+    {L"\\;",                      Parser::cSymbolUnsafe},
+    {L"\\>",                      Parser::cSymbolUnsafe},
+    {L"\\quad",                   Parser::cSymbolUnsafe},
+    {L"\\qquad",                  Parser::cSymbolUnsafe},
+
+    {L"\\not",                    Parser::cSymbol},
+
+    {L"(",                        Parser::cSymbol},
+    {L")",                        Parser::cSymbol},
+    {L"[",                        Parser::cSymbol},
+    {L"]",                        Parser::cSymbol},
+    {L"<",                        Parser::cSymbol},
+    {L">",                        Parser::cSymbol},
+    {L"+",                        Parser::cSymbol},
+    {L"-",                        Parser::cSymbol},
+    {L"=",                        Parser::cSymbol},
+    {L"|",                        Parser::cSymbol},
+    {L";",                        Parser::cSymbol},
+    {L":",                        Parser::cSymbol},
+    {L",",                        Parser::cSymbol},
+    {L".",                        Parser::cSymbol},
+    {L"/",                        Parser::cSymbol},
+    {L"?",                        Parser::cSymbol},
+    {L"!",                        Parser::cSymbol},
+    {L"@",                        Parser::cSymbol},
+    {L"*",                        Parser::cSymbol},
+
+    {L"\\vert",                   Parser::cSymbol},
+    {L"\\lvert",                  Parser::cSymbol},
+    {L"\\rvert",                  Parser::cSymbol},
+    {L"\\Vert",                   Parser::cSymbol},
+    {L"\\lVert",                  Parser::cSymbol},
+    {L"\\rVert",                  Parser::cSymbol},
+    {L"\\lfloor",                 Parser::cSymbol},
+    {L"\\rfloor",                 Parser::cSymbol},
+    {L"\\lceil",                  Parser::cSymbol},
+    {L"\\rceil",                  Parser::cSymbol},
+    {L"\\lbrace",                 Parser::cSymbol},
+    {L"\\rbrace",                 Parser::cSymbol},
+    {L"\\langle",                 Parser::cSymbol},
+    {L"\\rangle",                 Parser::cSymbol},
+    {L"\\lbrack",                 Parser::cSymbol},
+    {L"\\rbrack",                 Parser::cSymbol},
+
+    {L"\\hat",                    Parser::cCommand1Arg},
+    {L"\\widehat",                Parser::cCommand1Arg},
+    {L"\\dot",                    Parser::cCommand1Arg},
+    {L"\\ddot",                   Parser::cCommand1Arg},
+    {L"\\bar",                    Parser::cCommand1Arg},
+    {L"\\overline",               Parser::cCommand1Arg},
+    {L"\\underline",              Parser::cCommand1Arg},
+    {L"\\overbrace",              Parser::cCommand1Arg},
+    {L"\\underbrace",             Parser::cCommand1Arg},
+    {L"\\overleftarrow",          Parser::cCommand1Arg},
+    {L"\\overrightarrow",         Parser::cCommand1Arg},
+    {L"\\overleftrightarrow",     Parser::cCommand1Arg},
+    {L"\\check",                  Parser::cCommand1Arg},
+    {L"\\acute",                  Parser::cCommand1Arg},
+    {L"\\grave",                  Parser::cCommand1Arg},
+    {L"\\vec",                    Parser::cCommand1Arg},
+    {L"\\breve",                  Parser::cCommand1Arg},
+    {L"\\tilde",                  Parser::cCommand1Arg},
+    {L"\\widetilde",              Parser::cCommand1Arg},
+
+    {L"\\mathbf",                 Parser::cCommand1Arg},
+    {L"\\mathbb",                 Parser::cCommand1Arg},
+    {L"\\mathrm",                 Parser::cCommand1Arg},
+    {L"\\mathit",                 Parser::cCommand1Arg},
+    {L"\\mathcal",                Parser::cCommand1Arg},
+    {L"\\mathfrak",               Parser::cCommand1Arg},
+    {L"\\mathsf",                 Parser::cCommand1Arg},
+    {L"\\mathtt",                 Parser::cCommand1Arg},
+    {L"\\boldsymbol",             Parser::cCommand1Arg},
+
+    {L"\\rm",                     Parser::cStateChange},
+    {L"\\bf",                     Parser::cStateChange},
+    {L"\\it",                     Parser::cStateChange},
+    {L"\\cal",                    Parser::cStateChange},
+    {L"\\tt",                     Parser::cStateChange},
+    {L"\\sf",                     Parser::cStateChange},
+
+    {L"\\displaystyle",           Parser::cStateChange},
+    {L"\\textstyle",              Parser::cStateChange},
+    {L"\\scriptstyle",            Parser::cStateChange},
+    {L"\\scriptscriptstyle",      Parser::cStateChange},
+
+    {L"\\color",                  Parser::cStateChange},
+
+    {L"\\varlimsup",              Parser::cSymbolUnsafe},
+    {L"\\varliminf",              Parser::cSymbolUnsafe},
+    {L"\\lim",                    Parser::cSymbolUnsafe},
+    {L"\\sup",                    Parser::cSymbolUnsafe},
+    {L"\\inf",                    Parser::cSymbolUnsafe},
+    {L"\\limsup",                 Parser::cSymbolUnsafe},
+    {L"\\liminf",                 Parser::cSymbolUnsafe},
+    {L"\\injlim",                 Parser::cSymbolUnsafe},
+    {L"\\projlim",                Parser::cSymbolUnsafe},
+    {L"\\min",                    Parser::cSymbolUnsafe},
+    {L"\\max",                    Parser::cSymbolUnsafe},
+    {L"\\gcd",                    Parser::cSymbolUnsafe},
+    {L"\\det",                    Parser::cSymbolUnsafe},
+    {L"\\Pr",                     Parser::cSymbolUnsafe},
+
+    {L"\\ker",                    Parser::cSymbolUnsafe},
+    {L"\\hom",                    Parser::cSymbolUnsafe},
+    {L"\\dim",                    Parser::cSymbolUnsafe},
+    {L"\\arg",                    Parser::cSymbolUnsafe},
+    {L"\\sin",                    Parser::cSymbolUnsafe},
+    {L"\\cos",                    Parser::cSymbolUnsafe},
+    {L"\\sec",                    Parser::cSymbolUnsafe},
+    {L"\\csc",                    Parser::cSymbolUnsafe},
+    {L"\\tan",                    Parser::cSymbolUnsafe},
+    {L"\\cot",                    Parser::cSymbolUnsafe},
+    {L"\\arcsin",                 Parser::cSymbolUnsafe},
+    {L"\\arccos",                 Parser::cSymbolUnsafe},
+    {L"\\arctan",                 Parser::cSymbolUnsafe},
+    {L"\\sinh",                   Parser::cSymbolUnsafe},
+    {L"\\cosh",                   Parser::cSymbolUnsafe},
+    {L"\\tanh",                   Parser::cSymbolUnsafe},
+    {L"\\coth",                   Parser::cSymbolUnsafe},
+    {L"\\log",                    Parser::cSymbolUnsafe},
+    {L"\\lg",                     Parser::cSymbolUnsafe},
+    {L"\\ln",                     Parser::cSymbolUnsafe},
+    {L"\\exp",                    Parser::cSymbolUnsafe},
+    {L"\\deg",                    Parser::cSymbolUnsafe},
+
+    {L"\\alpha",                  Parser::cSymbol},
+    {L"\\beta",                   Parser::cSymbol},
+    {L"\\gamma",                  Parser::cSymbol},
+    {L"\\delta",                  Parser::cSymbol},
+    {L"\\epsilon",                Parser::cSymbol},
+    {L"\\varepsilon",             Parser::cSymbol},
+    {L"\\zeta",                   Parser::cSymbol},
+    {L"\\eta",                    Parser::cSymbol},
+    {L"\\theta",                  Parser::cSymbol},
+    {L"\\vartheta",               Parser::cSymbol},
+    {L"\\iota",                   Parser::cSymbol},
+    {L"\\kappa",                  Parser::cSymbol},
+    {L"\\varkappa",               Parser::cSymbol},
+    {L"\\lambda",                 Parser::cSymbol},
+    {L"\\mu",                     Parser::cSymbol},
+    {L"\\nu",                     Parser::cSymbol},
+    {L"\\pi",                     Parser::cSymbol},
+    {L"\\varpi",                  Parser::cSymbol},
+    {L"\\rho",                    Parser::cSymbol},
+    {L"\\varrho",                 Parser::cSymbol},
+    {L"\\sigma",                  Parser::cSymbol},
+    {L"\\varsigma",               Parser::cSymbol},
+    {L"\\tau",                    Parser::cSymbol},
+    {L"\\upsilon",                Parser::cSymbol},
+    {L"\\phi",                    Parser::cSymbol},
+    {L"\\varphi",                 Parser::cSymbol},
+    {L"\\chi",                    Parser::cSymbol},
+    {L"\\psi",                    Parser::cSymbol},
+    {L"\\omega",                  Parser::cSymbol},
+    {L"\\xi",                     Parser::cSymbol},
+    {L"\\digamma",                Parser::cSymbol},
+
+    {L"\\Gamma",                  Parser::cSymbol},
+    {L"\\Delta",                  Parser::cSymbol},
+    {L"\\Theta",                  Parser::cSymbol},
+    {L"\\Lambda",                 Parser::cSymbol},
+    {L"\\Pi",                     Parser::cSymbol},
+    {L"\\Sigma",                  Parser::cSymbol},
+    {L"\\Upsilon",                Parser::cSymbol},
+    {L"\\Phi",                    Parser::cSymbol},
+    {L"\\Psi",                    Parser::cSymbol},
+    {L"\\Omega",                  Parser::cSymbol},
+    {L"\\Xi",                     Parser::cSymbol},
+
+    {L"\\aleph",                  Parser::cSymbol},
+    {L"\\beth",                   Parser::cSymbol},
+    {L"\\gimel",                  Parser::cSymbol},
+    {L"\\daleth",                 Parser::cSymbol},
+
+    {L"\\wp",                     Parser::cSymbol},
+    {L"\\ell",                    Parser::cSymbol},
+    {L"\\P",                      Parser::cSymbol},
+    {L"\\imath",                  Parser::cSymbol},
+    {L"\\forall",                 Parser::cSymbol},
+    {L"\\exists",                 Parser::cSymbol},
+    {L"\\Finv",                   Parser::cSymbol},
+    {L"\\Game",                   Parser::cSymbol},
+    {L"\\partial",                Parser::cSymbol},
+    {L"\\Re",                     Parser::cSymbol},
+    {L"\\Im",                     Parser::cSymbol},
+
+    {L"\\leftarrow",              Parser::cSymbol},
+    {L"\\rightarrow",             Parser::cSymbol},
+    {L"\\longleftarrow",          Parser::cSymbolUnsafe},
+    {L"\\longrightarrow",         Parser::cSymbolUnsafe},
+    {L"\\Leftarrow",              Parser::cSymbol},
+    {L"\\Rightarrow",             Parser::cSymbol},
+    {L"\\Longleftarrow",          Parser::cSymbolUnsafe},
+    {L"\\Longrightarrow",         Parser::cSymbolUnsafe},
+    {L"\\mapsto",                 Parser::cSymbolUnsafe},
+    {L"\\longmapsto",             Parser::cSymbolUnsafe},
+    {L"\\leftrightarrow",         Parser::cSymbol},
+    {L"\\Leftrightarrow",         Parser::cSymbol},
+    {L"\\longleftrightarrow",     Parser::cSymbolUnsafe},
+    {L"\\Longleftrightarrow",     Parser::cSymbolUnsafe},
+
+    {L"\\uparrow",                Parser::cSymbol},
+    {L"\\Uparrow",                Parser::cSymbol},
+    {L"\\downarrow",              Parser::cSymbol},
+    {L"\\Downarrow",              Parser::cSymbol},
+    {L"\\updownarrow",            Parser::cSymbol},
+    {L"\\Updownarrow",            Parser::cSymbol},
+
+    {L"\\searrow",                Parser::cSymbol},
+    {L"\\nearrow",                Parser::cSymbol},
+    {L"\\swarrow",                Parser::cSymbol},
+    {L"\\nwarrow",                Parser::cSymbol},
+
+    {L"\\hookrightarrow",         Parser::cSymbolUnsafe},
+    {L"\\hookleftarrow",          Parser::cSymbolUnsafe},
+    {L"\\upharpoonright",         Parser::cSymbol},
+    {L"\\upharpoonleft",          Parser::cSymbol},
+    {L"\\downharpoonright",       Parser::cSymbol},
+    {L"\\downharpoonleft",        Parser::cSymbol},
+    {L"\\rightharpoonup",         Parser::cSymbol},
+    {L"\\rightharpoondown",       Parser::cSymbol},
+    {L"\\leftharpoonup",          Parser::cSymbol},
+    {L"\\leftharpoondown",        Parser::cSymbol},
+
+    {L"\\nleftarrow",             Parser::cSymbol},
+    {L"\\nrightarrow",            Parser::cSymbol},
+
+    {L"\\supset",                 Parser::cSymbol},
+    {L"\\subset",                 Parser::cSymbol},
+    {L"\\supseteq",               Parser::cSymbol},
+    {L"\\subseteq",               Parser::cSymbol},
+    {L"\\sqsupset",               Parser::cSymbol},
+    {L"\\sqsubset",               Parser::cSymbol},
+    {L"\\sqsupseteq",             Parser::cSymbol},
+    {L"\\sqsubseteq",             Parser::cSymbol},
+    {L"\\supsetneq",              Parser::cSymbol},
+    {L"\\subsetneq",              Parser::cSymbol},
+
+    {L"\\in",                     Parser::cSymbol},
+    {L"\\ni",                     Parser::cSymbol},
+    {L"\\notin",                  Parser::cSymbolUnsafe},
+
+    {L"\\iff",                    Parser::cSymbolUnsafe},
+
+    {L"\\mid",                    Parser::cSymbol},
+    {L"\\sim",                    Parser::cSymbol},
+    {L"\\simeq",                  Parser::cSymbol},
+    {L"\\approx",                 Parser::cSymbol},
+    {L"\\propto",                 Parser::cSymbol},
+    {L"\\equiv",                  Parser::cSymbol},
+    {L"\\cong",                   Parser::cSymbolUnsafe},
+    {L"\\neq",                    Parser::cSymbolUnsafe},
+
+    {L"\\ll",                     Parser::cSymbol},
+    {L"\\gg",                     Parser::cSymbol},
+    {L"\\geq",                    Parser::cSymbol},
+    {L"\\leq",                    Parser::cSymbol},
+    {L"\\triangleleft",           Parser::cSymbol},
+    {L"\\triangleright",          Parser::cSymbol},
+
+    {L"\\models",                 Parser::cSymbolUnsafe},
+    {L"\\vdash",                  Parser::cSymbol},
+    {L"\\Vdash",                  Parser::cSymbol},
+    {L"\\vDash",                  Parser::cSymbol},
+
+    {L"\\lesssim",                Parser::cSymbol},
+    {L"\\nless",                  Parser::cSymbol},
+    {L"\\ngeq",                   Parser::cSymbol},
+    {L"\\nleq",                   Parser::cSymbol},
+
+    {L"\\ast",                    Parser::cSymbol},
+    {L"\\times",                  Parser::cSymbol},
+    {L"\\div",                    Parser::cSymbol},
+    {L"\\wedge",                  Parser::cSymbol},
+    {L"\\vee",                    Parser::cSymbol},
+    {L"\\oplus",                  Parser::cSymbol},
+    {L"\\otimes",                 Parser::cSymbol},
+    {L"\\cap",                    Parser::cSymbol},
+    {L"\\cup",                    Parser::cSymbol},
+    {L"\\sqcap",                  Parser::cSymbol},
+    {L"\\sqcup",                  Parser::cSymbol},
+    {L"\\smile",                  Parser::cSymbol},
+    {L"\\frown",                  Parser::cSymbol},
+    {L"\\smallsmile",             Parser::cSymbol},
+    {L"\\smallfrown",             Parser::cSymbol},
+
+    {L"\\setminus",               Parser::cSymbol},
+    {L"\\smallsetminus",          Parser::cSymbol},
+
+    {L"\\And",                    Parser::cSymbolUnsafe},
 
     // This next group of "large operators" are all "safe" in ordinary
     // TeX, but NOT when AMS-LaTeX is loaded, so we'll call them unsafe
@@ -454,481 +456,533 @@ pair<wstring, Parser::TokenCode> gMathTokenArray[] =
     // textstyle and below should all be the same size.
     // Although, amsmath does things differently: investigate that.
 
-    make_pair(L"\\sum",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\prod",                   Parser::cSymbolUnsafe),
-    make_pair(L"\\int",                    Parser::cSymbolUnsafe),
-    make_pair(L"\\iint",                   Parser::cSymbolUnsafe),
-    make_pair(L"\\iiint",                  Parser::cSymbolUnsafe),
-    make_pair(L"\\iiiint",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\oint",                   Parser::cSymbolUnsafe),
-    make_pair(L"\\bigcap",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\bigodot",                Parser::cSymbolUnsafe),
-    make_pair(L"\\bigcup",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\bigotimes",              Parser::cSymbolUnsafe),
-    make_pair(L"\\coprod",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\bigsqcup",               Parser::cSymbolUnsafe),
-    make_pair(L"\\bigoplus",               Parser::cSymbolUnsafe),
-    make_pair(L"\\bigvee",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\biguplus",               Parser::cSymbolUnsafe),
-    make_pair(L"\\bigwedge",               Parser::cSymbolUnsafe),
-
-    make_pair(L"\\star",                   Parser::cSymbol),
-    make_pair(L"\\triangle",               Parser::cSymbol),
-    make_pair(L"\\wr",                     Parser::cSymbol),
-    make_pair(L"\\infty",                  Parser::cSymbol),
-    make_pair(L"\\circ",                   Parser::cSymbol),
-    make_pair(L"\\hbar",                   Parser::cSymbol),
-    make_pair(L"\\lnot",                   Parser::cSymbol),
-    make_pair(L"\\nabla",                  Parser::cSymbol),
-    make_pair(L"\\prime",                  Parser::cSymbol),
-    make_pair(L"\\backslash",              Parser::cSymbol),
-    make_pair(L"\\pm",                     Parser::cSymbol),
-    make_pair(L"\\mp",                     Parser::cSymbol),
-    make_pair(L"\\emptyset",               Parser::cSymbol),
-    make_pair(L"\\varnothing",             Parser::cSymbol),
-    make_pair(L"\\S",                      Parser::cSymbol),
-    make_pair(L"\\angle",                  Parser::cSymbol),
-    make_pair(L"\\colon",                  Parser::cSymbolUnsafe),
-    make_pair(L"\\nmid",                   Parser::cSymbol),
-    make_pair(L"\\square",                 Parser::cSymbol),
-    make_pair(L"\\Box",                    Parser::cSymbol),
-    make_pair(L"\\checkmark",              Parser::cSymbol),
-    make_pair(L"\\complement",             Parser::cSymbol),
-    make_pair(L"\\eth",                    Parser::cSymbol),
-    make_pair(L"\\hslash",                 Parser::cSymbol),
-    make_pair(L"\\mho",                    Parser::cSymbol),
-
-    make_pair(L"\\flat",                   Parser::cSymbol),
-    make_pair(L"\\sharp",                  Parser::cSymbol),
-    make_pair(L"\\natural",                Parser::cSymbol),
-    make_pair(L"\\bullet",                 Parser::cSymbol),
-    make_pair(L"\\dagger",                 Parser::cSymbol),
-    make_pair(L"\\ddagger",                Parser::cSymbol),
-
-    make_pair(L"\\clubsuit",               Parser::cSymbol),
-    make_pair(L"\\spadesuit",              Parser::cSymbol),
-    make_pair(L"\\heartsuit",              Parser::cSymbol),
-    make_pair(L"\\diamondsuit",            Parser::cSymbol),
-
-    make_pair(L"\\top",                    Parser::cSymbol),
-    make_pair(L"\\bot",                    Parser::cSymbol),
-    make_pair(L"\\perp",                   Parser::cSymbol),
-
-    make_pair(L"\\ldots",                  Parser::cSymbolUnsafe),
-    make_pair(L"\\cdot",                   Parser::cSymbol),
-    make_pair(L"\\cdots",                  Parser::cSymbolUnsafe),
-    make_pair(L"\\vdots",                  Parser::cSymbolUnsafe),
-    make_pair(L"\\ddots",                  Parser::cSymbolUnsafe),
+    {L"\\sum",                    Parser::cSymbolUnsafe},
+    {L"\\prod",                   Parser::cSymbolUnsafe},
+    {L"\\int",                    Parser::cSymbolUnsafe},
+    {L"\\iint",                   Parser::cSymbolUnsafe},
+    {L"\\iiint",                  Parser::cSymbolUnsafe},
+    {L"\\iiiint",                 Parser::cSymbolUnsafe},
+    {L"\\oint",                   Parser::cSymbolUnsafe},
+    {L"\\bigcap",                 Parser::cSymbolUnsafe},
+    {L"\\bigodot",                Parser::cSymbolUnsafe},
+    {L"\\bigcup",                 Parser::cSymbolUnsafe},
+    {L"\\bigotimes",              Parser::cSymbolUnsafe},
+    {L"\\coprod",                 Parser::cSymbolUnsafe},
+    {L"\\bigsqcup",               Parser::cSymbolUnsafe},
+    {L"\\bigoplus",               Parser::cSymbolUnsafe},
+    {L"\\bigvee",                 Parser::cSymbolUnsafe},
+    {L"\\biguplus",               Parser::cSymbolUnsafe},
+    {L"\\bigwedge",               Parser::cSymbolUnsafe},
+
+    {L"\\star",                   Parser::cSymbol},
+    {L"\\triangle",               Parser::cSymbol},
+    {L"\\wr",                     Parser::cSymbol},
+    {L"\\infty",                  Parser::cSymbol},
+    {L"\\circ",                   Parser::cSymbol},
+    {L"\\hbar",                   Parser::cSymbol},
+    {L"\\lnot",                   Parser::cSymbol},
+    {L"\\nabla",                  Parser::cSymbol},
+    {L"\\prime",                  Parser::cSymbol},
+    {L"\\backslash",              Parser::cSymbol},
+    {L"\\pm",                     Parser::cSymbol},
+    {L"\\mp",                     Parser::cSymbol},
+    {L"\\emptyset",               Parser::cSymbol},
+    {L"\\varnothing",             Parser::cSymbol},
+    {L"\\S",                      Parser::cSymbol},
+    {L"\\angle",                  Parser::cSymbol},
+    {L"\\colon",                  Parser::cSymbolUnsafe},
+    {L"\\nmid",                   Parser::cSymbol},
+    {L"\\square",                 Parser::cSymbol},
+    {L"\\Box",                    Parser::cSymbol},
+    {L"\\checkmark",              Parser::cSymbol},
+    {L"\\complement",             Parser::cSymbol},
+    {L"\\eth",                    Parser::cSymbol},
+    {L"\\hslash",                 Parser::cSymbol},
+    {L"\\mho",                    Parser::cSymbol},
+
+    {L"\\flat",                   Parser::cSymbol},
+    {L"\\sharp",                  Parser::cSymbol},
+    {L"\\natural",                Parser::cSymbol},
+    {L"\\bullet",                 Parser::cSymbol},
+    {L"\\dagger",                 Parser::cSymbol},
+    {L"\\ddagger",                Parser::cSymbol},
+
+    {L"\\clubsuit",               Parser::cSymbol},
+    {L"\\spadesuit",              Parser::cSymbol},
+    {L"\\heartsuit",              Parser::cSymbol},
+    {L"\\diamondsuit",            Parser::cSymbol},
+
+    {L"\\top",                    Parser::cSymbol},
+    {L"\\bot",                    Parser::cSymbol},
+    {L"\\perp",                   Parser::cSymbol},
+
+    {L"\\ldots",                  Parser::cSymbolUnsafe},
+    {L"\\cdot",                   Parser::cSymbol},
+    {L"\\cdots",                  Parser::cSymbolUnsafe},
+    {L"\\vdots",                  Parser::cSymbolUnsafe},
+    {L"\\ddots",                  Parser::cSymbolUnsafe},
 
     // AMSLaTeX is pretty clever with "\dots" and "\dotsb"; it adjusts the
     // height of the dots based on the surrounding symbols. Blahtex
     // currently doesn't do this.
-    make_pair(L"\\dots",                   Parser::cSymbolUnsafe),
-    make_pair(L"\\dotsb",                  Parser::cSymbolUnsafe),
-
-    make_pair(L"\\varinjlim",              Parser::cSymbolUnsafe),
-    make_pair(L"\\varprojlim",             Parser::cSymbolUnsafe),
-
-    make_pair(L"\\circledR",               Parser::cSymbol),
-    make_pair(L"\\yen",                    Parser::cSymbol),
-    make_pair(L"\\maltese",                Parser::cSymbol),
-    make_pair(L"\\ulcorner",               Parser::cSymbol),
-    make_pair(L"\\urcorner",               Parser::cSymbol),
-    make_pair(L"\\llcorner",               Parser::cSymbol),
-    make_pair(L"\\lrcorner",               Parser::cSymbol),
-    make_pair(L"\\dashrightarrow",         Parser::cSymbolUnsafe),
-    make_pair(L"\\dashleftarrow",          Parser::cSymbolUnsafe),
-    make_pair(L"\\backprime",              Parser::cSymbol),
-    make_pair(L"\\vartriangle",            Parser::cSymbol),
-    make_pair(L"\\blacktriangle",          Parser::cSymbol),
-    make_pair(L"\\triangledown",           Parser::cSymbol),
-    make_pair(L"\\blacktriangledown",      Parser::cSymbol),
-    make_pair(L"\\blacksquare",            Parser::cSymbol),
-    make_pair(L"\\lozenge",                Parser::cSymbol),
-    make_pair(L"\\blacklozenge",           Parser::cSymbol),
-    make_pair(L"\\circledS",               Parser::cSymbol),
-    make_pair(L"\\bigstar",                Parser::cSymbol),
-    make_pair(L"\\sphericalangle",         Parser::cSymbol),
-    make_pair(L"\\measuredangle",          Parser::cSymbol),
-    make_pair(L"\\Bbbk",                   Parser::cSymbol),
-    make_pair(L"\\dotplus",                Parser::cSymbol),
-    make_pair(L"\\ltimes",                 Parser::cSymbol),
-    make_pair(L"\\rtimes",                 Parser::cSymbol),
-    make_pair(L"\\Cap",                    Parser::cSymbol),
-    make_pair(L"\\leftthreetimes",         Parser::cSymbol),
-    make_pair(L"\\rightthreetimes",        Parser::cSymbol),
-    make_pair(L"\\Cup",                    Parser::cSymbol),
-    make_pair(L"\\barwedge",               Parser::cSymbol),
-    make_pair(L"\\curlywedge",             Parser::cSymbol),
-    make_pair(L"\\veebar",                 Parser::cSymbol),
-    make_pair(L"\\curlyvee",               Parser::cSymbol),
-    make_pair(L"\\doublebarwedge",         Parser::cSymbol),
-    make_pair(L"\\boxminus",               Parser::cSymbol),
-    make_pair(L"\\circleddash",            Parser::cSymbol),
-    make_pair(L"\\boxtimes",               Parser::cSymbol),
-    make_pair(L"\\circledast",             Parser::cSymbol),
-    make_pair(L"\\boxdot",                 Parser::cSymbol),
-    make_pair(L"\\circledcirc",            Parser::cSymbol),
-    make_pair(L"\\boxplus",                Parser::cSymbol),
-    make_pair(L"\\centerdot",              Parser::cSymbol),
-    make_pair(L"\\divideontimes",          Parser::cSymbol),
-    make_pair(L"\\intercal",               Parser::cSymbol),
-    make_pair(L"\\leqq",                   Parser::cSymbol),
-    make_pair(L"\\geqq",                   Parser::cSymbol),
-    make_pair(L"\\leqslant",               Parser::cSymbol),
-    make_pair(L"\\geqslant",               Parser::cSymbol),
-    make_pair(L"\\eqslantless",            Parser::cSymbol),
-    make_pair(L"\\eqslantgtr",             Parser::cSymbol),
-    make_pair(L"\\gtrsim",                 Parser::cSymbol),
-    make_pair(L"\\lessapprox",             Parser::cSymbol),
-    make_pair(L"\\gtrapprox",              Parser::cSymbol),
-    make_pair(L"\\approxeq",               Parser::cSymbol),
-    make_pair(L"\\eqsim",                  Parser::cSymbol),
-    make_pair(L"\\lessdot",                Parser::cSymbol),
-    make_pair(L"\\gtrdot",                 Parser::cSymbol),
-    make_pair(L"\\lll",                    Parser::cSymbol),
-    make_pair(L"\\ggg",                    Parser::cSymbol),
-    make_pair(L"\\lessgtr",                Parser::cSymbol),
-    make_pair(L"\\gtrless",                Parser::cSymbol),
-    make_pair(L"\\lesseqgtr",              Parser::cSymbol),
-    make_pair(L"\\gtreqless",              Parser::cSymbol),
-    make_pair(L"\\lesseqqgtr",             Parser::cSymbol),
-    make_pair(L"\\gtreqqless",             Parser::cSymbol),
-    make_pair(L"\\doteqdot",               Parser::cSymbol),
-    make_pair(L"\\eqcirc",                 Parser::cSymbol),
-    make_pair(L"\\risingdotseq",           Parser::cSymbol),
-    make_pair(L"\\circeq",                 Parser::cSymbol),
-    make_pair(L"\\fallingdotseq",          Parser::cSymbol),
-    make_pair(L"\\triangleq",              Parser::cSymbol),
-    make_pair(L"\\backsim",                Parser::cSymbol),
-    make_pair(L"\\thicksim",               Parser::cSymbol),
-    make_pair(L"\\backsimeq",              Parser::cSymbol),
-    make_pair(L"\\thickapprox",            Parser::cSymbol),
-    make_pair(L"\\subseteqq",              Parser::cSymbol),
-    make_pair(L"\\supseteqq",              Parser::cSymbol),
-    make_pair(L"\\Subset",                 Parser::cSymbol),
-    make_pair(L"\\Supset",                 Parser::cSymbol),
-    make_pair(L"\\preccurlyeq",            Parser::cSymbol),
-    make_pair(L"\\succcurlyeq",            Parser::cSymbol),
-    make_pair(L"\\curlyeqprec",            Parser::cSymbol),
-    make_pair(L"\\curlyeqsucc",            Parser::cSymbol),
-    make_pair(L"\\precsim",                Parser::cSymbol),
-    make_pair(L"\\succsim",                Parser::cSymbol),
-    make_pair(L"\\precapprox",             Parser::cSymbol),
-    make_pair(L"\\succapprox",             Parser::cSymbol),
-    make_pair(L"\\Vvdash",                 Parser::cSymbol),
-    make_pair(L"\\shortmid",               Parser::cSymbol),
-    make_pair(L"\\shortparallel",          Parser::cSymbol),
-    make_pair(L"\\bumpeq",                 Parser::cSymbol),
-    make_pair(L"\\between",                Parser::cSymbol),
-    make_pair(L"\\Bumpeq",                 Parser::cSymbol),
-    make_pair(L"\\varpropto",              Parser::cSymbol),
-    make_pair(L"\\backepsilon",            Parser::cSymbol),
-    make_pair(L"\\blacktriangleleft",      Parser::cSymbol),
-    make_pair(L"\\blacktriangleright",     Parser::cSymbol),
-    make_pair(L"\\therefore",              Parser::cSymbol),
-    make_pair(L"\\because",                Parser::cSymbol),
-    make_pair(L"\\ngtr",                   Parser::cSymbol),
-    make_pair(L"\\nleqslant",              Parser::cSymbol),
-    make_pair(L"\\ngeqslant",              Parser::cSymbol),
-    make_pair(L"\\nleqq",                  Parser::cSymbol),
-    make_pair(L"\\ngeqq",                  Parser::cSymbol),
-    make_pair(L"\\lneqq",                  Parser::cSymbol),
-    make_pair(L"\\gneqq",                  Parser::cSymbol),
-    make_pair(L"\\lvertneqq",              Parser::cSymbol),
-    make_pair(L"\\gvertneqq",              Parser::cSymbol),
-    make_pair(L"\\lnsim",                  Parser::cSymbol),
-    make_pair(L"\\gnsim",                  Parser::cSymbol),
-    make_pair(L"\\lnapprox",               Parser::cSymbol),
-    make_pair(L"\\gnapprox",               Parser::cSymbol),
-    make_pair(L"\\nprec",                  Parser::cSymbol),
-    make_pair(L"\\nsucc",                  Parser::cSymbol),
-    make_pair(L"\\npreceq",                Parser::cSymbol),
-    make_pair(L"\\nsucceq",                Parser::cSymbol),
-    make_pair(L"\\precneqq",               Parser::cSymbol),
-    make_pair(L"\\succneqq",               Parser::cSymbol),
-    make_pair(L"\\precnsim",               Parser::cSymbol),
-    make_pair(L"\\succnsim",               Parser::cSymbol),
-    make_pair(L"\\precnapprox",            Parser::cSymbol),
-    make_pair(L"\\succnapprox",            Parser::cSymbol),
-    make_pair(L"\\nsim",                   Parser::cSymbol),
-    make_pair(L"\\ncong",                  Parser::cSymbol),
-    make_pair(L"\\nshortmid",              Parser::cSymbol),
-    make_pair(L"\\nshortparallel",         Parser::cSymbol),
-    make_pair(L"\\nmid",                   Parser::cSymbol),
-    make_pair(L"\\nparallel",              Parser::cSymbol),
-    make_pair(L"\\nvdash",                 Parser::cSymbol),
-    make_pair(L"\\nvDash",                 Parser::cSymbol),
-    make_pair(L"\\nVdash",                 Parser::cSymbol),
-    make_pair(L"\\nVDash",                 Parser::cSymbol),
-    make_pair(L"\\ntriangleleft",          Parser::cSymbol),
-    make_pair(L"\\ntriangleright",         Parser::cSymbol),
-    make_pair(L"\\ntrianglelefteq",        Parser::cSymbol),
-    make_pair(L"\\ntrianglerighteq",       Parser::cSymbol),
-    make_pair(L"\\nsubseteq",              Parser::cSymbol),
-    make_pair(L"\\nsupseteq",              Parser::cSymbol),
-    make_pair(L"\\nsubseteqq",             Parser::cSymbol),
-    make_pair(L"\\nsupseteqq",             Parser::cSymbol),
-    make_pair(L"\\subsetneq",              Parser::cSymbol),
-    make_pair(L"\\supsetneq",              Parser::cSymbol),
-    make_pair(L"\\varsubsetneq",           Parser::cSymbol),
-    make_pair(L"\\varsupsetneq",           Parser::cSymbol),
-    make_pair(L"\\subsetneqq",             Parser::cSymbol),
-    make_pair(L"\\supsetneqq",             Parser::cSymbol),
-    make_pair(L"\\varsubsetneqq",          Parser::cSymbol),
-    make_pair(L"\\varsupsetneqq",          Parser::cSymbol),
-    make_pair(L"\\leftleftarrows",         Parser::cSymbol),
-    make_pair(L"\\rightrightarrows",       Parser::cSymbol),
-    make_pair(L"\\leftrightarrows",        Parser::cSymbol),
-    make_pair(L"\\rightleftarrows",        Parser::cSymbol),
-    make_pair(L"\\Lleftarrow",             Parser::cSymbol),
-    make_pair(L"\\Rrightarrow",            Parser::cSymbol),
-    make_pair(L"\\twoheadleftarrow",       Parser::cSymbol),
-    make_pair(L"\\twoheadrightarrow",      Parser::cSymbol),
-    make_pair(L"\\leftarrowtail",          Parser::cSymbol),
-    make_pair(L"\\rightarrowtail",         Parser::cSymbol),
-    make_pair(L"\\looparrowleft",          Parser::cSymbol),
-    make_pair(L"\\looparrowright",         Parser::cSymbol),
-    make_pair(L"\\leftrightharpoons",      Parser::cSymbol),
-    make_pair(L"\\rightleftharpoons",      Parser::cSymbol),
-    make_pair(L"\\curvearrowleft",         Parser::cSymbol),
-    make_pair(L"\\curvearrowright",        Parser::cSymbol),
-    make_pair(L"\\circlearrowleft",        Parser::cSymbol),
-    make_pair(L"\\circlearrowright",       Parser::cSymbol),
-    make_pair(L"\\Lsh",                    Parser::cSymbol),
-    make_pair(L"\\Rsh",                    Parser::cSymbol),
-    make_pair(L"\\upuparrows",             Parser::cSymbol),
-    make_pair(L"\\downdownarrows",         Parser::cSymbol),
-    make_pair(L"\\multimap",               Parser::cSymbol),
-    make_pair(L"\\rightsquigarrow",        Parser::cSymbol),
-    make_pair(L"\\leftrightsquigarrow",    Parser::cSymbol),
-    make_pair(L"\\nLeftarrow",             Parser::cSymbol),
-    make_pair(L"\\nRightarrow",            Parser::cSymbol),
-    make_pair(L"\\nleftrightarrow",        Parser::cSymbol),
-    make_pair(L"\\nLeftrightarrow",        Parser::cSymbol),
-    make_pair(L"\\pitchfork",              Parser::cSymbol),
-    make_pair(L"\\nexists",                Parser::cSymbol),
-    make_pair(L"\\lhd",                    Parser::cSymbol),
-    make_pair(L"\\rhd",                    Parser::cSymbol),
-    make_pair(L"\\unlhd",                  Parser::cSymbol),
-    make_pair(L"\\unrhd",                  Parser::cSymbol),
-    make_pair(L"\\leadsto",                Parser::cSymbol),
-    make_pair(L"\\uplus",                  Parser::cSymbol),
-    make_pair(L"\\diamond",                Parser::cSymbol),
-    make_pair(L"\\bigtriangleup",          Parser::cSymbol),
-    make_pair(L"\\bigtriangledown",        Parser::cSymbol),
-    make_pair(L"\\ominus",                 Parser::cSymbol),
-    make_pair(L"\\oslash",                 Parser::cSymbol),
-    make_pair(L"\\odot",                   Parser::cSymbol),
-    make_pair(L"\\bigcirc",                Parser::cSymbol),
-    make_pair(L"\\amalg",                  Parser::cSymbol),
-    make_pair(L"\\prec",                   Parser::cSymbol),
-    make_pair(L"\\succ",                   Parser::cSymbol),
-    make_pair(L"\\preceq",                 Parser::cSymbol),
-    make_pair(L"\\succeq",                 Parser::cSymbol),
-    make_pair(L"\\dashv",                  Parser::cSymbol),
-    make_pair(L"\\asymp",                  Parser::cSymbol),
-    make_pair(L"\\doteq",                  Parser::cSymbolUnsafe),
-    make_pair(L"\\parallel",               Parser::cSymbol),
-    make_pair(L"\\bowtie",                 Parser::cSymbolUnsafe),
-    make_pair(L"\\jmath",                  Parser::cSymbol),
-    make_pair(L"\\surd",                   Parser::cSymbol)
+    {L"\\dots",                   Parser::cSymbolUnsafe},
+    {L"\\dotsb",                  Parser::cSymbolUnsafe},
+
+    {L"\\varinjlim",              Parser::cSymbolUnsafe},
+    {L"\\varprojlim",             Parser::cSymbolUnsafe},
+
+    {L"\\circledR",               Parser::cSymbol},
+    {L"\\yen",                    Parser::cSymbol},
+    {L"\\maltese",                Parser::cSymbol},
+    {L"\\ulcorner",               Parser::cSymbol},
+    {L"\\urcorner",               Parser::cSymbol},
+    {L"\\llcorner",               Parser::cSymbol},
+    {L"\\lrcorner",               Parser::cSymbol},
+    {L"\\dashrightarrow",         Parser::cSymbolUnsafe},
+    {L"\\dashleftarrow",          Parser::cSymbolUnsafe},
+    {L"\\backprime",              Parser::cSymbol},
+    {L"\\vartriangle",            Parser::cSymbol},
+    {L"\\blacktriangle",          Parser::cSymbol},
+    {L"\\triangledown",           Parser::cSymbol},
+    {L"\\blacktriangledown",      Parser::cSymbol},
+    {L"\\blacksquare",            Parser::cSymbol},
+    {L"\\lozenge",                Parser::cSymbol},
+    {L"\\blacklozenge",           Parser::cSymbol},
+    {L"\\circledS",               Parser::cSymbol},
+    {L"\\bigstar",                Parser::cSymbol},
+    {L"\\sphericalangle",         Parser::cSymbol},
+    {L"\\measuredangle",          Parser::cSymbol},
+    {L"\\Bbbk",                   Parser::cSymbol},
+    {L"\\dotplus",                Parser::cSymbol},
+    {L"\\ltimes",                 Parser::cSymbol},
+    {L"\\rtimes",                 Parser::cSymbol},
+    {L"\\Cap",                    Parser::cSymbol},
+    {L"\\leftthreetimes",         Parser::cSymbol},
+    {L"\\rightthreetimes",        Parser::cSymbol},
+    {L"\\Cup",                    Parser::cSymbol},
+    {L"\\barwedge",               Parser::cSymbol},
+    {L"\\curlywedge",             Parser::cSymbol},
+    {L"\\veebar",                 Parser::cSymbol},
+    {L"\\curlyvee",               Parser::cSymbol},
+    {L"\\doublebarwedge",         Parser::cSymbol},
+    {L"\\boxminus",               Parser::cSymbol},
+    {L"\\circleddash",            Parser::cSymbol},
+    {L"\\boxtimes",               Parser::cSymbol},
+    {L"\\circledast",             Parser::cSymbol},
+    {L"\\boxdot",                 Parser::cSymbol},
+    {L"\\circledcirc",            Parser::cSymbol},
+    {L"\\boxplus",                Parser::cSymbol},
+    {L"\\centerdot",              Parser::cSymbol},
+    {L"\\divideontimes",          Parser::cSymbol},
+    {L"\\intercal",               Parser::cSymbol},
+    {L"\\leqq",                   Parser::cSymbol},
+    {L"\\geqq",                   Parser::cSymbol},
+    {L"\\leqslant",               Parser::cSymbol},
+    {L"\\geqslant",               Parser::cSymbol},
+    {L"\\eqslantless",            Parser::cSymbol},
+    {L"\\eqslantgtr",             Parser::cSymbol},
+    {L"\\gtrsim",                 Parser::cSymbol},
+    {L"\\lessapprox",             Parser::cSymbol},
+    {L"\\gtrapprox",              Parser::cSymbol},
+    {L"\\approxeq",               Parser::cSymbol},
+    {L"\\eqsim",                  Parser::cSymbol},
+    {L"\\lessdot",                Parser::cSymbol},
+    {L"\\gtrdot",                 Parser::cSymbol},
+    {L"\\lll",                    Parser::cSymbol},
+    {L"\\ggg",                    Parser::cSymbol},
+    {L"\\lessgtr",                Parser::cSymbol},
+    {L"\\gtrless",                Parser::cSymbol},
+    {L"\\lesseqgtr",              Parser::cSymbol},
+    {L"\\gtreqless",              Parser::cSymbol},
+    {L"\\lesseqqgtr",             Parser::cSymbol},
+    {L"\\gtreqqless",             Parser::cSymbol},
+    {L"\\doteqdot",               Parser::cSymbol},
+    {L"\\eqcirc",                 Parser::cSymbol},
+    {L"\\risingdotseq",           Parser::cSymbol},
+    {L"\\circeq",                 Parser::cSymbol},
+    {L"\\fallingdotseq",          Parser::cSymbol},
+    {L"\\triangleq",              Parser::cSymbol},
+    {L"\\backsim",                Parser::cSymbol},
+    {L"\\thicksim",               Parser::cSymbol},
+    {L"\\backsimeq",              Parser::cSymbol},
+    {L"\\thickapprox",            Parser::cSymbol},
+    {L"\\subseteqq",              Parser::cSymbol},
+    {L"\\supseteqq",              Parser::cSymbol},
+    {L"\\Subset",                 Parser::cSymbol},
+    {L"\\Supset",                 Parser::cSymbol},
+    {L"\\preccurlyeq",            Parser::cSymbol},
+    {L"\\succcurlyeq",            Parser::cSymbol},
+    {L"\\curlyeqprec",            Parser::cSymbol},
+    {L"\\curlyeqsucc",            Parser::cSymbol},
+    {L"\\precsim",                Parser::cSymbol},
+    {L"\\succsim",                Parser::cSymbol},
+    {L"\\precapprox",             Parser::cSymbol},
+    {L"\\succapprox",             Parser::cSymbol},
+    {L"\\Vvdash",                 Parser::cSymbol},
+    {L"\\shortmid",               Parser::cSymbol},
+    {L"\\shortparallel",          Parser::cSymbol},
+    {L"\\bumpeq",                 Parser::cSymbol},
+    {L"\\between",                Parser::cSymbol},
+    {L"\\Bumpeq",                 Parser::cSymbol},
+    {L"\\varpropto",              Parser::cSymbol},
+    {L"\\backepsilon",            Parser::cSymbol},
+    {L"\\blacktriangleleft",      Parser::cSymbol},
+    {L"\\blacktriangleright",     Parser::cSymbol},
+    {L"\\therefore",              Parser::cSymbol},
+    {L"\\because",                Parser::cSymbol},
+    {L"\\ngtr",                   Parser::cSymbol},
+    {L"\\nleqslant",              Parser::cSymbol},
+    {L"\\ngeqslant",              Parser::cSymbol},
+    {L"\\nleqq",                  Parser::cSymbol},
+    {L"\\ngeqq",                  Parser::cSymbol},
+    {L"\\lneqq",                  Parser::cSymbol},
+    {L"\\gneqq",                  Parser::cSymbol},
+    {L"\\lvertneqq",              Parser::cSymbol},
+    {L"\\gvertneqq",              Parser::cSymbol},
+    {L"\\lnsim",                  Parser::cSymbol},
+    {L"\\gnsim",                  Parser::cSymbol},
+    {L"\\lnapprox",               Parser::cSymbol},
+    {L"\\gnapprox",               Parser::cSymbol},
+    {L"\\nprec",                  Parser::cSymbol},
+    {L"\\nsucc",                  Parser::cSymbol},
+    {L"\\npreceq",                Parser::cSymbol},
+    {L"\\nsucceq",                Parser::cSymbol},
+    {L"\\precneqq",               Parser::cSymbol},
+    {L"\\succneqq",               Parser::cSymbol},
+    {L"\\precnsim",               Parser::cSymbol},
+    {L"\\succnsim",               Parser::cSymbol},
+    {L"\\precnapprox",            Parser::cSymbol},
+    {L"\\succnapprox",            Parser::cSymbol},
+    {L"\\nsim",                   Parser::cSymbol},
+    {L"\\ncong",                  Parser::cSymbol},
+    {L"\\nshortmid",              Parser::cSymbol},
+    {L"\\nshortparallel",         Parser::cSymbol},
+    {L"\\nmid",                   Parser::cSymbol},
+    {L"\\nparallel",              Parser::cSymbol},
+    {L"\\nvdash",                 Parser::cSymbol},
+    {L"\\nvDash",                 Parser::cSymbol},
+    {L"\\nVdash",                 Parser::cSymbol},
+    {L"\\nVDash",                 Parser::cSymbol},
+    {L"\\ntriangleleft",          Parser::cSymbol},
+    {L"\\ntriangleright",         Parser::cSymbol},
+    {L"\\ntrianglelefteq",        Parser::cSymbol},
+    {L"\\ntrianglerighteq",       Parser::cSymbol},
+    {L"\\nsubseteq",              Parser::cSymbol},
+    {L"\\nsupseteq",              Parser::cSymbol},
+    {L"\\nsubseteqq",             Parser::cSymbol},
+    {L"\\nsupseteqq",             Parser::cSymbol},
+    {L"\\subsetneq",              Parser::cSymbol},
+    {L"\\supsetneq",              Parser::cSymbol},
+    {L"\\varsubsetneq",           Parser::cSymbol},
+    {L"\\varsupsetneq",           Parser::cSymbol},
+    {L"\\subsetneqq",             Parser::cSymbol},
+    {L"\\supsetneqq",             Parser::cSymbol},
+    {L"\\varsubsetneqq",          Parser::cSymbol},
+    {L"\\varsupsetneqq",          Parser::cSymbol},
+    {L"\\leftleftarrows",         Parser::cSymbol},
+    {L"\\rightrightarrows",       Parser::cSymbol},
+    {L"\\leftrightarrows",        Parser::cSymbol},
+    {L"\\rightleftarrows",        Parser::cSymbol},
+    {L"\\Lleftarrow",             Parser::cSymbol},
+    {L"\\Rrightarrow",            Parser::cSymbol},
+    {L"\\twoheadleftarrow",       Parser::cSymbol},
+    {L"\\twoheadrightarrow",      Parser::cSymbol},
+    {L"\\leftarrowtail",          Parser::cSymbol},
+    {L"\\rightarrowtail",         Parser::cSymbol},
+    {L"\\looparrowleft",          Parser::cSymbol},
+    {L"\\looparrowright",         Parser::cSymbol},
+    {L"\\leftrightharpoons",      Parser::cSymbol},
+    {L"\\rightleftharpoons",      Parser::cSymbol},
+    {L"\\curvearrowleft",         Parser::cSymbol},
+    {L"\\curvearrowright",        Parser::cSymbol},
+    {L"\\circlearrowleft",        Parser::cSymbol},
+    {L"\\circlearrowright",       Parser::cSymbol},
+    {L"\\Lsh",                    Parser::cSymbol},
+    {L"\\Rsh",                    Parser::cSymbol},
+    {L"\\upuparrows",             Parser::cSymbol},
+    {L"\\downdownarrows",         Parser::cSymbol},
+    {L"\\multimap",               Parser::cSymbol},
+    {L"\\rightsquigarrow",        Parser::cSymbol},
+    {L"\\leftrightsquigarrow",    Parser::cSymbol},
+    {L"\\nLeftarrow",             Parser::cSymbol},
+    {L"\\nRightarrow",            Parser::cSymbol},
+    {L"\\nleftrightarrow",        Parser::cSymbol},
+    {L"\\nLeftrightarrow",        Parser::cSymbol},
+    {L"\\pitchfork",              Parser::cSymbol},
+    {L"\\nexists",                Parser::cSymbol},
+    {L"\\lhd",                    Parser::cSymbol},
+    {L"\\rhd",                    Parser::cSymbol},
+    {L"\\unlhd",                  Parser::cSymbol},
+    {L"\\unrhd",                  Parser::cSymbol},
+    {L"\\leadsto",                Parser::cSymbol},
+    {L"\\uplus",                  Parser::cSymbol},
+    {L"\\diamond",                Parser::cSymbol},
+    {L"\\bigtriangleup",          Parser::cSymbol},
+    {L"\\bigtriangledown",        Parser::cSymbol},
+    {L"\\ominus",                 Parser::cSymbol},
+    {L"\\oslash",                 Parser::cSymbol},
+    {L"\\odot",                   Parser::cSymbol},
+    {L"\\bigcirc",                Parser::cSymbol},
+    {L"\\amalg",                  Parser::cSymbol},
+    {L"\\prec",                   Parser::cSymbol},
+    {L"\\succ",                   Parser::cSymbol},
+    {L"\\preceq",                 Parser::cSymbol},
+    {L"\\succeq",                 Parser::cSymbol},
+    {L"\\dashv",                  Parser::cSymbol},
+    {L"\\asymp",                  Parser::cSymbol},
+    {L"\\doteq",                  Parser::cSymbolUnsafe},
+    {L"\\parallel",               Parser::cSymbol},
+    {L"\\bowtie",                 Parser::cSymbolUnsafe},
+    {L"\\jmath",                  Parser::cSymbol},
+    {L"\\surd",                   Parser::cSymbol}
 };
 
-wishful_hash_map<wstring, Parser::TokenCode> gMathTokenTable(
+// Marks tokens that don't appear in one of the arrays.
+const unsigned char cNoTokenCode = 0xFF;
+
+// Returns a vector indexed by token (in the global token table) giving the
+// token code for each command in the supplied array, or cNoTokenCode for
+// those not in the array. This way the parser can find the code for a
+// command without any string comparisons.
+vector<unsigned char> BuildTokenCodes(
+    const TableEntry<Parser::TokenCode>* begin,
+    const TableEntry<Parser::TokenCode>* end
+)
+{
+    TokenTable& tokenTable = GetGlobalTokenTable();
+    vector<Token> tokens;
+    for (const TableEntry<Parser::TokenCode>* ptr = begin;
+        ptr != end;
+        ptr++
+    )
+        tokens.push_back(tokenTable.Intern(ptr->mName, wcslen(ptr->mName)));
+
+    vector<unsigned char> output(tokenTable.Size(), cNoTokenCode);
+    for (size_t index = 0; index < tokens.size(); index++)
+        output[tokens[index]] = begin[index].mValue;
+    return output;
+}
+
+const vector<unsigned char> gMathTokenCodes = BuildTokenCodes(
     gMathTokenArray,
     END_ARRAY(gMathTokenArray)
 );
 
-pair<wstring, Parser::TokenCode> gTextTokenArray[] =
+const TableEntry<Parser::TokenCode> gTextTokenArray[] =
 {
-    make_pair(L"",                         Parser::cEndOfInput),
-    make_pair(L" ",                        Parser::cWhitespace),
-    make_pair(L"\\newcommand",             Parser::cNewcommand),
-
-    make_pair(L"{",                        Parser::cBeginGroup),
-    make_pair(L"}",                        Parser::cEndGroup),
-
-    make_pair(L"$",                        Parser::cIllegal),
-    make_pair(L"%",                        Parser::cIllegal),
-    make_pair(L"#",                        Parser::cIllegal),
-    make_pair(L"&",                        Parser::cIllegal),
-    make_pair(L"\\\\",                     Parser::cIllegal),
-    make_pair(L"^",                        Parser::cIllegal),
-    make_pair(L"_",                        Parser::cIllegal),
-
-    make_pair(L"\\&",                      Parser::cSymbol),
-    make_pair(L"\\_",                      Parser::cSymbol),
-    make_pair(L"\\$",                      Parser::cSymbol),
-    make_pair(L"\\#",                      Parser::cSymbol),
-    make_pair(L"\\%",                      Parser::cSymbol),
-    make_pair(L"\\{",                      Parser::cSymbol),
-    make_pair(L"\\}",                      Parser::cSymbol),
-    make_pair(L"\\textbackslash",          Parser::cSymbol),
-    make_pair(L"\\textvisiblespace",       Parser::cSymbol),
-    make_pair(L"\\textasciicircum",        Parser::cSymbol),
-    make_pair(L"\\textasciitilde",         Parser::cSymbol),
-    make_pair(L"\\O",                      Parser::cSymbol),
-    make_pair(L"\\S",                      Parser::cSymbol),
-
-    make_pair(L"!",                        Parser::cSymbol),
-    make_pair(L"@",                        Parser::cSymbol),
-    make_pair(L"*",                        Parser::cSymbol),
-    make_pair(L"(",                        Parser::cSymbol),
-    make_pair(L")",                        Parser::cSymbol),
-    make_pair(L"-",                        Parser::cSymbol),
-    make_pair(L"=",                        Parser::cSymbol),
-    make_pair(L"+",                        Parser::cSymbol),
-    make_pair(L"[",                        Parser::cSymbol),
-    make_pair(L"]",                        Parser::cSymbol),
-    make_pair(L"|",                        Parser::cSymbol),
-    make_pair(L";",                        Parser::cSymbol),
-    make_pair(L":",                        Parser::cSymbol),
-    make_pair(L"<",                        Parser::cSymbol),
-    make_pair(L">",                        Parser::cSymbol),
-    make_pair(L",",                        Parser::cSymbol),
-    make_pair(L".",                        Parser::cSymbol),
-    make_pair(L"/",                        Parser::cSymbol),
-    make_pair(L"?",                        Parser::cSymbol),
-    make_pair(L"\"",                       Parser::cSymbol),
-    make_pair(L"\'",                       Parser::cSymbol),
-
-    make_pair(L"~",                        Parser::cSymbolUnsafe),
-    make_pair(L"\\,",                      Parser::cSymbolUnsafe),
-    make_pair(L"\\!",                      Parser::cSymbolUnsafe),
-    make_pair(L"\\ ",                      Parser::cSymbolUnsafe),
-    make_pair(L"\\;",                      Parser::cSymbolUnsafe),
-    make_pair(L"\\quad",                   Parser::cSymbolUnsafe),
-    make_pair(L"\\qquad",                  Parser::cSymbolUnsafe),
-
-    make_pair(L"\\hbox",                   Parser::cCommand1Arg),
-    make_pair(L"\\mbox",                   Parser::cCommand1Arg),
-    make_pair(L"\\emph",                   Parser::cCommand1Arg),
-    make_pair(L"\\text",                   Parser::cCommand1Arg),
-    make_pair(L"\\textit",                 Parser::cCommand1Arg),
-    make_pair(L"\\textbf",                 Parser::cCommand1Arg),
-    make_pair(L"\\textrm",                 Parser::cCommand1Arg),
-    make_pair(L"\\texttt",                 Parser::cCommand1Arg),
-    make_pair(L"\\textsf",                 Parser::cCommand1Arg),
-
-    make_pair(L"\\cyr",                    Parser::cCommand1Arg),
-    make_pair(L"\\jap",                    Parser::cCommand1Arg),
-
-    make_pair(L"\\rm",                     Parser::cStateChange),
-    make_pair(L"\\it",                     Parser::cStateChange),
-    make_pair(L"\\bf",                     Parser::cStateChange),
-    make_pair(L"\\tt",                     Parser::cStateChange),
-    make_pair(L"\\sf",                     Parser::cStateChange),
-
-    make_pair(L"\\color",                  Parser::cStateChange)
+    {L"",                         Parser::cEndOfInput},
+    {L" ",                        Parser::cWhitespace},
+    {L"\\newcommand",             Parser::cNewcommand},
+
+    {L"{",                        Parser::cBeginGroup},
+    {L"}",                        Parser::cEndGroup},
+
+    {L"$",                        Parser::cIllegal},
+    {L"%",                        Parser::cIllegal},
+    {L"#",                        Parser::cIllegal},
+    {L"&",                        Parser::cIllegal},
+    {L"\\\\",                     Parser::cIllegal},
+    {L"^",                        Parser::cIllegal},
+    {L"_",                        Parser::cIllegal},
+
+    {L"\\&",                      Parser::cSymbol},
+    {L"\\_",                      Parser::cSymbol},
+    {L"\\$",                      Parser::cSymbol},
+    {L"\\#",                      Parser::cSymbol},
+    {L"\\%",                      Parser::cSymbol},
+    {L"\\{",                      Parser::cSymbol},
+    {L"\\}",                      Parser::cSymbol},
+    {L"\\textbackslash",          Parser::cSymbol},
+    {L"\\textvisiblespace",       Parser::cSymbol},
+    {L"\\textasciicircum",        Parser::cSymbol},
+    {L"\\textasciitilde",         Parser::cSymbol},
+    {L"\\O",                      Parser::cSymbol},
+    {L"\\S",                      Parser::cSymbol},
+
+    {L"!",                        Parser::cSymbol},
+    {L"@",                        Parser::cSymbol},
+    {L"*",                        Parser::cSymbol},
+    {L"(",                        Parser::cSymbol},
+    {L")",                        Parser::cSymbol},
+    {L"-",                        Parser::cSymbol},
+    {L"=",                        Parser::cSymbol},
+    {L"+",                        Parser::cSymbol},
+    {L"[",                        Parser::cSymbol},
+    {L"]",                        Parser::cSymbol},
+    {L"|",                        Parser::cSymbol},
+    {L";",                        Parser::cSymbol},
+    {L":",                        Parser::cSymbol},
+    {L"<",                        Parser::cSymbol},
+    {L">",                        Parser::cSymbol},
+    {L",",                        Parser::cSymbol},
+    {L".",                        Parser::cSymbol},
+    {L"/",                        Parser::cSymbol},
+    {L"?",                        Parser::cSymbol},
+    {L"\"",                       Parser::cSymbol},
+    {L"\'",                       Parser::cSymbol},
+
+    {L"~",                        Parser::cSymbolUnsafe},
+    {L"\\,",                      Parser::cSymbolUnsafe},
+    {L"\\!",                      Parser::cSymbolUnsafe},
+    {L"\\ ",                      Parser::cSymbolUnsafe},
+    {L"\\;",                      Parser::cSymbolUnsafe},
+    {L"\\quad",                   Parser::cSymbolUnsafe},
+    {L"\\qquad",                  Parser::cSymbolUnsafe},
+
+    {L"\\hbox",                   Parser::cCommand1Arg},
+    {L"\\mbox",                   Parser::cCommand1Arg},
+    {L"\\emph",                   Parser::cCommand1Arg},
+    {L"\\text",                   Parser::cCommand1Arg},
+    {L"\\textit",                 Parser::cCommand1Arg},
+    {L"\\textbf",                 Parser::cCommand1Arg},
+    {L"\\textrm",                 Parser::cCommand1Arg},
+    {L"\\texttt",                 Parser::cCommand1Arg},
+    {L"\\textsf",                 Parser::cCommand1Arg},
+
+    {L"\\cyr",                    Parser::cCommand1Arg},
+    {L"\\jap",                    Parser::cCommand1Arg},
+
+    {L"\\rm",                     Parser::cStateChange},
+    {L"\\it",                     Parser::cStateChange},
+    {L"\\bf",                     Parser::cStateChange},
+    {L"\\tt",                     Parser::cStateChange},
+    {L"\\sf",                     Parser::cStateChange},
+
+    {L"\\color",                  Parser::cStateChange}
 };
 
-wishful_hash_map<wstring, Parser::TokenCode> gTextTokenTable(
+const vector<unsigned char> gTextTokenCodes = BuildTokenCodes(
     gTextTokenArray,
     END_ARRAY(gTextTokenArray)
 );
 
+// Looks up a token in gMathTokenCodes or gTextTokenCodes. (Tokens added to
+// the global table after the vector was built, or belonging to a
+// per-conversion table, are not in the array.)
+unsigned char LookupTokenCode(
+    const vector<unsigned char>& codes,
+    Token token
+)
+{
+    return token < codes.size() ? codes[token] : cNoTokenCode;
+}
+
 // Tests whether the supplied token is in either the math or text token
 // tables.
-bool IsInTokenTables(const wstring& token)
+bool IsInTokenTables(Token token)
 {
     return
-        (gMathTokenTable.count(token) > 0) ||
-        (gTextTokenTable.count(token) > 0);
+        LookupTokenCode(gMathTokenCodes, token) != cNoTokenCode ||
+        LookupTokenCode(gTextTokenCodes, token) != cNoTokenCode;
 }
 
-Parser::TokenCode Parser::GetMathTokenCode(const wstring& token) const
+Parser::TokenCode Parser::GetMathTokenCode(Token tokenId) const
 {
-    wishful_hash_map<wstring, TokenCode>::const_iterator
-        output = gMathTokenTable.find(token);
+    unsigned char code = LookupTokenCode(gMathTokenCodes, tokenId);
+    if (code != cNoTokenCode && code != cIllegal)
+        return static_cast<TokenCode>(code);
 
-    if (output != gMathTokenTable.end())
-    {
-        if (output->second != cIllegal)
-            return output->second;
+    // Everything below is either an error or a single character, so it
+    // works on the token's string.
+    const wstring& token = GetName(tokenId);
 
+    if (code == cIllegal)
+    {
         // Give the user some helpful hints if they try to use certain
         // illegal commands (e.g. "% is illegal, try \% instead").
         if (token == L"%" || token == L"#" || token == L"$")
-            throw Exception(
+            mTokenSource->Abort(Exception(
                 L"IllegalCommandInMathModeWithHint",
                 token, L"\\" + token
-            );
+            ));
 
         else if (token == L"`" || token == L"\"")
-            throw Exception(L"IllegalCommandInMathMode", token);
+            mTokenSource->Abort(
+                Exception(L"IllegalCommandInMathMode", token)
+            );
 
-        throw logic_error(
-            "Unexpected illegal character in Parser::GetMathTokenCode"
-        );
+        else
+            throw logic_error(
+                "Unexpected illegal character in Parser::GetMathTokenCode"
+            );
     }
 
-    if (token[0] == L'\\')
+    else if (token[0] == L'\\')
     {
-        if (gTextTokenTable.count(token))
-            throw Exception(L"IllegalCommandInMathMode", token);
+        if (LookupTokenCode(gTextTokenCodes, tokenId) != cNoTokenCode)
+            mTokenSource->Abort(
+                Exception(L"IllegalCommandInMathMode", token)
+            );
         else
-            throw Exception(L"UnrecognisedCommand", token);
+            mTokenSource->Abort(Exception(L"UnrecognisedCommand", token));
     }
 
-    if (token[0] > 0x7F)
-        throw Exception(L"NonAsciiInMathMode");
+    else if (token[0] > 0x7F)
+        mTokenSource->Abort(Exception(L"NonAsciiInMathMode"));
 
-    if (
+    else if (
         (token[0] >= L'a' && token[0] <= L'z') ||
         (token[0] >= L'A' && token[0] <= L'Z') ||
         (token[0] >= L'0' && token[0] <= L'9')
     )
         return cSymbol;
 
-    throw Exception(L"UnrecognisedCommand", token);
+    else
+        mTokenSource->Abort(Exception(L"UnrecognisedCommand", token));
+
+    // The token source has been drained (see MacroProcessor::Abort).
+    return cEndOfInput;
 }
 
-Parser::TokenCode Parser::GetTextTokenCode(const wstring& token) const
+Parser::TokenCode Parser::GetTextTokenCode(Token tokenId) const
 {
-    wishful_hash_map<wstring, TokenCode>::const_iterator
-        output = gTextTokenTable.find(token);
+    unsigned char code = LookupTokenCode(gTextTokenCodes, tokenId);
+    if (code != cNoTokenCode && code != cIllegal)
+        return static_cast<TokenCode>(code);
 
-    if (output != gTextTokenTable.end())
-    {
-        if (output->second != cIllegal)
-            return output->second;
+    const wstring& token = GetName(tokenId);
 
+    if (code == cIllegal)
+    {
         // Give the user some helpful hints if they try to use certain
         // illegal commands.
         if (token == L"&" || token == L"_" || token == L"%"
             || token == L"#" || token == L"$")
 
-            throw Exception(
+            mTokenSource->Abort(Exception(
                 L"IllegalCommandInTextModeWithHint",
                 token, L"\\" + token
-            );
+            ));
 
         else if (token == L"\\\\")
-            throw Exception(
+            mTokenSource->Abort(Exception(
                 L"IllegalCommandInTextModeWithHint",
                 L"\\\\", L"\\textbackslash"
-            );
+            ));
 
         else if (token == L"^")
-            throw Exception(
+            mTokenSource->Abort(Exception(
                 L"IllegalCommandInTextModeWithHint",
                 L"^", L"\\textasciicircum"
-            );
+            ));
 
         else
-            throw Exception(L"IllegalCommandInTextMode", token);
+            mTokenSource->Abort(
+                Exception(L"IllegalCommandInTextMode", token)
+            );
     }
 
-    if (token[0] == L'\\')
+    else if (token[0] == L'\\')
     {
-        if (gMathTokenTable.count(token))
-            throw Exception(L"IllegalCommandInTextMode", token);
+        if (LookupTokenCode(gMathTokenCodes, tokenId) != cNoTokenCode)
+            mTokenSource->Abort(
+                Exception(L"IllegalCommandInTextMode", token)
+            );
         else
-            throw Exception(L"UnrecognisedCommand", token);
+            mTokenSource->Abort(Exception(L"UnrecognisedCommand", token));
     }
 
-    if (
+    else if (
         (token[0] >= L'a' && token[0] <= L'z') ||
         (token[0] >= L'A' && token[0] <= L'Z') ||
         (token[0] >= L'0' && token[0] <= L'9') ||
@@ -936,40 +990,64 @@ Parser::TokenCode Parser::GetTextTokenCode(const wstring& token) const
     )
         return cSymbol;
 
-    throw Exception(L"UnrecognisedCommand", token);
+    else
+        mTokenSource->Abort(Exception(L"UnrecognisedCommand", token));
+
+    // The token source has been drained (see MacroProcessor::Abort).
+    return cEndOfInput;
 }
 
-auto_ptr<ParseTree::MathNode> Parser::DoParse(const vector<wstring>& input)
+auto_ptr<ParseTree::MathNode> Parser::DoParse(
+    const vector<Token>& input,
+    const TokenTable& tokenTable,
+    const MacroProcessor::MacroTable& predefinedMacros,
+    Exception& error
+)
 {
-    mTokenSource.reset(new MacroProcessor(input));
+    mTokenTable = &tokenTable;
+    mHasLimitsCommands = false;
+    mTokenSource.reset(
+        new MacroProcessor(input, tokenTable, predefinedMacros)
+    );
 
     // Parse until we hit a closing token of some kind...
     auto_ptr<ParseTree::MathNode> output = ParseMathList();
 
     // ... and check that the closing token is actually the end of input.
+    const wchar_t* code = NULL;
     switch (GetMathTokenCode(mTokenSource->Peek()))
     {
-        case cEndOfInput:     return output;
-        case cEndGroup:       throw Exception(L"UnmatchedCloseBrace");
-        case cRight:          throw Exception(L"UnmatchedRight");
-        case cNextCell:       throw Exception(L"UnexpectedNextCell");
-        case cNextRow:        throw Exception(L"UnexpectedNextRow");
-        case cEndEnvironment: throw Exception(L"UnmatchedEnd");
+        case cEndOfInput:     break;
+        case cEndGroup:       code = L"UnmatchedCloseBrace";    break;
+        case cRight:          code = L"UnmatchedRight";         break;
+        case cNextCell:       code = L"UnexpectedNextCell";     break;
+        case cNextRow:        code = L"UnexpectedNextRow";      break;
+        case cEndEnvironment: code = L"UnmatchedEnd";           break;
+
+        default:
+            throw logic_error("Unexpected token code in Parser::DoParse");
     }
+    if (code)
+        mTokenSource->Abort(Exception(code));
 
-    throw logic_error("Unexpected token code in Parser::DoParse");
+    if (mTokenSource->HasError())
+    {
+        error = mTokenSource->GetError();
+        output.reset(NULL);
+    }
+    return output;
 }
 
 auto_ptr<ParseTree::MathNode> Parser::ParseMathField()
 {
     mTokenSource->SkipWhitespace();
-    wstring command = mTokenSource->Get();
+    Token command = mTokenSource->Get();
 
     switch (GetMathTokenCode(command))
     {
         case cSymbol:
             return auto_ptr<ParseTree::MathNode>(
-                new ParseTree::MathSymbol(command)
+                new ParseTree::MathSymbol(command, GetName(command))
             );
 
         case cBeginGroup:
@@ -978,17 +1056,24 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathField()
             auto_ptr<ParseTree::MathNode> field = ParseMathList();
 
             // Gobble closing brace
-            if (mTokenSource->Get() != L"}")
-                throw Exception(L"UnmatchedOpenBrace");
+            if (mTokenSource->Get() != cTokenEndGroup)
+                mTokenSource->Abort(Exception(L"UnmatchedOpenBrace"));
 
             return field;
         }
 
         case cEndOfInput:
-            throw Exception(L"MissingOpenBraceAtEnd");
+            mTokenSource->Abort(Exception(L"MissingOpenBraceAtEnd"));
+            break;
+
+        default:
+            mTokenSource->Abort(
+                Exception(L"MissingOpenBraceBefore", GetName(command))
+            );
     }
 
-    throw Exception(L"MissingOpenBraceBefore", command);
+    // After an error, the caller still gets a (harmless) node.
+    return auto_ptr<ParseTree::MathNode>(new ParseTree::MathList);
 }
 
 auto_ptr<ParseTree::MathTable> Parser::ParseMathTable()
@@ -1087,22 +1172,31 @@ ParseTree::MathScripts* Parser::PrepareScripts(ParseTree::MathList* output)
 wstring Parser::ParseColourName()
 {
     mTokenSource->SkipWhitespace();
-    if (mTokenSource->Get() != L"{")
-        throw Exception(L"MissingOpenBraceAfter", L"\\color");
+    if (mTokenSource->Get() != cTokenBeginGroup)
+    {
+        mTokenSource->Abort(
+            Exception(L"MissingOpenBraceAfter", L"\\color")
+        );
+        return wstring();
+    }
     
     wstring colourName;
     while (true)
     {
-        wstring c = mTokenSource->Get();
-        if (c == L"}")
+        Token token = mTokenSource->Get();
+        if (token == cTokenEndGroup)
         {
             // check colour name is valid
-            if (gColourTable.find(colourName) == gColourTable.end())
-                throw Exception(L"InvalidColour", colourName);
+            if (!IsColourName(colourName))
+                mTokenSource->Abort(Exception(L"InvalidColour", colourName));
             return colourName;
         }
-        if (c == L"")
-            throw Exception(L"UnmatchedOpenBrace");
+        if (token == cTokenEndOfInput)
+        {
+            mTokenSource->Abort(Exception(L"UnmatchedOpenBrace"));
+            return colourName;
+        }
+        const wstring& c = GetName(token);
         colourName += c;
         if (c.size() != 1 ||
             !(
@@ -1110,10 +1204,13 @@ wstring Parser::ParseColourName()
                 (c[0] >= 'a' && c[0] <= 'z')
              )
         )
-            throw Exception(
+        {
+            mTokenSource->Abort(Exception(
                 L"InvalidColour",
                 colourName + L"..."
-            );
+            ));
+            return colourName;
+        }
     }
 }
 
@@ -1126,8 +1223,9 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
     // (like "\over"), while we are waiting for the denominator to be
     // fully built up...
     auto_ptr<ParseTree::MathList> infixNumerator;
-    // and the infix command itself is stored here:
-    wstring infixCommand;
+    // and the infix command itself is stored here (cTokenEndOfInput means
+    // there isn't one):
+    Token infixCommand = cTokenEndOfInput;
 
     while (true)
     {
@@ -1143,10 +1241,11 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
                 // It's a little strange that the following static_casts
                 // should be needed, but gcc 3.3 seems to require them.
                 // Don't know about later versions.
-                if (!infixCommand.empty())
+                if (infixCommand != cTokenEndOfInput)
                     return auto_ptr<ParseTree::MathNode>(
                         new ParseTree::MathCommand2Args(
                             infixCommand,
+                            GetName(infixCommand),
                             static_cast<auto_ptr<ParseTree::MathNode> >
                                 (infixNumerator),
                             static_cast<auto_ptr<ParseTree::MathNode> >
@@ -1194,8 +1293,9 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
             case cSymbol:
             case cSymbolUnsafe:
             {
+                Token command = mTokenSource->Get();
                 output->mChildren.push_back(
-                    new ParseTree::MathSymbol(mTokenSource->Get())
+                    new ParseTree::MathSymbol(command, GetName(command))
                 );
                 break;
             }
@@ -1210,40 +1310,52 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
                 );
 
                 // Gobble closing brace.
-                if (mTokenSource->Get() != L"}")
-                    throw Exception(L"UnmatchedOpenBrace");
+                if (mTokenSource->Get() != cTokenEndGroup)
+                    mTokenSource->Abort(Exception(L"UnmatchedOpenBrace"));
                 break;
             }
 
             case cBeginEnvironment:
             {
                 // extract e.g. "matrix" from "\begin{matrix}"
-                wstring beginCommand = mTokenSource->Get();
+                const wstring& beginCommand
+                    = GetName(mTokenSource->Get());
                 wstring name
                     = beginCommand.substr(7, beginCommand.size() - 8);
 
                 auto_ptr<ParseTree::MathTable> table = ParseMathTable();
 
-                wstring endCommand = mTokenSource->Get();
-                if (GetMathTokenCode(endCommand) != cEndEnvironment)
-                    throw Exception(L"UnmatchedBegin", beginCommand);
+                Token endToken = mTokenSource->Get();
+                if (GetMathTokenCode(endToken) != cEndEnvironment)
+                {
+                    mTokenSource->Abort(
+                        Exception(L"UnmatchedBegin", beginCommand)
+                    );
+                    break;
+                }
 
+                const wstring& endCommand = GetName(endToken);
                 if (name != endCommand.substr(5, endCommand.size() - 6))
-                    throw Exception(
+                {
+                    mTokenSource->Abort(Exception(
                         L"MismatchedBeginAndEnd", beginCommand, endCommand
-                    );
+                    ));
+                    break;
+                }
 
                 if (name == L"cases")
                 {
                     // check none of the rows have more than two entries
-                    for (vector<ParseTree::MathTableRow*>::iterator
+                    for (ParseTree::MathTableRowVector::iterator
                         row = table->mRows.begin();
                         row != table->mRows.end();
                         row++
                     )
                     {
                         if ((*row)->mEntries.size() > 2)
-                            throw Exception(L"CasesRowTooBig");
+                            mTokenSource->Abort(
+                                Exception(L"CasesRowTooBig")
+                            );
                     }
                 }
 
@@ -1255,35 +1367,42 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
 
             case cShortEnvironment:
             {
-                wstring command = mTokenSource->Get();
+                const wstring& command = GetName(mTokenSource->Get());
 
                 // Strip initial backslash (e.g. "\substack" => "substack")
                 wstring name = command.substr(1, command.size() - 1);
 
                 // Gobble opening "{"
                 mTokenSource->SkipWhitespace();
-                if (mTokenSource->Get() != L"{")
-                    throw Exception(L"MissingOpenBraceAfter", command);
+                if (mTokenSource->Get() != cTokenBeginGroup)
+                {
+                    mTokenSource->Abort(
+                        Exception(L"MissingOpenBraceAfter", command)
+                    );
+                    break;
+                }
 
                 auto_ptr<ParseTree::MathTable> table = ParseMathTable();
 
                 if (name == L"substack")
                 {
                     // check none of the rows have more than one entry
-                    for (vector<ParseTree::MathTableRow*>::iterator
+                    for (ParseTree::MathTableRowVector::iterator
                         row = table->mRows.begin();
                         row != table->mRows.end();
                         row++
                     )
                     {
                         if ((*row)->mEntries.size() > 1)
-                            throw Exception(L"SubstackRowTooBig");
+                            mTokenSource->Abort(
+                                Exception(L"SubstackRowTooBig")
+                            );
                     }
                 }
 
                 // Gobble closing "}"
-                if (mTokenSource->Get() != L"}")
-                    throw Exception(L"UnmatchedOpenBrace");
+                if (mTokenSource->Get() != cTokenEndGroup)
+                    mTokenSource->Abort(Exception(L"UnmatchedOpenBrace"));
 
                 output->mChildren.push_back(
                     new ParseTree::MathEnvironment(name, table, true)
@@ -1293,16 +1412,24 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
 
             case cEnterTextMode:
             {
-                wstring command = mTokenSource->Get();
+                Token commandToken = mTokenSource->Get();
+                const wstring& command = GetName(commandToken);
 
                 mTokenSource->SkipWhitespace();
-                if (mTokenSource->Peek() != L"{")
-                    throw Exception(L"MissingOpenBraceAfter", command);
+                if (mTokenSource->Peek() != cTokenBeginGroup)
+                {
+                    mTokenSource->Abort(
+                        Exception(L"MissingOpenBraceAfter", command)
+                    );
+                    break;
+                }
 
                 output->mChildren.push_back(
                     // Here is the only place in this function that we
                     // switch to text mode parsing:
-                    new ParseTree::EnterTextMode(command, ParseTextField())
+                    new ParseTree::EnterTextMode(
+                        commandToken, command, ParseTextField()
+                    )
                 );
                 break;
             }
@@ -1311,43 +1438,84 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
             {
                 mTokenSource->Advance();
                 mTokenSource->SkipWhitespace();
-                wstring left = mTokenSource->Get();
+                Token leftToken = mTokenSource->Get();
+                const wstring& left = GetName(leftToken);
                 if (left.empty())
-                    throw Exception(L"MissingDelimiter", L"\\left");
-                else if (!gDelimiterTable.count(left))
-                    throw Exception(L"IllegalDelimiter", L"\\left");
+                {
+                    mTokenSource->Abort(
+                        Exception(L"MissingDelimiter", L"\\left")
+                    );
+                    break;
+                }
+                else if (!IsDelimiter(left))
+                {
+                    mTokenSource->Abort(
+                        Exception(L"IllegalDelimiter", L"\\left")
+                    );
+                    break;
+                }
 
                 auto_ptr<ParseTree::MathNode> child = ParseMathList();
 
-                if (mTokenSource->Peek() != L"\\right")
-                    throw Exception(L"UnmatchedLeft");
+                if (mTokenSource->Peek() != cTokenRight)
+                {
+                    mTokenSource->Abort(Exception(L"UnmatchedLeft"));
+                    break;
+                }
 
                 mTokenSource->Advance();
                 mTokenSource->SkipWhitespace();
-                wstring right = mTokenSource->Get();
+                Token rightToken = mTokenSource->Get();
+                const wstring& right = GetName(rightToken);
                 if (right.empty())
-                    throw Exception(L"MissingDelimiter", L"\\right");
-                else if (!gDelimiterTable.count(right))
-                    throw Exception(L"IllegalDelimiter", L"\\right");
+                {
+                    mTokenSource->Abort(
+                        Exception(L"MissingDelimiter", L"\\right")
+                    );
+                    break;
+                }
+                else if (!IsDelimiter(right))
+                {
+                    mTokenSource->Abort(
+                        Exception(L"IllegalDelimiter", L"\\right")
+                    );
+                    break;
+                }
 
                 output->mChildren.push_back(
-                    new ParseTree::MathDelimited(child, left, right)
+                    new ParseTree::MathDelimited(
+                        child, leftToken, left, rightToken, right
+                    )
                 );
                 break;
             }
 
             case cBig:
             {
-                wstring command = mTokenSource->Get();
+                Token commandToken = mTokenSource->Get();
+                const wstring& command = GetName(commandToken);
                 mTokenSource->SkipWhitespace();
-                wstring delimiter = mTokenSource->Get();
+                Token delimiterToken = mTokenSource->Get();
+                const wstring& delimiter = GetName(delimiterToken);
                 if (delimiter.empty())
-                    throw Exception(L"MissingDelimiter", command);
-                else if (!gDelimiterTable.count(delimiter))
-                    throw Exception(L"IllegalDelimiter", command);
+                {
+                    mTokenSource->Abort(
+                        Exception(L"MissingDelimiter", command)
+                    );
+                    break;
+                }
+                else if (!IsDelimiter(delimiter))
+                {
+                    mTokenSource->Abort(
+                        Exception(L"IllegalDelimiter", command)
+                    );
+                    break;
+                }
 
                 output->mChildren.push_back(
-                    new ParseTree::MathBig(command, delimiter)
+                    new ParseTree::MathBig(
+                        commandToken, command, delimiterToken, delimiter
+                    )
                 );
                 break;
             }
@@ -1358,7 +1526,10 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
                 ParseTree::MathScripts* target
                     = PrepareScripts(output.get());
                 if (target->mUpper.get())
-                    throw Exception(L"DoubleSuperscript");
+                {
+                    mTokenSource->Abort(Exception(L"DoubleSuperscript"));
+                    break;
+                }
                 target->mUpper = ParseMathField();
                 break;
             }
@@ -1369,7 +1540,10 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
                 ParseTree::MathScripts* target
                     = PrepareScripts(output.get());
                 if (target->mLower.get())
-                    throw Exception(L"DoubleSubscript");
+                {
+                    mTokenSource->Abort(Exception(L"DoubleSubscript"));
+                    break;
+                }
                 target->mLower = ParseMathField();
                 break;
             }
@@ -1387,10 +1561,12 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
                     new ParseTree::MathList
                 );
 
-                while (mTokenSource->Peek() == L"'")
+                while (mTokenSource->Peek() == cTokenPrime)
                 {
                     superscript->mChildren.push_back(
-                        new ParseTree::MathSymbol(L"\\prime")
+                        new ParseTree::MathSymbol(
+                            cTokenPrimeSymbol, L"\\prime"
+                        )
                     );
                     mTokenSource->Advance();
                 }
@@ -1398,9 +1574,12 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
                 ParseTree::MathScripts* target
                     = PrepareScripts(output.get());
                 if (target->mUpper.get())
-                    throw Exception(L"DoubleSuperscript");
+                {
+                    mTokenSource->Abort(Exception(L"DoubleSuperscript"));
+                    break;
+                }
 
-                if (mTokenSource->Peek() == L"^")
+                if (mTokenSource->Peek() == cTokenSuperscript)
                 {
                     mTokenSource->Advance();
                     superscript->mChildren.push_back(
@@ -1419,9 +1598,15 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
 
             case cLimits:
             {
-                wstring command = mTokenSource->Get();
+                const wstring& command = GetName(mTokenSource->Get());
                 if (output->mChildren.empty())
-                    throw Exception(L"MisplacedLimits", command);
+                {
+                    mTokenSource->Abort(
+                        Exception(L"MisplacedLimits", command)
+                    );
+                    break;
+                }
+                mHasLimitsCommands = true;
 
                 // We need to arrange things so that the child of the
                 // new MathLimits node is the base of a (possibly new)
@@ -1449,24 +1634,26 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
 
             case cStateChange:
             {
-                wstring command = mTokenSource->Get();
-                if (command == L"\\color")
+                Token command = mTokenSource->Get();
+                if (command == cTokenColor)
                     output->mChildren.push_back(
                         new ParseTree::MathColour(ParseColourName())
                     );
                 else
                     output->mChildren.push_back(
-                        new ParseTree::MathStateChange(command)
+                        new ParseTree::MathStateChange(
+                            command, GetName(command)
+                        )
                     );
                 break;
             }
 
             case cCommand1Arg:
             {
-                wstring command = mTokenSource->Get();
+                Token command = mTokenSource->Get();
                 output->mChildren.push_back(
                     new ParseTree::MathCommand1Arg(
-                        command, ParseMathField()
+                        command, GetName(command), ParseMathField()
                     )
                 );
                 break;
@@ -1474,12 +1661,12 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
 
             case cCommand2Args:
             {
-                wstring command = mTokenSource->Get();
+                Token command = mTokenSource->Get();
                 auto_ptr<ParseTree::MathNode> child1 = ParseMathField();
                 auto_ptr<ParseTree::MathNode> child2 = ParseMathField();
                 output->mChildren.push_back(
                     new ParseTree::MathCommand2Args(
-                        command, child1, child2, false
+                        command, GetName(command), child1, child2, false
                     )
                 );
                 break;
@@ -1487,10 +1674,13 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
 
             case cCommandInfix:
             {
-                if (!infixCommand.empty())
-                    throw Exception(
-                        L"AmbiguousInfix", mTokenSource->Peek()
-                    );
+                if (infixCommand != cTokenEndOfInput)
+                {
+                    mTokenSource->Abort(Exception(
+                        L"AmbiguousInfix", GetName(mTokenSource->Peek())
+                    ));
+                    break;
+                }
 
                 // When we see an infix command (e.g. "\over"), we do the
                 // same thing TeX does: clear out the entire math list
@@ -1517,13 +1707,13 @@ auto_ptr<ParseTree::MathNode> Parser::ParseMathList()
 auto_ptr<ParseTree::TextNode> Parser::ParseTextField()
 {
     mTokenSource->SkipWhitespace();
-    wstring command = mTokenSource->Get();
+    Token command = mTokenSource->Get();
 
     switch (GetTextTokenCode(command))
     {
         case cSymbol:
             return auto_ptr<ParseTree::TextNode>(
-                new ParseTree::TextSymbol(command)
+                new ParseTree::TextSymbol(command, GetName(command))
             );
 
         case cBeginGroup:
@@ -1531,17 +1721,24 @@ auto_ptr<ParseTree::TextNode> Parser::ParseTextField()
             auto_ptr<ParseTree::TextNode> field(
                 new ParseTree::TextGroup(ParseTextList())
             );
-            if (mTokenSource->Peek() != L"}")
-                throw Exception(L"UnmatchedOpenBrace");
+            if (mTokenSource->Peek() != cTokenEndGroup)
+                mTokenSource->Abort(Exception(L"UnmatchedOpenBrace"));
             mTokenSource->Advance();
             return field;
         }
 
         case cEndOfInput:
-            throw Exception(L"MissingOpenBraceAtEnd");
+            mTokenSource->Abort(Exception(L"MissingOpenBraceAtEnd"));
+            break;
+
+        default:
+            mTokenSource->Abort(
+                Exception(L"MissingOpenBraceBefore", GetName(command))
+            );
     }
 
-    throw Exception(L"MissingOpenBraceBefore", command);
+    // After an error, the caller still gets a (harmless) node.
+    return auto_ptr<ParseTree::TextNode>(new ParseTree::TextList);
 }
 
 auto_ptr<ParseTree::TextNode> Parser::ParseTextList()
@@ -1581,8 +1778,8 @@ auto_ptr<ParseTree::TextNode> Parser::ParseTextList()
                 output->mChildren.push_back(
                     new ParseTree::TextGroup(ParseTextList())
                 );
-                if (mTokenSource->Peek() != L"}")
-                    throw Exception(L"UnmatchedOpenBrace");
+                if (mTokenSource->Peek() != cTokenEndGroup)
+                    mTokenSource->Abort(Exception(L"UnmatchedOpenBrace"));
                 mTokenSource->Advance();
                 break;
             }
@@ -1591,18 +1788,19 @@ auto_ptr<ParseTree::TextNode> Parser::ParseTextList()
             case cSymbol:
             case cSymbolUnsafe:
             {
+                Token command = mTokenSource->Get();
                 output->mChildren.push_back(
-                    new ParseTree::TextSymbol(mTokenSource->Get())
+                    new ParseTree::TextSymbol(command, GetName(command))
                 );
                 break;
             }
 
             case cCommand1Arg:
             {
-                wstring command = mTokenSource->Get();
+                Token command = mTokenSource->Get();
                 output->mChildren.push_back(
                     new ParseTree::TextCommand1Arg(
-                        command, ParseTextField()
+                        command, GetName(command), ParseTextField()
                     )
                 );
                 break;
@@ -1610,14 +1808,16 @@ auto_ptr<ParseTree::TextNode> Parser::ParseTextList()
 
             case cStateChange:
             {
-                wstring command = mTokenSource->Get();
-                if (command == L"\\color")
+                Token command = mTokenSource->Get();
+                if (command == cTokenColor)
                     output->mChildren.push_back(
                         new ParseTree::TextColour(ParseColourName())
                     );
                 else
                     output->mChildren.push_back(
-                        new ParseTree::TextStateChange(command)
+                        new ParseTree::TextStateChange(
+                            command, GetName(command)
+                        )
                     );
                 break;
             }
@@ -35,11 +35,30 @@ class Parser
 
 public:
     // Main function that the caller should use to do a parsing job.
-    // Input is a TeX string, output is the root of a parse tree.
+    // Input is a sequence of tokens from "tokenTable", output is the root
+    // of a parse tree. The input starts off with "predefinedMacros"
+    // already defined (see MacroProcessor::CompileMacros).
+    //
+    // If the input is invalid, it returns NULL instead, and stores the
+    // first error found in "error". Nothing is thrown: each error is
+    // passed to MacroProcessor::Abort, which ends the token stream there,
+    // and the parser finishes off quietly (building bits of tree which
+    // then get thrown away).
     std::auto_ptr<ParseTree::MathNode> DoParse(
-        const std::vector<std::wstring>& input
+        const std::vector<Token>& input,
+        const TokenTable& tokenTable,
+        const MacroProcessor::MacroTable& predefinedMacros,
+        Exception& error
     );
 
+    // True if the input given to the last DoParse contained "\limits",
+    // "\nolimits" or "\displaylimits". (Misplaced ones can only be
+    // detected while building the layout tree; see Manager::ProcessInput.)
+    bool HasLimitsCommands() const
+    {
+        return mHasLimitsCommands;
+    }
+
     // The parser uses GetMathTokenCode (in math mode) or GetTextTokenCode
     // (in text mode) to translate each incoming token into one of the
     // following values:
@@ -94,6 +113,13 @@ private:
     // the parser doesn't have to be aware of macros at all.
     std::auto_ptr<MacroProcessor> mTokenSource;
 
+    // The table that the tokens come from; used to turn them back into
+    // strings when building the parse tree.
+    const TokenTable* mTokenTable;
+
+    // See HasLimitsCommands().
+    bool mHasLimitsCommands;
+
     // ParseMathList starts parsing a math list, until it reaches a command
     // indicating the end of the list, like "}" or "\right" or "\end{...}".
     std::auto_ptr<ParseTree::MathNode> ParseMathList();
@@ -125,10 +151,17 @@ private:
 
     // These functions determine the appropriate token code for the supplied
     // token. Things like "1", "a", "+" are handled appropriately, as are
-    // backslash-prefixed commands listed in gMathTokenTable or
-    // gTextTokenTable.
-    TokenCode GetMathTokenCode(const std::wstring& token) const;
-    TokenCode GetTextTokenCode(const std::wstring& token) const;
+    // backslash-prefixed commands listed in gMathTokenArray or
+    // gTextTokenArray. If the token is illegal, they abort the token
+    // source, and return cEndOfInput.
+    TokenCode GetMathTokenCode(Token token) const;
+    TokenCode GetTextTokenCode(Token token) const;
+
+    // Shorthand for mTokenTable->GetName().
+    const std::wstring& GetName(Token token) const
+    {
+        return mTokenTable->GetName(token);
+    }
     
     // Parses stuff that occurs after "\color", e.g. "  {red}", and checks
     // that the colour is legal. Returns the colour name, e.g. "red".
@@ -0,0 +1,234 @@
+// File "TokenTable.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include <cwchar>
+#include <stdexcept>
+#include "TokenTable.h"
+#include "Misc.h"
+
+using namespace std;
+
+namespace blahtex
+{
+
+// Marks an unused entry in TokenTable::mSlots and mAsciiTokens.
+const Token cEmptySlot = ~0u;
+
+// Names of the well-known tokens, in the same order as the enum in
+// TokenTable.h.
+const wchar_t* gWellKnownTokenArray[] =
+{
+    L"",
+    L" ",
+    L"{",
+    L"}",
+    L"[",
+    L"]",
+    L"#",
+    L"'",
+    L"^",
+    L"\\begin",
+    L"\\end",
+    L"\\newcommand",
+    L"\\sqrt",
+    L"\\sqrtReserved",
+    L"\\rootReserved",
+    L"\\right",
+    L"\\color",
+    L"\\strictspacing",
+    L"\\prime"
+};
+
+// Returned by GetCommandInfo for tokens it knows nothing about.
+const CommandInfo cNoCommandInfo = {0, cSymbolTableNone, 0};
+
+// FNV-1a hash over the characters of a token.
+size_t HashToken(const wchar_t* name, size_t length)
+{
+    size_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= static_cast<unsigned>(name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+TokenTable::TokenTable(const TokenTable* parent) :
+    mParent(parent),
+    mFirst(parent ? parent->Size() : 0)
+{
+    fill(mAsciiTokens, END_ARRAY(mAsciiTokens), cEmptySlot);
+}
+
+size_t TokenTable::FindSlot(const wchar_t* name, size_t length) const
+{
+    size_t mask = mSlots.size() - 1;
+    size_t slot = HashToken(name, length) & mask;
+
+    while (true)
+    {
+        Token token = mSlots[slot];
+        if (token == cEmptySlot)
+            return slot;
+
+        const wstring& candidate = mNames[token - mFirst];
+        if (candidate.size() == length &&
+            wmemcmp(candidate.data(), name, length) == 0
+        )
+            return slot;
+
+        slot = (slot + 1) & mask;
+    }
+}
+
+void TokenTable::Rehash(size_t size)
+{
+    vector<Token> old;
+    old.swap(mSlots);
+    mSlots.resize(size, cEmptySlot);
+
+    for (vector<Token>::const_iterator
+        ptr = old.begin();
+        ptr != old.end();
+        ptr++
+    )
+    {
+        if (*ptr != cEmptySlot)
+        {
+            const wstring& name = mNames[*ptr - mFirst];
+            mSlots[FindSlot(name.data(), name.size())] = *ptr;
+        }
+    }
+}
+
+void TokenTable::Reserve(size_t count)
+{
+    mNames.reserve(count);
+    mReservedSuffix.reserve(count);
+    mCommandInfo.reserve(count);
+
+    // Keep the load factor at most 1/2 (see Intern).
+    size_t size = mSlots.empty() ? 16 : mSlots.size();
+    while (size < 2 * count)
+        size *= 2;
+    if (size != mSlots.size())
+        Rehash(size);
+}
+
+bool TokenTable::Find(
+    const wchar_t* name,
+    size_t length,
+    Token& token
+) const
+{
+    if (mParent && mParent->Find(name, length, token))
+        return true;
+
+    if (length == 1 && static_cast<unsigned>(name[0]) < 0x80)
+        token = mAsciiTokens[name[0]];
+    else if (mSlots.empty())
+        return false;
+    else
+        token = mSlots[FindSlot(name, length)];
+
+    return token != cEmptySlot;
+}
+
+const CommandInfo& TokenTable::GetCommandInfo(Token token) const
+{
+    if (token < mFirst)
+        return mParent->GetCommandInfo(token);
+
+    token -= mFirst;
+    return token < mCommandInfo.size()
+        ? mCommandInfo[token] : cNoCommandInfo;
+}
+
+Token TokenTable::Intern(const wchar_t* name, size_t length)
+{
+    Token token;
+    if (Find(name, length, token))
+        return token;
+
+    token = Size();
+    if (token == cEmptySlot)
+        throw logic_error("Too many tokens in TokenTable::Intern");
+
+    mNames.push_back(wstring(name, length));
+    mReservedSuffix.push_back(
+        length >= 8 && wmemcmp(name + length - 8, L"Reserved", 8) == 0
+    );
+    mCommandInfo.push_back(cNoCommandInfo);
+
+    if (length == 1 && static_cast<unsigned>(name[0]) < 0x80)
+        mAsciiTokens[name[0]] = token;
+    else
+    {
+        // Keep the load factor at most 1/2.
+        if (2 * mNames.size() > mSlots.size())
+            Rehash(mSlots.empty() ? 16 : 2 * mSlots.size());
+        mSlots[FindSlot(name, length)] = token;
+    }
+
+    return token;
+}
+
+// Builds the global table: first the well-known tokens, then every
+// printable ASCII character, so that single-character tokens never need
+// to be added to a per-conversion table.
+TokenTable* CreateGlobalTokenTable()
+{
+    TokenTable* table = new TokenTable;
+
+    // The tables built during static initialisation bring the total to
+    // around 800; reserving space up front saves rehashing, and copying
+    // the names every time mNames is reallocated.
+    table->Reserve(1024);
+
+    for (size_t index = 0; index < cWellKnownTokenCount; index++)
+    {
+        const wchar_t* name = gWellKnownTokenArray[index];
+        if (table->Intern(name, wcslen(name)) != index)
+            throw logic_error(
+                "Well-known token out of order in CreateGlobalTokenTable"
+            );
+    }
+
+    for (wchar_t c = L'!'; c < 0x7F; c++)
+        table->Intern(&c, 1);
+
+    return table;
+}
+
+TokenTable& GetGlobalTokenTable()
+{
+    // The table is created on first use (rather than as a plain global)
+    // because the other tables which intern tokens during static
+    // initialisation live in other translation units. It is deliberately
+    // never destroyed, so it stays valid however static destruction is
+    // ordered.
+    static TokenTable* table = CreateGlobalTokenTable();
+    return *table;
+}
+
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
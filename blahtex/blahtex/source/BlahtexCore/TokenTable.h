@@ -0,0 +1,205 @@
+// File "TokenTable.h"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef BLAHTEX_TOKENTABLE_H
+#define BLAHTEX_TOKENTABLE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace blahtex
+{
+
+// Tokens are passed between the tokeniser, the MacroProcessor and the
+// Parser as small integers rather than strings. Each distinct token string
+// (like "a", "{" or "\frac") is interned once in a TokenTable, which maps
+// it to its Token and back again.
+typedef unsigned Token;
+
+// These are the tokens which the tokeniser, MacroProcessor and Parser need
+// to recognise individually. They are interned first, in this order, when
+// the global table is created, so their IDs are known at compile time.
+enum
+{
+    cTokenEndOfInput,       // ""
+    cTokenWhitespace,       // " "
+    cTokenBeginGroup,       // "{"
+    cTokenEndGroup,         // "}"
+    cTokenOpenBracket,      // "["
+    cTokenCloseBracket,     // "]"
+    cTokenHash,             // "#"
+    cTokenPrime,            // "'"
+    cTokenSuperscript,      // "^"
+    cTokenBegin,            // "\begin"
+    cTokenEnd,              // "\end"
+    cTokenNewcommand,       // "\newcommand"
+    cTokenSqrt,             // "\sqrt"
+    cTokenSqrtReserved,     // "\sqrtReserved"
+    cTokenRootReserved,     // "\rootReserved"
+    cTokenRight,            // "\right"
+    cTokenColor,            // "\color"
+    cTokenStrictspacing,    // "\strictspacing"
+    cTokenPrimeSymbol,      // "\prime"
+
+    cWellKnownTokenCount
+};
+
+// Flags for CommandInfo::mFeatures; each says that the command needs some
+// LaTeX package (see LatexFeatures::Update).
+enum
+{
+    cFeatureAmsmath  = 0x01,
+    cFeatureAmsfonts = 0x02,
+    cFeatureAmssymb  = 0x04,
+    cFeatureCyrillic = 0x08,    // "\cyr": X2 font encoding and ucs
+    cFeatureJapanese = 0x10     // "\jap": CJK and a japanese font
+};
+
+// Values for CommandInfo::mSymbolTable, naming the tables in
+// ParseTree2.cpp that MathSymbol::BuildLayoutTree consults.
+enum
+{
+    cSymbolTableNone,
+    cSymbolTableLowercaseGreek,
+    cSymbolTableUppercaseGreek,
+    cSymbolTableSpace,
+    cSymbolTableOperator,
+    cSymbolTableIdentifier
+};
+
+// CommandInfo holds what the parse tree needs to know about a command,
+// so that it can look it up by Token instead of by name. It is filled in
+// for the global table during static initialisation (by ParseTree2.cpp
+// and ParseTree3.cpp); for anything else it is all zero.
+struct CommandInfo
+{
+    // Bitwise OR of cFeature... flags.
+    unsigned char mFeatures;
+
+    // Which symbol table lists the command (one of cSymbolTable...), and
+    // at which index.
+    unsigned char mSymbolTable;
+    unsigned short mSymbolIndex;
+};
+
+// A TokenTable assigns consecutive Tokens to the strings interned in it.
+//
+// A table may be layered on top of a parent table: lookups check the
+// parent first, and new strings get Tokens following the parent's last
+// one. Manager::ProcessInput uses this to keep the (immutable) global
+// table free of whatever unknown commands turn up in user input, by
+// tokenising into a short-lived table layered on the global one.
+class TokenTable
+{
+public:
+    // The parent, if any, must outlive this table, and must not have any
+    // more strings interned in it once this table exists.
+    explicit TokenTable(const TokenTable* parent = NULL);
+
+    // Returns the Token for the given string, adding it if necessary.
+    Token Intern(const wchar_t* name, size_t length);
+
+    Token Intern(const std::wstring& name)
+    {
+        return Intern(name.data(), name.size());
+    }
+
+    // Makes room for "count" strings in total, so that interning that many
+    // doesn't have to keep growing the table.
+    void Reserve(size_t count);
+
+    // Looks up a string without adding it. Returns false if it isn't in
+    // this table or any parent.
+    bool Find(const wchar_t* name, size_t length, Token& token) const;
+
+    // Returns the string for the given Token. (The reference is only valid
+    // until the next call to Intern.)
+    const std::wstring& GetName(Token token) const
+    {
+        return token < mFirst
+            ? mParent->GetName(token)
+            : mNames[token - mFirst];
+    }
+
+    // Tests whether the given Token's string ends with "Reserved" (see
+    // Manager::ProcessInput).
+    bool HasReservedSuffix(Token token) const
+    {
+        return token < mFirst
+            ? mParent->HasReservedSuffix(token)
+            : mReservedSuffix[token - mFirst];
+    }
+
+    // Returns the CommandInfo for the given Token. Tokens beyond the end
+    // of this table (i.e. from a table layered on it) get an empty one.
+    const CommandInfo& GetCommandInfo(Token token) const;
+
+    // Gives write access to the CommandInfo of a Token from this table
+    // (not from its parent). Only used during static initialisation.
+    CommandInfo& EditCommandInfo(Token token)
+    {
+        return mCommandInfo[token - mFirst];
+    }
+
+    // Returns one more than the largest Token in the table.
+    Token Size() const
+    {
+        return mFirst + static_cast<Token>(mNames.size());
+    }
+
+private:
+    const TokenTable* mParent;
+
+    // Token of mNames[0]; that is, the parent's Size().
+    Token mFirst;
+
+    std::vector<std::wstring> mNames;
+    std::vector<bool> mReservedSuffix;
+    std::vector<CommandInfo> mCommandInfo;
+
+    // Open addressing hash table (linear probing) over mNames. Each slot
+    // holds a Token, or cEmptySlot. The size is always a power of two.
+    std::vector<Token> mSlots;
+
+    // Single ASCII characters (by far the most common kind of token) skip
+    // the hash table and are looked up here instead.
+    Token mAsciiTokens[0x80];
+
+    // Finds the slot in mSlots where "name" is, or else the empty slot
+    // where it would go.
+    size_t FindSlot(const wchar_t* name, size_t length) const;
+
+    // Resizes mSlots to "size" (a power of two) and reinserts everything.
+    void Rehash(size_t size);
+};
+
+// Returns the global table. It contains the well-known tokens above, plus
+// everything interned by the tokeniser and the token tables during static
+// initialisation (standard macros, command names). It must not be
+// modified after static initialisation, so that any number of threads can
+// share it.
+extern TokenTable& GetGlobalTokenTable();
+
+}
+
+#endif
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
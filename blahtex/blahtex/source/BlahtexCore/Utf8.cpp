@@ -0,0 +1,273 @@
+// File "Utf8.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "Utf8.h"
+
+// Like the rest of the core (see Utf8.h), the code below
+// assumes that wchar_t is 32 bits wide, so that every character fits in
+// one of them.
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace blahtex
+{
+
+// WidenAscii() copies the longest run of ASCII bytes starting at "source"
+// (but not past "end") into "dest", one wchar_t each. Returns the number
+// of bytes copied.
+size_t WidenAscii(
+    const unsigned char* source,
+    const unsigned char* end,
+    wchar_t* dest
+)
+{
+    const unsigned char* start = source;
+
+#ifdef __AVX2__
+    while (end - source >= 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(source)
+        );
+        if (_mm256_movemask_epi8(chunk))
+            break;
+
+        for (int i = 0; i < 4; i++)
+            _mm256_storeu_si256(
+                reinterpret_cast<__m256i*>(dest + 8 * i),
+                _mm256_cvtepu8_epi32(
+                    _mm_loadl_epi64(
+                        reinterpret_cast<const __m128i*>(source + 8 * i)
+                    )
+                )
+            );
+        source += 32;
+        dest += 32;
+    }
+#endif
+
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    while (end - source >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(source)
+        );
+        if (_mm_movemask_epi8(chunk))
+            break;
+
+        __m128i low  = _mm_unpacklo_epi8(chunk, zero);
+        __m128i high = _mm_unpackhi_epi8(chunk, zero);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest),
+            _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 4),
+            _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 8),
+            _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 12),
+            _mm_unpackhi_epi16(high, zero));
+        source += 16;
+        dest += 16;
+    }
+#endif
+
+    while (source < end && *source < 0x80)
+        *dest++ = *source++;
+
+    return source - start;
+}
+
+// NarrowAscii() is the reverse of WidenAscii().
+size_t NarrowAscii(
+    const wchar_t* source,
+    const wchar_t* end,
+    unsigned char* dest
+)
+{
+    const wchar_t* start = source;
+
+#ifdef __SSE2__
+    const __m128i highBits = _mm_set1_epi32(~0x7F);
+    const __m128i zero = _mm_setzero_si128();
+    while (end - source >= 16)
+    {
+        const __m128i* chunk = reinterpret_cast<const __m128i*>(source);
+        __m128i a = _mm_loadu_si128(chunk);
+        __m128i b = _mm_loadu_si128(chunk + 1);
+        __m128i c = _mm_loadu_si128(chunk + 2);
+        __m128i d = _mm_loadu_si128(chunk + 3);
+
+        __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        if (_mm_movemask_epi8(
+            _mm_cmpeq_epi32(_mm_and_si128(any, highBits), zero)) != 0xFFFF
+        )
+            break;
+
+        // All values are below 0x80, so the saturating packs are exact.
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(dest),
+            _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d))
+        );
+        source += 16;
+        dest += 16;
+    }
+#endif
+
+    while (source < end && static_cast<unsigned>(*source) < 0x80)
+        *dest++ = static_cast<unsigned char>(*source++);
+
+    return source - start;
+}
+
+bool DecodeUtf8(const string& input, wstring& output)
+{
+    // There can't be more wchar_t's than bytes.
+    output.resize(input.size());
+    if (input.empty())
+        return true;
+
+    const unsigned char* source =
+        reinterpret_cast<const unsigned char*>(input.data());
+    const unsigned char* end = source + input.size();
+    wchar_t* dest = &output[0];
+
+    while (source < end)
+    {
+        size_t count = WidenAscii(source, end, dest);
+        source += count;
+        dest += count;
+        if (source == end)
+            break;
+
+        // Decode one multibyte sequence, rejecting overlong forms,
+        // surrogates and anything beyond U+10FFFF.
+        unsigned char lead = *source;
+        unsigned code;
+        int trailCount;
+        unsigned minimum;
+
+        if (lead >= 0xC2 && lead <= 0xDF)
+        {
+            code = lead & 0x1F;
+            trailCount = 1;
+            minimum = 0x80;
+        }
+        else if (lead >= 0xE0 && lead <= 0xEF)
+        {
+            code = lead & 0x0F;
+            trailCount = 2;
+            minimum = 0x800;
+        }
+        else if (lead >= 0xF0 && lead <= 0xF4)
+        {
+            code = lead & 0x07;
+            trailCount = 3;
+            minimum = 0x10000;
+        }
+        else
+            return false;
+
+        if (end - source <= trailCount)
+            return false;
+
+        for (int i = 1; i <= trailCount; i++)
+        {
+            if ((source[i] & 0xC0) != 0x80)
+                return false;
+            code = (code << 6) | (source[i] & 0x3F);
+        }
+
+        if (code < minimum || code > 0x10FFFF ||
+            (code >= 0xD800 && code < 0xE000)
+        )
+            return false;
+
+        *dest++ = static_cast<wchar_t>(code);
+        source += trailCount + 1;
+    }
+
+    output.resize(dest - output.data());
+    return true;
+}
+
+bool AppendUtf8(string& output, const wstring& input)
+{
+    // Start off assuming the output is pure ASCII; we make more room when
+    // we find out otherwise.
+    size_t pos = output.size();
+    output.resize(pos + input.size());
+    if (input.empty())
+        return true;
+
+    const wchar_t* source = input.data();
+    const wchar_t* end = source + input.size();
+
+    while (source < end)
+    {
+        size_t count = NarrowAscii(
+            source,
+            end,
+            reinterpret_cast<unsigned char*>(&output[pos])
+        );
+        source += count;
+        pos += count;
+        if (source == end)
+            break;
+
+        // Each remaining wchar_t needs at most four bytes.
+        if (output.size() - pos < 4 * static_cast<size_t>(end - source))
+            output.resize(pos + 4 * (end - source));
+
+        unsigned code = static_cast<unsigned>(*source++);
+        if (code > 0x10FFFF || (code >= 0xD800 && code < 0xE000))
+            return false;
+
+        if (code < 0x800)
+        {
+            output[pos++] = static_cast<char>(0xC0 | (code >> 6));
+        }
+        else if (code < 0x10000)
+        {
+            output[pos++] = static_cast<char>(0xE0 | (code >> 12));
+            output[pos++] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        }
+        else
+        {
+            output[pos++] = static_cast<char>(0xF0 | (code >> 18));
+            output[pos++] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            output[pos++] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        }
+        output[pos++] = static_cast<char>(0x80 | (code & 0x3F));
+    }
+
+    output.resize(pos);
+    return true;
+}
+
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -0,0 +1,85 @@
+// File "Utf8.h"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef BLAHTEX_UTF8_H
+#define BLAHTEX_UTF8_H
+
+#include <cwchar>
+#include <string>
+
+// The core keeps every character in a single wchar_t, and its own tables
+// contain characters outside the Basic Multilingual Plane, so it only
+// works where wchar_t is 32 bits wide. There is no UTF-16 fallback.
+#if WCHAR_MAX <= 0xFFFF
+#error "blahtex needs a 32-bit wchar_t"
+#endif
+
+namespace blahtex
+{
+
+// These functions translate between UTF-8 (in a std::string) and the
+// wchar_t format used by the core (UCS-4; see above). They are used by the UTF-8 entry points of Interface, so
+// that callers working in UTF-8 never need to see a wstring.
+//
+// Runs of ASCII characters, which is what almost all TeX input and MathML
+// output consists of, take a fast path; it uses SSE2 (and AVX2 for
+// decoding) when the compiler targets them, e.g. with "-mavx2".
+
+// DecodeUtf8() replaces the contents of "output" with the decoded "input".
+// Returns false if "input" isn't valid UTF-8 (this includes overlong
+// forms, surrogates and anything above U+10FFFF).
+extern bool DecodeUtf8(const std::string& input, std::wstring& output);
+
+// AppendUtf8() appends the UTF-8 encoding of "input" to "output". Returns
+// false if "input" contains something which isn't a valid Unicode
+// character (in which case "output" is left in an unspecified state).
+extern bool AppendUtf8(std::string& output, const std::wstring& input);
+
+// Appends the UTF-8 encoding of a single character, which must be a valid
+// Unicode scalar value.
+inline void AppendUtf8(std::string& output, unsigned code)
+{
+    if (code < 0x80)
+        output += static_cast<char>(code);
+    else if (code < 0x800)
+    {
+        output += static_cast<char>(0xC0 | (code >> 6));
+        output += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else if (code < 0x10000)
+    {
+        output += static_cast<char>(0xE0 | (code >> 12));
+        output += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        output += static_cast<char>(0x80 | (code & 0x3F));
+    }
+    else
+    {
+        output += static_cast<char>(0xF0 | (code >> 18));
+        output += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        output += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        output += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+}
+
+#endif
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
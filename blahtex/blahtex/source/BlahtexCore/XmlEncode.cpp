@@ -18,675 +18,1094 @@
 // along with this program; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
-#include <iomanip>
-#include <sstream>
-#include <map>
+#include <algorithm>
+#include <cwchar>
+#include <stdexcept>
+#include <vector>
 #include "XmlEncode.h"
+#include "Utf8.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 using namespace std;
 
 namespace blahtex
 {
 
+// The names are NULL where the character has no short or long name.
 struct UnicodeNameInfo
 {
-    wstring mShortName;
-    wstring mLongName;
-
-    UnicodeNameInfo()
-    { }
-
-    UnicodeNameInfo(
-        const wstring& shortName
-    ) :
-        mShortName(shortName)
-    { }
-
-    UnicodeNameInfo(
-        const wstring& shortName,
-        const wstring& longName
-    ) :
-        mShortName(shortName),
-        mLongName(longName)
-    { }
+    wchar_t mCode;
+    const wchar_t* mShortName;
+    const wchar_t* mLongName;
 };
 
 // This table lists all the non-ASCII characters that blahtex can give
 // names to. For each one it possibly lists a short and long MathML name.
-pair<wchar_t, UnicodeNameInfo> gUnicodeNameArray[] =
+// (Sorted by mCode; EncodedNameTable checks this. The entries switched
+// off with "#if 0" are kept in order too, so that they can be switched
+// on.)
+const UnicodeNameInfo gUnicodeNameArray[] =
 {
-    make_pair(L'\U00000060', UnicodeNameInfo(L"grave", L"DiacriticalGrave")),
-    make_pair(L'\U000000A0', UnicodeNameInfo(L"nbsp", L"NonBreakingSpace")),
-    make_pair(L'\U000000A5', UnicodeNameInfo(L"yen")),
-    make_pair(L'\U000000A7', UnicodeNameInfo(L"sect")),
-    make_pair(L'\U000000AC', UnicodeNameInfo(L"not")),
-    make_pair(L'\U000000AE', UnicodeNameInfo(L"reg", L"circledR")),
-    make_pair(L'\U000000AF', UnicodeNameInfo(L"macr", L"OverBar")),
-    make_pair(L'\U000000B1', UnicodeNameInfo(L"pm", L"PlusMinus")),
-    make_pair(L'\U000000B4', UnicodeNameInfo(L"acute", L"DiacriticalAcute")),
-    make_pair(L'\U000000B6', UnicodeNameInfo(L"para")),
-    make_pair(L'\U000000B7', UnicodeNameInfo(L"middot", L"CenterDot")),
-    make_pair(L'\U000000D7', UnicodeNameInfo(L"times")),
-    make_pair(L'\U000000D8', UnicodeNameInfo(L"Oslash")),
-    make_pair(L'\U000000F0', UnicodeNameInfo(L"eth")),
-    make_pair(L'\U000000F7', UnicodeNameInfo(L"div", L"divide")),
-    make_pair(L'\U00000127', UnicodeNameInfo(L"hstrok")),
-    make_pair(L'\U00000131', UnicodeNameInfo(L"imath")),
-    make_pair(L'\U000002C7', UnicodeNameInfo(L"caron", L"Hacek")),
-    make_pair(L'\U000002D8', UnicodeNameInfo(L"breve", L"Breve")),
-    make_pair(L'\U000002DC', UnicodeNameInfo(L"tilde", L"DiacriticalTilde")),
-    make_pair(L'\U00000338', UnicodeNameInfo()),     // FIX: combining character that needs some thought
-    make_pair(L'\U00000393', UnicodeNameInfo(L"Gamma")),
-    make_pair(L'\U00000394', UnicodeNameInfo(L"Delta")),
-    make_pair(L'\U00000398', UnicodeNameInfo(L"Theta")),
-    make_pair(L'\U0000039B', UnicodeNameInfo(L"Lambda")),
-    make_pair(L'\U0000039E', UnicodeNameInfo(L"Xi")),
-    make_pair(L'\U000003A0', UnicodeNameInfo(L"Pi")),
-    make_pair(L'\U000003A3', UnicodeNameInfo(L"Sigma")),
-    make_pair(L'\U000003A5', UnicodeNameInfo(L"Upsilon")),
-    make_pair(L'\U000003A6', UnicodeNameInfo(L"Phi")),
-    make_pair(L'\U000003A8', UnicodeNameInfo(L"Psi")),
-    make_pair(L'\U000003A9', UnicodeNameInfo(L"Omega")),
-    make_pair(L'\U000003B1', UnicodeNameInfo(L"alpha")),
-    make_pair(L'\U000003B2', UnicodeNameInfo(L"beta")),
-    make_pair(L'\U000003B3', UnicodeNameInfo(L"gamma")),
-    make_pair(L'\U000003B4', UnicodeNameInfo(L"delta")),
-    make_pair(L'\U000003B5', UnicodeNameInfo(L"epsiv", L"varepsilon")),
-    make_pair(L'\U000003B6', UnicodeNameInfo(L"zeta")),
-    make_pair(L'\U000003B7', UnicodeNameInfo(L"eta")),
-    make_pair(L'\U000003B8', UnicodeNameInfo(L"theta")),
-    make_pair(L'\U000003B9', UnicodeNameInfo(L"iota")),
-    make_pair(L'\U000003BA', UnicodeNameInfo(L"kappa")),
-    make_pair(L'\U000003BB', UnicodeNameInfo(L"lambda")),
-    make_pair(L'\U000003BC', UnicodeNameInfo(L"mu")),
-    make_pair(L'\U000003BD', UnicodeNameInfo(L"nu")),
-    make_pair(L'\U000003BE', UnicodeNameInfo(L"xi")),
-    make_pair(L'\U000003C0', UnicodeNameInfo(L"pi")),
-    make_pair(L'\U000003C1', UnicodeNameInfo(L"rho")),
-    make_pair(L'\U000003C2', UnicodeNameInfo(L"sigmav", L"varsigma")),
-    make_pair(L'\U000003C3', UnicodeNameInfo(L"sigma")),
-    make_pair(L'\U000003C4', UnicodeNameInfo(L"tau")),
-    make_pair(L'\U000003C5', UnicodeNameInfo(L"upsi", L"upsilon")),
+    {L'\U00000060', L"grave", L"DiacriticalGrave"},
+    {L'\U000000A0', L"nbsp", L"NonBreakingSpace"},
+    {L'\U000000A5', L"yen", NULL},
+    {L'\U000000A7', L"sect", NULL},
+    {L'\U000000AC', L"not", NULL},
+    {L'\U000000AE', L"reg", L"circledR"},
+    {L'\U000000AF', L"macr", L"OverBar"},
+    {L'\U000000B1', L"pm", L"PlusMinus"},
+    {L'\U000000B4', L"acute", L"DiacriticalAcute"},
+    {L'\U000000B6', L"para", NULL},
+    {L'\U000000B7', L"middot", L"CenterDot"},
+    {L'\U000000D7', L"times", NULL},
+    {L'\U000000D8', L"Oslash", NULL},
+    {L'\U000000F0', L"eth", NULL},
+    {L'\U000000F7', L"div", L"divide"},
+    {L'\U00000127', L"hstrok", NULL},
+    {L'\U00000131', L"imath", NULL},
+    {L'\U000002C7', L"caron", L"Hacek"},
+    {L'\U000002D8', L"breve", L"Breve"},
+    {L'\U000002DC', L"tilde", L"DiacriticalTilde"},
+    {L'\U00000338', NULL, NULL},     // FIX: combining character that needs some thought
+    {L'\U00000393', L"Gamma", NULL},
+    {L'\U00000394', L"Delta", NULL},
+    {L'\U00000398', L"Theta", NULL},
+    {L'\U0000039B', L"Lambda", NULL},
+    {L'\U0000039E', L"Xi", NULL},
+    {L'\U000003A0', L"Pi", NULL},
+    {L'\U000003A3', L"Sigma", NULL},
+    {L'\U000003A5', L"Upsilon", NULL},
+    {L'\U000003A6', L"Phi", NULL},
+    {L'\U000003A8', L"Psi", NULL},
+    {L'\U000003A9', L"Omega", NULL},
+    {L'\U000003B1', L"alpha", NULL},
+    {L'\U000003B2', L"beta", NULL},
+    {L'\U000003B3', L"gamma", NULL},
+    {L'\U000003B4', L"delta", NULL},
+    {L'\U000003B5', L"epsiv", L"varepsilon"},
+    {L'\U000003B6', L"zeta", NULL},
+    {L'\U000003B7', L"eta", NULL},
+    {L'\U000003B8', L"theta", NULL},
+    {L'\U000003B9', L"iota", NULL},
+    {L'\U000003BA', L"kappa", NULL},
+    {L'\U000003BB', L"lambda", NULL},
+    {L'\U000003BC', L"mu", NULL},
+    {L'\U000003BD', L"nu", NULL},
+    {L'\U000003BE', L"xi", NULL},
+    {L'\U000003C0', L"pi", NULL},
+    {L'\U000003C1', L"rho", NULL},
+    {L'\U000003C2', L"sigmav", L"varsigma"},
+    {L'\U000003C3', L"sigma", NULL},
+    {L'\U000003C4', L"tau", NULL},
+    {L'\U000003C5', L"upsi", L"upsilon"},
 #if 0
     // FIX: note Firefox 1.5 has &phi; and &varphi; around the wrong
     // way, so better to stick with numeric codes for 0x3C6 and 0x3D5.
     // See mozilla bug 321438.
-    make_pair(L'\U000003C6', UnicodeNameInfo(L"phiv", L"varphi")),
-    make_pair(L'\U000003D5', UnicodeNameInfo(L"phi", L"straightphi")),
+    {L'\U000003C6', L"phiv", L"varphi"},
+#endif
+    {L'\U000003C7', L"chi", NULL},
+    {L'\U000003C8', L"psi", NULL},
+    {L'\U000003C9', L"omega", NULL},
+    {L'\U000003D1', L"thetav", L"vartheta"},
+#if 0
+    // FIX: see 0x3C6 above.
+    {L'\U000003D5', L"phi", L"straightphi"},
 #endif
-    make_pair(L'\U000003C7', UnicodeNameInfo(L"chi")),
-    make_pair(L'\U000003C8', UnicodeNameInfo(L"psi")),
-    make_pair(L'\U000003C9', UnicodeNameInfo(L"omega")),
-    make_pair(L'\U000003D1', UnicodeNameInfo(L"thetav", L"vartheta")),
-    make_pair(L'\U000003D6', UnicodeNameInfo(L"piv", L"varpi")),
-    make_pair(L'\U000003DD', UnicodeNameInfo(L"gammad", L"digamma")),
-    make_pair(L'\U000003F0', UnicodeNameInfo(L"kappav", L"varkappa")),
-    make_pair(L'\U000003F1', UnicodeNameInfo(L"rhov", L"varrho")),
-    make_pair(L'\U000003F5', UnicodeNameInfo(L"epsi", L"straightepsilon")),
-    make_pair(L'\U000003F6', UnicodeNameInfo(L"bepsi", L"backepsilon")),
-    make_pair(L'\U00002020', UnicodeNameInfo(L"dagger")),
-    make_pair(L'\U00002021', UnicodeNameInfo(L"Dagger", L"ddagger")),
-    make_pair(L'\U00002022', UnicodeNameInfo(L"bull", L"bullet")),
-    make_pair(L'\U00002026', UnicodeNameInfo(L"hellip")),
-    make_pair(L'\U00002032', UnicodeNameInfo(L"prime")),
-    make_pair(L'\U00002035', UnicodeNameInfo(L"bprime", L"backprime")),
-    make_pair(L'\U00002102', UnicodeNameInfo(L"Copf", L"complexes")),
-    make_pair(L'\U0000210B', UnicodeNameInfo(L"Hscr", L"HilbertSpace")),
-    make_pair(L'\U0000210C', UnicodeNameInfo(L"Hfr", L"Poincareplane")),
-    make_pair(L'\U0000210D', UnicodeNameInfo(L"Hopf", L"quaternions")),
-    make_pair(L'\U0000210F', UnicodeNameInfo(L"hbar", L"planck")),
-    make_pair(L'\U00002110', UnicodeNameInfo(L"Iscr", L"imagline")),
-    make_pair(L'\U00002111', UnicodeNameInfo(L"Im", L"imagpart")),
-    make_pair(L'\U00002112', UnicodeNameInfo(L"Lscr", L"Laplacetrf")),
-    make_pair(L'\U00002113', UnicodeNameInfo(L"ell")),
-    make_pair(L'\U00002118', UnicodeNameInfo(L"wp", L"weierp")),
-    make_pair(L'\U00002119', UnicodeNameInfo(L"Popf", L"primes")),
-    make_pair(L'\U0000211A', UnicodeNameInfo(L"Qopf", L"rationals")),
-    make_pair(L'\U0000211B', UnicodeNameInfo(L"Rscr", L"realine")),
-    make_pair(L'\U0000211C', UnicodeNameInfo(L"Re", L"realpart")),
-    make_pair(L'\U0000211D', UnicodeNameInfo(L"Ropf", L"reals")),
-    make_pair(L'\U00002124', UnicodeNameInfo(L"Zopf", L"integers")),
-    make_pair(L'\U00002127', UnicodeNameInfo(L"mho")),
-    make_pair(L'\U00002128', UnicodeNameInfo(L"Zfr", L"zeetrf")),
-    make_pair(L'\U0000212C', UnicodeNameInfo(L"Bscr", L"Bernoullis")),
-    make_pair(L'\U0000212D', UnicodeNameInfo(L"Cfr", L"Cayleys")),
-    make_pair(L'\U00002130', UnicodeNameInfo(L"Escr", L"expectation")),
-    make_pair(L'\U00002131', UnicodeNameInfo(L"Fscr", L"Fouriertrf")),
-    make_pair(L'\U00002133', UnicodeNameInfo(L"Mscr", L"Mellintrf")),
-    make_pair(L'\U00002135', UnicodeNameInfo(L"aleph")),
-    make_pair(L'\U00002136', UnicodeNameInfo(L"beth")),
-    make_pair(L'\U00002137', UnicodeNameInfo(L"gimel")),
-    make_pair(L'\U00002138', UnicodeNameInfo(L"daleth")),
-    make_pair(L'\U00002190', UnicodeNameInfo(L"larr", L"LeftArrow")),
-    make_pair(L'\U00002191', UnicodeNameInfo(L"uarr", L"UpArrow")),
-    make_pair(L'\U00002192', UnicodeNameInfo(L"rarr", L"RightArrow")),
-    make_pair(L'\U00002193', UnicodeNameInfo(L"darr", L"DownArrow")),
-    make_pair(L'\U00002194', UnicodeNameInfo(L"harr", L"LeftRightArrow")),
-    make_pair(L'\U00002195', UnicodeNameInfo(L"varr", L"UpDownArrow")),
-    make_pair(L'\U00002196', UnicodeNameInfo(L"nwarr", L"UpperLeftArrow")),
-    make_pair(L'\U00002197', UnicodeNameInfo(L"nearr", L"UpperRightArrow")),
-    make_pair(L'\U00002198', UnicodeNameInfo(L"searr", L"LowerRightArrow")),
-    make_pair(L'\U00002199', UnicodeNameInfo(L"swarr", L"LowerLeftArrow")),
-    make_pair(L'\U0000219A', UnicodeNameInfo(L"nlarr", L"nleftarrow")),
-    make_pair(L'\U0000219B', UnicodeNameInfo(L"nrarr", L"nrightarrow")),
-    make_pair(L'\U0000219D', UnicodeNameInfo(L"rarrw", L"rightsquigarrow")),
-    make_pair(L'\U0000219E', UnicodeNameInfo(L"Larr", L"twoheadleftarrow")),
-    make_pair(L'\U000021A0', UnicodeNameInfo(L"Rarr", L"twoheadrightarrow")),
-    make_pair(L'\U000021A2', UnicodeNameInfo(L"larrtl", L"leftarrowtail")),
-    make_pair(L'\U000021A3', UnicodeNameInfo(L"rarrtl", L"rightarrowtail")),
-    make_pair(L'\U000021A6', UnicodeNameInfo(L"map", L"RightTeeArrow")),
-    make_pair(L'\U000021A9', UnicodeNameInfo(L"larrhk", L"hookleftarrow")),
-    make_pair(L'\U000021AA', UnicodeNameInfo(L"rarrhk", L"hookrightarrow")),
-    make_pair(L'\U000021AB', UnicodeNameInfo(L"larrlp", L"looparrowleft")),
-    make_pair(L'\U000021AC', UnicodeNameInfo(L"rarrlp", L"looparrowright")),
-    make_pair(L'\U000021AD', UnicodeNameInfo(L"harrw", L"leftrightsquigarrow")),
-    make_pair(L'\U000021AE', UnicodeNameInfo(L"nharr", L"nleftrightarrow")),
-    make_pair(L'\U000021B0', UnicodeNameInfo(L"lsh", L"Lsh")),
-    make_pair(L'\U000021B1', UnicodeNameInfo(L"rsh", L"Rsh")),
-    make_pair(L'\U000021B6', UnicodeNameInfo(L"cularr", L"curvearrowleft")),
-    make_pair(L'\U000021B7', UnicodeNameInfo(L"curarr", L"curvearrowright")),
-    make_pair(L'\U000021BA', UnicodeNameInfo(L"olarr", L"circlearrowleft")),
-    make_pair(L'\U000021BB', UnicodeNameInfo(L"orarr", L"circlearrowright")),
-    make_pair(L'\U000021BC', UnicodeNameInfo(L"lharu", L"leftharpoonup")),
-    make_pair(L'\U000021BD', UnicodeNameInfo(L"lhard", L"leftharpoondown")),
-    make_pair(L'\U000021BE', UnicodeNameInfo(L"uharr", L"upharpoonright")),
-    make_pair(L'\U000021BF', UnicodeNameInfo(L"uharl", L"upharpoonleft")),
-    make_pair(L'\U000021C0', UnicodeNameInfo(L"rharu", L"rightharpoonup")),
-    make_pair(L'\U000021C1', UnicodeNameInfo(L"rhard", L"rightharpoondown")),
-    make_pair(L'\U000021C2', UnicodeNameInfo(L"dharr", L"downharpoonright")),
-    make_pair(L'\U000021C3', UnicodeNameInfo(L"dharl", L"downharpoonleft")),
-    make_pair(L'\U000021C4', UnicodeNameInfo(L"rlarr", L"RightArrowLeftArrow")),
-    make_pair(L'\U000021C6', UnicodeNameInfo(L"lrarr", L"LeftArrowRightArrow")),
-    make_pair(L'\U000021C7', UnicodeNameInfo(L"llarr", L"leftleftarrows")),
-    make_pair(L'\U000021C8', UnicodeNameInfo(L"uuarr", L"upuparrows")),
-    make_pair(L'\U000021C9', UnicodeNameInfo(L"rrarr", L"rightrightarrows")),
-    make_pair(L'\U000021CA', UnicodeNameInfo(L"ddarr", L"downdownarrows")),
-    make_pair(L'\U000021CB', UnicodeNameInfo(L"lrhar", L"ReverseEquilibrium")),
-    make_pair(L'\U000021CC', UnicodeNameInfo(L"rlhar", L"Equilibrium")),
-    make_pair(L'\U000021CD', UnicodeNameInfo(L"nlArr", L"nLeftarrow")),
-    make_pair(L'\U000021CE', UnicodeNameInfo(L"nhArr", L"nLeftrightarrow")),
-    make_pair(L'\U000021CF', UnicodeNameInfo(L"nrArr", L"nRightarrow")),
-    make_pair(L'\U000021D0', UnicodeNameInfo(L"lArr", L"DoubleLeftArrow")),
-    make_pair(L'\U000021D1', UnicodeNameInfo(L"uArr", L"DoubleUpArrow")),
-    make_pair(L'\U000021D2', UnicodeNameInfo(L"rArr", L"DoubleRightArrow")),
-    make_pair(L'\U000021D3', UnicodeNameInfo(L"dArr", L"DoubleDownArrow")),
-    make_pair(L'\U000021D4', UnicodeNameInfo(L"hArr", L"DoubleLeftRightArrow")),
-    make_pair(L'\U000021D5', UnicodeNameInfo(L"vArr", L"DoubleUpDownArrow")),
-    make_pair(L'\U000021DA', UnicodeNameInfo(L"lAarr", L"Lleftarrow")),
-    make_pair(L'\U000021DB', UnicodeNameInfo(L"rAarr", L"Rrightarrow")),
-    make_pair(L'\U000021DD', UnicodeNameInfo(L"zigrarr")),
-    make_pair(L'\U00002200', UnicodeNameInfo(L"forall", L"ForAll")),
-    make_pair(L'\U00002201', UnicodeNameInfo(L"comp", L"complement")),
-    make_pair(L'\U00002202', UnicodeNameInfo(L"part", L"PartialD")),
-    make_pair(L'\U00002203', UnicodeNameInfo(L"exist", L"Exists")),
-    make_pair(L'\U00002204', UnicodeNameInfo(L"nexist", L"NotExists")),
-    make_pair(L'\U00002205', UnicodeNameInfo(L"empty", L"emptyset")),
-    make_pair(L'\U00002207', UnicodeNameInfo(L"nabla", L"Del")),
-    make_pair(L'\U00002208', UnicodeNameInfo(L"in", L"Element")),
-    make_pair(L'\U00002209', UnicodeNameInfo(L"notin", L"NotElement")),
-    make_pair(L'\U0000220B', UnicodeNameInfo(L"ni", L"ReverseElement")),
-    make_pair(L'\U0000220C', UnicodeNameInfo(L"notni", L"NotReverseElement")),
-    make_pair(L'\U0000220F', UnicodeNameInfo(L"prod", L"Product")),
-    make_pair(L'\U00002210', UnicodeNameInfo(L"coprod", L"Coproduct")),
-    make_pair(L'\U00002211', UnicodeNameInfo(L"sum", L"Sum")),
-    make_pair(L'\U00002213', UnicodeNameInfo(L"mp", L"MinusPlus")),
-    make_pair(L'\U00002214', UnicodeNameInfo(L"dotplus")),
-    make_pair(L'\U00002216', UnicodeNameInfo(L"setmn", L"Backslash")),
-    make_pair(L'\U00002218', UnicodeNameInfo(L"compfn", L"SmallCircle")),
-    make_pair(L'\U0000221A', UnicodeNameInfo(L"radic", L"Sqrt")),
-    make_pair(L'\U0000221D', UnicodeNameInfo(L"prop", L"Proportional")),
-    make_pair(L'\U0000221E', UnicodeNameInfo(L"infin")),
-    make_pair(L'\U00002220', UnicodeNameInfo(L"ang", L"angle")),
-    make_pair(L'\U00002221', UnicodeNameInfo(L"angmsd", L"measuredangle")),
-    make_pair(L'\U00002222', UnicodeNameInfo(L"angsph")),
-    make_pair(L'\U00002223', UnicodeNameInfo(L"mid", L"VerticalBar")),
-    make_pair(L'\U00002224', UnicodeNameInfo(L"nmid", L"NotVerticalBar")),
-    make_pair(L'\U00002225', UnicodeNameInfo(L"par", L"DoubleVerticalBar")),
-    make_pair(L'\U00002226', UnicodeNameInfo(L"npar", L"NotDoubleVerticalBar")),
-    make_pair(L'\U00002227', UnicodeNameInfo(L"and", L"wedge")),
-    make_pair(L'\U00002228', UnicodeNameInfo(L"or", L"vee")),
-    make_pair(L'\U00002229', UnicodeNameInfo(L"cap")),
-    make_pair(L'\U0000222A', UnicodeNameInfo(L"cup")),
-    make_pair(L'\U0000222B', UnicodeNameInfo(L"int", L"Integral")),
-    make_pair(L'\U0000222C', UnicodeNameInfo(L"Int")),
-    make_pair(L'\U0000222D', UnicodeNameInfo(L"tint", L"iiint")),
-    make_pair(L'\U0000222E', UnicodeNameInfo(L"conint", L"ContourIntegral")),
-    make_pair(L'\U00002234', UnicodeNameInfo(L"there4", L"Therefore")),
-    make_pair(L'\U00002235', UnicodeNameInfo(L"becaus", L"Because")),
-    make_pair(L'\U0000223C', UnicodeNameInfo(L"sim", L"Tilde")),
-    make_pair(L'\U0000223D', UnicodeNameInfo(L"bsim", L"backsim")),
-    make_pair(L'\U00002240', UnicodeNameInfo(L"wr", L"VerticalTilde")),
-    make_pair(L'\U00002241', UnicodeNameInfo(L"nsim", L"NotTilde")),
-    make_pair(L'\U00002242', UnicodeNameInfo(L"esim", L"EqualTilde")),
-    make_pair(L'\U00002243', UnicodeNameInfo(L"sime", L"TildeEqual")),
-    make_pair(L'\U00002244', UnicodeNameInfo(L"nsime", L"NotTildeEqual")),
-    make_pair(L'\U00002245', UnicodeNameInfo(L"cong", L"TildeFullEqual")),
-    make_pair(L'\U00002247', UnicodeNameInfo(L"ncong", L"NotTildeFullEqual")),
-    make_pair(L'\U00002248', UnicodeNameInfo(L"ap", L"TildeTilde")),
-    make_pair(L'\U00002249', UnicodeNameInfo(L"nap", L"NotTildeTilde")),
-    make_pair(L'\U0000224A', UnicodeNameInfo(L"ape", L"approxeq")),
-    make_pair(L'\U0000224E', UnicodeNameInfo(L"bump", L"HumpDownHump")),
-    make_pair(L'\U0000224F', UnicodeNameInfo(L"nbump", L"NotHumpDownHump")),
-    make_pair(L'\U00002250', UnicodeNameInfo(L"esdot", L"DotEqual")),
-    make_pair(L'\U00002251', UnicodeNameInfo(L"eDot", L"doteqdot")),
-    make_pair(L'\U00002252', UnicodeNameInfo(L"efDot", L"fallingdotseq")),
-    make_pair(L'\U00002253', UnicodeNameInfo(L"erDot", L"risingdotseq")),
-    make_pair(L'\U00002256', UnicodeNameInfo(L"ecir", L"eqcirc")),
-    make_pair(L'\U00002257', UnicodeNameInfo(L"cire", L"circeq")),
-    make_pair(L'\U0000225C', UnicodeNameInfo(L"trie", L"triangleq")),
-    make_pair(L'\U00002260', UnicodeNameInfo(L"ne", L"NotEqual")),
-    make_pair(L'\U00002261', UnicodeNameInfo(L"equiv", L"Congruent")),
-    make_pair(L'\U00002262', UnicodeNameInfo(L"nequiv", L"NotCongruent")),
-    make_pair(L'\U00002264', UnicodeNameInfo(L"le", L"leq")),
-    make_pair(L'\U00002265', UnicodeNameInfo(L"ge", L"GreaterEqual")),
-    make_pair(L'\U00002266', UnicodeNameInfo(L"lE", L"LessFullEqual")),
-    make_pair(L'\U00002267', UnicodeNameInfo(L"gE", L"GreaterFullEqual")),
-    make_pair(L'\U00002268', UnicodeNameInfo(L"lnE", L"lneqq")),
-    make_pair(L'\U00002269', UnicodeNameInfo(L"gnE", L"gneqq")),
-    make_pair(L'\U0000226A', UnicodeNameInfo(L"Lt", L"NestedLessLess")),
-    make_pair(L'\U0000226B', UnicodeNameInfo(L"Gt", L"NestedGreaterGreater")),
-    make_pair(L'\U0000226C', UnicodeNameInfo(L"twixt", L"between")),
-    make_pair(L'\U0000226E', UnicodeNameInfo(L"nlt", L"NotLess")),
-    make_pair(L'\U0000226F', UnicodeNameInfo(L"ngt", L"NotGreater")),
-    make_pair(L'\U00002270', UnicodeNameInfo(L"nle", L"NotLessEqual")),
-    make_pair(L'\U00002271', UnicodeNameInfo(L"nge", L"NotGreaterEqual")),
-    make_pair(L'\U00002272', UnicodeNameInfo(L"lsim", L"LessTilde")),
-    make_pair(L'\U00002273', UnicodeNameInfo(L"gsim", L"GreaterTilde")),
-    make_pair(L'\U00002276', UnicodeNameInfo(L"lg", L"LessGreater")),
-    make_pair(L'\U00002277', UnicodeNameInfo(L"gl", L"GreaterLess")),
-    make_pair(L'\U0000227A', UnicodeNameInfo(L"pr", L"Precedes")),
-    make_pair(L'\U0000227B', UnicodeNameInfo(L"sc", L"Succeeds")),
-    make_pair(L'\U0000227C', UnicodeNameInfo(L"prcue", L"PrecedesSlantEqual")),
-    make_pair(L'\U0000227D', UnicodeNameInfo(L"sccue", L"SucceedsSlantEqual")),
-    make_pair(L'\U0000227E', UnicodeNameInfo(L"prsim", L"PrecedesTilde")),
-    make_pair(L'\U0000227F', UnicodeNameInfo(L"scsim", L"SucceedsTilde")),
-    make_pair(L'\U00002280', UnicodeNameInfo(L"npr", L"NotPrecedes")),
-    make_pair(L'\U00002281', UnicodeNameInfo(L"nsc", L"NotSucceeds")),
-    make_pair(L'\U00002282', UnicodeNameInfo(L"sub", L"subset")),
-    make_pair(L'\U00002283', UnicodeNameInfo(L"sup", L"supset")),
-    make_pair(L'\U00002284', UnicodeNameInfo(L"nsub")),
-    make_pair(L'\U00002285', UnicodeNameInfo(L"nsup")),
-    make_pair(L'\U00002286', UnicodeNameInfo(L"sube", L"SubsetEqual")),
-    make_pair(L'\U00002287', UnicodeNameInfo(L"supe", L"SupersetEqual")),
-    make_pair(L'\U00002288', UnicodeNameInfo(L"nsube", L"NotSubsetEqual")),
-    make_pair(L'\U00002289', UnicodeNameInfo(L"nsupe", L"NotSupersetEqual")),
-    make_pair(L'\U0000228A', UnicodeNameInfo(L"subne", L"subsetneq")),
-    make_pair(L'\U0000228B', UnicodeNameInfo(L"supne", L"supsetneq")),
-    make_pair(L'\U0000228E', UnicodeNameInfo(L"uplus", L"UnionPlus")),
-    make_pair(L'\U0000228F', UnicodeNameInfo(L"sqsub", L"SquareSubset")),
-    make_pair(L'\U00002290', UnicodeNameInfo(L"sqsup", L"SquareSuperset")),
-    make_pair(L'\U00002291', UnicodeNameInfo(L"sqsube", L"SquareSubsetEqual")),
-    make_pair(L'\U00002292', UnicodeNameInfo(L"sqsupe", L"SquareSupersetEqual")),
-    make_pair(L'\U00002293', UnicodeNameInfo(L"sqcap", L"SquareIntersection")),
-    make_pair(L'\U00002294', UnicodeNameInfo(L"sqcup", L"SquareUnion")),
-    make_pair(L'\U00002295', UnicodeNameInfo(L"oplus", L"CirclePlus")),
-    make_pair(L'\U00002296', UnicodeNameInfo(L"ominus", L"CircleMinus")),
-    make_pair(L'\U00002297', UnicodeNameInfo(L"otimes", L"CircleTimes")),
-    make_pair(L'\U00002298', UnicodeNameInfo(L"osol")),
-    make_pair(L'\U00002299', UnicodeNameInfo(L"odot", L"CircleDot")),
-    make_pair(L'\U0000229A', UnicodeNameInfo(L"ocir", L"circledcirc")),
-    make_pair(L'\U0000229B', UnicodeNameInfo(L"oast", L"circledast")),
-    make_pair(L'\U0000229D', UnicodeNameInfo(L"odash", L"circleddash")),
-    make_pair(L'\U0000229E', UnicodeNameInfo(L"plusb", L"boxplus")),
-    make_pair(L'\U0000229F', UnicodeNameInfo(L"minusb", L"boxminus")),
-    make_pair(L'\U000022A0', UnicodeNameInfo(L"timesb", L"boxtimes")),
-    make_pair(L'\U000022A1', UnicodeNameInfo(L"sdotb", L"dotsquare")),
-    make_pair(L'\U000022A2', UnicodeNameInfo(L"vdash", L"RightTee")),
-    make_pair(L'\U000022A3', UnicodeNameInfo(L"dashv", L"LeftTee")),
-    make_pair(L'\U000022A4', UnicodeNameInfo(L"top", L"DownTee")),
-    make_pair(L'\U000022A5', UnicodeNameInfo(L"bot", L"UpTee")),
-    make_pair(L'\U000022A7', UnicodeNameInfo(L"models")),
-    make_pair(L'\U000022A8', UnicodeNameInfo(L"vDash", L"DoubleRightTee")),
-    make_pair(L'\U000022A9', UnicodeNameInfo(L"Vdash")),
-    make_pair(L'\U000022AA', UnicodeNameInfo(L"Vvdash")),
-    make_pair(L'\U000022AC', UnicodeNameInfo(L"nvdash")),
-    make_pair(L'\U000022AD', UnicodeNameInfo(L"nvDash")),
-    make_pair(L'\U000022AE', UnicodeNameInfo(L"nVdash")),
-    make_pair(L'\U000022AF', UnicodeNameInfo(L"nVDash")),
-    make_pair(L'\U000022B2', UnicodeNameInfo(L"vltri", L"LeftTriangle")),
-    make_pair(L'\U000022B3', UnicodeNameInfo(L"vrtri", L"RightTriangle")),
-    make_pair(L'\U000022B4', UnicodeNameInfo(L"ltrie", L"LeftTriangleEqual")),
-    make_pair(L'\U000022B5', UnicodeNameInfo(L"rtrie", L"RightTriangleEqual")),
-    make_pair(L'\U000022B8', UnicodeNameInfo(L"mumap", L"multimap")),
-    make_pair(L'\U000022BA', UnicodeNameInfo(L"intcal", L"intercal")),
-    make_pair(L'\U000022BB', UnicodeNameInfo(L"veebar")),
-    make_pair(L'\U000022C0', UnicodeNameInfo(L"xwedge", L"Wedge")),
-    make_pair(L'\U000022C1', UnicodeNameInfo(L"xvee", L"Vee")),
-    make_pair(L'\U000022C2', UnicodeNameInfo(L"xcap", L"Intersection")),
-    make_pair(L'\U000022C3', UnicodeNameInfo(L"xcup", L"Union")),
-    make_pair(L'\U000022C4', UnicodeNameInfo(L"diam", L"Diamond")),
-    make_pair(L'\U000022C5', UnicodeNameInfo(L"sdot")),
-    make_pair(L'\U000022C6', UnicodeNameInfo(L"Star")),
-    make_pair(L'\U000022C7', UnicodeNameInfo(L"divonx", L"divideontimes")),
-    make_pair(L'\U000022C8', UnicodeNameInfo(L"bowtie")),
-    make_pair(L'\U000022C9', UnicodeNameInfo(L"ltimes")),
-    make_pair(L'\U000022CA', UnicodeNameInfo(L"rtimes")),
-    make_pair(L'\U000022CB', UnicodeNameInfo(L"lthree", L"leftthreetimes")),
-    make_pair(L'\U000022CC', UnicodeNameInfo(L"rthree", L"rightthreetimes")),
-    make_pair(L'\U000022CD', UnicodeNameInfo(L"bsime", L"backsimeq")),
-    make_pair(L'\U000022CE', UnicodeNameInfo(L"cuvee", L"curlyvee")),
-    make_pair(L'\U000022CF', UnicodeNameInfo(L"cuwed", L"curlywedge")),
-    make_pair(L'\U000022D0', UnicodeNameInfo(L"Sub", L"Subset")),
-    make_pair(L'\U000022D1', UnicodeNameInfo(L"Sup", L"Supset")),
-    make_pair(L'\U000022D2', UnicodeNameInfo(L"Cap")),
-    make_pair(L'\U000022D3', UnicodeNameInfo(L"Cup")),
-    make_pair(L'\U000022D4', UnicodeNameInfo(L"fork", L"pitchfork")),
-    make_pair(L'\U000022D6', UnicodeNameInfo(L"ltdot", L"lessdot")),
-    make_pair(L'\U000022D7', UnicodeNameInfo(L"gtdot", L"gtrdot")),
-    make_pair(L'\U000022D8', UnicodeNameInfo(L"Ll")),
-    make_pair(L'\U000022D9', UnicodeNameInfo(L"Gg")),
-    make_pair(L'\U000022DA', UnicodeNameInfo(L"leg", L"LessEqualGreater")),
-    make_pair(L'\U000022DB', UnicodeNameInfo(L"gel", L"GreaterEqualLess")),
-    make_pair(L'\U000022DE', UnicodeNameInfo(L"cuepr", L"curlyeqprec")),
-    make_pair(L'\U000022DF', UnicodeNameInfo(L"cuesc", L"curlyeqsucc")),
-    make_pair(L'\U000022E2', UnicodeNameInfo(L"nsqsube", L"NotSquareSubsetEqual")),
-    make_pair(L'\U000022E3', UnicodeNameInfo(L"nsqsupe", L"NotSquareSupersetEqual")),
-    make_pair(L'\U000022E6', UnicodeNameInfo(L"lnsim")),
-    make_pair(L'\U000022E7', UnicodeNameInfo(L"gnsim")),
-    make_pair(L'\U000022E8', UnicodeNameInfo(L"prnsim", L"precnsim")),
-    make_pair(L'\U000022E9', UnicodeNameInfo(L"scnsim", L"succnsim")),
-    make_pair(L'\U000022EA', UnicodeNameInfo(L"nltri", L"NotLeftTriangle")),
-    make_pair(L'\U000022EB', UnicodeNameInfo(L"nrtri", L"NotRightTriangle")),
-    make_pair(L'\U000022EC', UnicodeNameInfo(L"nltrie", L"NotLeftTriangleEqual")),
-    make_pair(L'\U000022ED', UnicodeNameInfo(L"nrtrie", L"NotRightTriangleEqual")),
-    make_pair(L'\U000022EE', UnicodeNameInfo(L"vellip")),
-    make_pair(L'\U000022EF', UnicodeNameInfo(L"ctdot")),
-    make_pair(L'\U000022F1', UnicodeNameInfo(L"dtdot")),
-    make_pair(L'\U00002305', UnicodeNameInfo(L"barwed", L"barwedge")),
-    make_pair(L'\U00002306', UnicodeNameInfo(L"Barwed", L"doublebarwedge")),
-    make_pair(L'\U00002308', UnicodeNameInfo(L"lceil", L"LeftCeiling")),
-    make_pair(L'\U00002309', UnicodeNameInfo(L"rceil", L"RightCeiling")),
-    make_pair(L'\U0000230A', UnicodeNameInfo(L"lfloor", L"LeftFloor")),
-    make_pair(L'\U0000230B', UnicodeNameInfo(L"rfloor", L"RightFloor")),
-    make_pair(L'\U0000231C', UnicodeNameInfo(L"ulcorn", L"ulcorner")),
-    make_pair(L'\U0000231D', UnicodeNameInfo(L"urcorn", L"urcorner")),
-    make_pair(L'\U0000231E', UnicodeNameInfo(L"dlcorn", L"llcorner")),
-    make_pair(L'\U0000231F', UnicodeNameInfo(L"drcorn", L"lrcorner")),
-    make_pair(L'\U00002322', UnicodeNameInfo(L"frown", L"sfrown")),
-    make_pair(L'\U00002323', UnicodeNameInfo(L"smile", L"ssmile")),
-    make_pair(L'\U00002329', UnicodeNameInfo(L"lang", L"LeftAngleBracket")),
-    make_pair(L'\U0000232A', UnicodeNameInfo(L"rang", L"RightAngleBracket")),
-    make_pair(L'\U000023B5', UnicodeNameInfo(L"bbrk", L"UnderBracket")),
-    make_pair(L'\U000024C8', UnicodeNameInfo(L"oS", L"circledS")),
-    make_pair(L'\U000025A1', UnicodeNameInfo(L"squ", L"Square")),
-    make_pair(L'\U000025B3', UnicodeNameInfo(L"xutri", L"bigtriangleup")),
-    make_pair(L'\U000025B4', UnicodeNameInfo(L"utrif", L"blacktriangle")),
-    make_pair(L'\U000025B5', UnicodeNameInfo(L"utri", L"triangle")),
-    make_pair(L'\U000025B6', UnicodeNameInfo()),
-    make_pair(L'\U000025B9', UnicodeNameInfo(L"rtri", L"triangleright")),
-    make_pair(L'\U000025BD', UnicodeNameInfo(L"xdtri", L"bigtriangledown")),
-    make_pair(L'\U000025BE', UnicodeNameInfo(L"dtrif", L"blacktriangledown")),
-    make_pair(L'\U000025BF', UnicodeNameInfo(L"dtri", L"triangledown")),
-    make_pair(L'\U000025C0', UnicodeNameInfo()),
-    make_pair(L'\U000025C3', UnicodeNameInfo(L"ltri", L"triangleleft")),
-    make_pair(L'\U000025CA', UnicodeNameInfo(L"loz", L"lozenge")),
-    make_pair(L'\U000025EF', UnicodeNameInfo(L"xcirc", L"bigcirc")),
-    make_pair(L'\U000025FC', UnicodeNameInfo(L"FilledSmallSquare")),
-    make_pair(L'\U00002605', UnicodeNameInfo(L"starf", L"bigstar")),
-    make_pair(L'\U00002660', UnicodeNameInfo(L"spades", L"spadesuit")),
-    make_pair(L'\U00002663', UnicodeNameInfo(L"clubs", L"clubsuit")),
-    make_pair(L'\U00002665', UnicodeNameInfo(L"hearts", L"heartsuit")),
-    make_pair(L'\U00002666', UnicodeNameInfo(L"diams", L"diamondsuit")),
-    make_pair(L'\U0000266D', UnicodeNameInfo(L"flat")),
-    make_pair(L'\U0000266E', UnicodeNameInfo(L"natur", L"natural")),
-    make_pair(L'\U0000266F', UnicodeNameInfo(L"sharp")),
-    make_pair(L'\U00002713', UnicodeNameInfo(L"check", L"checkmark")),
-    make_pair(L'\U00002720', UnicodeNameInfo(L"malt", L"maltese")),
-    make_pair(L'\U000027F5', UnicodeNameInfo(L"xlarr", L"LongLeftArrow")),
-    make_pair(L'\U000027F6', UnicodeNameInfo(L"xrarr", L"LongRightArrow")),
-    make_pair(L'\U000027F7', UnicodeNameInfo(L"xharr", L"LongLeftRightArrow")),
-    make_pair(L'\U000027F8', UnicodeNameInfo(L"xlArr", L"DoubleLongLeftArrow")),
-    make_pair(L'\U000027F9', UnicodeNameInfo(L"xrArr", L"DoubleLongRightArrow")),
-    make_pair(L'\U000027FA', UnicodeNameInfo(L"xhArr", L"DoubleLongLeftRightArrow")),
-    make_pair(L'\U000027FC', UnicodeNameInfo(L"xmap", L"longMapsto")),
-    make_pair(L'\U0000290E', UnicodeNameInfo(L"lBarr")),
-    make_pair(L'\U0000290F', UnicodeNameInfo(L"rBarr", L"dbkarow")),
-    make_pair(L'\U000029EB', UnicodeNameInfo(L"lozf", L"blacklozenge")),
-    make_pair(L'\U00002A00', UnicodeNameInfo(L"xodot", L"bigodot")),
-    make_pair(L'\U00002A01', UnicodeNameInfo(L"xoplus", L"bigoplus")),
-    make_pair(L'\U00002A02', UnicodeNameInfo(L"xotime", L"bigotimes")),
-    make_pair(L'\U00002A04', UnicodeNameInfo(L"xuplus", L"biguplus")),
-    make_pair(L'\U00002A06', UnicodeNameInfo(L"xsqcup", L"bigsqcup")),
-    make_pair(L'\U00002A0C', UnicodeNameInfo(L"qint", L"iiiint")),
-    make_pair(L'\U00002A2F', UnicodeNameInfo(L"Cross")),
-    make_pair(L'\U00002A3F', UnicodeNameInfo(L"amalg")),
-    make_pair(L'\U00002A7D', UnicodeNameInfo(L"les", L"LessSlantEqual")),
-    make_pair(L'\U00002A7E', UnicodeNameInfo(L"ges", L"GreaterSlantEqual")),
-    make_pair(L'\U00002A85', UnicodeNameInfo(L"lap", L"lessapprox")),
-    make_pair(L'\U00002A86', UnicodeNameInfo(L"gap", L"gtrapprox")),
-    make_pair(L'\U00002A89', UnicodeNameInfo(L"lnap", L"lnapprox")),
-    make_pair(L'\U00002A8A', UnicodeNameInfo(L"gnap", L"gnapprox")),
-    make_pair(L'\U00002A8B', UnicodeNameInfo(L"lEg", L"lesseqqgtr")),
-    make_pair(L'\U00002A8C', UnicodeNameInfo(L"gEl", L"gtreqqless")),
-    make_pair(L'\U00002A95', UnicodeNameInfo(L"els", L"eqslantless")),
-    make_pair(L'\U00002A96', UnicodeNameInfo(L"egs", L"eqslantgtr")),
-    make_pair(L'\U00002AAF', UnicodeNameInfo(L"pre", L"PrecedesEqual")),
-    make_pair(L'\U00002AB0', UnicodeNameInfo(L"sce", L"SucceedsEqual")),
-    make_pair(L'\U00002AB5', UnicodeNameInfo(L"prnE", L"precneqq")),
-    make_pair(L'\U00002AB6', UnicodeNameInfo(L"scnE", L"succneqq")),
-    make_pair(L'\U00002AB7', UnicodeNameInfo(L"prap", L"precapprox")),
-    make_pair(L'\U00002AB8', UnicodeNameInfo(L"scap", L"succapprox")),
-    make_pair(L'\U00002AB9', UnicodeNameInfo(L"prnap", L"precnapprox")),
-    make_pair(L'\U00002ABA', UnicodeNameInfo(L"scnap", L"succnapprox")),
-    make_pair(L'\U00002AC5', UnicodeNameInfo(L"subE", L"subseteqq")),
-    make_pair(L'\U00002AC6', UnicodeNameInfo(L"supE", L"supseteqq")),
-    make_pair(L'\U00002ACB', UnicodeNameInfo(L"subnE", L"subsetneqq")),
-    make_pair(L'\U00002ACC', UnicodeNameInfo(L"supnE", L"supsetneqq")),
-    make_pair(L'\U0000FE00', UnicodeNameInfo()),        // FIX: think about this combining character...
-    make_pair(L'\U0000FE37', UnicodeNameInfo(L"OverBrace")),
-    make_pair(L'\U0000FE38', UnicodeNameInfo(L"UnderBrace")),
-    make_pair(L'\U0001D49C', UnicodeNameInfo(L"Ascr")),
-    make_pair(L'\U0001D49E', UnicodeNameInfo(L"Cscr")),
-    make_pair(L'\U0001D49F', UnicodeNameInfo(L"Dscr")),
-    make_pair(L'\U0001D4A2', UnicodeNameInfo(L"Gscr")),
-    make_pair(L'\U0001D4A5', UnicodeNameInfo(L"Jscr")),
-    make_pair(L'\U0001D4A6', UnicodeNameInfo(L"Kscr")),
-    make_pair(L'\U0001D4A9', UnicodeNameInfo(L"Nscr")),
-    make_pair(L'\U0001D4AA', UnicodeNameInfo(L"Oscr")),
-    make_pair(L'\U0001D4AB', UnicodeNameInfo(L"Pscr")),
-    make_pair(L'\U0001D4AC', UnicodeNameInfo(L"Qscr")),
-    make_pair(L'\U0001D4AE', UnicodeNameInfo(L"Sscr")),
-    make_pair(L'\U0001D4AF', UnicodeNameInfo(L"Tscr")),
-    make_pair(L'\U0001D4B0', UnicodeNameInfo(L"Uscr")),
-    make_pair(L'\U0001D4B1', UnicodeNameInfo(L"Vscr")),
-    make_pair(L'\U0001D4B2', UnicodeNameInfo(L"Wscr")),
-    make_pair(L'\U0001D4B3', UnicodeNameInfo(L"Xscr")),
-    make_pair(L'\U0001D4B4', UnicodeNameInfo(L"Yscr")),
-    make_pair(L'\U0001D4B5', UnicodeNameInfo(L"Zscr")),
-    make_pair(L'\U0001D4D0', UnicodeNameInfo()),    // mathematical bold script capitals
-    make_pair(L'\U0001D4D1', UnicodeNameInfo()),
-    make_pair(L'\U0001D4D2', UnicodeNameInfo()),
-    make_pair(L'\U0001D4D3', UnicodeNameInfo()),
-    make_pair(L'\U0001D4D4', UnicodeNameInfo()),
-    make_pair(L'\U0001D4D5', UnicodeNameInfo()),
-    make_pair(L'\U0001D4D6', UnicodeNameInfo()),
-    make_pair(L'\U0001D4D7', UnicodeNameInfo()),
-    make_pair(L'\U0001D4D8', UnicodeNameInfo()),
-    make_pair(L'\U0001D4D9', UnicodeNameInfo()),
-    make_pair(L'\U0001D4DA', UnicodeNameInfo()),
-    make_pair(L'\U0001D4DB', UnicodeNameInfo()),
-    make_pair(L'\U0001D4DC', UnicodeNameInfo()),
-    make_pair(L'\U0001D4DD', UnicodeNameInfo()),
-    make_pair(L'\U0001D4DE', UnicodeNameInfo()),
-    make_pair(L'\U0001D4DF', UnicodeNameInfo()),
-    make_pair(L'\U0001D4E0', UnicodeNameInfo()),
-    make_pair(L'\U0001D4E1', UnicodeNameInfo()),
-    make_pair(L'\U0001D4E2', UnicodeNameInfo()),
-    make_pair(L'\U0001D4E3', UnicodeNameInfo()),
-    make_pair(L'\U0001D4E4', UnicodeNameInfo()),
-    make_pair(L'\U0001D4E5', UnicodeNameInfo()),
-    make_pair(L'\U0001D4E6', UnicodeNameInfo()),
-    make_pair(L'\U0001D4E7', UnicodeNameInfo()),
-    make_pair(L'\U0001D4E8', UnicodeNameInfo()),
-    make_pair(L'\U0001D4E9', UnicodeNameInfo()),
-    make_pair(L'\U0001D504', UnicodeNameInfo(L"Afr")),
-    make_pair(L'\U0001D505', UnicodeNameInfo(L"Bfr")),
-    make_pair(L'\U0001D507', UnicodeNameInfo(L"Dfr")),
-    make_pair(L'\U0001D508', UnicodeNameInfo(L"Efr")),
-    make_pair(L'\U0001D509', UnicodeNameInfo(L"Ffr")),
-    make_pair(L'\U0001D50A', UnicodeNameInfo(L"Gfr")),
-    make_pair(L'\U0001D50D', UnicodeNameInfo(L"Jfr")),
-    make_pair(L'\U0001D50E', UnicodeNameInfo(L"Kfr")),
-    make_pair(L'\U0001D50F', UnicodeNameInfo(L"Lfr")),
-    make_pair(L'\U0001D510', UnicodeNameInfo(L"Mfr")),
-    make_pair(L'\U0001D511', UnicodeNameInfo(L"Nfr")),
-    make_pair(L'\U0001D512', UnicodeNameInfo(L"Ofr")),
-    make_pair(L'\U0001D513', UnicodeNameInfo(L"Pfr")),
-    make_pair(L'\U0001D514', UnicodeNameInfo(L"Qfr")),
-    make_pair(L'\U0001D516', UnicodeNameInfo(L"Sfr")),
-    make_pair(L'\U0001D517', UnicodeNameInfo(L"Tfr")),
-    make_pair(L'\U0001D518', UnicodeNameInfo(L"Ufr")),
-    make_pair(L'\U0001D519', UnicodeNameInfo(L"Vfr")),
-    make_pair(L'\U0001D51A', UnicodeNameInfo(L"Wfr")),
-    make_pair(L'\U0001D51B', UnicodeNameInfo(L"Xfr")),
-    make_pair(L'\U0001D51C', UnicodeNameInfo(L"Yfr")),
-    make_pair(L'\U0001D51E', UnicodeNameInfo(L"afr")),
-    make_pair(L'\U0001D51F', UnicodeNameInfo(L"bfr")),
-    make_pair(L'\U0001D520', UnicodeNameInfo(L"cfr")),
-    make_pair(L'\U0001D521', UnicodeNameInfo(L"dfr")),
-    make_pair(L'\U0001D522', UnicodeNameInfo(L"efr")),
-    make_pair(L'\U0001D523', UnicodeNameInfo(L"ffr")),
-    make_pair(L'\U0001D524', UnicodeNameInfo(L"gfr")),
-    make_pair(L'\U0001D525', UnicodeNameInfo(L"hfr")),
-    make_pair(L'\U0001D526', UnicodeNameInfo(L"ifr")),
-    make_pair(L'\U0001D527', UnicodeNameInfo(L"jfr")),
-    make_pair(L'\U0001D528', UnicodeNameInfo(L"kfr")),
-    make_pair(L'\U0001D529', UnicodeNameInfo(L"lfr")),
-    make_pair(L'\U0001D52A', UnicodeNameInfo(L"mfr")),
-    make_pair(L'\U0001D52B', UnicodeNameInfo(L"nfr")),
-    make_pair(L'\U0001D52C', UnicodeNameInfo(L"ofr")),
-    make_pair(L'\U0001D52D', UnicodeNameInfo(L"pfr")),
-    make_pair(L'\U0001D52E', UnicodeNameInfo(L"qfr")),
-    make_pair(L'\U0001D52F', UnicodeNameInfo(L"rfr")),
-    make_pair(L'\U0001D530', UnicodeNameInfo(L"sfr")),
-    make_pair(L'\U0001D531', UnicodeNameInfo(L"tfr")),
-    make_pair(L'\U0001D532', UnicodeNameInfo(L"ufr")),
-    make_pair(L'\U0001D533', UnicodeNameInfo(L"vfr")),
-    make_pair(L'\U0001D534', UnicodeNameInfo(L"wfr")),
-    make_pair(L'\U0001D535', UnicodeNameInfo(L"xfr")),
-    make_pair(L'\U0001D536', UnicodeNameInfo(L"yfr")),
-    make_pair(L'\U0001D537', UnicodeNameInfo(L"zfr")),
-    make_pair(L'\U0001D538', UnicodeNameInfo(L"Aopf")),
-    make_pair(L'\U0001D539', UnicodeNameInfo(L"Bopf")),
-    make_pair(L'\U0001D53B', UnicodeNameInfo(L"Dopf")),
-    make_pair(L'\U0001D53C', UnicodeNameInfo(L"Eopf")),
-    make_pair(L'\U0001D53D', UnicodeNameInfo(L"Fopf")),
-    make_pair(L'\U0001D53E', UnicodeNameInfo(L"Gopf")),
-    make_pair(L'\U0001D540', UnicodeNameInfo(L"Iopf")),
-    make_pair(L'\U0001D541', UnicodeNameInfo(L"Jopf")),
-    make_pair(L'\U0001D542', UnicodeNameInfo(L"Kopf")),
-    make_pair(L'\U0001D543', UnicodeNameInfo(L"Lopf")),
-    make_pair(L'\U0001D544', UnicodeNameInfo(L"Mopf")),
-    make_pair(L'\U0001D546', UnicodeNameInfo(L"Oopf")),
-    make_pair(L'\U0001D54A', UnicodeNameInfo(L"Sopf")),
-    make_pair(L'\U0001D54B', UnicodeNameInfo(L"Topf")),
-    make_pair(L'\U0001D54C', UnicodeNameInfo(L"Uopf")),
-    make_pair(L'\U0001D54D', UnicodeNameInfo(L"Vopf")),
-    make_pair(L'\U0001D54E', UnicodeNameInfo(L"Wopf")),
-    make_pair(L'\U0001D54F', UnicodeNameInfo(L"Xopf")),
-    make_pair(L'\U0001D550', UnicodeNameInfo(L"Yopf")),
-    make_pair(L'\U0001D55C', UnicodeNameInfo(L"kopf")),
-    make_pair(L'\U0001D6A5', UnicodeNameInfo())
+    {L'\U000003D6', L"piv", L"varpi"},
+    {L'\U000003DD', L"gammad", L"digamma"},
+    {L'\U000003F0', L"kappav", L"varkappa"},
+    {L'\U000003F1', L"rhov", L"varrho"},
+    {L'\U000003F5', L"epsi", L"straightepsilon"},
+    {L'\U000003F6', L"bepsi", L"backepsilon"},
+    {L'\U00002020', L"dagger", NULL},
+    {L'\U00002021', L"Dagger", L"ddagger"},
+    {L'\U00002022', L"bull", L"bullet"},
+    {L'\U00002026', L"hellip", NULL},
+    {L'\U00002032', L"prime", NULL},
+    {L'\U00002035', L"bprime", L"backprime"},
+    {L'\U00002102', L"Copf", L"complexes"},
+    {L'\U0000210B', L"Hscr", L"HilbertSpace"},
+    {L'\U0000210C', L"Hfr", L"Poincareplane"},
+    {L'\U0000210D', L"Hopf", L"quaternions"},
+    {L'\U0000210F', L"hbar", L"planck"},
+    {L'\U00002110', L"Iscr", L"imagline"},
+    {L'\U00002111', L"Im", L"imagpart"},
+    {L'\U00002112', L"Lscr", L"Laplacetrf"},
+    {L'\U00002113', L"ell", NULL},
+    {L'\U00002118', L"wp", L"weierp"},
+    {L'\U00002119', L"Popf", L"primes"},
+    {L'\U0000211A', L"Qopf", L"rationals"},
+    {L'\U0000211B', L"Rscr", L"realine"},
+    {L'\U0000211C', L"Re", L"realpart"},
+    {L'\U0000211D', L"Ropf", L"reals"},
+    {L'\U00002124', L"Zopf", L"integers"},
+    {L'\U00002127', L"mho", NULL},
+    {L'\U00002128', L"Zfr", L"zeetrf"},
+    {L'\U0000212C', L"Bscr", L"Bernoullis"},
+    {L'\U0000212D', L"Cfr", L"Cayleys"},
+    {L'\U00002130', L"Escr", L"expectation"},
+    {L'\U00002131', L"Fscr", L"Fouriertrf"},
+    {L'\U00002133', L"Mscr", L"Mellintrf"},
+    {L'\U00002135', L"aleph", NULL},
+    {L'\U00002136', L"beth", NULL},
+    {L'\U00002137', L"gimel", NULL},
+    {L'\U00002138', L"daleth", NULL},
+    {L'\U00002190', L"larr", L"LeftArrow"},
+    {L'\U00002191', L"uarr", L"UpArrow"},
+    {L'\U00002192', L"rarr", L"RightArrow"},
+    {L'\U00002193', L"darr", L"DownArrow"},
+    {L'\U00002194', L"harr", L"LeftRightArrow"},
+    {L'\U00002195', L"varr", L"UpDownArrow"},
+    {L'\U00002196', L"nwarr", L"UpperLeftArrow"},
+    {L'\U00002197', L"nearr", L"UpperRightArrow"},
+    {L'\U00002198', L"searr", L"LowerRightArrow"},
+    {L'\U00002199', L"swarr", L"LowerLeftArrow"},
+    {L'\U0000219A', L"nlarr", L"nleftarrow"},
+    {L'\U0000219B', L"nrarr", L"nrightarrow"},
+    {L'\U0000219D', L"rarrw", L"rightsquigarrow"},
+    {L'\U0000219E', L"Larr", L"twoheadleftarrow"},
+    {L'\U000021A0', L"Rarr", L"twoheadrightarrow"},
+    {L'\U000021A2', L"larrtl", L"leftarrowtail"},
+    {L'\U000021A3', L"rarrtl", L"rightarrowtail"},
+    {L'\U000021A6', L"map", L"RightTeeArrow"},
+    {L'\U000021A9', L"larrhk", L"hookleftarrow"},
+    {L'\U000021AA', L"rarrhk", L"hookrightarrow"},
+    {L'\U000021AB', L"larrlp", L"looparrowleft"},
+    {L'\U000021AC', L"rarrlp", L"looparrowright"},
+    {L'\U000021AD', L"harrw", L"leftrightsquigarrow"},
+    {L'\U000021AE', L"nharr", L"nleftrightarrow"},
+    {L'\U000021B0', L"lsh", L"Lsh"},
+    {L'\U000021B1', L"rsh", L"Rsh"},
+    {L'\U000021B6', L"cularr", L"curvearrowleft"},
+    {L'\U000021B7', L"curarr", L"curvearrowright"},
+    {L'\U000021BA', L"olarr", L"circlearrowleft"},
+    {L'\U000021BB', L"orarr", L"circlearrowright"},
+    {L'\U000021BC', L"lharu", L"leftharpoonup"},
+    {L'\U000021BD', L"lhard", L"leftharpoondown"},
+    {L'\U000021BE', L"uharr", L"upharpoonright"},
+    {L'\U000021BF', L"uharl", L"upharpoonleft"},
+    {L'\U000021C0', L"rharu", L"rightharpoonup"},
+    {L'\U000021C1', L"rhard", L"rightharpoondown"},
+    {L'\U000021C2', L"dharr", L"downharpoonright"},
+    {L'\U000021C3', L"dharl", L"downharpoonleft"},
+    {L'\U000021C4', L"rlarr", L"RightArrowLeftArrow"},
+    {L'\U000021C6', L"lrarr", L"LeftArrowRightArrow"},
+    {L'\U000021C7', L"llarr", L"leftleftarrows"},
+    {L'\U000021C8', L"uuarr", L"upuparrows"},
+    {L'\U000021C9', L"rrarr", L"rightrightarrows"},
+    {L'\U000021CA', L"ddarr", L"downdownarrows"},
+    {L'\U000021CB', L"lrhar", L"ReverseEquilibrium"},
+    {L'\U000021CC', L"rlhar", L"Equilibrium"},
+    {L'\U000021CD', L"nlArr", L"nLeftarrow"},
+    {L'\U000021CE', L"nhArr", L"nLeftrightarrow"},
+    {L'\U000021CF', L"nrArr", L"nRightarrow"},
+    {L'\U000021D0', L"lArr", L"DoubleLeftArrow"},
+    {L'\U000021D1', L"uArr", L"DoubleUpArrow"},
+    {L'\U000021D2', L"rArr", L"DoubleRightArrow"},
+    {L'\U000021D3', L"dArr", L"DoubleDownArrow"},
+    {L'\U000021D4', L"hArr", L"DoubleLeftRightArrow"},
+    {L'\U000021D5', L"vArr", L"DoubleUpDownArrow"},
+    {L'\U000021DA', L"lAarr", L"Lleftarrow"},
+    {L'\U000021DB', L"rAarr", L"Rrightarrow"},
+    {L'\U000021DD', L"zigrarr", NULL},
+    {L'\U00002200', L"forall", L"ForAll"},
+    {L'\U00002201', L"comp", L"complement"},
+    {L'\U00002202', L"part", L"PartialD"},
+    {L'\U00002203', L"exist", L"Exists"},
+    {L'\U00002204', L"nexist", L"NotExists"},
+    {L'\U00002205', L"empty", L"emptyset"},
+    {L'\U00002207', L"nabla", L"Del"},
+    {L'\U00002208', L"in", L"Element"},
+    {L'\U00002209', L"notin", L"NotElement"},
+    {L'\U0000220B', L"ni", L"ReverseElement"},
+    {L'\U0000220C', L"notni", L"NotReverseElement"},
+    {L'\U0000220F', L"prod", L"Product"},
+    {L'\U00002210', L"coprod", L"Coproduct"},
+    {L'\U00002211', L"sum", L"Sum"},
+    {L'\U00002213', L"mp", L"MinusPlus"},
+    {L'\U00002214', L"dotplus", NULL},
+    {L'\U00002216', L"setmn", L"Backslash"},
+    {L'\U00002218', L"compfn", L"SmallCircle"},
+    {L'\U0000221A', L"radic", L"Sqrt"},
+    {L'\U0000221D', L"prop", L"Proportional"},
+    {L'\U0000221E', L"infin", NULL},
+    {L'\U00002220', L"ang", L"angle"},
+    {L'\U00002221', L"angmsd", L"measuredangle"},
+    {L'\U00002222', L"angsph", NULL},
+    {L'\U00002223', L"mid", L"VerticalBar"},
+    {L'\U00002224', L"nmid", L"NotVerticalBar"},
+    {L'\U00002225', L"par", L"DoubleVerticalBar"},
+    {L'\U00002226', L"npar", L"NotDoubleVerticalBar"},
+    {L'\U00002227', L"and", L"wedge"},
+    {L'\U00002228', L"or", L"vee"},
+    {L'\U00002229', L"cap", NULL},
+    {L'\U0000222A', L"cup", NULL},
+    {L'\U0000222B', L"int", L"Integral"},
+    {L'\U0000222C', L"Int", NULL},
+    {L'\U0000222D', L"tint", L"iiint"},
+    {L'\U0000222E', L"conint", L"ContourIntegral"},
+    {L'\U00002234', L"there4", L"Therefore"},
+    {L'\U00002235', L"becaus", L"Because"},
+    {L'\U0000223C', L"sim", L"Tilde"},
+    {L'\U0000223D', L"bsim", L"backsim"},
+    {L'\U00002240', L"wr", L"VerticalTilde"},
+    {L'\U00002241', L"nsim", L"NotTilde"},
+    {L'\U00002242', L"esim", L"EqualTilde"},
+    {L'\U00002243', L"sime", L"TildeEqual"},
+    {L'\U00002244', L"nsime", L"NotTildeEqual"},
+    {L'\U00002245', L"cong", L"TildeFullEqual"},
+    {L'\U00002247', L"ncong", L"NotTildeFullEqual"},
+    {L'\U00002248', L"ap", L"TildeTilde"},
+    {L'\U00002249', L"nap", L"NotTildeTilde"},
+    {L'\U0000224A', L"ape", L"approxeq"},
+    {L'\U0000224E', L"bump", L"HumpDownHump"},
+    {L'\U0000224F', L"nbump", L"NotHumpDownHump"},
+    {L'\U00002250', L"esdot", L"DotEqual"},
+    {L'\U00002251', L"eDot", L"doteqdot"},
+    {L'\U00002252', L"efDot", L"fallingdotseq"},
+    {L'\U00002253', L"erDot", L"risingdotseq"},
+    {L'\U00002256', L"ecir", L"eqcirc"},
+    {L'\U00002257', L"cire", L"circeq"},
+    {L'\U0000225C', L"trie", L"triangleq"},
+    {L'\U00002260', L"ne", L"NotEqual"},
+    {L'\U00002261', L"equiv", L"Congruent"},
+    {L'\U00002262', L"nequiv", L"NotCongruent"},
+    {L'\U00002264', L"le", L"leq"},
+    {L'\U00002265', L"ge", L"GreaterEqual"},
+    {L'\U00002266', L"lE", L"LessFullEqual"},
+    {L'\U00002267', L"gE", L"GreaterFullEqual"},
+    {L'\U00002268', L"lnE", L"lneqq"},
+    {L'\U00002269', L"gnE", L"gneqq"},
+    {L'\U0000226A', L"Lt", L"NestedLessLess"},
+    {L'\U0000226B', L"Gt", L"NestedGreaterGreater"},
+    {L'\U0000226C', L"twixt", L"between"},
+    {L'\U0000226E', L"nlt", L"NotLess"},
+    {L'\U0000226F', L"ngt", L"NotGreater"},
+    {L'\U00002270', L"nle", L"NotLessEqual"},
+    {L'\U00002271', L"nge", L"NotGreaterEqual"},
+    {L'\U00002272', L"lsim", L"LessTilde"},
+    {L'\U00002273', L"gsim", L"GreaterTilde"},
+    {L'\U00002276', L"lg", L"LessGreater"},
+    {L'\U00002277', L"gl", L"GreaterLess"},
+    {L'\U0000227A', L"pr", L"Precedes"},
+    {L'\U0000227B', L"sc", L"Succeeds"},
+    {L'\U0000227C', L"prcue", L"PrecedesSlantEqual"},
+    {L'\U0000227D', L"sccue", L"SucceedsSlantEqual"},
+    {L'\U0000227E', L"prsim", L"PrecedesTilde"},
+    {L'\U0000227F', L"scsim", L"SucceedsTilde"},
+    {L'\U00002280', L"npr", L"NotPrecedes"},
+    {L'\U00002281', L"nsc", L"NotSucceeds"},
+    {L'\U00002282', L"sub", L"subset"},
+    {L'\U00002283', L"sup", L"supset"},
+    {L'\U00002284', L"nsub", NULL},
+    {L'\U00002285', L"nsup", NULL},
+    {L'\U00002286', L"sube", L"SubsetEqual"},
+    {L'\U00002287', L"supe", L"SupersetEqual"},
+    {L'\U00002288', L"nsube", L"NotSubsetEqual"},
+    {L'\U00002289', L"nsupe", L"NotSupersetEqual"},
+    {L'\U0000228A', L"subne", L"subsetneq"},
+    {L'\U0000228B', L"supne", L"supsetneq"},
+    {L'\U0000228E', L"uplus", L"UnionPlus"},
+    {L'\U0000228F', L"sqsub", L"SquareSubset"},
+    {L'\U00002290', L"sqsup", L"SquareSuperset"},
+    {L'\U00002291', L"sqsube", L"SquareSubsetEqual"},
+    {L'\U00002292', L"sqsupe", L"SquareSupersetEqual"},
+    {L'\U00002293', L"sqcap", L"SquareIntersection"},
+    {L'\U00002294', L"sqcup", L"SquareUnion"},
+    {L'\U00002295', L"oplus", L"CirclePlus"},
+    {L'\U00002296', L"ominus", L"CircleMinus"},
+    {L'\U00002297', L"otimes", L"CircleTimes"},
+    {L'\U00002298', L"osol", NULL},
+    {L'\U00002299', L"odot", L"CircleDot"},
+    {L'\U0000229A', L"ocir", L"circledcirc"},
+    {L'\U0000229B', L"oast", L"circledast"},
+    {L'\U0000229D', L"odash", L"circleddash"},
+    {L'\U0000229E', L"plusb", L"boxplus"},
+    {L'\U0000229F', L"minusb", L"boxminus"},
+    {L'\U000022A0', L"timesb", L"boxtimes"},
+    {L'\U000022A1', L"sdotb", L"dotsquare"},
+    {L'\U000022A2', L"vdash", L"RightTee"},
+    {L'\U000022A3', L"dashv", L"LeftTee"},
+    {L'\U000022A4', L"top", L"DownTee"},
+    {L'\U000022A5', L"bot", L"UpTee"},
+    {L'\U000022A7', L"models", NULL},
+    {L'\U000022A8', L"vDash", L"DoubleRightTee"},
+    {L'\U000022A9', L"Vdash", NULL},
+    {L'\U000022AA', L"Vvdash", NULL},
+    {L'\U000022AC', L"nvdash", NULL},
+    {L'\U000022AD', L"nvDash", NULL},
+    {L'\U000022AE', L"nVdash", NULL},
+    {L'\U000022AF', L"nVDash", NULL},
+    {L'\U000022B2', L"vltri", L"LeftTriangle"},
+    {L'\U000022B3', L"vrtri", L"RightTriangle"},
+    {L'\U000022B4', L"ltrie", L"LeftTriangleEqual"},
+    {L'\U000022B5', L"rtrie", L"RightTriangleEqual"},
+    {L'\U000022B8', L"mumap", L"multimap"},
+    {L'\U000022BA', L"intcal", L"intercal"},
+    {L'\U000022BB', L"veebar", NULL},
+    {L'\U000022C0', L"xwedge", L"Wedge"},
+    {L'\U000022C1', L"xvee", L"Vee"},
+    {L'\U000022C2', L"xcap", L"Intersection"},
+    {L'\U000022C3', L"xcup", L"Union"},
+    {L'\U000022C4', L"diam", L"Diamond"},
+    {L'\U000022C5', L"sdot", NULL},
+    {L'\U000022C6', L"Star", NULL},
+    {L'\U000022C7', L"divonx", L"divideontimes"},
+    {L'\U000022C8', L"bowtie", NULL},
+    {L'\U000022C9', L"ltimes", NULL},
+    {L'\U000022CA', L"rtimes", NULL},
+    {L'\U000022CB', L"lthree", L"leftthreetimes"},
+    {L'\U000022CC', L"rthree", L"rightthreetimes"},
+    {L'\U000022CD', L"bsime", L"backsimeq"},
+    {L'\U000022CE', L"cuvee", L"curlyvee"},
+    {L'\U000022CF', L"cuwed", L"curlywedge"},
+    {L'\U000022D0', L"Sub", L"Subset"},
+    {L'\U000022D1', L"Sup", L"Supset"},
+    {L'\U000022D2', L"Cap", NULL},
+    {L'\U000022D3', L"Cup", NULL},
+    {L'\U000022D4', L"fork", L"pitchfork"},
+    {L'\U000022D6', L"ltdot", L"lessdot"},
+    {L'\U000022D7', L"gtdot", L"gtrdot"},
+    {L'\U000022D8', L"Ll", NULL},
+    {L'\U000022D9', L"Gg", NULL},
+    {L'\U000022DA', L"leg", L"LessEqualGreater"},
+    {L'\U000022DB', L"gel", L"GreaterEqualLess"},
+    {L'\U000022DE', L"cuepr", L"curlyeqprec"},
+    {L'\U000022DF', L"cuesc", L"curlyeqsucc"},
+    {L'\U000022E2', L"nsqsube", L"NotSquareSubsetEqual"},
+    {L'\U000022E3', L"nsqsupe", L"NotSquareSupersetEqual"},
+    {L'\U000022E6', L"lnsim", NULL},
+    {L'\U000022E7', L"gnsim", NULL},
+    {L'\U000022E8', L"prnsim", L"precnsim"},
+    {L'\U000022E9', L"scnsim", L"succnsim"},
+    {L'\U000022EA', L"nltri", L"NotLeftTriangle"},
+    {L'\U000022EB', L"nrtri", L"NotRightTriangle"},
+    {L'\U000022EC', L"nltrie", L"NotLeftTriangleEqual"},
+    {L'\U000022ED', L"nrtrie", L"NotRightTriangleEqual"},
+    {L'\U000022EE', L"vellip", NULL},
+    {L'\U000022EF', L"ctdot", NULL},
+    {L'\U000022F1', L"dtdot", NULL},
+    {L'\U00002305', L"barwed", L"barwedge"},
+    {L'\U00002306', L"Barwed", L"doublebarwedge"},
+    {L'\U00002308', L"lceil", L"LeftCeiling"},
+    {L'\U00002309', L"rceil", L"RightCeiling"},
+    {L'\U0000230A', L"lfloor", L"LeftFloor"},
+    {L'\U0000230B', L"rfloor", L"RightFloor"},
+    {L'\U0000231C', L"ulcorn", L"ulcorner"},
+    {L'\U0000231D', L"urcorn", L"urcorner"},
+    {L'\U0000231E', L"dlcorn", L"llcorner"},
+    {L'\U0000231F', L"drcorn", L"lrcorner"},
+    {L'\U00002322', L"frown", L"sfrown"},
+    {L'\U00002323', L"smile", L"ssmile"},
+    {L'\U00002329', L"lang", L"LeftAngleBracket"},
+    {L'\U0000232A', L"rang", L"RightAngleBracket"},
+    {L'\U000023B5', L"bbrk", L"UnderBracket"},
+    {L'\U000024C8', L"oS", L"circledS"},
+    {L'\U000025A1', L"squ", L"Square"},
+    {L'\U000025B3', L"xutri", L"bigtriangleup"},
+    {L'\U000025B4', L"utrif", L"blacktriangle"},
+    {L'\U000025B5', L"utri", L"triangle"},
+    {L'\U000025B6', NULL, NULL},
+    {L'\U000025B9', L"rtri", L"triangleright"},
+    {L'\U000025BD', L"xdtri", L"bigtriangledown"},
+    {L'\U000025BE', L"dtrif", L"blacktriangledown"},
+    {L'\U000025BF', L"dtri", L"triangledown"},
+    {L'\U000025C0', NULL, NULL},
+    {L'\U000025C3', L"ltri", L"triangleleft"},
+    {L'\U000025CA', L"loz", L"lozenge"},
+    {L'\U000025EF', L"xcirc", L"bigcirc"},
+    {L'\U000025FC', L"FilledSmallSquare", NULL},
+    {L'\U00002605', L"starf", L"bigstar"},
+    {L'\U00002660', L"spades", L"spadesuit"},
+    {L'\U00002663', L"clubs", L"clubsuit"},
+    {L'\U00002665', L"hearts", L"heartsuit"},
+    {L'\U00002666', L"diams", L"diamondsuit"},
+    {L'\U0000266D', L"flat", NULL},
+    {L'\U0000266E', L"natur", L"natural"},
+    {L'\U0000266F', L"sharp", NULL},
+    {L'\U00002713', L"check", L"checkmark"},
+    {L'\U00002720', L"malt", L"maltese"},
+    {L'\U000027F5', L"xlarr", L"LongLeftArrow"},
+    {L'\U000027F6', L"xrarr", L"LongRightArrow"},
+    {L'\U000027F7', L"xharr", L"LongLeftRightArrow"},
+    {L'\U000027F8', L"xlArr", L"DoubleLongLeftArrow"},
+    {L'\U000027F9', L"xrArr", L"DoubleLongRightArrow"},
+    {L'\U000027FA', L"xhArr", L"DoubleLongLeftRightArrow"},
+    {L'\U000027FC', L"xmap", L"longMapsto"},
+    {L'\U0000290E', L"lBarr", NULL},
+    {L'\U0000290F', L"rBarr", L"dbkarow"},
+    {L'\U000029EB', L"lozf", L"blacklozenge"},
+    {L'\U00002A00', L"xodot", L"bigodot"},
+    {L'\U00002A01', L"xoplus", L"bigoplus"},
+    {L'\U00002A02', L"xotime", L"bigotimes"},
+    {L'\U00002A04', L"xuplus", L"biguplus"},
+    {L'\U00002A06', L"xsqcup", L"bigsqcup"},
+    {L'\U00002A0C', L"qint", L"iiiint"},
+    {L'\U00002A2F', L"Cross", NULL},
+    {L'\U00002A3F', L"amalg", NULL},
+    {L'\U00002A7D', L"les", L"LessSlantEqual"},
+    {L'\U00002A7E', L"ges", L"GreaterSlantEqual"},
+    {L'\U00002A85', L"lap", L"lessapprox"},
+    {L'\U00002A86', L"gap", L"gtrapprox"},
+    {L'\U00002A89', L"lnap", L"lnapprox"},
+    {L'\U00002A8A', L"gnap", L"gnapprox"},
+    {L'\U00002A8B', L"lEg", L"lesseqqgtr"},
+    {L'\U00002A8C', L"gEl", L"gtreqqless"},
+    {L'\U00002A95', L"els", L"eqslantless"},
+    {L'\U00002A96', L"egs", L"eqslantgtr"},
+    {L'\U00002AAF', L"pre", L"PrecedesEqual"},
+    {L'\U00002AB0', L"sce", L"SucceedsEqual"},
+    {L'\U00002AB5', L"prnE", L"precneqq"},
+    {L'\U00002AB6', L"scnE", L"succneqq"},
+    {L'\U00002AB7', L"prap", L"precapprox"},
+    {L'\U00002AB8', L"scap", L"succapprox"},
+    {L'\U00002AB9', L"prnap", L"precnapprox"},
+    {L'\U00002ABA', L"scnap", L"succnapprox"},
+    {L'\U00002AC5', L"subE", L"subseteqq"},
+    {L'\U00002AC6', L"supE", L"supseteqq"},
+    {L'\U00002ACB', L"subnE", L"subsetneqq"},
+    {L'\U00002ACC', L"supnE", L"supsetneqq"},
+    {L'\U0000FE00', NULL, NULL},        // FIX: think about this combining character...
+    {L'\U0000FE37', L"OverBrace", NULL},
+    {L'\U0000FE38', L"UnderBrace", NULL},
+    {L'\U0001D49C', L"Ascr", NULL},
+    {L'\U0001D49E', L"Cscr", NULL},
+    {L'\U0001D49F', L"Dscr", NULL},
+    {L'\U0001D4A2', L"Gscr", NULL},
+    {L'\U0001D4A5', L"Jscr", NULL},
+    {L'\U0001D4A6', L"Kscr", NULL},
+    {L'\U0001D4A9', L"Nscr", NULL},
+    {L'\U0001D4AA', L"Oscr", NULL},
+    {L'\U0001D4AB', L"Pscr", NULL},
+    {L'\U0001D4AC', L"Qscr", NULL},
+    {L'\U0001D4AE', L"Sscr", NULL},
+    {L'\U0001D4AF', L"Tscr", NULL},
+    {L'\U0001D4B0', L"Uscr", NULL},
+    {L'\U0001D4B1', L"Vscr", NULL},
+    {L'\U0001D4B2', L"Wscr", NULL},
+    {L'\U0001D4B3', L"Xscr", NULL},
+    {L'\U0001D4B4', L"Yscr", NULL},
+    {L'\U0001D4B5', L"Zscr", NULL},
+    {L'\U0001D4D0', NULL, NULL},    // mathematical bold script capitals
+    {L'\U0001D4D1', NULL, NULL},
+    {L'\U0001D4D2', NULL, NULL},
+    {L'\U0001D4D3', NULL, NULL},
+    {L'\U0001D4D4', NULL, NULL},
+    {L'\U0001D4D5', NULL, NULL},
+    {L'\U0001D4D6', NULL, NULL},
+    {L'\U0001D4D7', NULL, NULL},
+    {L'\U0001D4D8', NULL, NULL},
+    {L'\U0001D4D9', NULL, NULL},
+    {L'\U0001D4DA', NULL, NULL},
+    {L'\U0001D4DB', NULL, NULL},
+    {L'\U0001D4DC', NULL, NULL},
+    {L'\U0001D4DD', NULL, NULL},
+    {L'\U0001D4DE', NULL, NULL},
+    {L'\U0001D4DF', NULL, NULL},
+    {L'\U0001D4E0', NULL, NULL},
+    {L'\U0001D4E1', NULL, NULL},
+    {L'\U0001D4E2', NULL, NULL},
+    {L'\U0001D4E3', NULL, NULL},
+    {L'\U0001D4E4', NULL, NULL},
+    {L'\U0001D4E5', NULL, NULL},
+    {L'\U0001D4E6', NULL, NULL},
+    {L'\U0001D4E7', NULL, NULL},
+    {L'\U0001D4E8', NULL, NULL},
+    {L'\U0001D4E9', NULL, NULL},
+    {L'\U0001D504', L"Afr", NULL},
+    {L'\U0001D505', L"Bfr", NULL},
+    {L'\U0001D507', L"Dfr", NULL},
+    {L'\U0001D508', L"Efr", NULL},
+    {L'\U0001D509', L"Ffr", NULL},
+    {L'\U0001D50A', L"Gfr", NULL},
+    {L'\U0001D50D', L"Jfr", NULL},
+    {L'\U0001D50E', L"Kfr", NULL},
+    {L'\U0001D50F', L"Lfr", NULL},
+    {L'\U0001D510', L"Mfr", NULL},
+    {L'\U0001D511', L"Nfr", NULL},
+    {L'\U0001D512', L"Ofr", NULL},
+    {L'\U0001D513', L"Pfr", NULL},
+    {L'\U0001D514', L"Qfr", NULL},
+    {L'\U0001D516', L"Sfr", NULL},
+    {L'\U0001D517', L"Tfr", NULL},
+    {L'\U0001D518', L"Ufr", NULL},
+    {L'\U0001D519', L"Vfr", NULL},
+    {L'\U0001D51A', L"Wfr", NULL},
+    {L'\U0001D51B', L"Xfr", NULL},
+    {L'\U0001D51C', L"Yfr", NULL},
+    {L'\U0001D51E', L"afr", NULL},
+    {L'\U0001D51F', L"bfr", NULL},
+    {L'\U0001D520', L"cfr", NULL},
+    {L'\U0001D521', L"dfr", NULL},
+    {L'\U0001D522', L"efr", NULL},
+    {L'\U0001D523', L"ffr", NULL},
+    {L'\U0001D524', L"gfr", NULL},
+    {L'\U0001D525', L"hfr", NULL},
+    {L'\U0001D526', L"ifr", NULL},
+    {L'\U0001D527', L"jfr", NULL},
+    {L'\U0001D528', L"kfr", NULL},
+    {L'\U0001D529', L"lfr", NULL},
+    {L'\U0001D52A', L"mfr", NULL},
+    {L'\U0001D52B', L"nfr", NULL},
+    {L'\U0001D52C', L"ofr", NULL},
+    {L'\U0001D52D', L"pfr", NULL},
+    {L'\U0001D52E', L"qfr", NULL},
+    {L'\U0001D52F', L"rfr", NULL},
+    {L'\U0001D530', L"sfr", NULL},
+    {L'\U0001D531', L"tfr", NULL},
+    {L'\U0001D532', L"ufr", NULL},
+    {L'\U0001D533', L"vfr", NULL},
+    {L'\U0001D534', L"wfr", NULL},
+    {L'\U0001D535', L"xfr", NULL},
+    {L'\U0001D536', L"yfr", NULL},
+    {L'\U0001D537', L"zfr", NULL},
+    {L'\U0001D538', L"Aopf", NULL},
+    {L'\U0001D539', L"Bopf", NULL},
+    {L'\U0001D53B', L"Dopf", NULL},
+    {L'\U0001D53C', L"Eopf", NULL},
+    {L'\U0001D53D', L"Fopf", NULL},
+    {L'\U0001D53E', L"Gopf", NULL},
+    {L'\U0001D540', L"Iopf", NULL},
+    {L'\U0001D541', L"Jopf", NULL},
+    {L'\U0001D542', L"Kopf", NULL},
+    {L'\U0001D543', L"Lopf", NULL},
+    {L'\U0001D544', L"Mopf", NULL},
+    {L'\U0001D546', L"Oopf", NULL},
+    {L'\U0001D54A', L"Sopf", NULL},
+    {L'\U0001D54B', L"Topf", NULL},
+    {L'\U0001D54C', L"Uopf", NULL},
+    {L'\U0001D54D', L"Vopf", NULL},
+    {L'\U0001D54E', L"Wopf", NULL},
+    {L'\U0001D54F', L"Xopf", NULL},
+    {L'\U0001D550', L"Yopf", NULL},
+    {L'\U0001D55C', L"kopf", NULL},
+    {L'\U0001D6A5', NULL, NULL}
 };
 
-wishful_hash_map<wchar_t, UnicodeNameInfo> gUnicodeNameTable(
-    gUnicodeNameArray,
-    END_ARRAY(gUnicodeNameArray)
-);
-
-
 // FIX:
 // Need to read about and think about combining characters.
 // In particular, does the current strategy work for *named* entities
 // and combining characters? I'm not sure.
 
 
-// XmlEncode() handles conversion of non-ASCII characters to entities.
-// It uses the "options" parameter and gUnicodeNameTable to decide how to
-// translate each character.
-wstring XmlEncode(
+// RenderUtf8() and RenderNumericEntity() write "code" to "dest" (which
+// must have room for 16 bytes) as UTF-8 and as e.g. "&#x2329;"
+// respectively. They return the number of bytes written.
+size_t RenderUtf8(char* dest, unsigned code)
+{
+    if (code < 0x80)
+    {
+        dest[0] = static_cast<char>(code);
+        return 1;
+    }
+    if (code < 0x800)
+    {
+        dest[0] = static_cast<char>(0xC0 | (code >> 6));
+        dest[1] = static_cast<char>(0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000)
+    {
+        dest[0] = static_cast<char>(0xE0 | (code >> 12));
+        dest[1] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        dest[2] = static_cast<char>(0x80 | (code & 0x3F));
+        return 3;
+    }
+    dest[0] = static_cast<char>(0xF0 | (code >> 18));
+    dest[1] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+    dest[2] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    dest[3] = static_cast<char>(0x80 | (code & 0x3F));
+    return 4;
+}
+
+size_t RenderNumericEntity(char* dest, unsigned code)
+{
+    char digits[8];
+    int count = 0;
+    do
+    {
+        digits[count++] = "0123456789abcdef"[code & 0xF];
+        code >>= 4;
+    }
+    while (code);
+
+    char* start = dest;
+    *dest++ = '&';
+    *dest++ = '#';
+    *dest++ = 'x';
+    while (count)
+        *dest++ = digits[--count];
+    *dest++ = ';';
+    return dest - start;
+}
+
+// EncodedNameTable is a dense version of gUnicodeNameArray, built during
+// static initialisation, so that EncodeTo() finds a character with two
+// array lookups instead of a binary search.
+//
+// For each character it holds the complete output for every
+// MathmlEncoding, already rendered in UTF-8. The fallbacks between
+// encodings (e.g. "long" uses the short name, or failing that the numeric
+// entity, if the character has no long name) are resolved when the table
+// is built.
+class EncodedNameTable
+{
+public:
+    struct Entry
+    {
+        // Both indexed by EncodingOptions::MathmlEncoding. mOffset is a
+        // position in mText.
+        unsigned mOffset[4];
+        unsigned char mLength[4];
+    };
+
+    EncodedNameTable();
+
+    // Returns NULL if "code" isn't in gUnicodeNameArray.
+    const Entry* Find(unsigned code) const
+    {
+        unsigned page = code >> 8;
+        if (page >= mPageIndex.size())
+            return NULL;
+
+        unsigned short slot = mSlots[mPageIndex[page] << 8 | (code & 0xFF)];
+        return slot ? &mEntries[slot - 1] : NULL;
+    }
+
+    const char* GetText(const Entry& entry, int encoding) const
+    {
+        return mText.data() + entry.mOffset[encoding];
+    }
+
+private:
+    // mPageIndex[code >> 8] is the number of the block of 256 slots in
+    // mSlots that covers "code". Block zero stays empty; it stands for
+    // all the pages that have no names.
+    vector<unsigned char> mPageIndex;
+
+    // Each slot holds one plus an index into mEntries, or zero.
+    vector<unsigned short> mSlots;
+
+    vector<Entry> mEntries;
+    string mText;
+
+    void SetText(Entry& entry, int encoding, const char* text, size_t length);
+};
+
+void EncodedNameTable::SetText(
+    Entry& entry,
+    int encoding,
+    const char* text,
+    size_t length
+)
+{
+    entry.mOffset[encoding] = mText.size();
+    entry.mLength[encoding] = length;
+    mText.append(text, length);
+}
+
+EncodedNameTable::EncodedNameTable()
+{
+    const UnicodeNameInfo* begin = gUnicodeNameArray;
+    const UnicodeNameInfo* end = END_ARRAY(gUnicodeNameArray);
+
+    mPageIndex.resize(((end - 1)->mCode >> 8) + 1);
+    mSlots.resize(256);
+    mEntries.resize(end - begin);
+    mText.reserve(32 * (end - begin));
+
+    for (const UnicodeNameInfo* info = begin; info != end; info++)
+    {
+        // The size of mPageIndex above assumes the last entry has the
+        // largest code.
+        if (info != begin && info->mCode <= (info - 1)->mCode)
+            throw logic_error("gUnicodeNameArray is not sorted");
+
+        unsigned code = info->mCode;
+        unsigned page = code >> 8;
+        if (!mPageIndex[page])
+        {
+            if (mSlots.size() >> 8 > 0xFF)
+                throw logic_error("Too many pages in EncodedNameTable");
+            mPageIndex[page] = mSlots.size() >> 8;
+            mSlots.resize(mSlots.size() + 256);
+        }
+        mSlots[mPageIndex[page] << 8 | (code & 0xFF)] = info - begin + 1;
+
+        Entry& entry = mEntries[info - begin];
+        char buffer[16];
+
+        SetText(
+            entry,
+            EncodingOptions::cMathmlEncodingRaw,
+            buffer,
+            RenderUtf8(buffer, code)
+        );
+
+        SetText(
+            entry,
+            EncodingOptions::cMathmlEncodingNumeric,
+            buffer,
+            RenderNumericEntity(buffer, code)
+        );
+
+        // Short falls back on numeric, and long falls back on short.
+        const wchar_t* names[2] = {info->mShortName, info->mLongName};
+        for (int i = 0; i < 2; i++)
+        {
+            int encoding = EncodingOptions::cMathmlEncodingShort + i;
+            if (names[i])
+            {
+                string entity = "&";
+                for (const wchar_t* c = names[i]; *c; c++)
+                    entity += static_cast<char>(*c);
+                entity += ';';
+                SetText(entry, encoding, entity.data(), entity.size());
+            }
+            else
+            {
+                entry.mOffset[encoding] = entry.mOffset[encoding - 1];
+                entry.mLength[encoding] = entry.mLength[encoding - 1];
+            }
+        }
+    }
+}
+
+// The table is built on first use, rather than as a global, because
+// EncodedText objects in other files need it during static
+// initialisation.
+const EncodedNameTable& GetEncodedNameTable()
+{
+    static const EncodedNameTable table;
+    return table;
+}
+
+
+// GetPlane1Encoding() returns the encoding to use for named plane-1
+// characters. If plane 1 isn't allowed, blahtex falls back on the short
+// names rather than writing them directly or as numeric entities.
+int GetPlane1Encoding(const EncodingOptions& options)
+{
+    if (!options.mAllowPlane1 &&
+        (
+            options.mMathmlEncoding ==
+                EncodingOptions::cMathmlEncodingNumeric ||
+            options.mMathmlEncoding == EncodingOptions::cMathmlEncodingRaw
+        )
+    )
+        return EncodingOptions::cMathmlEncodingShort;
+
+    return options.mMathmlEncoding;
+}
+
+
+// CopyPlainText() narrows the longest run of characters starting at
+// "source" (but not past "end") that need no encoding at all, i.e. ASCII
+// other than "&", "<" and ">", into "dest". Returns the number of
+// characters copied. Most MathML text is like this (e.g. "x", "sin",
+// "2"), so the vectorised loop takes 16 characters at a time. (Like the
+// rest of the core, it assumes a 32-bit wchar_t; see Utf8.h.)
+size_t CopyPlainText(
+    const wchar_t* source,
+    const wchar_t* end,
+    unsigned char* dest
+)
+{
+    const wchar_t* start = source;
+
+#ifdef __SSE2__
+    const __m128i highBits = _mm_set1_epi32(~0x7F);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ampersand = _mm_set1_epi8('&');
+    const __m128i lessThan = _mm_set1_epi8('<');
+    const __m128i greaterThan = _mm_set1_epi8('>');
+    while (end - source >= 16)
+    {
+        const __m128i* chunk = reinterpret_cast<const __m128i*>(source);
+        __m128i a = _mm_loadu_si128(chunk);
+        __m128i b = _mm_loadu_si128(chunk + 1);
+        __m128i c = _mm_loadu_si128(chunk + 2);
+        __m128i d = _mm_loadu_si128(chunk + 3);
+
+        __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        if (_mm_movemask_epi8(
+            _mm_cmpeq_epi32(_mm_and_si128(any, highBits), zero)) != 0xFFFF
+        )
+            break;
+
+        // All values are below 0x80, so the saturating packs are exact,
+        // and the markup characters can be looked for a byte at a time.
+        __m128i bytes =
+            _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), bytes);
+
+        int markup = _mm_movemask_epi8(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(bytes, ampersand),
+                _mm_or_si128(
+                    _mm_cmpeq_epi8(bytes, lessThan),
+                    _mm_cmpeq_epi8(bytes, greaterThan)
+                )
+            )
+        );
+        if (markup)
+            return source - start + __builtin_ctz(markup);
+
+        source += 16;
+        dest += 16;
+    }
+#endif
+
+    while (source < end)
+    {
+        unsigned code = static_cast<unsigned>(*source);
+        if (code >= 0x80 || code == '&' || code == '<' || code == '>')
+            break;
+        *dest++ = static_cast<unsigned char>(code);
+        source++;
+    }
+
+    return source - start;
+}
+
+
+// Widens "length" ASCII characters onto the end of "output".
+inline void AppendAscii(wstring& output, const char* text, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+        output += static_cast<wchar_t>(text[i]);
+}
+
+
+// There are two versions of EncodeTo(), one for each version of
+// XmlEncode(). They convert the markup characters and non-ASCII
+// characters to entities, using the "options" parameter and
+// the EncodedNameTable to decide how to translate each character.
+
+void EncodeTo(
+    wstring& output,
     const wstring& input,
     const EncodingOptions& options
 )
 {
-    wostringstream os;
+    const EncodedNameTable& nameTable = GetEncodedNameTable();
+    int plane1Encoding = GetPlane1Encoding(options);
+
     for (wstring::const_iterator
         ptr = input.begin(); ptr != input.end(); ptr++
     )
     {
-        if (*ptr == L'&')
-            os << L"&amp;";
-        else if (*ptr == L'<')
-            os << L"&lt;";
-        else if (*ptr == L'>')
-            os << L"&gt;";
-        else if (*ptr <= 0x7F)
-            os << *ptr;
+        unsigned code = static_cast<unsigned>(*ptr);
+        if (code == '&')
+            output += L"&amp;";
+        else if (code == '<')
+            output += L"&lt;";
+        else if (code == '>')
+            output += L"&gt;";
+        else if (code < 0x80)
+            output += *ptr;
+        else if (const EncodedNameTable::Entry* entry =
+            nameTable.Find(code)
+        )
+        {
+            int encoding =
+                code >= 0x10000 ? plane1Encoding : options.mMathmlEncoding;
+
+            if (encoding == EncodingOptions::cMathmlEncodingRaw)
+                output += *ptr;
+            else
+                AppendAscii(
+                    output,
+                    nameTable.GetText(*entry, encoding),
+                    entry->mLength[encoding]
+                );
+        }
+        else if (options.mOtherEncodingRaw)
+            output += *ptr;
         else
         {
-            wishful_hash_map<wchar_t, UnicodeNameInfo>::const_iterator
-                search = gUnicodeNameTable.find(*ptr);
+            char buffer[16];
+            AppendAscii(output, buffer, RenderNumericEntity(buffer, code));
+        }
+    }
+}
 
-            if (search == gUnicodeNameTable.end())
+void EncodeTo(
+    string& output,
+    const wstring& input,
+    const EncodingOptions& options
+)
+{
+    const EncodedNameTable& nameTable = GetEncodedNameTable();
+    int plane1Encoding = GetPlane1Encoding(options);
+
+    const wchar_t* source = input.data();
+    const wchar_t* end = source + input.size();
+
+    while (source < end)
+    {
+        unsigned char buffer[256];
+
+        // Most MathML text is only a character or two long, so long runs
+        // of plain text are worth the detour through CopyPlainText() and
+        // a buffer (which is appended to "output" in one piece) only when
+        // there's enough input left.
+        if (end - source >= 16)
+        {
+            size_t count = CopyPlainText(
+                source,
+                end - source > 256 ? source + 256 : end,
+                buffer
+            );
+            if (count)
             {
-                if (options.mOtherEncodingRaw)
-                    os << *ptr;
-                else
-                    os << L"&#x" << hex
-                        << static_cast<unsigned>(*ptr) << L";";
+                output.append(reinterpret_cast<char*>(buffer), count);
+                source += count;
+                continue;
             }
-            else
-            {
-                EncodingOptions::MathmlEncoding encoding
-                    = options.mMathmlEncoding;
-
-                // Deal with plane-1 characters.
-                if (!options.mAllowPlane1 &&
-                    static_cast<unsigned>(*ptr) >= 0x10000 &&
-                    (
-                        encoding == EncodingOptions::cMathmlEncodingNumeric
-                        ||
-                        encoding == EncodingOptions::cMathmlEncodingRaw
-                    )
-                )
-                {
-                    encoding = EncodingOptions::cMathmlEncodingShort;
-                }
-
-                // Notice the missing "break"s in this switch statement.
-                // We are falling back on other encoding methods if certain
-                // ones aren't available.
-                switch (encoding)
-                {
-                    case EncodingOptions::cMathmlEncodingLong:
-                        if (!search->second.mLongName.empty())
-                        {
-                            os << L"&" << search->second.mLongName << L";";
-                            break;
-                        }
-
-                    case EncodingOptions::cMathmlEncodingShort:
-                        if (!search->second.mShortName.empty())
-                        {
-                            os << L"&" << search->second.mShortName << L";";
-                            break;
-                        }
-
-                    case EncodingOptions::cMathmlEncodingNumeric:
-                        os << L"&#x" << hex << static_cast<unsigned>(*ptr)
-                            << L";";
-                        break;
-
-                    case EncodingOptions::cMathmlEncodingRaw:
-                        os << *ptr;
-                        break;
-                }
+        }
 
-            }
+        unsigned code = static_cast<unsigned>(*source++);
+
+        if (code < 0x80 && code != '&' && code != '<' && code != '>')
+            output += static_cast<char>(code);
+        else if (code == '&')
+            output.append("&amp;", 5);
+        else if (code == '<')
+            output.append("&lt;", 4);
+        else if (code == '>')
+            output.append("&gt;", 4);
+        else if (const EncodedNameTable::Entry* entry =
+            nameTable.Find(code)
+        )
+        {
+            int encoding =
+                code >= 0x10000 ? plane1Encoding : options.mMathmlEncoding;
+            output.append(
+                nameTable.GetText(*entry, encoding),
+                entry->mLength[encoding]
+            );
+        }
+        else
+        {
+            char* text = reinterpret_cast<char*>(buffer);
+            output.append(
+                text,
+                options.mOtherEncodingRaw
+                    ? RenderUtf8(text, code)
+                    : RenderNumericEntity(text, code)
+            );
+        }
+    }
+}
+
+wstring XmlEncode(
+    const wstring& input,
+    const EncodingOptions& options
+)
+{
+    wstring output;
+    output.reserve(input.size());
+    EncodeTo(output, input, options);
+    return output;
+}
+
+void XmlEncode(
+    wstring& output,
+    const wstring& input,
+    const EncodingOptions& options
+)
+{
+    EncodeTo(output, input, options);
+}
+
+void XmlEncode(
+    string& output,
+    const wstring& input,
+    const EncodingOptions& options
+)
+{
+    EncodeTo(output, input, options);
+}
+
+
+// The encoded text of every EncodedText is kept in this one buffer, so
+// that building them costs a few allocations rather than one each.
+string& GetEncodedTextBuffer()
+{
+    static string buffer;
+    return buffer;
+}
+
+int EncodedText::GetCombination(const EncodingOptions& options)
+{
+    return options.mMathmlEncoding
+        | (options.mAllowPlane1 ? 4 : 0)
+        | (options.mOtherEncodingRaw ? 8 : 0);
+}
+
+EncodedText::EncodedText(const wstring& text)
+{
+    string& buffer = GetEncodedTextBuffer();
+    mBuffer = &buffer;
+
+    // Find out which options can affect this text at all. Most of the
+    // combinations then turn out to be the same as some other one, and
+    // only the distinct ones need encoding.
+    const EncodedNameTable& nameTable = GetEncodedNameTable();
+    bool hasName = false, hasPlane1Name = false, hasOther = false;
+    for (wstring::const_iterator ptr = text.begin(); ptr != text.end(); ptr++)
+    {
+        unsigned code = static_cast<unsigned>(*ptr);
+        if (code < 0x80)
+            continue;
+        if (nameTable.Find(code))
+        {
+            hasName = true;
+            if (code >= 0x10000)
+                hasPlane1Name = true;
         }
+        else
+            hasOther = true;
+    }
+
+    int same[cCombinationCount];
+    for (int combination = 0;
+        combination < cCombinationCount;
+        combination++
+    )
+    {
+        EncodingOptions options;
+        options.mMathmlEncoding =
+            static_cast<EncodingOptions::MathmlEncoding>(combination & 3);
+        options.mAllowPlane1 = !hasPlane1Name || (combination & 4);
+        options.mOtherEncodingRaw = hasOther && (combination & 8);
+        if (!hasName)
+            options.mMathmlEncoding = EncodingOptions::cMathmlEncodingRaw;
+
+        same[combination] = GetCombination(options);
+        if (same[combination] != combination)
+            continue;
+
+        mOffset[combination] = buffer.size();
+        XmlEncode(buffer, text, options);
+        if (buffer.size() - mOffset[combination] > 0xFF)
+            throw logic_error("Text too long in EncodedText::EncodedText");
+        mLength[combination] = buffer.size() - mOffset[combination];
     }
 
-    return os.str();
+    for (int combination = 0;
+        combination < cCombinationCount;
+        combination++
+    )
+    {
+        mOffset[combination] = mOffset[same[combination]];
+        mLength[combination] = mLength[same[combination]];
+    }
 }
 
 }
@@ -34,6 +34,50 @@ extern std::wstring XmlEncode(
     const EncodingOptions& options
 );
 
+// Same as above, but appends the result to "output".
+extern void XmlEncode(
+    std::wstring& output,
+    const std::wstring& input,
+    const EncodingOptions& options
+);
+
+// Same again, but appends the result to "output" in UTF-8.
+extern void XmlEncode(
+    std::string& output,
+    const std::wstring& input,
+    const EncodingOptions& options
+);
+
+// EncodedText holds the UTF-8 output of XmlEncode() for a fixed string,
+// worked out in advance for every combination of EncodingOptions. It is
+// used for the symbols in blahtex's built-in tables (see ParseTree2.cpp),
+// so that MathmlPrinter can write them out with a single append.
+//
+// EncodedText objects must only be constructed during static
+// initialisation, since they share a buffer that isn't protected against
+// use by other threads.
+class EncodedText
+{
+public:
+    explicit EncodedText(const std::wstring& text);
+
+    // GetCombination() numbers the combinations of EncodingOptions that
+    // affect XmlEncode(), from 0 to cCombinationCount - 1.
+    static const int cCombinationCount = 16;
+    static int GetCombination(const EncodingOptions& options);
+
+    void AppendTo(std::string& output, int combination) const
+    {
+        output.append(
+            mBuffer->data() + mOffset[combination], mLength[combination]
+        );
+    }
+
+private:
+    const std::string* mBuffer;
+    unsigned mOffset[cCombinationCount];
+    unsigned char mLength[cCombinationCount];
+};
 
 }
 
@@ -19,21 +19,11 @@
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
 #include "UnicodeConverter.h"
-#include <iostream>
+#include "BlahtexCore/Utf8.h"
 #include <stdexcept>
-#include <cerrno>
 
 using namespace std;
 
-UnicodeConverter::~UnicodeConverter()
-{
-    if (mIsOpen)
-    {
-        iconv_close(mInHandle);
-        iconv_close(mOutHandle);
-    }
-}
-
 void UnicodeConverter::Open()
 {
     if (mIsOpen)
@@ -41,75 +31,6 @@ void UnicodeConverter::Open()
             "UnicodeConverter::Open called on already open object"
         );
 
-    if (sizeof(wchar_t) != 4)
-        throw runtime_error(
-            "The wchar_t data type on this system is not four bytes wide"
-        );
-
-    // Determine endian-ness of wchar_t.
-    // (Really we should be able to just use "WCHAR_T". This unfortunately
-    // doesn't seem to available on darwin.)
-    wchar_t testChar = L'A';
-    const char* UcsString =
-        (*(reinterpret_cast<char*>(&testChar)) == 'A')
-            ? "UCS-4LE" : "UCS-4BE";
-
-    mInHandle = iconv_open(UcsString, "UTF-8");
-    if (mInHandle == (iconv_t)(-1))
-    {
-        switch (errno)
-        {
-            case EMFILE:
-                throw runtime_error(
-                    "iconv_open failed with errno == EMFILE"
-                );
-            case ENFILE:
-                throw runtime_error(
-                    "iconv_open failed with errno == ENFILE"
-                );
-            case ENOMEM:
-                throw runtime_error(
-                    "iconv_open failed with errno == ENOMEM"
-                );
-            case EINVAL:
-                throw runtime_error(
-                    "iconv_open failed with errno == EINVAL"
-                );
-            default:
-                throw runtime_error(
-                    "iconv_open failed with unknown error code"
-                );
-        }
-    }
-
-    mOutHandle = iconv_open("UTF-8", UcsString);
-    if (mOutHandle == (iconv_t)(-1))
-    {
-        switch (errno)
-        {
-            case EMFILE:
-                throw runtime_error(
-                    "iconv_open failed with errno == EMFILE"
-                );
-            case ENFILE:
-                throw runtime_error(
-                    "iconv_open failed with errno == ENFILE"
-                );
-            case ENOMEM:
-                throw runtime_error(
-                    "iconv_open failed with errno == ENOMEM"
-                );
-            case EINVAL:
-                throw runtime_error(
-                    "iconv_open failed with errno == EINVAL"
-                );
-            default:
-                throw runtime_error(
-                    "iconv_open failed with unknown error code"
-                );
-        }
-    }
-
     mIsOpen = true;
 }
 
@@ -121,52 +42,9 @@ wstring UnicodeConverter::ConvertIn(const string& input)
             "before UnicodeConverter::Open"
         );
 
-    char* inputBuf  = new char[input.size()];
-    memcpy(inputBuf, input.c_str(), input.size());
-
-    char* outputBuf = new char[input.size() * 4];
-
-    // The following garbage is needed to handle the unfortunate
-    // inconsistency between Linux and BSD definitions for the second
-    // parameter of iconv. BSD (including Mac OS X) requires const char*,
-    // whereas Linux requires char*, and neither option seems to produce
-    // error-free, warning-free compilation on both systems simultaneously.
-#ifdef BLAHTEX_ICONV_CONST
-    const
-#endif
-    char* source = inputBuf;
-    char* dest = outputBuf;
-
-    size_t  inBytesLeft = input.size();
-    size_t outBytesLeft = input.size() * 4;
-
-    if (iconv(
-        mInHandle,
-        &source,
-        &inBytesLeft,
-        &dest,
-        &outBytesLeft
-    ) == -1)
-    {
-        delete[] inputBuf;
-        delete[] outputBuf;
-        switch (errno)
-        {
-            case EILSEQ:
-            case EINVAL:    throw UnicodeConverter::Exception();
-            default:
-                throw logic_error(
-                    "Conversion problem in UnicodeConverter::ConvertIn"
-                );
-        }
-    }
-
-    wstring output(
-        reinterpret_cast<wchar_t*>(outputBuf),
-        input.size() - outBytesLeft / 4
-    );
-    delete[] inputBuf;
-    delete[] outputBuf;
+    wstring output;
+    if (!blahtex::DecodeUtf8(input, output))
+        throw UnicodeConverter::Exception();
     return output;
 }
 
@@ -178,44 +56,9 @@ string UnicodeConverter::ConvertOut(const wstring& input)
             "before UnicodeConverter::Open"
         );
 
-    wchar_t* inputBuf = new wchar_t[input.size()];
-    wmemcpy(inputBuf, input.c_str(), input.size());
-
-    char* outputBuf = new char[input.size() * 4];
-
-#ifdef BLAHTEX_ICONV_CONST
-    const
-#endif
-    char* source = reinterpret_cast<char*>(inputBuf);
-    char* dest = outputBuf;
-
-    size_t  inBytesLeft = input.size() * 4;
-    size_t outBytesLeft = input.size() * 4;
-
-    if (iconv(
-        mOutHandle,
-        &source,
-        &inBytesLeft,
-        &dest,
-        &outBytesLeft
-    ) == -1)
-    {
-        delete[] inputBuf;
-        delete[] outputBuf;
-        switch (errno)
-        {
-            case EILSEQ:
-            case EINVAL:    throw UnicodeConverter::Exception();
-            default:
-                throw logic_error(
-                    "Conversion problem in UnicodeConverter::ConvertIn"
-                );
-        }
-    }
-
-    string output(outputBuf, input.size() * 4 - outBytesLeft);
-    delete[] inputBuf;
-    delete[] outputBuf;
+    string output;
+    if (!blahtex::AppendUtf8(output, input))
+        throw UnicodeConverter::Exception();
     return output;
 }
 
@@ -22,13 +22,17 @@
 #define BLAHTEX_UNICODE_CONVERTER_H
 
 #include <string>
-#include <iconv.h>
 
-// UnicodeConverter handles all UTF8 <=> wchar_t conversions. It's
-// basically a wrapper for the iconv library in terms of
+// UnicodeConverter handles all UTF8 <=> wchar_t conversions, in terms of
 // - string (assumed to be in UTF-8) and
-// - wstring (in internal wchar_t format, which may be big-endian or
-// little-endian depending on platform).
+// - wstring (in internal wchar_t format, i.e. UCS-4 in native byte order).
+//
+// It is a thin wrapper around the functions in BlahtexCore/Utf8.h. Code
+// that only deals in UTF-8 may not need it at all: blahtex::Interface
+// accepts and returns UTF-8 directly (see Interface.h).
+//
+// Conversions don't modify the object, so once Open() has been called a
+// single UnicodeConverter may be used by several threads at once.
 class UnicodeConverter
 {
     public:
@@ -36,21 +40,16 @@ class UnicodeConverter
             mIsOpen(false)
         { }
 
-        ~UnicodeConverter();
-
         // Open() must be called before using this object.
-        //
-        // It will throw a std::runtime_error object if
-        // (1) we are running on a platform with less than 4 bytes
-        //     per wchar_t, or
-        // (2) an appropriate iconv_t converter object can't be created
         void Open();
 
         std::wstring ConvertIn(const std::string& input);
         std::string ConvertOut(const std::wstring& input);
 
         // The above 'ConvertIn' and 'ConvertOut' functions will throw this
-        // exception object if their input is invalid (e.g. invalid UTF-8).
+        // exception object if their input is invalid, i.e. invalid UTF-8
+        // (including overlong forms, surrogates and anything above
+        // U+10FFFF), or a wchar_t which isn't a valid Unicode character.
         // More serious problems report a std::logic_error.
         class Exception
         {
@@ -58,11 +57,6 @@ class UnicodeConverter
 
     private:
         bool mIsOpen;
-
-        // mOutHandle is the iconv object handling wchar_t => UTF-8,
-        // mInHandle does the other way.
-        iconv_t mOutHandle;
-        iconv_t mInHandle;
 };
 
 #endif
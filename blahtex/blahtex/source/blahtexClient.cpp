@@ -0,0 +1,260 @@
+// File "blahtexClient.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// blahtex-client is a small client for blahtexd.
+//
+// With no "--corpus" option, it sends standard input to the daemon as a
+// single request and prints the response, just like running blahtex
+// directly.
+//
+// With "--corpus file", it becomes a load generator: each of
+// "--connections" threads opens its own connection and sends every line
+// of the file (one formula per line) "--repeat" times, and at the end the
+// total throughput is reported.
+
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+string gSocketPath;
+string gOptions;
+vector<string> gCorpus;
+long gRepeat = 1;
+
+int Connect()
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (gSocketPath.size() >= sizeof(address.sun_path))
+        throw runtime_error("Socket path is too long");
+    strcpy(address.sun_path, gSocketPath.c_str());
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 ||
+        connect(fd, (sockaddr*) &address, sizeof(address)) != 0)
+        throw runtime_error("Cannot connect to " + gSocketPath);
+    return fd;
+}
+
+void WriteAll(int fd, const string& data)
+{
+    string::size_type pos = 0;
+    while (pos < data.size())
+    {
+        ssize_t count = write(fd, data.data() + pos, data.size() - pos);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            throw runtime_error("Write to blahtexd failed");
+        pos += count;
+    }
+}
+
+// Reads one framed response; "buffer" holds anything read beyond it.
+string ReadResponse(int fd, string& buffer)
+{
+    char chunk[65536];
+    string::size_type newline;
+    string::size_type length = 0;
+
+    while (true)
+    {
+        newline = buffer.find('\n');
+        if (newline != string::npos)
+        {
+            length = strtoul(buffer.c_str(), NULL, 10);
+            if (buffer.size() >= newline + 1 + length)
+                break;
+        }
+
+        ssize_t count = read(fd, chunk, sizeof(chunk));
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count <= 0)
+            throw runtime_error("blahtexd closed the connection");
+        buffer.append(chunk, count);
+    }
+
+    string response = buffer.substr(newline + 1, length);
+    buffer.erase(0, newline + 1 + length);
+    return response;
+}
+
+string MakeRequest(const string& input)
+{
+    ostringstream os;
+    os << gOptions.size() << " " << input.size() << "\n"
+        << gOptions << input;
+    return os.str();
+}
+
+void* LoadThread(void* arg)
+{
+    long& completed = *static_cast<long*>(arg);
+
+    try
+    {
+        int fd = Connect();
+        string buffer;
+
+        for (long r = 0; r < gRepeat; r++)
+            for (vector<string>::iterator
+                line = gCorpus.begin(); line != gCorpus.end(); line++
+            )
+            {
+                WriteAll(fd, MakeRequest(*line));
+                ReadResponse(fd, buffer);
+                completed++;
+            }
+
+        close(fd);
+    }
+    catch (std::runtime_error& e)
+    {
+        cerr << "blahtex-client: " << e.what() << endl;
+    }
+
+    return NULL;
+}
+
+void ShowUsage()
+{
+    cout << "\n"
+"Usage: blahtex-client --socket path [ --corpus file [ --connections n ]\n"
+"           [ --repeat n ] ] [ blahtex options ] < inputfile\n"
+"\n";
+    exit(0);
+}
+
+int main(int argc, char* const argv[])
+{
+    try
+    {
+        string corpusFile;
+        long connectionCount = 1;
+
+        for (int i = 1; i < argc; i++)
+        {
+            string arg(argv[i]);
+
+            if (arg == "--help")
+                ShowUsage();
+
+            else if (
+                arg == "--socket" || arg == "--corpus" ||
+                arg == "--connections" || arg == "--repeat"
+            )
+            {
+                if (++i == argc)
+                    throw runtime_error(
+                        "Missing string after \"" + arg + "\""
+                    );
+
+                if (arg == "--socket")
+                    gSocketPath = argv[i];
+                else if (arg == "--corpus")
+                    corpusFile = argv[i];
+                else if (arg == "--connections")
+                    connectionCount = atol(argv[i]);
+                else
+                    gRepeat = atol(argv[i]);
+            }
+
+            // Everything else is passed on to blahtexd.
+            else
+                gOptions += arg + "\n";
+        }
+
+        if (gSocketPath.empty())
+            ShowUsage();
+
+        if (corpusFile.empty())
+        {
+            ostringstream input;
+            input << cin.rdbuf();
+
+            int fd = Connect();
+            string buffer;
+            WriteAll(fd, MakeRequest(input.str()));
+            cout << ReadResponse(fd, buffer);
+            close(fd);
+            return 0;
+        }
+
+        ifstream corpus(corpusFile.c_str());
+        if (!corpus)
+            throw runtime_error("Cannot open " + corpusFile);
+        string line;
+        while (getline(corpus, line))
+            gCorpus.push_back(line);
+
+        if (connectionCount <= 0)
+            connectionCount = 1;
+
+        timeval start, finish;
+        gettimeofday(&start, NULL);
+
+        vector<pthread_t> threads(connectionCount);
+        vector<long> completed(connectionCount, 0);
+        for (long i = 0; i < connectionCount; i++)
+            if (pthread_create(
+                &threads[i], NULL, LoadThread, &completed[i]) != 0
+            )
+                throw runtime_error("Cannot create thread");
+
+        long total = 0;
+        for (long i = 0; i < connectionCount; i++)
+        {
+            pthread_join(threads[i], NULL);
+            total += completed[i];
+        }
+
+        gettimeofday(&finish, NULL);
+        double seconds = (finish.tv_sec - start.tv_sec)
+            + (finish.tv_usec - start.tv_usec) / 1e6;
+
+        cout << total << " requests in " << seconds << " seconds ("
+            << total / seconds << " requests/second)" << endl;
+    }
+
+    catch (std::runtime_error& e)
+    {
+        cerr << "blahtex-client: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
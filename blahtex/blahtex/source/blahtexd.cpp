@@ -0,0 +1,681 @@
+// File "blahtexd.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// blahtexd is a daemon which listens on a Unix domain socket and converts
+// requests from any number of clients. A single thread multiplexes all the
+// connections using epoll, and hands conversions to a fixed pool of worker
+// threads, each with its own blahtex::Interface.
+//
+// Requests and responses use exactly the same framing as "blahtex
+// --server" (see mainServer.h). A client may send several requests on one
+// connection; they are answered in order, one at a time. Clients that want
+// several conversions in flight at once should open several connections.
+
+#include "mainConvert.h"
+#include "mainServer.h"
+#include <pthread.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+// A Job is a single request travelling from the epoll thread to a worker
+// and back again.
+struct Job
+{
+    // Identifies the connection the response should be sent to. (We use an
+    // id rather than the file descriptor, since the client might hang up
+    // and the descriptor get reused while the job is still running.)
+    unsigned long mConnection;
+
+    std::string mOptions;
+    std::string mInput;
+    std::string mResponse;
+};
+
+// JobQueue is a simple blocking queue shared between threads.
+class JobQueue
+{
+    pthread_mutex_t mMutex;
+    pthread_cond_t mNotEmpty;
+    deque<Job*> mJobs;
+    bool mShutdown;
+
+public:
+    JobQueue() :
+        mShutdown(false)
+    {
+        pthread_mutex_init(&mMutex, NULL);
+        pthread_cond_init(&mNotEmpty, NULL);
+    }
+
+    ~JobQueue()
+    {
+        pthread_cond_destroy(&mNotEmpty);
+        pthread_mutex_destroy(&mMutex);
+    }
+
+    void Push(Job* job)
+    {
+        pthread_mutex_lock(&mMutex);
+        mJobs.push_back(job);
+        pthread_cond_signal(&mNotEmpty);
+        pthread_mutex_unlock(&mMutex);
+    }
+
+    // Waits for a job. Returns NULL once Shutdown() has been called.
+    Job* Pop()
+    {
+        pthread_mutex_lock(&mMutex);
+        while (mJobs.empty() && !mShutdown)
+            pthread_cond_wait(&mNotEmpty, &mMutex);
+        Job* job = NULL;
+        if (!mShutdown)
+        {
+            job = mJobs.front();
+            mJobs.pop_front();
+        }
+        pthread_mutex_unlock(&mMutex);
+        return job;
+    }
+
+    // Returns NULL immediately if there's nothing available.
+    Job* TryPop()
+    {
+        pthread_mutex_lock(&mMutex);
+        Job* job = NULL;
+        if (!mJobs.empty())
+        {
+            job = mJobs.front();
+            mJobs.pop_front();
+        }
+        pthread_mutex_unlock(&mMutex);
+        return job;
+    }
+
+    void Shutdown()
+    {
+        pthread_mutex_lock(&mMutex);
+        mShutdown = true;
+        pthread_cond_broadcast(&mNotEmpty);
+        pthread_mutex_unlock(&mMutex);
+    }
+};
+
+// Global state shared by the epoll thread and the workers.
+Settings gDefaultSettings;
+JobQueue gPendingJobs;
+JobQueue gFinishedJobs;
+
+// Workers write a byte to gWakePipe[1] whenever they finish a job, to wake
+// up epoll_wait. The signal handler uses gSignalPipe the same way.
+int gWakePipe[2];
+int gSignalPipe[2];
+
+void* WorkerThread(void*)
+{
+    blahtex::Interface interface;
+
+    while (Job* job = gPendingJobs.Pop())
+    {
+        try
+        {
+            HandleRequest(
+                gDefaultSettings,
+                job->mOptions,
+                job->mInput,
+                interface,
+                job->mResponse
+            );
+        }
+        catch (std::runtime_error& e)
+        {
+            job->mResponse =
+                string("blahtex runtime error: ") + e.what() + "\n";
+        }
+
+        // Anything else (e.g. std::bad_alloc) only costs this client its
+        // request; letting it escape would terminate the whole daemon.
+        catch (std::exception& e)
+        {
+            job->mResponse =
+                string("blahtex runtime error: ") + e.what() + "\n";
+        }
+        catch (...)
+        {
+            job->mResponse = "blahtex runtime error: unknown exception\n";
+        }
+
+        gFinishedJobs.Push(job);
+        char c = 0;
+        while (write(gWakePipe[1], &c, 1) < 0 && errno == EINTR)
+            ;
+    }
+
+    return NULL;
+}
+
+void HandleSignal(int)
+{
+    char c = 0;
+    write(gSignalPipe[1], &c, 1);
+}
+
+// Connection records the state of a single client connection.
+struct Connection
+{
+    int mFd;
+
+    // Bytes received but not yet handed to a worker.
+    string mInput;
+
+    // Bytes waiting to be sent, starting at mOutputPos.
+    string mOutput;
+    string::size_type mOutputPos;
+
+    // Set while one of this connection's requests is with a worker.
+    bool mBusy;
+
+    // Set once the client has stopped sending (or sent garbage); we close
+    // the connection as soon as everything owed to it has been sent.
+    bool mReadClosed;
+
+    Connection(int fd) :
+        mFd(fd),
+        mOutputPos(0),
+        mBusy(false),
+        mReadClosed(false)
+    { }
+};
+
+// The Server class runs the epoll loop.
+class Server
+{
+    int mEpoll;
+    int mListenFd;
+    unsigned long mNextId;
+    map<unsigned long, Connection*> mConnections;
+
+    void Watch(int fd, unsigned long id, unsigned events, int op);
+    void Accept();
+    void Read(unsigned long id);
+    void Dispatch(unsigned long id);
+    bool Flush(unsigned long id);
+    void Close(unsigned long id);
+    void CollectFinishedJobs();
+
+public:
+    Server(int listenFd);
+    void Run();
+};
+
+// Ids below this are reserved for the listening socket and the pipes.
+const unsigned long cFirstConnectionId = 16;
+const unsigned long cListenId = 1;
+const unsigned long cWakeId = 2;
+const unsigned long cSignalId = 3;
+
+void SetNonBlocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+Server::Server(int listenFd) :
+    mListenFd(listenFd),
+    mNextId(cFirstConnectionId)
+{
+    mEpoll = epoll_create(64);
+    if (mEpoll < 0)
+        throw runtime_error("epoll_create failed");
+
+    Watch(mListenFd, cListenId, EPOLLIN, EPOLL_CTL_ADD);
+    Watch(gWakePipe[0], cWakeId, EPOLLIN, EPOLL_CTL_ADD);
+    Watch(gSignalPipe[0], cSignalId, EPOLLIN, EPOLL_CTL_ADD);
+}
+
+void Server::Watch(int fd, unsigned long id, unsigned events, int op)
+{
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.u64 = id;
+    if (epoll_ctl(mEpoll, op, fd, &event) != 0)
+        throw runtime_error("epoll_ctl failed");
+}
+
+void Server::Accept()
+{
+    while (true)
+    {
+        int fd = accept(mListenFd, NULL, NULL);
+        if (fd < 0)
+            return;
+
+        SetNonBlocking(fd);
+        unsigned long id = mNextId++;
+        mConnections[id] = new Connection(fd);
+        Watch(fd, id, EPOLLIN, EPOLL_CTL_ADD);
+    }
+}
+
+// No complete request is longer than this: a header line of at most
+// cMaxRequestSize bytes (see Dispatch), its newline, and a body of at most
+// cMaxRequestSize bytes.
+const string::size_type cMaxBufferedInput = 2 * cMaxRequestSize + 1;
+
+// Read() takes whatever the client has sent, but only while none of its
+// requests is with a worker, and never more than one request's worth;
+// anything else stays in the socket until Dispatch() catches up, so that
+// a client can't make us buffer an unlimited amount of input.
+void Server::Read(unsigned long id)
+{
+    Connection* connection = mConnections[id];
+    char buffer[65536];
+
+    while (!connection->mBusy &&
+        connection->mInput.size() < cMaxBufferedInput
+    )
+    {
+        ssize_t count = read(connection->mFd, buffer, sizeof(buffer));
+        if (count > 0)
+            connection->mInput.append(buffer, count);
+        else if (count < 0 && errno == EINTR)
+            continue;
+        else
+        {
+            if (count == 0 || errno != EAGAIN)
+                connection->mReadClosed = true;
+            break;
+        }
+    }
+
+    Dispatch(id);
+}
+
+// Dispatch() sends any pending output, then hands the next complete
+// request on this connection to the workers (unless one is already
+// running), and closes the connection once there's nothing left to do.
+void Server::Dispatch(unsigned long id)
+{
+    Connection* connection = mConnections[id];
+
+    while (Flush(id) && !connection->mBusy)
+    {
+        string::size_type newline = connection->mInput.find('\n');
+        string::size_type optionsLength, inputLength;
+
+        if (newline == string::npos)
+        {
+            if (connection->mInput.size() > cMaxRequestSize)
+                newline = connection->mInput.size();
+            else
+            {
+                if (connection->mReadClosed)
+                    Close(id);
+                return;
+            }
+        }
+
+        if (newline == connection->mInput.size() ||
+            !ParseRequestHeader(
+                connection->mInput.substr(0, newline),
+                optionsLength,
+                inputLength
+            )
+        )
+        {
+            // We can't find the next request, so give up on this client
+            // after telling it why.
+            string message =
+                "blahtex: Malformed request header in server mode\n";
+            ostringstream os;
+            os << message.size() << "\n" << message;
+            connection->mOutput = os.str();
+            connection->mOutputPos = 0;
+            connection->mInput.clear();
+            connection->mReadClosed = true;
+            continue;
+        }
+
+        string::size_type total = newline + 1 + optionsLength + inputLength;
+        if (connection->mInput.size() < total)
+        {
+            if (connection->mReadClosed)
+                Close(id);
+            return;
+        }
+
+        Job* job = new Job;
+        job->mConnection = id;
+        job->mOptions = connection->mInput.substr(newline + 1, optionsLength);
+        job->mInput = connection->mInput.substr(
+            newline + 1 + optionsLength, inputLength
+        );
+        connection->mInput.erase(0, total);
+        connection->mBusy = true;
+        gPendingJobs.Push(job);
+    }
+}
+
+// Flush() writes as much pending output as the socket will take. Returns
+// true if everything has been sent, or false if the socket is full (or
+// the connection had to be closed).
+bool Server::Flush(unsigned long id)
+{
+    Connection* connection = mConnections[id];
+
+    while (connection->mOutputPos < connection->mOutput.size())
+    {
+        ssize_t count = write(
+            connection->mFd,
+            connection->mOutput.data() + connection->mOutputPos,
+            connection->mOutput.size() - connection->mOutputPos
+        );
+        if (count > 0)
+            connection->mOutputPos += count;
+        else if (count < 0 && errno == EINTR)
+            continue;
+        else if (count < 0 && errno == EAGAIN)
+        {
+            Watch(
+                connection->mFd,
+                id,
+                (connection->mReadClosed || connection->mBusy) ?
+                    EPOLLOUT : (EPOLLIN | EPOLLOUT),
+                EPOLL_CTL_MOD
+            );
+            return false;
+        }
+        else
+        {
+            Close(id);
+            return false;
+        }
+    }
+
+    connection->mOutput.clear();
+    connection->mOutputPos = 0;
+
+    // Once the client has stopped sending, we stop watching for input,
+    // otherwise epoll would keep reporting the end of file. We also stop
+    // while a request is with a worker (see Read); CollectFinishedJobs()
+    // calls Dispatch() again, which brings us back here, once it's done.
+    Watch(
+        connection->mFd,
+        id,
+        (connection->mReadClosed || connection->mBusy) ? 0 : EPOLLIN,
+        EPOLL_CTL_MOD
+    );
+    return true;
+}
+
+void Server::Close(unsigned long id)
+{
+    map<unsigned long, Connection*>::iterator
+        search = mConnections.find(id);
+    if (search == mConnections.end())
+        return;
+
+    // Closing the descriptor removes it from the epoll set too.
+    close(search->second->mFd);
+    delete search->second;
+    mConnections.erase(search);
+}
+
+void Server::CollectFinishedJobs()
+{
+    char buffer[256];
+    while (read(gWakePipe[0], buffer, sizeof(buffer)) > 0)
+        ;
+
+    while (Job* job = gFinishedJobs.TryPop())
+    {
+        map<unsigned long, Connection*>::iterator
+            search = mConnections.find(job->mConnection);
+
+        // The client may have hung up in the meantime.
+        if (search != mConnections.end())
+        {
+            Connection* connection = search->second;
+            char header[32];
+            snprintf(
+                header, sizeof(header), "%lu\n",
+                static_cast<unsigned long>(job->mResponse.size())
+            );
+            connection->mOutput.reserve(
+                strlen(header) + job->mResponse.size()
+            );
+            connection->mOutput = header;
+            connection->mOutput += job->mResponse;
+            connection->mOutputPos = 0;
+            connection->mBusy = false;
+            Dispatch(job->mConnection);
+        }
+
+        delete job;
+    }
+}
+
+void Server::Run()
+{
+    epoll_event events[64];
+
+    while (true)
+    {
+        int count = epoll_wait(mEpoll, events, 64, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw runtime_error("epoll_wait failed");
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            unsigned long id = events[i].data.u64;
+
+            if (id == cListenId)
+                Accept();
+
+            else if (id == cWakeId)
+                CollectFinishedJobs();
+
+            else if (id == cSignalId)
+                return;
+
+            else if (mConnections.count(id))
+            {
+                // The client has gone away completely; any job still
+                // running for it will be discarded when it finishes.
+                if (events[i].events & (EPOLLERR | EPOLLHUP))
+                    Close(id);
+
+                else if (events[i].events & EPOLLIN)
+                    Read(id);
+
+                else
+                    Dispatch(id);
+            }
+        }
+    }
+}
+
+void ShowUsage()
+{
+    cout << "\n"
+"Usage: blahtexd --socket path [ --threads n ] [ blahtex options ]\n"
+"\n"
+"Listens on the Unix domain socket \"path\" for requests in the format\n"
+"used by \"blahtex --server\". Any blahtex options given here become the\n"
+"defaults for every request.\n"
+"\n";
+    exit(0);
+}
+
+int main(int argc, char* const argv[])
+{
+    try
+    {
+        string socketPath;
+        long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+        vector<string> blahtexArgs;
+
+        for (int i = 1; i < argc; i++)
+        {
+            string arg(argv[i]);
+
+            if (arg == "--socket")
+            {
+                if (++i == argc)
+                    throw CommandLineException(
+                        "Missing string after \"--socket\""
+                    );
+                socketPath = argv[i];
+            }
+
+            else if (arg == "--threads")
+            {
+                if (++i == argc)
+                    throw CommandLineException(
+                        "Missing string after \"--threads\""
+                    );
+                threadCount = atol(argv[i]);
+                if (threadCount <= 0)
+                    throw CommandLineException(
+                        "Illegal string after \"--threads\""
+                    );
+            }
+
+            else
+                blahtexArgs.push_back(arg);
+        }
+
+        ParseOptions(blahtexArgs, gDefaultSettings);
+        if (gDefaultSettings.mShowUsage || socketPath.empty())
+            ShowUsage();
+        if (gDefaultSettings.mServer || gDefaultSettings.mPrintErrorMessages
+            || !gDefaultSettings.mBatchFile.empty()
+            || gDefaultSettings.mShowCacheStatistics
+        )
+            throw CommandLineException(
+                "Option not available in blahtexd"
+            );
+        if (threadCount <= 0)
+            threadCount = 1;
+
+        ResultCache cache;
+        if (!gDefaultSettings.mCacheFile.empty())
+        {
+            cache.Open(
+                gDefaultSettings.mCacheFile, gDefaultSettings.mCacheSize
+            );
+            gDefaultSettings.mCache = &cache;
+        }
+        auto_ptr<MemoryCache> memoryCache;
+        if (gDefaultSettings.mMemoryCacheSize)
+        {
+            memoryCache.reset(
+                new MemoryCache(gDefaultSettings.mMemoryCacheSize)
+            );
+            gDefaultSettings.mMemoryCache = memoryCache.get();
+        }
+
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path))
+            throw CommandLineException("Socket path is too long");
+        strcpy(address.sun_path, socketPath.c_str());
+
+        int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0)
+            throw runtime_error("Cannot create socket");
+        unlink(socketPath.c_str());
+
+        // Only our own user may connect: a request can ask for any input
+        // to be converted, and files to be written in the PNG directory.
+        mode_t oldUmask = umask(0177);
+        int bindResult =
+            bind(listenFd, (sockaddr*) &address, sizeof(address));
+        umask(oldUmask);
+        if (bindResult != 0)
+            throw runtime_error("Cannot bind to " + socketPath);
+        if (listen(listenFd, SOMAXCONN) != 0)
+            throw runtime_error("Cannot listen on " + socketPath);
+        SetNonBlocking(listenFd);
+
+        if (pipe(gWakePipe) != 0 || pipe(gSignalPipe) != 0)
+            throw runtime_error("Cannot create pipe");
+        SetNonBlocking(gWakePipe[0]);
+        SetNonBlocking(gSignalPipe[0]);
+        SetNonBlocking(gSignalPipe[1]);
+
+        signal(SIGPIPE, SIG_IGN);
+        signal(SIGINT, HandleSignal);
+        signal(SIGTERM, HandleSignal);
+
+        Server server(listenFd);
+
+        vector<pthread_t> workers(threadCount);
+        for (long i = 0; i < threadCount; i++)
+            if (pthread_create(&workers[i], NULL, WorkerThread, NULL) != 0)
+                throw runtime_error("Cannot create worker thread");
+
+        server.Run();
+
+        gPendingJobs.Shutdown();
+        for (long i = 0; i < threadCount; i++)
+            pthread_join(workers[i], NULL);
+
+        close(listenFd);
+        unlink(socketPath.c_str());
+    }
+
+    catch (CommandLineException& e)
+    {
+        cerr << "blahtexd: " << e.mMessage << endl;
+        return 1;
+    }
+
+    catch (std::runtime_error& e)
+    {
+        cerr << "blahtexd runtime error: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -0,0 +1,202 @@
+// File "errorBenchmark.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// error-benchmark simulates a live preview, which converts a formula after
+// every keystroke: it processes every prefix of each formula in a list,
+// most of which are invalid (e.g. "\frac{a"). The formulas are read from a
+// file, one per line in UTF-8, or a built-in list is used.
+//
+// The prefixes are run through Interface::ProcessInputUtf8(), catching
+// the blahtex::Exception for each invalid one, and then through
+// Interface::TryProcessInputUtf8(), which returns the error instead. The
+// times are reported separately for the invalid and the valid prefixes.
+//
+// Usage: error-benchmark [formula-file [rounds]]
+
+#include <time.h>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "BlahtexCore/Interface.h"
+
+using namespace std;
+using namespace blahtex;
+
+const char* const gDefaultFormulas[] =
+{
+    "\\frac{-b \\pm \\sqrt{b^2 - 4ac}}{2a}",
+    "\\sum_{k=0}^{n} \\binom{n}{k} x^k y^{n-k} = (x + y)^n",
+    "\\int_{-\\infty}^{\\infty} e^{-\\pi x^2}\\,dx = 1",
+    "\\left[ \\begin{matrix} \\cos\\theta & -\\sin\\theta \\\\ "
+        "\\sin\\theta & \\cos\\theta \\end{matrix} \\right]",
+    "f(x) = \\begin{cases} x^2 & \\text{if } x \\ge 0 \\\\ "
+        "-x & \\text{otherwise} \\end{cases}",
+    "\\mathbf{F} = q\\left(\\mathbf{E} + \\mathbf{v} \\times "
+        "\\mathbf{B}\\right)",
+    "\\zeta(s) = \\prod_{p} \\frac{1}{1 - p^{-s}}",
+    "\\overline{z_1 z_2} = \\bar{z}_1 \\bar{z}_2",
+    "\\sqrt[3]{x^3 + y^3} \\le |x| + |y|",
+    "\\lim_{n \\to \\infty} \\left(1 + \\frac{1}{n}\\right)^n = e"
+};
+
+double Now()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+// Appends every non-empty prefix of "formula" to "prefixes", cutting only
+// at UTF-8 character boundaries.
+void AddPrefixes(const string& formula, vector<string>& prefixes)
+{
+    for (string::size_type length = 1; length <= formula.size(); length++)
+        if (length == formula.size() ||
+            (static_cast<unsigned char>(formula[length]) & 0xC0) != 0x80
+        )
+            prefixes.push_back(formula.substr(0, length));
+}
+
+// Returns the time per input, in nanoseconds, for the fastest of "rounds"
+// passes over all of "inputs".
+double TimeWithExceptions(const vector<string>& inputs, long rounds)
+{
+    Interface interface;
+    double best = 0.0;
+    for (long round = 0; round < rounds; round++)
+    {
+        double start = Now();
+        for (vector<string>::const_iterator
+            input = inputs.begin(); input != inputs.end(); input++
+        )
+        {
+            try
+            {
+                interface.ProcessInputUtf8(*input);
+            }
+            catch (blahtex::Exception& e)
+            {
+            }
+        }
+        double elapsed = Now() - start;
+        if (round == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return best / inputs.size();
+}
+
+double TimeWithResults(const vector<string>& inputs, long rounds)
+{
+    Interface interface;
+    Exception error;
+    double best = 0.0;
+    for (long round = 0; round < rounds; round++)
+    {
+        double start = Now();
+        for (vector<string>::const_iterator
+            input = inputs.begin(); input != inputs.end(); input++
+        )
+            interface.TryProcessInputUtf8(*input, error);
+        double elapsed = Now() - start;
+        if (round == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return best / inputs.size();
+}
+
+int main(int argc, char* const argv[])
+{
+    try
+    {
+        vector<string> formulas;
+        if (argc > 1)
+        {
+            ifstream file(argv[1], ios::in | ios::binary);
+            if (!file)
+                throw runtime_error(
+                    string("Cannot open \"") + argv[1] + "\""
+                );
+            string line;
+            while (getline(file, line))
+                if (!line.empty())
+                    formulas.push_back(line);
+        }
+        else
+            formulas.assign(
+                gDefaultFormulas,
+                END_ARRAY(gDefaultFormulas)
+            );
+
+        long rounds = (argc > 2) ? atol(argv[2]) : 20;
+        if (rounds <= 0)
+            rounds = 1;
+
+        vector<string> prefixes;
+        for (vector<string>::const_iterator
+            formula = formulas.begin(); formula != formulas.end(); formula++
+        )
+            AddPrefixes(*formula, prefixes);
+
+        // Sort the prefixes into invalid and valid ones.
+        vector<string> invalid, valid;
+        Interface interface;
+        Exception error;
+        for (vector<string>::const_iterator
+            prefix = prefixes.begin(); prefix != prefixes.end(); prefix++
+        )
+        {
+            if (interface.TryProcessInputUtf8(*prefix, error))
+                valid.push_back(*prefix);
+            else
+                invalid.push_back(*prefix);
+        }
+        if (invalid.empty() || valid.empty())
+            throw runtime_error("Need both invalid and valid prefixes");
+
+        cout << formulas.size() << " formulas, " << invalid.size()
+            << " invalid and " << valid.size() << " valid prefixes, best of "
+            << rounds << " rounds" << endl;
+
+        double invalidThrown = TimeWithExceptions(invalid, rounds);
+        double invalidReturned = TimeWithResults(invalid, rounds);
+        cout << "invalid: " << invalidThrown
+            << " ns/input with exceptions, " << invalidReturned
+            << " ns/input with TryProcessInputUtf8" << endl;
+
+        double validThrown = TimeWithExceptions(valid, rounds);
+        double validReturned = TimeWithResults(valid, rounds);
+        cout << "valid: " << validThrown
+            << " ns/input with exceptions, " << validReturned
+            << " ns/input with TryProcessInputUtf8" << endl;
+    }
+
+    catch (std::runtime_error& e)
+    {
+        cerr << "error-benchmark: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -0,0 +1,425 @@
+// File "libblahtex.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "libblahtex.h"
+#include "BlahtexCore/Interface.h"
+#include "BlahtexCore/Utf8.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace blahtex;
+
+// Imported from Messages.cpp:
+extern wstring GetErrorMessage(const blahtex::Exception& e);
+
+struct blahtex_converter
+{
+    Interface mInterface;
+
+    // Set once blahtex_process() has succeeded; cleared again by options
+    // that change how the input is parsed.
+    bool mHaveInput;
+
+    // Cached outputs for the current input; cleared whenever the input or
+    // the options change.
+    bool mHaveMathml;
+    bool mHavePurifiedTex;
+    string mMathml;
+    string mPurifiedTex;
+
+    // Describes the last error.
+    string mErrorCode;
+    string mErrorMessage;
+
+    blahtex_converter() :
+        mHaveInput(false),
+        mHaveMathml(false),
+        mHavePurifiedTex(false)
+    { }
+
+    void ClearOutput()
+    {
+        mHaveMathml = mHavePurifiedTex = false;
+        mMathml.clear();
+        mPurifiedTex.clear();
+    }
+
+    void ClearError()
+    {
+        mErrorCode.clear();
+        mErrorMessage.clear();
+    }
+
+    int InputError(const blahtex::Exception& e)
+    {
+        mErrorCode.clear();
+        mErrorMessage.clear();
+        AppendUtf8(mErrorCode, e.GetCode());
+        AppendUtf8(mErrorMessage, GetErrorMessage(e));
+        return BLAHTEX_ERROR_INPUT;
+    }
+
+    int InternalError(const char* message)
+    {
+        mErrorCode = "Internal";
+        mErrorMessage = message;
+        return BLAHTEX_ERROR_INTERNAL;
+    }
+};
+
+// The CATCH_ALL macro ends every exported function, converting any C++
+// exception into a status code, since none may cross the C boundary.
+#define CATCH_ALL(converter)                                            \
+    catch (blahtex::Exception& e)                                       \
+    {                                                                   \
+        return (converter)->InputError(e);                              \
+    }                                                                   \
+    catch (std::exception& e)                                           \
+    {                                                                   \
+        return (converter)->InternalError(e.what());                    \
+    }                                                                   \
+    catch (...)                                                         \
+    {                                                                   \
+        return (converter)->InternalError("Unknown exception");         \
+    }
+
+// Fills in the requested output if it isn't already cached, and points
+// "output" at it.
+int GetOutput(
+    blahtex_converter* converter,
+    bool mathml,
+    const string*& output
+)
+{
+    if (!converter->mHaveInput)
+        return BLAHTEX_ERROR_NO_INPUT;
+
+    try
+    {
+        if (mathml)
+        {
+            if (!converter->mHaveMathml)
+            {
+                converter->mMathml.clear();
+                converter->mInterface.AppendMathmlUtf8(converter->mMathml);
+                converter->mHaveMathml = true;
+            }
+            output = &converter->mMathml;
+        }
+        else
+        {
+            if (!converter->mHavePurifiedTex)
+            {
+                converter->mPurifiedTex =
+                    converter->mInterface.GetPurifiedTexUtf8();
+                converter->mHavePurifiedTex = true;
+            }
+            output = &converter->mPurifiedTex;
+        }
+        return BLAHTEX_OK;
+    }
+    CATCH_ALL(converter)
+}
+
+int CopyOutput(
+    blahtex_converter* converter,
+    bool mathml,
+    char* buffer,
+    size_t size,
+    size_t* length
+)
+{
+    if (!converter || (!buffer && size > 0))
+        return BLAHTEX_ERROR_INVALID_ARGUMENT;
+    converter->ClearError();
+
+    const string* output;
+    int status = GetOutput(converter, mathml, output);
+    if (status != BLAHTEX_OK)
+        return status;
+
+    if (length)
+        *length = output->size();
+    if (output->size() >= size)
+        return BLAHTEX_ERROR_BUFFER_TOO_SMALL;
+
+    memcpy(buffer, output->data(), output->size());
+    buffer[output->size()] = '\0';
+    return BLAHTEX_OK;
+}
+
+int PointToOutput(
+    blahtex_converter* converter,
+    bool mathml,
+    const char** output,
+    size_t* length
+)
+{
+    if (!converter || !output)
+        return BLAHTEX_ERROR_INVALID_ARGUMENT;
+    converter->ClearError();
+
+    const string* result;
+    int status = GetOutput(converter, mathml, result);
+    if (status != BLAHTEX_OK)
+        return status;
+
+    *output = result->c_str();
+    if (length)
+        *length = result->size();
+    return BLAHTEX_OK;
+}
+
+extern "C"
+{
+
+int blahtex_abi_version(void)
+{
+    return BLAHTEX_ABI_VERSION;
+}
+
+blahtex_converter* blahtex_create(void)
+{
+    // Allocating the converter can throw std::bad_alloc, and there's no
+    // converter yet for CATCH_ALL to record the error in, so any failure
+    // just gives NULL.
+    try
+    {
+        return new blahtex_converter;
+    }
+    catch (...)
+    {
+        return NULL;
+    }
+}
+
+void blahtex_destroy(blahtex_converter* converter)
+{
+    delete converter;
+}
+
+int blahtex_set_option(
+    blahtex_converter* converter,
+    int option,
+    int value
+)
+{
+    if (!converter)
+        return BLAHTEX_ERROR_INVALID_ARGUMENT;
+    converter->ClearError();
+
+    Interface& interface = converter->mInterface;
+
+    switch (option)
+    {
+        case BLAHTEX_OPTION_TEXVC_COMPATIBILITY:
+            // The current input was parsed under the old setting, so it
+            // has to go through blahtex_process() again.
+            interface.mTexvcCompatibility = value;
+            converter->mHaveInput = false;
+            break;
+
+        case BLAHTEX_OPTION_INDENTED:
+            interface.mIndented = value;
+            break;
+
+        case BLAHTEX_OPTION_MATHML_VERSION_1_FONTS:
+            interface.mMathmlOptions.mUseVersion1FontAttributes = value;
+            break;
+
+        case BLAHTEX_OPTION_ALLOW_PLANE_1:
+            interface.mMathmlOptions  .mAllowPlane1 = value;
+            interface.mEncodingOptions.mAllowPlane1 = value;
+            break;
+
+        case BLAHTEX_OPTION_OTHER_ENCODING_RAW:
+            interface.mEncodingOptions.mOtherEncodingRaw = value;
+            break;
+
+        case BLAHTEX_OPTION_USE_UCS_PACKAGE:
+            interface.mPurifiedTexOptions.mAllowUcs = value;
+            break;
+
+        case BLAHTEX_OPTION_USE_CJK_PACKAGE:
+            interface.mPurifiedTexOptions.mAllowCJK = value;
+            break;
+
+        case BLAHTEX_OPTION_USE_PREVIEW_PACKAGE:
+            interface.mPurifiedTexOptions.mAllowPreview = value;
+            break;
+
+        case BLAHTEX_OPTION_SPACING:
+            switch (value)
+            {
+                case BLAHTEX_SPACING_STRICT:
+                    interface.mMathmlOptions.mSpacingControl
+                        = MathmlOptions::cSpacingControlStrict;
+                    break;
+
+                case BLAHTEX_SPACING_MODERATE:
+                    interface.mMathmlOptions.mSpacingControl
+                        = MathmlOptions::cSpacingControlModerate;
+                    break;
+
+                case BLAHTEX_SPACING_RELAXED:
+                    interface.mMathmlOptions.mSpacingControl
+                        = MathmlOptions::cSpacingControlRelaxed;
+                    break;
+
+                default:
+                    return BLAHTEX_ERROR_INVALID_ARGUMENT;
+            }
+            break;
+
+        case BLAHTEX_OPTION_MATHML_ENCODING:
+            switch (value)
+            {
+                case BLAHTEX_MATHML_ENCODING_RAW:
+                    interface.mEncodingOptions.mMathmlEncoding
+                        = EncodingOptions::cMathmlEncodingRaw;
+                    break;
+
+                case BLAHTEX_MATHML_ENCODING_NUMERIC:
+                    interface.mEncodingOptions.mMathmlEncoding
+                        = EncodingOptions::cMathmlEncodingNumeric;
+                    break;
+
+                case BLAHTEX_MATHML_ENCODING_SHORT:
+                    interface.mEncodingOptions.mMathmlEncoding
+                        = EncodingOptions::cMathmlEncodingShort;
+                    break;
+
+                case BLAHTEX_MATHML_ENCODING_LONG:
+                    interface.mEncodingOptions.mMathmlEncoding
+                        = EncodingOptions::cMathmlEncodingLong;
+                    break;
+
+                default:
+                    return BLAHTEX_ERROR_INVALID_ARGUMENT;
+            }
+            break;
+
+        default:
+            return BLAHTEX_ERROR_INVALID_ARGUMENT;
+    }
+
+    converter->ClearOutput();
+    return BLAHTEX_OK;
+}
+
+int blahtex_set_japanese_font(
+    blahtex_converter* converter,
+    const char* font
+)
+{
+    if (!converter)
+        return BLAHTEX_ERROR_INVALID_ARGUMENT;
+    converter->ClearError();
+
+    try
+    {
+        wstring japaneseFont;
+        if (!DecodeUtf8(font ? font : "", japaneseFont))
+            throw blahtex::Exception(L"InvalidUtf8Input");
+        converter->mInterface.mPurifiedTexOptions.mJapaneseFont =
+            japaneseFont;
+        converter->ClearOutput();
+        return BLAHTEX_OK;
+    }
+    CATCH_ALL(converter)
+}
+
+int blahtex_process(
+    blahtex_converter* converter,
+    const char* input,
+    size_t length
+)
+{
+    if (!converter || (!input && length > 0))
+        return BLAHTEX_ERROR_INVALID_ARGUMENT;
+    converter->ClearError();
+    converter->ClearOutput();
+    converter->mHaveInput = false;
+
+    try
+    {
+        blahtex::Exception error;
+        if (!converter->mInterface.TryProcessInputUtf8(
+            string(input ? input : "", length), error
+        ))
+            return converter->InputError(error);
+        converter->mHaveInput = true;
+        return BLAHTEX_OK;
+    }
+    CATCH_ALL(converter)
+}
+
+int blahtex_copy_mathml(
+    blahtex_converter* converter,
+    char* buffer,
+    size_t size,
+    size_t* length
+)
+{
+    return CopyOutput(converter, true, buffer, size, length);
+}
+
+int blahtex_copy_purified_tex(
+    blahtex_converter* converter,
+    char* buffer,
+    size_t size,
+    size_t* length
+)
+{
+    return CopyOutput(converter, false, buffer, size, length);
+}
+
+int blahtex_get_mathml(
+    blahtex_converter* converter,
+    const char** output,
+    size_t* length
+)
+{
+    return PointToOutput(converter, true, output, length);
+}
+
+int blahtex_get_purified_tex(
+    blahtex_converter* converter,
+    const char** output,
+    size_t* length
+)
+{
+    return PointToOutput(converter, false, output, length);
+}
+
+const char* blahtex_error_code(blahtex_converter* converter)
+{
+    return converter ? converter->mErrorCode.c_str() : "";
+}
+
+const char* blahtex_error_message(blahtex_converter* converter)
+{
+    return converter ? converter->mErrorMessage.c_str() : "";
+}
+
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -0,0 +1,214 @@
+// File "libblahtex.h"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// This is the C interface to libblahtex.so (built by "make library"). It
+// lets programs written in C, or anything that can call C (PHP, Python,
+// ...), run blahtex in-process instead of starting the blahtex executable.
+//
+// To use it:
+// (1) Create a converter with blahtex_create()
+// (2) Set options with blahtex_set_option() (the values correspond to the
+//     blahtex command line options, and to the C++ option structs in
+//     BlahtexCore/Misc.h)
+// (3) Call blahtex_process() on a UTF-8 input
+// (4) Fetch the MathML and/or purified TeX, either into your own buffer
+//     (blahtex_copy_mathml(), blahtex_copy_purified_tex()) or as a pointer
+//     into a buffer owned by the converter (blahtex_get_mathml(),
+//     blahtex_get_purified_tex())
+// (5) Repeat from (2) or (3) as often as you like, then call
+//     blahtex_destroy()
+//
+// All strings are UTF-8. The option, processing and copy/get functions
+// return one of the BLAHTEX_* status codes below; blahtex_create() returns
+// a handle (NULL on failure), and blahtex_error_code() and
+// blahtex_error_message() return strings. No C++ exceptions ever escape
+// from the library.
+//
+// A converter may only be used by one thread at a time, but different
+// threads may use different converters simultaneously.
+//
+// ABI stability: the functions below will keep their signatures, and the
+// numeric values of existing constants will never change; new options and
+// status codes are only ever added at the end. BLAHTEX_ABI_VERSION is
+// increased if that promise ever has to be broken.
+
+#ifndef BLAHTEX_LIBBLAHTEX_H
+#define BLAHTEX_LIBBLAHTEX_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLAHTEX_ABI_VERSION 1
+
+#if defined(__GNUC__) && __GNUC__ >= 4
+#define BLAHTEX_API __attribute__((visibility("default")))
+#else
+#define BLAHTEX_API
+#endif
+
+// Opaque converter handle.
+typedef struct blahtex_converter blahtex_converter;
+
+// Status codes.
+enum
+{
+    BLAHTEX_OK = 0,
+
+    // The input was invalid (TeX syntax error, invalid UTF-8 etc). Use
+    // blahtex_error_code() and blahtex_error_message() for details.
+    BLAHTEX_ERROR_INPUT = 1,
+
+    // The caller's buffer is too small; the required length is returned.
+    BLAHTEX_ERROR_BUFFER_TOO_SMALL = 2,
+
+    // Unknown option or value, or a NULL pointer where one isn't allowed.
+    BLAHTEX_ERROR_INVALID_ARGUMENT = 3,
+
+    // Output was requested before any input was successfully processed.
+    BLAHTEX_ERROR_NO_INPUT = 4,
+
+    // Something went wrong inside blahtex (a debug assertion, out of
+    // memory, or an installation problem). blahtex_error_message()
+    // describes it.
+    BLAHTEX_ERROR_INTERNAL = 5
+};
+
+// Options for blahtex_set_option().
+enum
+{
+    // Boolean options (value is 0 or 1):
+    BLAHTEX_OPTION_TEXVC_COMPATIBILITY = 0,     // --texvc-compatible-commands
+    BLAHTEX_OPTION_INDENTED = 1,                // --indented
+    BLAHTEX_OPTION_MATHML_VERSION_1_FONTS = 2,  // --mathml-version-1-fonts
+    BLAHTEX_OPTION_ALLOW_PLANE_1 = 3,           // opposite of
+                                                // --disallow-plane-1
+    BLAHTEX_OPTION_OTHER_ENCODING_RAW = 4,      // --other-encoding raw
+    BLAHTEX_OPTION_USE_UCS_PACKAGE = 5,         // --use-ucs-package
+    BLAHTEX_OPTION_USE_CJK_PACKAGE = 6,         // --use-cjk-package
+    BLAHTEX_OPTION_USE_PREVIEW_PACKAGE = 7,     // --use-preview-package
+
+    // value is one of BLAHTEX_SPACING_*:
+    BLAHTEX_OPTION_SPACING = 8,                 // --spacing
+
+    // value is one of BLAHTEX_MATHML_ENCODING_*:
+    BLAHTEX_OPTION_MATHML_ENCODING = 9          // --mathml-encoding
+};
+
+enum
+{
+    BLAHTEX_SPACING_STRICT = 0,
+    BLAHTEX_SPACING_MODERATE = 1,
+    BLAHTEX_SPACING_RELAXED = 2
+};
+
+enum
+{
+    BLAHTEX_MATHML_ENCODING_RAW = 0,
+    BLAHTEX_MATHML_ENCODING_NUMERIC = 1,
+    BLAHTEX_MATHML_ENCODING_SHORT = 2,
+    BLAHTEX_MATHML_ENCODING_LONG = 3
+};
+
+// Returns BLAHTEX_ABI_VERSION as it was when the library was built.
+BLAHTEX_API int blahtex_abi_version(void);
+
+// Creates a converter with the default options (the same defaults as the
+// command line). Returns NULL if it can't be created.
+BLAHTEX_API blahtex_converter* blahtex_create(void);
+
+BLAHTEX_API void blahtex_destroy(blahtex_converter* converter);
+
+// Output options apply to the next blahtex_get_* or blahtex_copy_* call.
+// BLAHTEX_OPTION_TEXVC_COMPATIBILITY changes how the input is parsed, so
+// setting it discards the current input (until blahtex_process() is
+// called again, fetching output gives BLAHTEX_ERROR_NO_INPUT).
+BLAHTEX_API int blahtex_set_option(
+    blahtex_converter* converter,
+    int option,
+    int value
+);
+
+// Equivalent to "--japanese-font"; NULL or "" means no font.
+BLAHTEX_API int blahtex_set_japanese_font(
+    blahtex_converter* converter,
+    const char* font
+);
+
+// Parses the given input (which need not be NUL-terminated). On success,
+// the MathML and purified TeX may then be fetched. (Some errors are only
+// detected when the MathML is generated, so fetching it can still return
+// BLAHTEX_ERROR_INPUT.)
+BLAHTEX_API int blahtex_process(
+    blahtex_converter* converter,
+    const char* input,
+    size_t length
+);
+
+// Copies the output into "buffer" (which has room for "size" bytes),
+// followed by a NUL. The output length, not counting the NUL, is always
+// stored in "*length" (if "length" isn't NULL), so that if
+// BLAHTEX_ERROR_BUFFER_TOO_SMALL is returned the caller can try again with
+// a buffer of at least *length + 1 bytes. "buffer" may be NULL if "size"
+// is zero.
+BLAHTEX_API int blahtex_copy_mathml(
+    blahtex_converter* converter,
+    char* buffer,
+    size_t size,
+    size_t* length
+);
+BLAHTEX_API int blahtex_copy_purified_tex(
+    blahtex_converter* converter,
+    char* buffer,
+    size_t size,
+    size_t* length
+);
+
+// Sets "*output" to point to the NUL-terminated output, which is owned by
+// the converter and stays valid until the next call on the same
+// converter. "length" may be NULL.
+BLAHTEX_API int blahtex_get_mathml(
+    blahtex_converter* converter,
+    const char** output,
+    size_t* length
+);
+BLAHTEX_API int blahtex_get_purified_tex(
+    blahtex_converter* converter,
+    const char** output,
+    size_t* length
+);
+
+// Describe the last error returned by this converter: the error code
+// (e.g. "UnmatchedOpenBrace", see "blahtex --print-error-messages") and an
+// English message. For BLAHTEX_ERROR_INTERNAL the code is "Internal".
+// Both are empty strings if there was no error. The pointers stay valid
+// until the next call on the same converter.
+BLAHTEX_API const char* blahtex_error_code(blahtex_converter* converter);
+BLAHTEX_API const char* blahtex_error_message(blahtex_converter* converter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
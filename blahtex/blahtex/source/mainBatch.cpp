@@ -0,0 +1,358 @@
+// File "mainBatch.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "mainBatch.h"
+#include "BlahtexCore/Utf8.h"
+#include <pthread.h>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// The input is processed this many records per thread at a time; the
+// results of each chunk are written out (in order) before the next chunk
+// is read, so memory use doesn't grow with the size of the input.
+const vector<string>::size_type cBatchRecordsPerJob = 256;
+
+// Reads the four hex digits of a "\uXXXX" escape starting at input[pos].
+bool ReadHex4(
+    const string& input,
+    string::size_type pos,
+    string::size_type end,
+    unsigned& code
+)
+{
+    if (pos + 4 > end)
+        return false;
+
+    code = 0;
+    for (string::size_type i = pos; i < pos + 4; i++)
+    {
+        char c = input[i];
+        code <<= 4;
+        if (c >= '0' && c <= '9')
+            code |= c - '0';
+        else if (c >= 'a' && c <= 'f')
+            code |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            code |= c - 'A' + 10;
+        else
+            return false;
+    }
+    return true;
+}
+
+bool DecodeJsonString(const string& input, string& output)
+{
+    string::size_type begin = input.find_first_not_of(" \t\r\n");
+    string::size_type end = input.find_last_not_of(" \t\r\n");
+    if (begin == string::npos || begin == end ||
+        input[begin] != '"' || input[end] != '"'
+    )
+        return false;
+
+    output.clear();
+    for (string::size_type i = begin + 1; i < end; i++)
+    {
+        unsigned char c = input[i];
+
+        if (c == '"' || c < 0x20)
+            return false;
+
+        if (c != '\\')
+        {
+            output += c;
+            continue;
+        }
+
+        if (++i == end)
+            return false;
+
+        switch (input[i])
+        {
+            case '"':   output += '"';    break;
+            case '\\':  output += '\\';   break;
+            case '/':   output += '/';    break;
+            case 'b':   output += '\b';   break;
+            case 'f':   output += '\f';   break;
+            case 'n':   output += '\n';   break;
+            case 'r':   output += '\r';   break;
+            case 't':   output += '\t';   break;
+
+            case 'u':
+            {
+                unsigned code;
+                if (!ReadHex4(input, i + 1, end, code))
+                    return false;
+                i += 4;
+
+                // Characters outside the BMP come as surrogate pairs.
+                if (code >= 0xD800 && code < 0xDC00)
+                {
+                    unsigned low;
+                    if (i + 2 >= end || input[i + 1] != '\\' ||
+                        input[i + 2] != 'u' ||
+                        !ReadHex4(input, i + 3, end, low) ||
+                        low < 0xDC00 || low >= 0xE000
+                    )
+                        return false;
+                    i += 6;
+                    code = 0x10000 + ((code - 0xD800) << 10)
+                        + (low - 0xDC00);
+                }
+                else if (code >= 0xDC00 && code < 0xE000)
+                    return false;
+
+                blahtex::AppendUtf8(output, code);
+                break;
+            }
+
+            default:
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// A BatchChunk is a group of records shared out between the threads.
+struct BatchChunk
+{
+    const Settings* mSettings;
+
+    std::vector<std::string> mRecords;
+
+    // mValid[i] is false if record i couldn't be decoded.
+    std::vector<bool> mValid;
+
+    // mOutputs is not emptied by Clear(): each thread clears the string
+    // it is about to fill, so the buffers are reused from chunk to chunk.
+    std::vector<std::string> mOutputs;
+
+    // Everything below is protected by mMutex.
+    pthread_mutex_t mMutex;
+
+    // Index of the next record to be claimed by a thread.
+    std::vector<std::string>::size_type mNext;
+
+    // Set if any thread hits an exception (std::runtime_error, or anything
+    // else such as std::bad_alloc); the remaining records are abandoned
+    // and the error is reported by RunBatch().
+    bool mFailed;
+    std::string mRuntimeError;
+
+    BatchChunk(const Settings& settings) :
+        mSettings(&settings),
+        mNext(0),
+        mFailed(false)
+    {
+        pthread_mutex_init(&mMutex, NULL);
+    }
+
+    ~BatchChunk()
+    {
+        pthread_mutex_destroy(&mMutex);
+    }
+
+    void Clear()
+    {
+        mRecords.clear();
+        mValid.clear();
+        mNext = 0;
+    }
+
+    // Records the first error; later ones are dropped.
+    void Fail(const std::string& error)
+    {
+        pthread_mutex_lock(&mMutex);
+        if (!mFailed)
+        {
+            mFailed = true;
+            mRuntimeError = error;
+        }
+        pthread_mutex_unlock(&mMutex);
+    }
+};
+
+// Each BatchThread has its own Interface, since an Interface may not be
+// shared between threads.
+struct BatchThread
+{
+    pthread_t mThread;
+    BatchChunk* mChunk;
+    blahtex::Interface mInterface;
+};
+
+void* ProcessChunk(void* arg)
+{
+    BatchThread& thread = *static_cast<BatchThread*>(arg);
+    BatchChunk& chunk = *thread.mChunk;
+
+    while (true)
+    {
+        pthread_mutex_lock(&chunk.mMutex);
+        vector<string>::size_type index = chunk.mNext++;
+        bool finished = chunk.mFailed || index >= chunk.mRecords.size();
+        pthread_mutex_unlock(&chunk.mMutex);
+
+        if (finished)
+            break;
+
+        string& output = chunk.mOutputs[index];
+        output.clear();
+        try
+        {
+            if (chunk.mValid[index])
+                ConvertInput(
+                    *chunk.mSettings,
+                    chunk.mRecords[index],
+                    thread.mInterface,
+                    output
+                );
+            else
+                AppendErrorBlock(
+                    output,
+                    blahtex::Exception(L"InvalidBatchRecord"),
+                    *chunk.mSettings
+                );
+        }
+        catch (std::runtime_error& e)
+        {
+            chunk.Fail(e.what());
+        }
+
+        // Anything else (e.g. std::bad_alloc) must not escape either: on a
+        // worker thread it would terminate the whole process.
+        catch (std::exception& e)
+        {
+            chunk.Fail(e.what());
+        }
+        catch (...)
+        {
+            chunk.Fail("unknown exception");
+        }
+    }
+
+    return NULL;
+}
+
+// Reads the next record into "record"; returns false at end of input.
+bool ReadRecord(
+    istream& input,
+    bool nulSeparated,
+    string& record,
+    bool& valid
+)
+{
+    if (nulSeparated)
+    {
+        valid = true;
+        return !getline(input, record, '\0').fail();
+    }
+
+    string line;
+    while (getline(input, line))
+        if (line.find_first_not_of(" \t\r") != string::npos)
+        {
+            valid = DecodeJsonString(line, record);
+            return true;
+        }
+
+    return false;
+}
+
+void RunBatch(const Settings& settings)
+{
+    ifstream file;
+    istream* input = &cin;
+    if (settings.mBatchFile != "-")
+    {
+        file.open(settings.mBatchFile.c_str(), ios::in | ios::binary);
+        if (!file)
+            throw CommandLineException(
+                "Cannot open batch file \"" + settings.mBatchFile + "\""
+            );
+        input = &file;
+    }
+
+    unsigned jobs = settings.mJobs;
+    vector<string>::size_type chunkSize = cBatchRecordsPerJob * jobs;
+
+    BatchChunk chunk(settings);
+
+    vector<BatchThread*> threads;
+    for (unsigned i = 0; i < jobs; i++)
+    {
+        threads.push_back(new BatchThread);
+        threads.back()->mChunk = &chunk;
+    }
+
+    string record;
+    bool valid;
+    bool more = true;
+
+    while (more && !chunk.mFailed)
+    {
+        chunk.Clear();
+        while (chunk.mRecords.size() < chunkSize &&
+            (more = ReadRecord(*input, settings.mBatchNulSeparated,
+                record, valid))
+        )
+        {
+            chunk.mRecords.push_back(record);
+            chunk.mValid.push_back(valid);
+        }
+        chunk.mOutputs.resize(chunk.mRecords.size());
+
+        // The current thread does its share of the work too, so with a
+        // single job no extra threads are started.
+        {
+            // If a thread can't be started, the others (or this thread,
+            // below) just get more of the work.
+            vector<bool> started(jobs);
+            for (unsigned i = 1; i < jobs; i++)
+                started[i] = pthread_create(
+                    &threads[i]->mThread, NULL, ProcessChunk, threads[i]
+                ) == 0;
+
+            ProcessChunk(threads[0]);
+
+            for (unsigned i = 1; i < jobs; i++)
+                if (started[i])
+                    pthread_join(threads[i]->mThread, NULL);
+        }
+
+        // The whole chunk goes out in as few writev() calls as possible.
+        if (!chunk.mFailed && !chunk.mOutputs.empty() &&
+            !WriteAll(1, &chunk.mOutputs[0], chunk.mOutputs.size())
+        )
+            throw runtime_error("Cannot write to standard output");
+    }
+
+    for (unsigned i = 0; i < jobs; i++)
+        delete threads[i];
+
+    if (chunk.mFailed)
+        throw runtime_error(chunk.mRuntimeError);
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
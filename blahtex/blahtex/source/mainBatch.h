@@ -0,0 +1,49 @@
+// File "mainBatch.h"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef BLAHTEX_MAINBATCH_H
+#define BLAHTEX_MAINBATCH_H
+
+#include <string>
+#include "mainConvert.h"
+
+// Batch mode ("--batch file") converts a whole file of inputs in one go,
+// spreading the work over "--jobs" threads.
+//
+// The file contains one record per input. With "--batch-format jsonl"
+// (the default) each line is a JSON string, e.g. "x^{2}" or "\\frac12";
+// blank lines are skipped. With "--batch-format nul" the records are raw
+// UTF-8, separated by NUL bytes.
+//
+// The output contains one "<blahtex>...</blahtex>" block per record, in
+// the same order as the input, exactly as the command line version would
+// have printed for each record on its own.
+
+// DecodeJsonString() decodes a single JSON string literal (surrounding
+// whitespace allowed) into UTF-8. Returns false if it isn't one.
+extern bool DecodeJsonString(const std::string& input, std::string& output);
+
+// RunBatch() processes the batch file named in settings.mBatchFile,
+// writing the results to standard output.
+extern void RunBatch(const Settings& settings);
+
+#endif
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
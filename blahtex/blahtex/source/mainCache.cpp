@@ -0,0 +1,500 @@
+// File "mainCache.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "mainCache.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// The file starts with cMagic, followed by cFormat; bump cFormat whenever
+// the layout below changes, so that old files get emptied.
+static const char cMagic[8] = { 'B', 'L', 'A', 'H', 'C', 'A', 'C', 'H' };
+static const uint32_t cFormat = 1;
+
+// Files smaller than this get rounded up to it.
+static const size_t cMinimumSize = 64 * 1024;
+
+// One slot per this many bytes of file.
+static const size_t cBytesPerSlot = 512;
+
+struct ResultCache::Header
+{
+    char mMagic[8];
+    uint32_t mFormat;
+    uint32_t mSlotCount;        // always a power of two
+    uint64_t mFileSize;
+    uint64_t mDataStart;
+    uint64_t mDataEnd;
+    uint64_t mEntries;
+
+    uint64_t mHits;
+    uint64_t mMisses;
+    uint64_t mInserts;
+    uint64_t mResets;
+};
+
+// An entry at file offset mOffset consists of the key length and the value
+// length (uint32_t each), the key, and the value, padded to a multiple of
+// 8 bytes. An offset of zero means the slot is empty.
+struct ResultCache::Slot
+{
+    uint64_t mHash;
+    uint64_t mOffset;
+};
+
+static const size_t cEntryHeaderSize = 2 * sizeof(uint32_t);
+
+static inline uint64_t RoundUp(uint64_t x)
+{
+    return (x + 7) & ~static_cast<uint64_t>(7);
+}
+
+// 64-bit FNV-1a.
+static uint64_t Hash(const string& key)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (string::const_iterator p = key.begin(); p != key.end(); p++)
+    {
+        hash ^= static_cast<unsigned char>(*p);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// CacheLock holds mMutex and a flock() on the cache file for as long as it
+// is in scope.
+class CacheLock
+{
+    pthread_mutex_t& mMutex;
+    int mFd;
+
+public:
+    CacheLock(pthread_mutex_t& mutex, int fd, int operation) :
+        mMutex(mutex),
+        mFd(fd)
+    {
+        pthread_mutex_lock(&mMutex);
+        while (flock(mFd, operation) != 0)
+        {
+            if (errno != EINTR)
+            {
+                pthread_mutex_unlock(&mMutex);
+                throw runtime_error("Cannot lock the cache file");
+            }
+        }
+    }
+
+    ~CacheLock()
+    {
+        flock(mFd, LOCK_UN);
+        pthread_mutex_unlock(&mMutex);
+    }
+};
+
+ResultCache::ResultCache() :
+    mFd(-1),
+    mMap(NULL),
+    mMapSize(0)
+{
+    pthread_mutex_init(&mMutex, NULL);
+}
+
+ResultCache::~ResultCache()
+{
+    if (mMap)
+        munmap(mMap, mMapSize);
+    if (mFd >= 0)
+        close(mFd);
+    pthread_mutex_destroy(&mMutex);
+}
+
+ResultCache::Header* ResultCache::GetHeader() const
+{
+    return reinterpret_cast<Header*>(mMap);
+}
+
+ResultCache::Slot* ResultCache::GetSlots() const
+{
+    return reinterpret_cast<Slot*>(mMap + RoundUp(sizeof(Header)));
+}
+
+void ResultCache::Open(const string& fileName, size_t size)
+{
+    if (mMap)
+        throw logic_error("ResultCache::Open called twice");
+
+    mFd = open(fileName.c_str(), O_RDWR | O_CREAT, 0644);
+    if (mFd < 0)
+        throw runtime_error(
+            "Cannot open cache file \"" + fileName + "\""
+        );
+
+    // Hold the exclusive lock while setting up the file, so that another
+    // process starting at the same moment waits until it's ready.
+    CacheLock lock(mMutex, mFd, LOCK_EX);
+
+    struct stat status;
+    if (fstat(mFd, &status) != 0)
+        throw runtime_error(
+            "Cannot read cache file \"" + fileName + "\""
+        );
+
+    if (status.st_size == 0)
+    {
+        if (size < cMinimumSize)
+            size = cMinimumSize;
+        if (ftruncate(mFd, size) != 0)
+            throw runtime_error(
+                "Cannot resize cache file \"" + fileName + "\""
+            );
+        mMapSize = size;
+    }
+    else
+    {
+        mMapSize = status.st_size;
+        if (mMapSize < cMinimumSize)
+            throw runtime_error(
+                "\"" + fileName + "\" is not a blahtex cache file"
+            );
+    }
+
+    void* map = mmap(
+        NULL, mMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0
+    );
+    if (map == MAP_FAILED)
+        throw runtime_error(
+            "Cannot map cache file \"" + fileName + "\""
+        );
+    mMap = static_cast<char*>(map);
+
+    Header* header = GetHeader();
+
+    // A new file (or one whose creator died before writing the magic) is
+    // all zeros.
+    static const char cZeros[sizeof(cMagic)] = { 0 };
+    if (memcmp(header->mMagic, cZeros, sizeof(cMagic)) != 0)
+    {
+        if (memcmp(header->mMagic, cMagic, sizeof(cMagic)) != 0)
+            throw runtime_error(
+                "\"" + fileName + "\" is not a blahtex cache file"
+            );
+        if (header->mFormat == cFormat &&
+            header->mFileSize == mMapSize &&
+            header->mSlotCount >= 16 &&
+            (header->mSlotCount & (header->mSlotCount - 1)) == 0 &&
+            header->mDataStart <= header->mDataEnd &&
+            header->mDataEnd <= mMapSize &&
+            header->mDataStart ==
+                RoundUp(sizeof(Header)) + header->mSlotCount * sizeof(Slot)
+        )
+            return;
+    }
+
+    uint32_t slotCount = 16;
+    while (slotCount < 0x40000000 &&
+        2 * slotCount <= mMapSize / cBytesPerSlot
+    )
+        slotCount *= 2;
+
+    header->mFormat = cFormat;
+    header->mSlotCount = slotCount;
+    header->mFileSize = mMapSize;
+    header->mDataStart =
+        RoundUp(sizeof(Header)) + slotCount * sizeof(Slot);
+    header->mHits = header->mMisses = header->mInserts = 0;
+    header->mResets = 0;
+    Reset();
+    header->mResets = 0;
+    memcpy(header->mMagic, cMagic, sizeof(cMagic));
+}
+
+void ResultCache::Reset()
+{
+    Header* header = GetHeader();
+    memset(GetSlots(), 0, header->mSlotCount * sizeof(Slot));
+    header->mDataEnd = header->mDataStart;
+    header->mEntries = 0;
+    header->mResets++;
+}
+
+ResultCache::Slot* ResultCache::FindSlot(
+    uint64_t hash,
+    const string& key
+) const
+{
+    Header* header = GetHeader();
+    Slot* slots = GetSlots();
+    uint32_t mask = header->mSlotCount - 1;
+
+    // The table is never more than half full, but a damaged file might
+    // have no empty slot at all, so give up after visiting every slot.
+    uint32_t index = hash & mask;
+    for (uint32_t probes = 0; probes < header->mSlotCount;
+        probes++, index = (index + 1) & mask
+    )
+    {
+        Slot* slot = &slots[index];
+        if (slot->mOffset == 0)
+            return slot;
+        if (slot->mHash != hash)
+            continue;
+
+        // Don't trust a damaged file to stay within the data area.
+        if (slot->mOffset < header->mDataStart ||
+            slot->mOffset + cEntryHeaderSize > header->mDataEnd
+        )
+            continue;
+        const char* entry = mMap + slot->mOffset;
+        uint32_t keyLength, valueLength;
+        memcpy(&keyLength, entry, sizeof(keyLength));
+        memcpy(&valueLength, entry + sizeof(uint32_t), sizeof(valueLength));
+        if (slot->mOffset + cEntryHeaderSize + keyLength + valueLength >
+            header->mDataEnd
+        )
+            continue;
+
+        if (keyLength == key.size() &&
+            memcmp(entry + cEntryHeaderSize, key.data(), keyLength) == 0
+        )
+            return slot;
+    }
+
+    return NULL;
+}
+
+bool ResultCache::Lookup(const string& key, string& output)
+{
+    if (!mMap)
+        throw logic_error("ResultCache::Lookup called before Open");
+
+    uint64_t hash = Hash(key);
+    Header* header = GetHeader();
+    CacheLock lock(mMutex, mFd, LOCK_SH);
+
+    Slot* slot = FindSlot(hash, key);
+    if (!slot || slot->mOffset == 0)
+    {
+        __sync_fetch_and_add(&header->mMisses, 1);
+        return false;
+    }
+
+    const char* entry = mMap + slot->mOffset;
+    uint32_t valueLength;
+    memcpy(&valueLength, entry + sizeof(uint32_t), sizeof(valueLength));
+    output.append(entry + cEntryHeaderSize + key.size(), valueLength);
+    __sync_fetch_and_add(&header->mHits, 1);
+    return true;
+}
+
+void ResultCache::Insert(
+    const string& key,
+    const char* value,
+    size_t valueLength
+)
+{
+    if (!mMap)
+        throw logic_error("ResultCache::Insert called before Open");
+
+    Header* header = GetHeader();
+    uint64_t entrySize =
+        RoundUp(cEntryHeaderSize + key.size() + valueLength);
+    if (entrySize > header->mFileSize - header->mDataStart)
+        return;
+
+    uint64_t hash = Hash(key);
+    CacheLock lock(mMutex, mFd, LOCK_EX);
+
+    if (2 * (header->mEntries + 1) > header->mSlotCount ||
+        header->mDataEnd + entrySize > header->mFileSize
+    )
+        Reset();
+
+    Slot* slot = FindSlot(hash, key);
+    if (!slot)
+    {
+        // The slot table is damaged (it has no empty slot).
+        Reset();
+        slot = FindSlot(hash, key);
+    }
+
+    // Write the entry before pointing a slot at it.
+    char* entry = mMap + header->mDataEnd;
+    uint32_t keyLength = key.size();
+    uint32_t length = valueLength;
+    memcpy(entry, &keyLength, sizeof(keyLength));
+    memcpy(entry + sizeof(uint32_t), &length, sizeof(length));
+    memcpy(entry + cEntryHeaderSize, key.data(), keyLength);
+    memcpy(entry + cEntryHeaderSize + keyLength, value, valueLength);
+
+    if (slot->mOffset == 0)
+        header->mEntries++;
+    slot->mHash = hash;
+    slot->mOffset = header->mDataEnd;
+    header->mDataEnd += entrySize;
+    __sync_fetch_and_add(&header->mInserts, 1);
+}
+
+ResultCache::Statistics ResultCache::GetStatistics()
+{
+    if (!mMap)
+        throw logic_error("ResultCache::GetStatistics called before Open");
+
+    Header* header = GetHeader();
+    CacheLock lock(mMutex, mFd, LOCK_SH);
+
+    Statistics statistics;
+    statistics.mHits = header->mHits;
+    statistics.mMisses = header->mMisses;
+    statistics.mInserts = header->mInserts;
+    statistics.mResets = header->mResets;
+    statistics.mEntries = header->mEntries;
+    statistics.mBytesUsed = header->mDataEnd;
+    statistics.mFileSize = header->mFileSize;
+    return statistics;
+}
+
+// Each entry costs this much on top of its key and value: roughly the map
+// and list nodes, and the string headers.
+static const size_t cMemoryEntryOverhead = 128;
+
+MemoryCache::MemoryCache(size_t budget) :
+    mBudget(budget),
+    mBytesUsed(0)
+{
+    memset(&mStatistics, 0, sizeof(mStatistics));
+    pthread_mutex_init(&mMutex, NULL);
+    pthread_cond_init(&mClaimDone, NULL);
+}
+
+MemoryCache::~MemoryCache()
+{
+    pthread_cond_destroy(&mClaimDone);
+    pthread_mutex_destroy(&mMutex);
+}
+
+bool MemoryCache::LookupOrClaim(const string& key, string& output)
+{
+    pthread_mutex_lock(&mMutex);
+
+    bool hasWaited = false;
+    while (mClaimed.count(key))
+    {
+        pthread_cond_wait(&mClaimDone, &mMutex);
+        hasWaited = true;
+    }
+
+    EntryMap::iterator entry = mEntries.find(key);
+    if (entry == mEntries.end())
+    {
+        mClaimed.insert(key);
+        mStatistics.mMisses++;
+        pthread_mutex_unlock(&mMutex);
+        return false;
+    }
+
+    mRecent.splice(mRecent.begin(), mRecent, entry->second.mPosition);
+    output += entry->second.mValue;
+    mStatistics.mHits++;
+    if (hasWaited)
+        mStatistics.mCoalesced++;
+    pthread_mutex_unlock(&mMutex);
+    return true;
+}
+
+void MemoryCache::Remove(EntryMap::iterator entry)
+{
+    mBytesUsed -= entry->first.size() + entry->second.mValue.size() +
+        cMemoryEntryOverhead;
+    mRecent.erase(entry->second.mPosition);
+    mEntries.erase(entry);
+}
+
+void MemoryCache::Insert(
+    const string& key,
+    const char* value,
+    size_t valueLength
+)
+{
+    size_t size = key.size() + valueLength + cMemoryEntryOverhead;
+
+    pthread_mutex_lock(&mMutex);
+
+    mClaimed.erase(key);
+    pthread_cond_broadcast(&mClaimDone);
+
+    EntryMap::iterator entry = mEntries.find(key);
+    if (entry != mEntries.end())
+        Remove(entry);
+
+    if (size <= mBudget)
+    {
+        while (mBytesUsed + size > mBudget)
+        {
+            Remove(mEntries.find(*mRecent.back()));
+            mStatistics.mEvictions++;
+        }
+
+        entry = mEntries.insert(make_pair(key, Entry())).first;
+        entry->second.mValue.assign(value, valueLength);
+        mRecent.push_front(&entry->first);
+        entry->second.mPosition = mRecent.begin();
+        mBytesUsed += size;
+        mStatistics.mInserts++;
+    }
+
+    pthread_mutex_unlock(&mMutex);
+}
+
+void MemoryCache::Release(const string& key)
+{
+    pthread_mutex_lock(&mMutex);
+    mClaimed.erase(key);
+    pthread_cond_broadcast(&mClaimDone);
+    pthread_mutex_unlock(&mMutex);
+}
+
+void MemoryCache::Erase(const string& key)
+{
+    pthread_mutex_lock(&mMutex);
+    EntryMap::iterator entry = mEntries.find(key);
+    if (entry != mEntries.end())
+        Remove(entry);
+    pthread_mutex_unlock(&mMutex);
+}
+
+MemoryCache::Statistics MemoryCache::GetStatistics()
+{
+    pthread_mutex_lock(&mMutex);
+    Statistics statistics = mStatistics;
+    statistics.mEntries = mEntries.size();
+    statistics.mBytesUsed = mBytesUsed;
+    statistics.mBudget = mBudget;
+    pthread_mutex_unlock(&mMutex);
+    return statistics;
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -0,0 +1,210 @@
+// File "mainCache.h"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef BLAHTEX_MAINCACHE_H
+#define BLAHTEX_MAINCACHE_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+
+// ResultCache is a persistent cache of conversion results, kept in a
+// memory-mapped file ("--cache"). Each entry maps a key (see
+// AppendCacheKey in mainConvert.cpp) to a value (a complete output block).
+//
+// Any number of blahtex processes may use the same file at once: lookups
+// take a shared flock() on it, and inserts an exclusive one. Since flock()
+// doesn't distinguish between threads, the threads of one process also
+// take turns using mMutex.
+//
+// The file has a fixed size, set when it is created. It holds a header,
+// then an open addressing hash table of slots, then the entries, which are
+// appended one after another. Once either the table or the space for the
+// entries is full, the next insert empties the whole cache and starts
+// again; there's no finer-grained eviction, which keeps the file format
+// trivial and a lookup down to a hash, one or two probes and a memcmp().
+class ResultCache
+{
+public:
+    // The counters kept in the file header, shared by every process using
+    // the file. (They are only updated atomically, not under the
+    // exclusive lock, so a concurrent reset may lose a few counts.)
+    struct Statistics
+    {
+        uint64_t mHits;
+        uint64_t mMisses;
+        uint64_t mInserts;
+        uint64_t mResets;
+        uint64_t mEntries;
+        uint64_t mBytesUsed;
+        uint64_t mFileSize;
+    };
+
+    ResultCache();
+    ~ResultCache();
+
+    // Opens the cache file, creating it (with "size" bytes) if it doesn't
+    // exist yet; an existing file keeps whatever size it was created with.
+    // A file written by a different version of this code is emptied.
+    // Throws std::runtime_error if the file can't be opened or mapped, or
+    // isn't a blahtex cache at all.
+    void Open(const std::string& fileName, size_t size);
+
+    // Looks up "key". If it's there, appends the value to "output", and
+    // returns true.
+    bool Lookup(const std::string& key, std::string& output);
+
+    // Stores "value" under "key", replacing any earlier value. Values too
+    // large to ever fit are silently dropped.
+    void Insert(
+        const std::string& key,
+        const char* value,
+        size_t valueLength
+    );
+
+    Statistics GetStatistics();
+
+private:
+    struct Header;
+    struct Slot;
+
+    int mFd;
+    char* mMap;
+    size_t mMapSize;
+    pthread_mutex_t mMutex;
+
+    Header* GetHeader() const;
+    Slot* GetSlots() const;
+
+    // Returns the slot for "key" (whose hash is "hash"): either the one
+    // holding it, or the empty one where it would go. Returns NULL if
+    // there's neither, which only happens if the file is damaged.
+    Slot* FindSlot(uint64_t hash, const std::string& key) const;
+
+    // Empties the cache. The caller must hold the exclusive lock.
+    void Reset();
+
+    // Not copyable.
+    ResultCache(const ResultCache&);
+    ResultCache& operator=(const ResultCache&);
+};
+
+// MemoryCache is an in-process cache of conversion results, for
+// long-running processes ("--memory-cache"), with the same keys and values
+// as ResultCache. It holds at most a given number of bytes, evicting the
+// least recently used entries to make room.
+//
+// It also makes sure that an input is only converted once even if several
+// threads ask for it at the same time (as happens when a popular page is
+// purged): the first thread to miss "claims" the key, and the others wait
+// until it has stored the result, and then use that.
+class MemoryCache
+{
+public:
+    struct Statistics
+    {
+        uint64_t mHits;
+        uint64_t mMisses;
+
+        // The number of hits that had to wait for another thread to
+        // finish converting the same input.
+        uint64_t mCoalesced;
+
+        uint64_t mInserts;
+        uint64_t mEvictions;
+        uint64_t mEntries;
+        uint64_t mBytesUsed;
+        uint64_t mBudget;
+    };
+
+    // "budget" is the maximum size of the cache in bytes, counting the
+    // keys, the values and a fixed overhead per entry.
+    explicit MemoryCache(size_t budget);
+    ~MemoryCache();
+
+    // Looks up "key". If it's there, appends the value to "output", and
+    // returns true. Otherwise returns false, and the key now belongs to
+    // the caller, who must pass it to either Insert() or Release(); other
+    // threads looking it up wait until then. If the key already belongs to
+    // another thread, LookupOrClaim() waits first.
+    bool LookupOrClaim(const std::string& key, std::string& output);
+
+    // Stores "value" under a key claimed by LookupOrClaim() (or replaces
+    // it), and wakes up any threads waiting for it.
+    void Insert(
+        const std::string& key,
+        const char* value,
+        size_t valueLength
+    );
+
+    // Gives up a claimed key without storing anything; one of the threads
+    // waiting for it (if any) claims it instead.
+    void Release(const std::string& key);
+
+    // Removes "key", e.g. if its value turns out to be out of date.
+    void Erase(const std::string& key);
+
+    Statistics GetStatistics();
+
+private:
+    // The keys of all the entries (pointing into mEntries), most recently
+    // used first.
+    typedef std::list<const std::string*> RecentList;
+    RecentList mRecent;
+
+    struct Entry
+    {
+        std::string mValue;
+
+        // This entry's position in mRecent.
+        RecentList::iterator mPosition;
+    };
+
+    typedef std::map<std::string, Entry> EntryMap;
+    EntryMap mEntries;
+
+    // The keys claimed by LookupOrClaim() but not yet inserted or
+    // released.
+    std::set<std::string> mClaimed;
+
+    size_t mBudget;
+    size_t mBytesUsed;
+    Statistics mStatistics;
+
+    pthread_mutex_t mMutex;
+
+    // Broadcast whenever a claimed key is inserted or released.
+    pthread_cond_t mClaimDone;
+
+    // Removes the entry at "entry", and updates mBytesUsed.
+    void Remove(EntryMap::iterator entry);
+
+    // Not copyable.
+    MemoryCache(const MemoryCache&);
+    MemoryCache& operator=(const MemoryCache&);
+};
+
+#endif
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -0,0 +1,1112 @@
+// File "mainConvert.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "mainConvert.h"
+#include "mainPng.h"
+#include "md5Wrapper.h"
+#include "BlahtexCore/Utf8.h"
+#include <cstdlib>
+#include <cctype>
+#include <cstdio>
+#include <cerrno>
+#include <climits>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+using namespace std;
+using namespace blahtex;
+
+string gBlahtexVersion = "0.4.4";
+
+// Imported from Messages.cpp:
+extern wstring GetErrorMessage(const blahtex::Exception& e);
+extern wstring GetErrorMessages();
+
+// AppendError() converts a blahtex Exception object into UTF-8 like
+// "<error><id>...</id><arg>...</arg><arg>...</arg> ...
+// <message>...</message></error>", and appends it to "output".
+void AppendError(
+    string& output,
+    const blahtex::Exception& e,
+    const EncodingOptions& options
+)
+{
+    output += "<error><id>";
+    AppendUtf8(output, e.GetCode());
+    output += "</id>";
+    for (vector<wstring>::const_iterator
+        arg = e.GetArgs().begin(); arg != e.GetArgs().end(); arg++
+    )
+    {
+        output += "<arg>";
+        XmlEncode(output, *arg, options);
+        output += "</arg>";
+    }
+
+    output += "<message>";
+    XmlEncode(output, GetErrorMessage(e), options);
+    output += "</message>";
+
+    output += "</error>";
+}
+
+// Appends an element like "<height>12</height>\n".
+void AppendNumberElement(string& output, const char* name, int value)
+{
+    char digits[16];
+    snprintf(digits, sizeof(digits), "%d", value);
+    output += '<';
+    output += name;
+    output += '>';
+    output += digits;
+    output += "</";
+    output += name;
+    output += ">\n";
+}
+
+// Adds a trailing slash to the string, if it's not already there.
+void AddTrailingSlash(string& s)
+{
+    if (!s.empty() && s[s.size() - 1] != '/')
+        s += '/';
+}
+
+// ParseMathmlOption() handles the options that only affect the MathML
+// output ("--indented", "--spacing" etc). If args[i] is one of them, it
+// applies it (and the argument after it, if it takes one) to "profile",
+// and returns true. Otherwise it returns false.
+bool ParseMathmlOption(
+    const vector<string>& args,
+    vector<string>::size_type& i,
+    MathmlProfile& profile
+)
+{
+    string arg(args[i]);
+
+    if (arg == "--indented")
+        profile.mIndented = true;
+
+    else if (arg == "--spacing")
+    {
+        if (++i == args.size())
+            throw CommandLineException(
+                "Missing string after \"--spacing\""
+            );
+        arg = args[i];
+
+        if (arg == "strict")
+            profile.mMathmlOptions.mSpacingControl
+                = MathmlOptions::cSpacingControlStrict;
+
+        else if (arg == "moderate")
+            profile.mMathmlOptions.mSpacingControl
+                = MathmlOptions::cSpacingControlModerate;
+
+        else if (arg == "relaxed")
+            profile.mMathmlOptions.mSpacingControl
+                = MathmlOptions::cSpacingControlRelaxed;
+
+        else
+            throw CommandLineException(
+                "Illegal string after \"--spacing\""
+            );
+    }
+
+    else if (arg == "--mathml-version-1-fonts")
+        profile.mMathmlOptions.mUseVersion1FontAttributes = true;
+
+    else if (arg == "--mathml-encoding")
+    {
+        if (++i == args.size())
+            throw CommandLineException(
+                "Missing string after \"--mathml-encoding\""
+            );
+        arg = args[i];
+
+        if (arg == "raw")
+            profile.mEncodingOptions.mMathmlEncoding
+                = EncodingOptions::cMathmlEncodingRaw;
+
+        else if (arg == "numeric")
+            profile.mEncodingOptions.mMathmlEncoding
+                = EncodingOptions::cMathmlEncodingNumeric;
+
+        else if (arg == "short")
+            profile.mEncodingOptions.mMathmlEncoding
+                = EncodingOptions::cMathmlEncodingShort;
+
+        else if (arg == "long")
+            profile.mEncodingOptions.mMathmlEncoding
+                = EncodingOptions::cMathmlEncodingLong;
+
+        else
+            throw CommandLineException(
+                "Illegal string after \"--mathml-encoding\""
+            );
+    }
+
+    else if (arg == "--disallow-plane-1")
+    {
+        profile.mMathmlOptions  .mAllowPlane1 = false;
+        profile.mEncodingOptions.mAllowPlane1 = false;
+    }
+
+    else if (arg == "--other-encoding")
+    {
+        if (++i == args.size())
+            throw CommandLineException(
+                "Missing string after \"--other-encoding\""
+            );
+        arg = args[i];
+        if (arg == "raw")
+            profile.mEncodingOptions.mOtherEncodingRaw = true;
+        else if (arg == "numeric")
+            profile.mEncodingOptions.mOtherEncodingRaw = false;
+        else
+            throw CommandLineException(
+                "Illegal string after \"--other-encoding\""
+            );
+    }
+
+    else
+        return false;
+
+    return true;
+}
+
+// Splits "text" into words separated by whitespace.
+vector<string> SplitWords(const string& text)
+{
+    vector<string> output;
+    istringstream is(text);
+    string word;
+    while (is >> word)
+        output.push_back(word);
+    return output;
+}
+
+// Returns true if "name" is usable as a profile name, i.e. it's non-empty
+// and only contains letters, digits, '-', '_' and '.' (so that it never
+// needs XML encoding).
+bool IsValidProfileName(const string& name)
+{
+    if (name.empty())
+        return false;
+    for (string::const_iterator c = name.begin(); c != name.end(); c++)
+        if (!isalnum(static_cast<unsigned char>(*c)) &&
+            *c != '-' && *c != '_' && *c != '.'
+        )
+            return false;
+    return true;
+}
+
+void ParseOptions(
+    const vector<string>& args,
+    Settings& settings
+)
+{
+    for (vector<string>::size_type i = 0; i < args.size(); i++)
+    {
+        if (ParseMathmlOption(args, i, settings.mMathmlProfile))
+            continue;
+
+        string arg(args[i]);
+
+        if (arg == "--help")
+        {
+            settings.mShowUsage = true;
+            return;
+        }
+
+        else if (arg == "--print-error-messages")
+        {
+            settings.mPrintErrorMessages = true;
+            return;
+        }
+
+        else if (arg == "--server")
+            settings.mServer = true;
+
+        else if (arg == "--batch")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--batch\""
+                );
+            settings.mBatchFile = args[i];
+        }
+
+        else if (arg == "--batch-format")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--batch-format\""
+                );
+            arg = args[i];
+            if (arg == "jsonl")
+                settings.mBatchNulSeparated = false;
+            else if (arg == "nul")
+                settings.mBatchNulSeparated = true;
+            else
+                throw CommandLineException(
+                    "Illegal string after \"--batch-format\""
+                );
+        }
+
+        else if (arg == "--jobs")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--jobs\""
+                );
+            int jobs = atoi(args[i].c_str());
+            if (jobs <= 0)
+                throw CommandLineException(
+                    "Illegal string after \"--jobs\""
+                );
+            settings.mJobs = jobs;
+        }
+
+        else if (arg == "--cache")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--cache\""
+                );
+            settings.mCacheFile = args[i];
+        }
+
+        else if (arg == "--cache-size")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--cache-size\""
+                );
+            int megabytes = atoi(args[i].c_str());
+            if (megabytes <= 0 || megabytes > 4096)
+                throw CommandLineException(
+                    "Illegal string after \"--cache-size\""
+                );
+            settings.mCacheSize = static_cast<size_t>(megabytes) << 20;
+        }
+
+        else if (arg == "--memory-cache")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--memory-cache\""
+                );
+            int megabytes = atoi(args[i].c_str());
+            if (megabytes < 0 || megabytes > 4096 ||
+                (megabytes == 0 && args[i] != "0")
+            )
+                throw CommandLineException(
+                    "Illegal string after \"--memory-cache\""
+                );
+            settings.mMemoryCacheSize =
+                static_cast<size_t>(megabytes) << 20;
+        }
+
+        else if (arg == "--cache-stats")
+            settings.mShowCacheStatistics = true;
+
+        else if (arg == "--throw-logic-error")
+            throw logic_error("Aaarrrgggghhhh!");
+
+        else if (arg == "--shell-latex")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--shell-latex\""
+                );
+            settings.mShellLatex = args[i];
+        }
+
+        else if (arg == "--shell-dvipng")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--shell-dvipng\""
+                );
+            settings.mShellDvipng = args[i];
+        }
+
+        else if (arg == "--temp-directory")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--temp-directory\""
+                );
+            settings.mTempDirectory = args[i];
+            AddTrailingSlash(settings.mTempDirectory);
+        }
+
+        else if (arg == "--png-directory")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--png-directory\""
+                );
+            settings.mPngDirectory = args[i];
+            AddTrailingSlash(settings.mPngDirectory);
+        }
+
+        else if (arg == "--use-ucs-package")
+            settings.mPurifiedTexOptions.mAllowUcs = true;
+
+        else if (arg == "--use-cjk-package")
+            settings.mPurifiedTexOptions.mAllowCJK = true;
+
+        else if (arg == "--use-preview-package")
+            settings.mPurifiedTexOptions.mAllowPreview = true;
+
+        else if (arg == "--japanese-font")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--japanese-font\""
+                );
+            settings.mJapaneseFont = args[i];
+        }
+
+        else if (arg == "--texvc-compatible-commands")
+            settings.mTexvcCompatibility = true;
+
+        else if (arg == "--png")
+            settings.mDoPng = true;
+
+        else if (arg == "--mathml")
+            settings.mDoMathml = true;
+
+        else if (arg == "--validate")
+            settings.mValidate = true;
+
+        else if (arg == "--canonical-hash")
+            settings.mCanonicalHash = true;
+
+        else if (arg == "--validate-layout")
+        {
+            settings.mValidate = true;
+            settings.mValidateLayout = true;
+        }
+
+        else if (arg == "--mathml-profile")
+        {
+            if (i + 2 >= args.size())
+                throw CommandLineException(
+                    "Missing strings after \"--mathml-profile\""
+                );
+            string name = args[++i];
+            if (!IsValidProfileName(name))
+                throw CommandLineException(
+                    "Illegal profile name after \"--mathml-profile\""
+                );
+            for (vector<string>::const_iterator
+                other = settings.mProfileNames.begin();
+                other != settings.mProfileNames.end();
+                other++
+            )
+                if (*other == name)
+                    throw CommandLineException(
+                        "Duplicate profile name \"" + name + "\""
+                    );
+            settings.mProfileNames.push_back(name);
+            settings.mProfileOptions.push_back(args[++i]);
+        }
+
+        else if (arg == "--debug")
+        {
+            if (++i == args.size())
+                throw CommandLineException(
+                    "Missing string after \"--debug\""
+                );
+            arg = args[i];
+            if (arg == "layout")
+                settings.mDebugLayoutTree = true;
+            else if (arg == "parse")
+                settings.mDebugParseTree = true;
+            else if (arg == "purified")
+                settings.mDebugPurifiedTex = true;
+            else
+                throw CommandLineException(
+                    "Illegal string after \"--debug\""
+                );
+        }
+
+        else if (arg == "--keep-temp-files")
+            settings.mDeleteTempFiles = false;
+
+        else
+            throw CommandLineException(
+                "Unrecognised command line option \"" + arg + "\""
+            );
+    }
+
+    // The profiles are worked out last, so that each one starts from the
+    // main MathML options wherever those appear (and, in server mode,
+    // from the ones in the request).
+    settings.mProfiles.assign(
+        settings.mProfileNames.size(), settings.mMathmlProfile
+    );
+    for (vector<string>::size_type
+        profile = 0; profile < settings.mProfileNames.size(); profile++
+    )
+    {
+        vector<string> profileArgs =
+            SplitWords(settings.mProfileOptions[profile]);
+        for (vector<string>::size_type i = 0; i < profileArgs.size(); i++)
+            if (!ParseMathmlOption(
+                profileArgs, i, settings.mProfiles[profile]
+            ))
+                throw CommandLineException(
+                    "Illegal option \"" + profileArgs[i] +
+                    "\" in profile \"" + settings.mProfileNames[profile] +
+                    "\""
+                );
+    }
+}
+
+// Appends the options in "profile" to a cache key.
+void AppendProfileKey(string& key, const MathmlProfile& profile)
+{
+    key += static_cast<char>('0' + profile.mMathmlOptions.mSpacingControl);
+    key += profile.mMathmlOptions.mUseVersion1FontAttributes ? '1' : '0';
+    key += profile.mMathmlOptions.mAllowPlane1 ? '1' : '0';
+    key += static_cast<char>(
+        '0' + profile.mEncodingOptions.mMathmlEncoding
+    );
+    key += profile.mEncodingOptions.mOtherEncodingRaw ? '1' : '0';
+    key += profile.mEncodingOptions.mAllowPlane1 ? '1' : '0';
+    key += profile.mIndented ? '1' : '0';
+}
+
+// AppendSettingsKey() appends every setting that affects the output block
+// to a cache key. Strings are terminated by a NUL, so that no two
+// different sets of settings give the same key. (The "--debug" options
+// aren't included, since their output is never cached; nor is anything
+// that only affects how the PNG gets made.)
+void AppendSettingsKey(string& key, const Settings& settings)
+{
+    key += settings.mDoPng ? '1' : '0';
+    key += settings.mDoMathml ? '1' : '0';
+    key += settings.mValidate ? '1' : '0';
+    key += settings.mValidateLayout ? '1' : '0';
+    key += settings.mCanonicalHash ? '1' : '0';
+    key += settings.mTexvcCompatibility ? '1' : '0';
+    key += settings.mPurifiedTexOptions.mAllowUcs ? '1' : '0';
+    key += settings.mPurifiedTexOptions.mAllowCJK ? '1' : '0';
+    key += settings.mPurifiedTexOptions.mAllowPreview ? '1' : '0';
+    key += settings.mJapaneseFont;
+    key += '\0';
+    AppendProfileKey(key, settings.mMathmlProfile);
+    for (vector<string>::size_type
+        profile = 0; profile < settings.mProfiles.size(); profile++
+    )
+    {
+        key += settings.mProfileNames[profile];
+        key += '\0';
+        AppendProfileKey(key, settings.mProfiles[profile]);
+    }
+    key += '\0';
+}
+
+// AppendCacheKey() appends the cache key for converting "inputUtf8" with
+// "settings": the version, the settings and the input itself.
+void AppendCacheKey(
+    string& key,
+    const Settings& settings,
+    const string& inputUtf8
+)
+{
+    key += 'r';
+    key += gBlahtexVersion;
+    key += '\0';
+    AppendSettingsKey(key, settings);
+    key += inputUtf8;
+}
+
+// AppendCanonicalCacheKey() appends the cache key for the input that
+// "interface" has just processed, based on its canonical form instead of
+// the input. It has the canonical form and result format versions instead
+// of the blahtex version, so that the entries stay valid across releases
+// that don't change the output.
+void AppendCanonicalCacheKey(
+    string& key,
+    const Settings& settings,
+    blahtex::Interface& interface
+)
+{
+    char version[32];
+    snprintf(
+        version, sizeof(version), "c%d.%d",
+        Manager::cCanonicalFormVersion, cResultFormatVersion
+    );
+    key += version;
+    key += '\0';
+    AppendSettingsKey(key, settings);
+    key += interface.GetCanonicalFormUtf8();
+}
+
+// Returns the "--canonical-hash" for the input that "interface" has just
+// processed: the md5 of the canonical form, preceded by its version.
+string GetCanonicalHash(blahtex::Interface& interface)
+{
+    char version[16];
+    snprintf(
+        version, sizeof(version), "%d:", Manager::cCanonicalFormVersion
+    );
+    return ComputeMd5(version + interface.GetCanonicalFormUtf8());
+}
+
+// Returns true unless the block starting at output[blockStart] refers to
+// a PNG file that's no longer in the PNG directory.
+bool IsPngPresent(
+    const Settings& settings,
+    const string& output,
+    string::size_type blockStart
+)
+{
+    string::size_type start = output.find("<md5>", blockStart);
+    if (start == string::npos)
+        return true;
+    start += 5;
+    string::size_type end = output.find("</md5>", start);
+    if (end == string::npos)
+        return false;
+
+    struct stat status;
+    return stat(
+        (settings.mPngDirectory + output.substr(start, end - start) +
+            ".png").c_str(),
+        &status
+    ) == 0;
+}
+
+// ConvertUncached() does the work of ConvertInput(). It returns false if
+// the block it appended mustn't be cached.
+//
+// If "canonicalKey" isn't NULL, then once the input has been parsed, its
+// canonical cache key is stored there and looked up in settings.mCache.
+// If it's found, the cached block is used, and the key is cleared (so the
+// caller knows not to store it again).
+bool ConvertUncached(
+    const Settings& settings,
+    const string& inputUtf8,
+    blahtex::Interface& interface,
+    string& output,
+    string* canonicalKey
+)
+{
+    bool isCacheable = true;
+
+    interface.mMathmlOptions   = settings.mMathmlProfile.mMathmlOptions;
+    interface.mEncodingOptions = settings.mMathmlProfile.mEncodingOptions;
+    interface.mIndented        = settings.mMathmlProfile.mIndented;
+    interface.mPurifiedTexOptions = settings.mPurifiedTexOptions;
+    interface.mTexvcCompatibility = settings.mTexvcCompatibility;
+
+    // Everything is appended directly to "output", in UTF-8; the only
+    // wstrings are the ones inside the core. When an error replaces some
+    // output that has already been written, we just cut "output" back to
+    // the right length.
+    string::size_type blockStart = output.size();
+
+    // The following errors might occur if there's a bug in blahtex that
+    // some assertion condition picked up. We still want to report these
+    // nicely to the user so that they can notify the developers.
+    try
+    {
+        output += "<blahtex>\n";
+        string::size_type mainStart = output.size();
+
+        try
+        {
+            if (!settings.mJapaneseFont.empty() &&
+                !DecodeUtf8(
+                    settings.mJapaneseFont,
+                    interface.mPurifiedTexOptions.mJapaneseFont
+                )
+            )
+                throw blahtex::Exception(L"InvalidUtf8Input");
+
+            // Build the parse tree (or just check it, for "--validate").
+            // Syntax errors (including invalid UTF-8) are so common that
+            // they are returned rather than thrown; see
+            // Interface::TryProcessInput.
+            blahtex::Exception inputError;
+            bool isValid = settings.mValidate
+                ? interface.TryValidateUtf8(
+                    inputUtf8, settings.mValidateLayout, inputError
+                )
+                : interface.TryProcessInputUtf8(inputUtf8, inputError);
+            if (!isValid)
+            {
+                AppendError(output, inputError, interface.mEncodingOptions);
+                output += "\n</blahtex>\n";
+                return true;
+            }
+
+            if (settings.mValidate)
+            {
+                output += "<valid/>\n</blahtex>\n";
+                return true;
+            }
+
+            if (canonicalKey)
+            {
+                AppendCanonicalCacheKey(*canonicalKey, settings, interface);
+                string cached;
+                if (settings.mCache->Lookup(*canonicalKey, cached) &&
+                    (!settings.mDoPng || IsPngPresent(settings, cached, 0))
+                )
+                {
+                    output.resize(blockStart);
+                    output += cached;
+                    canonicalKey->clear();
+                    return true;
+                }
+            }
+
+            if (settings.mCanonicalHash)
+            {
+                output += "<canonicalHash>";
+                output += GetCanonicalHash(interface);
+                output += "</canonicalHash>\n";
+            }
+
+            if (settings.mDebugParseTree)
+            {
+                output += "\n=== BEGIN PARSE TREE ===\n\n";
+                wostringstream temp;
+                interface.GetManager()->GetParseTree()->Print(temp);
+                AppendUtf8(output, temp.str());
+                output += "\n=== END PARSE TREE ===\n\n";
+            }
+
+            if (settings.mDebugLayoutTree)
+            {
+                output += "\n=== BEGIN LAYOUT TREE ===\n\n";
+                wostringstream temp;
+                interface.GetManager()->GetLayoutTree()->Print(temp);
+                XmlEncode(output, temp.str(), EncodingOptions());
+                output += "\n=== END LAYOUT TREE ===\n\n";
+            }
+
+            // Generate purified TeX if required.
+            if (settings.mDoPng || settings.mDebugPurifiedTex)
+            {
+                // This is where the PNG output block starts:
+                output += "<png>\n";
+                string::size_type pngStart = output.size();
+
+                try
+                {
+                    string purifiedTex = interface.GetPurifiedTexUtf8();
+
+                    if (settings.mDebugPurifiedTex)
+                    {
+                        output += "\n=== BEGIN PURIFIED TEX ===\n\n";
+                        output += purifiedTex;
+                        output += "\n=== END PURIFIED TEX ===\n\n";
+                    }
+
+                    // Make the system calls to generate the PNG image
+                    // if requested.
+                    if (settings.mDoPng)
+                    {
+                        // A failure here is most likely a problem with
+                        // latex or dvipng, not with the input, and so it
+                        // might not happen next time.
+                        isCacheable = false;
+                        PngInfo info = MakePngFile(
+                            purifiedTex,
+                            settings.mTempDirectory,
+                            settings.mPngDirectory,
+                            settings.mShellLatex,
+                            settings.mShellDvipng,
+                            settings.mDeleteTempFiles
+                        );
+                        isCacheable = true;
+
+                        // The height and depth measurements are only
+                        // valid if the "preview" package is used:
+                        if (interface.mPurifiedTexOptions.mAllowPreview
+                            && info.mDimensionsValid
+                        )
+                        {
+                            AppendNumberElement(
+                                output, "height", info.mHeight
+                            );
+                            AppendNumberElement(
+                                output, "depth", info.mDepth
+                            );
+                        }
+
+                        output += "<md5>";
+                        output += info.mMd5;
+                        output += "</md5>\n";
+                    }
+                }
+
+                // Catching errors that occurred during PNG generation:
+                catch (blahtex::Exception& e)
+                {
+                    output.resize(pngStart);
+                    AppendError(output, e, interface.mEncodingOptions);
+                    output += "\n";
+                }
+
+                output += "</png>\n";
+            }
+
+            // This block generates MathML output if requested.
+            if (settings.mDoMathml)
+            {
+                output += "<mathml>\n";
+                string::size_type mathmlStart = output.size();
+
+                try
+                {
+                    output += "<markup>\n";
+                    interface.AppendMathmlUtf8(output);
+                    if (!interface.mIndented)
+                        output += "\n";
+                    output += "</markup>\n";
+                }
+
+                // Catch errors in generating the MathML:
+                catch (blahtex::Exception& e)
+                {
+                    output.resize(mathmlStart);
+                    AppendError(output, e, interface.mEncodingOptions);
+                    output += "\n";
+                }
+
+                output += "</mathml>\n";
+            }
+
+            // The MathML variants for the "--mathml-profile" options all
+            // come from the same parse.
+            if (!settings.mProfiles.empty())
+            {
+                vector<MathmlVariant> variants;
+                interface.GetMathmlVariantsUtf8(settings.mProfiles, variants);
+
+                for (vector<MathmlVariant>::size_type
+                    index = 0; index < variants.size(); index++
+                )
+                {
+                    const MathmlProfile& profile = settings.mProfiles[index];
+                    const MathmlVariant& variant = variants[index];
+
+                    output += "<mathml profile=\"";
+                    output += settings.mProfileNames[index];
+                    output += "\">\n";
+                    if (variant.mHasError)
+                    {
+                        AppendError(
+                            output, variant.mError, profile.mEncodingOptions
+                        );
+                        output += "\n";
+                    }
+                    else
+                    {
+                        output += "<markup>\n";
+                        output += variant.mMathml;
+                        if (!profile.mIndented)
+                            output += "\n";
+                        output += "</markup>\n";
+                    }
+                    output += "</mathml>\n";
+                }
+            }
+        }
+
+        // This catches input syntax errors.
+        catch (blahtex::Exception& e)
+        {
+            output.resize(mainStart);
+            AppendError(output, e, interface.mEncodingOptions);
+            output += "\n";
+        }
+
+        output += "</blahtex>\n";
+    }
+
+    catch (std::logic_error& e)
+    {
+        // WARNING: this doesn't XML-encode the message
+        // (We don't expect to the message to contain the characters &<>)
+        output.resize(blockStart);
+        output += "<blahtex>\n<logicError>";
+        output += e.what();
+        output += "</logicError>\n</blahtex>\n";
+        isCacheable = false;
+    }
+
+    return isCacheable;
+}
+
+// ConvertWithResultCache() converts "inputUtf8", whose cache key is "key",
+// using settings.mCache if there is one. It returns false if the block
+// mustn't be cached.
+bool ConvertWithResultCache(
+    const Settings& settings,
+    const string& key,
+    const string& inputUtf8,
+    blahtex::Interface& interface,
+    string& output
+)
+{
+    if (!settings.mCache)
+        return ConvertUncached(settings, inputUtf8, interface, output, NULL);
+
+    string::size_type blockStart = output.size();
+    if (settings.mCache->Lookup(key, output))
+    {
+        if (!settings.mDoPng || IsPngPresent(settings, output, blockStart))
+            return true;
+        output.resize(blockStart);
+    }
+
+    // The block is stored under both keys, so that the next time this
+    // exact input comes along, it doesn't even need parsing.
+    string canonicalKey;
+    if (!ConvertUncached(
+        settings, inputUtf8, interface, output, &canonicalKey
+    ))
+        return false;
+
+    const char* block = output.data() + blockStart;
+    size_t blockLength = output.size() - blockStart;
+    settings.mCache->Insert(key, block, blockLength);
+    if (!canonicalKey.empty())
+        settings.mCache->Insert(canonicalKey, block, blockLength);
+    return true;
+}
+
+// MemoryCacheClaim looks after a key claimed by
+// MemoryCache::LookupOrClaim(): unless Insert() gets called, it releases
+// the key when it goes out of scope (even if that's because of an
+// exception), so that other threads waiting for it don't wait forever.
+class MemoryCacheClaim
+{
+    MemoryCache& mCache;
+    const string& mKey;
+    bool mIsInserted;
+
+public:
+    MemoryCacheClaim(MemoryCache& cache, const string& key) :
+        mCache(cache),
+        mKey(key),
+        mIsInserted(false)
+    { }
+
+    ~MemoryCacheClaim()
+    {
+        if (!mIsInserted)
+            mCache.Release(mKey);
+    }
+
+    void Insert(const char* value, size_t valueLength)
+    {
+        mCache.Insert(mKey, value, valueLength);
+        mIsInserted = true;
+    }
+};
+
+void ConvertInput(
+    const Settings& settings,
+    const string& inputUtf8,
+    blahtex::Interface& interface,
+    string& output
+)
+{
+    if ((!settings.mCache && !settings.mMemoryCache) ||
+        settings.mDebugParseTree || settings.mDebugLayoutTree ||
+        settings.mDebugPurifiedTex
+    )
+    {
+        ConvertUncached(settings, inputUtf8, interface, output, NULL);
+        return;
+    }
+
+    string key;
+    AppendCacheKey(key, settings, inputUtf8);
+
+    MemoryCache* memoryCache = settings.mMemoryCache;
+    if (!memoryCache)
+    {
+        ConvertWithResultCache(settings, key, inputUtf8, interface, output);
+        return;
+    }
+
+    // If another thread is converting the same input, this waits for it
+    // and then uses its result, rather than converting (or running latex)
+    // again.
+    string::size_type blockStart = output.size();
+    while (memoryCache->LookupOrClaim(key, output))
+    {
+        if (!settings.mDoPng || IsPngPresent(settings, output, blockStart))
+            return;
+        output.resize(blockStart);
+        memoryCache->Erase(key);
+    }
+
+    MemoryCacheClaim claim(*memoryCache, key);
+    if (ConvertWithResultCache(settings, key, inputUtf8, interface, output))
+        claim.Insert(output.data() + blockStart, output.size() - blockStart);
+}
+
+// Appends a "--cache-stats" line.
+void AppendCounter(string& output, const char* name, uint64_t value)
+{
+    char line[64];
+    snprintf(
+        line, sizeof(line), "%s %llu\n", name,
+        static_cast<unsigned long long>(value)
+    );
+    output += line;
+}
+
+void AppendCacheStatistics(string& output, const Settings& settings)
+{
+    if (settings.mCache)
+    {
+        ResultCache::Statistics statistics =
+            settings.mCache->GetStatistics();
+        AppendCounter(output, "hits", statistics.mHits);
+        AppendCounter(output, "misses", statistics.mMisses);
+        AppendCounter(output, "inserts", statistics.mInserts);
+        AppendCounter(output, "resets", statistics.mResets);
+        AppendCounter(output, "entries", statistics.mEntries);
+        AppendCounter(output, "bytes-used", statistics.mBytesUsed);
+        AppendCounter(output, "file-size", statistics.mFileSize);
+    }
+
+    if (settings.mMemoryCache)
+    {
+        MemoryCache::Statistics statistics =
+            settings.mMemoryCache->GetStatistics();
+        AppendCounter(output, "memory-hits", statistics.mHits);
+        AppendCounter(output, "memory-misses", statistics.mMisses);
+        AppendCounter(output, "memory-coalesced", statistics.mCoalesced);
+        AppendCounter(output, "memory-inserts", statistics.mInserts);
+        AppendCounter(output, "memory-evictions", statistics.mEvictions);
+        AppendCounter(output, "memory-entries", statistics.mEntries);
+        AppendCounter(output, "memory-bytes-used", statistics.mBytesUsed);
+        AppendCounter(output, "memory-budget", statistics.mBudget);
+    }
+}
+
+void AppendErrorBlock(
+    string& output,
+    const blahtex::Exception& e,
+    const Settings& settings
+)
+{
+    output += "<blahtex>\n";
+    AppendError(output, e, settings.mMathmlProfile.mEncodingOptions);
+    output += "\n</blahtex>\n";
+}
+
+string ErrorMessagesUtf8()
+{
+    string output;
+    AppendUtf8(output, GetErrorMessages());
+    return output;
+}
+
+bool ReadAll(int fd, string& output)
+{
+    char buffer[65536];
+    while (true)
+    {
+        ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count > 0)
+            output.append(buffer, count);
+        else if (count == 0)
+            return true;
+        else if (errno != EINTR)
+            return false;
+    }
+}
+
+bool WriteAll(int fd, const string* blocks, size_t count)
+{
+#ifdef IOV_MAX
+    const size_t cMaxBlocks = IOV_MAX < 1024 ? IOV_MAX : 1024;
+#else
+    const size_t cMaxBlocks = 16;
+#endif
+
+    // Skip empty blocks up front, so that every iovec in the batch is
+    // non-empty and a zero-length write can't be mistaken for progress.
+    iovec vectors[cMaxBlocks];
+    size_t next = 0;
+    while (true)
+    {
+        size_t used = 0;
+        for (; next < count && used < cMaxBlocks; next++)
+            if (!blocks[next].empty())
+            {
+                vectors[used].iov_base =
+                    const_cast<char*>(blocks[next].data());
+                vectors[used].iov_len = blocks[next].size();
+                used++;
+            }
+
+        if (used == 0)
+            return true;
+
+        iovec* current = vectors;
+        while (used > 0)
+        {
+            ssize_t written = writev(fd, current, used);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+
+            // Step over whatever the kernel accepted; a partial write
+            // leaves us part way through one of the blocks.
+            size_t remaining = written;
+            while (used > 0 && remaining >= current->iov_len)
+            {
+                remaining -= current->iov_len;
+                current++;
+                used--;
+            }
+            if (used > 0)
+            {
+                current->iov_base =
+                    static_cast<char*>(current->iov_base) + remaining;
+                current->iov_len -= remaining;
+            }
+        }
+    }
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -0,0 +1,244 @@
+// File "mainConvert.h"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef BLAHTEX_MAINCONVERT_H
+#define BLAHTEX_MAINCONVERT_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "BlahtexCore/Interface.h"
+#include "mainCache.h"
+
+// The version number, which is also part of every cache key.
+extern std::string gBlahtexVersion;
+
+// The version of the output block format produced by this front end: the
+// layout of the <blahtex> block built in mainConvert.cpp, and the error
+// messages in Messages.cpp. It is part of the cache keys based on the
+// canonical form (which, unlike the others, don't contain
+// gBlahtexVersion), so it must be bumped whenever either of those
+// changes, or old cached blocks would still be returned.
+const int cResultFormatVersion = 1;
+
+// CommandLineException is used for reporting incorrect command line
+// syntax.
+struct CommandLineException
+{
+    std::string mMessage;
+
+    CommandLineException(
+        const std::string& message
+    ) :
+        mMessage(message)
+    { }
+};
+
+// Settings collects everything that can be specified on the command line.
+// In server mode, the command line supplies the default settings, and each
+// request may override them using the same option names.
+struct Settings
+{
+    bool mDoPng;
+    bool mDoMathml;
+
+    // "--validate" and "--validate-layout": only check the input, and
+    // report whether it's valid instead of converting it.
+    bool mValidate;
+    bool mValidateLayout;
+
+    // "--canonical-hash": report the md5 of the input's canonical form
+    // (see Manager::GetCanonicalForm) in a <canonicalHash> element.
+    bool mCanonicalHash;
+
+    bool mDebugLayoutTree;
+    bool mDebugParseTree;
+    bool mDebugPurifiedTex;
+    bool mDeleteTempFiles;
+
+    std::string mShellLatex;
+    std::string mShellDvipng;
+    std::string mTempDirectory;
+    std::string mPngDirectory;
+
+    // These get copied into the corresponding members of
+    // blahtex::Interface.
+    blahtex::MathmlProfile mMathmlProfile;
+    blahtex::PurifiedTexOptions mPurifiedTexOptions;
+    bool mTexvcCompatibility;
+
+    // The "--mathml-profile" arguments, in order: the name of each extra
+    // MathML variant, and the options it uses on top of mMathmlProfile
+    // (e.g. "--spacing relaxed --disallow-plane-1"). ParseOptions() works
+    // out the resulting profiles, in mProfiles.
+    std::vector<std::string> mProfileNames;
+    std::vector<std::string> mProfileOptions;
+    std::vector<blahtex::MathmlProfile> mProfiles;
+
+    // The "--japanese-font" argument, in UTF-8. It gets converted into
+    // mPurifiedTexOptions.mJapaneseFont by ConvertInput, so that an
+    // invalid font name is reported like any other invalid input.
+    std::string mJapaneseFont;
+
+    // Batch mode settings ("--batch", "--batch-format", "--jobs"). An empty
+    // mBatchFile means batch mode is off; "-" means standard input.
+    std::string mBatchFile;
+    bool mBatchNulSeparated;
+    unsigned mJobs;
+
+    // The persistent result cache ("--cache", "--cache-size"). The program
+    // opens mCacheFile after parsing the options, and sets mCache; NULL
+    // means there's no cache. mCacheSize is in bytes.
+    std::string mCacheFile;
+    size_t mCacheSize;
+    ResultCache* mCache;
+
+    // The in-process cache ("--memory-cache"), for server mode, batch mode
+    // and blahtexd; likewise created by the program, with a budget of
+    // mMemoryCacheSize bytes. Zero (the default) means there's none.
+    size_t mMemoryCacheSize;
+    MemoryCache* mMemoryCache;
+
+    // These are set by options which don't convert anything, but instead
+    // ask for something else to be done ("--help", "--print-error-messages",
+    // "--server" and "--cache-stats" respectively).
+    bool mShowUsage;
+    bool mPrintErrorMessages;
+    bool mServer;
+    bool mShowCacheStatistics;
+
+    Settings() :
+        mDoPng(false),
+        mDoMathml(false),
+        mValidate(false),
+        mValidateLayout(false),
+        mCanonicalHash(false),
+        mDebugLayoutTree(false),
+        mDebugParseTree(false),
+        mDebugPurifiedTex(false),
+        mDeleteTempFiles(true),
+        mShellLatex("latex"),
+        mShellDvipng("dvipng"),
+        mTempDirectory("./"),
+        mPngDirectory("./"),
+        mTexvcCompatibility(false),
+        mBatchNulSeparated(false),
+        mJobs(1),
+        mCacheSize(64 * 1024 * 1024),
+        mCache(NULL),
+        mMemoryCacheSize(0),
+        mMemoryCache(NULL),
+        mShowUsage(false),
+        mPrintErrorMessages(false),
+        mServer(false),
+        mShowCacheStatistics(false)
+    { }
+};
+
+// ParseOptions() applies the options in "args" (e.g. "--spacing",
+// "moderate", "--png") to "settings", and then recomputes
+// settings.mProfiles. Throws CommandLineException if the syntax is wrong.
+// It stops early after "--help" or "--print-error-messages", just like
+// the command line always has.
+extern void ParseOptions(
+    const std::vector<std::string>& args,
+    Settings& settings
+);
+
+// AppendErrorBlock() appends a complete "<blahtex>...</blahtex>" output
+// block, in UTF-8, reporting the given error. It's for errors detected
+// outside ConvertInput() (e.g. a malformed record in batch mode).
+extern void AppendErrorBlock(
+    std::string& output,
+    const blahtex::Exception& e,
+    const Settings& settings
+);
+
+// ConvertInput() runs a single UTF-8 input through the blahtex core using
+// the supplied settings, and appends the complete "<blahtex>...</blahtex>"
+// output block, in UTF-8, to "output". The MathML for each profile in
+// settings.mProfiles follows the ordinary MathML block, as
+// "<mathml profile="name">...</mathml>".
+//
+// If settings.mValidate is set, the input is only checked (see
+// Interface::Validate); the block then contains "<valid/>", or the same
+// error that a conversion would have reported, and all the options
+// asking for output are ignored. Everything in the block (MathML,
+// error messages etc) is written directly into "output", so a caller can
+// collect any amount of output in one buffer and write it out in one go.
+//
+// If settings.mMemoryCache is set, the block is looked up there first, and
+// stored there afterwards; concurrent calls for the same input (and
+// settings) wait for the first one to finish, and then share its block.
+//
+// If settings.mCache is set, the block is looked up in that cache next
+// (except with the "--debug" options), and stored there after a
+// successful conversion. An input that isn't in the cache is parsed, and
+// then looked up again by its canonical form, so that it can use a block
+// stored for a different spelling of the same formula. Blocks reporting
+// a std::logic_error, or an error from latex or dvipng, are never stored;
+// nor is a cached PNG block used if its PNG file has gone missing.
+//
+// Syntax errors and debug assertions (std::logic_error) are reported
+// inside the output block, so the caller can carry on with more input.
+// A std::runtime_error means blahtex is installed incorrectly, and is
+// passed on to the caller (leaving part of a block in "output").
+//
+// The Interface is supplied by the caller; it can be reused for any number
+// of conversions, but a thread that runs conversions concurrently with
+// other threads needs its own one.
+extern void ConvertInput(
+    const Settings& settings,
+    const std::string& inputUtf8,
+    blahtex::Interface& interface,
+    std::string& output
+);
+
+// AppendCacheStatistics() appends the "--cache-stats" output: one
+// "name value" line for each counter of settings.mCache and
+// settings.mMemoryCache (the latter prefixed by "memory-").
+extern void AppendCacheStatistics(
+    std::string& output,
+    const Settings& settings
+);
+
+// Returns the list of all error codes and messages, in UTF-8
+// (this is the "--print-error-messages" output).
+extern std::string ErrorMessagesUtf8();
+
+// ReadAll() appends everything that can be read from the file descriptor
+// "fd" to "output". Returns false on a read error.
+extern bool ReadAll(int fd, std::string& output);
+
+// WriteAll() writes the "count" strings starting at "blocks" to the file
+// descriptor "fd", in order, using as few system calls as it can. (All the
+// conversion output reaches standard output this way, rather than through
+// iostreams.) Returns false if writing fails, e.g. because the reader has
+// gone away.
+extern bool WriteAll(int fd, const std::string* blocks, size_t count);
+
+inline bool WriteAll(int fd, const std::string& data)
+{
+    return WriteAll(fd, &data, 1);
+}
+
+#endif
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -19,10 +19,12 @@
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 
 #include "BlahtexCore/Misc.h"
-#include "UnicodeConverter.h"
 #include "md5Wrapper.h"
 #include "mainPng.h"
 #include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
 #include <sys/stat.h>
 #include <iostream>
 #include <fstream>
@@ -33,10 +35,6 @@ using namespace std;
 using namespace blahtex;
 
 
-// From main.cpp:
-extern UnicodeConverter gUnicodeConverter;
-
-
 // TemporaryFile manages a temporary file; it deletes the named file when
 // the object goes out of scope.
 class TemporaryFile
@@ -64,6 +62,70 @@ public:
 };
 
 
+// RenderLock holds a flock() on the file "filename" for as long as it is in
+// scope, creating the file first if necessary. The file is deleted again
+// before the lock is released; a process that was waiting for the lock
+// notices this and starts again with a new file.
+//
+// If the lock can't be taken (e.g. the filesystem doesn't support flock),
+// RenderLock just does nothing, which is no worse than not locking at all.
+class RenderLock
+{
+    string mFilename;
+    int mFd;
+
+public:
+    RenderLock(const string& filename) :
+        mFilename(filename),
+        mFd(-1)
+    {
+        while (true)
+        {
+            mFd = open(mFilename.c_str(), O_RDWR | O_CREAT, 0666);
+            if (mFd == -1)
+                throw blahtex::Exception(L"CannotCreateTexFile");
+
+            int result;
+            while ((result = flock(mFd, LOCK_EX)) != 0 && errno == EINTR)
+                ;
+            if (result != 0)
+            {
+                close(mFd);
+                mFd = -1;
+                return;
+            }
+
+            // Check that the file we've locked is still the one with this
+            // name, i.e. that the previous holder didn't delete it while
+            // we were waiting.
+            struct stat locked, named;
+            if (fstat(mFd, &locked) == 0
+                && stat(mFilename.c_str(), &named) == 0
+                && locked.st_dev == named.st_dev
+                && locked.st_ino == named.st_ino
+            )
+                return;
+
+            close(mFd);
+        }
+    }
+
+    ~RenderLock()
+    {
+        if (mFd != -1)
+        {
+            unlink(mFilename.c_str());
+            close(mFd);
+        }
+    }
+
+private:
+    // Not copyable.
+    RenderLock(const RenderLock&);
+    RenderLock& operator=(const RenderLock&);
+};
+
+
 // Tests whether a file exists
 bool FileExists(const string& filename)
 {
@@ -74,42 +136,135 @@ bool FileExists(const string& filename)
 
 // Attempts to run given command from the given directory.
 // Returns true if the system() call was successful, otherwise false.
-// Can throw a "CannotChangeDirectory" exception if problems occur.
+// Can throw a "CannotChangeDirectory" exception if the directory doesn't
+// exist.
+//
+// The directory change happens in the shell that system() starts, rather
+// than via chdir(), since the working directory is shared by every thread
+// in the process.
 bool Execute(
     const string& command,
     const string& directory = "./"
 )
 {
-    char buffer[5000];
-
     bool NeedToChange = (directory != "" && directory != "./");
 
-    if (NeedToChange)
+    if (!NeedToChange)
+        return (system(command.c_str()) == 0);
+
+    struct stat temp;
+    if (stat(directory.c_str(), &temp) != 0 || !S_ISDIR(temp.st_mode))
+        throw blahtex::Exception(L"CannotChangeDirectory");
+
+    // Quote the directory for the shell: "'" becomes "'\''".
+    string quoted = "'";
+    for (string::const_iterator
+        ptr = directory.begin(); ptr != directory.end(); ptr++
+    )
     {
-        if (getcwd(buffer, 5000) == NULL)
-            throw blahtex::Exception(L"CannotChangeDirectory");
+        if (*ptr == '\'')
+            quoted += "'\\''";
+        else
+            quoted += *ptr;
+    }
+    quoted += "'";
 
-        if (chdir(directory.c_str()) != 0)
-            throw blahtex::Exception(L"CannotChangeDirectory");
+    return (system(("cd " + quoted + " && " + command).c_str()) == 0);
+}
+
+
+// Each PNG made by MakePngFile has a record stored beside it, in the same
+// directory with ".info" appended to its name. It looks like this:
+//
+//     blahtex-png 1
+//     <md5 of the purified TeX>
+//     <height> <depth>
+//
+// where the last line is "-" if dvipng didn't report the dimensions. It
+// lets MakePngFile use an existing PNG instead of making it again.
+const char cPngRecordHeader[] = "blahtex-png 1";
+
+// Reads the record for pngDirectory + pngFilename into "info". Returns
+// false if the PNG or its record is missing, or if the record wasn't
+// written for the given md5.
+bool ReadPngRecord(
+    const string& pngDirectory,
+    const string& pngFilename,
+    const string& md5,
+    PngInfo& info
+)
+{
+    ifstream recordFile(
+        (pngDirectory + pngFilename + ".info").c_str(),
+        ios::in | ios::binary
+    );
+    if (!recordFile)
+        return false;
+
+    string header, recordMd5, dimensions;
+    if (!getline(recordFile, header) || header != cPngRecordHeader
+        || !getline(recordFile, recordMd5) || recordMd5 != md5
+        || !getline(recordFile, dimensions)
+    )
+        return false;
+
+    if (dimensions == "-")
+        info.mDimensionsValid = false;
+    else
+    {
+        istringstream dimensionsStream(dimensions);
+        if (!(dimensionsStream >> info.mHeight >> info.mDepth))
+            return false;
+        info.mDimensionsValid = true;
     }
-    
-    bool result = (system(command.c_str()) == 0);
 
-    if (NeedToChange)
+    // The record is written after the PNG is in place, so this only fails
+    // if someone has deleted the PNG since.
+    if (!FileExists(pngDirectory + pngFilename))
+        return false;
+
+    info.mMd5 = md5;
+    return true;
+}
+
+// Stores the record for pngDirectory + pngFilename. It's written to
+// tempDirectory first and then renamed, so that ReadPngRecord never sees
+// half a record. Failure is ignored; the PNG will just get made again
+// next time.
+void WritePngRecord(
+    const string& tempDirectory,
+    const string& pngDirectory,
+    const string& pngFilename,
+    const PngInfo& info
+)
+{
+    string tempFilename = tempDirectory + info.mMd5 + ".info";
     {
-        if (chdir(buffer) != 0)
-            throw blahtex::Exception(L"CannotChangeDirectory");
+        ofstream recordFile(tempFilename.c_str(), ios::out | ios::binary);
+        recordFile << cPngRecordHeader << "\n" << info.mMd5 << "\n";
+        if (info.mDimensionsValid)
+            recordFile << info.mHeight << " " << info.mDepth << "\n";
+        else
+            recordFile << "-\n";
+        if (!recordFile)
+        {
+            unlink(tempFilename.c_str());
+            return;
+        }
     }
 
-    return result;
+    if (rename(
+        tempFilename.c_str(),
+        (pngDirectory + pngFilename + ".info").c_str()
+    ))
+        unlink(tempFilename.c_str());
 }
 
 
 PngInfo MakePngFile(
-    const wstring& purifiedTex,
+    const string& purifiedTexUtf8,
     const string& tempDirectory,
     const string& pngDirectory,
-    const string& pngFilename,
     const string& shellLatex,
     const string& shellDvipng,
     bool deleteTempFiles
@@ -117,13 +272,30 @@ PngInfo MakePngFile(
 {
     PngInfo info;
     
-    string purifiedTexUtf8 = gUnicodeConverter.ConvertOut(purifiedTex);
-    
     // This md5 is used for the temp filenames.
     string md5 = ComputeMd5(purifiedTexUtf8);
 
-    string pngActualFilename =
-        pngFilename.empty() ? (md5 + ".png") : pngFilename;
+    string pngFilename = md5 + ".png";
+
+    // If this TeX has been rendered before, the PNG is already there.
+    // (Unless we're keeping temp files, in which case the caller
+    // presumably wants to look at them.) This check needs no lock, since
+    // the PNG is named after the md5, so only this TeX ever gets rendered
+    // to it.
+    if (deleteTempFiles
+        && ReadPngRecord(pngDirectory, pngFilename, md5, info)
+    )
+        return info;
+
+    // Only one process (or thread) at a time renders any given TeX (the
+    // temp files are named after its md5, so two of them would trip over
+    // each other). Anyone else waits here, and then normally finds the PNG
+    // already made.
+    RenderLock renderLock(tempDirectory + md5 + ".lock");
+    if (deleteTempFiles
+        && ReadPngRecord(pngDirectory, pngFilename, md5, info)
+    )
+        return info;
 
     // Send output to tex file.
     {
@@ -164,18 +336,21 @@ PngInfo MakePngFile(
             shellDvipng + " " + md5 + ".dvi " +
                 "--picky --bg Transparent --gamma 1.3 -D 120 -q -T tight " +
                 "--height --depth " +
-                "-o \"" + pngActualFilename +
+                "-o \"" + pngFilename +
                 "\" > " + md5 + ".data 2>/dev/null", 
             tempDirectory
         )
         ||
-        !FileExists(tempDirectory + pngActualFilename)
+        !FileExists(tempDirectory + pngFilename)
     )
         throw blahtex::Exception(L"CannotRunDvipng");
         
+    // The record for the PNG being replaced (if any) goes first, so that
+    // it never describes the wrong image.
+    unlink((pngDirectory + pngFilename + ".info").c_str());
     if (rename(
-        (tempDirectory + pngActualFilename).c_str(),
-        (pngDirectory + pngActualFilename).c_str()
+        (tempDirectory + pngFilename).c_str(),
+        (pngDirectory + pngFilename).c_str()
     ))
         throw blahtex::Exception(L"CannotWritePngDirectory");
 
@@ -207,6 +382,7 @@ PngInfo MakePngFile(
     }
 
     info.mMd5 = md5;
+    WritePngRecord(tempDirectory, pngDirectory, pngFilename, info);
     return info;
 }
 
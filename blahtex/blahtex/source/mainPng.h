@@ -40,17 +40,25 @@ struct PngInfo
     { }
 };
 
-// Generates a PNG file. Uses tempDirectory for storage of temporary files
-// (.tex, .dvi, .log, .data). Expects tempDirectory and pngDirectory to
-// include a terminating slash. The output file will be stored in the
-// directory pngDirectory in the file pngFilename; if pngFilename is an
-// empty string, MakePngFile will just use the md5 that it computes (which
-// gets returned in PngInfo).
+// Generates a PNG file from the purified TeX (supplied in UTF-8). Uses
+// tempDirectory for storage of temporary files (.tex, .dvi, .log, .data).
+// Expects tempDirectory and pngDirectory to include a terminating slash.
+// The output file will be stored in the directory pngDirectory, named after
+// the md5 that MakePngFile computes (which gets returned in PngInfo).
+//
+// Alongside the PNG, MakePngFile stores a small record (the PNG's name with
+// ".info" appended) holding the md5 and dimensions. If that record is
+// already there for the same md5, and the PNG still exists, MakePngFile
+// returns its contents without running latex or dvipng at all (unless
+// deleteTempFiles is false). Concurrent calls for the same TeX wait for
+// each other, using a lock file in tempDirectory.
+//
+// MakePngFile doesn't touch any global state (in particular it never
+// changes the working directory), so several threads may call it at once.
 extern PngInfo MakePngFile(
-    const std::wstring& purifiedTex,
+    const std::string& purifiedTexUtf8,
     const std::string& tempDirectory,
     const std::string& pngDirectory,
-    const std::string& pngFilename,
     const std::string& shellLatex,
     const std::string& shellDvipng,
     bool deleteTempFiles
@@ -0,0 +1,253 @@
+// File "mainServer.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#include "mainServer.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+// Reads a decimal byte count starting at header[pos], and advances pos
+// past it. Returns false if there are no digits there, or if the count
+// exceeds cMaxRequestSize (checked digit by digit, so it can't overflow).
+bool ParseLength(
+    const string& header,
+    string::size_type& pos,
+    string::size_type& length
+)
+{
+    string::size_type start = pos;
+    length = 0;
+    for (; pos < header.size() && header[pos] >= '0' && header[pos] <= '9';
+        pos++
+    )
+    {
+        length = length * 10 + (header[pos] - '0');
+        if (length > cMaxRequestSize)
+            return false;
+    }
+    return pos > start;
+}
+
+bool ParseRequestHeader(
+    const string& header,
+    string::size_type& optionsLength,
+    string::size_type& inputLength
+)
+{
+    string::size_type pos = 0;
+    if (!ParseLength(header, pos, optionsLength) ||
+        pos == header.size() || header[pos++] != ' ' ||
+        !ParseLength(header, pos, inputLength)
+    )
+        return false;
+
+    // Allow for clients that send "\r\n", as SplitOptions() does.
+    if (pos < header.size() && header[pos] == '\r')
+        pos++;
+
+    return pos == header.size() &&
+        inputLength <= cMaxRequestSize - optionsLength;
+}
+
+vector<string> SplitOptions(const string& options)
+{
+    vector<string> output;
+    istringstream is(options);
+    string line;
+    while (getline(is, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+        if (!line.empty())
+            output.push_back(line);
+    }
+    return output;
+}
+
+void HandleRequest(
+    const Settings& defaultSettings,
+    const string& options,
+    const string& input,
+    blahtex::Interface& interface,
+    string& response
+)
+{
+    Settings settings = defaultSettings;
+    settings.mServer = false;
+
+    try
+    {
+        ParseOptions(SplitOptions(options), settings);
+
+        // The commands and directories used for PNG generation can only
+        // be set when the server starts; otherwise anyone able to send
+        // requests could run any command, or write files anywhere.
+        if (settings.mShowUsage || settings.mServer ||
+            !settings.mBatchFile.empty() ||
+            settings.mCacheFile != defaultSettings.mCacheFile ||
+            settings.mMemoryCacheSize != defaultSettings.mMemoryCacheSize ||
+            settings.mShellLatex != defaultSettings.mShellLatex ||
+            settings.mShellDvipng != defaultSettings.mShellDvipng ||
+            settings.mTempDirectory != defaultSettings.mTempDirectory ||
+            settings.mPngDirectory != defaultSettings.mPngDirectory
+        )
+            throw CommandLineException(
+                "Option not available in a server request"
+            );
+    }
+    catch (CommandLineException& e)
+    {
+        response += "blahtex: ";
+        response += e.mMessage;
+        response += " (try \"blahtex --help\")\n";
+        return;
+    }
+    catch (std::logic_error& e)
+    {
+        // i.e. "--throw-logic-error"
+        response += "<blahtex>\n<logicError>";
+        response += e.what();
+        response += "</logicError>\n</blahtex>\n";
+        return;
+    }
+
+    if (settings.mPrintErrorMessages)
+    {
+        response += ErrorMessagesUtf8();
+        response += "\n";
+        return;
+    }
+
+    if (settings.mShowCacheStatistics)
+    {
+        if (settings.mCache || settings.mMemoryCache)
+            AppendCacheStatistics(response, settings);
+        else
+            response +=
+                "blahtex: \"--cache-stats\" needs \"--cache\" or "
+                "\"--memory-cache\" (try \"blahtex --help\")\n";
+        return;
+    }
+
+    ConvertInput(settings, input, interface, response);
+}
+
+// Reads exactly "length" bytes from standard input into "output". It reads
+// a buffer at a time rather than allocating "length" bytes up front, so
+// that memory is only used for input that actually arrives. Returns false
+// if the input ends first.
+bool ReadBlock(string::size_type length, string& output)
+{
+    output.clear();
+    char buffer[65536];
+    while (output.size() < length)
+    {
+        streamsize wanted = static_cast<streamsize>(
+            min<string::size_type>(sizeof(buffer), length - output.size())
+        );
+        cin.read(buffer, wanted);
+        output.append(buffer, cin.gcount());
+        if (cin.gcount() != wanted)
+            return false;
+    }
+    return true;
+}
+
+// Reads a request header line (without the newline) from standard input
+// into "header". Returns false at the end of input. As in blahtexd, a line
+// longer than cMaxRequestSize is given up on; "header" is then left empty,
+// so that it gets rejected as malformed.
+bool ReadHeader(string& header)
+{
+    header.clear();
+    int c;
+    while ((c = cin.get()) != '\n')
+    {
+        if (c == EOF)
+            return !header.empty();
+        if (header.size() == cMaxRequestSize)
+        {
+            header.clear();
+            return true;
+        }
+        header += static_cast<char>(c);
+    }
+    return true;
+}
+
+// Writes response[1] to standard output, preceded by its length header
+// (which goes in response[0]), in a single writev().
+void WriteResponse(string* response)
+{
+    char length[32];
+    snprintf(
+        length, sizeof(length), "%lu\n",
+        static_cast<unsigned long>(response[1].size())
+    );
+    response[0] = length;
+    if (!WriteAll(1, response, 2))
+        throw runtime_error("Cannot write to standard output");
+}
+
+void RunServer(const Settings& defaultSettings)
+{
+    blahtex::Interface interface;
+    string response[2];
+
+    string header;
+    while (ReadHeader(header))
+    {
+        string::size_type optionsLength, inputLength;
+        if (!ParseRequestHeader(header, optionsLength, inputLength))
+        {
+            // We can't find the next request, so stop after telling the
+            // client why, as blahtexd does.
+            response[1] =
+                "blahtex: Malformed request header in server mode\n";
+            WriteResponse(response);
+            return;
+        }
+
+        string options, input;
+        if (!ReadBlock(optionsLength, options) ||
+            !ReadBlock(inputLength, input)
+        )
+            throw CommandLineException(
+                "Unexpected end of input in server mode"
+            );
+
+        // Both response buffers keep their capacity between requests.
+        response[1].clear();
+        HandleRequest(
+            defaultSettings,
+            options,
+            input,
+            interface,
+            response[1]
+        );
+        WriteResponse(response);
+    }
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
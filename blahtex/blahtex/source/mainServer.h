@@ -0,0 +1,93 @@
+// File "mainServer.h"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+#ifndef BLAHTEX_MAINSERVER_H
+#define BLAHTEX_MAINSERVER_H
+
+#include <string>
+#include <vector>
+#include "mainConvert.h"
+
+// Server mode ("--server") lets a single blahtex process convert a whole
+// stream of inputs, so that process startup is only paid once.
+//
+// Each request looks like this:
+//
+//     <optionsLength> <inputLength>\n
+//     <options><input>
+//
+// where the header line contains two decimal byte counts. The options
+// block contains command line options, one per line, exactly as they
+// would be given to blahtex on the command line (e.g. "--spacing\n
+// moderate\n--png\n"); it may be empty. These options are applied on top
+// of the options the server itself was started with. The input block is
+// the TeX input, in UTF-8.
+//
+// Each response looks like this:
+//
+//     <outputLength>\n
+//     <output>
+//
+// where the output is exactly what the command line version would have
+// printed for the same input and options, in UTF-8.
+
+// Requests bigger than this are rejected. (The blahtex core refuses
+// anything with more than cMaxParseCost tokens anyway.)
+const std::string::size_type cMaxRequestSize = 1 << 20;
+
+// ParseRequestHeader() reads the two byte counts from a request header
+// line (without the trailing newline). Returns false if it is malformed,
+// i.e. unless it is exactly two runs of decimal digits separated by a
+// single space (and optionally followed by '\r'), or if the two counts
+// add up to more than cMaxRequestSize.
+extern bool ParseRequestHeader(
+    const std::string& header,
+    std::string::size_type& optionsLength,
+    std::string::size_type& inputLength
+);
+
+// SplitOptions() splits a request options block into separate arguments.
+// Blank lines (and a trailing '\r', for clients that send "\r\n") are
+// ignored.
+extern std::vector<std::string> SplitOptions(const std::string& options);
+
+// HandleRequest() processes a single request and appends the response
+// body (without the length header) to "response". The Interface is used
+// as for ConvertInput.
+extern void HandleRequest(
+    const Settings& defaultSettings,
+    const std::string& options,
+    const std::string& input,
+    blahtex::Interface& interface,
+    std::string& response
+);
+
+// RunServer() reads requests from standard input and writes responses to
+// standard output until end of input.
+//
+// If a request header is malformed, it sends a "Malformed request header"
+// response and stops, since at that point we can't tell where the next
+// request starts. Throws CommandLineException if the input ends in the
+// middle of a request.
+extern void RunServer(const Settings& defaultSettings);
+
+#endif
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -0,0 +1,141 @@
+// File "startupBenchmark.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// startup-benchmark measures how long blahtex takes to get going, which
+// matters because the usual way of running it is once per formula.
+//
+// Each run forks, execs "blahtex --mathml" with the formula "x" on
+// standard input, and times the interval from just before the fork until
+// the first byte of output arrives. Since "x" takes next to no time to
+// convert, this is almost entirely process startup: loading, static
+// initialisation, and reading the input.
+//
+// Usage: startup-benchmark [path-to-blahtex [runs]]
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <time.h>
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+double Now()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+// Runs blahtex once, and returns the time in microseconds until its first
+// byte of output.
+double TimeOneRun(const string& path)
+{
+    int input[2], output[2];
+    if (pipe(input) != 0 || pipe(output) != 0)
+        throw runtime_error("Cannot create pipe");
+
+    double start = Now();
+
+    pid_t pid = fork();
+    if (pid < 0)
+        throw runtime_error("Cannot fork");
+
+    if (pid == 0)
+    {
+        dup2(input[0], 0);
+        dup2(output[1], 1);
+        close(input[0]);
+        close(input[1]);
+        close(output[0]);
+        close(output[1]);
+        execl(path.c_str(), path.c_str(), "--mathml", (char*) NULL);
+        _exit(127);
+    }
+
+    close(input[0]);
+    close(output[1]);
+    if (write(input[1], "x", 1) != 1)
+        throw runtime_error("Cannot write to " + path);
+    close(input[1]);
+
+    char buffer[4096];
+    ssize_t count;
+    while ((count = read(output[0], buffer, 1)) < 0 && errno == EINTR)
+        ;
+    double finish = Now();
+    if (count != 1)
+        throw runtime_error("No output from " + path);
+
+    // Drain the rest of the output so that blahtex exits normally.
+    while ((count = read(output[0], buffer, sizeof(buffer))) > 0 ||
+        (count < 0 && errno == EINTR)
+    )
+        ;
+    close(output[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        throw runtime_error("Failed to run " + path);
+
+    return finish - start;
+}
+
+int main(int argc, char* const argv[])
+{
+    try
+    {
+        string path = (argc > 1) ? argv[1] : "./blahtex";
+        long runs = (argc > 2) ? atol(argv[2]) : 200;
+        if (runs <= 0)
+            runs = 1;
+
+        // One run first to get the binary into the page cache.
+        TimeOneRun(path);
+
+        vector<double> times;
+        for (long i = 0; i < runs; i++)
+            times.push_back(TimeOneRun(path));
+        sort(times.begin(), times.end());
+
+        cout << path << " --mathml, exec to first byte, " << runs
+            << " runs: median " << static_cast<long>(times[runs / 2])
+            << " us, min " << static_cast<long>(times.front())
+            << " us, max " << static_cast<long>(times.back())
+            << " us" << endl;
+    }
+
+    catch (std::runtime_error& e)
+    {
+        cerr << "startup-benchmark: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -0,0 +1,286 @@
+// File "threadStress.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// thread-stress checks the thread safety guarantee documented in
+// Interface.h: it converts a list of formulas on several threads at once,
+// each thread with its own Interface, and compares every result with the
+// one obtained beforehand on a single thread. The formulas are read from a
+// file, one per line in UTF-8, or a built-in list is used (including some
+// invalid ones, so that the error paths get exercised too). Each formula
+// is converted with several sets of options.
+//
+// "make thread-stress" builds it with -fsanitize=thread, so that any data
+// race in the core gets reported by ThreadSanitizer as well. The exit
+// status is nonzero if any result differs.
+//
+// Usage: thread-stress [formula-file [threads [rounds]]]
+
+#include <pthread.h>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "BlahtexCore/Interface.h"
+
+using namespace std;
+using namespace blahtex;
+
+const char* const gDefaultFormulas[] =
+{
+    "x^2 + y^2 = z^2",
+    "\\frac{-b \\pm \\sqrt{b^2 - 4ac}}{2a}",
+    "\\sum_{n=1}^\\infty \\frac{1}{n^2} = \\frac{\\pi^2}{6}",
+    "\\int_0^\\infty e^{-x^2}\\,dx = \\frac{\\sqrt\\pi}{2}",
+    "\\begin{pmatrix} a & b \\\\ c & d \\end{pmatrix}^{-1} = "
+        "\\frac{1}{ad - bc} \\begin{pmatrix} d & -b \\\\ -c & a "
+        "\\end{pmatrix}",
+    "f(x) = \\begin{cases} 0 & \\text{if } x < 0 \\\\ 1 & "
+        "\\text{otherwise} \\end{cases}",
+    "\\mathbb{N} \\subset \\mathbb{Z} \\subset \\mathbb{Q}",
+    "\\mathfrak{g} = \\mathfrak{sl}_2(\\mathbb{C})",
+    "\\mathcal{L}\\{f\\}(s) = \\int_0^\\infty f(t) e^{-st}\\,dt",
+    "\\left( \\sum_{i=1}^n a_i b_i \\right)^2 \\le "
+        "\\left( \\sum_{i=1}^n a_i^2 \\right) "
+        "\\left( \\sum_{i=1}^n b_i^2 \\right)",
+    "\\overrightarrow{AB} \\cdot \\overrightarrow{CD} = 0",
+    "\\begin{align} a &= b + c \\\\ &= d \\end{align}",
+    "\\sqrt[3]{x^3 + y^3} \\le |x| + |y|",
+    "\\operatorname{tr}(AB) = \\operatorname{tr}(BA)",
+    "\\text{\xc3\xa9t\xc3\xa9} + \xce\xb1",
+    "\\Bigl( \\frac{a}{b} \\Bigr) \\big| \\Biggr\\rangle",
+    "\\overset{a}{b}",
+    "\\underset{a}{b}",
+    "\\frac{a",
+    "x^2^3",
+    "\\unknowncommand",
+    "\\left( x",
+    "\\mathbb{\\alpha}"
+};
+
+// The option sets each formula is converted with.
+const int cOptionSetCount = 3;
+
+void SetOptions(Interface& interface, int optionSet)
+{
+    interface.mMathmlOptions = MathmlOptions();
+    interface.mEncodingOptions = EncodingOptions();
+    interface.mPurifiedTexOptions = PurifiedTexOptions();
+    interface.mTexvcCompatibility = false;
+    interface.mIndented = false;
+
+    switch (optionSet)
+    {
+        case 0:
+            break;
+
+        case 1:
+            interface.mTexvcCompatibility = true;
+            interface.mMathmlOptions.mUseVersion1FontAttributes = true;
+            interface.mMathmlOptions.mSpacingControl =
+                MathmlOptions::cSpacingControlRelaxed;
+            interface.mEncodingOptions.mMathmlEncoding =
+                EncodingOptions::cMathmlEncodingLong;
+            break;
+
+        case 2:
+            interface.mIndented = true;
+            interface.mMathmlOptions.mAllowPlane1 = false;
+            interface.mEncodingOptions.mAllowPlane1 = false;
+            interface.mEncodingOptions.mMathmlEncoding =
+                EncodingOptions::cMathmlEncodingRaw;
+            interface.mPurifiedTexOptions.mAllowUcs = true;
+            interface.mPurifiedTexOptions.mAllowPreview = true;
+            break;
+    }
+}
+
+void AppendCode(string& output, const Exception& e)
+{
+    // Error codes are plain ASCII.
+    const wstring& code = e.GetCode();
+    output.append(code.begin(), code.end());
+    output += "\n";
+}
+
+// Converts "formula" and returns everything generated, so that two
+// conversions can be compared.
+string Convert(Interface& interface, const string& formula)
+{
+    string output;
+    try
+    {
+        interface.ProcessInputUtf8(formula);
+    }
+    catch (Exception& e)
+    {
+        output = "input error ";
+        AppendCode(output, e);
+        return output;
+    }
+
+    try
+    {
+        output += interface.GetMathmlUtf8();
+    }
+    catch (Exception& e)
+    {
+        output += "mathml error ";
+        AppendCode(output, e);
+    }
+
+    try
+    {
+        output += interface.GetPurifiedTexUtf8();
+    }
+    catch (Exception& e)
+    {
+        output += "purified tex error ";
+        AppendCode(output, e);
+    }
+
+    output += interface.GetCanonicalFormUtf8();
+    return output;
+}
+
+struct Job
+{
+    const string* mFormula;
+    int mOptionSet;
+    string mExpected;
+};
+
+struct StressThread
+{
+    pthread_t mThread;
+    const vector<Job>* mJobs;
+    long mStart;
+    long mRounds;
+    long mMismatches;
+};
+
+void* RunStressThread(void* arg)
+{
+    StressThread& thread = *static_cast<StressThread*>(arg);
+    const vector<Job>& jobs = *thread.mJobs;
+
+    // Each thread starts at a different place in the list, so that the
+    // threads are working on different formulas at any moment.
+    Interface interface;
+    for (long round = 0; round < thread.mRounds; round++)
+        for (size_t i = 0; i < jobs.size(); i++)
+        {
+            const Job& job = jobs[(thread.mStart + i) % jobs.size()];
+            SetOptions(interface, job.mOptionSet);
+            if (Convert(interface, *job.mFormula) != job.mExpected)
+                thread.mMismatches++;
+        }
+
+    return NULL;
+}
+
+int main(int argc, char* const argv[])
+{
+    try
+    {
+        vector<string> formulas;
+        if (argc > 1)
+        {
+            ifstream file(argv[1], ios::in | ios::binary);
+            if (!file)
+                throw runtime_error(
+                    string("Cannot open \"") + argv[1] + "\""
+                );
+            string line;
+            while (getline(file, line))
+                if (!line.empty())
+                    formulas.push_back(line);
+        }
+        else
+            formulas.assign(
+                gDefaultFormulas,
+                END_ARRAY(gDefaultFormulas)
+            );
+
+        long threadCount = (argc > 2) ? atol(argv[2]) : 8;
+        if (threadCount <= 0)
+            threadCount = 1;
+        long rounds = (argc > 3) ? atol(argv[3]) : 20;
+        if (rounds <= 0)
+            rounds = 1;
+
+        // The expected results come from a single thread.
+        vector<Job> jobs;
+        Interface interface;
+        for (vector<string>::const_iterator
+            formula = formulas.begin(); formula != formulas.end(); formula++
+        )
+            for (int optionSet = 0; optionSet < cOptionSetCount; optionSet++)
+            {
+                Job job;
+                job.mFormula = &*formula;
+                job.mOptionSet = optionSet;
+                SetOptions(interface, optionSet);
+                job.mExpected = Convert(interface, *formula);
+                jobs.push_back(job);
+            }
+        if (jobs.empty())
+            throw runtime_error("No formulas to convert");
+
+        vector<StressThread> threads(threadCount);
+        for (long i = 0; i < threadCount; i++)
+        {
+            threads[i].mJobs = &jobs;
+            threads[i].mStart = i * jobs.size() / threadCount;
+            threads[i].mRounds = rounds;
+            threads[i].mMismatches = 0;
+            if (pthread_create(
+                &threads[i].mThread, NULL, RunStressThread, &threads[i]
+            ))
+                throw runtime_error("Cannot create thread");
+        }
+
+        long mismatches = 0;
+        for (long i = 0; i < threadCount; i++)
+        {
+            pthread_join(threads[i].mThread, NULL);
+            mismatches += threads[i].mMismatches;
+        }
+
+        cout << formulas.size() << " formulas x " << cOptionSetCount
+            << " option sets, " << threadCount << " threads x " << rounds
+            << " rounds: " << jobs.size() * threadCount * rounds
+            << " conversions, " << mismatches << " mismatches" << endl;
+
+        if (mismatches)
+            return 1;
+    }
+
+    catch (std::runtime_error& e)
+    {
+        cerr << "thread-stress: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -0,0 +1,327 @@
+// File "unicodeBenchmark.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// unicode-benchmark compares UnicodeConverter with the iconv() based
+// implementation it replaced (reproduced below as IconvConverter). It
+// times ConvertIn() on a list of formulas, and ConvertOut() on the MathML
+// that blahtex generates for them, which is the kind of text the command
+// line version converts. The formulas are read from a file, one per line
+// in UTF-8, or a built-in list of typical ones is used. It also checks
+// that both converters give the same results.
+//
+// Usage: unicode-benchmark [formula-file [rounds]]
+
+#include <time.h>
+#include <iconv.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "UnicodeConverter.h"
+#include "BlahtexCore/Interface.h"
+
+using namespace std;
+
+const char* const gDefaultFormulas[] =
+{
+    "x^2 + y^2 = z^2",
+    "\\frac{-b \\pm \\sqrt{b^2 - 4ac}}{2a}",
+    "\\sum_{n=1}^\\infty \\frac{1}{n^2} = \\frac{\\pi^2}{6}",
+    "\\int_0^\\infty e^{-x^2}\\,dx = \\frac{\\sqrt\\pi}{2}",
+    "\\lim_{x \\to 0} \\frac{\\sin x}{x} = 1",
+    "\\begin{pmatrix} a & b \\\\ c & d \\end{pmatrix}^{-1} = "
+        "\\frac{1}{ad - bc} \\begin{pmatrix} d & -b \\\\ -c & a "
+        "\\end{pmatrix}",
+    "f(x) = \\begin{cases} 0 & \\text{if } x < 0 \\\\ 1 & "
+        "\\text{otherwise} \\end{cases}",
+    "\\mathbb{N} \\subset \\mathbb{Z} \\subset \\mathbb{Q} \\subset "
+        "\\mathbb{R} \\subset \\mathbb{C}",
+    "\\alpha + \\beta + \\gamma + \\delta + \\varepsilon + \\zeta "
+        "+ \\eta + \\theta",
+    "a \\leq b \\geq c \\neq d \\approx e \\equiv f \\pmod{n}",
+    "\\langle \\psi | \\hat{H} | \\psi \\rangle",
+    "\\left( \\sum_{i=1}^n a_i b_i \\right)^2 \\le "
+        "\\left( \\sum_{i=1}^n a_i^2 \\right) "
+        "\\left( \\sum_{i=1}^n b_i^2 \\right)",
+    "P(A \\mid B) = \\frac{P(B \\mid A)\\,P(A)}{P(B)}",
+    "\\text{\xc3\xa9t\xc3\xa9} = \xce\xb1 + \xce\xb2",
+    "\\det(A - \\lambda I) = 0"
+};
+
+double Now()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+// IconvConverter is UnicodeConverter as it was before blahtex had its own
+// UTF-8 code: each conversion copies its input into a scratch buffer,
+// allocates a worst-case output buffer, and calls iconv().
+class IconvConverter
+{
+public:
+    IconvConverter()
+    {
+        wchar_t testChar = L'A';
+        const char* ucsString =
+            (*(reinterpret_cast<char*>(&testChar)) == 'A')
+                ? "UCS-4LE" : "UCS-4BE";
+
+        mInHandle = iconv_open(ucsString, "UTF-8");
+        mOutHandle = iconv_open("UTF-8", ucsString);
+        if (mInHandle == (iconv_t)(-1) || mOutHandle == (iconv_t)(-1))
+            throw runtime_error("iconv_open failed");
+    }
+
+    ~IconvConverter()
+    {
+        iconv_close(mInHandle);
+        iconv_close(mOutHandle);
+    }
+
+    wstring ConvertIn(const string& input)
+    {
+        char* inputBuf = new char[input.size()];
+        memcpy(inputBuf, input.c_str(), input.size());
+        char* outputBuf = new char[input.size() * 4];
+
+        // BSD (including Mac OS X) declares iconv's second parameter as
+        // const char**; build with -DBLAHTEX_ICONV_CONST there.
+#ifdef BLAHTEX_ICONV_CONST
+        const
+#endif
+        char* source = inputBuf;
+        char* dest = outputBuf;
+        size_t inBytesLeft = input.size();
+        size_t outBytesLeft = input.size() * 4;
+
+        if (iconv(
+            mInHandle, &source, &inBytesLeft, &dest, &outBytesLeft
+        ) == (size_t)(-1))
+        {
+            delete[] inputBuf;
+            delete[] outputBuf;
+            throw UnicodeConverter::Exception();
+        }
+
+        wstring output(
+            reinterpret_cast<wchar_t*>(outputBuf),
+            input.size() - outBytesLeft / 4
+        );
+        delete[] inputBuf;
+        delete[] outputBuf;
+        return output;
+    }
+
+    string ConvertOut(const wstring& input)
+    {
+        wchar_t* inputBuf = new wchar_t[input.size()];
+        wmemcpy(inputBuf, input.c_str(), input.size());
+        char* outputBuf = new char[input.size() * 4];
+
+#ifdef BLAHTEX_ICONV_CONST
+        const
+#endif
+        char* source = reinterpret_cast<char*>(inputBuf);
+        char* dest = outputBuf;
+        size_t inBytesLeft = input.size() * 4;
+        size_t outBytesLeft = input.size() * 4;
+
+        if (iconv(
+            mOutHandle, &source, &inBytesLeft, &dest, &outBytesLeft
+        ) == (size_t)(-1))
+        {
+            delete[] inputBuf;
+            delete[] outputBuf;
+            throw UnicodeConverter::Exception();
+        }
+
+        string output(outputBuf, input.size() * 4 - outBytesLeft);
+        delete[] inputBuf;
+        delete[] outputBuf;
+        return output;
+    }
+
+private:
+    iconv_t mInHandle;
+    iconv_t mOutHandle;
+
+    // Not copyable.
+    IconvConverter(const IconvConverter&);
+    IconvConverter& operator=(const IconvConverter&);
+};
+
+// Returns the time per input, in nanoseconds, for the fastest of "rounds"
+// passes of ConvertIn() over all of "inputs".
+template<class Converter>
+double TimeConvertIn(
+    Converter& converter,
+    const vector<string>& inputs,
+    long rounds
+)
+{
+    double best = 0.0;
+    size_t total = 0;
+    for (long round = 0; round < rounds; round++)
+    {
+        double start = Now();
+        for (vector<string>::const_iterator
+            input = inputs.begin(); input != inputs.end(); input++
+        )
+            total += converter.ConvertIn(*input).size();
+        double elapsed = Now() - start;
+        if (round == 0 || elapsed < best)
+            best = elapsed;
+    }
+    // (Using "total" stops the compiler optimising the loop away.)
+    return (best + (total == 0)) / inputs.size();
+}
+
+// Same as TimeConvertIn(), for ConvertOut().
+template<class Converter>
+double TimeConvertOut(
+    Converter& converter,
+    const vector<wstring>& inputs,
+    long rounds
+)
+{
+    double best = 0.0;
+    size_t total = 0;
+    for (long round = 0; round < rounds; round++)
+    {
+        double start = Now();
+        for (vector<wstring>::const_iterator
+            input = inputs.begin(); input != inputs.end(); input++
+        )
+            total += converter.ConvertOut(*input).size();
+        double elapsed = Now() - start;
+        if (round == 0 || elapsed < best)
+            best = elapsed;
+    }
+    return (best + (total == 0)) / inputs.size();
+}
+
+int main(int argc, char* const argv[])
+{
+    try
+    {
+        vector<string> formulas;
+        if (argc > 1)
+        {
+            ifstream file(argv[1], ios::in | ios::binary);
+            if (!file)
+                throw runtime_error(
+                    string("Cannot open \"") + argv[1] + "\""
+                );
+            string line;
+            while (getline(file, line))
+                if (!line.empty())
+                    formulas.push_back(line);
+        }
+        else
+            formulas.assign(
+                gDefaultFormulas,
+                END_ARRAY(gDefaultFormulas)
+            );
+
+        long rounds = (argc > 2) ? atol(argv[2]) : 200;
+        if (rounds <= 0)
+            rounds = 1;
+
+        UnicodeConverter converter;
+        converter.Open();
+        IconvConverter iconvConverter;
+
+        // Only valid UTF-8 is timed (both converters reject the rest).
+        vector<string> inputs;
+        vector<wstring> outputs;
+        blahtex::Interface interface;
+        size_t inputBytes = 0, outputChars = 0;
+        for (vector<string>::const_iterator
+            formula = formulas.begin(); formula != formulas.end(); formula++
+        )
+        {
+            wstring decoded;
+            try
+            {
+                decoded = converter.ConvertIn(*formula);
+            }
+            catch (UnicodeConverter::Exception& e)
+            {
+                continue;
+            }
+            if (iconvConverter.ConvertIn(*formula) != decoded)
+                throw runtime_error("ConvertIn results differ");
+            inputs.push_back(*formula);
+            inputBytes += formula->size();
+
+            try
+            {
+                interface.ProcessInput(decoded);
+                wstring mathml = interface.GetMathml();
+                if (iconvConverter.ConvertOut(mathml)
+                    != converter.ConvertOut(mathml)
+                )
+                    throw runtime_error("ConvertOut results differ");
+                outputs.push_back(mathml);
+                outputChars += mathml.size();
+            }
+            catch (blahtex::Exception& e)
+            {
+                // Skip formulas with errors.
+            }
+        }
+        if (inputs.empty() || outputs.empty())
+            throw runtime_error("No formulas to convert");
+
+        cout << inputs.size() << " inputs (" << inputBytes
+            << " bytes), " << outputs.size() << " MathML outputs ("
+            << outputChars << " characters), best of " << rounds
+            << " rounds" << endl;
+
+        cout << "ConvertIn: "
+            << TimeConvertIn(iconvConverter, inputs, rounds)
+            << " ns/input iconv, "
+            << TimeConvertIn(converter, inputs, rounds)
+            << " ns/input UnicodeConverter" << endl;
+
+        cout << "ConvertOut: "
+            << TimeConvertOut(iconvConverter, outputs, rounds)
+            << " ns/output iconv, "
+            << TimeConvertOut(converter, outputs, rounds)
+            << " ns/output UnicodeConverter" << endl;
+    }
+
+    catch (std::runtime_error& e)
+    {
+        cerr << "unicode-benchmark: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
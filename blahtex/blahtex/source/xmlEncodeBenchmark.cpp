@@ -0,0 +1,255 @@
+// File "xmlEncodeBenchmark.cpp"
+//
+// blahtex (version 0.4.4)
+// a TeX to MathML converter designed with MediaWiki in mind
+// Copyright (C) 2006, David Harvey
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+
+// xmlencode-benchmark times XmlEncode() on real MathML text content: the
+// text of every token element (<mi>, <mo>, <mn>, <mtext>) that blahtex
+// generates for a list of formulas. The formulas are read from a file, one
+// per line in UTF-8, or a built-in list of typical ones is used.
+//
+// Each MathML encoding is timed separately, writing UTF-8 (as the command
+// line version does) and writing a wstring (as Interface::GetMathml does).
+// The text is collected twice, once with MathML version 1 fonts, so that
+// the plane-1 characters get exercised too.
+//
+// Usage: xmlencode-benchmark [formula-file [rounds]]
+
+#include <time.h>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "BlahtexCore/Interface.h"
+#include "BlahtexCore/Manager.h"
+#include "BlahtexCore/MathmlWriter.h"
+#include "BlahtexCore/XmlEncode.h"
+
+using namespace std;
+using namespace blahtex;
+
+const char* const gDefaultFormulas[] =
+{
+    "x^2 + y^2 = z^2",
+    "\\frac{-b \\pm \\sqrt{b^2 - 4ac}}{2a}",
+    "\\sum_{n=1}^\\infty \\frac{1}{n^2} = \\frac{\\pi^2}{6}",
+    "\\int_0^\\infty e^{-x^2}\\,dx = \\frac{\\sqrt\\pi}{2}",
+    "\\lim_{x \\to 0} \\frac{\\sin x}{x} = 1",
+    "\\forall \\epsilon > 0\\ \\exists \\delta > 0 : |x - a| < \\delta "
+        "\\Rightarrow |f(x) - f(a)| < \\epsilon",
+    "\\nabla \\times \\mathbf{E} = -\\frac{\\partial \\mathbf{B}}"
+        "{\\partial t}",
+    "\\begin{pmatrix} a & b \\\\ c & d \\end{pmatrix}^{-1} = "
+        "\\frac{1}{ad - bc} \\begin{pmatrix} d & -b \\\\ -c & a "
+        "\\end{pmatrix}",
+    "f(x) = \\begin{cases} 0 & \\text{if } x < 0 \\\\ 1 & "
+        "\\text{otherwise} \\end{cases}",
+    "\\mathbb{N} \\subset \\mathbb{Z} \\subset \\mathbb{Q} \\subset "
+        "\\mathbb{R} \\subset \\mathbb{C}",
+    "\\mathfrak{g} = \\mathfrak{sl}_2(\\mathbb{C})",
+    "\\mathcal{L}\\{f\\}(s) = \\int_0^\\infty f(t) e^{-st}\\,dt",
+    "\\alpha + \\beta + \\gamma + \\delta + \\varepsilon + \\zeta "
+        "+ \\eta + \\theta",
+    "A \\cap B \\cup C \\setminus D",
+    "a \\leq b \\geq c \\neq d \\approx e \\equiv f \\pmod{n}",
+    "\\langle \\psi | \\hat{H} | \\psi \\rangle",
+    "\\hbar \\omega",
+    "\\left( \\sum_{i=1}^n a_i b_i \\right)^2 \\le "
+        "\\left( \\sum_{i=1}^n a_i^2 \\right) "
+        "\\left( \\sum_{i=1}^n b_i^2 \\right)",
+    "\\log_2 n, \\quad \\exp(i\\pi) + 1 = 0",
+    "\\text{if } x \\in \\{1, 2, 3\\} \\text{ and } y \\notin S",
+    "\\overrightarrow{AB} \\cdot \\overrightarrow{CD} = 0",
+    "P(A \\mid B) = \\frac{P(B \\mid A)\\,P(A)}{P(B)}",
+    "n! = \\prod_{k=1}^n k",
+    "\\det(A - \\lambda I) = 0",
+    "a < b \\ \\text{and}\\ c > d \\ \\text{and}\\ e \\& f"
+};
+
+double Now()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+// TextCollector keeps the text of each token element and ignores the
+// rest of the markup.
+class TextCollector : public MathmlWriter
+{
+public:
+    TextCollector(vector<wstring>& texts) :
+        mTexts(texts)
+    { }
+
+    virtual void StartElement(
+        MathmlNode::Type type,
+        const MathmlNode::AttributeSet& attributes
+    )
+    { }
+
+    virtual void Text(const wstring& text)
+    {
+        mTexts.push_back(text);
+    }
+
+    virtual void EndElement(MathmlNode::Type type)
+    { }
+
+private:
+    vector<wstring>& mTexts;
+};
+
+void CollectTexts(
+    const vector<string>& formulas,
+    const MathmlOptions& options,
+    vector<wstring>& texts
+)
+{
+    Interface interface;
+    TextCollector collector(texts);
+    for (vector<string>::const_iterator
+        formula = formulas.begin(); formula != formulas.end(); formula++
+    )
+    {
+        try
+        {
+            interface.ProcessInputUtf8(*formula);
+            interface.GetManager()->WriteMathml(collector, options);
+        }
+        catch (blahtex::Exception& e)
+        {
+            // Skip formulas with errors.
+        }
+    }
+}
+
+// Returns the time per text, in nanoseconds, for the fastest of "rounds"
+// passes over all of "texts".
+template<class Output>
+double TimeEncoding(
+    const vector<wstring>& texts,
+    const EncodingOptions& options,
+    long rounds,
+    size_t& outputSize
+)
+{
+    double best = 0.0;
+    Output output;
+    for (long round = 0; round < rounds; round++)
+    {
+        output.clear();
+        double start = Now();
+        for (vector<wstring>::const_iterator
+            text = texts.begin(); text != texts.end(); text++
+        )
+            XmlEncode(output, *text, options);
+        double elapsed = Now() - start;
+        if (round == 0 || elapsed < best)
+            best = elapsed;
+    }
+    outputSize = output.size();
+    return best / texts.size();
+}
+
+int main(int argc, char* const argv[])
+{
+    try
+    {
+        vector<string> formulas;
+        if (argc > 1)
+        {
+            ifstream file(argv[1], ios::in | ios::binary);
+            if (!file)
+                throw runtime_error(
+                    string("Cannot open \"") + argv[1] + "\""
+                );
+            string line;
+            while (getline(file, line))
+                if (!line.empty())
+                    formulas.push_back(line);
+        }
+        else
+            formulas.assign(
+                gDefaultFormulas,
+                END_ARRAY(gDefaultFormulas)
+            );
+
+        long rounds = (argc > 2) ? atol(argv[2]) : 200;
+        if (rounds <= 0)
+            rounds = 1;
+
+        vector<wstring> texts;
+        MathmlOptions mathmlOptions;
+        CollectTexts(formulas, mathmlOptions, texts);
+        mathmlOptions.mUseVersion1FontAttributes = true;
+        CollectTexts(formulas, mathmlOptions, texts);
+        if (texts.empty())
+            throw runtime_error("No MathML text to encode");
+
+        size_t characters = 0;
+        for (vector<wstring>::const_iterator
+            text = texts.begin(); text != texts.end(); text++
+        )
+            characters += text->size();
+
+        cout << formulas.size() << " formulas, " << texts.size()
+            << " texts, " << characters << " characters, best of "
+            << rounds << " rounds" << endl;
+
+        static const char* const names[] =
+            {"raw", "numeric", "short", "long"};
+
+        for (int plane1 = 1; plane1 >= 0; plane1--)
+            for (int encoding = EncodingOptions::cMathmlEncodingRaw;
+                encoding <= EncodingOptions::cMathmlEncodingLong;
+                encoding++
+            )
+            {
+                EncodingOptions options;
+                options.mMathmlEncoding =
+                    static_cast<EncodingOptions::MathmlEncoding>(encoding);
+                options.mAllowPlane1 = plane1;
+
+                size_t utf8Size, wideSize;
+                double utf8 = TimeEncoding<string>(
+                    texts, options, rounds, utf8Size
+                );
+                double wide = TimeEncoding<wstring>(
+                    texts, options, rounds, wideSize
+                );
+
+                cout << names[encoding]
+                    << (plane1 ? "" : ", no plane 1") << ": "
+                    << utf8 << " ns/text UTF-8 (" << utf8Size
+                    << " bytes), " << wide << " ns/text wstring" << endl;
+            }
+    }
+
+    catch (std::runtime_error& e)
+    {
+        cerr << "xmlencode-benchmark: " << e.what() << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// end of file @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
@@ -1101,6 +1101,11 @@ $wgTexvc = './math/texvc';
 $wgBlahtex = '';
 /** Command-line options for blahtex */
 $wgBlahtexOptions = '--texvc-compatible-commands --mathml-version-1-fonts --disallow-plane-1 --spacing strict';
+/**
+ * Run blahtex once per request in "--server" mode, instead of once per
+ * formula. Requires a blahtex binary which supports "--server".
+ */
+$wgBlahtexServer = false;
 
 #
 # Profiling / debugging
@@ -371,10 +371,17 @@ class MathRenderer {
 	 */
 	function invokeBlahtex( $tex, $makePNG )
 	{
-		global $wgBlahtex, $wgBlahtexOptions, $wgTmpDirectory;
+		global $wgBlahtex, $wgBlahtexOptions, $wgBlahtexServer, $wgTmpDirectory;
 
 		$descriptorspec = array( 0 => array( "pipe", "r" ),
 					 1 => array( "pipe", "w" ) );
+		if ( $wgBlahtexServer ) {
+			// The server is started with $wgBlahtexOptions and the
+			// directories (a request isn't allowed to change the
+			// latter), so each request only says what to produce.
+			$options = $makePNG ? '--mathml --png' : '--mathml';
+			return $this->invokeBlahtexServer( $options, '\\displaystyle ' . $tex );
+		}
 		$options = '--mathml ' . $wgBlahtexOptions;
 		if ( $makePNG ) 
 			$options .= " --png --temp-directory $wgTmpDirectory --png-directory $wgTmpDirectory";
@@ -400,6 +407,65 @@ class MathRenderer {
 		return array( true, $contents );
 	}
 
+	/**
+	 * Send a request to a persistent blahtex process.
+	 * The first call starts "blahtex --server"; later calls during the
+	 * same request reuse it, so that a page with many formulas only
+	 * pays the blahtex startup cost once.
+	 * @param $options String containing the per-formula options (just
+	 * "--mathml" and possibly "--png"), separated by spaces; the
+	 * defaults from $wgBlahtexOptions are given when the server starts.
+	 * @param $input String containing the input for blahtex.
+	 * @return A 2-tuple, as for invokeBlahtex().
+	 */
+	function invokeBlahtexServer( $options, $input )
+	{
+		global $wgBlahtex, $wgBlahtexOptions, $wgTmpDirectory;
+		static $process = NULL, $pipes = NULL;
+
+		if ( $process === NULL ) {
+			$descriptorspec = array( 0 => array( "pipe", "r" ),
+						 1 => array( "pipe", "w" ) );
+			// Options such as --shell-latex and the directories can't be
+			// given in a request, so they have to be set here.
+			$process = proc_open( "$wgBlahtex --server $wgBlahtexOptions " .
+				"--temp-directory $wgTmpDirectory --png-directory $wgTmpDirectory",
+				$descriptorspec, $pipes );
+			if ( !$process ) {
+				$process = NULL;
+				return array( false, $this->_error( 'math_unknown_error', ' #1' ) );
+			}
+		}
+
+		$options = implode( "\n", preg_split( '/\s+/', trim( $options ) ) );
+		fwrite( $pipes[0], strlen( $options ) . ' ' . strlen( $input ) . "\n" );
+		fwrite( $pipes[0], $options );
+		fwrite( $pipes[0], $input );
+		fflush( $pipes[0] );
+
+		$header = fgets( $pipes[1] );
+		$ok = $header !== false && preg_match( '/^[0-9]+$/', trim( $header ) );
+		$contents = '';
+		if ( $ok ) {
+			$length = intval( $header );
+			while ( strlen( $contents ) < $length && !feof( $pipes[1] ) ) {
+				$contents .= fread( $pipes[1], $length - strlen( $contents ) );
+			}
+			$ok = strlen( $contents ) == $length;
+		}
+		if ( !$ok ) {
+			// The server has died or lost track of the protocol; start a
+			// new one next time.
+			fclose( $pipes[0] );
+			fclose( $pipes[1] );
+			proc_close( $process );
+			$process = NULL;
+			return array( false, $this->_error( 'math_unknown_error', ' #2' ) );
+		}
+
+		return array( true, $contents );
+	}
+
 	/**
 	 * Process blahtex output.
 	 * Parse the output and fill the mathml field in the database. If